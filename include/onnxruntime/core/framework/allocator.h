@@ -33,14 +33,15 @@ struct OrtArenaCfg {
         max_power_of_two_extend_bytes(max_power_of_two_extend_bytes) {}
 
   size_t max_mem;                         // use 0 to allow ORT to choose the default
-  int arena_extend_strategy;              // use -1 to allow ORT to choose the default, 0 = kNextPowerOfTwo, 1 = kSameAsRequested
+  int arena_extend_strategy;              // use -1 to allow ORT to choose the default, 0 = kNextPowerOfTwo, 1 = kSameAsRequested,
+                                          // 2 = kSizeClassSlab
   int initial_chunk_size_bytes;           // use -1 to allow ORT to choose the default
   int max_dead_bytes_per_chunk;           // use -1 to allow ORT to choose the default
   int initial_growth_chunk_size_bytes;    // use -1 to allow ORT to choose the default
   int64_t max_power_of_two_extend_bytes;  // use -1 to allow ORT to choose the default
 
   bool IsValid() {
-    return arena_extend_strategy >= -1 && arena_extend_strategy <= 1 &&
+    return arena_extend_strategy >= -1 && arena_extend_strategy <= 2 &&
            initial_chunk_size_bytes >= -1 &&
            max_dead_bytes_per_chunk >= -1 &&
            initial_growth_chunk_size_bytes >= -1 &&
@@ -39,7 +39,10 @@
 #pragma warning(disable : 4127)
 #pragma warning(disable : 4805)
 #endif
+#include <chrono>
+#include <map>
 #include <memory>
+#include <vector>
 #include "unsupported/Eigen/CXX11/ThreadPool"
 
 #if defined(__GNUC__)
@@ -77,6 +80,8 @@
 //
 //   This spin-then-block behavior is configured via a flag provided
 //   when creating the thread pool, and by the constant spin_count.
+//   With adaptive spinning, the spin time additionally adapts to the
+//   idle gaps each worker observes (see AdaptiveSpinPolicy).
 //
 // - Although all tasks are simple void()->void functions,
 //   conceptually there are three different kinds:
@@ -230,6 +235,10 @@ class ThreadPoolProfiler {
   void LogCoreAndBlock(std::ptrdiff_t) {}
   void LogThreadId(int) {}
   void LogRun(int) {}
+  void LogSpinStart(int) {}
+  void LogSpinEnd(int, bool) {}
+  void LogBlock(int) {}
+  void LogSpinLimit(int, std::chrono::nanoseconds) {}
   std::string DumpChildThreadStat() { return {}; }
 };
 #else
@@ -256,7 +265,12 @@ class ThreadPoolProfiler {
   void LogCoreAndBlock(std::ptrdiff_t block_size);  // called in main thread to log core and block size for task breakdown
   void LogThreadId(int thread_idx);                 // called in child thread to log its id
   void LogRun(int thread_idx);                      // called in child thread to log num of run
-  std::string DumpChildThreadStat();                // return all child statistics collected so far
+  void LogSpinStart(int thread_idx);                // called in child thread when it starts spinning for work
+  void LogSpinEnd(int thread_idx, bool found_work);  // called in child thread when it stops spinning
+  void LogBlock(int thread_idx);                     // called in child thread when it blocks in the OS
+  // called in child thread to log the spin limit chosen by adaptive spinning
+  void LogSpinLimit(int thread_idx, std::chrono::nanoseconds spin_limit);
+  std::string DumpChildThreadStat();  // return all child statistics collected so far
 
  private:
   static const char* GetEventName(ThreadPoolEvent);
@@ -285,6 +299,12 @@ class ThreadPoolProfiler {
     uint64_t num_run_ = 0;
     onnxruntime::TimePoint last_logged_point_ = Clock::now();
     int32_t core_ = -1;  // core that the child thread is running on
+    uint64_t num_spin_hit_ = 0;   // spins that found work
+    uint64_t num_spin_miss_ = 0;  // spins that gave up
+    uint64_t num_block_ = 0;      // times the thread blocked in the OS
+    uint64_t spin_us_ = 0;        // total time spent spinning
+    int64_t spin_limit_us_ = -1;  // latest spin limit chosen by adaptive spinning
+    onnxruntime::TimePoint spin_start_point_;
   };
 #ifdef _MSC_VER
 #pragma warning(pop)
@@ -294,6 +314,53 @@ class ThreadPoolProfiler {
 };
 #endif
 
+// AdaptiveSpinPolicy decides how long an idle worker spins for work
+// before it blocks in the OS.
+//
+// A worker records the idle gaps it observes, from running out of work
+// until it gets its next task, e.g. between the parallel sections of a
+// request, or between requests.  It keeps an exponential moving average
+// of the gaps.  Spinning only pays off if the next task arrives while
+// the worker is still spinning, so the worker spins for up to twice the
+// average gap, within the budget.  If the gaps are longer than the
+// budget, e.g. between requests at a low request rate, the worker only
+// spins briefly before it blocks, which gives the core back to other
+// processes.  A burst of short gaps brings the spinning back within a
+// few gaps.
+class AdaptiveSpinPolicy {
+ public:
+  explicit AdaptiveSpinPolicy(std::chrono::nanoseconds budget)
+      : budget_ns_(budget.count()), average_gap_ns_(budget_ns_ / 2) {}
+
+  // How long to spin for at the start of an idle gap.
+  std::chrono::nanoseconds SpinLimit() const {
+    const int64_t min_spin_ns = budget_ns_ / kMinSpinDivisor;
+    if (average_gap_ns_ > budget_ns_) {
+      return std::chrono::nanoseconds(min_spin_ns);
+    }
+    return std::chrono::nanoseconds(std::min(budget_ns_, 2 * average_gap_ns_ + min_spin_ns));
+  }
+
+  // Record an idle gap that ended with the worker getting a task.
+  void RecordGap(std::chrono::nanoseconds gap) {
+    // cap the gap, so that a single long gap does not outweigh the following short ones for long
+    const int64_t gap_ns = std::min(gap.count(), kMaxGapFactor * budget_ns_);
+    average_gap_ns_ += (gap_ns - average_gap_ns_) / kAverageWeight;
+  }
+
+  std::chrono::nanoseconds AverageGap() const {
+    return std::chrono::nanoseconds(average_gap_ns_);
+  }
+
+ private:
+  static constexpr int64_t kAverageWeight = 8;    // a new gap contributes 1/8 to the average
+  static constexpr int64_t kMinSpinDivisor = 32;  // the minimum spin is 1/32 of the budget
+  static constexpr int64_t kMaxGapFactor = 4;
+
+  const int64_t budget_ns_;
+  int64_t average_gap_ns_;
+};
+
 // Extended Eigen thread pool interface, avoiding the need to modify
 // the ThreadPoolInterface.h header from the external Eigen
 // repository.
@@ -338,6 +405,8 @@ class ExtendedThreadPoolInterface : public Eigen::ThreadPoolInterface {
                              unsigned n, std::ptrdiff_t block_size) = 0;
   virtual void StartProfiling() = 0;
   virtual std::string StopProfiling() = 0;
+  // Approximate number of tasks waiting in the queues of the workers
+  virtual unsigned QueueDepth() const = 0;
 };
 
 class ThreadPoolParallelSection {
@@ -729,6 +798,14 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
     return profiler_.Stop();
   }
 
+  unsigned QueueDepth() const override {
+    unsigned depth = 0;
+    for (size_t i = 0; i < worker_data_.size(); ++i) {
+      depth += worker_data_[i].queue.Size();
+    }
+    return depth;
+  }
+
   struct Tag {
     constexpr Tag() : v_(0) {
     }
@@ -772,6 +849,7 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
         env_(env),
         num_threads_(num_threads),
         allow_spinning_(allow_spinning),
+        adaptive_spin_budget_(std::chrono::microseconds(thread_options.adaptive_spin_budget_us)),
         set_denormal_as_zero_(thread_options.set_denormal_as_zero),
         worker_data_(num_threads),
         all_coprimes_(num_threads),
@@ -789,6 +867,8 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
       ComputeCoprimes(i, &all_coprimes_.back());
     }
 
+    InitializeNumaNodes(thread_options.numa_nodes);
+
     // Eigen::MaxSizeVector has neither essential exception safety features
     // such as swap, nor it is movable. So we have to join threads right here
     // on exception
@@ -817,7 +897,10 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
 
   void Schedule(std::function<void()> fn) override {
     PerThread* pt = GetPerThread();
-    int q_idx = Rand(&pt->rand) % num_threads_;
+    // keep the work that a worker spawns on its own NUMA node
+    const auto* numa_peers = GetNumaPeers(*pt);
+    int q_idx = numa_peers ? (*numa_peers)[Rand(&pt->rand) % numa_peers->size()]
+                           : Rand(&pt->rand) % num_threads_;
     WorkerData& td = worker_data_[q_idx];
     Queue& q = td.queue;
     fn = q.PushBack(std::move(fn));
@@ -1049,6 +1132,13 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
   //   Once worker 1 steals one of these tasks, the task will update its
   //   preferred worker to be 1.
   //
+  // In a NUMA aware pool the hints are instead initialized so that the
+  // consecutive par_idx values map to the workers of one node before
+  // moving on to the next node, the same for all main threads.  A loop
+  // then gives consecutive ranges of its iterations to the same node, and
+  // a task that is stolen by a worker of another node does not move the
+  // hint off its node.
+  //
   //   From that point onwards, the two main threads will dispatch tasks
   //   to separate workers, avoiding the need for further work stealing.
 
@@ -1065,7 +1155,11 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
     // preferred_workers maps from a par_idx to a q_idx, hence we
     // initialize slots in the range [0,num_threads_]
     while (preferred_workers.size() <= num_threads_) {
-      preferred_workers.push_back(next_worker++ % num_threads_);
+      if (numa_worker_order_.empty()) {
+        preferred_workers.push_back(next_worker++ % num_threads_);
+      } else {
+        preferred_workers.push_back(numa_worker_order_[(preferred_workers.size() - 1) % num_threads_]);
+      }
     }
   }
 
@@ -1076,6 +1170,10 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
     unsigned ran_on_idx = GetPerThread()->thread_id;
     assert(ran_on_idx < num_threads_);
     assert(par_idx < preferred_workers.size());
+    if (!numa_node_of_worker_.empty() &&
+        numa_node_of_worker_[ran_on_idx] != numa_node_of_worker_[preferred_workers[par_idx] % num_threads_]) {
+      return;
+    }
     preferred_workers[par_idx] = ran_on_idx;
   }
 
@@ -1494,7 +1592,16 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
 
   Environment& env_;
   const unsigned num_threads_;
+
+  // NUMA topology of the workers, empty unless the pool is NUMA aware.
+  // numa_node_of_worker_ maps a q_idx to an index into numa_peers_, which lists the workers of every node.
+  // numa_worker_order_ lists the workers node by node.
+  std::vector<unsigned> numa_node_of_worker_;
+  std::vector<std::vector<unsigned>> numa_peers_;
+  std::vector<unsigned> numa_worker_order_;
   const bool allow_spinning_;
+  // Upper bound of the spin time of adaptive spinning, which is disabled if it is 0.  See AdaptiveSpinPolicy.
+  const std::chrono::nanoseconds adaptive_spin_budget_;
   const bool set_denormal_as_zero_;
   Eigen::MaxSizeVector<WorkerData> worker_data_;
   Eigen::MaxSizeVector<Eigen::MaxSizeVector<unsigned>> all_coprimes_;
@@ -1539,13 +1646,36 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
     const int spin_count = allow_spinning_ ? (1ull << log2_spin) : 0;
     const int steal_count = spin_count / 100;
 
+    // With adaptive spinning the spin loop also stops at a deadline, which it checks every few iterations
+    using SpinClock = std::chrono::steady_clock;
+    constexpr int spin_clock_interval = 64;
+    const bool adaptive_spinning = allow_spinning_ && adaptive_spin_budget_.count() > 0;
+    AdaptiveSpinPolicy spin_policy(adaptive_spin_budget_);
+    bool idle = false;
+    SpinClock::time_point idle_start;
+
     SetDenormalAsZero(set_denormal_as_zero_);
     profiler_.LogThreadId(thread_id);
 
     while (!should_exit) {
       Task t = q.PopFront();
       if (!t) {
+        SpinClock::time_point spin_deadline;
+        if (adaptive_spinning) {
+          const auto now = SpinClock::now();
+          if (!idle) {
+            idle = true;
+            idle_start = now;
+          }
+          const auto spin_limit = spin_policy.SpinLimit();
+          spin_deadline = now + spin_limit;
+          profiler_.LogSpinLimit(thread_id, spin_limit);
+        }
+
         // Spin waiting for work.
+        if (allow_spinning_) {
+          profiler_.LogSpinStart(thread_id);
+        }
         for (int i = 0; i < spin_count && !done_; i++) {
           if (((i + 1) % steal_count == 0)) {
             t = Steal(StealAttemptKind::TRY_ONE);
@@ -1557,8 +1687,14 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
           if (spin_loop_status_.load(std::memory_order_relaxed) == SpinLoopStatus::kIdle) {
             break;
           }
+          if (adaptive_spinning && (i + 1) % spin_clock_interval == 0 && SpinClock::now() >= spin_deadline) {
+            break;
+          }
           onnxruntime::concurrency::SpinPause();
         }
+        if (allow_spinning_) {
+          profiler_.LogSpinEnd(thread_id, static_cast<bool>(t));
+        }
 
         // Attempt to block
         if (!t) {
@@ -1617,6 +1753,7 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
                   // Post-block update (executed only if we blocked)
                   [&]() {
                     blocked_--;
+                    profiler_.LogBlock(thread_id);
                   })) {
             // Encountered a fatal logic error in SetBlocked
             should_exit = true;
@@ -1631,6 +1768,10 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
       }
 
       if (t) {
+        if (idle) {
+          idle = false;
+          spin_policy.RecordGap(SpinClock::now() - idle_start);
+        }
         td.SetActive();
         t();
         profiler_.LogRun(thread_id);
@@ -1652,18 +1793,37 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
   // "snatching" work from a thread which is just about to notice the
   // work itself.
 
+  //
+  // In a NUMA aware pool, a thread first tries the workers of its own
+  // node, and only tries the workers of the other nodes if it is
+  // trying all of them.
+
   Task Steal(StealAttemptKind steal_kind) {
     PerThread* pt = GetPerThread();
-    unsigned size = num_threads_;
+    const auto* numa_peers = GetNumaPeers(*pt);
+    if (numa_peers) {
+      Task t = StealFrom(*pt, numa_peers, steal_kind);
+      if (t || steal_kind != StealAttemptKind::TRY_ALL) {
+        return t;
+      }
+    }
+
+    return StealFrom(*pt, nullptr, steal_kind);
+  }
+
+  // Steal from the workers in victims, or from all the workers if it is null.
+  Task StealFrom(PerThread& pt, const std::vector<unsigned>* victims, StealAttemptKind steal_kind) {
+    unsigned size = victims ? static_cast<unsigned>(victims->size()) : num_threads_;
     unsigned num_attempts = (steal_kind == StealAttemptKind::TRY_ALL) ? size : 1;
-    unsigned r = Rand(&pt->rand);
+    unsigned r = Rand(&pt.rand);
     unsigned inc = all_coprimes_[size - 1][r % all_coprimes_[size - 1].size()];
     unsigned victim = r % size;
 
     for (unsigned i = 0; i < num_attempts; i++) {
       assert(victim < size);
-      if (worker_data_[victim].GetStatus() == WorkerData::ThreadStatus::Active) {
-        Task t = worker_data_[victim].queue.PopBack();
+      WorkerData& td = worker_data_[victims ? (*victims)[victim] : victim];
+      if (td.GetStatus() == WorkerData::ThreadStatus::Active) {
+        Task t = td.queue.PopBack();
         if (t) {
           return t;
         }
@@ -1677,6 +1837,45 @@ class ThreadPoolTempl : public onnxruntime::concurrency::ExtendedThreadPoolInter
     return Task();
   }
 
+  void InitializeNumaNodes(const std::vector<int>& numa_nodes) {
+    if (numa_nodes.size() < num_threads_) {
+      return;
+    }
+
+    std::map<int, unsigned> node_indices;
+    for (unsigned i = 0; i < num_threads_; ++i) {
+      node_indices.emplace(numa_nodes[i], static_cast<unsigned>(node_indices.size()));
+    }
+
+    // a single node does not need any of this
+    if (node_indices.size() < 2) {
+      return;
+    }
+
+    numa_node_of_worker_.resize(num_threads_);
+    numa_peers_.resize(node_indices.size());
+    for (unsigned i = 0; i < num_threads_; ++i) {
+      numa_node_of_worker_[i] = node_indices[numa_nodes[i]];
+      numa_peers_[numa_node_of_worker_[i]].push_back(i);
+    }
+
+    // the nodes in ascending order
+    for (const auto& node : node_indices) {
+      const auto& peers = numa_peers_[node.second];
+      numa_worker_order_.insert(numa_worker_order_.end(), peers.begin(), peers.end());
+    }
+  }
+
+  // The workers of the NUMA node of the calling thread, or null if the pool
+  // is not NUMA aware or the calling thread is not one of its workers.
+  const std::vector<unsigned>* GetNumaPeers(const PerThread& pt) const {
+    if (numa_node_of_worker_.empty() || pt.pool != this) {
+      return nullptr;
+    }
+
+    return &numa_peers_[numa_node_of_worker_[pt.thread_id]];
+  }
+
   int NonEmptyQueueIndex() {
     PerThread* pt = GetPerThread();
     const unsigned size = static_cast<unsigned>(worker_data_.size());
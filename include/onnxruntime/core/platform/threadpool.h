@@ -360,6 +360,10 @@ class ThreadPool {
   // working in combination with the thread initiating the loop.
   static int DegreeOfParallelism(const ThreadPool* tp);
 
+  // Returns the approximate number of tasks that are waiting in the queues of the worker threads of the pool.
+  // Only meant for monitoring, as the queues may change while they are read.
+  static size_t QueueDepth(const ThreadPool* tp);
+
   ORT_DISALLOW_COPY_AND_ASSIGNMENT(ThreadPool);
 
   // StartProfiling and StopProfiling are not to be consumed as public-facing API
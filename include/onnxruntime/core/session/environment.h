@@ -15,6 +15,7 @@
 #include "core/common/status.h"
 #include "core/framework/allocator.h"
 #include "core/framework/execution_provider.h"
+#include "core/framework/prepacked_weights_container.h"
 #include "core/platform/device_discovery.h"
 #include "core/platform/threadpool.h"
 
@@ -145,6 +146,14 @@ class Environment {
   // return a shared allocator from a plugin EP or custom allocator added with RegisterAllocator
   Status GetSharedAllocator(const OrtMemoryInfo& mem_info, OrtAllocator*& allocator);
 
+  /**
+   * Returns the store of pre-packed weights that is shared by the sessions that set
+   * "session.use_env_prepacked_weights". The store is thread safe.
+   */
+  SharedPrepackedWeightsStore& GetSharedPrepackedWeightsStore() const {
+    return shared_prepacked_weights_store_;
+  }
+
   ~Environment();
 
  private:
@@ -183,6 +192,9 @@ class Environment {
   // providing a CPU allocator.
   std::unique_ptr<OrtAllocatorImplWrappingIAllocator> default_cpu_ort_allocator_;
 
+  // pre-packed weights shared by the sessions, which only use it during their initialization
+  mutable SharedPrepackedWeightsStore shared_prepacked_weights_store_;
+
   using OrtAllocatorUniquePtr = std::unique_ptr<OrtAllocator, std::function<void(OrtAllocator*)>>;
 
 #if !defined(ORT_MINIMAL_BUILD)
@@ -2784,7 +2784,8 @@ struct OrtApi {
    * This will create the configuration of an arena that can eventually be used to define an arena based allocator's behavior
    *
    * \param[in] max_mem Use 0 to allow ORT to choose the default
-   * \param[in] arena_extend_strategy Use -1 to allow ORT to choose the default, 0 = kNextPowerOfTwo, 1 = kSameAsRequested
+   * \param[in] arena_extend_strategy Use -1 to allow ORT to choose the default, 0 = kNextPowerOfTwo, 1 = kSameAsRequested,
+   *            2 = kSizeClassSlab (CPU only)
    * \param[in] initial_chunk_size_bytes Use -1 to allow ORT to choose the default
    * \param[in] max_dead_bytes_per_chunk Use -1 to allow ORT to choose the default
    * \param[in] out A pointer to an OrtArenaCfg instance
@@ -2924,8 +2925,10 @@ struct OrtApi {
    * following parameters mean and how to choose these values.):
    * "max_mem": Maximum memory that can be allocated by the arena based allocator.
    *  Use 0 for ORT to pick the best value. Default is 0.
-   * "arena_extend_strategy": 0 = kNextPowerOfTwo, 1 = kSameAsRequested.
+   * "arena_extend_strategy": 0 = kNextPowerOfTwo, 1 = kSameAsRequested, 2 = kSizeClassSlab.
    *  Use -1 to allow ORT to choose the default.
+   *  kSizeClassSlab replaces the best-fit arena with an allocator that serves requests from fixed size classes
+   *  through per-thread caches. It is only supported for CPU memory and ignores the chunk size settings.
    * "initial_chunk_size_bytes": (Possible) Size of the first allocation in the arena.
    *  Only relevant if arena strategy is `kNextPowerOfTwo`. Use -1 to allow ORT to choose the default.
    *  Ultimately, the first allocation size is determined by the allocation memory request.
@@ -6163,6 +6166,64 @@ struct OrtApi {
    * \since Version 1.23.
    */
   ORT_API2_STATUS(GetSessionOptionsConfigEntries, _In_ const OrtSessionOptions* options, _Outptr_ OrtKeyValuePairs** out);
+
+  /** \brief Get a snapshot of the metrics of a session.
+   *
+   * The metrics must be enabled by setting the session config entry "session.enable_metrics" to "1".
+   * Unlike profiling they are cheap enough to stay enabled in production, and a snapshot can be taken at any time,
+   * including while the session is running.
+   *
+   * The snapshot contains the following entries. Latencies are in nanoseconds, and the percentiles are the upper bounds
+   * of the buckets of a histogram with a relative error of at most 12.5%.
+   *   - "run.latency.<stat>": the latencies of the successful runs, where <stat> is one of "count", "sum_ns",
+   *     "p50_ns", "p90_ns" and "p99_ns".
+   *   - "node.<node name>.op_type" and "node.<node name>.latency.<stat>": the latencies of every node. The names of
+   *     the nodes of subgraphs are prefixed with "<node name>/<attribute name>/" of the node that owns the subgraph.
+   *   - "frame.memory_pattern_allocations", "frame.dynamic_allocations" and "frame.dynamic_allocation_bytes": the
+   *     tensors allocated by the runs, in the buffers of the memory patterns or from the allocators.
+   *   - "thread_pool.intra_op.queue_depth" and "thread_pool.inter_op.queue_depth": the number of tasks waiting in
+   *     the queues of the thread pools.
+   *   - "dynamic_batching.batched_runs" and "dynamic_batching.batched_requests": the runs that combined several
+   *     RunAsync() requests and the number of requests they completed, if dynamic batching is enabled.
+   *   - "allocator.<name>:<device id>.<stat>": the statistics of the allocators of the session, where <stat> is one
+   *     of "num_allocs", "bytes_in_use", "max_bytes_in_use" and "total_allocated_bytes".
+   *
+   * \param[in] session The session.
+   * \param[out] out A pointer to a newly created OrtKeyValuePairs instance with the metrics.
+   *                  Note: the user should call OrtApi::ReleaseKeyValuePairs.
+   *
+   * \snippet{doc} snippets.dox OrtStatus Return Value
+   *
+   * \since Version 1.23.
+   */
+  ORT_API2_STATUS(SessionGetMetrics, _In_ const OrtSession* session, _Outptr_ OrtKeyValuePairs** out);
+
+  /** \brief Set all strings at once in a string tensor from a contiguous buffer
+   *
+   * This is the inverse of OrtApi::GetStringTensorContent. String i is made of the bytes of \p s from offsets[i]
+   * up to offsets[i + 1], or up to \p s_len for the last string. The strings are not null terminated and may
+   * contain null characters, so a column of strings stored as one UTF-8 buffer and an array of offsets (Arrow
+   * layout) can be copied into a tensor in one call without building an array of null terminated strings.
+   *
+   * An example of the inputs:<br>
+   * \p s contains "Thisisatest" and \p s_len is 11<br>
+   * \p offsets contains { 0, 4, 6, 7 }<br>
+   * After the call, \p value contains the strings { "This" "is" "a" "test" }
+   *
+   * \param[in,out] value A tensor of type ONNX_TENSOR_ELEMENT_DATA_TYPE_STRING
+   * \param[in] s Buffer with the bytes of all the strings one after the other
+   * \param[in] s_len Number of bytes of buffer pointed to by \p s
+   * \param[in] offsets Array of start offsets of the strings in \p s, in non-decreasing order
+   * \param[in] offsets_len Number of elements in offsets (Must match the size of \p value's tensor shape)
+   *
+   * All the offsets are checked before any string is written, so on error \p value is left unchanged.
+   *
+   * \snippet{doc} snippets.dox OrtStatus Return Value
+   *
+   * \since Version 1.23.
+   */
+  ORT_API2_STATUS(FillStringTensorFromContent, _Inout_ OrtValue* value, _In_ const void* s,
+                  size_t s_len, _In_reads_(offsets_len) const size_t* offsets, size_t offsets_len);
 };
 
 /*
@@ -1843,6 +1843,17 @@ struct ValueImpl : ConstValueImpl<T> {
   /// <param name="s_len">[in] Count of strings in s (Must match the size of \p value's tensor shape)</param>
   void FillStringTensor(const char* const* s, size_t s_len);
 
+  /// <summary>
+  /// Set all strings at once in a string tensor from one buffer, the inverse of GetStringTensorContent().
+  /// The strings are not null terminated, string i ends where string i + 1 starts.
+  /// </summary>
+  /// <param name="buffer">[in] UTF-8 encoded bytes of all the strings one after the other</param>
+  /// <param name="buffer_length">[in] Number of bytes in buffer</param>
+  /// <param name="offsets">[in] Start offsets of the strings in buffer</param>
+  /// <param name="offsets_count">[in] Count of offsets (Must match the size of the tensor shape)</param>
+  void FillStringTensorFromContent(const void* buffer, size_t buffer_length, const size_t* offsets,
+                                   size_t offsets_count);  ///< Wraps OrtApi::FillStringTensorFromContent
+
   /// <summary>
   /// Set a single string in a string tensor
   /// </summary>
@@ -2238,7 +2249,8 @@ struct ArenaCfg : detail::Base<OrtArenaCfg> {
   /**
    * Wraps OrtApi::CreateArenaCfg
    * \param max_mem - use 0 to allow ORT to choose the default
-   * \param arena_extend_strategy -  use -1 to allow ORT to choose the default, 0 = kNextPowerOfTwo, 1 = kSameAsRequested
+   * \param arena_extend_strategy -  use -1 to allow ORT to choose the default, 0 = kNextPowerOfTwo, 1 = kSameAsRequested,
+   *                                 2 = kSizeClassSlab (CPU only)
    * \param initial_chunk_size_bytes - use -1 to allow ORT to choose the default
    * \param max_dead_bytes_per_chunk - use -1 to allow ORT to choose the default
    * See docs/C_API.md for details on what the following parameters mean and how to choose these values
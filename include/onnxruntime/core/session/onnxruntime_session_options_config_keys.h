@@ -24,6 +24,13 @@ static const char* const kOrtSessionOptionsConfigDisablePrepacking = "session.di
 // will be used. Use this to override the usage of env allocators on a per session level.
 static const char* const kOrtSessionOptionsConfigUseEnvAllocators = "session.use_env_allocators";
 
+// A value of "1" means the pre-packed weights of the session are shared with all the other sessions of the env that
+// set it. The weights are shared by content, so the sessions of the same model or of models that share initializers
+// use a single copy of the pre-packed weights of the CPU kernels, without registering a PrepackedWeightsContainer.
+// The shared weights are freed with the last session that uses them. "0" (default) disables the sharing.
+// Initializers that are shared with a PrepackedWeightsContainer keep using the container.
+static const char* const kOrtSessionOptionsConfigUseEnvPrepackedWeights = "session.use_env_prepacked_weights";
+
 // Set to 'ORT' (case sensitive) to load an ORT format model.
 // If unset, model type will default to ONNX unless inferred from filename ('.ort' == ORT format) or bytes to be ORT
 static const char* const kOrtSessionOptionsConfigLoadModelFormat = "session.load_model_format";
@@ -154,6 +161,15 @@ static const char* const kOrtSessionOptionsUseDeviceAllocatorForInitializers = "
 static const char* const kOrtSessionOptionsConfigAllowInterOpSpinning = "session.inter_op.allow_spinning";
 static const char* const kOrtSessionOptionsConfigAllowIntraOpSpinning = "session.intra_op.allow_spinning";
 
+// Adapt the time the intra_op threads spin for work before blocking to the idle gaps between their tasks, instead of
+// spinning a fixed number of times. Every thread keeps a moving average of its idle gaps and spins for up to twice the
+// average, so it picks up the next parallel section without the wake latency when the gaps are short, and gives the
+// core back quickly when they are longer than the budget, e.g. between requests at a low request rate.
+// The value is the upper bound of the spin time in microseconds, e.g. "1000". "0" disables it (default).
+// Only applies if kOrtSessionOptionsConfigAllowIntraOpSpinning is "1". The spin statistics of the threads are part
+// of the thread pool statistics in the profiling output of the session.
+static const char* const kOrtSessionOptionsConfigIntraOpAdaptiveSpinBudgetUs = "session.intra_op.adaptive_spin_budget_us";
+
 // Key for using model bytes directly for ORT format
 // If a session is created using an input byte array contains the ORT format model data,
 // By default we will copy the model bytes at the time of session creation to ensure the model bytes
@@ -172,6 +188,18 @@ static const char* const kOrtSessionOptionsConfigUseORTModelBytesDirectly = "ses
 static const char* const kOrtSessionOptionsConfigUseORTModelBytesForInitializers =
     "session.use_ort_model_bytes_for_initializers";
 
+/// <summary>
+/// Key for memory mapping the model files instead of reading them.
+/// An ORT format model loaded from a file path is mapped into memory, and its initializers refer to the mapping
+/// directly rather than being copied. The external data files of a model are mapped once per process, and all the
+/// initializers that are used on CPU are views into that mapping. The mappings are kept for the lifetime of the
+/// sessions that use them, so the processes that load the same model share one copy of its data in the page cache.
+/// The files MUST NOT be modified while a session uses them.
+/// "0": disabled [DEFAULT]
+/// "1": enabled
+/// </summary>
+static const char* const kOrtSessionOptionsConfigMapModelFiles = "session.map_model_files";
+
 // This should only be specified when exporting an ORT format model for use on a different platform.
 // If the ORT format model will be used on ARM platforms set to "1". For other platforms set to "0"
 // Available since version 1.11.
@@ -220,6 +248,66 @@ static const char* const kOrtSessionOptionsConfigDynamicBlockBase = "session.dyn
 // Applies only to internal thread-pools
 static const char* const kOrtSessionOptionsConfigForceSpinningStop = "session.force_spinning_stop";
 
+// Arena extend strategy of the CPU memory arena. Only used if the CPU memory arena is enabled.
+// "-1": let ORT choose the default. [DEFAULT]
+// "0": kNextPowerOfTwo, "1": kSameAsRequested. Both use the best-fit with coalescing arena (BFCArena).
+// "2": kSizeClassSlab. Serve allocations from fixed size classes through per-thread caches (SlabArena).
+//      Avoids the arena wide lock on every allocation when many threads allocate concurrently.
+static const char* const kOrtSessionOptionsCpuArenaExtendStrategy = "session.cpu_arena_extend_strategy";
+
+// Enables dynamic batching of concurrent RunAsync() calls.
+// Requests with the same input/output names and input shapes that only differ in the first dimension are
+// concatenated along that dimension, executed with a single Run(), and the outputs are split back to each
+// request's callback. This requires the first dimension of every model input to be the same symbolic dimension.
+// Only the requests that fetch outputs with that symbolic first dimension are batched.
+// The value is the maximum total size of the first dimension of a batched Run, e.g. "32".
+// Values below 2 disable dynamic batching. The default is "0".
+static const char* const kOrtSessionOptionsDynamicBatchingMaxBatchSize = "session.dynamic_batching.max_batch_size";
+
+// Maximum time in microseconds a RunAsync() request waits in the queue for other requests to join its batch.
+// Only used if dynamic batching is enabled. The default is "1000".
+static const char* const kOrtSessionOptionsDynamicBatchingMaxQueueDelayUs =
+    "session.dynamic_batching.max_queue_delay_us";
+
+// Enables dataflow execution of the main graph.
+// Instead of running the nodes one after another in the order of the execution plan, a node is dispatched to the
+// intra-op thread pool as soon as all the nodes it depends on have completed, so independent branches of the graph
+// run concurrently. Kernels that parallelize internally use the same intra-op thread pool, so node level and kernel
+// level parallelism share one thread budget.
+// Only applies to graphs that are executed in a single CPU stream, which is the case when only CPU based execution
+// providers are used. Memory reuse across nodes and memory patterns are disabled for the main graph as the order in
+// which nodes run is not fixed.
+// "0": disabled [DEFAULT]
+// "1": enabled
+static const char* const kOrtSessionOptionsEnableDataflowExecution = "session.enable_dataflow_execution";
+
+// Directory of the compiled model cache.
+// When set, the first session created for an ONNX model saves the optimized and partitioned graph as an ORT format
+// model in this directory. The name of the file is a hash of the content of the model and its external data files,
+// the session options and config entries, the registered execution providers, the ORT version and the instruction
+// set extensions of the CPU. A later session with the same hash memory maps that file instead of running the graph
+// optimizers, and its initializers refer to the mapped file directly.
+// Pre-packed weights and the execution plan are not part of the cache, they are rebuilt from the cached model.
+// The cache is not used when the optimized model is saved via SessionOptions.optimized_model_filepath, when external
+// initializers are provided in memory, when graph capture is enabled or when the graph contains compiled nodes.
+// Sample usage: sess_options.add_session_config_entry(kOrtSessionOptionsCompiledModelCacheDir, "/var/cache/ort")
+static const char* const kOrtSessionOptionsCompiledModelCacheDir = "session.compiled_model_cache_dir";
+
+// Buckets the input shapes that the memory patterns are cached for.
+// By default a memory pattern is only reused by runs whose inputs have exactly the same shapes. When bucketing is
+// enabled, every dimension of the inputs is rounded up to the next power of two, so e.g. all the runs with a sequence
+// length between 65 and 128 share one pattern. The pattern of a bucket grows to the largest sizes seen for the bucket,
+// after which every run of the bucket allocates a single block per device for its intermediate values.
+// Only applies when the memory pattern is enabled.
+// "0": disabled [DEFAULT]
+// "1": enabled
+static const char* const kOrtSessionOptionsMemoryPatternShapeBuckets = "session.memory_pattern_shape_buckets";
+
+// Maximum number of memory patterns a session caches for each graph. The least recently used pattern is dropped when
+// a new one exceeds it.
+// "0": unbounded [DEFAULT]
+static const char* const kOrtSessionOptionsMemoryPatternCacheCapacity = "session.memory_pattern_cache_capacity";
+
 // "1": all inconsistencies encountered during shape and type inference
 // will result in failures.
 // "0": in some cases warnings will be logged but processing will continue. The default.
@@ -251,6 +339,20 @@ static const char* const kNodePartitionConfigFile = "session.node_partition_conf
 //    Hence 64-65 is an invalid configuration, because a windows thread cannot be attached to processors across group boundary.
 static const char* const kOrtSessionOptionsConfigIntraOpThreadAffinities = "session.intra_op_thread_affinities";
 
+// Make the intra op thread pool NUMA aware. "0": disable (default); "1": enable.
+// The threads are bound to the physical cores grouped by NUMA node, the memory the threads allocate is bound to their
+// node, and the consecutive parts of a parallel loop are handed to the threads of the same node. The initializers and
+// prepacked weights of the session are interleaved across the nodes.
+// If intra_op_num_threads is 0, the pool has a thread for each physical core. The main thread, which is started and
+// managed by the calling app, is expected to run on the first core of the first node.
+// Ignored if kOrtSessionOptionsConfigIntraOpThreadAffinities is set, or if the NUMA topology is not available.
+static const char* const kOrtSessionOptionsConfigIntraOpNumaAware = "session.intra_op.numa_aware";
+
+// Restrict a NUMA aware intra op thread pool to the cores of a single NUMA node, e.g. to run one session per socket.
+// The initializers and prepacked weights of the session are placed on that node.
+// Setting it implies kOrtSessionOptionsConfigIntraOpNumaAware. The default is "-1", which uses all the nodes.
+static const char* const kOrtSessionOptionsConfigIntraOpNumaNode = "session.intra_op.numa_node";
+
 // This option will dump out the model to assist debugging any issues with layout transformation,
 // and is primarily intended for developer usage. It is only relevant if an execution provider that requests
 // NHWC layout is enabled such as NNAPI, XNNPACK or QNN.
@@ -369,6 +471,7 @@ static const char* const kOrtSessionOptionsEpContextModelExternalInitializersFil
     "ep.context_model_external_initializers_file_name";
 
 // Gemm fastmath mode provides fp32 gemm acceleration with bfloat16 based matmul.
+// It is supported on arm64 and, with AMX-BF16 tiles, on x64 Linux.
 // Option values:
 // - "0": Gemm FastMath mode is not enabled. [DEFAULT]
 // - "1": Gemm FastMath mode is enabled.
@@ -401,3 +504,12 @@ static const char* const kOrtEpDynamicOptionsWorkloadType = "ep.dynamic.workload
 // - "0": EP compile is not disabled. [DEFAULT]
 // - "1": EP compile is disabled.
 static const char* const kOrtSessionOptionsDisableModelCompile = "session.disable_model_compile";
+
+// Enables the always-on metrics of the session, which are cheap enough to be collected in production.
+// The metrics are a latency histogram per node, the latencies of the runs, the tensor allocations of the execution
+// frames, the queue depth of the thread pools and the memory high-water marks of the allocators. They are queried
+// with OrtApi::SessionGetMetrics.
+// Option values:
+// - "0": Metrics are not collected. [DEFAULT]
+// - "1": Metrics are collected.
+static const char* const kOrtSessionOptionsEnableMetrics = "session.enable_metrics";
@@ -11,6 +11,10 @@
 #include "core/common/common.h"
 #include "core/common/safeint.h"
 #include "core/framework/op_kernel.h"
+#include "core/platform/env.h"
+#include "core/platform/env_var_utils.h"
+
+#include <vector>
 
 namespace onnxruntime {
 namespace contrib {
@@ -37,6 +41,11 @@ class GQAAttentionBase {
     local_window_size_ = has_local ? static_cast<int>(info.GetAttrOrDefault<int64_t>("local_window_size", -1)) : -1;
 
     qk_output_ = static_cast<int>(info.GetAttrOrDefault<int64_t>("qk_output", static_cast<int64_t>(QKOutputType::NO_OUTPUT)));
+
+    kv_cache_bit_width_ = static_cast<int>(info.GetAttrOrDefault<int64_t>("kv_cache_bit_width", 0));
+
+    l2_cache_size_ = Env::Default().GetL2CacheSize();
+    disable_flash_ = ParseEnvironmentVariableWithDefault<bool>(attention::kDisableFlashAttention, false);
   }
 
   int num_heads_;     // number of attention heads of Q
@@ -47,9 +56,13 @@ class GQAAttentionBase {
   bool rotary_interleaved_;
   int local_window_size_;
   int qk_output_;
+  int kv_cache_bit_width_;  // 0 if the past and present key and value are not quantized
 
   bool use_smooth_softmax_;
 
+  bool disable_flash_;
+  int l2_cache_size_;
+
   template <typename T>
   Status ApplyAttention(const T* Q,                                 // Q data with shape BxNxSxH
                         const T* K,                                 // K data with shape BxN_kvxSxH
@@ -82,13 +95,6 @@ class GQAAttentionBase {
     }
     int seqlen_present_kv_cache = static_cast<int>(present_key->Shape().GetDims()[2]);
 
-    // Compute the attention score.
-    bool gqa_mlas_supported = MlasGQASupported<T>(CblasNoTrans, CblasTrans) &&
-                              MlasGQASupported<T>(CblasNoTrans, CblasNoTrans);
-    size_t bytes = SafeInt<size_t>(batch_size) * num_heads_ * sequence_length * seqlen_present_kv_cache * (gqa_mlas_supported ? sizeof(T) : sizeof(float));
-    auto attention_probs = allocator->Alloc(bytes);
-    BufferUniquePtr scratch_buffer(attention_probs, BufferDeleter(allocator));
-
     const T* past_key_data = past_key != nullptr ? past_key->Data<T>() : nullptr;
     T* present_key_data = present_key != nullptr ? present_key->MutableData<T>() : nullptr;
     const T* past_value_data = past_value != nullptr ? past_value->Data<T>() : nullptr;
@@ -103,6 +109,23 @@ class GQAAttentionBase {
 
     T* output_qk_buffer = output_qk != nullptr ? output_qk->MutableData<T>() : nullptr;
 
+    if constexpr (std::is_same_v<T, float>) {
+      // The first prompt has no past, so each of its queries only attends to the keys of the prompt before it.
+      if (is_prompt && !disable_flash_ && l2_cache_size_ > 0 && attention_bias == nullptr && output_qk == nullptr) {
+        const T* v = packed_qkv ? Q + (num_heads_ + kv_num_heads_) * sequence_length * head_size : V;
+        ApplyFlashAttention(Q, k, v, head_sink, output->MutableData<T>(), present_key_data, present_value_data,
+                            past_present_share_buffer, parameters, seqlen_present_kv_cache, allocator, tp);
+        return Status::OK();
+      }
+    }
+
+    // Compute the attention score.
+    bool gqa_mlas_supported = MlasGQASupported<T>(CblasNoTrans, CblasTrans) &&
+                              MlasGQASupported<T>(CblasNoTrans, CblasNoTrans);
+    size_t bytes = SafeInt<size_t>(batch_size) * num_heads_ * sequence_length * seqlen_present_kv_cache * (gqa_mlas_supported ? sizeof(T) : sizeof(float));
+    auto attention_probs = allocator->Alloc(bytes);
+    BufferUniquePtr scratch_buffer(attention_probs, BufferDeleter(allocator));
+
     if (gqa_mlas_supported) {
       ComputeAttentionProbs(static_cast<T*>(attention_probs), Q, k, head_sink, seqlens_k->Data<int32_t>(), attention_bias_data,
                             batch_size, sequence_length, total_sequence_length, attention_bias_shape, seqlen_past_kv_cache,
@@ -134,6 +157,270 @@ class GQAAttentionBase {
     return Status::OK();
   }
 
+  // Variant of ApplyAttention for a past and present K/V quantized to kv_cache_bit_width_ bits, with one scale per
+  // token and kv head of shape (B, N_kv, S). The new K/V are quantized as they are appended to the present K/V, and
+  // their scales are computed from their own range so no value is clamped. Each row of Q is then computed against the
+  // cache by MLAS kernels that dequantize it in registers, so reading the cache costs 1/4 or 1/8 of the memory
+  // traffic of fp32.
+  template <typename T>
+  Status ApplyQuantizedKvCacheAttention(const T* Q,                                        // Q data with shape BxNxSxH
+                                        const T* K,                                        // K data with shape BxN_kvxSxH
+                                        const T* V,                                        // V data with shape BxN_kvxSxH
+                                        const T* head_sink,                                // head sinks, nullptr if not used
+                                        const Tensor* past_key,                            // quantized past K
+                                        const Tensor* past_value,                          // quantized past V
+                                        const Tensor* past_key_scale,                      // scales of past K
+                                        const Tensor* past_value_scale,                    // scales of past V
+                                        Tensor* output,                                    // output tensor
+                                        Tensor* present_key,                               // quantized present K
+                                        Tensor* present_value,                             // quantized present V
+                                        Tensor* present_key_scale,                         // scales of present K
+                                        Tensor* present_value_scale,                       // scales of present V
+                                        const Tensor* seqlens_k,                           // past sequence lengths tensor
+                                        const GroupQueryAttentionParameters& parameters,  // attention parameters
+                                        OpKernelContext* context) const {
+    const bool is_prompt = parameters.is_first_prompt;
+    const size_t batch_size = static_cast<size_t>(parameters.batch_size);
+    const size_t sequence_length = static_cast<size_t>(parameters.sequence_length);
+    const size_t head_size = static_cast<size_t>(parameters.head_size);
+    const size_t hidden_size = static_cast<size_t>(parameters.hidden_size);
+    const bool packed_qkv = parameters.is_packed_qkv;
+    const size_t bit_width = static_cast<size_t>(kv_cache_bit_width_);
+    const size_t head_bytes = head_size * bit_width / 8;
+    const size_t past_buffer_sequence_length = static_cast<size_t>(parameters.seqlen_past_kv_cache);
+    const size_t present_buffer_sequence_length = static_cast<size_t>(parameters.seqlen_present_kv_cache);
+    const int32_t* seqlens = seqlens_k->Data<int32_t>();
+
+    auto* tp = context->GetOperatorThreadPool();
+
+    const uint8_t* past_key_data = past_key != nullptr ? static_cast<const uint8_t*>(past_key->DataRaw()) : nullptr;
+    const uint8_t* past_value_data = past_value != nullptr ? static_cast<const uint8_t*>(past_value->DataRaw()) : nullptr;
+    uint8_t* present_key_data = static_cast<uint8_t*>(present_key->MutableDataRaw());
+    uint8_t* present_value_data = static_cast<uint8_t*>(present_value->MutableDataRaw());
+    const bool past_present_share_buffer = past_key_data == present_key_data && past_value_data == present_value_data;
+    const float* past_key_scale_data = past_key_scale != nullptr ? past_key_scale->Data<float>() : nullptr;
+    const float* past_value_scale_data = past_value_scale != nullptr ? past_value_scale->Data<float>() : nullptr;
+    float* present_key_scale_data = present_key_scale->MutableData<float>();
+    float* present_value_scale_data = present_value_scale->MutableData<float>();
+    const bool past_present_share_scale_buffer = past_key_scale_data == present_key_scale_data &&
+                                                 past_value_scale_data == present_value_scale_data;
+
+    const size_t kv_input_chunk_length = sequence_length * head_size;
+    const size_t packed_batch_stride = packed_qkv ? (num_heads_ + 2 * kv_num_heads_) * kv_input_chunk_length : 0;
+    const T* k_input = packed_qkv ? Q + num_heads_ * kv_input_chunk_length : K;
+    const T* v_input = packed_qkv ? Q + (num_heads_ + kv_num_heads_) * kv_input_chunk_length : V;
+
+    // Quantize the new K/V of each kv head into the present K/V, after the past ones.
+    TensorOpCost append_cost;
+    append_cost.bytes_loaded = static_cast<double>(2 * kv_input_chunk_length * sizeof(T));
+    append_cost.bytes_stored = static_cast<double>(2 * sequence_length * head_bytes);
+    append_cost.compute_cycles = static_cast<double>(2 * kv_input_chunk_length);
+    ThreadPool::TryParallelFor(
+        tp, batch_size * kv_num_heads_, append_cost, [&](std::ptrdiff_t begin, std::ptrdiff_t end) {
+          std::vector<float> converted(std::is_same_v<T, float> ? 0 : kv_input_chunk_length);
+          auto quantize = [&](const T* input, uint8_t* cache, float* scale) {
+            if constexpr (std::is_same_v<T, float>) {
+              MlasQuantizeKvCache(bit_width, input, cache, scale, sequence_length, head_size);
+            } else {
+              MlasConvertHalfToFloatBuffer(input, converted.data(), kv_input_chunk_length);
+              MlasQuantizeKvCache(bit_width, converted.data(), cache, scale, sequence_length, head_size);
+            }
+          };
+
+          for (std::ptrdiff_t i = begin; i != end; ++i) {
+            const size_t batch_index = i / kv_num_heads_;
+            const size_t head_index = i % kv_num_heads_;
+            const size_t total_seqlen = static_cast<size_t>(seqlens[batch_index]) + 1;
+            const size_t past_seqlen = is_prompt ? 0 : total_seqlen - sequence_length;
+
+            uint8_t* present_k = present_key_data + i * present_buffer_sequence_length * head_bytes;
+            uint8_t* present_v = present_value_data + i * present_buffer_sequence_length * head_bytes;
+            float* present_k_scale = present_key_scale_data + i * present_buffer_sequence_length;
+            float* present_v_scale = present_value_scale_data + i * present_buffer_sequence_length;
+            if (!past_present_share_buffer && past_seqlen > 0) {
+              std::memcpy(present_k, past_key_data + i * past_buffer_sequence_length * head_bytes,
+                          past_seqlen * head_bytes);
+              std::memcpy(present_v, past_value_data + i * past_buffer_sequence_length * head_bytes,
+                          past_seqlen * head_bytes);
+            }
+            if (!past_present_share_scale_buffer && past_seqlen > 0) {
+              std::memcpy(present_k_scale, past_key_scale_data + i * past_buffer_sequence_length,
+                          past_seqlen * sizeof(float));
+              std::memcpy(present_v_scale, past_value_scale_data + i * past_buffer_sequence_length,
+                          past_seqlen * sizeof(float));
+            }
+
+            const size_t input_offset = packed_qkv ? packed_batch_stride * batch_index + kv_input_chunk_length * head_index
+                                                   : kv_input_chunk_length * i;
+            quantize(k_input + input_offset, present_k + past_seqlen * head_bytes, present_k_scale + past_seqlen);
+            quantize(v_input + input_offset, present_v + past_seqlen * head_bytes, present_v_scale + past_seqlen);
+          }
+        });
+
+    const float alpha = scale_ == 0.0f ? 1.0f / sqrt(static_cast<float>(head_size)) : scale_;
+    const size_t kv_num_heads_factor = static_cast<size_t>(num_heads_ / kv_num_heads_);
+    const size_t q_chunk_length = sequence_length * head_size;
+    T* output_data = output->MutableData<T>();
+
+    TensorOpCost attention_cost;
+    attention_cost.bytes_loaded = static_cast<double>(sequence_length * present_buffer_sequence_length * head_bytes * 2);
+    attention_cost.bytes_stored = static_cast<double>(q_chunk_length * sizeof(T));
+    attention_cost.compute_cycles = static_cast<double>(4 * sequence_length * present_buffer_sequence_length * head_size);
+    ThreadPool::TryParallelFor(
+        tp, batch_size * num_heads_, attention_cost, [&](std::ptrdiff_t begin, std::ptrdiff_t end) {
+          std::vector<float> query(head_size);
+          std::vector<float> scores(present_buffer_sequence_length);
+          std::vector<float> context_row(head_size);
+
+          for (std::ptrdiff_t i = begin; i != end; ++i) {
+            const size_t batch_index = i / num_heads_;
+            const size_t head_index = i % num_heads_;
+            const size_t kv_head_index = head_index / kv_num_heads_factor;
+            const size_t total_seqlen = static_cast<size_t>(seqlens[batch_index]) + 1;
+            const size_t past_seqlen = is_prompt ? 0 : total_seqlen - sequence_length;
+
+            const size_t kv_offset = (batch_index * kv_num_heads_ + kv_head_index) * present_buffer_sequence_length;
+            const uint8_t* keys = present_key_data + kv_offset * head_bytes;
+            const uint8_t* values = present_value_data + kv_offset * head_bytes;
+            const float* key_scales = present_key_scale_data + kv_offset;
+            const float* value_scales = present_value_scale_data + kv_offset;
+            const T* q = Q + (packed_qkv ? packed_batch_stride * batch_index + q_chunk_length * head_index
+                                         : q_chunk_length * i);
+            const float sink = (head_sink != nullptr) ? static_cast<float>(head_sink[head_index]) : 0.0f;
+
+            for (size_t seq = 0; seq < sequence_length; seq++) {
+              const size_t seq_causal_length = past_seqlen + seq + 1;
+
+              // local_window_size does not include the current query token, while window_size includes it.
+              const bool should_apply_local_window = local_window_size_ >= 0 &&
+                                                     seq_causal_length > static_cast<size_t>(local_window_size_) + 1;
+              const size_t start_offset = should_apply_local_window ? seq_causal_length - local_window_size_ - 1 : 0;
+              const size_t window_size = should_apply_local_window ? local_window_size_ + 1 : seq_causal_length;
+
+              for (size_t k = 0; k < head_size; k++) {
+                query[k] = static_cast<float>(q[seq * head_size + k]) * alpha;
+              }
+              MlasKvCacheDot(bit_width, query.data(), keys + start_offset * head_bytes, scores.data(), window_size,
+                             head_size);
+              for (size_t j = 0; j < window_size; j++) {
+                scores[j] *= key_scales[start_offset + j];
+              }
+
+              if (softcap_ > 0.f) {
+                ComputeAttentionSoftcapInplace(scores.data(), static_cast<int>(window_size), softcap_);
+              }
+
+              if (use_smooth_softmax_ || head_sink != nullptr) {
+                ComputeSmoothSoftmaxInplace(scores.data(), static_cast<int>(window_size), sink, nullptr);
+              } else {
+                ComputeAttentionSoftmaxInplace(scores.data(), 1, static_cast<int>(window_size), nullptr);
+              }
+
+              // Fold the scales of the values into the attention probabilities.
+              for (size_t j = 0; j < window_size; j++) {
+                scores[j] *= value_scales[start_offset + j];
+              }
+              MlasKvCacheAccumulate(bit_width, scores.data(), values + start_offset * head_bytes, context_row.data(),
+                                    window_size, head_size);
+
+              // output is BxSxNxH
+              T* out = output_data + (batch_index * sequence_length + seq) * hidden_size + head_index * head_size;
+              for (size_t k = 0; k < head_size; k++) {
+                out[k] = static_cast<T>(context_row[k]);
+              }
+            }
+          }
+        });
+
+    return Status::OK();
+  }
+
+  // Applies attention to the packed tokens of the sequences of a batch whose K/V live in a block-based (paged) cache.
+  // Token t of sequence b is kept in slot t % block_size of block block_table[b][t / block_size], so a sequence only
+  // holds as many blocks as it needs instead of a buffer of the max sequence length. The new K/V of every sequence
+  // are appended to its blocks before the attention is computed from them.
+  template <typename T>
+  Status ApplyPagedAttention(const T* Q,                                  // Q data with shape (token_count, N, H)
+                             const T* K,                                  // K data with shape (token_count, N_kv, H)
+                             const T* V,                                  // V data with shape (token_count, N_kv, H)
+                             const size_t q_row_stride,                   // distance between the tokens of Q
+                             const size_t kv_row_stride,                  // distance between the tokens of K and V
+                             const int32_t* cumulative_seqlens,           // cumulative new sequence lengths (B + 1)
+                             const int32_t* past_seqlens,                 // past sequence lengths (B)
+                             const int32_t* block_table,                  // blocks of each sequence (B, max_blocks)
+                             T* key_cache,                                // key cache with shape (blocks, bs, N_kv, H)
+                             T* value_cache,                              // value cache with shape (blocks, bs, N_kv, H)
+                             T* output,                                   // output with shape (token_count, N x H)
+                             const PagedAttentionParameters& parameters,  // attention parameters
+                             AllocatorPtr allocator,                      // allocator for temporary tensors
+                             OpKernelContext* context) const {
+    const size_t batch_size = static_cast<size_t>(parameters.batch_size);
+    const size_t head_size = static_cast<size_t>(parameters.head_size);
+    const size_t block_size = static_cast<size_t>(parameters.block_size);
+    const size_t max_num_blocks_per_seq = static_cast<size_t>(parameters.max_num_blocks_per_seq);
+    const size_t cache_row_stride = SafeInt<size_t>(kv_num_heads_) * head_size;
+
+    auto* tp = context->GetOperatorThreadPool();
+
+    // Append the new K/V of every sequence to its blocks.
+    TensorOpCost append_cost;
+    append_cost.bytes_loaded = static_cast<double>(2 * parameters.token_count * head_size * sizeof(T)) / batch_size;
+    append_cost.bytes_stored = append_cost.bytes_loaded;
+    append_cost.compute_cycles = 0;
+    ThreadPool::TryParallelFor(
+        tp, batch_size * kv_num_heads_, append_cost, [&](std::ptrdiff_t begin, std::ptrdiff_t end) {
+          for (std::ptrdiff_t i = begin; i != end; ++i) {
+            const size_t batch_index = i / kv_num_heads_;
+            const size_t head_offset = (i % kv_num_heads_) * head_size;
+            const int32_t* blocks = block_table + batch_index * max_num_blocks_per_seq;
+            for (int32_t token = cumulative_seqlens[batch_index]; token < cumulative_seqlens[batch_index + 1]; ++token) {
+              const size_t position = static_cast<size_t>(past_seqlens[batch_index]) +
+                                      static_cast<size_t>(token - cumulative_seqlens[batch_index]);
+              const size_t slot = static_cast<size_t>(blocks[position / block_size]) * block_size + position % block_size;
+              std::memcpy(key_cache + slot * cache_row_stride + head_offset,
+                          K + static_cast<size_t>(token) * kv_row_stride + head_offset, head_size * sizeof(T));
+              std::memcpy(value_cache + slot * cache_row_stride + head_offset,
+                          V + static_cast<size_t>(token) * kv_row_stride + head_offset, head_size * sizeof(T));
+            }
+          }
+        });
+
+    // The attention probs of sequence b have shape (N, S_b, T_b), so they start at probs_offsets[b].
+    // kv_token_count is the sum of T_b, the number of keys and values read per head over all the sequences.
+    std::vector<size_t> probs_offsets(batch_size + 1, 0);
+    size_t kv_token_count = 0;
+    for (size_t b = 0; b < batch_size; ++b) {
+      const size_t new_seqlen = static_cast<size_t>(cumulative_seqlens[b + 1] - cumulative_seqlens[b]);
+      const size_t total_seqlen = static_cast<size_t>(past_seqlens[b]) + new_seqlen;
+      probs_offsets[b + 1] = probs_offsets[b] + SafeInt<size_t>(num_heads_) * new_seqlen * total_seqlen;
+      kv_token_count += total_seqlen;
+    }
+
+    const bool gqa_mlas_supported = MlasGQASupported<T>(CblasNoTrans, CblasTrans) &&
+                                    MlasGQASupported<T>(CblasNoTrans, CblasNoTrans);
+    size_t bytes = SafeInt<size_t>(probs_offsets[batch_size]) * (gqa_mlas_supported ? sizeof(T) : sizeof(float));
+    auto attention_probs = allocator->Alloc(bytes);
+    BufferUniquePtr scratch_buffer(attention_probs, BufferDeleter(allocator));
+
+    if (gqa_mlas_supported) {
+      ComputePagedAttentionProbs(static_cast<T*>(attention_probs), Q, q_row_stride, key_cache, cumulative_seqlens,
+                                 past_seqlens, block_table, probs_offsets, kv_token_count, parameters, tp,
+                                 allocator);
+      ComputePagedVxAttentionScore(output, static_cast<T*>(attention_probs), value_cache, cumulative_seqlens,
+                                   past_seqlens, block_table, probs_offsets, kv_token_count, parameters, tp,
+                                   allocator);
+    } else {
+      ComputePagedAttentionProbs(static_cast<float*>(attention_probs), Q, q_row_stride, key_cache, cumulative_seqlens,
+                                 past_seqlens, block_table, probs_offsets, kv_token_count, parameters, tp,
+                                 allocator);
+      ComputePagedVxAttentionScore(output, static_cast<float*>(attention_probs), value_cache, cumulative_seqlens,
+                                   past_seqlens, block_table, probs_offsets, kv_token_count, parameters, tp,
+                                   allocator);
+    }
+
+    return Status::OK();
+  }
+
  private:
   // Helper function to compute the attention probs. It does 2 things:
   //  attention_probs(B, N, S, T) = 1/sqrt(H) x Q(B, N, S, H) x K'(B, N, T, H -> B, N, H, T)
@@ -484,6 +771,324 @@ class GQAAttentionBase {
     }
   }
 
+  // Computes the attention of the first prompt with MlasFlashAttention, one block of queries and keys at a time with
+  // an online softmax, so the (B, N, S, T) attention probs are never materialized. The K/V of the prompt are copied to
+  // the present buffers first.
+  void ApplyFlashAttention(const float* Q,                                    // Q data with shape BxNxSxH
+                           const float* K,                                    // K data with shape BxN_kvxSxH
+                           const float* V,                                    // V data with shape BxN_kvxSxH
+                           const float* head_sink,                            // head sinks, nullptr if not used
+                           float* output,                                     // output with shape BxSxNxH
+                           float* present_key,                                // present key with shape BxN_kvxTxH
+                           float* present_value,                              // present value with shape BxN_kvxTxH
+                           const bool past_present_share_buffer,              // whether past and present share buffers
+                           const GroupQueryAttentionParameters& parameters,  // attention parameters
+                           const int present_buffer_sequence_length,          // sequence length of present state (T)
+                           AllocatorPtr allocator,                            // allocator for temporary buffer
+                           ThreadPool* tp) const {
+    const int batch_size = parameters.batch_size;
+    const int sequence_length = parameters.sequence_length;
+    const int head_size = parameters.head_size;
+    const bool packed_qkv = parameters.is_packed_qkv;
+
+    const ptrdiff_t packed_batch_stride =
+        packed_qkv ? SafeInt<ptrdiff_t>(num_heads_ + 2 * kv_num_heads_) * sequence_length * head_size
+                   : SafeInt<ptrdiff_t>(0);
+    const size_t kv_input_chunk_length = SafeInt<size_t>(sequence_length) * head_size;
+    const size_t present_buff_chunk_length = SafeInt<size_t>(present_buffer_sequence_length) * head_size;
+
+    if (!past_present_share_buffer) {
+      memset(present_key, 0, SafeInt<size_t>(batch_size) * kv_num_heads_ * present_buff_chunk_length * sizeof(float));
+      memset(present_value, 0, SafeInt<size_t>(batch_size) * kv_num_heads_ * present_buff_chunk_length * sizeof(float));
+    }
+
+    TensorOpCost copy_cost;
+    copy_cost.bytes_loaded = static_cast<double>(2 * kv_input_chunk_length * sizeof(float));
+    copy_cost.bytes_stored = copy_cost.bytes_loaded;
+    copy_cost.compute_cycles = 0;
+    ThreadPool::TryParallelFor(tp, SafeInt<ptrdiff_t>(batch_size) * kv_num_heads_, copy_cost,
+                               [&](std::ptrdiff_t begin, std::ptrdiff_t end) {
+                                 for (std::ptrdiff_t i = begin; i != end; ++i) {
+                                   const ptrdiff_t batch_index = i / kv_num_heads_;
+                                   const ptrdiff_t head_index = i % kv_num_heads_;
+                                   const ptrdiff_t input_offset =
+                                       packed_qkv ? packed_batch_stride * batch_index + kv_input_chunk_length * head_index
+                                                  : kv_input_chunk_length * i;
+                                   memcpy(present_key + present_buff_chunk_length * i, K + input_offset,
+                                          kv_input_chunk_length * sizeof(float));
+                                   memcpy(present_value + present_buff_chunk_length * i, V + input_offset,
+                                          kv_input_chunk_length * sizeof(float));
+                                 }
+                               });
+
+    MlasFlashAttentionThreadedArgs args;
+    args.batch_size = batch_size;
+    args.num_heads = num_heads_;
+    args.q_sequence_length = sequence_length;
+    args.kv_sequence_length = sequence_length;
+    args.qk_head_size = head_size;
+    args.v_head_size = head_size;
+    args.scale = scale_ == 0.0f ? 1.0f / sqrt(static_cast<float>(head_size)) : scale_;
+
+    // Same blocking as MultiHeadAttention: the slices of Q, K, V and O and the block of scores take 3/4 of L2.
+    args.kv_block_size = l2_cache_size_ / (static_cast<int>(sizeof(float)) * 4 * (head_size + head_size));
+    args.kv_block_size = std::max(args.kv_block_size, 1);
+    args.q_block_size = std::min(args.kv_block_size, head_size + head_size);
+    args.kv_block_size = std::min(args.kv_block_size, sequence_length);
+    args.q_block_size = std::min(args.q_block_size, sequence_length);
+
+    args.thread_count = ThreadPool::DegreeOfParallelism(tp);
+    args.buffer_size_per_thread = (static_cast<size_t>(args.q_block_size) * 2 +
+                                   static_cast<size_t>(args.q_block_size) * static_cast<size_t>(args.kv_block_size) +
+                                   static_cast<size_t>(args.q_block_size) * static_cast<size_t>(args.v_head_size)) *
+                                  sizeof(float);
+    IAllocatorUniquePtr<void> buffer =
+        IAllocator::MakeUniquePtr<void>(allocator, args.buffer_size_per_thread * args.thread_count);
+    args.buffer = reinterpret_cast<float*>(buffer.get());
+
+    args.query = Q;
+    args.key = present_key;
+    args.value = present_value;
+    args.output = output;
+
+    args.kv_num_heads = kv_num_heads_;
+    args.kv_buffer_sequence_length = present_buffer_sequence_length;
+    args.query_batch_stride = static_cast<size_t>(packed_batch_stride);
+    args.is_causal = true;
+    args.local_window_size = local_window_size_;
+    args.softcap = softcap_;
+    args.smooth_softmax = use_smooth_softmax_;
+    args.head_sink = head_sink;
+
+    MlasFlashAttention(&args, tp);
+  }
+
+  // Paged variant of ComputeAttentionProbs. The keys of a sequence are gathered block by block through its block
+  // table: each block is a (block_size x H) matrix with a row stride of N_kv x H in the cache, so it is multiplied in
+  // place without being copied.
+  template <typename T, typename U>
+  void ComputePagedAttentionProbs(U* attention_probs,                           // output buffer, see probs_offsets
+                                  const T* Q,                                   // Q data with shape (tokens, N, H)
+                                  const size_t q_row_stride,                    // distance between the tokens of Q
+                                  const T* key_cache,                           // key cache (blocks, bs, N_kv, H)
+                                  const int32_t* cumulative_seqlens,            // cumulative new sequence lengths
+                                  const int32_t* past_seqlens,                  // past sequence lengths
+                                  const int32_t* block_table,                   // blocks of each sequence
+                                  const std::vector<size_t>& probs_offsets,     // offsets of the probs of sequences
+                                  const size_t kv_token_count,                  // keys of all the sequences
+                                  const PagedAttentionParameters& parameters,   // attention parameters
+                                  ThreadPool* tp,                               // thread pool
+                                  AllocatorPtr allocator) const {               // allocator for temporary buffer
+    const size_t batch_size = static_cast<size_t>(parameters.batch_size);
+    const size_t head_size = static_cast<size_t>(parameters.head_size);
+    const size_t block_size = static_cast<size_t>(parameters.block_size);
+    const size_t max_num_blocks_per_seq = static_cast<size_t>(parameters.max_num_blocks_per_seq);
+    const size_t cache_row_stride = SafeInt<size_t>(kv_num_heads_) * head_size;
+    const size_t kv_num_heads_factor = num_heads_ / kv_num_heads_;
+    const float alpha = scale_ == 0.0f ? 1.0f / sqrt(static_cast<float>(head_size)) : scale_;
+
+    const size_t loop_len = batch_size * num_heads_;
+    const double probs_per_head = static_cast<double>(probs_offsets[batch_size]) / loop_len;
+    TensorOpCost unit_cost;
+    unit_cost.compute_cycles = 2 * probs_per_head * head_size;
+    unit_cost.bytes_loaded = static_cast<double>(kv_token_count) / batch_size * head_size * sizeof(T) +
+                             probs_per_head * sizeof(U);
+    unit_cost.bytes_stored = 2 * probs_per_head * sizeof(U);
+
+    ThreadPool::TryParallelFor(tp, loop_len, unit_cost, [&](std::ptrdiff_t begin, std::ptrdiff_t end) {
+      for (std::ptrdiff_t i = begin; i != end; ++i) {
+        const size_t batch_index = i / num_heads_;
+        const size_t head_index = i % num_heads_;
+        const size_t sequence_length = static_cast<size_t>(cumulative_seqlens[batch_index + 1] -
+                                                           cumulative_seqlens[batch_index]);
+        if (sequence_length == 0) {
+          continue;
+        }
+        const size_t past_seqlen = static_cast<size_t>(past_seqlens[batch_index]);
+        const size_t total_seqlen = past_seqlen + sequence_length;
+        const int32_t* blocks = block_table + batch_index * max_num_blocks_per_seq;
+        const size_t kv_head_offset = (head_index / kv_num_heads_factor) * head_size;
+
+        U* output = attention_probs + probs_offsets[batch_index] + head_index * sequence_length * total_seqlen;
+        const T* q = Q + static_cast<size_t>(cumulative_seqlens[batch_index]) * q_row_stride + head_index * head_size;
+
+        // Compute Q*K' one block of keys at a time
+        //                     each iteration
+        // A: Q                S x H
+        // B: K'               H x block_size
+        // C: attention_probs  S x block_size, out of S x T
+        float* q_fp32 = nullptr;
+        float* k_fp32 = nullptr;
+        BufferUniquePtr scratch_buffer;
+        if constexpr (std::is_same_v<T, MLFloat16> && std::is_same_v<U, float>) {
+          size_t bytes = head_size * (sequence_length + block_size) * sizeof(float);
+          scratch_buffer = BufferUniquePtr(allocator->Alloc(bytes), BufferDeleter(allocator));
+          q_fp32 = static_cast<float*>(scratch_buffer.get());
+          k_fp32 = q_fp32 + head_size * sequence_length;
+          for (size_t seq = 0; seq < sequence_length; seq++) {
+            MlasConvertHalfToFloatBuffer(q + seq * q_row_stride, q_fp32 + seq * head_size, head_size);
+          }
+        }
+
+        for (size_t block_start = 0; block_start < total_seqlen; block_start += block_size) {
+          const size_t block_len = std::min(block_size, total_seqlen - block_start);
+          const T* k = key_cache + static_cast<size_t>(blocks[block_start / block_size]) * block_size * cache_row_stride +
+                       kv_head_offset;
+
+          if constexpr (std::is_same<T, float>::value) {
+            math::GemmEx<float, ThreadPool>(CblasNoTrans, CblasTrans, sequence_length, block_len, head_size, alpha, q,
+                                            static_cast<int>(q_row_stride), k, static_cast<int>(cache_row_stride),
+                                            0.0f /*beta*/, output + block_start, static_cast<int>(total_seqlen),
+                                            nullptr);
+          } else if constexpr (std::is_same<U, MLFloat16>::value) {
+            MlasGemm(CblasNoTrans, CblasTrans, sequence_length, block_len, head_size,
+                     q, q_row_stride, k, cache_row_stride, output + block_start, total_seqlen,
+                     MLFloat16(alpha).val, static_cast<uint16_t>(0) /*beta*/, nullptr);
+          } else {
+            for (size_t row = 0; row < block_len; row++) {
+              MlasConvertHalfToFloatBuffer(k + row * cache_row_stride, k_fp32 + row * head_size, head_size);
+            }
+            math::GemmEx<float, ThreadPool>(CblasNoTrans, CblasTrans, sequence_length, block_len, head_size, alpha,
+                                            q_fp32, static_cast<int>(head_size), k_fp32, static_cast<int>(head_size),
+                                            0.0f /*beta*/, output + block_start, static_cast<int>(total_seqlen),
+                                            nullptr);
+          }
+        }
+
+        // compute Softmax
+        U* output_softmax = output;
+        for (size_t seq = 0; seq < sequence_length; seq++) {
+          const size_t seq_causal_length = past_seqlen + seq + 1;
+
+          // local_window_size does not include the current query token, while window_size includes it.
+          const bool should_apply_local_window = local_window_size_ >= 0 &&
+                                                 seq_causal_length > static_cast<size_t>(local_window_size_) + 1;
+
+          const size_t start_offset = should_apply_local_window ? seq_causal_length - local_window_size_ - 1 : 0;
+          const size_t window_size = should_apply_local_window ? local_window_size_ + 1 : seq_causal_length;
+
+          // Mask everything before the local window and after the current token
+          for (size_t total_seq_id = 0; total_seq_id < start_offset; total_seq_id++) {
+            output_softmax[total_seq_id] = U(0.f);
+          }
+          for (size_t total_seq_id = seq_causal_length; total_seq_id < total_seqlen; total_seq_id++) {
+            output_softmax[total_seq_id] = U(0.f);
+          }
+
+          if (softcap_ > 0.f) {
+            ComputeAttentionSoftcapInplace(output_softmax + start_offset, static_cast<int>(window_size),
+                                           static_cast<U>(softcap_));
+          }
+
+          if (use_smooth_softmax_) {
+            ComputeSmoothSoftmaxInplace(output_softmax + start_offset, static_cast<int>(window_size), 0.0f, nullptr);
+          } else {
+            ComputeAttentionSoftmaxInplace(output_softmax + start_offset, 1, static_cast<int>(window_size), nullptr);
+          }
+
+          output_softmax += total_seqlen;
+        }
+      }
+    });
+  }
+
+  // Paged variant of ComputeVxAttentionScore, which accumulates attention_probs x V one block of values at a time.
+  template <typename T, typename U>
+  void ComputePagedVxAttentionScore(T* output,                                    // output with shape (tokens, N x H)
+                                    const U* attention_probs,                     // attention probs, see probs_offsets
+                                    const T* value_cache,                         // value cache (blocks, bs, N_kv, H)
+                                    const int32_t* cumulative_seqlens,            // cumulative new sequence lengths
+                                    const int32_t* past_seqlens,                  // past sequence lengths
+                                    const int32_t* block_table,                   // blocks of each sequence
+                                    const std::vector<size_t>& probs_offsets,     // offsets of the probs of sequences
+                                    const size_t kv_token_count,                  // values of all the sequences
+                                    const PagedAttentionParameters& parameters,   // attention parameters
+                                    ThreadPool* tp,                               // thread pool
+                                    AllocatorPtr allocator) const {               // allocator for temporary buffer
+    const size_t batch_size = static_cast<size_t>(parameters.batch_size);
+    const size_t token_count = static_cast<size_t>(parameters.token_count);
+    const size_t head_size = static_cast<size_t>(parameters.head_size);
+    const size_t hidden_size = static_cast<size_t>(parameters.hidden_size);
+    const size_t block_size = static_cast<size_t>(parameters.block_size);
+    const size_t max_num_blocks_per_seq = static_cast<size_t>(parameters.max_num_blocks_per_seq);
+    const size_t cache_row_stride = SafeInt<size_t>(kv_num_heads_) * head_size;
+    const size_t kv_num_heads_factor = num_heads_ / kv_num_heads_;
+
+    const size_t loop_len = batch_size * num_heads_;
+    const double probs_per_head = static_cast<double>(probs_offsets[batch_size]) / loop_len;
+    TensorOpCost unit_cost;
+    unit_cost.compute_cycles = 2 * probs_per_head * head_size;
+    unit_cost.bytes_loaded = static_cast<double>(kv_token_count) / batch_size * head_size * sizeof(T) +
+                             probs_per_head * sizeof(U);
+    unit_cost.bytes_stored = static_cast<double>(token_count) / batch_size * head_size * sizeof(T);
+
+    size_t output_fp32_bytes = 0;
+    if constexpr (std::is_same<T, MLFloat16>::value && std::is_same<U, float>::value) {
+      output_fp32_bytes = SafeInt<size_t>(token_count) * hidden_size * sizeof(float);
+    }
+    auto output_fp32 = allocator->Alloc(output_fp32_bytes);
+    BufferUniquePtr scratch_buffer(output_fp32, BufferDeleter(allocator));
+
+    ThreadPool::TryParallelFor(tp, loop_len, unit_cost, [&](std::ptrdiff_t begin, std::ptrdiff_t end) {
+      for (std::ptrdiff_t i = begin; i != end; ++i) {
+        const size_t batch_index = i / num_heads_;
+        const size_t head_index = i % num_heads_;
+        const size_t sequence_length = static_cast<size_t>(cumulative_seqlens[batch_index + 1] -
+                                                           cumulative_seqlens[batch_index]);
+        if (sequence_length == 0) {
+          continue;
+        }
+        const size_t total_seqlen = static_cast<size_t>(past_seqlens[batch_index]) + sequence_length;
+        const int32_t* blocks = block_table + batch_index * max_num_blocks_per_seq;
+        const size_t kv_head_offset = (head_index / kv_num_heads_factor) * head_size;
+        const size_t output_offset = static_cast<size_t>(cumulative_seqlens[batch_index]) * hidden_size +
+                                     head_index * head_size;
+
+        const U* probs = attention_probs + probs_offsets[batch_index] + head_index * sequence_length * total_seqlen;
+
+        float* v_fp32 = nullptr;
+        BufferUniquePtr v_scratch_buffer;
+        if constexpr (std::is_same_v<T, MLFloat16> && std::is_same_v<U, float>) {
+          v_scratch_buffer = BufferUniquePtr(allocator->Alloc(head_size * block_size * sizeof(float)),
+                                             BufferDeleter(allocator));
+          v_fp32 = static_cast<float*>(v_scratch_buffer.get());
+        }
+
+        for (size_t block_start = 0; block_start < total_seqlen; block_start += block_size) {
+          const size_t block_len = std::min(block_size, total_seqlen - block_start);
+          const T* v = value_cache + static_cast<size_t>(blocks[block_start / block_size]) * block_size * cache_row_stride +
+                       kv_head_offset;
+          const bool is_first_block = block_start == 0;
+
+          if constexpr (std::is_same<T, float>::value) {
+            math::GemmEx<float, ThreadPool>(CblasNoTrans, CblasNoTrans, sequence_length, head_size, block_len,
+                                            1.f, /*alpha*/ probs + block_start, static_cast<int>(total_seqlen), v,
+                                            static_cast<int>(cache_row_stride), is_first_block ? 0.0f : 1.0f /*beta*/,
+                                            output + output_offset, static_cast<int>(hidden_size), nullptr);
+          } else if constexpr (std::is_same<U, MLFloat16>::value) {
+            MlasGemm(CblasNoTrans, CblasNoTrans, sequence_length, head_size, block_len,
+                     probs + block_start, total_seqlen, v, cache_row_stride, output + output_offset, hidden_size,
+                     MLFloat16(1.0f).val, is_first_block ? static_cast<uint16_t>(0) : MLFloat16(1.0f).val /*beta*/,
+                     nullptr);
+          } else {
+            for (size_t row = 0; row < block_len; row++) {
+              MlasConvertHalfToFloatBuffer(v + row * cache_row_stride, v_fp32 + row * head_size, head_size);
+            }
+            math::GemmEx<float, ThreadPool>(CblasNoTrans, CblasNoTrans, sequence_length, head_size, block_len,
+                                            1.f, /*alpha*/ probs + block_start, static_cast<int>(total_seqlen), v_fp32,
+                                            static_cast<int>(head_size), is_first_block ? 0.0f : 1.0f /*beta*/,
+                                            static_cast<float*>(output_fp32) + output_offset,
+                                            static_cast<int>(hidden_size), nullptr);
+          }
+        }
+      }
+    });
+
+    if constexpr (std::is_same<T, MLFloat16>::value && std::is_same<U, float>::value) {
+      MlasConvertFloatToHalfBuffer(static_cast<float*>(output_fp32), output, SafeInt<size_t>(token_count) * hidden_size);
+    }
+  }
+
   template <typename T, typename U>
   void WriteOutputQKHeadChunk(T* output_qk, const U* attention_probs, size_t total_sequence_length) const {
     if (output_qk == nullptr) {
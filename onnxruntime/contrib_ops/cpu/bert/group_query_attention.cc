@@ -22,16 +22,19 @@ namespace onnxruntime {
 namespace contrib {
 
 // These ops are internal-only, so register outside of onnx
-#define REGISTER_KERNEL_TYPED(T)                                        \
-  ONNX_OPERATOR_TYPED_KERNEL_EX(                                        \
-      GroupQueryAttention,                                              \
-      kMSDomain,                                                        \
-      1,                                                                \
-      T,                                                                \
-      kCpuExecutionProvider,                                            \
-      KernelDefBuilder()                                                \
-          .TypeConstraint("T", DataTypeImpl::GetTensorType<T>())        \
-          .TypeConstraint("M", DataTypeImpl::GetTensorType<int32_t>()), \
+#define REGISTER_KERNEL_TYPED(T)                                               \
+  ONNX_OPERATOR_TYPED_KERNEL_EX(                                               \
+      GroupQueryAttention,                                                     \
+      kMSDomain,                                                               \
+      1,                                                                       \
+      T,                                                                       \
+      kCpuExecutionProvider,                                                   \
+      KernelDefBuilder()                                                       \
+          .TypeConstraint("T", DataTypeImpl::GetTensorType<T>())               \
+          .TypeConstraint("T_CACHE", {DataTypeImpl::GetTensorType<T>(),        \
+                                      DataTypeImpl::GetTensorType<int8_t>(),   \
+                                      DataTypeImpl::GetTensorType<uint8_t>()}) \
+          .TypeConstraint("M", DataTypeImpl::GetTensorType<int32_t>()),        \
       GroupQueryAttention<T>);
 
 REGISTER_KERNEL_TYPED(float)
@@ -55,13 +58,18 @@ Status GroupQueryAttention<T>::Compute(OpKernelContext* context) const {
   const Tensor* position_ids = context->Input<Tensor>(9);
   const Tensor* attention_bias = context->Input<Tensor>(10);
   const Tensor* head_sink = context->Input<Tensor>(11);
+  const Tensor* past_key_scale = context->Input<Tensor>(12);
+  const Tensor* past_value_scale = context->Input<Tensor>(13);
+
+  // The shape of a quantized past key and value is checked separately.
+  const bool is_kv_cache_quantized = kv_cache_bit_width_ != 0;
 
   GroupQueryAttentionParameters parameters = {};
   ORT_RETURN_IF_ERROR(group_query_attention_helper::CheckInputs(query,
                                                                 key,
                                                                 value,
-                                                                past_key,
-                                                                past_value,
+                                                                is_kv_cache_quantized ? nullptr : past_key,
+                                                                is_kv_cache_quantized ? nullptr : past_value,
                                                                 cos_cache,
                                                                 sin_cache,
                                                                 &parameters,
@@ -77,6 +85,16 @@ Status GroupQueryAttention<T>::Compute(OpKernelContext* context) const {
                                                                                head_sink,
                                                                                parameters));
 
+  if (is_kv_cache_quantized) {
+    ORT_RETURN_IF_ERROR(group_query_attention_helper::CheckQuantizedKvCache(past_key, past_value, past_key_scale,
+                                                                            past_value_scale, kv_cache_bit_width_,
+                                                                            parameters));
+    if (attention_bias != nullptr || qk_output_ != static_cast<int>(QKOutputType::NO_OUTPUT)) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, NOT_IMPLEMENTED,
+                             "attention_bias and qk_output are not supported with a quantized kv cache.");
+    }
+  }
+
   const int batch_size = parameters.batch_size;
   const int sequence_length = parameters.sequence_length;
   const int present_kv_seqlen = parameters.seqlen_present_kv_cache;
@@ -90,8 +108,10 @@ Status GroupQueryAttention<T>::Compute(OpKernelContext* context) const {
   output_shape[2] = static_cast<int64_t>(q_hidden_size);
   Tensor* output = context->Output(0, output_shape);
 
-  std::vector<int64_t> present_k_shape({static_cast<int64_t>(batch_size), static_cast<int64_t>(kv_num_heads_), static_cast<int64_t>(present_kv_seqlen), static_cast<int64_t>(head_size)});
-  std::vector<int64_t> present_v_shape({static_cast<int64_t>(batch_size), static_cast<int64_t>(kv_num_heads_), static_cast<int64_t>(present_kv_seqlen), static_cast<int64_t>(head_size)});
+  // a quantized head takes head_size * kv_cache_bit_width / 8 bytes
+  const int present_head_size = is_kv_cache_quantized ? head_size * kv_cache_bit_width_ / 8 : head_size;
+  std::vector<int64_t> present_k_shape({static_cast<int64_t>(batch_size), static_cast<int64_t>(kv_num_heads_), static_cast<int64_t>(present_kv_seqlen), static_cast<int64_t>(present_head_size)});
+  std::vector<int64_t> present_v_shape({static_cast<int64_t>(batch_size), static_cast<int64_t>(kv_num_heads_), static_cast<int64_t>(present_kv_seqlen), static_cast<int64_t>(present_head_size)});
   Tensor* present_k = context->Output(1, present_k_shape);
   Tensor* present_v = context->Output(2, present_v_shape);
 
@@ -100,6 +120,20 @@ Status GroupQueryAttention<T>::Compute(OpKernelContext* context) const {
 
   ORT_RETURN_IF_ERROR(group_query_attention_helper::CheckOutputs(output_qk, qk_output_));
 
+  // one scale per token of each kv head of the quantized present key and value
+  Tensor* present_k_scale = nullptr;
+  Tensor* present_v_scale = nullptr;
+  if (is_kv_cache_quantized) {
+    const TensorShape present_scale_shape({batch_size, kv_num_heads_, present_kv_seqlen});
+    present_k_scale = context->Output(4, present_scale_shape);
+    present_v_scale = context->Output(5, present_scale_shape);
+    if (present_k_scale == nullptr || present_v_scale == nullptr) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                             "Outputs 'present_key_scale' and 'present_value_scale' are required when "
+                             "kv_cache_bit_width is not 0.");
+    }
+  }
+
   AllocatorPtr allocator;
   ORT_RETURN_IF_ERROR(context->GetTempSpaceAllocator(&allocator));
 
@@ -213,6 +247,13 @@ Status GroupQueryAttention<T>::Compute(OpKernelContext* context) const {
 
   const T* head_sink_data = (head_sink != nullptr) ? head_sink->Data<T>() : nullptr;
 
+  if (is_kv_cache_quantized) {
+    return ApplyQuantizedKvCacheAttention(q_rotary, packed_qkv ? nullptr : k_rotary,
+                                          packed_qkv ? nullptr : V.Get<Tensor>().Data<T>(), head_sink_data,
+                                          past_key, past_value, past_key_scale, past_value_scale, output, present_k,
+                                          present_v, present_k_scale, present_v_scale, seqlens_k, parameters, context);
+  }
+
   // Compute the attention score and apply the score to V
   return ApplyAttention(q_rotary, packed_qkv ? nullptr : k_rotary, packed_qkv ? nullptr : V.Get<Tensor>().Data<T>(),
                         head_sink_data, attention_bias, past_key, past_value, output, present_k, present_v,
@@ -393,6 +393,68 @@ Status CheckCustomAttentionInputs(const T* position_ids,
   return Status::OK();
 }
 
+// Checks that the scales of a quantized past key or value have shape (batch_size, kv_num_heads, past_sequence_length).
+template <typename T = Tensor>
+Status CheckKvCacheScale(const T* scale, const char* name, int batch_size, int kv_num_heads,
+                         int past_sequence_length) {
+  if (scale == nullptr) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT, "Input '", name,
+                           "' is required with a quantized past key and value.");
+  }
+
+  const auto& scale_dims = scale->Shape().GetDims();
+  if (scale_dims.size() != 3 || scale_dims[0] != batch_size || scale_dims[1] != kv_num_heads ||
+      scale_dims[2] != past_sequence_length) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT, "Input '", name,
+                           "' shall have shape (batch_size, kv_num_heads, past_sequence_length) = (", batch_size,
+                           ", ", kv_num_heads, ", ", past_sequence_length, "), got ", scale->Shape());
+  }
+
+  return Status::OK();
+}
+
+// Checks the quantized past key and value, which CheckInputs shall be given as absent, and their scales. Updates the
+// past and present sequence lengths of the parameters.
+template <typename T = Tensor>
+Status CheckQuantizedKvCache(const T* past_key,
+                             const T* past_value,
+                             const T* past_key_scale,
+                             const T* past_value_scale,
+                             int kv_cache_bit_width,
+                             GroupQueryAttentionParameters& parameters) {
+  if (kv_cache_bit_width != 4 && kv_cache_bit_width != 8) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "kv_cache_bit_width shall be 0, 4 or 8, got ", kv_cache_bit_width);
+  }
+
+  if (kv_cache_bit_width == 4 && parameters.head_size % 2 != 0) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "head_size shall be even when kv_cache_bit_width is 4, got ", parameters.head_size);
+  }
+
+  if (past_key != nullptr && past_value != nullptr) {
+    // the last dimension of the past key and value is the number of bytes of a quantized head
+    const int head_bytes = parameters.head_size * kv_cache_bit_width / 8;
+    int past_sequence_length = 0;
+    ORT_RETURN_IF_ERROR(CheckPast(past_key, past_value, parameters.batch_size, parameters.kv_num_heads, head_bytes,
+                                  past_sequence_length));
+    ORT_RETURN_IF_ERROR(CheckKvCacheScale(past_key_scale, "past_key_scale", parameters.batch_size,
+                                          parameters.kv_num_heads, past_sequence_length));
+    ORT_RETURN_IF_ERROR(CheckKvCacheScale(past_value_scale, "past_value_scale", parameters.batch_size,
+                                          parameters.kv_num_heads, past_sequence_length));
+    parameters.seqlen_past_kv_cache = past_sequence_length;
+    parameters.seqlen_present_kv_cache = std::max(parameters.total_sequence_length, past_sequence_length);
+  } else if (past_key != nullptr || past_value != nullptr) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'past_key' and 'past_value' shall be both present or both absent.");
+  } else if (past_key_scale != nullptr || past_value_scale != nullptr) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "Input 'past_key_scale' and 'past_value_scale' shall be absent without past key and value.");
+  }
+
+  return Status::OK();
+}
+
 template <typename T = Tensor>
 Status CheckOutputs(const T* output_qk, int qk_output) {
   const bool is_valid_qk_output = qk_output == static_cast<int>(QKOutputType::NO_OUTPUT) ||
@@ -0,0 +1,172 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "contrib_ops/cpu/bert/paged_attention.h"
+#include "contrib_ops/cpu/bert/paged_attention_helper.h"
+#include "contrib_ops/cpu/bert/rotary_embedding.h"
+#include "contrib_ops/cpu/bert/rotary_embedding_helper.h"
+
+#include "core/common/safeint.h"
+#include "core/platform/threadpool.h"
+
+#include <vector>
+
+using onnxruntime::concurrency::ThreadPool;
+
+namespace onnxruntime {
+namespace contrib {
+
+// These ops are internal-only, so register outside of onnx
+#define REGISTER_KERNEL_TYPED(T)                                        \
+  ONNX_OPERATOR_TYPED_KERNEL_EX(                                        \
+      PagedAttention,                                                   \
+      kMSDomain,                                                        \
+      1,                                                                \
+      T,                                                                \
+      kCpuExecutionProvider,                                            \
+      KernelDefBuilder()                                                \
+          .TypeConstraint("T", DataTypeImpl::GetTensorType<T>())        \
+          .TypeConstraint("S", DataTypeImpl::GetTensorType<int32_t>())  \
+          .MayInplace(3, 1)                                             \
+          .MayInplace(4, 2),                                            \
+      PagedAttention<T>);
+
+REGISTER_KERNEL_TYPED(float)
+REGISTER_KERNEL_TYPED(MLFloat16)
+
+template <typename T>
+PagedAttention<T>::PagedAttention(const OpKernelInfo& info)
+    : OpKernel(info), GQAAttentionBase(info, true) {
+  ORT_ENFORCE(num_heads_ % kv_num_heads_ == 0, "num_heads must be a multiple of kv_num_heads");
+}
+
+template <typename T>
+Status PagedAttention<T>::Compute(OpKernelContext* context) const {
+  const Tensor* query = context->Input<Tensor>(0);
+  const Tensor* key = context->Input<Tensor>(1);
+  const Tensor* value = context->Input<Tensor>(2);
+  const Tensor* key_cache = context->Input<Tensor>(3);
+  const Tensor* value_cache = context->Input<Tensor>(4);
+  const Tensor* cumulative_seqlens_q = context->Input<Tensor>(5);
+  const Tensor* past_seqlens = context->Input<Tensor>(6);
+  const Tensor* block_table = context->Input<Tensor>(7);
+  const Tensor* cos_cache = context->Input<Tensor>(8);
+  const Tensor* sin_cache = context->Input<Tensor>(9);
+
+  PagedAttentionParameters parameters = {};
+  ORT_RETURN_IF_ERROR(paged_attention_helper::CheckInputs(query,
+                                                          key,
+                                                          value,
+                                                          key_cache,
+                                                          value_cache,
+                                                          cumulative_seqlens_q,
+                                                          past_seqlens,
+                                                          block_table,
+                                                          cos_cache,
+                                                          sin_cache,
+                                                          &parameters,
+                                                          num_heads_,
+                                                          kv_num_heads_,
+                                                          scale_,
+                                                          softcap_,
+                                                          0));
+  parameters.local_window_size = local_window_size_;
+  parameters.do_rotary = do_rotary_;
+  parameters.rotary_interleaved = rotary_interleaved_;
+
+  const int32_t* cumulative_seqlens_data = cumulative_seqlens_q->Data<int32_t>();
+  const int32_t* past_seqlens_data = past_seqlens->Data<int32_t>();
+  const int32_t* block_table_data = block_table->Data<int32_t>();
+  ORT_RETURN_IF_ERROR(paged_attention_helper::CheckSequenceLengthsAndBlockTable(cumulative_seqlens_data,
+                                                                                past_seqlens_data,
+                                                                                block_table_data,
+                                                                                parameters));
+
+  if (do_rotary_ && (cos_cache == nullptr || sin_cache == nullptr)) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "cos_cache and sin_cache must be passed to PagedAttention when do_rotary = 1");
+  }
+
+  const int token_count = parameters.token_count;
+  const int head_size = parameters.head_size;
+  const bool packed_qkv = parameters.is_packed_qkv;
+
+  TensorShapeVector output_shape{static_cast<int64_t>(token_count), static_cast<int64_t>(parameters.hidden_size)};
+  Tensor* output = context->Output(0, output_shape);
+  Tensor* key_cache_out = context->Output(1, key_cache->Shape());
+  Tensor* value_cache_out = context->Output(2, value_cache->Shape());
+
+  // The cache is updated in place. When the outputs were not given the buffers of the inputs, the caches are copied
+  // to them first, which costs a pass over the whole cache, so callers should bind them to the same buffers.
+  T* key_cache_data = const_cast<T*>(key_cache->Data<T>());
+  T* value_cache_data = const_cast<T*>(value_cache->Data<T>());
+  if (key_cache_out != nullptr && key_cache_out->MutableData<T>() != key_cache_data) {
+    std::memcpy(key_cache_out->MutableDataRaw(), key_cache_data, key_cache->SizeInBytes());
+    key_cache_data = key_cache_out->MutableData<T>();
+  }
+  if (value_cache_out != nullptr && value_cache_out->MutableData<T>() != value_cache_data) {
+    std::memcpy(value_cache_out->MutableDataRaw(), value_cache_data, value_cache->SizeInBytes());
+    value_cache_data = value_cache_out->MutableData<T>();
+  }
+
+  AllocatorPtr allocator;
+  ORT_RETURN_IF_ERROR(context->GetTempSpaceAllocator(&allocator));
+
+  const size_t q_row_stride = packed_qkv ? SafeInt<size_t>(num_heads_ + 2 * kv_num_heads_) * head_size
+                                         : static_cast<size_t>(parameters.hidden_size);
+  const size_t kv_row_stride = packed_qkv ? q_row_stride : static_cast<size_t>(parameters.kv_hidden_size);
+  const T* q = query->Data<T>();
+  const T* k = packed_qkv ? q + num_heads_ * head_size : key->Data<T>();
+  const T* v = packed_qkv ? q + (num_heads_ + kv_num_heads_) * head_size : value->Data<T>();
+
+  IAllocatorUniquePtr<T> rotary_q;
+  IAllocatorUniquePtr<T> rotary_k;
+  if (do_rotary_) {
+    auto* tp = context->GetOperatorThreadPool();
+
+    // The tokens of the sequences are packed, so they are rotated as a batch of one sequence with the position of
+    // every token in its own sequence.
+    std::vector<int64_t> position_ids(token_count);
+    for (int b = 0; b < parameters.batch_size; b++) {
+      for (int t = cumulative_seqlens_data[b]; t < cumulative_seqlens_data[b + 1]; t++) {
+        position_ids[t] = static_cast<int64_t>(past_seqlens_data[b]) + (t - cumulative_seqlens_data[b]);
+      }
+    }
+
+    rotary_embedding_helper::RotaryParameters rotary_params = {};
+    rotary_params.batch_size = 1;
+    rotary_params.sequence_length = token_count;
+    rotary_params.hidden_size = parameters.hidden_size;
+    rotary_params.head_size = head_size;
+    rotary_params.rotary_embedding_dim = parameters.rotary_dim;
+    rotary_params.num_heads = num_heads_;
+    rotary_params.max_sequence_length = token_count;  // unused
+    rotary_params.seq_stride = static_cast<int>(q_row_stride);
+    rotary_params.head_stride = head_size;
+    rotary_params.batch_stride = 0;
+    rotary_params.position_ids_format = 1;
+    rotary_params.transposed = false;
+
+    // Only the rotated heads are read from the buffers, so they keep the row strides of the inputs.
+    rotary_q = IAllocator::MakeUniquePtr<T>(allocator, SafeInt<size_t>(token_count) * q_row_stride);
+    ORT_RETURN_IF_ERROR(RunRotaryEmbedding<T>(tp, rotary_params, q, position_ids.data(), cos_cache->Data<T>(),
+                                              sin_cache->Data<T>(), rotary_q.get(), rotary_interleaved_));
+
+    rotary_params.num_heads = kv_num_heads_;
+    rotary_params.hidden_size = parameters.kv_hidden_size;
+    rotary_params.seq_stride = static_cast<int>(kv_row_stride);
+    rotary_k = IAllocator::MakeUniquePtr<T>(allocator, SafeInt<size_t>(token_count) * kv_row_stride);
+    ORT_RETURN_IF_ERROR(RunRotaryEmbedding<T>(tp, rotary_params, k, position_ids.data(), cos_cache->Data<T>(),
+                                              sin_cache->Data<T>(), rotary_k.get(), rotary_interleaved_));
+    q = rotary_q.get();
+    k = rotary_k.get();
+  }
+
+  // Compute the attention score and apply the score to V
+  return ApplyPagedAttention(q, k, v, q_row_stride, kv_row_stride, cumulative_seqlens_data, past_seqlens_data,
+                             block_table_data, key_cache_data, value_cache_data, output->MutableData<T>(), parameters,
+                             allocator, context);
+}
+
+}  // namespace contrib
+}  // namespace onnxruntime
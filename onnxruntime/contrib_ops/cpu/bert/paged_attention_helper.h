@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <algorithm>
+
 #include "core/common/common.h"
 #include "core/providers/common.h"
 #include "contrib_ops/cpu/bert/attention_common.h"
@@ -106,11 +108,9 @@ Status CheckKVCache(const T* key_cache, const T* value_cache, const int kv_num_h
 
   num_blocks = static_cast<int>(key_cache_dims[0]);
   block_size = static_cast<int>(key_cache_dims[1]);
-  // TODO(aciddelgado): block size multiple of 8
-  if (block_size % 256 != 0) {
+  if (block_size <= 0) {
     return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
-                           "block_size must be a multiple of 256. Got block_size % 256 == ",
-                           block_size % 256);
+                           "block_size must be positive. Got ", block_size);
   }
   if (value_cache_dims[0] != num_blocks) {
     return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
@@ -166,7 +166,7 @@ Status CheckSequenceLengthTensors(const T* cumulative_sequence_length, const T*
   batch_size = static_cast<int>(cumulative_seqlen_dim[0]) - 1;
 
   const auto& seqlens_dim = seqlens->Shape().GetDims();
-  if (seqlens_dim.size() != 1 && seqlens_dim[0] != batch_size) {
+  if (seqlens_dim.size() != 1 || seqlens_dim[0] != batch_size) {
     return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
                            "seqlens must be shape (batch_size).");
   }
@@ -273,6 +273,57 @@ Status CheckInputs(const T* query,
   return Status::OK();
 }
 
+// Checks the values of the sequence lengths and the block table, so it can only be used when they are on the CPU.
+// The blocks of every sequence must hold its past and new tokens and be in the cache. Sets the total sequence length
+// of the parameters to the longest one of the batch.
+inline Status CheckSequenceLengthsAndBlockTable(const int32_t* cumulative_sequence_length,
+                                                const int32_t* past_seqlens,
+                                                const int32_t* block_table,
+                                                PagedAttentionParameters& parameters) {
+  if (cumulative_sequence_length[0] != 0 ||
+      cumulative_sequence_length[parameters.batch_size] != parameters.token_count) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "cumulative_sequence_length shall start with 0 and end with the token count ",
+                           parameters.token_count);
+  }
+
+  const int64_t max_seqlen = static_cast<int64_t>(parameters.max_num_blocks_per_seq) * parameters.block_size;
+  int max_total_seqlen = 0;
+  for (int b = 0; b < parameters.batch_size; ++b) {
+    const int32_t new_seqlen = cumulative_sequence_length[b + 1] - cumulative_sequence_length[b];
+    if (new_seqlen < 0) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                             "cumulative_sequence_length shall be non-decreasing. Got ", new_seqlen,
+                             " tokens for sequence ", b);
+    }
+    if (past_seqlens[b] < 0) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                             "past_seqlens shall be non-negative. Got ", past_seqlens[b], " for sequence ", b);
+    }
+
+    const int64_t total_seqlen = static_cast<int64_t>(past_seqlens[b]) + new_seqlen;
+    if (total_seqlen > max_seqlen) {
+      return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                             "The block table holds ", max_seqlen, " tokens per sequence, but sequence ", b, " has ",
+                             total_seqlen);
+    }
+    max_total_seqlen = std::max(max_total_seqlen, static_cast<int>(total_seqlen));
+
+    const int64_t num_used_blocks = (total_seqlen + parameters.block_size - 1) / parameters.block_size;
+    const int32_t* blocks = block_table + static_cast<ptrdiff_t>(b) * parameters.max_num_blocks_per_seq;
+    for (int64_t i = 0; i < num_used_blocks; ++i) {
+      if (blocks[i] < 0 || blocks[i] >= parameters.num_blocks) {
+        return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                               "block_table of sequence ", b, " refers to block ", blocks[i], " out of ",
+                               parameters.num_blocks, " blocks in the KV cache");
+      }
+    }
+  }
+
+  parameters.total_sequence_length = max_total_seqlen;
+  return Status::OK();
+}
+
 }  // namespace paged_attention_helper
 }  // namespace contrib
 }  // namespace onnxruntime
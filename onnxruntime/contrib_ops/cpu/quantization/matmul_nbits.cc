@@ -30,7 +30,9 @@ constexpr size_t A = 0,
                  scales = 2,
                  zero_points = 3,
                  g_idx = 4,
-                 bias = 5;
+                 bias = 5,
+                 multiplier = 6,
+                 residual = 7;
 };
 
 typedef enum {
@@ -74,6 +76,24 @@ GetComputeType<MLFloat16>(size_t nbits, size_t block_size, int64_t accuracy_leve
 }
 #endif  // !MLAS_F16VEC_INTRINSICS_SUPPORTED || !MLAS_TARGET_ARM64
 
+MLAS_QNBIT_GEMM_EPILOGUE_ACTIVATION GetEpilogueActivation(const std::string& activation) {
+  if (activation.empty()) {
+    return MlasQNBitGemmEpilogueIdentity;
+  } else if (activation == "Relu") {
+    return MlasQNBitGemmEpilogueRelu;
+  } else if (activation == "Sigmoid") {
+    return MlasQNBitGemmEpilogueSigmoid;
+  } else if (activation == "Gelu") {
+    return MlasQNBitGemmEpilogueGelu;
+  } else if (activation == "FastGelu") {
+    return MlasQNBitGemmEpilogueFastGelu;
+  } else if (activation == "QuickGelu") {
+    return MlasQNBitGemmEpilogueQuickGelu;
+  }
+
+  ORT_THROW("Unsupported activation for MatMulNBits: ", activation);
+}
+
 }  // namespace
 
 bool GetType(const NodeArg& node_arg, int32_t& type) {
@@ -100,7 +120,9 @@ class MatMulNBits final : public OpKernel {
         nbits_{narrow<size_t>(info.GetAttr<int64_t>("bits"))},
         has_g_idx_{info.GetInputCount() > InputIndex::g_idx && info.node().InputDefs()[InputIndex::g_idx]->Exists()},
         has_bias_{info.GetInputCount() > InputIndex::bias && info.node().InputDefs()[InputIndex::bias]->Exists()},
-        compute_type_{GetComputeType<T1>(nbits_, block_size_, info.GetAttr<int64_t>("accuracy_level"))} {
+        compute_type_{GetComputeType<T1>(nbits_, block_size_, info.GetAttr<int64_t>("accuracy_level"))},
+        activation_{GetEpilogueActivation(info.GetAttrOrDefault<std::string>("activation", ""))},
+        activation_alpha_{info.GetAttrOrDefault<float>("activation_alpha", 1.702f)} {
     const auto& node = info.node();
     auto input_defs = node.InputDefs();
     const NodeArg* zero_point_arg =
@@ -116,6 +138,12 @@ class MatMulNBits final : public OpKernel {
                 "Only 4b and 8b quantization is supported for MatMulNBits op, additional bits support is planned.");
     const Tensor* tensor_zero_point = nullptr;
     has_zp_input_ = info.TryGetConstantInput(InputIndex::zero_points, &tensor_zero_point);
+
+    has_epilogue_ = activation_ != MlasQNBitGemmEpilogueIdentity ||
+                    (info.GetInputCount() > InputIndex::multiplier && input_defs[InputIndex::multiplier]->Exists()) ||
+                    (info.GetInputCount() > InputIndex::residual && input_defs[InputIndex::residual]->Exists());
+    ORT_ENFORCE(!has_epilogue_ || std::is_same_v<T1, float>,
+                "The activation, multiplier and residual of MatMulNBits are only supported for float input.");
   }
 
   Status Compute(OpKernelContext* context) const override;
@@ -136,6 +164,9 @@ class MatMulNBits final : public OpKernel {
   const bool has_bias_;
   bool scales_are_packed_{false};
   const MLAS_QNBIT_GEMM_COMPUTE_TYPE compute_type_;
+  const MLAS_QNBIT_GEMM_EPILOGUE_ACTIVATION activation_;
+  const float activation_alpha_;
+  bool has_epilogue_{false};
   bool has_unquantized_zero_point_{false};
   const bool column_wise_quant_{true};
   IAllocatorUniquePtr<void> packed_b_{};
@@ -155,7 +186,8 @@ class MatMulNBits final : public OpKernel {
                           Tensor* y,
                           AllocatorPtr& allocator,
                           concurrency::ThreadPool* thread_pool,
-                          const MatMulComputeHelper& helper) const {
+                          const MatMulComputeHelper& helper,
+                          MLAS_QNBIT_GEMM_EPILOGUE* epilogues) const {
     ORT_THROW("ComputeBUnpacked is not supported for T1 type.");
   }
 
@@ -166,7 +198,8 @@ class MatMulNBits final : public OpKernel {
                         Tensor* y,
                         AllocatorPtr& allocator,
                         concurrency::ThreadPool* thread_pool,
-                        const MatMulComputeHelper& helper) const;
+                        const MatMulComputeHelper& helper,
+                        MLAS_QNBIT_GEMM_EPILOGUE* epilogues) const;
 };
 
 template <typename T1>
@@ -309,7 +342,8 @@ Status MatMulNBits<T1>::ComputeBPacked(const Tensor* a,
                                        Tensor* y,
                                        AllocatorPtr& allocator,
                                        concurrency::ThreadPool* thread_pool,
-                                       const MatMulComputeHelper& helper) const {
+                                       const MatMulComputeHelper& helper,
+                                       MLAS_QNBIT_GEMM_EPILOGUE* epilogues) const {
   const auto* a_data = a->Data<T1>();
   const auto* scales_data = scales == nullptr ? nullptr : scales->Data<T1>();
   const auto* zero_points_data = zero_points == nullptr ? nullptr : zero_points->DataRaw();
@@ -343,6 +377,9 @@ Status MatMulNBits<T1>::ComputeBPacked(const Tensor* a,
     data[i].Bias = bias_data;
     data[i].C = y_data + helper.OutputOffsets()[i];
     data[i].ldc = N;
+    if constexpr (std::is_same_v<T1, float>) {
+      data[i].PostProcessor = epilogues == nullptr ? nullptr : &epilogues[i];
+    }
   }
   MlasQNBitGemmBatch(M, N, K, batch_count, nbits_, block_size_, compute_type_, data.data(), workspace.get(),
                      thread_pool);
@@ -358,7 +395,9 @@ Status MatMulNBits<MLFloat16>::ComputeBPacked(const Tensor* a,
                                               Tensor* y,
                                               AllocatorPtr& allocator,
                                               concurrency::ThreadPool* thread_pool,
-                                              const MatMulComputeHelper& helper) const {
+                                              const MatMulComputeHelper& helper,
+                                              MLAS_QNBIT_GEMM_EPILOGUE* epilogues) const {
+  ORT_UNUSED_PARAMETER(epilogues);
   const auto* a_data = a->Data<MLFloat16>();
   const auto* scales_data = scales->Data<MLFloat16>();
   const auto* zero_points_data = zero_points == nullptr ? nullptr : zero_points->DataRaw();
@@ -439,7 +478,8 @@ Status MatMulNBits<float>::ComputeBUnpacked(const Tensor* a,
                                             Tensor* y,
                                             AllocatorPtr& allocator,
                                             concurrency::ThreadPool* thread_pool,
-                                            const MatMulComputeHelper& helper) const {
+                                            const MatMulComputeHelper& helper,
+                                            MLAS_QNBIT_GEMM_EPILOGUE* epilogues) const {
   const auto* a_data = a->Data<float>();
   const uint8_t* b_data = b->Data<uint8_t>();
   const auto* scales_data = scales->Data<float>();
@@ -552,6 +592,19 @@ Status MatMulNBits<float>::ComputeBUnpacked(const Tensor* a,
   MlasGemmBatch(CblasNoTrans, CblasTrans,
                 M, N, K, data.data(), batch_count, thread_pool);
 
+  if (epilogues != nullptr) {
+    concurrency::ThreadPool::TryParallelFor(
+        thread_pool, static_cast<std::ptrdiff_t>(batch_count * M),
+        TensorOpCost{static_cast<double>(N) * sizeof(float), static_cast<double>(N) * sizeof(float),
+                     static_cast<double>(N) * 8},
+        [&](std::ptrdiff_t begin, std::ptrdiff_t end) {
+          for (std::ptrdiff_t row = begin; row < end; row++) {
+            const size_t i = static_cast<size_t>(row) / M;
+            epilogues[i].Process(data[i].C, static_cast<size_t>(row) % M, 0, 1, N, N);
+          }
+        });
+  }
+
   return Status::OK();
 }
 
@@ -565,7 +618,9 @@ Status MatMulNBits<MLFloat16>::ComputeBUnpacked(const Tensor* a,
                                                 Tensor* y,
                                                 AllocatorPtr& allocator,
                                                 concurrency::ThreadPool* thread_pool,
-                                                const MatMulComputeHelper& helper) const {
+                                                const MatMulComputeHelper& helper,
+                                                MLAS_QNBIT_GEMM_EPILOGUE* epilogues) const {
+  ORT_UNUSED_PARAMETER(epilogues);
   const auto* a_data = a->Data<MLFloat16>();
   const uint8_t* b_data = b->Data<uint8_t>();
   const auto* scales_data = scales->Data<MLFloat16>();
@@ -718,6 +773,8 @@ Status MatMulNBits<T1>::Compute(OpKernelContext* ctx) const {
   const Tensor* zero_points = ctx->Input<Tensor>(InputIndex::zero_points);
   const Tensor* reorder_idx = ctx->Input<Tensor>(InputIndex::g_idx);
   const Tensor* bias = ctx->Input<Tensor>(InputIndex::bias);
+  const Tensor* multiplier = ctx->Input<Tensor>(InputIndex::multiplier);
+  const Tensor* residual = ctx->Input<Tensor>(InputIndex::residual);
 
   ORT_RETURN_IF_ERROR(matmul_nbits_helper::CheckInputs<Tensor>(
       a, b, scales, zero_points, reorder_idx, bias, N_, K_, block_size_, nbits_));
@@ -733,6 +790,25 @@ Status MatMulNBits<T1>::Compute(OpKernelContext* ctx) const {
     return Status::OK();
   }
 
+  ORT_RETURN_IF(multiplier != nullptr && multiplier->Shape() != y->Shape(),
+                "Input 'multiplier' is expected to have the shape of the output ", y->Shape(),
+                ", got ", multiplier->Shape());
+  ORT_RETURN_IF(residual != nullptr && residual->Shape() != y->Shape(),
+                "Input 'residual' is expected to have the shape of the output ", y->Shape(),
+                ", got ", residual->Shape());
+
+  // The activation, multiplier and residual are applied by the epilogue of each batch while its tiles are in cache.
+  InlinedVector<MLAS_QNBIT_GEMM_EPILOGUE> epilogues;
+  if (has_epilogue_) {
+    const size_t N = static_cast<size_t>(helper.N());
+    for (size_t offset : helper.OutputOffsets()) {
+      epilogues.emplace_back(activation_, activation_alpha_,
+                             multiplier == nullptr ? nullptr : multiplier->Data<float>() + offset, N,
+                             residual == nullptr ? nullptr : residual->Data<float>() + offset, N);
+    }
+  }
+  MLAS_QNBIT_GEMM_EPILOGUE* epilogues_data = epilogues.empty() ? nullptr : epilogues.data();
+
   AllocatorPtr allocator;
   ORT_RETURN_IF_ERROR(ctx->GetTempSpaceAllocator(&allocator));
 
@@ -749,7 +825,7 @@ Status MatMulNBits<T1>::Compute(OpKernelContext* ctx) const {
                     // MlasQNBitGemmPackQuantBDataSize() returns 0, we can consider calling MlasQNBitGemmBatch()
                     // with B directly too.
     if (MlasIsQNBitGemmAvailable(nbits_, block_size_, compute_type_)) {
-      return ComputeBPacked(a, scales, zero_points, bias, y, allocator, thread_pool, helper);
+      return ComputeBPacked(a, scales, zero_points, bias, y, allocator, thread_pool, helper, epilogues_data);
     }
   }
 
@@ -760,7 +836,8 @@ Status MatMulNBits<T1>::Compute(OpKernelContext* ctx) const {
                                "This is because MLAS doesn't have an optimized quantized kernel "
                                "for the requested compute configuration.";
 
-  return ComputeBUnpacked(a, b, scales, zero_points, reorder_idx, bias, y, allocator, thread_pool, helper);
+  return ComputeBUnpacked(a, b, scales, zero_points, reorder_idx, bias, y, allocator, thread_pool, helper,
+                          epilogues_data);
 }
 
 #define REGISTER_MatMulNBits(T1)                                         \
@@ -0,0 +1,563 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "contrib_ops/cpu/quantization/moe_quantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+#include "core/common/inlined_containers.h"
+#include "core/common/safeint.h"
+#include "core/mlas/inc/mlas.h"
+#include "core/platform/threadpool.h"
+
+namespace onnxruntime {
+namespace contrib {
+
+namespace {
+
+// QMoE op input indices.
+// These should match the inputs names specified in the op schema.
+namespace InputIndex {
+constexpr int input = 0,
+              router_probs = 1,
+              fc1_experts_weights = 2,
+              fc1_scales = 3,
+              fc1_experts_bias = 4,
+              fc2_experts_weights = 5,
+              fc2_scales = 6,
+              fc2_experts_bias = 7,
+              fc3_experts_weights = 8,
+              fc3_scales = 9,
+              fc3_experts_bias = 10;
+};
+
+// The 4-bit expert weights are packed for the blockwise MLAS GEMM with one scale per column, replicated to
+// every block of the column.
+constexpr size_t kBlkLen = 32;
+constexpr MLAS_QNBIT_GEMM_COMPUTE_TYPE kComputeType = SQNBIT_CompFp32;
+
+Status CheckExpertWeightsShape(const char* name, const TensorShape& shape, int64_t num_experts, int64_t rows,
+                               int64_t cols, int64_t pack_size) {
+  if (shape.NumDimensions() != 3) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT, name, " must be 3D, got ", shape.NumDimensions());
+  }
+  if (shape[0] != num_experts) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT, name, "[0] must be equal to num_experts, got ", shape[0],
+                           " and ", num_experts);
+  }
+  if (shape[1] != rows || shape[2] * pack_size != cols) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT, name, " has shape ", shape, ", expected {", num_experts,
+                           ",", rows, ",", cols / pack_size, "}");
+  }
+  return Status::OK();
+}
+
+Status CheckExpertBiasShape(const char* name, const Tensor* bias, int64_t num_experts, int64_t cols) {
+  if (bias != nullptr && bias->Shape() != TensorShape({num_experts, cols})) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT, name, " has shape ", bias->Shape(), ", expected {",
+                           num_experts, ",", cols, "}");
+  }
+  return Status::OK();
+}
+
+// Selects the top k experts of a row from the softmax of the router logits. The expert with the lower index
+// wins a tie.
+void RouteSoftmaxTopK(const float* logits, size_t num_experts, size_t k, bool normalize_routing_weights,
+                      int* experts, float* weights, float* probs) {
+  const float max_logit = *std::max_element(logits, logits + num_experts);
+  float sum = 0.0f;
+  for (size_t e = 0; e < num_experts; e++) {
+    probs[e] = std::exp(logits[e] - max_logit);
+    sum += probs[e];
+  }
+
+  float selected_sum = 0.0f;
+  for (size_t j = 0; j < k; j++) {
+    const size_t e = static_cast<size_t>(std::max_element(probs, probs + num_experts) - probs);
+    experts[j] = static_cast<int>(e);
+    weights[j] = probs[e] / sum;
+    selected_sum += weights[j];
+    probs[e] = -1.0f;
+  }
+
+  if (normalize_routing_weights) {
+    for (size_t j = 0; j < k; j++) {
+      weights[j] /= selected_sum;
+    }
+  }
+}
+
+// Selects the top 2 experts of a row with the sparse mixer: each expert is selected by its logit, and is
+// weighted by the softmax over the experts with a logit close to it.
+void RouteSparseMixer(const float* logits, size_t num_experts, int* experts, float* weights) {
+  constexpr float jitter_eps = 0.01f;
+
+  int first = -1;
+  for (size_t j = 0; j < 2; j++) {
+    size_t selected = 0;
+    float max_logit = -std::numeric_limits<float>::infinity();
+    for (size_t e = 0; e < num_experts; e++) {
+      if (static_cast<int>(e) != first && logits[e] > max_logit) {
+        max_logit = logits[e];
+        selected = e;
+      }
+    }
+
+    float sum = 0.0f;
+    for (size_t e = 0; e < num_experts; e++) {
+      const float factor = std::max(std::abs(logits[e]), max_logit);
+      if (static_cast<int>(e) != first && max_logit - logits[e] <= 2.0f * jitter_eps * factor) {
+        sum += std::exp(logits[e] - max_logit);
+      }
+    }
+
+    experts[j] = static_cast<int>(selected);
+    weights[j] = 1.0f / sum;
+    first = static_cast<int>(selected);
+  }
+}
+
+}  // namespace
+
+ONNX_OPERATOR_TYPED_KERNEL_EX(
+    QMoE,
+    kMSDomain,
+    1,
+    float,
+    kCpuExecutionProvider,
+    KernelDefBuilder()
+        .TypeConstraint("T", DataTypeImpl::GetTensorType<float>())
+        .TypeConstraint("T1", DataTypeImpl::GetTensorType<uint8_t>()),
+    QMoE);
+
+QMoE::QMoE(const OpKernelInfo& op_kernel_info) : OpKernel(op_kernel_info) {
+  ORT_ENFORCE(op_kernel_info.GetAttr<int64_t>("k", &k_).IsOK());
+  ORT_ENFORCE(k_ > 0, "k must be positive, but got ", k_);
+
+  const std::string activation_type = op_kernel_info.GetAttrOrDefault<std::string>("activation_type", "relu");
+  if (activation_type == "relu") {
+    activation_ = MlasQNBitGemmEpilogueRelu;
+  } else if (activation_type == "gelu") {
+    activation_ = MlasQNBitGemmEpilogueFastGelu;
+  } else if (activation_type == "silu") {
+    activation_ = MlasQNBitGemmEpilogueQuickGelu;
+  } else if (activation_type == "identity") {
+    activation_ = MlasQNBitGemmEpilogueIdentity;
+  } else {
+    ORT_THROW("Unsupported MoE activation type: ", activation_type);
+  }
+
+  normalize_routing_weights_ = op_kernel_info.GetAttrOrDefault<int64_t>("normalize_routing_weights", 0) == 1;
+
+  use_sparse_mixer_ = op_kernel_info.GetAttrOrDefault<int64_t>("use_sparse_mixer", 0) == 1;
+  if (use_sparse_mixer_) {
+    ORT_ENFORCE(k_ == 2, "Sparse mixer only supports k=2");
+  }
+
+  expert_weight_bits_ = op_kernel_info.GetAttrOrDefault<int64_t>("expert_weight_bits", 4);
+  ORT_ENFORCE(expert_weight_bits_ == 8 || expert_weight_bits_ == 4,
+              "expert_weight_bits must be 4 or 8, but got ", expert_weight_bits_);
+}
+
+Status QMoE::PrePack(const Tensor& tensor, int input_idx, /*out*/ AllocatorPtr alloc,
+                     /*out*/ bool& is_packed,
+                     /*out*/ PrePackedWeights* prepacked_weights) {
+  ORT_UNUSED_PARAMETER(prepacked_weights);
+  is_packed = false;
+
+  ExpertWeights* packed = nullptr;
+  int scales_idx = 0;
+  if (input_idx == InputIndex::fc1_experts_weights) {
+    packed = &fc1_weights_;
+    scales_idx = InputIndex::fc1_scales;
+  } else if (input_idx == InputIndex::fc2_experts_weights) {
+    packed = &fc2_weights_;
+    scales_idx = InputIndex::fc2_scales;
+  } else if (input_idx == InputIndex::fc3_experts_weights) {
+    packed = &fc3_weights_;
+    scales_idx = InputIndex::fc3_scales;
+  } else {
+    return Status::OK();
+  }
+
+  // The weights are converted in Compute when the scales are not constant.
+  const Tensor* scales = nullptr;
+  if (!OpKernel::Info().TryGetConstantInput(scales_idx, &scales)) {
+    return Status::OK();
+  }
+
+  ORT_RETURN_IF_ERROR(PackExpertWeights(tensor, *scales, alloc, *packed));
+  is_packed = true;
+  return Status::OK();
+}
+
+Status QMoE::PackExpertWeights(const Tensor& weights, const Tensor& scales, AllocatorPtr alloc,
+                               ExpertWeights& packed) const {
+  const auto& dims = weights.Shape().GetDims();
+  ORT_RETURN_IF_NOT(dims.size() == 3, "The expert weights must be 3D, got ", dims.size());
+
+  const size_t pack_size = 8 / static_cast<size_t>(expert_weight_bits_);
+  const size_t num_experts = static_cast<size_t>(dims[0]);
+  const size_t K = static_cast<size_t>(dims[1]);
+  const size_t N = static_cast<size_t>(dims[2]) * pack_size;
+  const size_t row_bytes = static_cast<size_t>(dims[2]);
+  ORT_RETURN_IF_NOT(scales.Shape() == TensorShape({dims[0], static_cast<int64_t>(N)}),
+                    "The expert scales have shape ", scales.Shape(), ", expected {", dims[0], ",", N, "}");
+
+  packed.shape = weights.Shape();
+  packed.K = K;
+  packed.N = N;
+
+  const uint8_t* weights_data = weights.Data<uint8_t>();
+  const float* scales_data = scales.Data<float>();
+
+  if (expert_weight_bits_ == 4 && MlasIsQNBitGemmAvailable(4, kBlkLen, kComputeType)) {
+    // The weights are signed 4-bit values packed along the columns, the lower nibble first. The blockwise
+    // layout holds blocks of unsigned values along the rows of each column, with the default zero point 8.
+    const size_t block_count = (K + kBlkLen - 1) / kBlkLen;
+    const size_t blob_size = kBlkLen / 2;
+
+    packed.packed_size = MlasQNBitGemmPackQuantBDataSize(N, K, 4, kBlkLen, false, kComputeType);
+    packed.packed_data = IAllocator::MakeUniquePtr<void>(alloc, SafeInt<size_t>(num_experts) * packed.packed_size,
+                                                         true);
+    packed.scales = IAllocator::MakeUniquePtr<float>(alloc, SafeInt<size_t>(num_experts) * N * block_count, true);
+
+    std::vector<uint8_t> blockwise(N * block_count * blob_size);
+    for (size_t e = 0; e < num_experts; e++) {
+      std::fill(blockwise.begin(), blockwise.end(), static_cast<uint8_t>(0x88));
+      const uint8_t* expert_weights = weights_data + e * K * row_bytes;
+      for (size_t k = 0; k < K; k++) {
+        const size_t shift = (k & 1) * 4;
+        uint8_t* dst = blockwise.data() + (k / kBlkLen) * blob_size + (k % kBlkLen) / 2;
+        for (size_t n = 0; n < N; n++) {
+          const uint8_t value = (expert_weights[k * row_bytes + n / 2] >> ((n & 1) * 4)) & 0x0F;
+          uint8_t& byte = dst[n * block_count * blob_size];
+          byte = static_cast<uint8_t>((byte & ~(0x0F << shift)) | ((value ^ 0x08) << shift));
+        }
+      }
+
+      float* expert_scales = packed.scales.get() + e * N * block_count;
+      for (size_t n = 0; n < N; n++) {
+        std::fill_n(expert_scales + n * block_count, block_count, scales_data[e * N + n]);
+      }
+
+      MlasQNBitGemmPackQuantBData(N, K, 4, kBlkLen, kComputeType, blockwise.data(),
+                                  static_cast<std::byte*>(packed.packed_data.get()) + e * packed.packed_size,
+                                  nullptr, false, nullptr, nullptr);
+    }
+  } else {
+    packed.dequantized = IAllocator::MakeUniquePtr<float>(alloc, SafeInt<size_t>(num_experts) * K * N, true);
+    float* dequantized = packed.dequantized.get();
+    for (size_t e = 0; e < num_experts; e++) {
+      const uint8_t* expert_weights = weights_data + e * K * row_bytes;
+      const float* expert_scales = scales_data + e * N;
+      for (size_t k = 0; k < K; k++) {
+        for (size_t n = 0; n < N; n++) {
+          int32_t value;
+          if (expert_weight_bits_ == 4) {
+            value = static_cast<int8_t>(expert_weights[k * row_bytes + n / 2] << (4 - (n & 1) * 4)) >> 4;
+          } else {
+            value = static_cast<int8_t>(expert_weights[k * row_bytes + n]);
+          }
+          *dequantized++ = static_cast<float>(value) * expert_scales[n];
+        }
+      }
+    }
+  }
+
+  return Status::OK();
+}
+
+Status QMoE::ExpertGemm(const ExpertWeights& weights, size_t expert, const float* a, size_t m, const float* bias,
+                        float* c, MLAS_QNBIT_GEMM_EPILOGUE* epilogue, AllocatorPtr allocator,
+                        concurrency::ThreadPool* thread_pool) const {
+  const size_t K = weights.K;
+  const size_t N = weights.N;
+
+  if (weights.packed_data != nullptr) {
+    const size_t block_count = (K + kBlkLen - 1) / kBlkLen;
+
+    IAllocatorUniquePtr<std::byte> workspace{};
+    const size_t workspace_size = MlasQNBitGemmBatchWorkspaceSize(m, N, K, 1, 4, kBlkLen, false, kComputeType);
+    if (workspace_size > 0) {
+      workspace = IAllocator::MakeUniquePtr<std::byte>(allocator, workspace_size, true);
+    }
+
+    MLAS_QNBIT_GEMM_DATA_PARAMS<float> data;
+    data.A = a;
+    data.lda = K;
+    data.PackedQuantBData = static_cast<const std::byte*>(weights.packed_data.get()) + expert * weights.packed_size;
+    data.QuantBScale = weights.scales.get() + expert * N * block_count;
+    data.Bias = bias;
+    data.C = c;
+    data.ldc = N;
+    data.PostProcessor = epilogue;
+    MlasQNBitGemmBatch(m, N, K, 1, 4, kBlkLen, kComputeType, &data, workspace.get(), thread_pool);
+    return Status::OK();
+  }
+
+  if (bias != nullptr) {
+    for (size_t i = 0; i < m; i++) {
+      std::copy_n(bias, N, c + i * N);
+    }
+  }
+  MlasGemm(CblasNoTrans, CblasNoTrans, m, N, K, 1.0f, a, K, weights.dequantized.get() + expert * K * N, N,
+           bias != nullptr ? 1.0f : 0.0f, c, N, thread_pool);
+  if (epilogue != nullptr) {
+    epilogue->Process(c, 0, 0, m, N, N);
+  }
+  return Status::OK();
+}
+
+Status QMoE::Compute(OpKernelContext* context) const {
+  const Tensor* input = context->Input<Tensor>(InputIndex::input);
+  const Tensor* router_probs = context->Input<Tensor>(InputIndex::router_probs);
+  const Tensor* fc1_experts_bias = context->Input<Tensor>(InputIndex::fc1_experts_bias);
+  const Tensor* fc2_experts_bias = context->Input<Tensor>(InputIndex::fc2_experts_bias);
+  const Tensor* fc3_experts_bias = context->Input<Tensor>(InputIndex::fc3_experts_bias);
+
+  AllocatorPtr allocator;
+  ORT_RETURN_IF_ERROR(context->GetTempSpaceAllocator(&allocator));
+
+  // Converts the weights that were not prepacked.
+  ExpertWeights converted_weights[3];
+  auto get_weights = [&](const ExpertWeights& prepacked, int weights_idx, ExpertWeights& converted,
+                         const ExpertWeights*& weights) -> Status {
+    weights = &prepacked;
+    if (prepacked.IsInitialized()) {
+      return Status::OK();
+    }
+    weights = nullptr;
+    const Tensor* weights_tensor = context->Input<Tensor>(weights_idx);
+    if (weights_tensor == nullptr) {
+      return Status::OK();
+    }
+    const Tensor* scales = context->Input<Tensor>(weights_idx + 1);
+    ORT_RETURN_IF(scales == nullptr, "The scales of the expert weights of input ", weights_idx, " are missing");
+    ORT_RETURN_IF_ERROR(PackExpertWeights(*weights_tensor, *scales, allocator, converted));
+    weights = &converted;
+    return Status::OK();
+  };
+
+  const ExpertWeights* fc1_weights = nullptr;
+  const ExpertWeights* fc2_weights = nullptr;
+  const ExpertWeights* fc3_weights = nullptr;
+  ORT_RETURN_IF_ERROR(get_weights(fc1_weights_, InputIndex::fc1_experts_weights, converted_weights[0], fc1_weights));
+  ORT_RETURN_IF_ERROR(get_weights(fc2_weights_, InputIndex::fc2_experts_weights, converted_weights[1], fc2_weights));
+  ORT_RETURN_IF_ERROR(get_weights(fc3_weights_, InputIndex::fc3_experts_weights, converted_weights[2], fc3_weights));
+  ORT_RETURN_IF(fc1_weights == nullptr || fc2_weights == nullptr, "fc1 and fc2 expert weights are required");
+
+  const auto& input_dims = input->Shape().GetDims();
+  ORT_RETURN_IF(input_dims.size() != 2 && input_dims.size() != 3, "input must be 2D or 3D, got ",
+                input_dims.size());
+  const int64_t hidden_size = input_dims.back();
+  const int64_t num_rows = input->Shape().SizeToDimension(input_dims.size() - 1);
+
+  const auto& router_probs_dims = router_probs->Shape().GetDims();
+  if (router_probs_dims.size() != 2 || router_probs_dims[0] != num_rows) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT, "router_probs has shape ", router_probs->Shape(),
+                           ", expected {", num_rows, ",num_experts}");
+  }
+  const int64_t num_experts = router_probs_dims[1];
+  ORT_RETURN_IF(k_ > num_experts, "k must not exceed the number of experts, got ", k_, " and ", num_experts);
+
+  // Expert parallelism, where each device holds a subset of the experts, is not supported on CPU.
+  if (fc1_weights->shape.NumDimensions() == 3 && fc1_weights->shape[0] != num_experts) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, NOT_IMPLEMENTED,
+                           "local_num_experts must be equal to num_experts on CPU, got ", fc1_weights->shape[0],
+                           " and ", num_experts);
+  }
+
+  const int64_t pack_size = 8 / expert_weight_bits_;
+  const int64_t inter_size = fc2_weights->shape.NumDimensions() == 3 ? fc2_weights->shape[1] : 0;
+  ORT_RETURN_IF_ERROR(CheckExpertWeightsShape("fc1_experts_weights", fc1_weights->shape, num_experts, hidden_size,
+                                              inter_size, pack_size));
+  ORT_RETURN_IF_ERROR(CheckExpertWeightsShape("fc2_experts_weights", fc2_weights->shape, num_experts, inter_size,
+                                              hidden_size, pack_size));
+  if (fc3_weights != nullptr) {
+    ORT_RETURN_IF_ERROR(CheckExpertWeightsShape("fc3_experts_weights", fc3_weights->shape, num_experts,
+                                                hidden_size, inter_size, pack_size));
+  }
+  ORT_RETURN_IF_ERROR(CheckExpertBiasShape("fc1_experts_bias", fc1_experts_bias, num_experts, inter_size));
+  ORT_RETURN_IF_ERROR(CheckExpertBiasShape("fc2_experts_bias", fc2_experts_bias, num_experts, hidden_size));
+  ORT_RETURN_IF_ERROR(CheckExpertBiasShape("fc3_experts_bias", fc3_experts_bias, num_experts, inter_size));
+
+  Tensor* output = context->Output(0, input->Shape());
+  if (num_rows == 0) {
+    return Status::OK();
+  }
+
+  concurrency::ThreadPool* thread_pool = context->GetOperatorThreadPool();
+
+  const size_t rows = static_cast<size_t>(num_rows);
+  const size_t experts = static_cast<size_t>(num_experts);
+  const size_t k = static_cast<size_t>(k_);
+  const size_t hidden = static_cast<size_t>(hidden_size);
+  const size_t inter = static_cast<size_t>(inter_size);
+  const size_t routed_rows = rows * k;
+
+  const float* input_data = input->Data<float>();
+  const float* router_probs_data = router_probs->Data<float>();
+
+  // Route each row to its top k experts.
+  std::vector<int> routed_experts(routed_rows);
+  std::vector<float> routed_weights(routed_rows);
+  concurrency::ThreadPool::TryParallelFor(
+      thread_pool, num_rows, static_cast<double>(experts * 4),
+      [&](std::ptrdiff_t begin, std::ptrdiff_t end) {
+        std::vector<float> probs(experts);
+        for (std::ptrdiff_t row = begin; row < end; row++) {
+          const float* logits = router_probs_data + row * experts;
+          if (use_sparse_mixer_) {
+            RouteSparseMixer(logits, experts, &routed_experts[row * k], &routed_weights[row * k]);
+          } else {
+            RouteSoftmaxTopK(logits, experts, k, normalize_routing_weights_, &routed_experts[row * k],
+                             &routed_weights[row * k], probs.data());
+          }
+        }
+      });
+
+  // Sort the routed rows by expert, keeping the order of the rows for each expert.
+  std::vector<size_t> expert_offsets(experts + 1, 0);
+  for (int e : routed_experts) {
+    expert_offsets[static_cast<size_t>(e) + 1]++;
+  }
+  std::partial_sum(expert_offsets.begin(), expert_offsets.end(), expert_offsets.begin());
+
+  std::vector<size_t> permuted_positions(routed_rows);
+  std::vector<size_t> source_rows(routed_rows);
+  {
+    std::vector<size_t> next_position(expert_offsets.begin(), expert_offsets.end() - 1);
+    for (size_t i = 0; i < routed_rows; i++) {
+      const size_t position = next_position[static_cast<size_t>(routed_experts[i])]++;
+      permuted_positions[i] = position;
+      source_rows[position] = i / k;
+    }
+  }
+
+  auto permuted_input = IAllocator::MakeUniquePtr<float>(allocator, SafeInt<size_t>(routed_rows) * hidden);
+  auto fc1_output = IAllocator::MakeUniquePtr<float>(allocator, SafeInt<size_t>(routed_rows) * inter);
+  auto fc2_output = IAllocator::MakeUniquePtr<float>(allocator, SafeInt<size_t>(routed_rows) * hidden);
+  IAllocatorUniquePtr<float> fc3_output{};
+  if (fc3_weights != nullptr) {
+    fc3_output = IAllocator::MakeUniquePtr<float>(allocator, SafeInt<size_t>(routed_rows) * inter);
+  }
+
+  concurrency::ThreadPool::TryParallelFor(
+      thread_pool, static_cast<std::ptrdiff_t>(routed_rows), static_cast<double>(hidden),
+      [&](std::ptrdiff_t begin, std::ptrdiff_t end) {
+        for (std::ptrdiff_t i = begin; i < end; i++) {
+          std::memcpy(permuted_input.get() + i * hidden, input_data + source_rows[i] * hidden,
+                      hidden * sizeof(float));
+        }
+      });
+
+  const float* fc1_bias_data = fc1_experts_bias == nullptr ? nullptr : fc1_experts_bias->Data<float>();
+  const float* fc2_bias_data = fc2_experts_bias == nullptr ? nullptr : fc2_experts_bias->Data<float>();
+  const float* fc3_bias_data = fc3_experts_bias == nullptr ? nullptr : fc3_experts_bias->Data<float>();
+
+  auto run_expert = [&](size_t e, concurrency::ThreadPool* expert_thread_pool) -> Status {
+    const size_t offset = expert_offsets[e];
+    const size_t m = expert_offsets[e + 1] - offset;
+    const float* a = permuted_input.get() + offset * hidden;
+    float* fc1_c = fc1_output.get() + offset * inter;
+    float* fc3_c = fc3_output == nullptr ? nullptr : fc3_output.get() + offset * inter;
+
+    if (fc3_c != nullptr) {
+      ORT_RETURN_IF_ERROR(ExpertGemm(*fc3_weights, e, a, m, fc3_bias_data ? fc3_bias_data + e * inter : nullptr,
+                                     fc3_c, nullptr, allocator, expert_thread_pool));
+    }
+
+    // The activation and the gate of fc3 are applied to the tiles of fc1 while they are in cache.
+    MLAS_QNBIT_GEMM_EPILOGUE epilogue(activation_, 1.0f, fc3_c, inter, nullptr, 0);
+    const bool has_epilogue = activation_ != MlasQNBitGemmEpilogueIdentity || fc3_c != nullptr;
+    ORT_RETURN_IF_ERROR(ExpertGemm(*fc1_weights, e, a, m, fc1_bias_data ? fc1_bias_data + e * inter : nullptr,
+                                   fc1_c, has_epilogue ? &epilogue : nullptr, allocator, expert_thread_pool));
+
+    // The bias of fc2 is added with the routing weight when the outputs are gathered.
+    return ExpertGemm(*fc2_weights, e, fc1_c, m, nullptr, fc2_output.get() + offset * hidden, nullptr, allocator,
+                      expert_thread_pool);
+  };
+
+  // Experts with more rows than a thread's share run one at a time on the whole thread pool. The remaining
+  // experts are balanced over the threads by their number of rows, largest first, and each runs on one thread.
+  InlinedVector<size_t> active_experts;
+  for (size_t e = 0; e < experts; e++) {
+    if (expert_offsets[e + 1] > expert_offsets[e]) {
+      active_experts.push_back(e);
+    }
+  }
+  std::stable_sort(active_experts.begin(), active_experts.end(), [&](size_t a, size_t b) {
+    return expert_offsets[a + 1] - expert_offsets[a] > expert_offsets[b + 1] - expert_offsets[b];
+  });
+
+  const size_t thread_count = static_cast<size_t>(concurrency::ThreadPool::DegreeOfParallelism(thread_pool));
+  const size_t thread_share = (routed_rows + thread_count - 1) / thread_count;
+  size_t first_shared = 0;
+  while (first_shared < active_experts.size() &&
+         (thread_count == 1 || active_experts.size() - first_shared < 2 ||
+          expert_offsets[active_experts[first_shared] + 1] - expert_offsets[active_experts[first_shared]] >
+              thread_share)) {
+    ORT_RETURN_IF_ERROR(run_expert(active_experts[first_shared], thread_pool));
+    first_shared++;
+  }
+
+  if (first_shared < active_experts.size()) {
+    const size_t bucket_count = std::min(thread_count, active_experts.size() - first_shared);
+    std::vector<InlinedVector<size_t>> buckets(bucket_count);
+    std::vector<size_t> bucket_rows(bucket_count, 0);
+    for (size_t i = first_shared; i < active_experts.size(); i++) {
+      const size_t e = active_experts[i];
+      const size_t b = static_cast<size_t>(std::min_element(bucket_rows.begin(), bucket_rows.end()) -
+                                           bucket_rows.begin());
+      buckets[b].push_back(e);
+      bucket_rows[b] += expert_offsets[e + 1] - expert_offsets[e];
+    }
+
+    std::vector<Status> statuses(bucket_count);
+    concurrency::ThreadPool::TrySimpleParallelFor(
+        thread_pool, static_cast<std::ptrdiff_t>(bucket_count), [&](std::ptrdiff_t b) {
+          for (size_t e : buckets[b]) {
+            statuses[b] = run_expert(e, nullptr);
+            if (!statuses[b].IsOK()) {
+              break;
+            }
+          }
+        });
+    for (const Status& status : statuses) {
+      ORT_RETURN_IF_ERROR(status);
+    }
+  }
+
+  // Gather the weighted outputs of the experts of each row.
+  float* output_data = output->MutableData<float>();
+  concurrency::ThreadPool::TryParallelFor(
+      thread_pool, num_rows, static_cast<double>(hidden * k * 2),
+      [&](std::ptrdiff_t begin, std::ptrdiff_t end) {
+        for (std::ptrdiff_t row = begin; row < end; row++) {
+          float* out = output_data + row * hidden;
+          std::fill_n(out, hidden, 0.0f);
+          for (size_t j = 0; j < k; j++) {
+            const size_t i = static_cast<size_t>(row) * k + j;
+            const float weight = routed_weights[i];
+            const float* expert_output = fc2_output.get() + permuted_positions[i] * hidden;
+            const float* bias = fc2_bias_data == nullptr
+                                    ? nullptr
+                                    : fc2_bias_data + static_cast<size_t>(routed_experts[i]) * hidden;
+            for (size_t h = 0; h < hidden; h++) {
+              out[h] += weight * (bias == nullptr ? expert_output[h] : expert_output[h] + bias[h]);
+            }
+          }
+        }
+      });
+
+  return Status::OK();
+}
+
+}  // namespace contrib
+}  // namespace onnxruntime
@@ -0,0 +1,62 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "core/common/common.h"
+#include "core/framework/op_kernel.h"
+#include "core/mlas/inc/mlas_qnbit.h"
+
+namespace onnxruntime {
+namespace contrib {
+
+// Mixture of experts with quantized expert weights.
+//
+// The rows of the input are routed to the top k experts, sorted by expert and each expert computes
+// fc2(activation(fc1(x)) [* fc3(x)]) for its rows with one GEMM per layer. The weighted outputs of the
+// experts are then gathered back to the rows.
+class QMoE final : public OpKernel {
+ public:
+  explicit QMoE(const OpKernelInfo& op_kernel_info);
+
+  Status Compute(OpKernelContext* context) const override;
+
+  Status PrePack(const Tensor& tensor, int input_idx, AllocatorPtr alloc,
+                 /*out*/ bool& is_packed,
+                 /*out*/ PrePackedWeights* prepacked_weights) override;
+
+ private:
+  // Weights of one fully connected layer of all the experts, either packed for the n-bit MLAS GEMM along
+  // with the scale of each block, or dequantized to float when the n-bit GEMM is not available.
+  struct ExpertWeights {
+    TensorShape shape{};
+    size_t K{0};
+    size_t N{0};
+    size_t packed_size{0};
+    IAllocatorUniquePtr<void> packed_data{};
+    IAllocatorUniquePtr<float> scales{};
+    IAllocatorUniquePtr<float> dequantized{};
+
+    bool IsInitialized() const { return packed_data != nullptr || dequantized != nullptr; }
+  };
+
+  Status PackExpertWeights(const Tensor& weights, const Tensor& scales, AllocatorPtr alloc,
+                           ExpertWeights& packed) const;
+
+  Status ExpertGemm(const ExpertWeights& weights, size_t expert, const float* a, size_t m, const float* bias,
+                    float* c, MLAS_QNBIT_GEMM_EPILOGUE* epilogue, AllocatorPtr allocator,
+                    concurrency::ThreadPool* thread_pool) const;
+
+  int64_t k_;
+  MLAS_QNBIT_GEMM_EPILOGUE_ACTIVATION activation_;
+  bool normalize_routing_weights_;
+  bool use_sparse_mixer_;
+  int64_t expert_weight_bits_;
+
+  ExpertWeights fc1_weights_;
+  ExpertWeights fc2_weights_;
+  ExpertWeights fc3_weights_;
+};
+
+}  // namespace contrib
+}  // namespace onnxruntime
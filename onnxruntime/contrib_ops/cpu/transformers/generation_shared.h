@@ -200,6 +200,15 @@ struct IGenerationParameters {
   int cross_qk_output_id = -1;
   int no_speech_probs_output_id = -1;
 
+  // Number of sequences decoded together by GreedySearch and Sampling. 0 decodes the whole batch together.
+  int continuous_batch_size = 0;
+
+  // Number of tokens proposed by the draft decoder of GreedySearch and Sampling in each speculative decoding step.
+  int num_draft_tokens = 4;
+
+  // Capacity in bytes of the cache of the past state of prompt prefixes of GreedySearch and Sampling. 0 disables it.
+  int64_t prefix_cache_bytes = 0;
+
   // Parameter for testing slow topk path. It can be updated by the below environment variable.
   bool use_fast_topk = true;
 };
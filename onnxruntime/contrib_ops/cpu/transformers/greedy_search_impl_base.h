@@ -192,6 +192,12 @@ class GreedySearchBase : public GenerateBase {
                            int counter,
                            int eos_token_id);
 
+  // Mark the sequences reaching eos_token_id as finished, and append next tokens to sequences.
+  // The next token of a finished sequence is replaced by pad_token_id.
+  void AppendNextTokens(GreedySearchState<T>& greedy_state,
+                        gsl::span<int32_t> next_tokens,
+                        int eos_token_id);
+
   // Calculate scores from logits, then apply filtering and select next token for each beam.
   Status ProcessLogits(const OrtValue& logits,  // logits output of subgraph
                        GreedySearchState<T>& greedy_state,
@@ -268,6 +274,16 @@ Status GreedySearchBase<T, ParametersT>::GenerateNextToken(
   ORT_RETURN_IF_ERROR(ProcessLogits(logits, greedy_state, sampling_state, this->temp_space_allocator_, counter));
 
   next_tokens = greedy_state.next_tokens;
+  AppendNextTokens(greedy_state, next_tokens, eos_token_id);
+
+  return Status::OK();
+}
+
+template <typename T, typename ParametersT>
+void GreedySearchBase<T, ParametersT>::AppendNextTokens(
+    GreedySearchState<T>& greedy_state,
+    gsl::span<int32_t> next_tokens,
+    int eos_token_id) {
   gsl::span<bool>& eos_meet = greedy_state.eos_meet;
   for (size_t batch_id = 0; batch_id < next_tokens.size(); ++batch_id) {
     if (next_tokens[batch_id] == eos_token_id || eos_meet[batch_id] == true) {
@@ -281,8 +297,6 @@ Status GreedySearchBase<T, ParametersT>::GenerateNextToken(
 #ifdef DEBUG_GENERATION
   greedy_state.sequences.PrintSequences(&cpu_dumper_);
 #endif
-
-  return Status::OK();
 }
 
 }  // namespace transformers
@@ -3,10 +3,16 @@
 
 #pragma once
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
 #include <vector>
 
 #include "core/common/span_utils.h"
+#include "core/platform/threadpool.h"
 #include "contrib_ops/cpu/transformers/greedy_search_impl_base.h"
+#include "contrib_ops/cpu/transformers/prefix_cache.h"
 
 namespace onnxruntime {
 namespace contrib {
@@ -84,7 +90,89 @@ class GreedySearchGpt : public GreedySearchBase<T, ParametersT> {
   Status Execute(const FeedsFetchesManager* init_run_feeds_fetches_manager,
                  const FeedsFetchesManager& feeds_fetches_manager);
 
+  // Use a draft decoder to propose the tokens verified by the decoder (speculative decoding).
+  void SetDraftDecoder(const SessionState* draft_decoder_session_state,
+                       GptSubgraph* draft_gpt_subgraph,
+                       const FeedsFetchesManager* draft_feeds_fetches_manager) {
+    draft_decoder_session_state_ = draft_decoder_session_state;
+    draft_gpt_subgraph_ = draft_gpt_subgraph;
+    draft_feeds_fetches_manager_ = draft_feeds_fetches_manager;
+  }
+
+  // Use a prefix cache to decode prompts from the past state of their longest cached prefix.
+  void SetPrefixCache(PrefixCache* prefix_cache) {
+    prefix_cache_ = prefix_cache;
+  }
+
  private:
+  // Slot of the batch decoded by continuous batching.
+  struct DecodingSlot {
+    // Index of the sequence of input_ids decoded in the slot, or -1 when the slot is idle.
+    int request = -1;
+    // Number of tokens of the sequence without padding.
+    int length = 1;
+    // Number of tokens that the sequence can still generate.
+    int remaining = 0;
+    // Whether the sequence joined the batch since the past state was laid out.
+    bool joined = false;
+    // Present state of the prompt of a sequence that joined the batch.
+    std::vector<OrtValue> prompt_present;
+  };
+
+  // Execute greedy search with continuous batching: at most parameters->continuous_batch_size sequences are
+  // decoded together, and a finished sequence leaves its slot to the next sequence of input_ids between two
+  // decoding steps.
+  Status ExecuteContinuousBatching(const FeedsFetchesManager* init_run_feeds_fetches_manager,
+                                   const FeedsFetchesManager& feeds_fetches_manager);
+
+  // Run the subgraph on the prompt of a sequence joining the batch to get its present state.
+  Status RunPrompt(gsl::span<const int32_t> prompt,
+                   const FeedsFetchesManager* init_run_feeds_fetches_manager,
+                   const FeedsFetchesManager& feeds_fetches_manager,
+                   std::vector<OrtValue>& present);
+
+  // Lay out the past state of the slots for a new past sequence length. The past state of a sequence is
+  // right aligned, and the past state of the sequences that joined the batch is taken from their prompt.
+  Status ResizePastState(const std::vector<DecodingSlot>& slots,
+                         int past_sequence_length,
+                         int new_past_sequence_length,
+                         std::vector<OrtValue>& feeds);
+
+  // Execute greedy search with speculative decoding. In each step, the draft decoder proposes
+  // parameters->num_draft_tokens tokens one by one, and the decoder scores all of them in one run. The proposed
+  // tokens accepted by every sequence are kept, followed by one token chosen by the decoder, and the past state
+  // of both decoders is rolled back to the kept tokens.
+  Status ExecuteSpeculative(const FeedsFetchesManager* init_run_feeds_fetches_manager,
+                            const FeedsFetchesManager& feeds_fetches_manager);
+
+  // Set input_ids, position_ids and attention_mask of feeds to decode tokens of shape (batch_size, count).
+  // The first of these tokens is at index start of the sequences.
+  void SetSpeculativeInputs(gsl::span<const int32_t> tokens,
+                            int count,
+                            int start,
+                            gsl::span<const int32_t> sequence_lengths,
+                            const Tensor& prompt_attention_mask,
+                            std::vector<OrtValue>& feeds);
+
+  // Move the present state in fetches to the past state in feeds, keeping its first past_sequence_length positions.
+  void SetPastState(const GptSubgraph& subgraph,
+                    std::vector<OrtValue>& fetches,
+                    int past_sequence_length,
+                    std::vector<OrtValue>& feeds);
+
+  // Keep the first sequence_length positions of a past or present state.
+  OrtValue TruncateState(const OrtValue& state, int sequence_length);
+
+  // Compute the probabilities softmax(logits / temperature) of a row of logits.
+  static void ComputeProbabilities(const T* logits, float temperature, gsl::span<float> probs);
+
+  // Set the inputs of feeds to decode the prompt of a single sequence after its first prefix_length tokens,
+  // and the past state of feeds to the state of these tokens taken from present.
+  void SetPrefixFeeds(gsl::span<const int32_t> prompt,
+                      int prefix_length,
+                      const std::vector<OrtValue>& present,
+                      std::vector<OrtValue>& feeds);
+
   // Prepare the inputs for first inference of subgraph
   Status CreateInitialFeeds(gsl::span<int32_t>& sequence_lengths,
                             OrtValue& expanded_input_ids,
@@ -105,6 +193,12 @@ class GreedySearchGpt : public GreedySearchBase<T, ParametersT> {
   GptSubgraph* init_run_gpt_subgraph_ = nullptr;
   GptSubgraph& gpt_subgraph_;
 
+  const SessionState* draft_decoder_session_state_ = nullptr;
+  GptSubgraph* draft_gpt_subgraph_ = nullptr;
+  const FeedsFetchesManager* draft_feeds_fetches_manager_ = nullptr;
+
+  PrefixCache* prefix_cache_ = nullptr;
+
   // Device specific functions
   GenerationDeviceHelper::CreateGptInputsFunc create_inputs_func_;
   GenerationDeviceHelper::AddToFeedsFunc add_to_feeds_func_;
@@ -190,6 +284,14 @@ Status GreedySearchGpt<T, ParametersT>::UpdateFeeds(
 template <typename T, typename ParametersT>
 Status GreedySearchGpt<T, ParametersT>::Execute(const FeedsFetchesManager* init_run_feeds_fetches_manager,
                                                 const FeedsFetchesManager& feeds_fetches_manager) {
+  if (draft_gpt_subgraph_ != nullptr) {
+    return ExecuteSpeculative(init_run_feeds_fetches_manager, feeds_fetches_manager);
+  }
+
+  if (this->parameters_->continuous_batch_size > 0) {
+    return ExecuteContinuousBatching(init_run_feeds_fetches_manager, feeds_fetches_manager);
+  }
+
   auto status = Status::OK();
   const ParametersT* parameters = this->parameters_;
 
@@ -254,6 +356,23 @@ Status GreedySearchGpt<T, ParametersT>::Execute(const FeedsFetchesManager* init_
                            parameters->max_length,
                            parameters->sequence_length);
 
+  // A prompt without padding is decoded from the past state of its longest prefix in the prefix cache, and the
+  // past state of the prompt is added to the cache after the first run.
+  bool use_prefix_cache = prefix_cache_ != nullptr && !this->IsCuda() &&
+                          !gpt_subgraph_.past_present_share_buffer_ && parameters->BatchBeamSize() == 1;
+  if (use_prefix_cache) {
+    gsl::span<const int32_t> attention_mask = feeds[2].Get<Tensor>().DataAsSpan<int32_t>();
+    use_prefix_cache = std::all_of(attention_mask.begin(), attention_mask.end(), [](int32_t m) { return m != 0; });
+  }
+  int prefix_length = 0;
+  if (use_prefix_cache) {
+    std::vector<OrtValue> prefix_present;
+    prefix_length = prefix_cache_->Lookup(input_ids, parameters->sequence_length - 1, prefix_present);
+    if (prefix_length > 0) {
+      SetPrefixFeeds(input_ids, prefix_length, prefix_present, feeds);
+    }
+  }
+
 #ifdef DEBUG_GENERATION
   const IConsoleDumper* dumper = this->GetConsoleDumper();
 #endif
@@ -280,9 +399,9 @@ Status GreedySearchGpt<T, ParametersT>::Execute(const FeedsFetchesManager* init_
     dumper->Print("past", feeds[3]);
 #endif
 
-    // For the first iteration use the init_run_decoder subgraph (if present)
+    // For the first iteration use the init_run_decoder subgraph (if present), unless a prefix of the prompt is cached
     if (iteration_counter++ == 0 &&
-        init_run_decoder_session_state_ != nullptr) {
+        init_run_decoder_session_state_ != nullptr && prefix_length == 0) {
 #ifdef DEBUG_NODE_INPUTS_OUTPUTS
       const_cast<SessionState*>(this->init_run_decoder_session_state_)->IncrementGraphExecutionCounter();
 #endif
@@ -312,6 +431,11 @@ Status GreedySearchGpt<T, ParametersT>::Execute(const FeedsFetchesManager* init_
 
     ORT_RETURN_IF_ERROR(status);
 
+    if (use_prefix_cache && iteration_counter == 1) {
+      auto first_present = fetches.begin() + gpt_subgraph_.GetFirstPresentOutputIndex();
+      prefix_cache_->Insert(input_ids, std::vector<OrtValue>(first_present, first_present + gpt_subgraph_.num_layers));
+    }
+
     const OrtValue& logits = fetches[0];
     gsl::span<int32_t> next_tokens;
 
@@ -410,6 +534,809 @@ Status GreedySearchGpt<T, ParametersT>::Execute(const FeedsFetchesManager* init_
   return status;
 }
 
+template <typename T, typename ParametersT>
+Status GreedySearchGpt<T, ParametersT>::RunPrompt(gsl::span<const int32_t> prompt,
+                                                  const FeedsFetchesManager* init_run_feeds_fetches_manager,
+                                                  const FeedsFetchesManager& feeds_fetches_manager,
+                                                  std::vector<OrtValue>& present) {
+  // The prompt is decoded from the past state of its longest prefix in the prefix cache.
+  std::vector<OrtValue> prefix_present;
+  const int prefix_length = prefix_cache_ != nullptr
+                                ? prefix_cache_->Lookup(prompt, static_cast<int>(prompt.size()), prefix_present)
+                                : 0;
+  if (prefix_length == static_cast<int>(prompt.size())) {
+    present.clear();
+    for (const OrtValue& state : prefix_present) {
+      present.push_back(TruncateState(state, prefix_length));
+    }
+    return Status::OK();
+  }
+
+  const bool use_init_run = init_run_gpt_subgraph_ != nullptr && prefix_length == 0;
+  GptSubgraph& subgraph = use_init_run ? *init_run_gpt_subgraph_ : gpt_subgraph_;
+
+  int64_t dims[] = {1, static_cast<int64_t>(prompt.size())};
+  TensorShape shape(&dims[0], 2);
+  const OrtMemoryInfo& location = this->cpu_allocator_->Info();
+  Tensor prompt_ids(DataTypeImpl::GetType<int32_t>(), shape, const_cast<int32_t*>(prompt.data()), location);
+
+  // The prompt has no padding.
+  OrtValue attention_mask;
+  Tensor::InitOrtValue(DataTypeImpl::GetType<int32_t>(), shape, this->cpu_allocator_, attention_mask);
+  gsl::span<int32_t> mask = attention_mask.GetMutable<Tensor>()->MutableDataAsSpan<int32_t>();
+  std::fill(mask.begin(), mask.end(), 1);
+
+  int32_t prompt_length = 0;
+  gsl::span<int32_t> sequence_lengths(&prompt_length, 1);
+  OrtValue expanded_input_ids;
+  std::vector<OrtValue> feeds;
+  std::vector<OrtValue> fetches;
+  IAllocatorUniquePtr<char> buffer;
+  ORT_RETURN_IF_ERROR(subgraph.CreateInitialFeeds(prompt_ids,
+                                                  this->implicit_inputs_,
+                                                  1,
+                                                  this->parameters_->pad_token_id,
+                                                  sequence_lengths,
+                                                  expanded_input_ids,
+                                                  &attention_mask,
+                                                  feeds,
+                                                  this->create_inputs_func_,
+                                                  this->add_to_feeds_func_,
+                                                  buffer,
+                                                  this->ort_stream_,
+                                                  this->parameters_->max_length));
+  if (prefix_length > 0) {
+    SetPrefixFeeds(prompt, prefix_length, prefix_present, feeds);
+  }
+
+  ORT_RETURN_IF_ERROR(utils::ExecuteSubgraph(use_init_run ? *init_run_decoder_session_state_
+                                                          : this->decoder_session_state_,
+                                             use_init_run ? *init_run_feeds_fetches_manager : feeds_fetches_manager,
+                                             feeds,
+                                             fetches,
+                                             {},
+                                             ExecutionMode::ORT_SEQUENTIAL,
+                                             this->context_.GetTerminateFlag(),
+                                             this->context_.Logger(),
+                                             this->ort_stream_));
+
+  auto first_present = fetches.begin() + subgraph.GetFirstPresentOutputIndex();
+  present.assign(first_present, first_present + subgraph.num_layers);
+  if (prefix_cache_ != nullptr) {
+    prefix_cache_->Insert(prompt, present);
+  }
+  return Status::OK();
+}
+
+template <typename T, typename ParametersT>
+void GreedySearchGpt<T, ParametersT>::SetPrefixFeeds(gsl::span<const int32_t> prompt,
+                                                     int prefix_length,
+                                                     const std::vector<OrtValue>& present,
+                                                     std::vector<OrtValue>& feeds) {
+  const int64_t prompt_length = static_cast<int64_t>(prompt.size());
+  const int64_t count = prompt_length - prefix_length;
+
+  auto int32_type = DataTypeImpl::GetType<int32_t>();
+  int64_t input_dims[] = {1, count};
+  int64_t mask_dims[] = {1, prompt_length};
+  OrtValue input_ids;
+  OrtValue position_ids;
+  OrtValue attention_mask;
+  Tensor::InitOrtValue(int32_type, TensorShape(&input_dims[0], 2), this->cpu_allocator_, input_ids);
+  Tensor::InitOrtValue(int32_type, TensorShape(&input_dims[0], 2), this->cpu_allocator_, position_ids);
+  Tensor::InitOrtValue(int32_type, TensorShape(&mask_dims[0], 2), this->cpu_allocator_, attention_mask);
+  int32_t* position_ids_data = position_ids.GetMutable<Tensor>()->MutableData<int32_t>();
+  std::copy(prompt.begin() + prefix_length, prompt.end(), input_ids.GetMutable<Tensor>()->MutableData<int32_t>());
+  std::iota(position_ids_data, position_ids_data + count, prefix_length);
+  std::fill_n(attention_mask.GetMutable<Tensor>()->MutableData<int32_t>(), prompt_length, 1);
+
+  // The feeds may have been created for the init_run_decoder subgraph, which can use other implicit inputs.
+  feeds.clear();
+  feeds.push_back(std::move(input_ids));
+  feeds.push_back(std::move(position_ids));
+  feeds.push_back(std::move(attention_mask));
+  for (int layer = 0; layer < gpt_subgraph_.num_layers; layer++) {
+    feeds.push_back(TruncateState(present[layer], prefix_length));
+  }
+  for (size_t i = 0; i < this->implicit_inputs_.size(); ++i) {
+    if (gpt_subgraph_.used_implicit_inputs[i]) {
+      feeds.push_back(*this->implicit_inputs_[i]);
+    }
+  }
+}
+
+template <typename T, typename ParametersT>
+Status GreedySearchGpt<T, ParametersT>::ResizePastState(const std::vector<DecodingSlot>& slots,
+                                                        int past_sequence_length,
+                                                        int new_past_sequence_length,
+                                                        std::vector<OrtValue>& feeds) {
+  // Past state shape is (2, batch_size, num_heads, past_sequence_length, head_size).
+  const int64_t batch_size = static_cast<int64_t>(slots.size());
+  const int64_t num_heads = gpt_subgraph_.num_heads;
+  const int64_t head_size = gpt_subgraph_.head_size;
+  int64_t dims[] = {2, batch_size, num_heads, new_past_sequence_length, head_size};
+  TensorShape past_shape(&dims[0], 5);
+
+  for (int layer = 0; layer < gpt_subgraph_.num_layers; layer++) {
+    OrtValue& past = feeds[static_cast<size_t>(gpt_subgraph_.GetFirstPastInputIndex()) + layer];
+
+    OrtValue new_past;
+    Tensor::InitOrtValue(DataTypeImpl::GetType<T>(), past_shape, this->temp_space_allocator_, new_past);
+    T* target = new_past.GetMutable<Tensor>()->MutableData<T>();
+
+    concurrency::ThreadPool::TrySimpleParallelFor(
+        this->thread_pool_, static_cast<std::ptrdiff_t>(batch_size), [&](std::ptrdiff_t slot_id) {
+          const DecodingSlot& slot = slots[slot_id];
+          const int64_t keep = slot.request < 0 ? 0 : slot.length - 1;
+
+          const T* source = nullptr;
+          int64_t source_batch_size = batch_size;
+          int64_t source_index = slot_id;
+          int64_t source_length = past_sequence_length;
+          if (slot.joined) {
+            if (keep > 0) {
+              source = slot.prompt_present[layer].Get<Tensor>().Data<T>();
+              source_batch_size = 1;
+              source_index = 0;
+              source_length = keep;
+            }
+          } else if (keep > 0) {
+            source = past.Get<Tensor>().Data<T>();
+          }
+
+          // Zero the padding so that masked positions cannot bring NaN into attention.
+          for (int64_t i = 0; i < 2 * num_heads; i++) {
+            const int64_t kv = i / num_heads;
+            const int64_t head = i % num_heads;
+            T* target_row = target + ((kv * batch_size + slot_id) * num_heads + head) *
+                                         new_past_sequence_length * head_size;
+            const int64_t padding = new_past_sequence_length - keep;
+            std::fill_n(target_row, padding * head_size, T{});
+            if (source != nullptr) {
+              const T* source_row = source + ((kv * source_batch_size + source_index) * num_heads + head) *
+                                                 source_length * head_size;
+              std::copy_n(source_row + (source_length - keep) * head_size, keep * head_size,
+                          target_row + padding * head_size);
+            }
+          }
+        });
+
+    past = std::move(new_past);
+  }
+
+  return Status::OK();
+}
+
+template <typename T, typename ParametersT>
+Status GreedySearchGpt<T, ParametersT>::ExecuteContinuousBatching(
+    const FeedsFetchesManager* init_run_feeds_fetches_manager,
+    const FeedsFetchesManager& feeds_fetches_manager) {
+  ParametersT* parameters = this->parameters_;
+
+  if (this->IsCuda() || gpt_subgraph_.past_present_share_buffer_) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, NOT_IMPLEMENTED,
+                           "continuous_batch_size is only supported on CPU without past_present_share_buffer");
+  }
+
+  // These depend on the position of a sequence in input_ids or on a sequence length shared by the batch.
+  if (parameters->min_length > 0 || !parameters->prefix_vocab_mask.empty() || !parameters->presence_mask.empty()) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "min_length, prefix_vocab_mask and presence_mask are not supported with "
+                           "continuous_batch_size");
+  }
+
+  const int num_requests = parameters->batch_size;
+  const int sequence_length = parameters->sequence_length;
+  const int max_length = parameters->max_length;
+  const int32_t pad_token_id = parameters->pad_token_id;
+
+  int64_t sequences_dims[] = {num_requests, max_length};
+  TensorShape sequences_shape(&sequences_dims[0], sizeof(sequences_dims) / sizeof(sequences_dims[0]));
+  gsl::span<int32_t> output = this->context_.Output(0, sequences_shape)->template MutableDataAsSpan<int32_t>();
+
+  // Sequences of input_ids without their padding. Padding is given by attention_mask when it is provided.
+  const Tensor* input_ids_tensor = this->context_.template Input<Tensor>(0);
+  const Tensor* attention_mask_tensor = this->context_.template Input<Tensor>(6);
+  gsl::span<const int32_t> input_ids = input_ids_tensor->DataAsSpan<int32_t>();
+  std::vector<std::vector<int32_t>> prompts(num_requests);
+  for (int i = 0; i < num_requests; i++) {
+    for (int j = 0; j < sequence_length; j++) {
+      const size_t index = SafeInt<size_t>(i) * sequence_length + j;
+      const bool is_token = attention_mask_tensor != nullptr
+                                ? attention_mask_tensor->Data<int32_t>()[index] != 0
+                                : input_ids[index] != pad_token_id;
+      if (is_token) {
+        prompts[i].push_back(input_ids[index]);
+      }
+    }
+    ORT_RETURN_IF(prompts[i].empty(), "Sequence ", i, " of input_ids has no token");
+  }
+
+  // From now on, the batch is the slots decoded together.
+  const int num_slots = std::min(parameters->continuous_batch_size, num_requests);
+  parameters->batch_size = num_slots;
+  this->logits_processors_.Init(*parameters);
+
+  GreedySearchState<T> greedy_state;
+  greedy_state.Init(this->cpu_allocator_,
+                    this->temp_space_allocator_,
+                    num_slots,
+                    static_cast<int>(parameters->vocab_size),
+                    0,
+                    max_length,
+                    static_cast<int>(parameters->num_heads),
+                    static_cast<int>(parameters->head_size),
+                    gpt_subgraph_.has_decoder_masked_attention_,
+                    this->IsCuda(),
+                    this->ort_stream_);
+
+  SamplingState<T> sampling_state;
+  if (std::is_same<ParametersT, SamplingParameters>::value) {
+    sampling_state.Init(this->temp_space_allocator_,
+                        this->cpu_allocator_,
+                        num_slots,
+                        static_cast<int>(parameters->vocab_size),
+                        max_length - sequence_length,
+                        parameters->seed,
+                        this->IsCuda(),
+                        this->ort_stream_);
+  }
+
+  // Feeds are input_ids, position_ids, attention_mask, past state and implicit inputs.
+  std::vector<OrtValue> feeds(static_cast<size_t>(gpt_subgraph_.GetFirstPastInputIndex()) + gpt_subgraph_.num_layers);
+  for (size_t i = 0; i < this->implicit_inputs_.size(); ++i) {
+    if (gpt_subgraph_.used_implicit_inputs[i]) {
+      feeds.push_back(*this->implicit_inputs_[i]);
+    }
+  }
+  std::vector<OrtValue> fetches;
+
+  std::vector<DecodingSlot> slots(num_slots);
+  int next_request = 0;
+  int current_length = 0;  // length of the sequences of the batch, including padding
+  bool slots_changed = true;
+  int iteration_counter = 0;
+
+  while (true) {
+    // Between two decoding steps, the next sequences of input_ids join the batch in the idle slots, and the
+    // past state is laid out again for the longest sequence of the batch.
+    if (slots_changed) {
+      int new_length = 0;
+      for (int slot_id = 0; slot_id < num_slots; slot_id++) {
+        DecodingSlot& slot = slots[slot_id];
+        if (slot.request < 0 && next_request < num_requests) {
+          slot.request = next_request++;
+          slot.length = static_cast<int>(prompts[slot.request].size());
+          slot.remaining = max_length - sequence_length;
+          slot.joined = true;
+          greedy_state.eos_meet[slot_id] = false;
+
+          // The last token of the prompt is decoded with the batch.
+          if (slot.length > 1) {
+            gsl::span<const int32_t> prompt(prompts[slot.request].data(), static_cast<size_t>(slot.length) - 1);
+            ORT_RETURN_IF_ERROR(RunPrompt(prompt, init_run_feeds_fetches_manager, feeds_fetches_manager,
+                                          slot.prompt_present));
+          }
+        }
+
+        if (slot.request < 0) {
+          slot.length = 1;
+        } else {
+          new_length = std::max(new_length, slot.length);
+        }
+      }
+
+      if (new_length == 0) {
+        break;
+      }
+
+      ORT_RETURN_IF_ERROR(ResizePastState(slots, std::max(current_length - 1, 0), new_length - 1, feeds));
+      greedy_state.sequences.ResizeSequences(new_length, pad_token_id);
+      for (int slot_id = 0; slot_id < num_slots; slot_id++) {
+        DecodingSlot& slot = slots[slot_id];
+        if (slot.request < 0) {
+          greedy_state.sequences.ResetSequence(slot_id, {}, pad_token_id);
+        } else if (slot.joined) {
+          greedy_state.sequences.ResetSequence(slot_id, prompts[slot.request], pad_token_id);
+          slot.joined = false;
+          slot.prompt_present.clear();
+        }
+      }
+
+      current_length = new_length;
+      slots_changed = false;
+    }
+
+    // Each sequence decodes its last token at its own position.
+    auto int32_type = DataTypeImpl::GetType<int32_t>();
+    int64_t step_dims[] = {num_slots, 1};
+    int64_t mask_dims[] = {num_slots, current_length};
+    OrtValue step_input_ids;
+    OrtValue position_ids;
+    OrtValue attention_mask;
+    Tensor::InitOrtValue(int32_type, TensorShape(&step_dims[0], 2), this->cpu_allocator_, step_input_ids);
+    Tensor::InitOrtValue(int32_type, TensorShape(&step_dims[0], 2), this->cpu_allocator_, position_ids);
+    Tensor::InitOrtValue(int32_type, TensorShape(&mask_dims[0], 2), this->cpu_allocator_, attention_mask);
+    int32_t* step_input_ids_data = step_input_ids.GetMutable<Tensor>()->MutableData<int32_t>();
+    int32_t* position_ids_data = position_ids.GetMutable<Tensor>()->MutableData<int32_t>();
+    int32_t* mask_data = attention_mask.GetMutable<Tensor>()->MutableData<int32_t>();
+    for (int slot_id = 0; slot_id < num_slots; slot_id++) {
+      const int length = slots[slot_id].length;
+      step_input_ids_data[slot_id] = greedy_state.sequences.GetSequence(slot_id)[current_length - 1];
+      position_ids_data[slot_id] = length - 1;
+      int32_t* mask = mask_data + static_cast<size_t>(slot_id) * current_length;
+      std::fill_n(mask, current_length - length, 0);
+      std::fill_n(mask + (current_length - length), length, 1);
+    }
+    feeds[0] = std::move(step_input_ids);
+    feeds[1] = std::move(position_ids);
+    feeds[2] = std::move(attention_mask);
+
+#ifdef DEBUG_NODE_INPUTS_OUTPUTS
+    const_cast<SessionState&>(this->decoder_session_state_).IncrementGraphExecutionCounter();
+#endif
+    ORT_RETURN_IF_ERROR(utils::ExecuteSubgraph(this->decoder_session_state_,
+                                               feeds_fetches_manager,
+                                               feeds,
+                                               fetches,
+                                               {},
+                                               ExecutionMode::ORT_SEQUENTIAL,
+                                               this->context_.GetTerminateFlag(),
+                                               this->context_.Logger(),
+                                               this->ort_stream_));
+
+    gsl::span<int32_t> next_tokens;
+    ORT_RETURN_IF_ERROR(this->GenerateNextToken(fetches[0],
+                                                next_tokens,
+                                                greedy_state,
+                                                sampling_state,
+                                                ++iteration_counter,
+                                                parameters->eos_token_id));
+    ++current_length;
+
+    // Finished sequences leave the batch.
+    for (int slot_id = 0; slot_id < num_slots; slot_id++) {
+      DecodingSlot& slot = slots[slot_id];
+      ++slot.length;
+      if (slot.request < 0 || (--slot.remaining > 0 && !greedy_state.eos_meet[slot_id])) {
+        continue;
+      }
+
+      // Same output as without continuous batching: the input sequence followed by the generated tokens.
+      const int generated = max_length - sequence_length - slot.remaining;
+      gsl::span<int32_t> sequence_output = output.subspan(SafeInt<size_t>(slot.request) * max_length, max_length);
+      gsl::span<const int32_t> sequence = greedy_state.sequences.GetSequence(slot_id);
+      gsl::copy(input_ids.subspan(SafeInt<size_t>(slot.request) * sequence_length, sequence_length),
+                sequence_output);
+      gsl::copy(sequence.subspan(sequence.size() - generated), sequence_output.subspan(sequence_length));
+      std::fill(sequence_output.begin() + sequence_length + generated, sequence_output.end(), pad_token_id);
+
+      slot.request = -1;
+      slots_changed = true;
+    }
+
+    for (int layer = 0; layer < gpt_subgraph_.num_layers; layer++) {
+      feeds[static_cast<size_t>(gpt_subgraph_.GetFirstPastInputIndex()) + layer] =
+          std::move(fetches[static_cast<size_t>(gpt_subgraph_.GetFirstPresentOutputIndex()) + layer]);
+    }
+    fetches.clear();
+  }
+
+  return Status::OK();
+}
+
+template <typename T, typename ParametersT>
+void GreedySearchGpt<T, ParametersT>::SetSpeculativeInputs(gsl::span<const int32_t> tokens,
+                                                           int count,
+                                                           int start,
+                                                           gsl::span<const int32_t> sequence_lengths,
+                                                           const Tensor& prompt_attention_mask,
+                                                           std::vector<OrtValue>& feeds) {
+  const int64_t batch_size = static_cast<int64_t>(sequence_lengths.size());
+  const int64_t prompt_length = prompt_attention_mask.Shape()[1];
+  const int64_t total_length = static_cast<int64_t>(start) + count;
+
+  auto int32_type = DataTypeImpl::GetType<int32_t>();
+  int64_t input_dims[] = {batch_size, count};
+  int64_t mask_dims[] = {batch_size, total_length};
+  OrtValue input_ids;
+  OrtValue position_ids;
+  OrtValue attention_mask;
+  Tensor::InitOrtValue(int32_type, TensorShape(&input_dims[0], 2), this->cpu_allocator_, input_ids);
+  Tensor::InitOrtValue(int32_type, TensorShape(&input_dims[0], 2), this->cpu_allocator_, position_ids);
+  Tensor::InitOrtValue(int32_type, TensorShape(&mask_dims[0], 2), this->cpu_allocator_, attention_mask);
+  int32_t* input_ids_data = input_ids.GetMutable<Tensor>()->MutableData<int32_t>();
+  int32_t* position_ids_data = position_ids.GetMutable<Tensor>()->MutableData<int32_t>();
+  int32_t* mask_data = attention_mask.GetMutable<Tensor>()->MutableData<int32_t>();
+  const int32_t* prompt_mask = prompt_attention_mask.Data<int32_t>();
+
+  for (int64_t i = 0; i < batch_size; i++) {
+    for (int j = 0; j < count; j++) {
+      input_ids_data[i * count + j] = tokens[static_cast<size_t>(i) * count + j];
+      // The generated tokens follow the tokens of the prompt without padding.
+      position_ids_data[i * count + j] = static_cast<int32_t>(start + j - prompt_length + sequence_lengths[i]);
+    }
+
+    int32_t* mask = mask_data + i * total_length;
+    std::copy_n(prompt_mask + i * prompt_length, prompt_length, mask);
+    std::fill(mask + prompt_length, mask + total_length, 1);
+  }
+
+  feeds[0] = std::move(input_ids);
+  feeds[1] = std::move(position_ids);
+  feeds[2] = std::move(attention_mask);
+}
+
+template <typename T, typename ParametersT>
+OrtValue GreedySearchGpt<T, ParametersT>::TruncateState(const OrtValue& state, int sequence_length) {
+  // State shape is (2, batch_size, num_heads, sequence_length, head_size).
+  const TensorShape& shape = state.Get<Tensor>().Shape();
+  const int64_t source_length = shape[3];
+  if (source_length == sequence_length) {
+    return state;
+  }
+
+  const int64_t rows = shape[0] * shape[1] * shape[2];
+  const int64_t head_size = shape[4];
+  int64_t dims[] = {shape[0], shape[1], shape[2], sequence_length, head_size};
+  OrtValue truncated;
+  Tensor::InitOrtValue(DataTypeImpl::GetType<T>(), TensorShape(&dims[0], 5), this->temp_space_allocator_, truncated);
+
+  const T* source = state.Get<Tensor>().Data<T>();
+  T* target = truncated.GetMutable<Tensor>()->MutableData<T>();
+  concurrency::ThreadPool::TrySimpleParallelFor(
+      this->thread_pool_, static_cast<std::ptrdiff_t>(rows), [&](std::ptrdiff_t row) {
+        std::copy_n(source + row * source_length * head_size, sequence_length * head_size,
+                    target + row * sequence_length * head_size);
+      });
+
+  return truncated;
+}
+
+template <typename T, typename ParametersT>
+void GreedySearchGpt<T, ParametersT>::SetPastState(const GptSubgraph& subgraph,
+                                                   std::vector<OrtValue>& fetches,
+                                                   int past_sequence_length,
+                                                   std::vector<OrtValue>& feeds) {
+  for (int layer = 0; layer < subgraph.num_layers; layer++) {
+    const OrtValue& present = fetches[static_cast<size_t>(subgraph.GetFirstPresentOutputIndex()) + layer];
+    feeds[static_cast<size_t>(subgraph.GetFirstPastInputIndex()) + layer] = TruncateState(present,
+                                                                                           past_sequence_length);
+  }
+  fetches.clear();
+}
+
+template <typename T, typename ParametersT>
+void GreedySearchGpt<T, ParametersT>::ComputeProbabilities(const T* logits, float temperature,
+                                                           gsl::span<float> probs) {
+  float max_logit = -std::numeric_limits<float>::infinity();
+  for (size_t i = 0; i < probs.size(); i++) {
+    max_logit = std::max(max_logit, static_cast<float>(logits[i]));
+  }
+
+  float sum = 0.0f;
+  for (size_t i = 0; i < probs.size(); i++) {
+    probs[i] = std::exp((static_cast<float>(logits[i]) - max_logit) / temperature);
+    sum += probs[i];
+  }
+
+  for (float& prob : probs) {
+    prob /= sum;
+  }
+}
+
+template <typename T, typename ParametersT>
+Status GreedySearchGpt<T, ParametersT>::ExecuteSpeculative(
+    const FeedsFetchesManager* init_run_feeds_fetches_manager,
+    const FeedsFetchesManager& feeds_fetches_manager) {
+  ParametersT* parameters = this->parameters_;
+  GptSubgraph& draft_subgraph = *draft_gpt_subgraph_;
+
+  if (this->IsCuda() || gpt_subgraph_.past_present_share_buffer_ || draft_subgraph.past_present_share_buffer_) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, NOT_IMPLEMENTED,
+                           "draft_decoder is only supported on CPU without past_present_share_buffer");
+  }
+
+  if (parameters->continuous_batch_size > 0) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "draft_decoder is not supported with continuous_batch_size");
+  }
+
+  if (draft_subgraph.vocab_size != gpt_subgraph_.vocab_size ||
+      draft_subgraph.IsOutputFloat16() != gpt_subgraph_.IsOutputFloat16()) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT,
+                           "draft_decoder shall have the same vocabulary size and logits type as decoder. Got ",
+                           draft_subgraph.vocab_size, " and ", gpt_subgraph_.vocab_size);
+  }
+
+  constexpr bool use_sampling = std::is_same<ParametersT, SamplingParameters>::value;
+  const int batch_size = parameters->batch_size;
+  const int vocab_size = parameters->vocab_size;
+  const int sequence_length = parameters->sequence_length;
+  const int max_length = parameters->max_length;
+  const int num_draft_tokens = parameters->num_draft_tokens;
+
+  int64_t sequences_dims[] = {batch_size, max_length};
+  TensorShape sequences_shape(&sequences_dims[0], sizeof(sequences_dims) / sizeof(sequences_dims[0]));
+  Tensor* output_sequences = this->context_.Output(0, sequences_shape);
+
+  GreedySearchState<T> greedy_state;
+  greedy_state.Init(this->cpu_allocator_,
+                    this->temp_space_allocator_,
+                    batch_size,
+                    vocab_size,
+                    sequence_length,
+                    max_length,
+                    static_cast<int>(parameters->num_heads),
+                    static_cast<int>(parameters->head_size),
+                    gpt_subgraph_.has_decoder_masked_attention_,
+                    this->IsCuda(),
+                    this->ort_stream_);
+
+  SamplingState<T> sampling_state;
+  if (use_sampling) {
+    sampling_state.Init(this->temp_space_allocator_,
+                        this->cpu_allocator_,
+                        batch_size,
+                        vocab_size,
+                        max_length - sequence_length,
+                        parameters->seed,
+                        this->IsCuda(),
+                        this->ort_stream_);
+  }
+
+  std::vector<OrtValue> feeds;
+  std::vector<OrtValue> fetches;
+  IAllocatorUniquePtr<char> buffer;
+  OrtValue expanded_input_ids_in_cpu;
+  ORT_RETURN_IF_ERROR(CreateInitialFeeds(greedy_state.sequence_lengths, expanded_input_ids_in_cpu, feeds, buffer));
+
+  init_greedy_state_func_(&greedy_state, greedy_state.sequence_lengths, this->ort_stream_);
+
+  greedy_state.SetSequence(expanded_input_ids_in_cpu.Get<Tensor>().DataAsSpan<int32_t>(),
+                           static_cast<size_t>(batch_size),
+                           max_length,
+                           sequence_length);
+
+  // The attention mask of the prompt is followed by ones for the generated tokens.
+  const OrtValue prompt_attention_mask = feeds[2];
+
+  // The draft decoder runs on the prompt to get its past state.
+  std::vector<OrtValue> draft_feeds;
+  std::vector<OrtValue> draft_fetches;
+  IAllocatorUniquePtr<char> draft_buffer;
+  OrtValue draft_expanded_input_ids;
+  std::vector<int32_t> draft_sequence_lengths_buffer(batch_size);
+  gsl::span<int32_t> draft_sequence_lengths(draft_sequence_lengths_buffer);
+  ORT_RETURN_IF_ERROR(draft_subgraph.CreateInitialFeeds(*this->context_.template Input<Tensor>(0),
+                                                        this->implicit_inputs_,
+                                                        parameters->num_beams,
+                                                        parameters->pad_token_id,
+                                                        draft_sequence_lengths,
+                                                        draft_expanded_input_ids,
+                                                        this->context_.GetInputOrtValue(6),
+                                                        draft_feeds,
+                                                        this->create_inputs_func_,
+                                                        this->add_to_feeds_func_,
+                                                        draft_buffer,
+                                                        this->ort_stream_,
+                                                        max_length));
+
+  const bool use_init_run = init_run_decoder_session_state_ != nullptr;
+  ORT_RETURN_IF_ERROR(utils::ExecuteSubgraph(use_init_run ? *init_run_decoder_session_state_
+                                                          : this->decoder_session_state_,
+                                             use_init_run ? *init_run_feeds_fetches_manager : feeds_fetches_manager,
+                                             feeds,
+                                             fetches,
+                                             {},
+                                             ExecutionMode::ORT_SEQUENTIAL,
+                                             this->context_.GetTerminateFlag(),
+                                             this->context_.Logger(),
+                                             this->ort_stream_));
+
+  ORT_RETURN_IF_ERROR(utils::ExecuteSubgraph(*draft_decoder_session_state_,
+                                             *draft_feeds_fetches_manager_,
+                                             draft_feeds,
+                                             draft_fetches,
+                                             {},
+                                             ExecutionMode::ORT_SEQUENTIAL,
+                                             this->context_.GetTerminateFlag(),
+                                             this->context_.Logger(),
+                                             this->ort_stream_));
+
+  gsl::span<int32_t> next_tokens;
+  ORT_RETURN_IF_ERROR(this->GenerateNextToken(fetches[0],
+                                              next_tokens,
+                                              greedy_state,
+                                              sampling_state,
+                                              1,
+                                              parameters->eos_token_id));
+
+  int current_length = sequence_length + 1;
+  int draft_past_length = sequence_length;
+  SetPastState(gpt_subgraph_, fetches, current_length - 1, feeds);
+  SetPastState(draft_subgraph, draft_fetches, draft_past_length, draft_feeds);
+
+  std::vector<int32_t> draft_tokens(static_cast<size_t>(batch_size) * num_draft_tokens);
+  // Probabilities of the draft tokens, needed to accept or reject them when sampling.
+  std::vector<float> draft_probs(use_sampling ? static_cast<size_t>(batch_size) * num_draft_tokens * vocab_size : 0);
+  std::vector<float> probs(use_sampling ? vocab_size : 0);
+  std::uniform_real_distribution<float> distribution(0.0f, 1.0f);
+  std::default_random_engine& generator = sampling_state.generator;
+  std::vector<int32_t> step_tokens;
+
+  // Logits of one position of the verification run.
+  int64_t position_logits_dims[] = {batch_size, 1, vocab_size};
+  OrtValue position_logits;
+  Tensor::InitOrtValue(DataTypeImpl::GetType<T>(), TensorShape(&position_logits_dims[0], 3),
+                       this->temp_space_allocator_, position_logits);
+  T* position_logits_data = position_logits.GetMutable<Tensor>()->MutableData<T>();
+
+  const gsl::span<bool>& eos_meet = greedy_state.eos_meet;
+  int64_t num_proposed = 0;
+  int64_t num_accepted = 0;
+
+  while (current_length < max_length && !std::all_of(eos_meet.begin(), eos_meet.end(), [](bool b) { return b; })) {
+    const int num_draft = std::min(num_draft_tokens, max_length - current_length - 1);
+
+    // The draft decoder proposes tokens one by one. Its first run decodes the tokens it has not seen yet.
+    for (int i = 0; i < num_draft; i++) {
+      const int start = i == 0 ? draft_past_length : current_length + i - 1;
+      const int count = i == 0 ? current_length - draft_past_length : 1;
+      step_tokens.resize(static_cast<size_t>(batch_size) * count);
+      for (int b = 0; b < batch_size; b++) {
+        for (int j = 0; j < count; j++) {
+          step_tokens[static_cast<size_t>(b) * count + j] =
+              i == 0 ? greedy_state.sequences.GetSequence(b)[static_cast<size_t>(start) + j]
+                     : draft_tokens[static_cast<size_t>(b) * num_draft_tokens + i - 1];
+        }
+      }
+      SetSpeculativeInputs(step_tokens, count, start, greedy_state.sequence_lengths,
+                           prompt_attention_mask.Get<Tensor>(), draft_feeds);
+
+      ORT_RETURN_IF_ERROR(utils::ExecuteSubgraph(*draft_decoder_session_state_,
+                                                 *draft_feeds_fetches_manager_,
+                                                 draft_feeds,
+                                                 draft_fetches,
+                                                 {},
+                                                 ExecutionMode::ORT_SEQUENTIAL,
+                                                 this->context_.GetTerminateFlag(),
+                                                 this->context_.Logger(),
+                                                 this->ort_stream_));
+
+      const T* draft_logits = draft_fetches[0].Get<Tensor>().Data<T>();
+      for (int b = 0; b < batch_size; b++) {
+        const T* logits = draft_logits + (static_cast<size_t>(b) * count + count - 1) * vocab_size;
+        int32_t& token = draft_tokens[static_cast<size_t>(b) * num_draft_tokens + i];
+        if (use_sampling) {
+          gsl::span<float> draft_token_probs(
+              draft_probs.data() + (static_cast<size_t>(b) * num_draft_tokens + i) * vocab_size, vocab_size);
+          ComputeProbabilities(logits, parameters->temperature, draft_token_probs);
+          token = std::discrete_distribution<int32_t>(draft_token_probs.begin(), draft_token_probs.end())(generator);
+        } else {
+          const T* best = std::max_element(logits, logits + vocab_size, [](const T& x, const T& y) {
+            return static_cast<float>(x) < static_cast<float>(y);
+          });
+          token = static_cast<int32_t>(best - logits);
+        }
+      }
+
+      draft_past_length = start + count;
+      SetPastState(draft_subgraph, draft_fetches, draft_past_length, draft_feeds);
+    }
+
+    // The decoder scores the last token and the proposed tokens in one run.
+    const int count = num_draft + 1;
+    step_tokens.resize(static_cast<size_t>(batch_size) * count);
+    for (int b = 0; b < batch_size; b++) {
+      step_tokens[static_cast<size_t>(b) * count] = greedy_state.sequences.GetSequence(b)[current_length - 1];
+      std::copy_n(draft_tokens.begin() + static_cast<size_t>(b) * num_draft_tokens, num_draft,
+                  step_tokens.begin() + static_cast<size_t>(b) * count + 1);
+    }
+    SetSpeculativeInputs(step_tokens, count, current_length - 1, greedy_state.sequence_lengths,
+                         prompt_attention_mask.Get<Tensor>(), feeds);
+
+#ifdef DEBUG_NODE_INPUTS_OUTPUTS
+    const_cast<SessionState&>(this->decoder_session_state_).IncrementGraphExecutionCounter();
+#endif
+    ORT_RETURN_IF_ERROR(utils::ExecuteSubgraph(this->decoder_session_state_,
+                                               feeds_fetches_manager,
+                                               feeds,
+                                               fetches,
+                                               {},
+                                               ExecutionMode::ORT_SEQUENTIAL,
+                                               this->context_.GetTerminateFlag(),
+                                               this->context_.Logger(),
+                                               this->ort_stream_));
+
+    // Logits of each position go through the logits processors like in a run decoding one token, so that the
+    // kept tokens are the tokens generated without draft decoder: a proposed token is kept when the decoder
+    // chooses it too, or with probability min(1, p / q) when sampling. The first rejected token is replaced by the
+    // token chosen by the decoder, or sampled from max(p - q, 0).
+    const T* logits = fetches[0].Get<Tensor>().Data<T>();
+    for (int j = 0; j < count; j++) {
+      for (int b = 0; b < batch_size; b++) {
+        std::copy_n(logits + (static_cast<size_t>(b) * count + j) * vocab_size, vocab_size,
+                    position_logits_data + static_cast<size_t>(b) * vocab_size);
+      }
+
+      ORT_RETURN_IF_ERROR(this->ProcessLogits(position_logits, greedy_state, sampling_state,
+                                              this->temp_space_allocator_,
+                                              current_length - sequence_length + 1));
+
+      // The token of the last position is always chosen by the decoder, and so are the tokens of the sequences
+      // following a sequence rejecting its proposed token.
+      gsl::span<int32_t> tokens = greedy_state.next_tokens;
+      bool all_accepted = j < num_draft;
+      for (int b = 0; all_accepted && b < batch_size; b++) {
+        if (eos_meet[b]) {
+          continue;
+        }
+
+        const int32_t draft_token = draft_tokens[static_cast<size_t>(b) * num_draft_tokens + j];
+        bool accepted = false;
+        if (use_sampling) {
+          const float* draft_token_probs = draft_probs.data() +
+                                           (static_cast<size_t>(b) * num_draft_tokens + j) * vocab_size;
+          ComputeProbabilities(greedy_state.next_token_scores.data() + static_cast<size_t>(b) * vocab_size, 1.0f, probs);
+          accepted = distribution(generator) * draft_token_probs[draft_token] < probs[draft_token];
+          if (!accepted) {
+            float sum = 0.0f;
+            for (int v = 0; v < vocab_size; v++) {
+              probs[v] = std::max(probs[v] - draft_token_probs[v], 0.0f);
+              sum += probs[v];
+            }
+            // Keep the token sampled from p when p is not above q anywhere.
+            if (sum > 0.0f) {
+              tokens[b] = std::discrete_distribution<int32_t>(probs.begin(), probs.end())(generator);
+            }
+          }
+        } else {
+          accepted = tokens[b] == draft_token;
+        }
+
+        if (accepted) {
+          tokens[b] = draft_token;
+        }
+        all_accepted = all_accepted && accepted;
+      }
+
+      this->AppendNextTokens(greedy_state, tokens, parameters->eos_token_id);
+      ++current_length;
+
+      if (!all_accepted) {
+        break;
+      }
+      ++num_accepted;
+    }
+    num_proposed += num_draft;
+
+    // Roll back the past state to the kept tokens. The last token is decoded in the next step.
+    SetPastState(gpt_subgraph_, fetches, current_length - 1, feeds);
+    if (draft_past_length > current_length - 1) {
+      draft_past_length = current_length - 1;
+      for (int layer = 0; layer < draft_subgraph.num_layers; layer++) {
+        OrtValue& past = draft_feeds[static_cast<size_t>(draft_subgraph.GetFirstPastInputIndex()) + layer];
+        past = TruncateState(past, draft_past_length);
+      }
+    }
+  }
+
+  LOGS(this->context_.Logger(), VERBOSE) << "Speculative decoding accepted " << num_accepted << " of "
+                                         << num_proposed << " draft tokens";
+
+  // Copy the sequences to output
+  gsl::span<int32_t> output = output_sequences->MutableDataAsSpan<int32_t>();
+  for (int batch_id = 0; batch_id < batch_size; ++batch_id) {
+    auto batch_output = output.subspan(static_cast<size_t>(batch_id) * max_length, max_length);
+    gsl::span<const int32_t> sequence_source = greedy_state.sequences.GetSequence(batch_id);
+    gsl::copy(sequence_source, batch_output);
+    std::fill(batch_output.begin() + sequence_source.size(), batch_output.end(), parameters->pad_token_id);
+  }
+
+  return Status::OK();
+}
+
 }  // namespace transformers
 }  // namespace contrib
 }  // namespace onnxruntime
@@ -15,6 +15,9 @@ void GreedySearchParameters::ParseFromAttributes(const OpKernelInfo& info) {
   decoder_start_token_id = static_cast<int>(info.GetAttrOrDefault<int64_t>("decoder_start_token_id", -1));
   no_repeat_ngram_size = static_cast<int>(info.GetAttrOrDefault<int64_t>("no_repeat_ngram_size", 0));
   vocab_size = static_cast<int>(info.GetAttrOrDefault<int64_t>("vocab_size", -1));
+  continuous_batch_size = static_cast<int>(info.GetAttrOrDefault<int64_t>("continuous_batch_size", 0));
+  num_draft_tokens = static_cast<int>(info.GetAttrOrDefault<int64_t>("num_draft_tokens", 4));
+  prefix_cache_bytes = info.GetAttrOrDefault<int64_t>("prefix_cache_bytes", 0);
 }
 
 void GreedySearchParameters::ParseFromInputs(OpKernelContext* context) {
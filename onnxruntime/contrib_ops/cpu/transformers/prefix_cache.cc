@@ -0,0 +1,125 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <algorithm>
+
+#include "core/framework/tensor.h"
+#include "contrib_ops/cpu/transformers/prefix_cache.h"
+
+namespace onnxruntime {
+namespace contrib {
+namespace transformers {
+
+int PrefixCache::Lookup(gsl::span<const int32_t> tokens, int max_prefix_length, std::vector<OrtValue>& present) {
+  const size_t max_length = std::min(tokens.size(), static_cast<size_t>(std::max(max_prefix_length, 0)));
+
+  std::vector<uint64_t> hashes(max_length + 1);
+  hashes[0] = kEmptyHash;
+  for (size_t i = 0; i < max_length; i++) {
+    hashes[i + 1] = HashNextToken(hashes[i], tokens[i]);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (size_t length = max_length; length > 0; length--) {
+    auto prefix = prefixes_.find(hashes[length]);
+    if (prefix == prefixes_.end()) {
+      continue;
+    }
+
+    // Tokens are compared in case of hash collision.
+    const Entry& entry = *prefix->second;
+    if (entry.tokens.size() < length || !std::equal(tokens.begin(), tokens.begin() + length, entry.tokens.begin())) {
+      continue;
+    }
+
+    entries_.splice(entries_.begin(), entries_, prefix->second);
+    present = entry.present;
+    return static_cast<int>(length);
+  }
+
+  return 0;
+}
+
+void PrefixCache::Insert(gsl::span<const int32_t> tokens, const std::vector<OrtValue>& present) {
+  size_t bytes = 0;
+  for (const OrtValue& state : present) {
+    bytes += state.Get<Tensor>().SizeInBytes();
+  }
+  if (tokens.empty() || bytes > capacity_in_bytes_) {
+    return;
+  }
+
+  std::vector<uint64_t> hashes(tokens.size() + 1);
+  hashes[0] = kEmptyHash;
+  for (size_t i = 0; i < tokens.size(); i++) {
+    hashes[i + 1] = HashNextToken(hashes[i], tokens[i]);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  // The sequence is already cached when a cached sequence starts with it.
+  auto prefix = prefixes_.find(hashes[tokens.size()]);
+  if (prefix != prefixes_.end() && prefix->second->tokens.size() >= tokens.size() &&
+      std::equal(tokens.begin(), tokens.end(), prefix->second->tokens.begin())) {
+    entries_.splice(entries_.begin(), entries_, prefix->second);
+    return;
+  }
+
+  // The cached sequences that start the sequence are replaced by it.
+  for (size_t length = 1; length < tokens.size(); length++) {
+    prefix = prefixes_.find(hashes[length]);
+    if (prefix != prefixes_.end() && prefix->second->tokens.size() == length &&
+        std::equal(tokens.begin(), tokens.begin() + length, prefix->second->tokens.begin())) {
+      Erase(prefix->second);
+    }
+  }
+
+  entries_.push_front(Entry{std::vector<int32_t>(tokens.begin(), tokens.end()), present, bytes});
+  bytes_ += bytes;
+  for (size_t length = 1; length <= tokens.size(); length++) {
+    prefixes_[hashes[length]] = entries_.begin();
+  }
+
+  while (bytes_ > capacity_in_bytes_) {
+    Erase(std::prev(entries_.end()));
+  }
+}
+
+size_t PrefixCache::SizeInBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return bytes_;
+}
+
+void PrefixCache::Erase(EntryList::iterator entry) {
+  // The prefixes that map to the sequence are mapped again to the most recent sequence that shares them, if any.
+  std::vector<int32_t> tokens = std::move(entry->tokens);
+  std::vector<uint64_t> hashes(tokens.size() + 1);
+  hashes[0] = kEmptyHash;
+  size_t num_orphans = 0;
+  for (size_t i = 0; i < tokens.size(); i++) {
+    hashes[i + 1] = HashNextToken(hashes[i], tokens[i]);
+    auto prefix = prefixes_.find(hashes[i + 1]);
+    if (prefix != prefixes_.end() && prefix->second == entry) {
+      prefixes_.erase(prefix);
+      num_orphans++;
+    }
+  }
+
+  bytes_ -= entry->bytes;
+  entries_.erase(entry);
+
+  for (auto it = entries_.begin(); it != entries_.end() && num_orphans > 0; ++it) {
+    const size_t length = std::min(tokens.size(), it->tokens.size());
+    const size_t shared_length = static_cast<size_t>(
+        std::mismatch(tokens.begin(), tokens.begin() + length, it->tokens.begin()).first - tokens.begin());
+    for (size_t i = 1; i <= shared_length; i++) {
+      if (prefixes_.emplace(hashes[i], it).second) {
+        num_orphans--;
+      }
+    }
+  }
+}
+
+}  // namespace transformers
+}  // namespace contrib
+}  // namespace onnxruntime
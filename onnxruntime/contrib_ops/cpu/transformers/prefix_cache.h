@@ -0,0 +1,68 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <gsl/gsl>
+#include "core/framework/ort_value.h"
+
+namespace onnxruntime {
+namespace contrib {
+namespace transformers {
+
+// Cache of the present state of the decoder for sequences of tokens, shared by the runs of a generation operator,
+// so that the prompts starting with a cached sequence only decode the tokens that follow it.
+// Sequences are found by a rolling hash of each of their prefixes, and the least recently used sequences are
+// evicted when the present state exceeds the capacity in bytes.
+class PrefixCache {
+ public:
+  explicit PrefixCache(size_t capacity_in_bytes) : capacity_in_bytes_(capacity_in_bytes) {}
+
+  // Find the longest prefix of tokens, of at most max_prefix_length tokens, that starts a cached sequence.
+  // Returns the length of the prefix, or 0 when there is none. The present state of the cached sequence is set to
+  // present: its positions from the length of the prefix belong to the cached sequence only.
+  int Lookup(gsl::span<const int32_t> tokens, int max_prefix_length, std::vector<OrtValue>& present);
+
+  // Add the present state of each layer of the decoder for a sequence of tokens.
+  void Insert(gsl::span<const int32_t> tokens, const std::vector<OrtValue>& present);
+
+  size_t SizeInBytes() const;
+
+ private:
+  struct Entry {
+    std::vector<int32_t> tokens;
+    std::vector<OrtValue> present;
+    size_t bytes;
+  };
+  using EntryList = std::list<Entry>;
+
+  // Rolling hash of the prefix of the next length, from the hash of a prefix and the next token.
+  static uint64_t HashNextToken(uint64_t hash, int32_t token) {
+    constexpr uint64_t kMultiplier = 0x100000001b3ULL;
+    return (hash ^ static_cast<uint32_t>(token)) * kMultiplier;
+  }
+
+  static constexpr uint64_t kEmptyHash = 0xcbf29ce484222325ULL;
+
+  // Remove a cached sequence. The caller holds the lock.
+  void Erase(EntryList::iterator entry);
+
+  mutable std::mutex mutex_;
+  const size_t capacity_in_bytes_;
+  size_t bytes_ = 0;
+
+  // Cached sequences, most recently used first.
+  EntryList entries_;
+
+  // Latest cached sequence starting with the prefix of a given hash.
+  std::unordered_map<uint64_t, EntryList::iterator> prefixes_;
+};
+
+}  // namespace transformers
+}  // namespace contrib
+}  // namespace onnxruntime
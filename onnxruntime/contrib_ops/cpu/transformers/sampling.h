@@ -9,6 +9,7 @@
 #include "core/providers/cpu/controlflow/utils.h"
 #include "contrib_ops/cpu/transformers/subgraph_gpt.h"
 #include "contrib_ops/cpu/transformers/generation_device_helper.h"
+#include "contrib_ops/cpu/transformers/prefix_cache.h"
 #include "contrib_ops/cpu/transformers/sampling_parameters.h"
 
 namespace onnxruntime {
@@ -102,15 +103,22 @@ class Sampling : public IControlFlowKernel {
   //------------------------------------------------------------
   std::unique_ptr<GptSubgraph> init_run_gpt_subgraph_;
   std::unique_ptr<GptSubgraph> gpt_subgraph_;
+  std::unique_ptr<GptSubgraph> draft_gpt_subgraph_;
 
   FeedsFetchesManager* decoder_feeds_fetches_manager_;
   FeedsFetchesManager* init_run_decoder_feeds_fetches_manager_;
+  FeedsFetchesManager* draft_decoder_feeds_fetches_manager_ = nullptr;
 
   IConsoleDumper* dumper_;
 
   SamplingParameters parameters_;
 
   bool has_init_decoder_ = false;
+
+  bool has_draft_decoder_ = false;
+
+  // Past state of prompt prefixes shared by the runs of the node.
+  std::unique_ptr<PrefixCache> prefix_cache_;
 };
 
 }  // namespace transformers
@@ -19,6 +19,9 @@ void SamplingParameters::ParseFromAttributes(const OpKernelInfo& info) {
   presence_penalty = info.GetAttrOrDefault<float>("presence_penalty", 0.0f);
   custom_sampling = static_cast<int>(info.GetAttrOrDefault<int64_t>("custom", 0));
   vocab_size = static_cast<int>(info.GetAttrOrDefault<int64_t>("vocab_size", -1));
+  continuous_batch_size = static_cast<int>(info.GetAttrOrDefault<int64_t>("continuous_batch_size", 0));
+  num_draft_tokens = static_cast<int>(info.GetAttrOrDefault<int64_t>("num_draft_tokens", 4));
+  prefix_cache_bytes = info.GetAttrOrDefault<int64_t>("prefix_cache_bytes", 0);
 }
 
 void SamplingParameters::ParseFromInputs(OpKernelContext* context) {
@@ -1,6 +1,8 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <algorithm>
+
 #include "core/common/safeint.h"
 #include "contrib_ops/cpu/transformers/sequences.h"
 
@@ -90,6 +92,36 @@ void Sequences::AfterDeviceAppendedNextToken() {
   current_sequences_buffer ^= 1;
 }
 
+void Sequences::ResizeSequences(int sequence_length, int32_t pad_token_id) {
+  ORT_ENFORCE(sequence_length >= 0 && sequence_length <= max_length_,
+              "sequence_length (", sequence_length, ") shall be in the range [0, ", max_length_, "]");
+
+  gsl::span<int32_t> buffer = sequences[current_sequences_buffer];
+  for (int i = 0; i < batch_beam_size_; i++) {
+    int32_t* sequence = buffer.data() + SafeInt<size_t>(i) * max_length_;
+    if (sequence_length < current_length_) {
+      std::copy(sequence + (current_length_ - sequence_length), sequence + current_length_, sequence);
+    } else if (sequence_length > current_length_) {
+      const int padding = sequence_length - current_length_;
+      std::copy_backward(sequence, sequence + current_length_, sequence + sequence_length);
+      std::fill_n(sequence, padding, pad_token_id);
+    }
+  }
+
+  current_length_ = sequence_length;
+}
+
+void Sequences::ResetSequence(int beam_index, gsl::span<const int32_t> tokens, int32_t pad_token_id) {
+  ORT_ENFORCE(tokens.size() <= static_cast<size_t>(current_length_),
+              "Sequence of ", tokens.size(), " tokens does not fit in the current length ", current_length_);
+
+  gsl::span<int32_t> sequence = sequences[current_sequences_buffer].subspan(SafeInt<size_t>(beam_index) * max_length_,
+                                                                            static_cast<gsl::index>(current_length_));
+  const size_t padding = sequence.size() - tokens.size();
+  std::fill_n(sequence.begin(), padding, pad_token_id);
+  gsl::copy(tokens, sequence.subspan(padding));
+}
+
 }  // namespace transformers
 }  // namespace contrib
 }  // namespace onnxruntime
@@ -44,6 +44,13 @@ class Sequences : public ISequences {
 
   void AfterDeviceAppendedNextToken();
 
+  // Change the length of all sequences, keeping their last tokens. A sequence is truncated at the beginning
+  // when it gets shorter, and padded at the beginning when it gets longer.
+  void ResizeSequences(int sequence_length, int32_t pad_token_id);
+
+  // Replace the sequence of a given beam index with tokens padded at the beginning to the current length.
+  void ResetSequence(int beam_index, gsl::span<const int32_t> tokens, int32_t pad_token_id);
+
  private:
   // Two buffers of shape (batch_size, num_beams, max_seq_length) to store sequences.
   // At each time, there is only one buffer is active. The other one will be active in next token.
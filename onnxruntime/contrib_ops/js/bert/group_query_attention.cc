@@ -16,7 +16,8 @@ ONNX_OPERATOR_KERNEL_EX(
     1,
     kJsExecutionProvider,
     (*KernelDefBuilder::Create())
-        .TypeConstraint("T", JsepSupportedFloatTypes()),
+        .TypeConstraint("T", JsepSupportedFloatTypes())
+        .TypeConstraint("T_CACHE", JsepSupportedFloatTypes()),
     GroupQueryAttention);
 
 }  // namespace js
@@ -231,12 +231,53 @@ void ThreadPoolProfiler::LogRun(int thread_idx) {
   }
 }
 
+void ThreadPoolProfiler::LogSpinStart(int thread_idx) {
+  if (enabled_) {
+    child_thread_stats_[thread_idx].spin_start_point_ = Clock::now();
+  }
+}
+
+void ThreadPoolProfiler::LogSpinEnd(int thread_idx, bool found_work) {
+  if (enabled_) {
+    auto& stat = child_thread_stats_[thread_idx];
+    // profiling may have been started while the thread was spinning
+    if (stat.spin_start_point_ == onnxruntime::TimePoint{}) {
+      return;
+    }
+    stat.spin_us_ += TimeDiffMicroSeconds(stat.spin_start_point_, Clock::now());
+    stat.spin_start_point_ = {};
+    if (found_work) {
+      stat.num_spin_hit_++;
+    } else {
+      stat.num_spin_miss_++;
+    }
+  }
+}
+
+void ThreadPoolProfiler::LogBlock(int thread_idx) {
+  if (enabled_) {
+    child_thread_stats_[thread_idx].num_block_++;
+  }
+}
+
+void ThreadPoolProfiler::LogSpinLimit(int thread_idx, std::chrono::nanoseconds spin_limit) {
+  if (enabled_) {
+    child_thread_stats_[thread_idx].spin_limit_us_ =
+        std::chrono::duration_cast<std::chrono::microseconds>(spin_limit).count();
+  }
+}
+
 std::string ThreadPoolProfiler::DumpChildThreadStat() {
   std::stringstream ss;
   for (int i = 0; i < num_threads_; ++i) {
     ss << "\"" << child_thread_stats_[i].thread_id_ << "\": {"
        << "\"num_run\": " << child_thread_stats_[i].num_run_ << ", "
-       << "\"core\": " << child_thread_stats_[i].core_ << "}"
+       << "\"core\": " << child_thread_stats_[i].core_ << ", "
+       << "\"num_spin_hit\": " << child_thread_stats_[i].num_spin_hit_ << ", "
+       << "\"num_spin_miss\": " << child_thread_stats_[i].num_spin_miss_ << ", "
+       << "\"num_block\": " << child_thread_stats_[i].num_block_ << ", "
+       << "\"spin_us\": " << child_thread_stats_[i].spin_us_ << ", "
+       << "\"spin_limit_us\": " << child_thread_stats_[i].spin_limit_us_ << "}"
        << (i == num_threads_ - 1 ? "" : ",");
   }
   return ss.str();
@@ -390,6 +431,11 @@ ThreadPool::ThreadPool(Env* env,
       assert(thread_options_.affinities.size() >= size_t(threads_to_create));
     }
 
+    if (!thread_options_.numa_nodes.empty()) {
+      thread_options_.numa_nodes.erase(thread_options_.numa_nodes.begin());
+      assert(thread_options_.numa_nodes.size() >= size_t(threads_to_create));
+    }
+
     extended_eigen_threadpool_ =
         std::make_unique<ThreadPoolTempl<Env> >(name,
                                                 threads_to_create,
@@ -650,6 +696,14 @@ int ThreadPool::DegreeOfParallelism(const concurrency::ThreadPool* tp) {
   }
 }
 
+size_t ThreadPool::QueueDepth(const concurrency::ThreadPool* tp) {
+  if (tp && tp->underlying_threadpool_) {
+    return tp->underlying_threadpool_->QueueDepth();
+  }
+
+  return 0;
+}
+
 void ThreadPool::StartProfiling(concurrency::ThreadPool* tp) {
   if (tp) {
     tp->StartProfiling();
@@ -1923,7 +1923,9 @@ class PlannerImpl {
             break;
           }
         }
-        if (is_all_consumer_same_stream) {
+        // with parallel execution, the consumers on a stream are not necessarily run in the order of the stream
+        // (e.g. by the dataflow executor), so always use ref counting.
+        if (is_all_consumer_same_stream && !context_->IsParallelExecutionEnabled()) {
           // all the consumers are on the same stream, so the first element is the last consumer int the stream.
           process_consumer(release_action_idx, ortvalue_to_consumers_map[i][0]);
         } else {
@@ -13,6 +13,7 @@
 #include "core/common/logging/logging.h"
 #include "core/common/narrow.h"
 #include "core/framework/bfc_arena.h"
+#include "core/framework/slab_arena.h"
 
 namespace onnxruntime {
 using namespace common;
@@ -43,12 +44,26 @@ AllocatorPtr CreateAllocator(const AllocatorCreationInfo& info) {
       case static_cast<int>(ArenaExtendStrategy::kNextPowerOfTwo):
         arena_extend_str = ArenaExtendStrategy::kNextPowerOfTwo;
         break;
+      case static_cast<int>(ArenaExtendStrategy::kSizeClassSlab):
+        arena_extend_str = ArenaExtendStrategy::kSizeClassSlab;
+        break;
       default:
         LOGS_DEFAULT(ERROR) << "Received invalid value of arena_extend_strategy "
                             << info.arena_cfg.arena_extend_strategy;
         return nullptr;
     }
 
+    if (arena_extend_str == ArenaExtendStrategy::kSizeClassSlab) {
+      // the slab arena stores its block headers in the allocated memory
+      if (info.use_stream_aware_arena || device_allocator->Info().device.Type() != OrtDevice::CPU) {
+        LOGS_DEFAULT(ERROR) << "arena_extend_strategy kSizeClassSlab is only supported for CPU memory "
+                            << "without a stream aware arena.";
+        return nullptr;
+      }
+
+      return AllocatorPtr(std::make_unique<SlabArena>(std::move(device_allocator), max_mem));
+    }
+
     if (info.use_stream_aware_arena) {
 #ifdef ORT_ENABLE_STREAM
       return AllocatorPtr(
@@ -10,6 +10,9 @@ namespace onnxruntime {
 enum class ArenaExtendStrategy : int32_t {
   kNextPowerOfTwo = 0,
   kSameAsRequested,
+  // Use a SlabArena with per-thread caches over fixed size classes instead of a BFCArena.
+  // Only supported for CPU accessible memory.
+  kSizeClassSlab,
 };
 
 }  // namespace onnxruntime
@@ -0,0 +1,264 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "core/framework/dataflow_executor.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "core/common/inlined_containers.h"
+#include "core/framework/sequential_executor.h"
+#include "core/framework/session_state.h"
+#include "core/framework/stream_execution_context.h"
+#include "core/graph/graph_viewer.h"
+#include "core/platform/threadpool.h"
+
+namespace onnxruntime {
+
+namespace {
+
+constexpr size_t kNoNode = std::numeric_limits<size_t>::max();
+
+// the dataflow plan only contains a single stream
+constexpr size_t kStreamIdx = 0;
+
+Status ExecuteDataflowNode(StreamExecutionContext& ctx, SessionScope& session_scope, const bool& terminate_flag,
+                           NodeIndex node_index) {
+  if (terminate_flag) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, FAIL, "Exiting due to terminate flag being set to true.");
+  }
+
+  Status status;
+  ORT_TRY {
+    status = ExecuteKernel(ctx, node_index, kStreamIdx, terminate_flag, session_scope);
+  }
+  ORT_CATCH(const std::exception& ex) {
+    ORT_HANDLE_EXCEPTION([&]() {
+      status = ORT_MAKE_STATUS(ONNXRUNTIME, RUNTIME_EXCEPTION, ex.what());
+    });
+  }
+  return status;
+}
+
+// State of a single execution of the dataflow plan.
+// It is shared with the tasks scheduled on the thread pool. Such a task may only start running after the execution
+// has completed, in which case it finds the ready list empty and returns without touching the execution context.
+class DataflowRun : public std::enable_shared_from_this<DataflowRun> {
+ public:
+  DataflowRun(StreamExecutionContext& ctx, SessionScope& session_scope, const bool& terminate_flag,
+              concurrency::ThreadPool* tp)
+      : ctx_(ctx),
+        session_scope_(session_scope),
+        terminate_flag_(terminate_flag),
+        tp_(tp),
+        nodes_(ctx.GetSessionState().GetExecutionPlan()->dataflow_nodes),
+        pending_dependencies_(std::make_unique<std::atomic_int[]>(nodes_.size())) {
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      pending_dependencies_[i].store(nodes_[i].num_dependencies, std::memory_order_relaxed);
+    }
+  }
+
+  ORT_DISALLOW_COPY_ASSIGNMENT_AND_MOVE(DataflowRun);
+
+  // Run all the nodes and wait for them to complete, or for the first failure.
+  Status Execute() {
+    const auto& roots = ctx_.GetSessionState().GetExecutionPlan()->dataflow_roots;
+    PublishReadyNodes(roots);
+    ProcessReadyNodes(/*wait_for_completion*/ true);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return status_;
+  }
+
+ private:
+  // Run nodes from the ready list until it is empty. If wait_for_completion is true, keep waiting for nodes to
+  // become ready until no node is running anymore.
+  void ProcessReadyNodes(bool wait_for_completion) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      if (!ready_.empty()) {
+        const size_t position = ready_.back();
+        ready_.pop_back();
+        ++num_running_;
+        lock.unlock();
+
+        RunFrom(position);
+
+        lock.lock();
+        if (--num_running_ == 0 && ready_.empty()) {
+          cv_.notify_all();
+        }
+        continue;
+      }
+
+      if (!wait_for_completion || num_running_ == 0) {
+        return;
+      }
+
+      cv_.wait(lock);
+    }
+  }
+
+  // Run the node at `position`, then keep going with one of the successors it made ready.
+  void RunFrom(size_t position) {
+    InlinedVector<size_t> newly_ready;
+    while (position != kNoNode && !failed_.load(std::memory_order_relaxed)) {
+      const auto& node = nodes_[position];
+      Status status = ExecuteDataflowNode(ctx_, session_scope_, terminate_flag_, node.node_index);
+      if (!status.IsOK()) {
+        SetFailed(std::move(status));
+        return;
+      }
+
+      position = kNoNode;
+      newly_ready.clear();
+      for (size_t successor : node.successors) {
+        // acquire the outputs of all the producers of the successor, release ours
+        if (pending_dependencies_[successor].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+          if (position == kNoNode) {
+            position = successor;
+          } else {
+            newly_ready.push_back(successor);
+          }
+        }
+      }
+
+      if (!newly_ready.empty()) {
+        PublishReadyNodes(newly_ready);
+      }
+    }
+  }
+
+  void PublishReadyNodes(gsl::span<const size_t> positions) {
+    if (positions.empty()) {
+      return;
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (failed_.load(std::memory_order_relaxed)) {
+        return;
+      }
+      ready_.insert(ready_.end(), positions.begin(), positions.end());
+    }
+
+    // wake up the thread waiting for the completion of the run so it helps as well
+    cv_.notify_one();
+    for (size_t i = 0; i < positions.size(); ++i) {
+      concurrency::ThreadPool::Schedule(tp_, [run = shared_from_this()]() {
+        run->ProcessReadyNodes(/*wait_for_completion*/ false);
+      });
+    }
+  }
+
+  void SetFailed(Status status) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (status_.IsOK()) {
+      status_ = std::move(status);
+    }
+    failed_.store(true, std::memory_order_relaxed);
+    // the nodes that are ready will not be run
+    ready_.clear();
+  }
+
+  StreamExecutionContext& ctx_;
+  SessionScope& session_scope_;
+  const bool& terminate_flag_;
+  concurrency::ThreadPool* const tp_;
+  const std::vector<SequentialExecutionPlan::DataflowNode>& nodes_;
+  std::unique_ptr<std::atomic_int[]> pending_dependencies_;
+  std::atomic<bool> failed_{false};
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::vector<size_t> ready_;  // GUARDED_BY(mutex_)
+  size_t num_running_ = 0;     // GUARDED_BY(mutex_)
+  Status status_;              // GUARDED_BY(mutex_)
+};
+
+}  // namespace
+
+bool BuildDataflowPlan(const GraphViewer& graph_viewer, SequentialExecutionPlan& plan) {
+  if (plan.execution_plan.size() != 1 || plan.execution_plan[0] == nullptr) {
+    return false;
+  }
+
+  const auto& logic_stream = *plan.execution_plan[0];
+  if (logic_stream.device_.Type() != OrtDevice::CPU) {
+    return false;
+  }
+
+  // A single stream plan has exactly one kernel launch per node. Anything else would be synchronization with
+  // another stream, which the dataflow executor does not handle.
+  const auto& steps = logic_stream.steps_;
+  if (steps.size() != static_cast<size_t>(graph_viewer.NumberOfNodes())) {
+    return false;
+  }
+
+  std::vector<size_t> node_to_position(static_cast<size_t>(graph_viewer.MaxNodeIndex()), kNoNode);
+  std::vector<SequentialExecutionPlan::DataflowNode> nodes(steps.size());
+  for (size_t i = 0; i < steps.size(); ++i) {
+    const NodeIndex node_index = steps[i]->GetNodeIndex();
+    if (node_index >= node_to_position.size() || node_to_position[node_index] != kNoNode ||
+        graph_viewer.GetNode(node_index) == nullptr) {
+      return false;
+    }
+
+    node_to_position[node_index] = i;
+    nodes[i].node_index = node_index;
+  }
+
+  std::vector<size_t> roots;
+  InlinedHashSet<size_t> producers;
+  for (size_t i = 0; i < nodes.size(); ++i) {
+    const Node& node = *graph_viewer.GetNode(nodes[i].node_index);
+
+    // the input edges cover explicit and implicit inputs as well as control dependencies
+    producers.clear();
+    for (auto it = node.InputEdgesBegin(), end = node.InputEdgesEnd(); it != end; ++it) {
+      const NodeIndex producer_index = it->GetNode().Index();
+      const size_t producer = producer_index < node_to_position.size() ? node_to_position[producer_index] : kNoNode;
+      if (producer == kNoNode || !producers.insert(producer).second) {
+        continue;
+      }
+
+      // the steps are in topological order
+      if (producer >= i) {
+        return false;
+      }
+
+      nodes[producer].successors.push_back(i);
+    }
+
+    nodes[i].num_dependencies = static_cast<int>(producers.size());
+    if (producers.empty()) {
+      roots.push_back(i);
+    }
+  }
+
+  plan.dataflow_nodes = std::move(nodes);
+  plan.dataflow_roots = std::move(roots);
+  return true;
+}
+
+Status RunDataflowPlan(StreamExecutionContext& ctx, SessionScope& session_scope, const bool& terminate_flag) {
+  const auto& session_state = ctx.GetSessionState();
+  auto* tp = session_state.GetThreadPool();
+
+  if (concurrency::ThreadPool::DegreeOfParallelism(tp) < 2) {
+    for (const auto& node : session_state.GetExecutionPlan()->dataflow_nodes) {
+      ORT_RETURN_IF_ERROR(ExecuteDataflowNode(ctx, session_scope, terminate_flag, node.node_index));
+    }
+
+    return Status::OK();
+  }
+
+  auto run = std::make_shared<DataflowRun>(ctx, session_scope, terminate_flag, tp);
+  return run->Execute();
+}
+
+}  // namespace onnxruntime
@@ -0,0 +1,32 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include "core/common/status.h"
+#include "core/framework/sequential_execution_plan.h"
+
+namespace onnxruntime {
+class GraphViewer;
+class SessionScope;
+class StreamExecutionContext;
+
+// Populate plan.dataflow_nodes and plan.dataflow_roots from the steps of the plan and the edges of the graph.
+// Returns false and leaves the plan unchanged if the plan can not be executed by the dataflow executor,
+// i.e. if it is not a single CPU stream of kernel launches.
+bool BuildDataflowPlan(const GraphViewer& graph_viewer, SequentialExecutionPlan& plan);
+
+// Execute the nodes in plan.dataflow_nodes of the session state of 'ctx'.
+//
+// A node is dispatched as soon as all the nodes it depends on have completed. The thread that completes a node
+// continues with the first of the successors that became ready, and publishes the others to a ready list of
+// this run. For every published node a task is scheduled on the intra-op thread pool, so the per-thread queues and
+// the work stealing of the pool spread the ready nodes over the idle threads. The calling thread takes nodes from
+// the ready list as well until the whole plan completes, so a run issued from a thread of the intra-op thread pool
+// itself (e.g. by RunAsync) can not deadlock.
+//
+// Falls back to executing the nodes in plan order on the calling thread if the intra-op thread pool can not run
+// anything concurrently.
+Status RunDataflowPlan(StreamExecutionContext& ctx, SessionScope& session_scope, const bool& terminate_flag);
+
+}  // namespace onnxruntime
@@ -3,6 +3,7 @@
 
 #include "core/framework/execution_frame.h"
 
+#include <algorithm>
 #include <sstream>
 
 #include "core/framework/mem_pattern_planner.h"
@@ -406,11 +407,16 @@ ExecutionFrame::ExecutionFrame(gsl::span<const int> feed_mlvalue_idxs, gsl::span
 
     // if there are some traditional ml value type in inputs disable the memory pattern optimization.
     if (all_tensors) {
-      mem_patterns_ = session_state.GetMemoryPatternGroup(feeds, feed_mlvalue_idxs, inferred_shapes_);
+      mem_pattern_entry_ = session_state.GetMemoryPatternGroup(feeds, feed_mlvalue_idxs, planner_size_hints_);
       // if no existing patterns, generate one in this execution frame
-      if (!mem_patterns_) {
+      if (!mem_pattern_entry_) {
         planner_.emplace(*session_state.GetExecutionPlan());
       } else {
+        mem_patterns_ = &mem_pattern_entry_->patterns;
+        if (!mem_pattern_entry_->inferred_shapes.empty()) {
+          inferred_shapes_ = &mem_pattern_entry_->inferred_shapes;
+        }
+
         // pre-allocate the big chunk requested in memory pattern.
         // all the internal kernel's input/output tensors will be allocated on these buffer.
         buffers_.reserve(mem_patterns_->locations.size());
@@ -551,12 +557,16 @@ Status ExecutionFrame::AllocateMLValueTensorSelfOwnBufferHelper(OrtValue& ort_va
       if (block) {
         auto it = buffers_.find(location);
         if (it != buffers_.end()) {
-          // if the block is not correct, log message then fall back to default behavior
-          if (block->size_ == size) {
+          // if the block is not correct, log message then fall back to default behavior.
+          // the pattern of a bucket of input shapes has blocks for the largest sizes seen in the bucket.
+          if (block->size_ == size || (size < block->size_ && session_state_.GetMemoryPatternShapeBucketing())) {
             void* buffer = it->second.get();
             auto status = AllocateTensorWithPreAllocateBufferHelper(
                 ort_value, static_cast<void*>(static_cast<char*>(buffer) + block->offset_), element_type, location,
                 shape);
+            if (auto* metrics = session_state_.GetMetrics(); metrics != nullptr) {
+              metrics->RecordAllocation(size, /*from_memory_pattern*/ true);
+            }
             return status;
           } else {
             // the block size may vary especially if the model has NonZero ops, or different sequence lengths are
@@ -567,6 +577,10 @@ Status ExecutionFrame::AllocateMLValueTensorSelfOwnBufferHelper(OrtValue& ort_va
                                                    << ", block in memory pattern size is: " << block->size_
                                                    << " but the actual size is: " << size
                                                    << ", fall back to default allocation behavior";
+            if (size > block->size_ && session_state_.GetMemoryPatternShapeBucketing()) {
+              std::lock_guard<std::mutex> lock(mtx_);
+              outgrown_blocks_.insert_or_assign(ort_value_index, size);
+            }
           }
         }
         // else { we couldn't allocate the large block for the buffer so we didn't insert an entry }
@@ -599,6 +613,10 @@ Status ExecutionFrame::AllocateMLValueTensorSelfOwnBufferHelper(OrtValue& ort_va
     Tensor::InitOrtValue(element_type, shape, std::move(alloc), ort_value);
   }
 
+  if (auto* metrics = session_state_.GetMetrics(); metrics != nullptr) {
+    metrics->RecordAllocation(size, /*from_memory_pattern*/ false);
+  }
+
   // trace the memory allocation.
   // don't trace the memory allocation on string tensors, as it need
   // placement new, we don't support it in memory pattern optimization.
@@ -901,6 +919,13 @@ void ExecutionFrame::TraceAllocate(int ort_value_idx, size_t size) {
         allocation_plan.alloc_kind == AllocKind::kAllocatedExternally) {
       return;
     }
+    if (planner_size_hints_) {
+      auto hint = planner_size_hints_->find(ort_value_idx);
+      if (hint != planner_size_hints_->end()) {
+        size = std::max(size, hint->second);
+      }
+    }
+
     auto status = planner_->TraceAllocation(ort_value_idx, size);
     if (!status.IsOK()) {
       LOGS(session_state_.Logger(), WARNING) << "TraceAllocation for ort_value_idx=" << ort_value_idx
@@ -945,6 +970,14 @@ Status ExecutionFrame::GeneratePatterns(MemoryPatternGroup& out) {
   return planner_->GeneratePatterns(out);
 }
 
+void ExecutionFrame::ReplaceMemoryPatternIfOutgrown(gsl::span<const OrtValue> feeds) {
+  std::lock_guard<std::mutex> lock(mtx_);
+  if (mem_pattern_entry_ && !outgrown_blocks_.empty()) {
+    session_state_.ReplaceMemoryPatternGroup(feeds, *mem_pattern_entry_, outgrown_blocks_);
+    outgrown_blocks_.clear();
+  }
+}
+
 bool ExecutionFrame::TryGetInferredShape(int index, TensorShape& shape) const {
   // NodeArg index to OrtValue index.
   int ort_value_idx = GetNodeIdxToMLValueIdx(index);
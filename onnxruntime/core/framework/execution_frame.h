@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -10,6 +11,7 @@
 #include "core/common/logging/logging.h"
 #include "core/common/status.h"
 #include "core/framework/iexecutor.h"
+#include "core/framework/mem_pattern_cache.h"
 #include "core/framework/ort_value.h"
 #include "core/framework/node_index_info.h"
 #include "core/framework/ort_value_pattern_planner.h"
@@ -168,6 +170,10 @@ class ExecutionFrame final : public IExecutionFrame {
     return planner_.has_value();
   }
 
+  // Replace the memory pattern used by this frame if a value did not fit into its block.
+  // Only applies if the memory patterns are shared by buckets of input shapes.
+  void ReplaceMemoryPatternIfOutgrown(gsl::span<const OrtValue> feeds);
+
 #if !defined(ORT_MINIMAL_BUILD)
   std::optional<size_t> GetOrtValueDynamicAllocation(int ort_value_index) const {
     auto it = ort_value_to_dynamic_allocations_size_.find(ort_value_index);
@@ -245,10 +251,19 @@ class ExecutionFrame final : public IExecutionFrame {
   // kernel's input/output tensors.
   const MemoryPatternGroup* mem_patterns_;
 
+  // The cache entry of mem_patterns_, which keeps it alive if the cache evicts it.
+  std::shared_ptr<const MemoryPatternCache::Entry> mem_pattern_entry_;
+
+  // Sizes of the values that did not fit into their block of mem_patterns_. GUARDED_BY(mtx_)
+  MemoryPatternCache::SizeHints outgrown_blocks_;
+
   // If no cached memory pattern, and we enable the memory pattern optimization
   // use this planner_ to trace the memory allocation in current executor.
   std::optional<OrtValuePatternPlanner> planner_;
 
+  // Lower bounds of the sizes traced by planner_, from the pattern it replaces.
+  std::shared_ptr<const MemoryPatternCache::SizeHints> planner_size_hints_;
+
   // Big chunks on different locations that will be used by mem_pattern.
   InlinedHashMap<OrtDevice, BufferUniquePtr> buffers_;
 
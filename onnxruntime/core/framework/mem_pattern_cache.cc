@@ -0,0 +1,117 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "core/framework/mem_pattern_cache.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+
+#include "core/common/hash_combine.h"
+#include "core/framework/tensor.h"
+
+namespace onnxruntime {
+
+static int64_t RoundUpToPowerOfTwo(int64_t dim) {
+  if (dim > (std::numeric_limits<int64_t>::max() >> 1)) {
+    return dim;
+  }
+
+  int64_t bucket = 1;
+  while (bucket < dim) {
+    bucket <<= 1;
+  }
+
+  return bucket;
+}
+
+int64_t MemoryPatternCache::CalculateKey(gsl::span<const OrtValue> tensor_inputs) const {
+  // include the rank of the inputs, so e.g. shapes {2, 3} and {2}, {3} result in different keys
+  size_t key = 0;
+  for (const auto& input : tensor_inputs) {
+    const auto dims = input.Get<Tensor>().Shape().GetDims();
+    HashCombine(dims.size(), key);
+    for (int64_t dim : dims) {
+      HashCombine(bucket_shapes_ && dim > 0 ? RoundUpToPowerOfTwo(dim) : dim, key);
+    }
+  }
+
+  return static_cast<int64_t>(key);
+}
+
+std::shared_ptr<const MemoryPatternCache::Entry> MemoryPatternCache::Find(int64_t key) {
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    ++num_misses_;
+    return nullptr;
+  }
+
+  ++num_hits_;
+  lru_.splice(lru_.begin(), lru_, it->second);
+  return it->second->second;
+}
+
+std::shared_ptr<const MemoryPatternCache::Entry> MemoryPatternCache::Insert(int64_t key, Entry entry) {
+  auto it = entries_.find(key);
+  if (it != entries_.end()) {
+    // a concurrent run traced the pattern first. keep it, as it may already be used.
+    return it->second->second;
+  }
+
+  lru_.emplace_front(key, std::make_shared<const Entry>(std::move(entry)));
+  entries_.emplace(key, lru_.begin());
+  size_hints_.erase(key);
+
+  if (capacity_ > 0 && lru_.size() > capacity_) {
+    entries_.erase(lru_.back().first);
+    lru_.pop_back();
+    ++num_evictions_;
+  }
+
+  return lru_.front().second;
+}
+
+void MemoryPatternCache::Replace(int64_t key, const Entry& used_entry, const SizeHints& required_sizes) {
+  auto hints = std::make_shared<SizeHints>(required_sizes);
+  auto add_hint = [&hints](int ort_value_idx, size_t size) {
+    auto result = hints->emplace(ort_value_idx, size);
+    if (!result.second) {
+      result.first->second = std::max(result.first->second, size);
+    }
+  };
+
+  for (const auto& pattern : used_entry.patterns.patterns) {
+    for (const auto& [ort_value_idx, block] : pattern.GetPatternsMap()) {
+      add_hint(ort_value_idx, block.size_);
+    }
+  }
+
+  // another run may have required larger sizes already
+  auto hints_it = size_hints_.find(key);
+  if (hints_it != size_hints_.end()) {
+    for (const auto& [ort_value_idx, size] : *hints_it->second) {
+      add_hint(ort_value_idx, size);
+    }
+  }
+
+  auto it = entries_.find(key);
+  if (it != entries_.end() && it->second->second.get() == &used_entry) {
+    lru_.erase(it->second);
+    entries_.erase(it);
+  }
+
+  // the hints of a key are dropped once its pattern is added, so they are only bounded for keys that are not run
+  // again
+  if (capacity_ > 0 && hints_it == size_hints_.end() && size_hints_.size() >= capacity_) {
+    size_hints_.erase(size_hints_.begin());
+  }
+
+  size_hints_.insert_or_assign(key, std::move(hints));
+}
+
+std::shared_ptr<const MemoryPatternCache::SizeHints> MemoryPatternCache::GetSizeHints(int64_t key) const {
+  auto it = size_hints_.find(key);
+  return it == size_hints_.end() ? nullptr : it->second;
+}
+
+}  // namespace onnxruntime
@@ -0,0 +1,90 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <utility>
+
+#include <gsl/gsl>
+
+#include "core/common/common.h"
+#include "core/common/inlined_containers.h"
+#include "core/framework/mem_pattern.h"
+#include "core/framework/ort_value.h"
+#include "core/framework/tensor_shape.h"
+
+namespace onnxruntime {
+
+/**
+ * Cache of the memory patterns of a session state, keyed by the shapes of the inputs of a run.
+ *
+ * If shape bucketing is enabled, every dimension of the inputs is rounded up to the next power of two before the key
+ * is computed, so all the runs with e.g. a sequence length between 65 and 128 share a single pattern. A block of such
+ * a pattern may be used for any tensor that fits into it. When a run finds a tensor that does not fit, the pattern is
+ * replaced by one that is traced with the sizes of the previous pattern as lower bounds, so the pattern of a bucket
+ * grows to the largest sizes seen for the bucket and then covers every run of it with a single allocation per device.
+ *
+ * The number of patterns can be bounded, in which case the least recently used one is evicted. The entries are
+ * reference counted, so an entry that is evicted while it is used by an execution frame stays valid.
+ *
+ * The class is not thread safe.
+ */
+class MemoryPatternCache {
+ public:
+  struct Entry {
+    MemoryPatternGroup patterns;
+    // shapes of the values resolved from the input shapes. only produced by training builds.
+    InlinedHashMap<int, TensorShape> inferred_shapes;
+  };
+
+  // lower bounds of the sizes of the values when tracing a new pattern, keyed by OrtValue index
+  using SizeHints = InlinedHashMap<int, size_t>;
+
+  // A capacity of 0 does not bound the number of patterns.
+  MemoryPatternCache(size_t capacity, bool bucket_shapes) : capacity_(capacity), bucket_shapes_(bucket_shapes) {}
+
+  ORT_DISALLOW_COPY_ASSIGNMENT_AND_MOVE(MemoryPatternCache);
+
+  bool BucketShapes() const { return bucket_shapes_; }
+
+  // Key of the pattern for a run with `tensor_inputs`. All the values must be tensors.
+  int64_t CalculateKey(gsl::span<const OrtValue> tensor_inputs) const;
+
+  // Look up the pattern for `key` and mark it as the most recently used one. Counts a hit or a miss.
+  std::shared_ptr<const Entry> Find(int64_t key);
+
+  // Add the pattern for `key` unless there already is one, and return the cached pattern.
+  std::shared_ptr<const Entry> Insert(int64_t key, Entry entry);
+
+  // Drop `used_entry` if it is still the pattern for `key`, and remember the sizes of its blocks as well as
+  // `required_sizes` as the lower bounds for the next pattern that is traced for `key`.
+  void Replace(int64_t key, const Entry& used_entry, const SizeHints& required_sizes);
+
+  // Lower bounds of the sizes for tracing the pattern for `key`, or nullptr.
+  std::shared_ptr<const SizeHints> GetSizeHints(int64_t key) const;
+
+  size_t Size() const { return entries_.size(); }
+  size_t NumHits() const { return num_hits_; }
+  size_t NumMisses() const { return num_misses_; }
+  size_t NumEvictions() const { return num_evictions_; }
+
+ private:
+  using LruList = std::list<std::pair<int64_t, std::shared_ptr<const Entry>>>;
+
+  const size_t capacity_;
+  const bool bucket_shapes_;
+
+  // most recently used first
+  LruList lru_;
+  InlinedHashMap<int64_t, LruList::iterator> entries_;
+  InlinedHashMap<int64_t, std::shared_ptr<const SizeHints>> size_hints_;
+
+  size_t num_hits_ = 0;
+  size_t num_misses_ = 0;
+  size_t num_evictions_ = 0;
+};
+
+}  // namespace onnxruntime
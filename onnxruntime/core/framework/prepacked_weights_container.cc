@@ -2,6 +2,10 @@
 // Licensed under the MIT License.
 
 #include "core/framework/prepacked_weights_container.h"
+
+#include <algorithm>
+#include <cstring>
+
 #include "core/framework/allocator_utils.h"
 #include "core/graph/graph.h"
 
@@ -61,6 +65,80 @@ size_t PrepackedWeightsContainer::GetNumberOfElements() const {
   return prepacked_weights_map_.size();
 }
 
+AllocatorPtr SharedPrepackedWeightsStore::GetAllocator() {
+  std::lock_guard<std::mutex> l(mutex_);
+  if (allocator_ == nullptr) {
+    // the buffers are freed with the last session that uses them, so they can't come from the arena of a session
+    AllocatorCreationInfo device_info{[](int) { return std::make_unique<CPUAllocator>(); },
+                                      0, false};
+    allocator_ = CreateAllocator(device_info);
+  }
+
+  return allocator_;
+}
+
+static bool HaveSameContent(const PrePackedWeights& lhs, const PrePackedWeights& rhs) {
+  if (lhs.buffer_sizes_ != rhs.buffer_sizes_ || lhs.buffers_.size() != rhs.buffers_.size()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < lhs.buffers_.size(); ++i) {
+    if (lhs.buffer_sizes_[i] > 0 &&
+        std::memcmp(lhs.buffers_[i].get(), rhs.buffers_[i].get(), lhs.buffer_sizes_[i]) != 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+std::shared_ptr<const PrePackedWeights> SharedPrepackedWeightsStore::GetOrAddWeight(const std::string& key,
+                                                                                    PrePackedWeights&& packed_weight,
+                                                                                    bool& is_cached) {
+  std::lock_guard<std::mutex> l(mutex_);
+  auto it = weights_.find(key);
+  if (it != weights_.end()) {
+    auto cached = it->second.lock();
+    if (cached != nullptr) {
+      if (HaveSameContent(*cached, packed_weight)) {
+        is_cached = true;
+        return cached;
+      }
+
+      // hash collision. the weight is used without being shared.
+      is_cached = false;
+      return std::make_shared<const PrePackedWeights>(std::move(packed_weight));
+    }
+  }
+
+  auto weight = std::make_shared<const PrePackedWeights>(std::move(packed_weight));
+  weights_.insert_or_assign(key, weight);
+  is_cached = false;
+
+  if (weights_.size() >= sweep_threshold_) {
+    RemoveExpiredWeights();
+    sweep_threshold_ = std::max(kMinSweepThreshold, 2 * weights_.size());
+  }
+
+  return weight;
+}
+
+void SharedPrepackedWeightsStore::RemoveExpiredWeights() {
+  for (auto it = weights_.begin(); it != weights_.end();) {
+    if (it->second.expired()) {
+      it = weights_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+size_t SharedPrepackedWeightsStore::GetNumberOfElements() const {
+  std::lock_guard<std::mutex> l(mutex_);
+  return static_cast<size_t>(std::count_if(weights_.begin(), weights_.end(),
+                                           [](const auto& entry) { return !entry.second.expired(); }));
+}
+
 void PrepackedWeightsForGraph::InsertPrepackedWeights(const std::string& key, PrePackedWeights&& packed_weight) {
   // We may have duplicate entries mapped from disk if the same weight is pre-packed from subgraphs and
   // up the tree by the same kernel with the same result. The map prevents this from happening.
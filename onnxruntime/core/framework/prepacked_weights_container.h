@@ -8,6 +8,7 @@
 #include "prepacked_weights.h"
 
 #include <cstdint>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
@@ -73,6 +74,49 @@ class PrepackedWeightsContainer final {
   std::unordered_map<std::string, PrePackedWeights> prepacked_weights_map_;
 };
 
+/// <summary>
+/// Store of pre-packed weights that is owned by the environment and shared by all the sessions that opt in with
+/// "session.use_env_prepacked_weights".
+///
+/// Unlike PrepackedWeightsContainer it is not limited to initializers that the user shares explicitly. The weights
+/// are keyed by the op type and the hash of the pre-packed buffers, so the sessions of the same model or of models
+/// that share weights use a single copy of each pre-packed weight, regardless of the layout the kernel packs to.
+/// The buffers of a weight are compared as well on a key match, so a hash collision can never hand the wrong weight
+/// to a kernel.
+///
+/// The entries are reference counted by the sessions that use them and are freed with the last of these sessions.
+/// The class is thread safe.
+/// </summary>
+class SharedPrepackedWeightsStore final {
+ public:
+  SharedPrepackedWeightsStore() = default;
+
+  ORT_DISALLOW_COPY_ASSIGNMENT_AND_MOVE(SharedPrepackedWeightsStore);
+
+  // Returns the allocator the kernels use to pre-pack the weights that are added to the store.
+  AllocatorPtr GetAllocator();
+
+  // Returns the weight stored for `key` if it has the same content as `packed_weight`, and `packed_weight` is
+  // released. Otherwise `packed_weight` is stored and returned. `is_cached` indicates which one was returned.
+  std::shared_ptr<const PrePackedWeights> GetOrAddWeight(const std::string& key, PrePackedWeights&& packed_weight,
+                                                         /*out*/ bool& is_cached);
+
+  // Returns the number of weights that are used by at least one session.
+  size_t GetNumberOfElements() const;
+
+ private:
+  // remove the entries of the weights that no session uses any more
+  void RemoveExpiredWeights();
+
+  mutable std::mutex mutex_;
+  AllocatorPtr allocator_;
+  std::unordered_map<std::string, std::weak_ptr<const PrePackedWeights>> weights_;
+  // size of weights_ at which the expired entries are removed next
+  size_t sweep_threshold_{kMinSweepThreshold};
+
+  static constexpr size_t kMinSweepThreshold = 64;
+};
+
 // Maps a pre-packed weight blob key to PrepackedWeights instance
 using PrepackedKeyToBlobMap = std::unordered_map<std::string, PrePackedWeights>;
 
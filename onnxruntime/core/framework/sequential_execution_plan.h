@@ -165,6 +165,21 @@ struct SequentialExecutionPlan : public ExecutionPlanBase {
 
   size_t num_barriers{0};
 
+  // Node level dependency graph used by the dataflow executor to run independent nodes concurrently.
+  // Only populated if dataflow execution is enabled and the plan consists of a single CPU stream.
+  struct DataflowNode {
+    NodeIndex node_index;
+    // number of distinct nodes in the plan that must complete before this node can run
+    int num_dependencies{0};
+    // positions in dataflow_nodes of the nodes that depend on this node
+    InlinedVector<size_t> successors;
+  };
+
+  // in the order of the steps in execution_plan[0], which is a topological order.
+  std::vector<DataflowNode> dataflow_nodes;
+  // positions in dataflow_nodes of the nodes without dependencies.
+  std::vector<size_t> dataflow_roots;
+
 #ifdef ENABLE_TRAINING
   InlinedVector<NodeIndex> node_execution_order_in_training;
   InlinedHashMap<NodeIndex, size_t> node_index_2_toposort_index;
@@ -10,6 +10,7 @@
 #include "core/common/common.h"
 #include "core/common/logging/logging.h"
 #include "core/framework/allocation_planner.h"
+#include "core/framework/dataflow_executor.h"
 #include "core/framework/execution_frame.h"
 #include "core/framework/resource_accountant.h"
 #include "core/framework/stream_execution_context.h"
@@ -226,7 +227,12 @@ class SessionScope {
 #endif
 
     if (session_state_.Profiler().IsEnabled()) {
-      session_state_.Profiler().EndTimeAndRecordEvent(profiling::SESSION_EVENT, "SequentialExecutor::Execute", session_start_);
+      size_t mem_pattern_cache_hits = 0;
+      size_t mem_pattern_cache_misses = 0;
+      session_state_.GetMemoryPatternCacheStats(mem_pattern_cache_hits, mem_pattern_cache_misses);
+      session_state_.Profiler().EndTimeAndRecordEvent(profiling::SESSION_EVENT, "SequentialExecutor::Execute", session_start_,
+                                                      {{"mem_pattern_cache_hits", std::to_string(mem_pattern_cache_hits)},
+                                                       {"mem_pattern_cache_misses", std::to_string(mem_pattern_cache_misses)}});
     }
 #if !defined(ORT_MINIMAL_BUILD) && defined(ORT_MEMORY_PROFILE)
     auto& logger = session_state_.Logger();
@@ -288,7 +294,8 @@ class KernelScope {
       : session_scope_(session_scope),
         session_state_(session_scope_.session_state_),
         kernel_context_(kernel_context),
-        kernel_(kernel)
+        kernel_(kernel),
+        metrics_(session_state_.GetMetrics())
 #ifdef CONCURRENCY_VISUALIZER
         ,
         span_(session_scope_.series_, "%s.%d", kernel_.Node().OpType().c_str(), kernel_.Node().Index())
@@ -344,6 +351,10 @@ class KernelScope {
     node_compute_range_.Begin();
 #endif
 
+    if (metrics_ != nullptr) {
+      metrics_begin_time_ = std::chrono::steady_clock::now();
+    }
+
     if (session_state_.Profiler().IsEnabled()) {
       auto& node = kernel.Node();
       node_name_ = node.Name().empty() ? MakeString(node.OpType(), "_", node.Index()) : node.Name();
@@ -363,6 +374,13 @@ class KernelScope {
     node_compute_range_.End();
 #endif
 
+    if (metrics_ != nullptr) {
+      const auto elapsed = std::chrono::steady_clock::now() - metrics_begin_time_;
+      metrics_->RecordNodeLatency(kernel_.Node().Index(),
+                                  static_cast<uint64_t>(
+                                      std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
     if (session_state_.Profiler().IsEnabled()) {
       auto& profiler = session_state_.Profiler();
       std::string output_type_shape_;
@@ -411,6 +429,8 @@ class KernelScope {
   std::string node_name_;
   OpKernelContextInternal& kernel_context_;
   const OpKernel& kernel_;
+  SessionMetrics* const metrics_;
+  std::chrono::steady_clock::time_point metrics_begin_time_;
 
   size_t input_activation_sizes_{};
   size_t input_parameter_sizes_{};
@@ -633,23 +653,29 @@ onnxruntime::Status ExecuteThePlan(const SessionState& session_state, gsl::span<
 
   SessionScope session_scope(session_state, ctx.GetExecutionFrame());
 
-  auto* tp = single_thread_mode ? nullptr : session_state.GetInterOpThreadPool();
-
-  for (size_t i = 0; i < execution_plan->execution_plan.size(); ++i) {
-    if (execution_plan->execution_plan[i]->steps_.empty()) {
-      // execution context is initialized with number of valid streams
-      // for invalid stream (0 steps), it doesn't count in number of tasks
-      // so don't need to invoke CompleteTask here
-      // ctx.CompleteTask();
-    } else {
-      concurrency::ThreadPool::Schedule(tp, [i, &ctx, &terminate_flag, &session_scope]() {
-        RunSince(i, ctx, session_scope, terminate_flag, 0);
-      });
+  if (!execution_plan->dataflow_nodes.empty() && !only_execute_path_to_fetches) {
+    // node level parallelism on the intra-op thread pool. see BuildDataflowPlan for when this is available.
+    ORT_RETURN_IF_ERROR(RunDataflowPlan(ctx, session_scope, terminate_flag));
+  } else {
+    auto* tp = single_thread_mode ? nullptr : session_state.GetInterOpThreadPool();
+
+    for (size_t i = 0; i < execution_plan->execution_plan.size(); ++i) {
+      if (execution_plan->execution_plan[i]->steps_.empty()) {
+        // execution context is initialized with number of valid streams
+        // for invalid stream (0 steps), it doesn't count in number of tasks
+        // so don't need to invoke CompleteTask here
+        // ctx.CompleteTask();
+      } else {
+        concurrency::ThreadPool::Schedule(tp, [i, &ctx, &terminate_flag, &session_scope]() {
+          RunSince(i, ctx, session_scope, terminate_flag, 0);
+        });
+      }
     }
+
+    ctx.WaitAll();
+    ORT_RETURN_IF_ERROR(ctx.TaskStatus());
   }
 
-  ctx.WaitAll();
-  ORT_RETURN_IF_ERROR(ctx.TaskStatus());
   ORT_RETURN_IF_ERROR(ctx.GetExecutionFrame().GetOutputs(fetches));
   if (ctx.GetExecutionFrame().HasMemoryPatternPlanner()) {
     bool all_tensors = true;
@@ -665,6 +691,8 @@ onnxruntime::Status ExecuteThePlan(const SessionState& session_state, gsl::span<
       ORT_RETURN_IF_ERROR(ctx.GetExecutionFrame().GeneratePatterns(mem_patterns));
       ORT_RETURN_IF_ERROR(session_state.UpdateMemoryPatternGroupCache(feeds, std::move(mem_patterns)));
     }
+  } else if (session_state.GetMemoryPatternShapeBucketing()) {
+    ctx.GetExecutionFrame().ReplaceMemoryPatternIfOutgrown(feeds);
   }
 
   return Status::OK();
@@ -0,0 +1,87 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "core/framework/session_metrics.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace onnxruntime {
+
+// Returns floor(log2(n)) for n > 0.
+static int Log2FloorNonZero(uint64_t n) {
+#if defined(__GNUC__)
+  return 63 ^ __builtin_clzll(n);
+#elif defined(_MSC_VER) && defined(_WIN64)
+  unsigned long index;
+  _BitScanReverse64(&index, n);
+  return static_cast<int>(index);
+#else
+  int r = -1;
+  while (n > 0) {
+    ++r;
+    n >>= 1;
+  }
+  return r;
+#endif
+}
+
+size_t LatencyHistogram::BucketIndex(uint64_t latency_ns) noexcept {
+  if (latency_ns < kNumSubBuckets) {
+    return static_cast<size_t>(latency_ns);
+  }
+
+  const int exponent = Log2FloorNonZero(latency_ns);
+  if (exponent >= kMaxExponent) {
+    return kNumBuckets - 1;
+  }
+
+  // the top kSubBucketBits + 1 bits of the latency, in [kNumSubBuckets, 2 * kNumSubBuckets)
+  const uint64_t mantissa = latency_ns >> (exponent - kSubBucketBits);
+  return static_cast<size_t>((exponent - kSubBucketBits) * kNumSubBuckets + mantissa);
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(size_t index) noexcept {
+  if (index < kNumSubBuckets) {
+    return index;
+  }
+
+  const int shift = static_cast<int>(index / kNumSubBuckets) - 1;
+  const uint64_t mantissa = index % kNumSubBuckets + kNumSubBuckets;
+  return ((mantissa + 1) << shift) - 1;
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::GetSnapshot() const {
+  Snapshot snapshot;
+  for (size_t i = 0; i < kNumBuckets; ++i) {
+    snapshot.buckets[i] = buckets_[i].load(std::memory_order_relaxed);
+    snapshot.count += snapshot.buckets[i];
+  }
+
+  snapshot.sum_ns = sum_ns_.load(std::memory_order_relaxed);
+  return snapshot;
+}
+
+uint64_t LatencyHistogram::Snapshot::Percentile(double quantile) const {
+  if (count == 0) {
+    return 0;
+  }
+
+  const double clamped_quantile = std::clamp(quantile, 0.0, 1.0);
+  const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(clamped_quantile * count)));
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kNumBuckets; ++i) {
+    seen += buckets[i];
+    if (seen >= rank) {
+      return BucketUpperBound(i);
+    }
+  }
+
+  return BucketUpperBound(kNumBuckets - 1);
+}
+
+}  // namespace onnxruntime
@@ -0,0 +1,126 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "core/common/common.h"
+#include "core/graph/basic_types.h"
+
+namespace onnxruntime {
+
+/**
+ * Histogram of latencies in nanoseconds that can be recorded into concurrently without locking.
+ *
+ * The buckets are log-linear: every power of two is split into kNumSubBuckets linear buckets, so a percentile is
+ * reported with a relative error of at most 1 / kNumSubBuckets. Latencies of 2^kMaxExponent ns (~34 s) and above
+ * share the last bucket.
+ */
+class LatencyHistogram {
+ public:
+  static constexpr int kSubBucketBits = 3;
+  static constexpr uint64_t kNumSubBuckets = uint64_t{1} << kSubBucketBits;
+  static constexpr int kMaxExponent = 35;
+  static constexpr size_t kNumBuckets = (kMaxExponent - kSubBucketBits + 1) * kNumSubBuckets;
+
+  struct Snapshot {
+    uint64_t count{0};
+    uint64_t sum_ns{0};
+    std::array<uint64_t, kNumBuckets> buckets{};
+
+    // Returns the upper bound of the bucket of the `quantile` (in [0, 1]) of the latencies, or 0 if nothing was
+    // recorded.
+    uint64_t Percentile(double quantile) const;
+  };
+
+  LatencyHistogram() = default;
+
+  ORT_DISALLOW_COPY_ASSIGNMENT_AND_MOVE(LatencyHistogram);
+
+  void Record(uint64_t latency_ns) noexcept {
+    buckets_[BucketIndex(latency_ns)].fetch_add(1, std::memory_order_relaxed);
+    sum_ns_.fetch_add(latency_ns, std::memory_order_relaxed);
+  }
+
+  // The buckets are read one at a time, so a snapshot taken while latencies are recorded may miss the most recent
+  // ones, but it is always consistent with its own count.
+  Snapshot GetSnapshot() const;
+
+  static size_t BucketIndex(uint64_t latency_ns) noexcept;
+
+  // largest latency in the bucket at `index`
+  static uint64_t BucketUpperBound(size_t index) noexcept;
+
+ private:
+  std::array<std::atomic<uint64_t>, kNumBuckets> buckets_{};
+  std::atomic<uint64_t> sum_ns_{0};
+};
+
+/**
+ * Always-on metrics of a session state, which are cheap enough to be collected in production, unlike the traces of
+ * the profiler. Enabled with "session.enable_metrics".
+ *
+ * Holds a latency histogram per node, the latencies of the runs and the tensor allocations of the execution frames.
+ * All the recording is lock free.
+ */
+class SessionMetrics {
+ public:
+  explicit SessionMetrics(size_t num_nodes)
+      : num_nodes_(num_nodes), node_latencies_(std::make_unique<LatencyHistogram[]>(num_nodes)) {}
+
+  ORT_DISALLOW_COPY_ASSIGNMENT_AND_MOVE(SessionMetrics);
+
+  void RecordNodeLatency(NodeIndex node_index, uint64_t latency_ns) noexcept {
+    if (node_index < num_nodes_) {
+      node_latencies_[node_index].Record(latency_ns);
+    }
+  }
+
+  // nullptr if the node did not exist when the metrics were created
+  const LatencyHistogram* GetNodeLatency(NodeIndex node_index) const noexcept {
+    return node_index < num_nodes_ ? &node_latencies_[node_index] : nullptr;
+  }
+
+  void RecordRunLatency(uint64_t latency_ns) noexcept { run_latency_.Record(latency_ns); }
+
+  const LatencyHistogram& GetRunLatency() const noexcept { return run_latency_; }
+
+  // Records an allocation of a tensor by an execution frame, either in the buffer of the memory pattern or from the
+  // allocator of the device.
+  void RecordAllocation(size_t num_bytes, bool from_memory_pattern) noexcept {
+    if (from_memory_pattern) {
+      num_memory_pattern_allocations_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      num_dynamic_allocations_.fetch_add(1, std::memory_order_relaxed);
+      dynamic_allocation_bytes_.fetch_add(num_bytes, std::memory_order_relaxed);
+    }
+  }
+
+  uint64_t GetNumMemoryPatternAllocations() const noexcept {
+    return num_memory_pattern_allocations_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t GetNumDynamicAllocations() const noexcept {
+    return num_dynamic_allocations_.load(std::memory_order_relaxed);
+  }
+
+  uint64_t GetDynamicAllocationBytes() const noexcept {
+    return dynamic_allocation_bytes_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  const size_t num_nodes_;
+  const std::unique_ptr<LatencyHistogram[]> node_latencies_;
+  LatencyHistogram run_latency_;
+
+  std::atomic<uint64_t> num_memory_pattern_allocations_{0};
+  std::atomic<uint64_t> num_dynamic_allocations_{0};
+  std::atomic<uint64_t> dynamic_allocation_bytes_{0};
+};
+
+}  // namespace onnxruntime
@@ -7,9 +7,11 @@
 
 #include <mutex>
 #include "core/common/logging/logging.h"
+#include "core/common/parse_string.h"
 #include "core/common/safeint.h"
 #include "core/flatbuffers/schema/ort.fbs.h"
 #include "core/framework/allocator.h"
+#include "core/framework/dataflow_executor.h"
 #include "core/framework/node_index_info.h"
 #include "core/framework/op_kernel.h"
 #include "core/framework/ort_value_pattern_planner.h"
@@ -79,6 +81,15 @@ class StreamCommandHandleRegistryImpl : public IStreamCommandHandleRegistry {
 };
 #endif
 
+static size_t GetMemoryPatternCacheCapacity(const SessionOptions& sess_options) {
+  const std::string value =
+      sess_options.config_options.GetConfigOrDefault(kOrtSessionOptionsMemoryPatternCacheCapacity, "0");
+  size_t capacity = 0;
+  ORT_ENFORCE(TryParseStringWithClassicLocale<size_t>(value, capacity),
+              "Invalid value for ", kOrtSessionOptionsMemoryPatternCacheCapacity, ": ", value);
+  return capacity;
+}
+
 SessionState::SessionState(Graph& graph,
                            const ExecutionProviders& execution_providers,
                            concurrency::ThreadPool* thread_pool,
@@ -89,17 +100,22 @@ SessionState::SessionState(Graph& graph,
                            profiling::Profiler& profiler,
                            const SessionOptions& sess_options,
                            PrepackedWeightsContainer* prepacked_weights_container,
-                           AllocatorMap* parent_allocators)
+                           AllocatorMap* parent_allocators,
+                           SharedPrepackedWeightsStore* shared_prepacked_weights_store)
     : graph_(graph),
       execution_providers_(execution_providers),
       logger_(logger),
       profiler_(profiler),
+      mem_pattern_cache_(GetMemoryPatternCacheCapacity(sess_options),
+                         sess_options.config_options.GetConfigOrDefault(kOrtSessionOptionsMemoryPatternShapeBuckets,
+                                                                        "0") == "1"),
       thread_pool_(thread_pool),
       inter_op_thread_pool_(inter_op_thread_pool),
       data_transfer_mgr_(data_transfer_mgr),
       external_data_loader_mgr_(external_data_loader_mgr),
       sess_options_(sess_options),
-      prepacked_weights_container_(prepacked_weights_container)
+      prepacked_weights_container_(prepacked_weights_container),
+      shared_prepacked_weights_store_(shared_prepacked_weights_store)
 #ifdef ORT_ENABLE_STREAM
       ,
       stream_handles_registry_(std::make_unique<StreamCommandHandleRegistryImpl>())
@@ -546,6 +562,49 @@ Status SessionState::PrepackConstantInitializedTensors(
                     }
                   }
 
+                } else if (shared_prepacked_weights_store_ != nullptr && !prepacked_for_graph->IsSaveModeOn() &&
+                           node.GetExecutionProviderType() == kCpuExecutionProvider) {
+                  // sharing of pre-packed weights with the other sessions of the environment turned ON.
+                  // the weights are shared by content, so this is not limited to shared initializers.
+                  PrePackedWeights weights_to_be_filled_in;
+                  ORT_RETURN_IF_ERROR(kernel->PrePack(const_initialized_tensor, input_idx,
+                                                      shared_prepacked_weights_store_->GetAllocator(),
+                                                      is_packed,
+                                                      &weights_to_be_filled_in));
+
+                  // as in the session local case, leave the kernels that don't produce sharable pre-packed
+                  // weights alone
+                  if (is_packed && !weights_to_be_filled_in.buffers_.empty()) {
+                    const std::string prepacked_weights_container_key = GenerateKeyForPrepackedWeightsMap(
+                        node.OpType(),
+                        weights_to_be_filled_in);
+
+                    // prefer the weights loaded from disk, which the store then shares
+                    auto prepacked_from_disk = prepacked_for_graph->ReplaceWithReferenceIfSaving(
+                        input_name,
+                        prepacked_weights_container_key,
+                        weights_to_be_filled_in);
+
+                    if (prepacked_from_disk.has_value()) {
+                      weights_to_be_filled_in = std::move(*prepacked_from_disk);
+                    }
+
+                    bool is_cached = false;
+                    auto shared_prepacked = shared_prepacked_weights_store_->GetOrAddWeight(
+                        prepacked_weights_container_key, std::move(weights_to_be_filled_in), is_cached);
+                    ORT_RETURN_IF_ERROR(KernelUseSharedPrePackedBuffers(*kernel, input_idx,
+                                                                        *shared_prepacked,
+                                                                        node.Name()));
+
+                    if (is_cached) {
+                      LOGS(logger_, INFO) << "Using pre-packed weight shared with other sessions for constant "
+                                          << "initializer: " << input_name << " used in the node: " << node.Name()
+                                          << " which is of op type: " << node.OpType();
+                      ++used_shared_pre_packed_weights_counter_;
+                    }
+
+                    shared_store_prepacked_weights_.push_back(std::move(shared_prepacked));
+                  }
                 } else {
                   // cross session caching of pre-packed weights' turned OFF
                   // we use serialization container to share weights loaded from disk
@@ -633,15 +692,6 @@ Status SessionState::PrepackConstantInitializedTensors(
   }
 }
 
-static int64_t
-CalculateMemoryPatternsKey(const gsl::span<const OrtValue>& tensor_inputs) {
-  int64_t key = 0;
-  for (const auto& input : tensor_inputs) {
-    for (auto dim : input.Get<Tensor>().Shape().GetDims()) key ^= dim;
-  }
-  return key;
-}
-
 #ifdef ENABLE_TRAINING
 namespace {
 Status ResolveDimParams(const GraphViewer& graph,
@@ -876,38 +926,36 @@ Status SessionState::GeneratePatternGroupCache(gsl::span<const OrtValue> tensor_
 
 #endif
 
-// MemoryPatternGroup pointer is cached. It only inserted upon creation
-// and is not updated if already present.
-const MemoryPatternGroup* SessionState::GetMemoryPatternGroup(
+// The entry of the cache is only inserted upon creation and is not updated if already present,
+// unless a run replaces it as it needs larger blocks.
+std::shared_ptr<const MemoryPatternCache::Entry> SessionState::GetMemoryPatternGroup(
     gsl::span<const OrtValue> tensor_inputs,
     gsl::span<const int> feed_mlvalue_idxs,
-    const InlinedHashMap<int, TensorShape>*& out_inferred_shapes) const {
-  out_inferred_shapes = nullptr;
-  int64_t key = CalculateMemoryPatternsKey(tensor_inputs);
+    std::shared_ptr<const MemoryPatternCache::SizeHints>& size_hints) const {
+  size_hints = nullptr;
   std::lock_guard<std::mutex> lock(mem_patterns_lock_);
-  auto it = mem_patterns_.find(key);
-  if (it == mem_patterns_.end()) {
+  const int64_t key = mem_pattern_cache_.CalculateKey(tensor_inputs);
+  auto entry = mem_pattern_cache_.Find(key);
+  if (entry) {
+    return entry;
+  }
+
 #ifdef ENABLE_TRAINING
-    MemoryPatternGroup mem_patterns;
-    InlinedHashMap<int, TensorShape> inferred_shapes;
-    if (GeneratePatternGroupCache(tensor_inputs, feed_mlvalue_idxs, mem_patterns, inferred_shapes).IsOK()) {
-      auto patt_insert = mem_patterns_.insert_or_assign(key, std::move(mem_patterns));
-      auto ptr = &patt_insert.first->second;
-      auto shape_insert = shape_patterns_.insert_or_assign(key, std::move(inferred_shapes));
-      out_inferred_shapes = &shape_insert.first->second;
-      return ptr;
+  // the inferred shapes are only valid for the exact input shapes
+  if (!mem_pattern_cache_.BucketShapes()) {
+    MemoryPatternCache::Entry new_entry;
+    if (GeneratePatternGroupCache(tensor_inputs, feed_mlvalue_idxs, new_entry.patterns,
+                                  new_entry.inferred_shapes)
+            .IsOK()) {
+      return mem_pattern_cache_.Insert(key, std::move(new_entry));
     }
+  }
 #else
-    ORT_UNUSED_PARAMETER(feed_mlvalue_idxs);
+  ORT_UNUSED_PARAMETER(feed_mlvalue_idxs);
 #endif
-    return nullptr;
-  }
 
-  auto patt_hit = shape_patterns_.find(key);
-  if (patt_hit != shape_patterns_.cend()) {
-    out_inferred_shapes = &patt_hit->second;
-  }
-  return &it->second;
+  size_hints = mem_pattern_cache_.GetSizeHints(key);
+  return nullptr;
 }
 
 void SessionState::ResolveMemoryPatternFlag() {
@@ -941,6 +989,10 @@ void SessionState::ResolveMemoryPatternFlag() {
     if (multi_stream)
       enable_mem_pattern_ = false;
 
+    // the order in which the dataflow executor runs the nodes differs between runs
+    if (!GetExecutionPlan()->dataflow_nodes.empty())
+      enable_mem_pattern_ = false;
+
     // For subgraphs, the implicit inputs need to meet the same crieria
     // as the explicit inputs for memory pattern to be enabled
     if (graph_viewer_->IsSubgraph()) {
@@ -958,14 +1010,29 @@ void SessionState::ResolveMemoryPatternFlag() {
 
 Status SessionState::UpdateMemoryPatternGroupCache(gsl::span<const OrtValue> tensor_inputs,
                                                    MemoryPatternGroup mem_patterns) const {
-  int64_t key = CalculateMemoryPatternsKey(tensor_inputs);
-
   std::lock_guard<std::mutex> lock(mem_patterns_lock_);
-  // Do not update if present, as the pointer to the existing one is cached
-  mem_patterns_.emplace(key, std::move(mem_patterns));
+  const int64_t key = mem_pattern_cache_.CalculateKey(tensor_inputs);
+  // Do not update if present, as the existing one may be in use
+  MemoryPatternCache::Entry entry;
+  entry.patterns = std::move(mem_patterns);
+  mem_pattern_cache_.Insert(key, std::move(entry));
   return Status::OK();
 }
 
+void SessionState::ReplaceMemoryPatternGroup(gsl::span<const OrtValue> tensor_inputs,
+                                             const MemoryPatternCache::Entry& used_entry,
+                                             const MemoryPatternCache::SizeHints& required_sizes) const {
+  std::lock_guard<std::mutex> lock(mem_patterns_lock_);
+  const int64_t key = mem_pattern_cache_.CalculateKey(tensor_inputs);
+  mem_pattern_cache_.Replace(key, used_entry, required_sizes);
+}
+
+void SessionState::GetMemoryPatternCacheStats(size_t& num_hits, size_t& num_misses) const {
+  std::lock_guard<std::mutex> lock(mem_patterns_lock_);
+  num_hits = mem_pattern_cache_.NumHits();
+  num_misses = mem_pattern_cache_.NumMisses();
+}
+
 bool SessionState::GetEnableMemoryPattern() const { return enable_mem_pattern_; }
 
 bool SessionState::GetEnableMemoryReuse() const { return sess_options_.enable_mem_reuse; }
@@ -1158,7 +1225,8 @@ Status SessionState::CreateSubgraphSessionState() {
           std::make_unique<SessionState>(*subgraph, execution_providers_,
                                          thread_pool_, inter_op_thread_pool_, data_transfer_mgr_,
                                          external_data_loader_mgr_, logger_, profiler_, sess_options_,
-                                         prepacked_weights_container_, allocators_);
+                                         prepacked_weights_container_, allocators_,
+                                         shared_prepacked_weights_store_);
 
       // Pass fused function manager to subgraph
       subgraph_session_state->fused_funcs_mgr_.SetFusedFuncs(fused_funcs_mgr_);
@@ -1514,7 +1582,15 @@ Status SessionState::FinalizeSessionStateImpl(const std::basic_string<PATH_CHAR_
   SubgraphsKernelCreateInfoMaps subgraphs_kernel_create_info_maps;
   AccumulateAllNestedSubgraphsInfo(*this, "", 0, subgraphs_kernel_create_info_maps);
 
-  SequentialPlannerContext context(session_options.execution_mode,
+  // Subgraphs are executed sequentially on the thread running their parent node.
+  const bool enable_dataflow_execution =
+      parent_node == nullptr &&
+      session_options.config_options.GetConfigOrDefault(kOrtSessionOptionsEnableDataflowExecution, "0") == "1";
+
+  // The dataflow executor does not run nodes in a fixed order, so plan without reusing buffers across nodes
+  // the same way as for parallel execution.
+  SequentialPlannerContext context(enable_dataflow_execution ? ExecutionMode::ORT_PARALLEL
+                                                             : session_options.execution_mode,
                                    session_options.execution_order,
                                    session_options.enable_mem_reuse);
 
@@ -1545,6 +1621,11 @@ Status SessionState::FinalizeSessionStateImpl(const std::basic_string<PATH_CHAR_
                                               p_seq_exec_plan_);
   ORT_RETURN_IF_ERROR(status);
 
+  if (enable_dataflow_execution && !BuildDataflowPlan(*graph_viewer_, *p_seq_exec_plan_)) {
+    LOGS(logger_, INFO) << "Dataflow execution is only supported for graphs executed in a single CPU stream. "
+                        << "Nodes will be executed in the order of the execution plan.";
+  }
+
   if (session_options.IsLoadCancellationFlagSet()) {
     return ORT_MAKE_STATUS(ONNXRUNTIME, MODEL_LOAD_CANCELED,
                            "SessionState finalize is canceled due to user request");
@@ -1645,6 +1726,10 @@ Status SessionState::FinalizeSessionStateImpl(const std::basic_string<PATH_CHAR_
 
   ORT_RETURN_IF_ERROR(CreateKernels(kernel_registry_manager));
 
+  if (session_options.config_options.GetConfigOrDefault(kOrtSessionOptionsEnableMetrics, "0") == "1") {
+    metrics_ = std::make_unique<SessionMetrics>(graph_viewer_->MaxNodeIndex());
+  }
+
   if (!disable_prepacking) {
     ORT_RETURN_IF_ERROR(PrepackConstantInitializedTensors(constant_initializers_use_count,
                                                           session_options.initializers_to_share_map));
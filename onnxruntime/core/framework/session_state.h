@@ -28,10 +28,12 @@
 #include "core/framework/fuse_nodes_funcs.h"
 #include "core/framework/kernel_registry_manager.h"
 #include "core/framework/mem_pattern.h"
+#include "core/framework/mem_pattern_cache.h"
 #include "core/framework/ort_value.h"
 #include "core/framework/node_index_info.h"
 #include "core/framework/op_kernel.h"
 #include "core/framework/ort_value_name_idx_map.h"
+#include "core/framework/session_metrics.h"
 #include "core/graph/graph_viewer.h"
 #include "core/graph/onnx_protobuf.h"
 #include <mutex>
@@ -98,7 +100,8 @@ class SessionState {
                profiling::Profiler& profiler,
                const SessionOptions& sess_options,
                PrepackedWeightsContainer* prepacked_weights_container = nullptr,
-               AllocatorMap* parent_allocators = nullptr);
+               AllocatorMap* parent_allocators = nullptr,
+               SharedPrepackedWeightsStore* shared_prepacked_weights_store = nullptr);
 
   ~SessionState() {
   }
@@ -214,16 +217,14 @@ class SessionState {
   /**
   Get cached memory pattern based on input shapes
   Must be called only when all values contain tensors
-  In training scenarios, the cache may be updated so
-  the callers would receive a copy of inferred shapes
-  made under mutex being held. In inference scenarios,
-  it is not mutable, we do not obtain a lock and simply get a pointer
-  w/o copying a hashtable
+  The returned entry stays valid while it is referenced, even if it is evicted from the cache.
+  If there is no pattern, `size_hints` receives the lower bounds of the sizes to trace the new pattern with,
+  which may be nullptr.
   */
-  const MemoryPatternGroup* GetMemoryPatternGroup(
+  std::shared_ptr<const MemoryPatternCache::Entry> GetMemoryPatternGroup(
       gsl::span<const OrtValue> tensor_inputs,
       gsl::span<const int> feed_mlvalue_idxs,
-      const InlinedHashMap<int, TensorShape>*& inferred_shapes) const;
+      std::shared_ptr<const MemoryPatternCache::SizeHints>& size_hints) const;
 
   /**
   Set generated memory pattern with a given input shapes.
@@ -233,6 +234,26 @@ class SessionState {
   Status UpdateMemoryPatternGroupCache(gsl::span<const OrtValue> tensor_inputs,
                                        MemoryPatternGroup mem_patterns) const;
 
+  /**
+  Replace the memory pattern `used_entry` for the given input shapes, as some values required larger blocks.
+  The next run with these input shapes traces a new pattern, with the sizes of `used_entry` and `required_sizes`
+  as lower bounds.
+  */
+  void ReplaceMemoryPatternGroup(gsl::span<const OrtValue> tensor_inputs,
+                                 const MemoryPatternCache::Entry& used_entry,
+                                 const MemoryPatternCache::SizeHints& required_sizes) const;
+
+  /**
+  Get whether memory patterns are shared by all the input shapes of a bucket, in which case a block of a pattern
+  may be used for a value that is smaller than the block.
+  */
+  bool GetMemoryPatternShapeBucketing() const { return mem_pattern_cache_.BucketShapes(); }
+
+  /**
+  Get the number of lookups of the memory pattern cache that found a pattern (hits) or not (misses).
+  */
+  void GetMemoryPatternCacheStats(size_t& num_hits, size_t& num_misses) const;
+
   bool GetUseDeterministicCompute() const { return sess_options_.use_deterministic_compute; }
 
   /**
@@ -366,6 +387,10 @@ class SessionState {
   /// <returns>true of false
   bool GetSaveModeForPrepacks(bool saving_model, bool saving_ort_format);
 
+  // Metrics of the session state, or nullptr if they are not enabled with "session.enable_metrics".
+  // The metrics are recorded concurrently by the runs.
+  SessionMetrics* GetMetrics() const noexcept { return metrics_.get(); }
+
 #if !defined(ORT_MINIMAL_BUILD)
 
   void SetNodeStatsRecorder(NodeStatsRecorder* node_stats_recorder) {
@@ -438,6 +463,10 @@ class SessionState {
   // fused_funcs_mgr_ must live longer than the session_kernels_, becaues a kernel could be created from this manager
   FuncManager fused_funcs_mgr_;
 
+  // pre-packed weights from the shared store of the environment that the kernels use.
+  // they must live longer than the session_kernels_, which refer to their buffers.
+  std::vector<std::shared_ptr<const PrePackedWeights>> shared_store_prepacked_weights_;
+
   // cache of the constructed kernels to avoid spending construction time per executor
   std::vector<std::unique_ptr<OpKernel>> session_kernels_;
   Graph& graph_;
@@ -507,21 +536,15 @@ class SessionState {
   NodeStatsRecorder* node_stats_recorder_ = nullptr;
 #endif
 
+  std::unique_ptr<SessionMetrics> metrics_;
+
   // switch for enable memory pattern optimization or not.
   bool enable_mem_pattern_;
 
-  // lock for the mem_patterns_
+  // lock for the mem_pattern_cache_
   mutable std::mutex mem_patterns_lock_;
   // cache for the generated mem_patterns. key is calculated based on input shapes.
-  // must be a node based container as a pointer is cached.
-  mutable NodeHashMap<int64_t, MemoryPatternGroup> mem_patterns_;
-  // This is mutable under mutex in training scenarios so execution frame would make a copy
-  // of the value when created.
-#ifdef ENABLE_TRAINING
-  mutable NodeHashMap<int64_t, InlinedHashMap<int, TensorShape>> shape_patterns_;
-#else
-  NodeHashMap<int64_t, InlinedHashMap<int, TensorShape>> shape_patterns_;
-#endif
+  mutable MemoryPatternCache mem_pattern_cache_;
 
   NameNodeInfoMapType input_names_to_nodeinfo_mapping_;
   NameNodeInfoMapType output_names_to_nodeinfo_mapping_;
@@ -546,6 +569,10 @@ class SessionState {
   // prepacked_weights_container_ can be nullptr if no caching is required for prepacked weights
   PrepackedWeightsContainer* const prepacked_weights_container_{};
 
+  // Store of the environment to share pre-packed weights with all the sessions that use it.
+  // The environment outlives the sessions. nullptr if the session does not use it.
+  SharedPrepackedWeightsStore* const shared_prepacked_weights_store_{};
+
 #ifdef ENABLE_TRAINING
 // Needed for ORTTrainer. Should be removed along with ORTTrainer code
 #ifndef DISABLE_ABSEIL
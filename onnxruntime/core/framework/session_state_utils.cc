@@ -70,6 +70,8 @@ static common::Status AllocateBufferUsingDeviceAllocatorFromShapeAndType(const T
  * @param prepacked_for_graph Reference to an object managing prepacked weights for the graph.
  * @param use_device_allocator_for_initializers A flag indicating whether to use the device-specific allocator
  *                                              directly for initializers, potentially bypassing arenas.
+ * @param map_external_data_files A flag indicating whether external data used on CPU is a view into a mapping of the
+ *                                whole external data file that is shared by all the sessions of the process.
  * @return common::Status indicating success or failure of the deserialization process.
  *         Returns an error status if both `memory_buffer` and `alloc` are provided or if both are null (unless external data on CPU allows mmap),
  *         if string tensors are attempted to be copied to non-CPU devices, or if any underlying
@@ -81,7 +83,8 @@ static common::Status DeserializeTensorProto(const Env& env, const std::basic_st
                                              OrtValue& ort_value, const DataTransferManager& data_transfer_mgr,
                                              const ExternalDataLoaderManager& external_data_loader_mgr,
                                              PrepackedWeightsForGraph& prepacked_for_graph,
-                                             bool use_device_allocator_for_initializers = false) {
+                                             bool use_device_allocator_for_initializers,
+                                             bool map_external_data_files) {
   if (bool(alloc) == (memory_buffer != nullptr)) {
     return Status(common::ONNXRUNTIME, common::INVALID_ARGUMENT,
                   "DeserializeTensorProto() takes either pre-allocated buffer or an allocator!");
@@ -113,7 +116,8 @@ static common::Status DeserializeTensorProto(const Env& env, const std::basic_st
       // utilize the mmap'd buffer directly.
       ORT_RETURN_IF_ERROR(utils::GetExtDataFromTensorProto(env, proto_path, tensor_proto,
                                                            ort_value,
-                                                           &prepacked_for_graph));
+                                                           &prepacked_for_graph,
+                                                           map_external_data_files));
       return common::Status::OK();
     } else {  // non-cpu tensor or tensor in a cpu accessible memory
       if (utils::HasString(tensor_proto)) {
@@ -373,6 +377,8 @@ common::Status SaveInitializedTensors(
       const bool use_device_allocator_for_initializers =
           session_options.config_options.GetConfigOrDefault(
               kOrtSessionOptionsUseDeviceAllocatorForInitializers, "0") == "1";
+      const bool map_external_data_files =
+          session_options.config_options.GetConfigOrDefault(kOrtSessionOptionsConfigMapModelFiles, "0") == "1";
 
       // Check if we already have an OrtValue for this initializer on CPU
       if (OrtValue ort_value_from_graph;
@@ -401,7 +407,8 @@ common::Status SaveInitializedTensors(
         Status st = DeserializeTensorProto(env, graph_loc, tensor_proto, (memory_buffer.has_value()) ? &*memory_buffer : nullptr, alloc,
                                            default_cpu_alloc, ort_value, data_transfer_mgr, external_data_loader_mgr,
                                            prepacked_for_graph,
-                                           use_device_allocator_for_initializers);
+                                           use_device_allocator_for_initializers,
+                                           map_external_data_files);
         if (!st.IsOK()) {
           std::ostringstream oss;
           oss << "Deserialize tensor " << name << " failed." << st.ErrorMessage();
@@ -0,0 +1,434 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "core/framework/slab_arena.h"
+
+#include <algorithm>
+
+#include "core/common/logging/logging.h"
+#include "core/common/safeint.h"
+
+namespace onnxruntime {
+
+namespace {
+
+constexpr size_t kSizeClassesPerDoubling = 4;
+constexpr size_t kNumLinearSizeClasses = 4;  // 64, 128, 192, 256
+constexpr size_t kLinearSizeClassLimit = kNumLinearSizeClasses * SlabArena::kMinBlockSize;
+
+// Target size of a slab carved into blocks of a size class.
+constexpr size_t kTargetSlabBytes = 1024 * 1024;
+// Target number of bytes moved between a thread cache and the shared pool in one refill or flush.
+constexpr size_t kTargetTransferBytes = 256 * 1024;
+constexpr size_t kMaxTransferBlocks = 32;
+
+// Size class index stored in the header of blocks that were allocated directly from the device allocator.
+constexpr uint32_t kLargeSizeClass = static_cast<uint32_t>(SlabArena::kNumSizeClasses);
+
+struct BlockHeader {
+  uint32_t size_class;
+  // total number of bytes allocated from the device allocator. only set for large blocks.
+  size_t allocated_bytes;
+};
+
+static_assert(sizeof(BlockHeader) <= SlabArena::kHeaderSize, "BlockHeader does not fit in the reserved header space");
+
+BlockHeader* HeaderFromUserPointer(void* p) {
+  return reinterpret_cast<BlockHeader*>(static_cast<uint8_t*>(p) - SlabArena::kHeaderSize);
+}
+
+void* UserPointerFromBlock(void* block) {
+  return static_cast<uint8_t*>(block) + SlabArena::kHeaderSize;
+}
+
+size_t TransferBlocks(size_t size_class) {
+  return std::clamp<size_t>(kTargetTransferBytes / SlabArena::SizeClassBlockSize(size_class), 1, kMaxTransferBlocks);
+}
+
+// Counters are only written by the owning thread, so relaxed load + store is sufficient.
+void AddRelaxed(std::atomic<int64_t>& counter, int64_t value) {
+  counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void UpdateMax(std::atomic<int64_t>& max_value, int64_t value) {
+  int64_t current = max_value.load(std::memory_order_relaxed);
+  while (value > current && !max_value.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+  }
+}
+
+std::atomic<uint64_t> next_arena_id{1};
+
+}  // namespace
+
+struct SlabArena::ThreadCache {
+  std::array<std::vector<void*>, kNumSizeClasses> free_blocks;
+
+  std::atomic<int64_t> num_allocs{0};
+  std::atomic<int64_t> bytes_allocated{0};
+  std::atomic<int64_t> bytes_freed{0};
+  std::atomic<int64_t> max_alloc_size{0};
+};
+
+struct SlabArena::State {
+  struct SizeClassPool {
+    std::mutex mutex;
+    std::vector<void*> free_blocks;  // GUARDED_BY(mutex)
+  };
+
+  State(std::unique_ptr<IAllocator> device_allocator_in, size_t memory_limit_in)
+      : device_allocator(std::move(device_allocator_in)),
+        memory_limit(memory_limit_in),
+        id(next_arena_id.fetch_add(1)) {}
+
+  ~State() {
+    for (void* slab : slabs) {
+      device_allocator->Free(slab);
+    }
+  }
+
+  // Reserve `bytes` of the memory limit. Throws if the limit would be exceeded.
+  void ReserveMemory(size_t bytes) {
+    size_t current = total_allocated_bytes.load(std::memory_order_relaxed);
+    size_t updated;
+    do {
+      updated = SafeInt<size_t>(current) + bytes;
+      if (updated > memory_limit) {
+        ORT_THROW("Available memory of ", memory_limit - current, " is smaller than requested bytes of ", bytes);
+      }
+    } while (!total_allocated_bytes.compare_exchange_weak(current, updated, std::memory_order_relaxed));
+  }
+
+  void* AllocateFromDevice(size_t bytes) {
+    ReserveMemory(bytes);
+    void* p = device_allocator->Alloc(bytes);
+    if (p == nullptr) {
+      total_allocated_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+      ORT_THROW("Failed to allocate memory for requested buffer of size ", bytes);
+    }
+
+    return p;
+  }
+
+  void FreeToDevice(void* p, size_t bytes) {
+    device_allocator->Free(p);
+    total_allocated_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  void CheckOut(int64_t bytes) {
+    UpdateMax(max_checked_out_bytes, checked_out_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+  }
+
+  void CheckIn(int64_t bytes) {
+    checked_out_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+  }
+
+  // Move a batch of blocks of `size_class` from the shared pool to `free_blocks`, carving a new slab if needed.
+  void Refill(size_t size_class, std::vector<void*>& free_blocks) {
+    const size_t block_size = SizeClassBlockSize(size_class);
+    const size_t stride = kHeaderSize + block_size;
+    const size_t num_blocks = TransferBlocks(size_class);
+
+    SizeClassPool& pool = pools[size_class];
+    std::lock_guard<std::mutex> lock(pool.mutex);
+
+    if (pool.free_blocks.size() < num_blocks) {
+      const size_t blocks_per_slab = std::max(num_blocks, kTargetSlabBytes / stride);
+      const size_t slab_bytes = SafeInt<size_t>(stride) * blocks_per_slab;
+      auto* slab = static_cast<uint8_t*>(AllocateFromDevice(slab_bytes));
+
+      {
+        std::lock_guard<std::mutex> slabs_lock(slabs_mutex);
+        slabs.push_back(slab);
+      }
+      num_slabs.fetch_add(1, std::memory_order_relaxed);
+
+      // push in reverse order so blocks are handed out in increasing address order
+      for (size_t i = blocks_per_slab; i-- > 0;) {
+        void* block = slab + i * stride;
+        auto* header = static_cast<BlockHeader*>(block);
+        header->size_class = static_cast<uint32_t>(size_class);
+        header->allocated_bytes = 0;
+        pool.free_blocks.push_back(block);
+      }
+    }
+
+    auto first = pool.free_blocks.end() - num_blocks;
+    free_blocks.insert(free_blocks.end(), first, pool.free_blocks.end());
+    pool.free_blocks.erase(first, pool.free_blocks.end());
+
+    CheckOut(static_cast<int64_t>(num_blocks * block_size));
+  }
+
+  // Move `num_blocks` blocks from the back of `free_blocks` to the shared pool.
+  void Flush(size_t size_class, std::vector<void*>& free_blocks, size_t num_blocks) {
+    if (num_blocks == 0) {
+      return;
+    }
+
+    SizeClassPool& pool = pools[size_class];
+    {
+      std::lock_guard<std::mutex> lock(pool.mutex);
+      auto first = free_blocks.end() - num_blocks;
+      pool.free_blocks.insert(pool.free_blocks.end(), first, free_blocks.end());
+      free_blocks.erase(first, free_blocks.end());
+    }
+
+    CheckIn(static_cast<int64_t>(num_blocks * SizeClassBlockSize(size_class)));
+  }
+
+  // Called when the thread owning `cache` exits. Returns its blocks to the shared pools.
+  void ReleaseThreadCache(ThreadCache* cache) {
+    for (size_t size_class = 0; size_class < kNumSizeClasses; ++size_class) {
+      auto& free_blocks = cache->free_blocks[size_class];
+      Flush(size_class, free_blocks, free_blocks.size());
+    }
+
+    std::lock_guard<std::mutex> lock(caches_mutex);
+    retired_num_allocs += cache->num_allocs.load(std::memory_order_relaxed);
+    retired_bytes_in_use += cache->bytes_allocated.load(std::memory_order_relaxed) -
+                            cache->bytes_freed.load(std::memory_order_relaxed);
+    retired_max_alloc_size = std::max(retired_max_alloc_size, cache->max_alloc_size.load(std::memory_order_relaxed));
+
+    caches.erase(std::remove_if(caches.begin(), caches.end(),
+                                [cache](const std::unique_ptr<ThreadCache>& c) { return c.get() == cache; }),
+                 caches.end());
+  }
+
+  const std::unique_ptr<IAllocator> device_allocator;
+  const size_t memory_limit;
+  const uint64_t id;
+
+  std::array<SizeClassPool, kNumSizeClasses> pools;
+
+  std::mutex slabs_mutex;
+  std::vector<void*> slabs;  // GUARDED_BY(slabs_mutex)
+
+  std::atomic<size_t> total_allocated_bytes{0};
+  std::atomic<int64_t> checked_out_bytes{0};
+  std::atomic<int64_t> max_checked_out_bytes{0};
+  std::atomic<int64_t> num_slabs{0};
+  std::atomic<int64_t> num_reserves{0};
+
+  std::mutex caches_mutex;
+  std::vector<std::unique_ptr<ThreadCache>> caches;  // GUARDED_BY(caches_mutex)
+  // counters of the caches of threads that have exited
+  int64_t retired_num_allocs = 0;      // GUARDED_BY(caches_mutex)
+  int64_t retired_bytes_in_use = 0;    // GUARDED_BY(caches_mutex)
+  int64_t retired_max_alloc_size = 0;  // GUARDED_BY(caches_mutex)
+};
+
+namespace {
+
+// Per thread list of the thread caches of all arenas the thread has used.
+struct ThreadCacheRegistry {
+  struct Entry {
+    uint64_t arena_id;
+    std::weak_ptr<SlabArena::State> state;
+    SlabArena::ThreadCache* cache;
+  };
+
+  ~ThreadCacheRegistry() {
+    for (auto& entry : entries) {
+      if (auto state = entry.state.lock()) {
+        state->ReleaseThreadCache(entry.cache);
+      }
+    }
+  }
+
+  std::vector<Entry> entries;
+};
+
+thread_local ThreadCacheRegistry thread_cache_registry;
+
+}  // namespace
+
+SlabArena::SlabArena(std::unique_ptr<IAllocator> resource_allocator, size_t total_memory)
+    : IAllocator(OrtMemoryInfo(resource_allocator->Info().name,
+                               OrtAllocatorType::OrtDeviceAllocator,
+                               resource_allocator->Info().device,
+                               resource_allocator->Info().mem_type)),
+      state_(std::make_shared<State>(std::move(resource_allocator), total_memory)) {
+  LOGS_DEFAULT(INFO) << "Creating SlabArena for " << state_->device_allocator->Info().name
+                     << " with " << kNumSizeClasses << " size classes up to " << kMaxBlockSize
+                     << " bytes and memory limit: " << total_memory;
+}
+
+SlabArena::~SlabArena() = default;
+
+size_t SlabArena::SizeClassIndex(size_t size) {
+  if (size <= kLinearSizeClassLimit) {
+    return size == 0 ? 0 : (size - 1) / kMinBlockSize;
+  }
+
+  if (size > kMaxBlockSize) {
+    return kNumSizeClasses;
+  }
+
+  // find p such that 2^p < size <= 2^(p+1). p >= 8 as size > 256.
+  size_t p = 0;
+  for (size_t v = size - 1; v > 1; v >>= 1) {
+    ++p;
+  }
+
+  const size_t base = size_t{1} << p;
+  const size_t step = base / kSizeClassesPerDoubling;
+  const size_t k = (size - base + step - 1) / step;  // 1..4
+  return kNumLinearSizeClasses + (p - 8) * kSizeClassesPerDoubling + (k - 1);
+}
+
+size_t SlabArena::SizeClassBlockSize(size_t index) {
+  if (index < kNumLinearSizeClasses) {
+    return (index + 1) * kMinBlockSize;
+  }
+
+  const size_t j = index - kNumLinearSizeClasses;
+  const size_t base = size_t{1} << (8 + j / kSizeClassesPerDoubling);
+  return base + (j % kSizeClassesPerDoubling + 1) * (base / kSizeClassesPerDoubling);
+}
+
+SlabArena::ThreadCache& SlabArena::GetThreadCache() {
+  auto& entries = thread_cache_registry.entries;
+  for (const auto& entry : entries) {
+    if (entry.arena_id == state_->id) {
+      return *entry.cache;
+    }
+  }
+
+  // first allocation from this arena on this thread. drop the entries of destroyed arenas while we're here.
+  entries.erase(std::remove_if(entries.begin(), entries.end(),
+                               [](const ThreadCacheRegistry::Entry& e) { return e.state.expired(); }),
+                entries.end());
+
+  auto cache = std::make_unique<ThreadCache>();
+  ThreadCache* cache_ptr = cache.get();
+  {
+    std::lock_guard<std::mutex> lock(state_->caches_mutex);
+    state_->caches.push_back(std::move(cache));
+  }
+
+  entries.push_back({state_->id, state_, cache_ptr});
+  return *cache_ptr;
+}
+
+void* SlabArena::AllocateLarge(size_t size, bool is_reserve) {
+  const size_t allocated_bytes = SafeInt<size_t>(size) + kHeaderSize;
+  void* block = state_->AllocateFromDevice(allocated_bytes);
+  auto* header = static_cast<BlockHeader*>(block);
+  header->size_class = kLargeSizeClass;
+  header->allocated_bytes = allocated_bytes;
+
+  state_->CheckOut(static_cast<int64_t>(size));
+  if (is_reserve) {
+    state_->num_reserves.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  return UserPointerFromBlock(block);
+}
+
+void* SlabArena::Alloc(size_t size) {
+  if (size == 0) {
+    return nullptr;
+  }
+
+  ThreadCache& cache = GetThreadCache();
+  const size_t size_class = SizeClassIndex(size);
+
+  void* p;
+  int64_t bytes;
+  if (size_class == kNumSizeClasses) {
+    p = AllocateLarge(size, /*is_reserve*/ false);
+    bytes = static_cast<int64_t>(size);
+  } else {
+    auto& free_blocks = cache.free_blocks[size_class];
+    if (free_blocks.empty()) {
+      state_->Refill(size_class, free_blocks);
+    }
+
+    p = UserPointerFromBlock(free_blocks.back());
+    free_blocks.pop_back();
+    bytes = static_cast<int64_t>(SizeClassBlockSize(size_class));
+  }
+
+  AddRelaxed(cache.num_allocs, 1);
+  AddRelaxed(cache.bytes_allocated, bytes);
+  if (static_cast<int64_t>(size) > cache.max_alloc_size.load(std::memory_order_relaxed)) {
+    cache.max_alloc_size.store(static_cast<int64_t>(size), std::memory_order_relaxed);
+  }
+
+  return p;
+}
+
+void* SlabArena::Reserve(size_t size) {
+  if (size == 0) {
+    return nullptr;
+  }
+
+  ThreadCache& cache = GetThreadCache();
+  void* p = AllocateLarge(size, /*is_reserve*/ true);
+
+  AddRelaxed(cache.num_allocs, 1);
+  AddRelaxed(cache.bytes_allocated, static_cast<int64_t>(size));
+  if (static_cast<int64_t>(size) > cache.max_alloc_size.load(std::memory_order_relaxed)) {
+    cache.max_alloc_size.store(static_cast<int64_t>(size), std::memory_order_relaxed);
+  }
+
+  return p;
+}
+
+void SlabArena::Free(void* p) {
+  if (p == nullptr) {
+    return;
+  }
+
+  ThreadCache& cache = GetThreadCache();
+  BlockHeader* header = HeaderFromUserPointer(p);
+  const size_t size_class = header->size_class;
+
+  if (size_class == kLargeSizeClass) {
+    const size_t allocated_bytes = header->allocated_bytes;
+    const auto bytes = static_cast<int64_t>(allocated_bytes - kHeaderSize);
+    state_->FreeToDevice(header, allocated_bytes);
+    state_->CheckIn(bytes);
+    AddRelaxed(cache.bytes_freed, bytes);
+    return;
+  }
+
+  ORT_ENFORCE(size_class < kNumSizeClasses, "Invalid pointer passed to SlabArena::Free");
+
+  auto& free_blocks = cache.free_blocks[size_class];
+  free_blocks.push_back(header);
+  AddRelaxed(cache.bytes_freed, static_cast<int64_t>(SizeClassBlockSize(size_class)));
+
+  const size_t transfer_blocks = TransferBlocks(size_class);
+  if (free_blocks.size() > 2 * transfer_blocks) {
+    state_->Flush(size_class, free_blocks, transfer_blocks);
+  }
+}
+
+void SlabArena::GetStats(AllocatorStats* stats) {
+  AllocatorStats result;
+
+  {
+    std::lock_guard<std::mutex> lock(state_->caches_mutex);
+    result.num_allocs = state_->retired_num_allocs;
+    result.bytes_in_use = state_->retired_bytes_in_use;
+    result.max_alloc_size = state_->retired_max_alloc_size;
+    for (const auto& cache : state_->caches) {
+      result.num_allocs += cache->num_allocs.load(std::memory_order_relaxed);
+      result.bytes_in_use += cache->bytes_allocated.load(std::memory_order_relaxed) -
+                             cache->bytes_freed.load(std::memory_order_relaxed);
+      result.max_alloc_size = std::max(result.max_alloc_size, cache->max_alloc_size.load(std::memory_order_relaxed));
+    }
+  }
+
+  result.num_reserves = state_->num_reserves.load(std::memory_order_relaxed);
+  result.num_arena_extensions = state_->num_slabs.load(std::memory_order_relaxed);
+  result.total_allocated_bytes = static_cast<int64_t>(state_->total_allocated_bytes.load(std::memory_order_relaxed));
+  result.max_bytes_in_use = std::max(result.bytes_in_use,
+                                     state_->max_checked_out_bytes.load(std::memory_order_relaxed));
+  result.bytes_limit = static_cast<int64_t>(state_->memory_limit);
+
+  *stats = result;
+}
+
+}  // namespace onnxruntime
@@ -0,0 +1,81 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "core/common/common.h"
+#include "core/framework/allocator.h"
+
+namespace onnxruntime {
+
+// A memory allocator that serves requests from fixed size classes.
+//
+// Every thread that allocates from the arena gets its own cache of free blocks per size class, so Alloc/Free
+// on the hot path only touch thread local state and do not take a lock. When a thread cache runs empty it
+// refills a batch of blocks from a shared pool for the size class, and when it holds too many free blocks it
+// returns a batch to the shared pool. The shared pool of a size class carves new blocks out of slabs obtained
+// from the underlying device allocator. Requests larger than the largest size class are forwarded to the
+// device allocator.
+//
+// Memory held in slabs is only returned to the device allocator when the arena is destroyed.
+//
+// This allocator reports OrtDeviceAllocator as its allocator type as code that sees OrtArenaAllocator assumes
+// it is dealing with a BFCArena (e.g. for Shrink() or stream aware allocations).
+class SlabArena : public IAllocator {
+ public:
+  static const size_t DEFAULT_MAX_MEM = std::numeric_limits<size_t>::max();
+
+  // Size of the header in front of every block. Keeps the blocks aligned to the preferred buffer alignment.
+  static constexpr size_t kHeaderSize = 64;
+  static constexpr size_t kMinBlockSize = 64;
+  static constexpr size_t kMaxBlockSize = 4 * 1024 * 1024;
+  // 4 size classes up to 256 bytes, then 4 size classes per power of two up to kMaxBlockSize.
+  static constexpr size_t kNumSizeClasses = 4 + 4 * 14;
+
+  SlabArena(std::unique_ptr<IAllocator> resource_allocator, size_t total_memory = DEFAULT_MAX_MEM);
+
+  ~SlabArena() override;
+
+  ORT_DISALLOW_COPY_ASSIGNMENT_AND_MOVE(SlabArena);
+
+  void* Alloc(size_t size) override;
+
+  // If p is NULL, no operation is performed.
+  void Free(void* p) override;
+
+  // Reserved memory is allocated directly from the device allocator and not cached on Free.
+  void* Reserve(size_t size) override;
+
+  // bytes_in_use is exact. max_bytes_in_use is the high-water mark of the memory handed out of the shared pools,
+  // which includes the blocks sitting in thread caches.
+  void GetStats(AllocatorStats* stats) override;
+
+  // Returns the index of the smallest size class that can hold `size` bytes,
+  // or kNumSizeClasses if `size` is larger than kMaxBlockSize.
+  static size_t SizeClassIndex(size_t size);
+
+  // Returns the block size of the size class at `index`.
+  static size_t SizeClassBlockSize(size_t index);
+
+  // Implementation details. Defined in slab_arena.cc.
+  struct State;
+  struct ThreadCache;
+
+ private:
+  ThreadCache& GetThreadCache();
+
+  void* AllocateLarge(size_t size, bool is_reserve);
+
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace onnxruntime
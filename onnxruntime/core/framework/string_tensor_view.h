@@ -0,0 +1,50 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <string_view>
+
+#include <gsl/gsl>
+
+#include "core/common/common.h"
+
+namespace onnxruntime {
+
+// Read-only view over strings stored one after the other in a single byte buffer with an array of start offsets,
+// the layout of OrtApi::GetStringTensorContent and of Arrow string arrays. String i spans
+// [offsets[i], offsets[i + 1]), the last string ends at the end of the buffer.
+// Neither the buffer nor the offsets are copied, both must outlive the view.
+class StringTensorView {
+ public:
+  StringTensorView() = default;
+
+  // Checks all the offsets once so the accessors do not need to.
+  static Status Create(gsl::span<const char> data, gsl::span<const size_t> offsets, StringTensorView& view) {
+    const size_t n = offsets.size();
+    for (size_t i = 0; i != n; ++i) {
+      const size_t end = i + 1 < n ? offsets[i + 1] : data.size();
+      if (offsets[i] > end || end > data.size()) {
+        return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT, "Offset ", i, " (", offsets[i],
+                               ") is out of order or beyond the buffer of ", data.size(), " bytes");
+      }
+    }
+
+    view.data_ = data;
+    view.offsets_ = offsets;
+    return Status::OK();
+  }
+
+  size_t size() const noexcept { return offsets_.size(); }
+
+  std::string_view operator[](size_t i) const {
+    const size_t end = i + 1 < offsets_.size() ? offsets_[i + 1] : data_.size();
+    return std::string_view(data_.data() + offsets_[i], end - offsets_[i]);
+  }
+
+ private:
+  gsl::span<const char> data_;
+  gsl::span<const size_t> offsets_;
+};
+
+}  // namespace onnxruntime
@@ -6,8 +6,10 @@
 #include <memory>
 #include <algorithm>
 #include <limits>
+#include <mutex>
 #include <string>
 #include <filesystem>
+#include <unordered_map>
 #if defined(__wasm__)
 #include <emscripten.h>
 #endif
@@ -1041,12 +1043,68 @@ static Status GetFileContent(const Env& env, const std::filesystem::path& file_p
   external_data.swap(raw_buffer);
   return Status::OK();
 }
+
+// Map the whole file at `file_path` into memory, or return the existing mapping of it.
+// A file is mapped at most once per process while any tensor refers to the mapping, so all the sessions that use
+// the file share the same pages. A file that was modified or replaced since it was mapped is mapped again.
+static Status GetSharedFileMapping(const Env& env, const std::filesystem::path& file_path,
+                                   std::shared_ptr<const char>& mapping, std::uintmax_t& file_length) {
+  struct SharedMapping {
+    std::weak_ptr<const char> mapping;
+    std::uintmax_t file_length;
+    std::filesystem::file_time_type last_write_time;
+  };
+
+  static std::mutex mutex;
+  static std::unordered_map<std::filesystem::path::string_type, SharedMapping> mappings;
+
+  std::error_code ec;
+  const std::filesystem::path canonical_path = std::filesystem::canonical(file_path, ec);
+  ORT_RETURN_IF(ec, "Failed to resolve ", file_path.string(), ": ", ec.message());
+  file_length = std::filesystem::file_size(canonical_path, ec);
+  ORT_RETURN_IF(ec, "Failed to get the size of ", file_path.string(), ": ", ec.message());
+  const auto last_write_time = std::filesystem::last_write_time(canonical_path, ec);
+  ORT_RETURN_IF(ec, "Failed to get the modification time of ", file_path.string(), ": ", ec.message());
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto& entry = mappings[canonical_path.native()];
+  mapping = entry.mapping.lock();
+  if (mapping && entry.file_length == file_length && entry.last_write_time == last_write_time) {
+    return Status::OK();
+  }
+
+  ORT_RETURN_IF(file_length > std::numeric_limits<size_t>::max(), "The file ", file_path.string(),
+                " is too large to be mapped");
+  Env::MappedMemoryPtr mapped_memory;
+  ORT_RETURN_IF_ERROR(env.MapFileIntoMemory(canonical_path.native().c_str(), 0, static_cast<size_t>(file_length),
+                                            mapped_memory));
+  ORT_RETURN_IF(mapped_memory == nullptr, "Failed to map the empty file ", file_path.string());
+
+  auto deleter = mapped_memory.get_deleter();
+  mapping = std::shared_ptr<const char>(mapped_memory.release(), [deleter](const char* p) {
+    deleter(const_cast<char*>(p));
+  });
+  entry = SharedMapping{mapping, file_length, last_write_time};
+
+  // drop the entries of the files that are not mapped anymore
+  for (auto it = mappings.begin(); it != mappings.end();) {
+    it = it->second.mapping.expired() ? mappings.erase(it) : std::next(it);
+  }
+
+  return Status::OK();
+}
+
+// Create a buffer that refers to the data at `offset` of a shared file mapping and keeps the mapping alive.
+static IAllocatorUniquePtr<void> CreateMappingView(const std::shared_ptr<const char>& mapping, FileOffsetType offset) {
+  return IAllocatorUniquePtr<void>(const_cast<char*>(mapping.get()) + offset, [mapping](void*) {});
+}
 #endif
 
 Status GetExtDataFromTensorProto(const Env& env,
                                  const std::filesystem::path& model_path,
                                  const ONNX_NAMESPACE::TensorProto& tensor_proto,
-                                 OrtValue& ort_value, PrepackedWeightsForGraph* prepacked_info) {
+                                 OrtValue& ort_value, PrepackedWeightsForGraph* prepacked_info,
+                                 bool use_shared_file_mapping) {
   ORT_ENFORCE(HasExternalData(tensor_proto), "TensorProto for: ",
               tensor_proto.name(), "Expected to have external data");
 
@@ -1082,6 +1140,7 @@ Status GetExtDataFromTensorProto(const Env& env,
     Tensor::InitOrtValue(std::move(tensor), ort_value);
   } else {
 #if defined(__wasm__)
+    ORT_UNUSED_PARAMETER(use_shared_file_mapping);
     ORT_RETURN_IF(file_offset < 0 || file_offset + raw_data_safe_len >= 4294967296,
                   "External initializer: ", tensor_proto.name(), " offset: ", file_offset,
                   " size to read: ", static_cast<size_t>(raw_data_safe_len),
@@ -1118,9 +1177,27 @@ Status GetExtDataFromTensorProto(const Env& env,
                   " size to read: ", static_cast<size_t>(raw_data_safe_len), " given file_length: ", file_length,
                   " are out of bounds or can not be read in full.");
 
+    // the data of a shared mapping must not be modified, so it is only used if no byte swapping is required
+    std::shared_ptr<const char> shared_mapping;
+    if constexpr (endian::native == endian::little) {
+      std::uintmax_t mapped_length = 0;
+      if (use_shared_file_mapping &&
+          (!GetSharedFileMapping(env, external_data_file_path, shared_mapping, mapped_length).IsOK() ||
+           mapped_length != file_length)) {
+        // fall back to mapping the data of the tensor only
+        shared_mapping.reset();
+      }
+    } else {
+      ORT_UNUSED_PARAMETER(use_shared_file_mapping);
+    }
+
     IAllocatorUniquePtr<void> ext_data_buf;
-    ORT_RETURN_IF_ERROR(GetFileContent(env, external_data_file_path, file_offset, raw_data_safe_len,
-                                       ext_data_buf));
+    if (shared_mapping) {
+      ext_data_buf = CreateMappingView(shared_mapping, file_offset);
+    } else {
+      ORT_RETURN_IF_ERROR(GetFileContent(env, external_data_file_path, file_offset, raw_data_safe_len,
+                                         ext_data_buf));
+    }
 
     // Data on disk is little endian
     if constexpr (endian::native != endian::little) {
@@ -1162,8 +1239,12 @@ Status GetExtDataFromTensorProto(const Env& env,
                         " is out of bounds and can not read in full");
 
           IAllocatorUniquePtr<void> data_ptr;
-          ORT_RETURN_IF_ERROR(GetFileContent(env, external_data_file_path, blob_offset, blob_length,
-                                             data_ptr));
+          if (shared_mapping) {
+            data_ptr = CreateMappingView(shared_mapping, blob_offset);
+          } else {
+            ORT_RETURN_IF_ERROR(GetFileContent(env, external_data_file_path, blob_offset, blob_length,
+                                               data_ptr));
+          }
           prepacked_weights.buffers_.push_back(std::move(data_ptr));
           prepacked_weights.buffer_sizes_.push_back(blob_length);
         }
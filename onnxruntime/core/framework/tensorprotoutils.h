@@ -215,10 +215,16 @@ constexpr const ORTCHAR_T* kTensorProtoMemoryAddressTag = ORT_TSTR("*/_ORT_MEM_A
 /// <param name="tensor_proto">tensor proto containing external data</param>
 /// <param name="ort_value">output ort value</param>
 /// <param name="prepacked_info">optional pre-packed weight data output container</param>
+/// <param name="use_shared_file_mapping">
+/// If true, the whole external data file is mapped once per process and the tensor is a view into that mapping,
+/// which is shared with all the other tensors and sessions that use the file. The data must not be modified.
+/// Otherwise only the data of the tensor is mapped.
+/// </param>
 /// <returns>Status</returns>
 common::Status GetExtDataFromTensorProto(const Env& env, const std::filesystem::path& model_path,
                                          const ONNX_NAMESPACE::TensorProto& tensor_proto,
-                                         OrtValue& ort_value, PrepackedWeightsForGraph* prepacked_info = nullptr);
+                                         OrtValue& ort_value, PrepackedWeightsForGraph* prepacked_info = nullptr,
+                                         bool use_shared_file_mapping = false);
 
 // Given a tensor proto with external data obtain a tensor using the specified custom external data loader.
 common::Status LoadExtDataToTensorFromTensorProto(const Env& env, const std::filesystem::path& model_path,
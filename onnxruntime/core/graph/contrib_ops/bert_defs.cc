@@ -378,6 +378,33 @@ void GroupQueryAttentionTypeAndShapeInference(ONNX_NAMESPACE::InferenceContext&
   // TODO(aciddelgado): propagate output shapes depending if kv-share buffer is on or not
   constexpr int use_max_past_present_buffer = -1;
   BaseGroupQueryAttentionTypeAndShapeInference(ctx, past_key_index, use_max_past_present_buffer, qk_output_index);
+
+  // T_CACHE is T unless the past and present key and value are quantized, then it is given by the bit width.
+  const int64_t kv_cache_bit_width = getAttribute(ctx, "kv_cache_bit_width", 0);
+  const auto query_type = ctx.getInputType(0)->tensor_type().elem_type();
+  const auto cache_type = kv_cache_bit_width == 0   ? query_type
+                          : kv_cache_bit_width == 4 ? ONNX_NAMESPACE::TensorProto::UINT8
+                                                    : ONNX_NAMESPACE::TensorProto::INT8;
+  for (size_t i = static_cast<size_t>(past_key_index); i < static_cast<size_t>(past_key_index) + 2; ++i) {
+    if (ctx.hasInput(i) && ctx.getInputType(i) != nullptr) {
+      const auto past_type = ctx.getInputType(i)->tensor_type().elem_type();
+      if (past_type != cache_type && past_type != ONNX_NAMESPACE::TensorProto::UNDEFINED &&
+          cache_type != ONNX_NAMESPACE::TensorProto::UNDEFINED) {
+        fail_type_inference("past_key and past_value shall have type ", cache_type,
+                            " for kv_cache_bit_width ", kv_cache_bit_width, ", got ", past_type);
+      }
+    }
+  }
+
+  if (kv_cache_bit_width != 0) {
+    if (ctx.getNumOutputs() >= 3) {
+      updateOutputElemType(ctx, 1, cache_type);
+      updateOutputElemType(ctx, 2, cache_type);
+    }
+    for (size_t i = 4; i < ctx.getNumOutputs(); ++i) {
+      updateOutputElemType(ctx, i, ONNX_NAMESPACE::TensorProto::FLOAT);
+    }
+  }
 }
 
 void SparseAttentionTypeAndShapeInference(ONNX_NAMESPACE::InferenceContext& ctx, int past_key_index) {
@@ -1129,6 +1156,10 @@ Only supports causal and local attention.
 Supports rotary position embedding for CPU and CUDA.
 Supports packed input for CPU and CUDA.
 Supports continuous decoding for batch_size == 1 for CPU and CUDA.
+Supports a past and present key and value quantized to 8 or 4 bits (kv_cache_bit_width) for CPU only. The other
+execution providers require T_CACHE to be T. Each token of each kv head is quantized with its own scale, computed when
+it is appended so that no value is clamped, and the scales are passed from present_key_scale and present_value_scale
+to past_key_scale and past_value_scale of the next run like the key and value.
 
 )DOC";
 
@@ -1166,6 +1197,14 @@ ONNX_MS_OPERATOR_SET_SCHEMA(
               "Output values of QK matrix multiplication before (1) or after (2) softmax normalization. Default value is 0 (don't output).",
               AttributeProto::INT,
               static_cast<int64_t>(QKOutputType::NO_OUTPUT))
+        .Attr("kv_cache_bit_width",
+              "Number of bits of the quantized past and present key and value: 8 stores them as int8 and 4 as uint8 "
+              "with two values per byte, the even channel in the low nibble, biased by 8. The values of a token of a "
+              "kv head are divided by its scale in past_key_scale/present_key_scale or past_value_scale/"
+              "present_value_scale. Only supported by the CPU execution provider. Default value is 0 meaning they are "
+              "not quantized and have type T.",
+              AttributeProto::INT,
+              static_cast<int64_t>(0))
         .Input(0,
                "query",
                "Query with shape (batch_size, sequence_length, hidden_size), or packed QKV with shape"
@@ -1185,13 +1224,13 @@ ONNX_MS_OPERATOR_SET_SCHEMA(
                "past_key",
                "past state key with support for format BNSH. When past_key uses same tensor as present_key"
                "(k-v cache), it is of length max_sequence_length... otherwise of length past_sequence_length.",
-               "T",
+               "T_CACHE",
                OpSchema::Optional)
         .Input(4,
                "past_value",
                "past state value with support for format BNSH. When past_value uses same tensor as present_value"
                "(k-v cache), it is of length max_sequence_length... otherwise of length past_sequence_length.",
-               "T",
+               "T_CACHE",
                OpSchema::Optional)
         .Input(5,
                "seqlens_k",
@@ -1228,6 +1267,18 @@ ONNX_MS_OPERATOR_SET_SCHEMA(
                "1D tensor with shape (num_heads). Each head has a smooth factor adding to the denominator of softmax.",
                "T",
                OpSchema::Optional)
+        .Input(12,
+               "past_key_scale",
+               "Scales of the quantized past key with shape (batch_size, kv_num_heads, past_sequence_length), one per "
+               "token of each kv head. Required with a past key when kv_cache_bit_width is not 0.",
+               "tensor(float)",
+               OpSchema::Optional)
+        .Input(13,
+               "past_value_scale",
+               "Scales of the quantized past value with shape (batch_size, kv_num_heads, past_sequence_length), one "
+               "per token of each kv head. Required with a past value when kv_cache_bit_width is not 0.",
+               "tensor(float)",
+               OpSchema::Optional)
         .Output(0,
                 "output",
                 "3D output tensor with shape (batch_size, sequence_length, hidden_size)",
@@ -1237,19 +1288,37 @@ ONNX_MS_OPERATOR_SET_SCHEMA(
                 "present state key with support for format BNSH. When past_key uses same tensor as present_key"
                 "(k-v buffer), it is of length max_sequence_length... otherwise of length past_sequence_length +"
                 "kv_sequence_length.",
-                "T")
+                "T_CACHE")
         .Output(2,
                 "present_value",
                 "present state value with support for format BNSH. When past_value uses same tensor as present_value"
                 "(k-v buffer), it is of length max_sequence_length... otherwise of length past_sequence_length +"
                 "kv_sequence_length.",
-                "T")
+                "T_CACHE")
         .Output(3,
                 "output_qk",
                 "Values of QK matrix multiplication, either before or after softmax normalization",
                 "T",
                 OpSchema::Optional)
+        .Output(4,
+                "present_key_scale",
+                "Scales of the quantized present key with shape (batch_size, kv_num_heads, present_sequence_length), "
+                "one per token of each kv head. Required when kv_cache_bit_width is not 0. May share its buffer with "
+                "past_key_scale like present_key with past_key.",
+                "tensor(float)",
+                OpSchema::Optional)
+        .Output(5,
+                "present_value_scale",
+                "Scales of the quantized present value with shape (batch_size, kv_num_heads, present_sequence_length), "
+                "one per token of each kv head. Required when kv_cache_bit_width is not 0. May share its buffer with "
+                "past_value_scale like present_value with past_value.",
+                "tensor(float)",
+                OpSchema::Optional)
         .TypeConstraint("T", {"tensor(float16)", "tensor(bfloat16)", "tensor(float)"}, "Constrain input and output to float tensors.")
+        .TypeConstraint("T_CACHE",
+                        {"tensor(float16)", "tensor(bfloat16)", "tensor(float)", "tensor(int8)", "tensor(uint8)"},
+                        "Constrain the past and present key and value to T, or to int8 (kv_cache_bit_width 8) and "
+                        "uint8 (kv_cache_bit_width 4) when quantized, which only the CPU execution provider supports.")
         .TypeConstraint("M", {"tensor(int32)"}, "Constrain mask to int tensor.")
         .TypeAndShapeInferenceFunction([](ONNX_NAMESPACE::InferenceContext& ctx) {
           GroupQueryAttentionTypeAndShapeInference(ctx, 3, 3);
@@ -1258,8 +1327,8 @@ ONNX_MS_OPERATOR_SET_SCHEMA(
 constexpr const char* PagedAttention_ver1_doc = R"DOC(
 Paged Attention.
 
-This op leverages a block-based KV cache to enable continuous batching for LLMs. Currently, it is designed to work with
-the CUDA Execution Provider only.
+This op leverages a block-based KV cache to enable continuous batching for LLMs. It is implemented by the CUDA and CPU
+Execution Providers. The CUDA kernel requires the block size to be a multiple of 256.
 
 In other attention ops, batch entries typically aren't of the same length, so they are padded.
 Below is a batch with 3 sequences where * denotes a padding token.
@@ -1445,7 +1514,7 @@ ONNX_MS_OPERATOR_SET_SCHEMA(
                 "the same tensor as value_cache.",
                 "T",
                 OpSchema::Optional)
-        .TypeConstraint("T", {"tensor(float16)", "tensor(bfloat16)"}, "Constrain input and output to float tensors.")
+        .TypeConstraint("T", {"tensor(float)", "tensor(float16)", "tensor(bfloat16)"}, "Constrain input and output to float tensors.")
         .TypeConstraint("S", {"tensor(int32)"}, "Constrain Positional inputs to int tensor.")
         .TypeAndShapeInferenceFunction([](ONNX_NAMESPACE::InferenceContext& ctx) {
           PagedAttentionTypeAndShapeInference(ctx);
@@ -1321,6 +1321,27 @@ ONNX_MS_OPERATOR_SET_SCHEMA(GreedySearch, 1,
                                       "This is relevant only for the GPT2 model. If this attribute is missing, the `decoder` subgraph will be used for all decoding runs",
                                       AttributeProto::GRAPH, OPTIONAL_VALUE)
                                 .Attr("decoder", "Decoder subgraph to execute in a loop.", AttributeProto::GRAPH)
+                                .Attr("continuous_batch_size",
+                                      "Maximum number of sequences decoded together. When a sequence is finished, the next sequence of "
+                                      "input_ids takes its place in the batch between two decoding steps. "
+                                      "Default value 0 decodes all the sequences of input_ids together. "
+                                      "Only decoder only models without past_present_share_buffer are supported, and "
+                                      "min_length, prefix_vocab_mask and presence_mask shall not be used",
+                                      AttributeProto::INT, static_cast<int64_t>(0))
+                                .Attr("draft_decoder",
+                                      "Subgraph of a smaller decoder sharing the vocabulary of `decoder`, used for speculative "
+                                      "decoding: it proposes num_draft_tokens tokens that `decoder` verifies in one decoding run. "
+                                      "This is relevant only for the GPT2 model without past_present_share_buffer on CPU",
+                                      AttributeProto::GRAPH, OPTIONAL_VALUE)
+                                .Attr("num_draft_tokens",
+                                      "Number of tokens proposed by `draft_decoder` in each speculative decoding step",
+                                      AttributeProto::INT, static_cast<int64_t>(4))
+                                .Attr("prefix_cache_bytes",
+                                      "Capacity in bytes of the cache of the past state of prompt prefixes shared by the "
+                                      "runs of the node: a prompt without padding starting with a cached prefix only "
+                                      "decodes the tokens after the prefix. 0 disables the cache. This is relevant only "
+                                      "for the GPT2 model with batch size 1 without past_present_share_buffer on CPU",
+                                      AttributeProto::INT, static_cast<int64_t>(0))
                                 .Attr("vocab_size",
                                       "Size of the vocabulary. "
                                       "If not provided, it will be inferred from the decoder subgraph's output shape",
@@ -1362,6 +1383,27 @@ ONNX_MS_OPERATOR_SET_SCHEMA(Sampling, 1,
                                       "This is relevant only for the GPT2 model. If this attribute is missing, the `decoder` subgraph will be used for all decoding runs",
                                       AttributeProto::GRAPH, OPTIONAL_VALUE)
                                 .Attr("decoder", "Decoder subgraph to execute in a loop.", AttributeProto::GRAPH)
+                                .Attr("continuous_batch_size",
+                                      "Maximum number of sequences decoded together. When a sequence is finished, the next sequence of "
+                                      "input_ids takes its place in the batch between two decoding steps. "
+                                      "Default value 0 decodes all the sequences of input_ids together. "
+                                      "Only decoder only models without past_present_share_buffer are supported, and "
+                                      "min_length, prefix_vocab_mask and presence_mask shall not be used",
+                                      AttributeProto::INT, static_cast<int64_t>(0))
+                                .Attr("draft_decoder",
+                                      "Subgraph of a smaller decoder sharing the vocabulary of `decoder`, used for speculative "
+                                      "decoding: it proposes num_draft_tokens tokens that `decoder` verifies in one decoding run. "
+                                      "This is relevant only for the GPT2 model without past_present_share_buffer on CPU",
+                                      AttributeProto::GRAPH, OPTIONAL_VALUE)
+                                .Attr("num_draft_tokens",
+                                      "Number of tokens proposed by `draft_decoder` in each speculative decoding step",
+                                      AttributeProto::INT, static_cast<int64_t>(4))
+                                .Attr("prefix_cache_bytes",
+                                      "Capacity in bytes of the cache of the past state of prompt prefixes shared by the "
+                                      "runs of the node: a prompt without padding starting with a cached prefix only "
+                                      "decodes the tokens after the prefix. 0 disables the cache. This is relevant only "
+                                      "for the GPT2 model with batch size 1 without past_present_share_buffer on CPU",
+                                      AttributeProto::INT, static_cast<int64_t>(0))
                                 .Attr("vocab_size",
                                       "Size of the vocabulary. "
                                       "If not provided, it will be inferred from the decoder subgraph's output shape",
@@ -1476,7 +1518,9 @@ ONNX_MS_OPERATOR_SET_SCHEMA(
                 "2D input tensor with shape (num_rows, hidden_size) or 3D input tensor with shape "
                 "(batch_size, sequence_length, hidden_size)",
                 "T")
-        .TypeConstraint("T", {"tensor(float16)"}, "Constrain input and output types to float or float16 tensors.")
+        .TypeConstraint("T",
+                        {"tensor(float)", "tensor(float16)"},
+                        "Constrain input and output types to float or float16 tensors.")
         .TypeConstraint("T1", {"tensor(uint8)"}, "Constrain weights type to uint8 tensors.")
         .TypeAndShapeInferenceFunction(ONNX_NAMESPACE::propagateShapeAndTypeFromFirstInput));
 
@@ -3442,6 +3486,11 @@ The quantization is performed using a bit-width specified by the 'bits' attribut
 
 The quantized weights are stored in a bit-packed format along the K dimension, with each block being represented by a blob of uint8.
 For example, for 4 bits, the first 4 bits are stored in the lower 4 bits of a byte, and the second 4 bits are stored in the higher 4 bits of a byte.
+
+The result may be followed by an epilogue, usually fused from the nodes consuming it:
+   Y = activation(A * dequantized_weight + bias) * multiplier + residual
+where the activation is specified by the 'activation' attribute, and 'multiplier' (e.g. the up projection of a SwiGLU)
+and 'residual' are optional inputs with the same shape as Y.
 )DOC";
 
   ONNX_CONTRIB_OPERATOR_SCHEMA(MatMulNBits)
@@ -3462,6 +3511,12 @@ For example, for 4 bits, the first 4 bits are stored in the lower 4 bits of a by
             "computation. 4 means input A can be quantized with the same block_size to int8 internally from "
             "type T1.",
             AttributeProto::INT, static_cast<int64_t>(0))
+      .Attr("activation",
+            "The activation applied to the result after the bias: Relu, Sigmoid, Gelu, FastGelu or QuickGelu "
+            "(default none).",
+            AttributeProto::STRING, OPTIONAL_VALUE)
+      .Attr("activation_alpha", "The alpha of the QuickGelu activation (default 1.702).",
+            AttributeProto::FLOAT, OPTIONAL_VALUE)
       .Input(0, "A", "The input tensor, not quantized.", "T1")
       .Input(1, "B",
              "Packed uint8 tensor of shape (N, k_blocks, blob_size), "
@@ -3477,6 +3532,10 @@ For example, for 4 bits, the first 4 bits are stored in the lower 4 bits of a by
              "T3", OpSchema::Optional)
       .Input(4, "g_idx", "group_idx. This input is deprecated", "T4", OpSchema::Optional)
       .Input(5, "bias", "Bias to add to result. It should have shape [N].", "T1", OpSchema::Optional)
+      .Input(6, "multiplier", "Tensor multiplying the result after the activation. It should have the shape of Y.",
+             "T1", OpSchema::Optional)
+      .Input(7, "residual", "Tensor added to the result after the multiplier. It should have the shape of Y.",
+             "T1", OpSchema::Optional)
       .Output(0, "Y", "tensor. The output tensor has the same rank as the input. ", "T1")
       .TypeConstraint("T1", {"tensor(float)", "tensor(float16)", "tensor(bfloat16)"},
                       "Constrain input and output types to float tensors.")
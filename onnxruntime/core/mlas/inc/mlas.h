@@ -1477,6 +1477,77 @@ MlasRotaryEmbedOneRow(
     T* output
 );
 
+/**
+ * @brief Quantize rows of a key or value cache to signed integers with one scale per row.
+ *        The scale of a row is its largest magnitude divided by 127 (8-bit) or 7 (4-bit), so
+ *        no value saturates, and row j is dequantized as Output[j][k] * Scale[j].
+ *        An 8-bit row is stored as Count int8 values. A 4-bit row packs two values per byte,
+ *        the even channel in the low nibble, each biased by 8 to [0, 15].
+ *
+ * @param BitWidth  4 or 8
+ * @param Input     rows to quantize, of shape [Rows, Count]
+ * @param Output    quantized rows, Count * BitWidth / 8 bytes each
+ * @param Scale     scales of the rows, of shape [Rows]
+ * @param Rows      number of rows
+ * @param Count     number of channels of a row, must be even when BitWidth is 4
+ */
+void
+MLASCALL
+MlasQuantizeKvCache(
+    size_t BitWidth,
+    const float* Input,
+    void* Output,
+    float* Scale,
+    size_t Rows,
+    size_t Count
+);
+
+/**
+ * @brief Compute the dot product of a vector with each row of a quantized key cache,
+ *        dequantizing the rows in registers: Output[j] = sum_k Input[k] * Keys[j][k].
+ *        The scales of the rows are expected to be applied to Output by the caller.
+ *
+ * @param BitWidth  4 or 8, as given to MlasQuantizeKvCache
+ * @param Input     vector of shape [Count]
+ * @param Keys      quantized rows, of shape [Rows, Count]
+ * @param Output    dot products, of shape [Rows]
+ * @param Rows      number of rows
+ * @param Count     number of channels of a row
+ */
+void
+MLASCALL
+MlasKvCacheDot(
+    size_t BitWidth,
+    const float* Input,
+    const void* Keys,
+    float* Output,
+    size_t Rows,
+    size_t Count
+);
+
+/**
+ * @brief Compute the weighted sum of the rows of a quantized value cache, dequantizing the
+ *        rows in registers: Output[k] = sum_j Weights[j] * Values[j][k]. The scales of the
+ *        rows are expected to be folded into Weights by the caller.
+ *
+ * @param BitWidth  4 or 8, as given to MlasQuantizeKvCache
+ * @param Weights   weights of the rows, of shape [Rows]
+ * @param Values    quantized rows, of shape [Rows, Count]
+ * @param Output    weighted sum, of shape [Count]
+ * @param Rows      number of rows
+ * @param Count     number of channels of a row
+ */
+void
+MLASCALL
+MlasKvCacheAccumulate(
+    size_t BitWidth,
+    const float* Weights,
+    const void* Values,
+    float* Output,
+    size_t Rows,
+    size_t Count
+);
+
 /**
  * @brief Supply matrices data information to half precision gemm functions
  */
@@ -1796,7 +1867,7 @@ MlasHalfGemmConvertPackB(
     void* PackedB
     );
 
-#if defined(__aarch64__) && defined(__linux__)
+#if defined(__linux__) && (defined(__aarch64__) || defined(__x86_64__))
 /**
  * @brief Whether current CPU supports Bfloat16(bf16) acceleration.
  */
@@ -2010,6 +2081,20 @@ struct MlasFlashAttentionThreadedArgs {
     const float* key;
     const float* value;
     float* output;
+
+    //
+    // Optional settings for grouped query attention. The defaults give plain multi-head attention over Q, K and V
+    // with shape (batch_size, num_heads, sequence_length, head_size).
+    //
+
+    int kv_num_heads = 0;                   // heads of K and V shared by num_heads / kv_num_heads query heads, 0 for num_heads
+    int kv_buffer_sequence_length = 0;      // sequence length of the K and V buffers, 0 for kv_sequence_length
+    size_t query_batch_stride = 0;          // distance between the batches of Q in elements, 0 if Q is contiguous
+    bool is_causal = false;                 // query i only attends to keys up to i + kv_sequence_length - q_sequence_length
+    int local_window_size = -1;             // when causal, number of keys left of the current one attended to, -1 for all
+    float softcap = 0.0f;                   // softcap applied to the scaled scores when positive
+    bool smooth_softmax = false;            // adds a sink of 0, or head_sink[head], to the softmax denominators
+    const float* head_sink = nullptr;       // per head sinks of the smooth softmax, with shape (num_heads)
 };
 
 /**
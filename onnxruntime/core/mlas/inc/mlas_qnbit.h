@@ -56,6 +56,54 @@ struct MLAS_QNBIT_GEMM_DATA_PARAMS {
     MLAS_GEMM_POSTPROCESSOR<T>* PostProcessor = nullptr;
 };
 
+/**
+ * @brief Define activation functions of the epilogue of the float/n-bit quantized int GEMM.
+ */
+typedef enum {
+    MlasQNBitGemmEpilogueIdentity,
+    MlasQNBitGemmEpilogueRelu,
+    MlasQNBitGemmEpilogueSigmoid,
+    MlasQNBitGemmEpilogueGelu,       /*!< x * 0.5 * (1 + erf(x / sqrt(2))) */
+    MlasQNBitGemmEpilogueFastGelu,   /*!< x * 0.5 * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3))) */
+    MlasQNBitGemmEpilogueQuickGelu,  /*!< x * sigmoid(alpha * x), SiLU when alpha is 1 */
+} MLAS_QNBIT_GEMM_EPILOGUE_ACTIVATION;
+
+/**
+ * @brief Epilogue of the float/n-bit quantized int GEMM, applied to each tile of the result matrix
+ *        after the bias while the tile is still in cache:
+ *
+ *        C = Activation(C) * Multiplier + Addend
+ *
+ *        Multiplier and Addend are optional matrices with the same shape as C, e.g. the up projection of a
+ *        SwiGLU and the residual of a transformer layer.
+ */
+class MLAS_QNBIT_GEMM_EPILOGUE : public MLAS_GEMM_POSTPROCESSOR<float>
+{
+   public:
+    MLAS_QNBIT_GEMM_EPILOGUE(
+        MLAS_QNBIT_GEMM_EPILOGUE_ACTIVATION Activation,
+        float Alpha,                /**< the alpha of the QuickGelu activation */
+        const float* Multiplier,    /**< optional address of the matrix multiplying the result */
+        size_t ldm,                 /**< the leading dimension of Multiplier */
+        const float* Addend,        /**< optional address of the matrix added to the result */
+        size_t ldd                  /**< the leading dimension of Addend */
+    )
+        : Activation_(Activation), Alpha_(Alpha), Multiplier_(Multiplier), ldm_(ldm), Addend_(Addend), ldd_(ldd)
+    {
+    }
+
+    void Process(float* C, size_t RangeStartM, size_t RangeStartN, size_t RangeCountM, size_t RangeCountN, size_t ldc)
+        const override;
+
+   private:
+    MLAS_QNBIT_GEMM_EPILOGUE_ACTIVATION Activation_;
+    float Alpha_;
+    const float* Multiplier_;
+    size_t ldm_;
+    const float* Addend_;
+    size_t ldd_;
+};
+
 /**
  * @brief Batched GEMM:  C = A * B + Bias
  *        A must be a float32/16 matrix
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <numeric>
 
 #include "mlasi.h"
@@ -29,6 +30,19 @@ MlasFlashAttentionThreaded(
     auto&& mlas_platform = GetMlasPlatform();
 #endif
 
+    ptrdiff_t kv_num_heads = args->kv_num_heads > 0 ? static_cast<ptrdiff_t>(args->kv_num_heads) : num_heads;
+    ptrdiff_t kv_buffer_sequence_length = args->kv_buffer_sequence_length > 0
+                                              ? static_cast<ptrdiff_t>(args->kv_buffer_sequence_length)
+                                              : kv_sequence_length;
+    ptrdiff_t query_batch_stride = args->query_batch_stride > 0
+                                       ? static_cast<ptrdiff_t>(args->query_batch_stride)
+                                       : num_heads * q_sequence_length * qk_head_size;
+    ptrdiff_t kv_num_heads_factor = num_heads / kv_num_heads;
+    // Under the causal mask, query i is at the position of key i + causal_offset.
+    ptrdiff_t causal_offset = kv_sequence_length - q_sequence_length;
+    ptrdiff_t local_window_size = args->is_causal ? static_cast<ptrdiff_t>(args->local_window_size) : -1;
+    bool has_sink = args->smooth_softmax || args->head_sink != nullptr;
+
     ptrdiff_t q_chunk_count = (q_sequence_length + (q_block_size - 1)) / q_block_size;
 
     ptrdiff_t task_start = 0;
@@ -50,18 +64,39 @@ MlasFlashAttentionThreaded(
         batch_idx /= q_chunk_count;
         ptrdiff_t head_idx = batch_idx % num_heads;
         batch_idx /= num_heads;
+        ptrdiff_t kv_head_idx = head_idx / kv_num_heads_factor;
+
+        ptrdiff_t row_size_q_capped = std::min(q_block_size, q_sequence_length - q_idx);
+
+        // The sink of the smooth softmax is a score without a value, so it starts the running max and sum.
+        float sink = std::numeric_limits<float>::lowest();
+        if (has_sink) {
+            sink = args->head_sink != nullptr ? args->head_sink[head_idx] : 0.0f;
+        }
 
         char* buffer_current_thread = reinterpret_cast<char*>(buffer) + thread_id * buffer_size_per_thread;
         float* l = reinterpret_cast<float*>(buffer_current_thread);
         float* m = l + q_block_size;
         for (ptrdiff_t t = 0; t < q_block_size; ++t) {
-            m[t] = std::numeric_limits<float>::lowest();
+            m[t] = sink;
+            l[t] = has_sink ? 1.0f : 0.0f;
         }
         float* intermediate = m + q_block_size;
         float* temp_output = intermediate + q_block_size * kv_block_size;
         float negmax = 0;
 
-        for (ptrdiff_t ir = 0; ir < kv_sequence_length; ir += kv_block_size) {
+        // Range of the keys attended to by any query of the block, so the blocks of keys that are masked out for all
+        // of them are skipped.
+        ptrdiff_t kv_start = 0;
+        ptrdiff_t kv_end = kv_sequence_length;
+        if (args->is_causal) {
+            kv_end = std::min(kv_end, q_idx + row_size_q_capped + causal_offset);
+            if (local_window_size >= 0) {
+                kv_start = std::max<ptrdiff_t>(0, q_idx + causal_offset - local_window_size);
+            }
+        }
+
+        for (ptrdiff_t ir = kv_start; ir < kv_end; ir += kv_block_size) {
             /*
                 S = Q[batch_idx, head_idx, q_idx:q_idx+q_block_size, :] * (K[batch_idx, head_idx, ir:ir+kv_block_size, :]).T
                 old_m = m
@@ -71,18 +106,17 @@ MlasFlashAttentionThreaded(
                 l = exp(diff) * l + rowsum(S)
                 O = diag(exp(diff)) * O + S * V[batch_idx, head_idx, ir:ir+kv_block_size, :]
             */
-            ptrdiff_t h = batch_idx * num_heads + head_idx;
-            const float* inputQ = query + (h * q_sequence_length + q_idx) * qk_head_size;
-            const float* inputK = key + (h * kv_sequence_length + ir) * qk_head_size;
-            const float* inputV = value + (h * kv_sequence_length + ir) * v_head_size;
+            const float* inputQ = query + batch_idx * query_batch_stride + (head_idx * q_sequence_length + q_idx) * qk_head_size;
+            const float* inputK = key + ((batch_idx * kv_num_heads + kv_head_idx) * kv_buffer_sequence_length + ir) * qk_head_size;
+            const float* inputV = value + ((batch_idx * kv_num_heads + kv_head_idx) * kv_buffer_sequence_length + ir) * v_head_size;
 
-            size_t row_size_q_capped = static_cast<size_t>(std::min(q_block_size, q_sequence_length - q_idx));
-            size_t row_size_kv_capped = static_cast<size_t>(std::min(kv_block_size, kv_sequence_length - ir));
+            ptrdiff_t row_size_kv_capped = std::min(kv_block_size, kv_end - ir);
+            bool is_first_kv_block = ir == kv_start;
 
             MlasSgemmOperation(CBLAS_TRANSPOSE::CblasNoTrans,
                      CBLAS_TRANSPOSE::CblasTrans,
-                     row_size_q_capped,
-                     row_size_kv_capped,
+                     static_cast<size_t>(row_size_q_capped),
+                     static_cast<size_t>(row_size_kv_capped),
                      static_cast<size_t>(qk_head_size),
                      args->scale,
                      inputQ,
@@ -91,15 +125,39 @@ MlasFlashAttentionThreaded(
                      static_cast<size_t>(qk_head_size),
                      0.0f,
                      intermediate,
-                     row_size_kv_capped);
+                     static_cast<size_t>(row_size_kv_capped));
 
-            for (ptrdiff_t irow = 0; irow < static_cast<ptrdiff_t>(row_size_q_capped); ++irow) {
+            for (ptrdiff_t irow = 0; irow < row_size_q_capped; ++irow) {
                 float* p = intermediate + irow * row_size_kv_capped;
 
+                // Columns of the block attended to by this query
+                ptrdiff_t col_start = 0;
+                ptrdiff_t col_end = row_size_kv_capped;
+                if (args->is_causal) {
+                    ptrdiff_t position = q_idx + irow + causal_offset;
+                    col_end = std::clamp<ptrdiff_t>(position + 1 - ir, 0, row_size_kv_capped);
+                    if (local_window_size >= 0) {
+                        col_start = std::clamp<ptrdiff_t>(position - local_window_size - ir, 0, col_end);
+                    }
+                }
+
+                std::fill(p, p + col_start, 0.0f);
+                std::fill(p + col_end, p + row_size_kv_capped, 0.0f);
+                if (col_start == col_end) {
+                    // Nothing to accumulate, and the zero scores leave O unchanged.
+                    continue;
+                }
+
+                float* valid = p + col_start;
+                size_t valid_count = static_cast<size_t>(col_end - col_start);
+                if (args->softcap > 0.0f) {
+                    MlasComputeSoftcap(valid, valid, valid_count, args->softcap);
+                }
+
 #if defined(MLAS_TARGET_AMD64) || defined(MLAS_TARGET_LARCH64)
-                float rowmax = mlas_platform.ReduceMaximumF32Kernel(p, row_size_kv_capped);
+                float rowmax = mlas_platform.ReduceMaximumF32Kernel(valid, valid_count);
 #else
-                float rowmax = MlasReduceMaximumF32Kernel(p, row_size_kv_capped);
+                float rowmax = MlasReduceMaximumF32Kernel(valid, valid_count);
 #endif
                 float m_diff = m[irow];
                 m[irow] = std::max(m[irow], rowmax);  // new m
@@ -107,45 +165,46 @@ MlasFlashAttentionThreaded(
                 m_diff -= m[irow];  // old - new (less than 0)
 
 #if defined(MLAS_TARGET_AMD64)
-                float rowsum = mlas_platform.ComputeSumExpF32Kernel(p, p, row_size_kv_capped, &negmax);
+                float rowsum = mlas_platform.ComputeSumExpF32Kernel(valid, valid, valid_count, &negmax);
 #else
-                float rowsum = MlasComputeSumExpF32Kernel(p, p, row_size_kv_capped, &negmax);
+                float rowsum = MlasComputeSumExpF32Kernel(valid, valid, valid_count, &negmax);
 #endif
 
-                // Note: for ir == 0, there is actually no need to calculate exp_diff
-                if (ir != 0) {
-                    float exp_diff = std::exp(m_diff);
-                    l[irow] = exp_diff * l[irow] + rowsum;
-
+                // exp_diff is 0 when nothing was accumulated yet, and there is no old result to scale in the first
+                // block because the product with V overwrites it.
+                float exp_diff = std::exp(m_diff);
+                l[irow] = exp_diff * l[irow] + rowsum;
+                if (!is_first_kv_block) {
                     for (ptrdiff_t icol = 0; icol < v_head_size; ++icol) {
                         temp_output[irow * v_head_size + icol] = exp_diff * temp_output[irow * v_head_size + icol];
                     }
-                } else {
-                    l[irow] = rowsum;
-                    // When ir == 0, there is no need to scale the old result because it is zero.
                 }
             }
             MlasSgemmOperation(CBLAS_TRANSPOSE::CblasNoTrans,
                      CBLAS_TRANSPOSE::CblasNoTrans,
-                     row_size_q_capped,
+                     static_cast<size_t>(row_size_q_capped),
                      static_cast<size_t>(v_head_size),
-                     row_size_kv_capped,
+                     static_cast<size_t>(row_size_kv_capped),
                      1.0f,
                      intermediate,
-                     row_size_kv_capped,
+                     static_cast<size_t>(row_size_kv_capped),
                      inputV,
                      static_cast<size_t>(v_head_size),
-                     ir == 0 ? 0.0f : 1.0f,
+                     is_first_kv_block ? 0.0f : 1.0f,
                      temp_output,
                      static_cast<size_t>(v_head_size));
         }
 
         float* output_row = output + ((batch_idx * q_sequence_length + q_idx) * num_heads + head_idx) * v_head_size;
-        ptrdiff_t row_size_q_valid = std::min(q_block_size, q_sequence_length - q_idx);
         // TODO: leverage advanced instruction sets
-        for (ptrdiff_t irow = 0; irow < row_size_q_valid; ++irow) {
-            for (ptrdiff_t icol = 0; icol < v_head_size; ++icol) {
-                output_row[icol] = temp_output[irow * v_head_size + icol] / l[irow];
+        for (ptrdiff_t irow = 0; irow < row_size_q_capped; ++irow) {
+            // A query that attends to no key has no output.
+            if (kv_start >= kv_end || l[irow] == 0.0f) {
+                std::fill(output_row, output_row + v_head_size, 0.0f);
+            } else {
+                for (ptrdiff_t icol = 0; icol < v_head_size; ++icol) {
+                    output_row[icol] = temp_output[irow * v_head_size + icol] / l[irow];
+                }
             }
             output_row += num_heads * v_head_size;
         }
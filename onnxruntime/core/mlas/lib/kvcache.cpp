@@ -0,0 +1,214 @@
+/*++
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+
+Licensed under the MIT License.
+
+Module Name:
+
+    kvcache.cpp
+
+Abstract:
+
+    This module implements the quantization of a key/value cache to 8-bit or
+    4-bit integers and the portable kernels computing attention over it.
+
+--*/
+
+#include <algorithm>
+#include <cmath>
+
+#include "kvcache.h"
+
+namespace {
+
+void
+MlasKvCacheDotS8_FallBack(
+    const float* Input,
+    const void* Keys,
+    float* Output,
+    size_t Rows,
+    size_t Count
+)
+{
+    const int8_t* row = static_cast<const int8_t*>(Keys);
+
+    for (size_t j = 0; j < Rows; j++) {
+        float sum = 0.0f;
+        for (size_t k = 0; k < Count; k++) {
+            sum += Input[k] * static_cast<float>(row[k]);
+        }
+        Output[j] = sum;
+        row += Count;
+    }
+}
+
+void
+MlasKvCacheDotS4_FallBack(
+    const float* Input,
+    const void* Keys,
+    float* Output,
+    size_t Rows,
+    size_t Count
+)
+{
+    const uint8_t* row = static_cast<const uint8_t*>(Keys);
+
+    for (size_t j = 0; j < Rows; j++) {
+        float sum = 0.0f;
+        for (size_t k = 0; k < Count; k += 2) {
+            const uint8_t packed = row[k / 2];
+            sum += Input[k] * static_cast<float>((packed & 0x0F) - MLAS_KVCACHE_S4_BIAS);
+            sum += Input[k + 1] * static_cast<float>((packed >> 4) - MLAS_KVCACHE_S4_BIAS);
+        }
+        Output[j] = sum;
+        row += Count / 2;
+    }
+}
+
+void
+MlasKvCacheAccumulateS8_FallBack(
+    const float* Weights,
+    const void* Values,
+    float* Output,
+    size_t Rows,
+    size_t Count
+)
+{
+    const int8_t* row = static_cast<const int8_t*>(Values);
+
+    std::fill_n(Output, Count, 0.0f);
+
+    for (size_t j = 0; j < Rows; j++) {
+        const float weight = Weights[j];
+        for (size_t k = 0; k < Count; k++) {
+            Output[k] += weight * static_cast<float>(row[k]);
+        }
+        row += Count;
+    }
+}
+
+void
+MlasKvCacheAccumulateS4_FallBack(
+    const float* Weights,
+    const void* Values,
+    float* Output,
+    size_t Rows,
+    size_t Count
+)
+{
+    const uint8_t* row = static_cast<const uint8_t*>(Values);
+
+    std::fill_n(Output, Count, 0.0f);
+
+    for (size_t j = 0; j < Rows; j++) {
+        const float weight = Weights[j];
+        for (size_t k = 0; k < Count; k += 2) {
+            const uint8_t packed = row[k / 2];
+            Output[k] += weight * static_cast<float>((packed & 0x0F) - MLAS_KVCACHE_S4_BIAS);
+            Output[k + 1] += weight * static_cast<float>((packed >> 4) - MLAS_KVCACHE_S4_BIAS);
+        }
+        row += Count / 2;
+    }
+}
+
+}  // namespace
+
+void
+MLASCALL
+MlasQuantizeKvCache(
+    size_t BitWidth,
+    const float* Input,
+    void* Output,
+    float* Scale,
+    size_t Rows,
+    size_t Count
+)
+{
+    if (BitWidth != 8 && BitWidth != 4) {
+        MLAS_THROW_EX(std::invalid_argument, "unsupported bit width of kv cache");
+    }
+
+    const float max_level = BitWidth == 8 ? 127.0f : 7.0f;
+    uint8_t* output = static_cast<uint8_t*>(Output);
+
+    for (size_t j = 0; j < Rows; j++) {
+        float max_magnitude = 0.0f;
+        for (size_t k = 0; k < Count; k++) {
+            max_magnitude = std::max(max_magnitude, std::fabs(Input[k]));
+        }
+
+        // a row of zeros is stored as zeros with a zero scale
+        const float inverse_scale = max_magnitude > 0.0f ? max_level / max_magnitude : 0.0f;
+        Scale[j] = max_magnitude / max_level;
+
+        auto quantize = [&](float value) {
+            return static_cast<int>(std::clamp(std::nearbyint(value * inverse_scale), -max_level, max_level));
+        };
+
+        if (BitWidth == 8) {
+            int8_t* row = reinterpret_cast<int8_t*>(output);
+            for (size_t k = 0; k < Count; k++) {
+                row[k] = static_cast<int8_t>(quantize(Input[k]));
+            }
+        } else {
+            for (size_t k = 0; k < Count; k += 2) {
+                output[k / 2] = static_cast<uint8_t>((quantize(Input[k]) + MLAS_KVCACHE_S4_BIAS) |
+                                                     ((quantize(Input[k + 1]) + MLAS_KVCACHE_S4_BIAS) << 4));
+            }
+        }
+
+        Input += Count;
+        output += Count * BitWidth / 8;
+    }
+}
+
+void
+MLASCALL
+MlasKvCacheDot(
+    size_t BitWidth,
+    const float* Input,
+    const void* Keys,
+    float* Output,
+    size_t Rows,
+    size_t Count
+)
+{
+    const auto* dispatch = GetMlasPlatform().KvCacheDispatch;
+
+    if (BitWidth == 8) {
+        auto* kernel = (dispatch != nullptr && dispatch->DotS8 != nullptr) ? dispatch->DotS8 : MlasKvCacheDotS8_FallBack;
+        kernel(Input, Keys, Output, Rows, Count);
+    } else if (BitWidth == 4) {
+        auto* kernel = (dispatch != nullptr && dispatch->DotS4 != nullptr) ? dispatch->DotS4 : MlasKvCacheDotS4_FallBack;
+        kernel(Input, Keys, Output, Rows, Count);
+    } else {
+        MLAS_THROW_EX(std::invalid_argument, "unsupported bit width of kv cache");
+    }
+}
+
+void
+MLASCALL
+MlasKvCacheAccumulate(
+    size_t BitWidth,
+    const float* Weights,
+    const void* Values,
+    float* Output,
+    size_t Rows,
+    size_t Count
+)
+{
+    const auto* dispatch = GetMlasPlatform().KvCacheDispatch;
+
+    if (BitWidth == 8) {
+        auto* kernel = (dispatch != nullptr && dispatch->AccumulateS8 != nullptr) ? dispatch->AccumulateS8
+                                                                                  : MlasKvCacheAccumulateS8_FallBack;
+        kernel(Weights, Values, Output, Rows, Count);
+    } else if (BitWidth == 4) {
+        auto* kernel = (dispatch != nullptr && dispatch->AccumulateS4 != nullptr) ? dispatch->AccumulateS4
+                                                                                  : MlasKvCacheAccumulateS4_FallBack;
+        kernel(Weights, Values, Output, Rows, Count);
+    } else {
+        MLAS_THROW_EX(std::invalid_argument, "unsupported bit width of kv cache");
+    }
+}
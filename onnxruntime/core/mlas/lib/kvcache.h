@@ -0,0 +1,55 @@
+/*++
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+
+Licensed under the MIT License.
+
+Module Name:
+
+    kvcache.h
+
+Abstract:
+
+    This module includes kernel function prototypes and helper functions for
+    computing attention over a quantized key/value cache.
+
+--*/
+
+#pragma once
+
+#include "mlasi.h"
+
+struct MLAS_KVCACHE_DISPATCH {
+    //
+    // Output[j] = sum_k Input[k] * Keys[j][k]
+    //
+    typedef void(Dot_Fn)(
+        const float* Input,
+        const void* Keys,
+        float* Output,
+        size_t Rows,
+        size_t Count
+    );
+
+    Dot_Fn* DotS8 = nullptr;
+    Dot_Fn* DotS4 = nullptr;
+
+    //
+    // Output[k] = sum_j Weights[j] * Values[j][k]
+    //
+    typedef void(Accumulate_Fn)(
+        const float* Weights,
+        const void* Values,
+        float* Output,
+        size_t Rows,
+        size_t Count
+    );
+
+    Accumulate_Fn* AccumulateS8 = nullptr;
+    Accumulate_Fn* AccumulateS4 = nullptr;
+};
+
+//
+// A 4-bit value is stored biased by 8 in a nibble.
+//
+constexpr int MLAS_KVCACHE_S4_BIAS = 8;
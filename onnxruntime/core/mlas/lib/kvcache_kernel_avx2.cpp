@@ -0,0 +1,274 @@
+/*++
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+
+Licensed under the MIT License.
+
+Module Name:
+
+    kvcache_kernel_avx2.cpp
+
+Abstract:
+
+    This module implements the kernels computing attention over a quantized
+    key/value cache for AVX2 supported h/w.
+
+--*/
+
+#include "kvcache.h"
+
+namespace {
+
+MLAS_FORCEINLINE
+float
+HorizontalSum(__m256 v)
+{
+    __m128 sum = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+    return _mm_cvtss_f32(sum);
+}
+
+MLAS_FORCEINLINE
+__m256
+ConvertS8ToFloat(__m128i v)
+{
+    return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(v));
+}
+
+//
+// Unpacks the 16 nibbles of the low 8 bytes of v to 16 bytes in channel order.
+//
+MLAS_FORCEINLINE
+__m128i
+UnpackS4(__m128i v)
+{
+    const __m128i low_mask = _mm_set1_epi8(0x0F);
+    const __m128i low = _mm_and_si128(v, low_mask);
+    const __m128i high = _mm_and_si128(_mm_srli_epi16(v, 4), low_mask);
+    return _mm_unpacklo_epi8(low, high);
+}
+
+MLAS_FORCEINLINE
+__m256
+ConvertBiasedS4ToFloat(__m128i v)
+{
+    const __m256i bias = _mm256_set1_epi32(MLAS_KVCACHE_S4_BIAS);
+    return _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_cvtepu8_epi32(v), bias));
+}
+
+void
+KvCacheDotS8Avx2(
+    const float* Input,
+    const void* Keys,
+    float* Output,
+    size_t Rows,
+    size_t Count
+)
+{
+    const int8_t* row = static_cast<const int8_t*>(Keys);
+
+    for (size_t j = 0; j < Rows; j++) {
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+
+        size_t k = 0;
+        for (; k + 16 <= Count; k += 16) {
+            const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + k));
+            acc0 = _mm256_fmadd_ps(ConvertS8ToFloat(v), _mm256_loadu_ps(Input + k), acc0);
+            acc1 = _mm256_fmadd_ps(ConvertS8ToFloat(_mm_srli_si128(v, 8)), _mm256_loadu_ps(Input + k + 8), acc1);
+        }
+        if (k + 8 <= Count) {
+            const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + k));
+            acc0 = _mm256_fmadd_ps(ConvertS8ToFloat(v), _mm256_loadu_ps(Input + k), acc0);
+            k += 8;
+        }
+
+        float sum = HorizontalSum(_mm256_add_ps(acc0, acc1));
+        for (; k < Count; k++) {
+            sum += Input[k] * static_cast<float>(row[k]);
+        }
+
+        Output[j] = sum;
+        row += Count;
+    }
+}
+
+void
+KvCacheDotS4Avx2(
+    const float* Input,
+    const void* Keys,
+    float* Output,
+    size_t Rows,
+    size_t Count
+)
+{
+    const uint8_t* row = static_cast<const uint8_t*>(Keys);
+
+    for (size_t j = 0; j < Rows; j++) {
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+
+        size_t k = 0;
+        for (; k + 16 <= Count; k += 16) {
+            const __m128i v = UnpackS4(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + k / 2)));
+            acc0 = _mm256_fmadd_ps(ConvertBiasedS4ToFloat(v), _mm256_loadu_ps(Input + k), acc0);
+            acc1 = _mm256_fmadd_ps(ConvertBiasedS4ToFloat(_mm_srli_si128(v, 8)), _mm256_loadu_ps(Input + k + 8), acc1);
+        }
+
+        float sum = HorizontalSum(_mm256_add_ps(acc0, acc1));
+        for (; k < Count; k += 2) {
+            const uint8_t packed = row[k / 2];
+            sum += Input[k] * static_cast<float>((packed & 0x0F) - MLAS_KVCACHE_S4_BIAS);
+            sum += Input[k + 1] * static_cast<float>((packed >> 4) - MLAS_KVCACHE_S4_BIAS);
+        }
+
+        Output[j] = sum;
+        row += Count / 2;
+    }
+}
+
+void
+KvCacheAccumulateS8Avx2(
+    const float* Weights,
+    const void* Values,
+    float* Output,
+    size_t Rows,
+    size_t Count
+)
+{
+    const int8_t* values = static_cast<const int8_t*>(Values);
+
+    //
+    // Keep a slice of 32 channels of the output in registers while reading the
+    // slice of every row.
+    //
+
+    size_t k = 0;
+    for (; k + 32 <= Count; k += 32) {
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps();
+        __m256 acc3 = _mm256_setzero_ps();
+
+        const int8_t* row = values + k;
+        for (size_t j = 0; j < Rows; j++) {
+            const __m256 weight = _mm256_broadcast_ss(Weights + j);
+            const __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+            const __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + 16));
+            acc0 = _mm256_fmadd_ps(weight, ConvertS8ToFloat(v0), acc0);
+            acc1 = _mm256_fmadd_ps(weight, ConvertS8ToFloat(_mm_srli_si128(v0, 8)), acc1);
+            acc2 = _mm256_fmadd_ps(weight, ConvertS8ToFloat(v1), acc2);
+            acc3 = _mm256_fmadd_ps(weight, ConvertS8ToFloat(_mm_srli_si128(v1, 8)), acc3);
+            row += Count;
+        }
+
+        _mm256_storeu_ps(Output + k, acc0);
+        _mm256_storeu_ps(Output + k + 8, acc1);
+        _mm256_storeu_ps(Output + k + 16, acc2);
+        _mm256_storeu_ps(Output + k + 24, acc3);
+    }
+
+    for (; k + 8 <= Count; k += 8) {
+        __m256 acc = _mm256_setzero_ps();
+
+        const int8_t* row = values + k;
+        for (size_t j = 0; j < Rows; j++) {
+            const __m128i v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row));
+            acc = _mm256_fmadd_ps(_mm256_broadcast_ss(Weights + j), ConvertS8ToFloat(v), acc);
+            row += Count;
+        }
+
+        _mm256_storeu_ps(Output + k, acc);
+    }
+
+    for (; k < Count; k++) {
+        float sum = 0.0f;
+        for (size_t j = 0; j < Rows; j++) {
+            sum += Weights[j] * static_cast<float>(values[j * Count + k]);
+        }
+        Output[k] = sum;
+    }
+}
+
+void
+KvCacheAccumulateS4Avx2(
+    const float* Weights,
+    const void* Values,
+    float* Output,
+    size_t Rows,
+    size_t Count
+)
+{
+    const uint8_t* values = static_cast<const uint8_t*>(Values);
+    const size_t row_bytes = Count / 2;
+
+    size_t k = 0;
+    for (; k + 32 <= Count; k += 32) {
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps();
+        __m256 acc3 = _mm256_setzero_ps();
+
+        const uint8_t* row = values + k / 2;
+        for (size_t j = 0; j < Rows; j++) {
+            const __m256 weight = _mm256_broadcast_ss(Weights + j);
+            const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row));
+            const __m128i v0 = UnpackS4(packed);
+            const __m128i v1 = UnpackS4(_mm_srli_si128(packed, 8));
+            acc0 = _mm256_fmadd_ps(weight, ConvertBiasedS4ToFloat(v0), acc0);
+            acc1 = _mm256_fmadd_ps(weight, ConvertBiasedS4ToFloat(_mm_srli_si128(v0, 8)), acc1);
+            acc2 = _mm256_fmadd_ps(weight, ConvertBiasedS4ToFloat(v1), acc2);
+            acc3 = _mm256_fmadd_ps(weight, ConvertBiasedS4ToFloat(_mm_srli_si128(v1, 8)), acc3);
+            row += row_bytes;
+        }
+
+        _mm256_storeu_ps(Output + k, acc0);
+        _mm256_storeu_ps(Output + k + 8, acc1);
+        _mm256_storeu_ps(Output + k + 16, acc2);
+        _mm256_storeu_ps(Output + k + 24, acc3);
+    }
+
+    for (; k + 16 <= Count; k += 16) {
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+
+        const uint8_t* row = values + k / 2;
+        for (size_t j = 0; j < Rows; j++) {
+            const __m256 weight = _mm256_broadcast_ss(Weights + j);
+            const __m128i v = UnpackS4(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row)));
+            acc0 = _mm256_fmadd_ps(weight, ConvertBiasedS4ToFloat(v), acc0);
+            acc1 = _mm256_fmadd_ps(weight, ConvertBiasedS4ToFloat(_mm_srli_si128(v, 8)), acc1);
+            row += row_bytes;
+        }
+
+        _mm256_storeu_ps(Output + k, acc0);
+        _mm256_storeu_ps(Output + k + 8, acc1);
+    }
+
+    for (; k < Count; k += 2) {
+        float sum0 = 0.0f;
+        float sum1 = 0.0f;
+        for (size_t j = 0; j < Rows; j++) {
+            const uint8_t packed = values[j * row_bytes + k / 2];
+            sum0 += Weights[j] * static_cast<float>((packed & 0x0F) - MLAS_KVCACHE_S4_BIAS);
+            sum1 += Weights[j] * static_cast<float>((packed >> 4) - MLAS_KVCACHE_S4_BIAS);
+        }
+        Output[k] = sum0;
+        Output[k + 1] = sum1;
+    }
+}
+
+}  // namespace
+
+//
+// Kernel dispatch structure definition.
+//
+const MLAS_KVCACHE_DISPATCH MlasKvCacheDispatchAvx2 = []() {
+    MLAS_KVCACHE_DISPATCH d;
+    d.DotS8 = KvCacheDotS8Avx2;
+    d.DotS4 = KvCacheDotS4Avx2;
+    d.AccumulateS8 = KvCacheAccumulateS8Avx2;
+    d.AccumulateS4 = KvCacheAccumulateS4Avx2;
+    return d;
+}();
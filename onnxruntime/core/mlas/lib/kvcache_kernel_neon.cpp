@@ -0,0 +1,252 @@
+/*++
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+
+Licensed under the MIT License.
+
+Module Name:
+
+    kvcache_kernel_neon.cpp
+
+Abstract:
+
+    This module implements the kernels computing attention over a quantized
+    key/value cache for ARM NEON.
+
+--*/
+
+#include "kvcache.h"
+
+namespace {
+
+MLAS_FORCEINLINE
+void
+ConvertS16ToFloat(int16x8_t v, float32x4_t& low, float32x4_t& high)
+{
+    low = vcvtq_f32_s32(vmovl_s16(vget_low_s16(v)));
+    high = vcvtq_f32_s32(vmovl_s16(vget_high_s16(v)));
+}
+
+//
+// Unpacks 8 bytes of biased nibbles to 16 signed values in channel order.
+//
+MLAS_FORCEINLINE
+void
+UnpackS4(uint8x8_t packed, int16x8_t& low, int16x8_t& high)
+{
+    const uint8x8_t low_nibbles = vand_u8(packed, vdup_n_u8(0x0F));
+    const uint8x8_t high_nibbles = vshr_n_u8(packed, 4);
+    const uint8x8x2_t zipped = vzip_u8(low_nibbles, high_nibbles);
+    const int16x8_t bias = vdupq_n_s16(MLAS_KVCACHE_S4_BIAS);
+    low = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(zipped.val[0])), bias);
+    high = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(zipped.val[1])), bias);
+}
+
+void
+KvCacheDotS8Neon(
+    const float* Input,
+    const void* Keys,
+    float* Output,
+    size_t Rows,
+    size_t Count
+)
+{
+    const int8_t* row = static_cast<const int8_t*>(Keys);
+
+    for (size_t j = 0; j < Rows; j++) {
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+
+        size_t k = 0;
+        for (; k + 8 <= Count; k += 8) {
+            float32x4_t v0, v1;
+            ConvertS16ToFloat(vmovl_s8(vld1_s8(row + k)), v0, v1);
+            acc0 = vfmaq_f32(acc0, v0, vld1q_f32(Input + k));
+            acc1 = vfmaq_f32(acc1, v1, vld1q_f32(Input + k + 4));
+        }
+
+        float sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+        for (; k < Count; k++) {
+            sum += Input[k] * static_cast<float>(row[k]);
+        }
+
+        Output[j] = sum;
+        row += Count;
+    }
+}
+
+void
+KvCacheDotS4Neon(
+    const float* Input,
+    const void* Keys,
+    float* Output,
+    size_t Rows,
+    size_t Count
+)
+{
+    const uint8_t* row = static_cast<const uint8_t*>(Keys);
+
+    for (size_t j = 0; j < Rows; j++) {
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+
+        size_t k = 0;
+        for (; k + 16 <= Count; k += 16) {
+            int16x8_t low, high;
+            UnpackS4(vld1_u8(row + k / 2), low, high);
+
+            float32x4_t v0, v1;
+            ConvertS16ToFloat(low, v0, v1);
+            acc0 = vfmaq_f32(acc0, v0, vld1q_f32(Input + k));
+            acc1 = vfmaq_f32(acc1, v1, vld1q_f32(Input + k + 4));
+            ConvertS16ToFloat(high, v0, v1);
+            acc0 = vfmaq_f32(acc0, v0, vld1q_f32(Input + k + 8));
+            acc1 = vfmaq_f32(acc1, v1, vld1q_f32(Input + k + 12));
+        }
+
+        float sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+        for (; k < Count; k += 2) {
+            const uint8_t packed = row[k / 2];
+            sum += Input[k] * static_cast<float>((packed & 0x0F) - MLAS_KVCACHE_S4_BIAS);
+            sum += Input[k + 1] * static_cast<float>((packed >> 4) - MLAS_KVCACHE_S4_BIAS);
+        }
+
+        Output[j] = sum;
+        row += Count / 2;
+    }
+}
+
+void
+KvCacheAccumulateS8Neon(
+    const float* Weights,
+    const void* Values,
+    float* Output,
+    size_t Rows,
+    size_t Count
+)
+{
+    const int8_t* values = static_cast<const int8_t*>(Values);
+
+    //
+    // Keep a slice of 16 channels of the output in registers while reading the
+    // slice of every row.
+    //
+
+    size_t k = 0;
+    for (; k + 16 <= Count; k += 16) {
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+        float32x4_t acc2 = vdupq_n_f32(0.0f);
+        float32x4_t acc3 = vdupq_n_f32(0.0f);
+
+        const int8_t* row = values + k;
+        for (size_t j = 0; j < Rows; j++) {
+            const int8x16_t v = vld1q_s8(row);
+            float32x4_t v0, v1, v2, v3;
+            ConvertS16ToFloat(vmovl_s8(vget_low_s8(v)), v0, v1);
+            ConvertS16ToFloat(vmovl_s8(vget_high_s8(v)), v2, v3);
+            acc0 = vfmaq_n_f32(acc0, v0, Weights[j]);
+            acc1 = vfmaq_n_f32(acc1, v1, Weights[j]);
+            acc2 = vfmaq_n_f32(acc2, v2, Weights[j]);
+            acc3 = vfmaq_n_f32(acc3, v3, Weights[j]);
+            row += Count;
+        }
+
+        vst1q_f32(Output + k, acc0);
+        vst1q_f32(Output + k + 4, acc1);
+        vst1q_f32(Output + k + 8, acc2);
+        vst1q_f32(Output + k + 12, acc3);
+    }
+
+    for (; k + 8 <= Count; k += 8) {
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+
+        const int8_t* row = values + k;
+        for (size_t j = 0; j < Rows; j++) {
+            float32x4_t v0, v1;
+            ConvertS16ToFloat(vmovl_s8(vld1_s8(row)), v0, v1);
+            acc0 = vfmaq_n_f32(acc0, v0, Weights[j]);
+            acc1 = vfmaq_n_f32(acc1, v1, Weights[j]);
+            row += Count;
+        }
+
+        vst1q_f32(Output + k, acc0);
+        vst1q_f32(Output + k + 4, acc1);
+    }
+
+    for (; k < Count; k++) {
+        float sum = 0.0f;
+        for (size_t j = 0; j < Rows; j++) {
+            sum += Weights[j] * static_cast<float>(values[j * Count + k]);
+        }
+        Output[k] = sum;
+    }
+}
+
+void
+KvCacheAccumulateS4Neon(
+    const float* Weights,
+    const void* Values,
+    float* Output,
+    size_t Rows,
+    size_t Count
+)
+{
+    const uint8_t* values = static_cast<const uint8_t*>(Values);
+    const size_t row_bytes = Count / 2;
+
+    size_t k = 0;
+    for (; k + 16 <= Count; k += 16) {
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+        float32x4_t acc2 = vdupq_n_f32(0.0f);
+        float32x4_t acc3 = vdupq_n_f32(0.0f);
+
+        const uint8_t* row = values + k / 2;
+        for (size_t j = 0; j < Rows; j++) {
+            int16x8_t low, high;
+            UnpackS4(vld1_u8(row), low, high);
+
+            float32x4_t v0, v1, v2, v3;
+            ConvertS16ToFloat(low, v0, v1);
+            ConvertS16ToFloat(high, v2, v3);
+            acc0 = vfmaq_n_f32(acc0, v0, Weights[j]);
+            acc1 = vfmaq_n_f32(acc1, v1, Weights[j]);
+            acc2 = vfmaq_n_f32(acc2, v2, Weights[j]);
+            acc3 = vfmaq_n_f32(acc3, v3, Weights[j]);
+            row += row_bytes;
+        }
+
+        vst1q_f32(Output + k, acc0);
+        vst1q_f32(Output + k + 4, acc1);
+        vst1q_f32(Output + k + 8, acc2);
+        vst1q_f32(Output + k + 12, acc3);
+    }
+
+    for (; k < Count; k += 2) {
+        float sum0 = 0.0f;
+        float sum1 = 0.0f;
+        for (size_t j = 0; j < Rows; j++) {
+            const uint8_t packed = values[j * row_bytes + k / 2];
+            sum0 += Weights[j] * static_cast<float>((packed & 0x0F) - MLAS_KVCACHE_S4_BIAS);
+            sum1 += Weights[j] * static_cast<float>((packed >> 4) - MLAS_KVCACHE_S4_BIAS);
+        }
+        Output[k] = sum0;
+        Output[k + 1] = sum1;
+    }
+}
+
+}  // namespace
+
+//
+// Kernel dispatch structure definition.
+//
+const MLAS_KVCACHE_DISPATCH MlasKvCacheDispatchNeon = []() {
+    MLAS_KVCACHE_DISPATCH d;
+    d.DotS8 = KvCacheDotS8Neon;
+    d.DotS4 = KvCacheDotS4Neon;
+    d.AccumulateS8 = KvCacheAccumulateS8Neon;
+    d.AccumulateS4 = KvCacheAccumulateS4Neon;
+    return d;
+}();
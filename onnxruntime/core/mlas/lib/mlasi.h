@@ -341,6 +341,18 @@ static_assert(sizeof(MLAS_FP16) == FP16_SIZE);
 #define MLAS_DGEMM_STRIDEN_THREAD_ALIGN             8
 #define MLAS_QGEMM_STRIDEN_THREAD_ALIGN             16
 
+//
+// Define the maximum number of columns and the maximum depth of the small
+// SGEMM kernels. The columns of an output row are held in registers for the
+// whole depth, and batches of problems below these limits are computed
+// without packing matrix B. A transposed matrix B is copied to a local buffer
+// of at most MLAS_SGEMM_SMALL_MAXIMUM_TRANSPOSE_NK elements.
+//
+
+#define MLAS_SGEMM_SMALL_MAXIMUM_N                  64
+#define MLAS_SGEMM_SMALL_MAXIMUM_K                  256
+#define MLAS_SGEMM_SMALL_MAXIMUM_TRANSPOSE_NK       (16 * 16)
+
 //
 // Define the prototypes of the platform optimized routines.
 //
@@ -440,6 +452,22 @@ size_t
 
 #endif
 
+typedef
+void
+(MLASCALL MLAS_SGEMM_SMALL_KERNEL)(
+    const float* A,
+    const float* B,
+    float* C,
+    size_t CountM,
+    size_t CountN,
+    size_t CountK,
+    size_t lda,
+    size_t ldb,
+    size_t ldc,
+    float alpha,
+    float beta
+    );
+
 typedef
 void
 (MLASCALL MLAS_GEMV_FLOAT_KERNEL)(
@@ -798,6 +826,8 @@ extern "C" {
     MLAS_GEMM_DOUBLE_KERNEL MlasGemmDoubleKernelAvx;
     MLAS_GEMM_DOUBLE_KERNEL MlasGemmDoubleKernelFma3;
     MLAS_GEMM_DOUBLE_KERNEL MlasGemmDoubleKernelAvx512F;
+    MLAS_SGEMM_SMALL_KERNEL MlasSgemmSmallKernelAvx2;
+    MLAS_SGEMM_SMALL_KERNEL MlasSgemmSmallKernelAvx512F;
 #endif
 #elif defined(MLAS_TARGET_POWER)
     MLAS_GEMM_FLOAT_KERNEL MlasSgemmKernel;
@@ -986,7 +1016,7 @@ extern "C" {
 #define MLAS_QGEMM_THREAD_COMPLEXITY                65536
 #define MLAS_HGEMM_THREAD_COMPLEXITY                65536
 
-#if defined(__aarch64__) && defined(__linux__)
+#if defined(__linux__) && (defined(__aarch64__) || defined(__x86_64__))
 #define MLAS_SBGEMM_THREAD_COMPLEXITY (size_t(64) * size_t(1024))
 #endif
 
@@ -1098,6 +1128,8 @@ extern const MLAS_QNBIT_GEMM_DISPATCH MlasSQNBitGemmDispatchAvx512;
 
 extern const MLAS_QNBIT_GEMM_DISPATCH MlasSQNBitGemmDispatchAvx512vnni;
 
+extern const MLAS_QNBIT_GEMM_DISPATCH MlasSQNBitGemmDispatchAmx;
+
 //
 // Rotary embedding dispatch structure.
 //
@@ -1105,12 +1137,25 @@ struct MLAS_ROPE_DISPATCH;
 extern const MLAS_ROPE_DISPATCH MlasRopeDispatchNeon;
 extern const MLAS_ROPE_DISPATCH MlasRopeDispatchAvx2;
 
+//
+// Quantized key/value cache dispatch structure.
+//
+struct MLAS_KVCACHE_DISPATCH;
+extern const MLAS_KVCACHE_DISPATCH MlasKvCacheDispatchNeon;
+extern const MLAS_KVCACHE_DISPATCH MlasKvCacheDispatchAvx2;
+
 //
 // half gemm dispatch structure
 //
 struct MLAS_HGEMM_DISPATCH;
 extern const MLAS_HGEMM_DISPATCH MlasHGemmDispatchNeon;
 
+//
+// bfloat16 gemm dispatch structure
+//
+struct MLAS_SBGEMM_DISPATCH;
+extern const MLAS_SBGEMM_DISPATCH MlasSBGemmDispatchAmx;
+
 // softmax dispatch structure
 struct MLAS_SOFTMAX_DISPATCH;
 extern const MLAS_SOFTMAX_DISPATCH MlasSoftmaxDispatchNeon;
@@ -1286,7 +1331,12 @@ struct MLAS_PLATFORM {
     MLAS_CAST_F32_TO_F16_KERNEL* CastF32ToF16Kernel;
 
     const MLAS_ROPE_DISPATCH* RopeDispatch{nullptr};
+    const MLAS_KVCACHE_DISPATCH* KvCacheDispatch{nullptr};
     const MLAS_HGEMM_DISPATCH* HGemmDispatch{nullptr};
+    const MLAS_SBGEMM_DISPATCH* SBGemmDispatch{nullptr};
+#if defined(MLAS_TARGET_AMD64)
+    MLAS_SGEMM_SMALL_KERNEL* SgemmSmallKernel{nullptr};
+#endif
     const MLAS_SOFTMAX_DISPATCH* SoftmaxDispatch{nullptr};
     const MLAS_ELTWISE_DISPATCH* EltwiseDispatch{nullptr};
 };
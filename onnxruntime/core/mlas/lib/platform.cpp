@@ -387,6 +387,7 @@ Return Value:
 
                 this->GemmFloatKernel = MlasGemmFloatKernelFma3;
                 this->GemmDoubleKernel = MlasGemmDoubleKernelFma3;
+                this->SgemmSmallKernel = MlasSgemmSmallKernelAvx2;
                 this->ConvNchwFloatKernel = MlasConvNchwFloatKernelFma3;
                 this->ConvNchwcFloatKernel = MlasConvNchwcFloatKernelFma3;
                 this->ConvDepthwiseFloatKernel = MlasConvDepthwiseFloatKernelFma3;
@@ -406,6 +407,7 @@ Return Value:
                 this->CastF16ToF32Kernel = &MlasCastF16ToF32KernelAvx2;
                 this->CastF32ToF16Kernel = &MlasCastF32ToF16KernelAvx2;
                 this->RopeDispatch = &MlasRopeDispatchAvx2;
+                this->KvCacheDispatch = &MlasKvCacheDispatchAvx2;
 
 
                 //
@@ -447,6 +449,7 @@ Return Value:
 
                     this->GemmFloatKernel = MlasGemmFloatKernelAvx512F;
                     this->GemmDoubleKernel = MlasGemmDoubleKernelAvx512F;
+                    this->SgemmSmallKernel = MlasSgemmSmallKernelAvx512F;
                     this->ConvNchwFloatKernel = MlasConvNchwFloatKernelAvx512F;
                     this->ConvNchwcFloatKernel = MlasConvNchwcFloatKernelAvx512F;
                     this->ConvDepthwiseFloatKernel = MlasConvDepthwiseFloatKernelAvx512F;
@@ -526,6 +529,24 @@ Return Value:
                     if (MlasInitAMX()) {
                         this->GemmU8U8Dispatch = &MlasGemmU8S8DispatchAmx;
                         this->GemmU8S8Dispatch = &MlasGemmU8S8DispatchAmx;
+
+                        //
+                        // The 4-bit quantized GEMM tile kernel shares the
+                        // AVX512VNNI kernels for the other compute types.
+                        //
+                        if (this->QNBitGemmDispatch == &MlasSQNBitGemmDispatchAvx512vnni) {
+                            this->QNBitGemmDispatch = &MlasSQNBitGemmDispatchAmx;
+                        }
+
+#if defined(__linux__)
+                        //
+                        // Check if the processor supports AMX-BF16 and
+                        // AVX512-BF16 features.
+                        //
+                        if ((Cpuid7[3] & 0b1 << 22) != 0 && (Cpuid7_1[0] & 0b1 << 5) != 0) {
+                            this->SBGemmDispatch = &MlasSBGemmDispatchAmx;
+                        }
+#endif
                     }
                 }
 #endif // __APPLE__
@@ -550,6 +571,7 @@ Return Value:
     this->ConvSymU8S8Dispatch = &MlasConvSymU8DispatchNeon;
     this->ConvSymS8S8Dispatch = &MlasConvSymS8DispatchNeon;
     this->RopeDispatch = &MlasRopeDispatchNeon;
+    this->KvCacheDispatch = &MlasKvCacheDispatchNeon;
     this->HGemmDispatch = &MlasHGemmDispatchNeon;
     this->SoftmaxDispatch = &MlasSoftmaxDispatchNeon;
     this->EltwiseDispatch = &MlasEltwiseDispatchNeon;
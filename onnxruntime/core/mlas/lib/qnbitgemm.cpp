@@ -587,6 +587,12 @@ SQ4BitGemm_CompInt8(
         SQ4BitGemm(BlkLen, QuantA, DataParams->PackedQuantBData,
             DataParams->C, RangeStartM, RangeCountM, RangeStartN, RangeCountN, K,
             DataParams->ldc, DataParams->Bias);
+        if (DataParams->PostProcessor != nullptr) {
+            DataParams->PostProcessor->Process(
+                DataParams->C, RangeStartM, RangeStartN,
+                RangeCountM, RangeCountN, DataParams->ldc
+            );
+        }
         return;
     }
 
@@ -979,6 +985,132 @@ GetQNBitGemm(QNBitGemmVariant variant)
 }
 }  // namespace
 
+void
+MLAS_QNBIT_GEMM_EPILOGUE::Process(
+    float* C,
+    size_t RangeStartM,
+    size_t RangeStartN,
+    size_t RangeCountM,
+    size_t RangeCountN,
+    size_t ldc
+) const
+{
+    //
+    // The columns of each row are processed in chunks that fit a buffer on the stack, so that the activation,
+    // the multiplication and the addition all run while the chunk is in the L1 cache.
+    //
+
+    constexpr size_t ChunkN = 128;
+    MLAS_DECLSPEC_ALIGN(float Buffer[ChunkN], 64);
+
+    const MLAS_FLOAT32X4 ZeroVector = MlasZeroFloat32x4();
+    const MLAS_FLOAT32X4 HalfVector = MlasBroadcastFloat32x4(0.5f);
+    const MLAS_FLOAT32X4 OneVector = MlasBroadcastFloat32x4(1.0f);
+
+    for (size_t m = RangeStartM; m < RangeStartM + RangeCountM; m++) {
+        for (size_t n = RangeStartN; n < RangeStartN + RangeCountN; n += ChunkN) {
+            const size_t CountN = std::min(ChunkN, RangeStartN + RangeCountN - n);
+            float* c = C + m * ldc + n;
+            size_t i;
+
+            switch (Activation_) {
+                case MlasQNBitGemmEpilogueIdentity:
+                    break;
+
+                case MlasQNBitGemmEpilogueRelu: {
+                    for (i = 0; i + 4 <= CountN; i += 4) {
+                        MlasStoreFloat32x4(c + i, MlasMaximumFloat32x4(MlasLoadFloat32x4(c + i), ZeroVector));
+                    }
+                    for (; i < CountN; i++) {
+                        c[i] = std::max(c[i], 0.0f);
+                    }
+                    break;
+                }
+
+                case MlasQNBitGemmEpilogueSigmoid: {
+                    MlasComputeLogistic(c, c, CountN);
+                    break;
+                }
+
+                case MlasQNBitGemmEpilogueGelu: {
+                    constexpr float InvSqrt2 = 0.70710678118654752f;
+                    for (i = 0; i < CountN; i++) {
+                        Buffer[i] = c[i] * InvSqrt2;
+                    }
+                    MlasComputeErf(Buffer, Buffer, CountN);
+                    for (i = 0; i + 4 <= CountN; i += 4) {
+                        MLAS_FLOAT32X4 x = MlasLoadFloat32x4(c + i);
+                        MLAS_FLOAT32X4 e = MlasAddFloat32x4(MlasLoadFloat32x4(Buffer + i), OneVector);
+                        MlasStoreFloat32x4(c + i, MlasMultiplyFloat32x4(MlasMultiplyFloat32x4(x, HalfVector), e));
+                    }
+                    for (; i < CountN; i++) {
+                        c[i] = 0.5f * c[i] * (Buffer[i] + 1.0f);
+                    }
+                    break;
+                }
+
+                case MlasQNBitGemmEpilogueFastGelu: {
+                    constexpr float Sqrt2OverPi = 0.79788456080286536f;
+                    constexpr float Coefficient = 0.044715f;
+                    for (i = 0; i < CountN; i++) {
+                        Buffer[i] = Sqrt2OverPi * c[i] * (1.0f + Coefficient * c[i] * c[i]);
+                    }
+                    MlasComputeTanh(Buffer, Buffer, CountN);
+                    for (i = 0; i + 4 <= CountN; i += 4) {
+                        MLAS_FLOAT32X4 x = MlasLoadFloat32x4(c + i);
+                        MLAS_FLOAT32X4 t = MlasAddFloat32x4(MlasLoadFloat32x4(Buffer + i), OneVector);
+                        MlasStoreFloat32x4(c + i, MlasMultiplyFloat32x4(MlasMultiplyFloat32x4(x, HalfVector), t));
+                    }
+                    for (; i < CountN; i++) {
+                        c[i] = 0.5f * c[i] * (Buffer[i] + 1.0f);
+                    }
+                    break;
+                }
+
+                case MlasQNBitGemmEpilogueQuickGelu: {
+                    for (i = 0; i < CountN; i++) {
+                        Buffer[i] = Alpha_ * c[i];
+                    }
+                    MlasComputeLogistic(Buffer, Buffer, CountN);
+                    for (i = 0; i + 4 <= CountN; i += 4) {
+                        MlasStoreFloat32x4(
+                            c + i, MlasMultiplyFloat32x4(MlasLoadFloat32x4(c + i), MlasLoadFloat32x4(Buffer + i))
+                        );
+                    }
+                    for (; i < CountN; i++) {
+                        c[i] *= Buffer[i];
+                    }
+                    break;
+                }
+            }
+
+            if (Multiplier_ != nullptr) {
+                const float* multiplier = Multiplier_ + m * ldm_ + n;
+                for (i = 0; i + 4 <= CountN; i += 4) {
+                    MlasStoreFloat32x4(
+                        c + i, MlasMultiplyFloat32x4(MlasLoadFloat32x4(c + i), MlasLoadFloat32x4(multiplier + i))
+                    );
+                }
+                for (; i < CountN; i++) {
+                    c[i] *= multiplier[i];
+                }
+            }
+
+            if (Addend_ != nullptr) {
+                const float* addend = Addend_ + m * ldd_ + n;
+                for (i = 0; i + 4 <= CountN; i += 4) {
+                    MlasStoreFloat32x4(
+                        c + i, MlasAddFloat32x4(MlasLoadFloat32x4(c + i), MlasLoadFloat32x4(addend + i))
+                    );
+                }
+                for (; i < CountN; i++) {
+                    c[i] += addend[i];
+                }
+            }
+        }
+    }
+}
+
 template <typename T>
 void MLASCALL
 MlasQNBitGemmBatch(
@@ -0,0 +1,274 @@
+/*++
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+
+Licensed under the MIT License.
+
+Module Name:
+
+    sbgemm_kernel_amx.cpp
+
+Abstract:
+
+    This module implements bfloat16 precision GEMM kernel for amx.
+
+    Matrix A is converted to bfloat16 on the fly and matrix B is packed in
+    the pair interleaved layout of the AMX-BF16 tiles: 16 columns by 32 rows
+    of bfloat16 values fill a 16 rows by 64 bytes tile.
+
+--*/
+
+#if defined(__x86_64__) && defined(__linux__)
+
+#include "mlasi.h"
+#include "sbgemm.h"
+#include "amx_common.h"
+
+#define TMM0 0
+#define TMM1 1
+#define TMM2 2
+#define TMM3 3
+#define TMM4 4
+#define TMM5 5
+#define TMM6 6
+#define TMM7 7
+
+#define TILE_M 16
+#define TILE_N 16
+#define TILE_K 32
+
+struct MLAS_SBGEMM_KERNEL_AMX {
+    static constexpr bool PackNeeded = true;
+    static constexpr size_t KernelMaxM = 2 * TILE_M;  // max # rows the tile kernel can process
+    static constexpr size_t PackedK = TILE_K;
+    static constexpr size_t PackedN = MLAS_SGEMM_STRIDEN_THREAD_ALIGN;
+    static constexpr MLAS_SBGEMM_STRIDES Strides{128, 128, 256};  // M:N:K
+};
+
+static_assert(MLAS_SBGEMM_KERNEL_AMX::PackedN == TILE_N, "packed columns shall fill a tile");
+
+bool MLASCALL
+MlasBf16AccelerationSupported()
+{
+    return GetMlasPlatform().SBGemmDispatch != nullptr;
+}
+
+MLAS_FORCEINLINE
+__mmask16
+MlasSBGemmMask(size_t Count)
+{
+    return (Count >= 16) ? __mmask16(0xFFFF) : __mmask16((1u << Count) - 1);
+}
+
+/*
+    This routine converts fp32 to bf16 and copies elements from the source
+    matrix to the destination packed buffer.
+
+    Each group of 16 columns is stored as pairs of rows: the two values of a
+    column in rows 2k and 2k+1 are adjacent, so that 32 rows of the group
+    form a tile. The rows are padded to 32 and the columns to 16 with zeros.
+*/
+MLAS_FORCEINLINE
+void
+MlasSBGemmConvertCopyPackB(bfloat16_t* D, const float* B, size_t ldb, size_t CountN, size_t CountK)
+{
+    const size_t AlignedK = (CountK + TILE_K - 1) & ~(TILE_K - 1);
+    const __m512i InterleaveIndex = _mm512_set_epi16(
+        31, 15, 30, 14, 29, 13, 28, 12, 27, 11, 26, 10, 25, 9, 24, 8,
+        23, 7, 22, 6, 21, 5, 20, 4, 19, 3, 18, 2, 17, 1, 16, 0
+    );
+
+    for (size_t n = 0; n < CountN; n += TILE_N) {
+        const __mmask16 Mask = MlasSBGemmMask(CountN - n);
+        const float* b = B + n;
+
+        for (size_t k = 0; k < AlignedK; k += 2) {
+            __m512 Row0 = _mm512_setzero_ps();
+            __m512 Row1 = _mm512_setzero_ps();
+            if (k < CountK) {
+                Row0 = _mm512_maskz_loadu_ps(Mask, b + k * ldb);
+            }
+            if (k + 1 < CountK) {
+                Row1 = _mm512_maskz_loadu_ps(Mask, b + (k + 1) * ldb);
+            }
+
+            __m512i Pairs = (__m512i)_mm512_cvtne2ps_pbh(Row1, Row0);
+            Pairs = _mm512_permutexvar_epi16(InterleaveIndex, Pairs);
+            _mm512_storeu_si512(D + k * TILE_N, Pairs);
+        }
+
+        D += AlignedK * TILE_N;
+    }
+}
+
+template <>
+void
+MlasSBGemmConvertPackB<MLAS_SBGEMM_KERNEL_AMX>(
+    bfloat16_t* PackedB, const float* B, size_t ldb, size_t CountN, size_t CountK
+)
+{
+    constexpr size_t PackedN = MLAS_SBGEMM_KERNEL_AMX::PackedN;
+    const size_t AlignedN = (CountN + PackedN - 1) & ~(PackedN - 1);
+
+    //
+    // Step through each slice of matrix B along the K dimension.
+    //
+    size_t K_block_size;
+    constexpr MLAS_SBGEMM_STRIDES Strides = MLAS_SBGEMM_KERNEL_AMX::Strides;
+
+    for (size_t k = 0; k < CountK; k += K_block_size) {
+        K_block_size = std::min(CountK - k, Strides.K);
+
+        MlasSBGemmConvertCopyPackB(PackedB, B + k * ldb, ldb, CountN, K_block_size);
+        PackedB += AlignedN * K_block_size;
+    }
+}
+
+/*
+    This routine converts rows of matrix A to bf16 with the columns padded to
+    AlignedK and the rows padded to PaddedM with zeros.
+*/
+MLAS_FORCEINLINE
+void
+MlasSBGemmConvertA(
+    bfloat16_t* D, const float* A, size_t lda, size_t CountM, size_t PaddedM, size_t CountK, size_t AlignedK
+)
+{
+    for (size_t m = 0; m < CountM; m++) {
+        const float* a = A + m * lda;
+        bfloat16_t* d = D + m * AlignedK;
+
+        for (size_t k = 0; k < AlignedK; k += 16) {
+            const __mmask16 Mask = (k < CountK) ? MlasSBGemmMask(CountK - k) : __mmask16(0);
+            const __m512 Values = _mm512_maskz_loadu_ps(Mask, a + k);
+            _mm256_storeu_si256((__m256i*)(d + k), (__m256i)_mm512_cvtneps_pbh(Values));
+        }
+    }
+
+    if (PaddedM > CountM) {
+        std::fill_n(D + CountM * AlignedK, (PaddedM - CountM) * AlignedK, bfloat16_t(0));
+    }
+}
+
+/*
+    This routine adds a 16x16 tile of results to matrix C. The bias is added
+    and matrix C overwritten when ZeroMode is set.
+*/
+MLAS_FORCEINLINE
+void
+MlasSBGemmStoreTile(
+    const float* Tile, float* C, size_t ldc, size_t CountM, size_t CountN, const float* Bias, bool ZeroMode
+)
+{
+    const __mmask16 Mask = MlasSBGemmMask(CountN);
+
+    if (ZeroMode) {
+        const __m512 BiasVector = (Bias == nullptr) ? _mm512_setzero_ps() : _mm512_maskz_loadu_ps(Mask, Bias);
+        for (size_t m = 0; m < CountM; m++) {
+            const __m512 Values = _mm512_add_ps(_mm512_load_ps(Tile + m * TILE_N), BiasVector);
+            _mm512_mask_storeu_ps(C + m * ldc, Mask, Values);
+        }
+    } else {
+        for (size_t m = 0; m < CountM; m++) {
+            const __m512 Values = _mm512_add_ps(_mm512_load_ps(Tile + m * TILE_N), _mm512_maskz_loadu_ps(Mask, C + m * ldc));
+            _mm512_mask_storeu_ps(C + m * ldc, Mask, Values);
+        }
+    }
+}
+
+template <>
+MLAS_FORCEINLINE void
+MlasSBGemmKernel<MLAS_SBGEMM_KERNEL_AMX>(size_t CountM, size_t CountN, size_t CountK, const float* A, size_t lda, const bfloat16_t* B, float* C, size_t ldc, const float* Bias, const bool ZeroMode)
+{
+    constexpr size_t KernelMaxM = MLAS_SBGEMM_KERNEL_AMX::KernelMaxM;
+    constexpr size_t StrideK = MLAS_SBGEMM_KERNEL_AMX::Strides.K;
+    constexpr size_t PackedN = MLAS_SBGEMM_KERNEL_AMX::PackedN;
+    const size_t AlignedN = (CountN + PackedN - 1) & ~(PackedN - 1);
+
+    MLAS_DECLSPEC_ALIGN(bfloat16_t PanelA[KernelMaxM * StrideK], 64);
+    MLAS_DECLSPEC_ALIGN(float Tile[TILE_M * TILE_N], 64);
+
+    MlasAmxLoadTileConfig();
+
+    //
+    // Step through each slice of matrix B along the K dimension. The slices
+    // are packed separately, see MlasSBGemmConvertPackB.
+    //
+    size_t SliceK;
+    for (size_t k = 0; k < CountK; k += SliceK) {
+        SliceK = std::min(CountK - k, StrideK);
+
+        const size_t AlignedK = (SliceK + TILE_K - 1) & ~(TILE_K - 1);
+        const size_t StrideA = AlignedK * sizeof(bfloat16_t);
+        const bfloat16_t* b = B + AlignedN * k;
+        const bool ZeroModeSlice = ZeroMode && (k == 0);
+
+        for (size_t m = 0; m < CountM; m += KernelMaxM) {
+            const size_t RowsM = std::min(CountM - m, KernelMaxM);
+            const bool TwoTilesM = RowsM > TILE_M;
+
+            MlasSBGemmConvertA(PanelA, A + m * lda + k, lda, RowsM, TwoTilesM ? 2 * TILE_M : TILE_M, SliceK, AlignedK);
+
+            for (size_t n = 0; n < CountN; n += 2 * TILE_N) {
+                const size_t ColsN = std::min(CountN - n, size_t(2 * TILE_N));
+                const bool TwoTilesN = ColsN > TILE_N;
+                const bfloat16_t* b0 = b + AlignedK * n;
+                const bfloat16_t* b1 = b0 + AlignedK * TILE_N;
+
+                tile_zero(TMM4);
+                tile_zero(TMM5);
+                tile_zero(TMM6);
+                tile_zero(TMM7);
+
+                for (size_t kk = 0; kk < AlignedK; kk += TILE_K) {
+                    tile_loadd(TMM0, b0 + kk * TILE_N, TILE_N * 2 * sizeof(bfloat16_t));
+                    tile_loadd(TMM2, PanelA + kk, StrideA);
+                    tile_dpbf16ps(TMM4, TMM2, TMM0);
+                    if (TwoTilesN) {
+                        tile_loadd(TMM1, b1 + kk * TILE_N, TILE_N * 2 * sizeof(bfloat16_t));
+                        tile_dpbf16ps(TMM5, TMM2, TMM1);
+                    }
+                    if (TwoTilesM) {
+                        tile_loadd(TMM3, PanelA + TILE_M * AlignedK + kk, StrideA);
+                        tile_dpbf16ps(TMM6, TMM3, TMM0);
+                        if (TwoTilesN) {
+                            tile_dpbf16ps(TMM7, TMM3, TMM1);
+                        }
+                    }
+                }
+
+                float* c = C + m * ldc + n;
+                const float* bias = (Bias == nullptr) ? nullptr : Bias + n;
+                const size_t RowsM0 = std::min(RowsM, size_t(TILE_M));
+                const size_t ColsN0 = std::min(ColsN, size_t(TILE_N));
+
+                tile_stored(TMM4, Tile, TILE_N * sizeof(float));
+                MlasSBGemmStoreTile(Tile, c, ldc, RowsM0, ColsN0, bias, ZeroModeSlice);
+                if (TwoTilesN) {
+                    tile_stored(TMM5, Tile, TILE_N * sizeof(float));
+                    MlasSBGemmStoreTile(Tile, c + TILE_N, ldc, RowsM0, ColsN - TILE_N,
+                                        (bias == nullptr) ? nullptr : bias + TILE_N, ZeroModeSlice);
+                }
+                if (TwoTilesM) {
+                    tile_stored(TMM6, Tile, TILE_N * sizeof(float));
+                    MlasSBGemmStoreTile(Tile, c + TILE_M * ldc, ldc, RowsM - TILE_M, ColsN0, bias, ZeroModeSlice);
+                    if (TwoTilesN) {
+                        tile_stored(TMM7, Tile, TILE_N * sizeof(float));
+                        MlasSBGemmStoreTile(Tile, c + TILE_M * ldc + TILE_N, ldc, RowsM - TILE_M, ColsN - TILE_N,
+                                            (bias == nullptr) ? nullptr : bias + TILE_N, ZeroModeSlice);
+                    }
+                }
+            }
+        }
+    }
+}
+
+const MLAS_SBGEMM_DISPATCH MlasSBGemmDispatchAmx = {
+    MlasSBGemmOperation<MLAS_SBGEMM_KERNEL_AMX>,
+    MlasSBGemmConvertPackB<MLAS_SBGEMM_KERNEL_AMX>,
+    MLAS_SBGEMM_KERNEL_AMX::PackedK,
+    MLAS_SBGEMM_KERNEL_AMX::PackedN,
+    MLAS_SBGEMM_KERNEL_AMX::KernelMaxM,
+    0  // kernel does not read beyond buffer end
+};
+#endif  // defined(__x86_64__) && defined(__linux__)
@@ -1554,6 +1554,162 @@ Return Value:
             DataParams->alpha, A, lda, B, ldb, DataParams->beta, C, ldc);
     }
 }
+
+#if defined(MLAS_TARGET_AMD64)
+
+void
+MlasSgemmSmallTransposeB(
+    float* D,
+    const float* B,
+    size_t ldb,
+    size_t CountN,
+    size_t CountK
+    )
+/*++
+
+Routine Description:
+
+    This routine transposes the source matrix B of CountN rows by CountK
+    columns to the destination buffer of CountK rows by CountN columns.
+
+Arguments:
+
+    D - Supplies the address of the destination buffer.
+
+    B - Supplies the address of the source matrix.
+
+    ldb - Supplies the number of elements per row of the source matrix.
+
+    CountN - Supplies the number of rows of the source matrix.
+
+    CountK - Supplies the number of columns of the source matrix.
+
+Return Value:
+
+    None.
+
+--*/
+{
+    size_t n = 0;
+
+    for (; n + 4 <= CountN; n += 4) {
+
+        const float* b = B + n * ldb;
+        float* d = D + n;
+        size_t k = 0;
+
+        for (; k + 4 <= CountK; k += 4) {
+
+            MLAS_FLOAT32X4 t0 = MlasLoadFloat32x4(&b[ldb * 0 + k]);
+            MLAS_FLOAT32X4 t1 = MlasLoadFloat32x4(&b[ldb * 1 + k]);
+            MLAS_FLOAT32X4 t2 = MlasLoadFloat32x4(&b[ldb * 2 + k]);
+            MLAS_FLOAT32X4 t3 = MlasLoadFloat32x4(&b[ldb * 3 + k]);
+
+            MLAS_FLOAT32X4 z0 = MlasInterleaveLowFloat32x4(t0, t2);
+            MLAS_FLOAT32X4 z1 = MlasInterleaveHighFloat32x4(t0, t2);
+            MLAS_FLOAT32X4 z2 = MlasInterleaveLowFloat32x4(t1, t3);
+            MLAS_FLOAT32X4 z3 = MlasInterleaveHighFloat32x4(t1, t3);
+            t0 = MlasInterleaveLowFloat32x4(z0, z2);
+            t1 = MlasInterleaveHighFloat32x4(z0, z2);
+            t2 = MlasInterleaveLowFloat32x4(z1, z3);
+            t3 = MlasInterleaveHighFloat32x4(z1, z3);
+
+            MlasStoreFloat32x4(&d[CountN * (k + 0)], t0);
+            MlasStoreFloat32x4(&d[CountN * (k + 1)], t1);
+            MlasStoreFloat32x4(&d[CountN * (k + 2)], t2);
+            MlasStoreFloat32x4(&d[CountN * (k + 3)], t3);
+        }
+
+        for (; k < CountK; k++) {
+            d[CountN * k + 0] = b[ldb * 0 + k];
+            d[CountN * k + 1] = b[ldb * 1 + k];
+            d[CountN * k + 2] = b[ldb * 2 + k];
+            d[CountN * k + 3] = b[ldb * 3 + k];
+        }
+    }
+
+    for (; n < CountN; n++) {
+        for (size_t k = 0; k < CountK; k++) {
+            D[CountN * k + n] = B[ldb * n + k];
+        }
+    }
+}
+
+void
+MlasSgemmSmallBatchThreaded(
+    const ptrdiff_t ThreadCount,
+    const CBLAS_TRANSPOSE TransB,
+    const size_t M,
+    const size_t N,
+    const size_t K,
+    const MLAS_SGEMM_DATA_PARAMS* Data,
+    const size_t BatchSize,
+    ptrdiff_t ThreadId
+    )
+/*++
+
+Routine Description:
+
+    This routine is invoked from a worker thread to execute a range of a
+    batch of small SGEMM operations. Each operation of the range is computed
+    in full by the small kernel, which reads matrix B without packing.
+
+Arguments:
+
+    ThreadCount - Supplies the total thread partition of the batch.
+
+    TransB - Supplies the transpose operation on B matrix.
+
+    M, N, K - Supplies the shape of the multiplication.
+
+    Data - Supplies the data position and layout of the matrices.
+
+    BatchSize - Supplies the number of multiplications in the batch.
+
+    ThreadId - Supplies the current index of the threaded operation.
+
+Return Value:
+
+    None.
+
+--*/
+{
+    MLAS_DECLSPEC_ALIGN(float PanelB[MLAS_SGEMM_SMALL_MAXIMUM_TRANSPOSE_NK], 16 * sizeof(float));
+
+    MLAS_SGEMM_SMALL_KERNEL* SmallKernel = GetMlasPlatform().SgemmSmallKernel;
+
+    size_t RangeStart;
+    size_t RangeCount;
+
+    MlasPartitionWork(ThreadId, ThreadCount, BatchSize, &RangeStart, &RangeCount);
+
+    for (size_t i = RangeStart; i < RangeStart + RangeCount; i++) {
+
+        const MLAS_SGEMM_DATA_PARAMS* DataParams = &Data[i];
+
+        const float* B = (const float*)DataParams->B;
+        size_t ldb = DataParams->ldb;
+
+        //
+        // Transpose matrix B to a local buffer, which is cheaper than packing
+        // for the small matrices handled here.
+        //
+
+        if (TransB == CblasTrans) {
+
+            MlasSgemmSmallTransposeB(PanelB, B, ldb, N, K);
+
+            B = PanelB;
+            ldb = N;
+        }
+
+        SmallKernel(DataParams->A, B, DataParams->C, M, N, K, DataParams->lda,
+            ldb, DataParams->ldc, DataParams->alpha, DataParams->beta);
+    }
+}
+
+#endif
+
 #if defined(_MSC_VER) && !defined(__clang__)
 #pragma warning(push)
 // Chance of arithmetic overflow could be reduced
@@ -1587,6 +1743,43 @@ MlasGemmBatch(
         TargetThreadCount = MaximumThreadCount;
     }
 
+    //
+    // Batches of small operations are dominated by the packing of matrix B
+    // and by the partitioning of each operation. When the platform provides
+    // a small kernel, run each operation on a single thread without packing
+    // and split the batch as a whole across the threads. A transposed matrix
+    // B is first copied to a local buffer, which only pays off for the
+    // smallest matrices.
+    //
+
+#if defined(MLAS_TARGET_AMD64)
+
+    if (TargetThreadCount == 1 && GetMlasPlatform().SgemmSmallKernel != nullptr &&
+        TransA == CblasNoTrans && N <= MLAS_SGEMM_SMALL_MAXIMUM_N && K <= MLAS_SGEMM_SMALL_MAXIMUM_K &&
+        (TransB == CblasNoTrans || (M > 1 && N * K <= MLAS_SGEMM_SMALL_MAXIMUM_TRANSPOSE_NK)) &&
+        std::none_of(Data, Data + BatchSize, [](const MLAS_SGEMM_DATA_PARAMS& DataParams) { return DataParams.BIsPacked; })) {
+
+        const double BatchComplexity = Complexity * double(BatchSize);
+
+        ptrdiff_t ThreadCount = ptrdiff_t(BatchComplexity / double(MLAS_SGEMM_THREAD_COMPLEXITY)) + 1;
+
+        if (ThreadCount >= MaximumThreadCount) {
+            ThreadCount = MaximumThreadCount;
+        }
+
+        if (size_t(ThreadCount) > BatchSize) {
+            ThreadCount = ptrdiff_t(BatchSize);
+        }
+
+        MlasTrySimpleParallel(ThreadPool, ThreadCount, [=](ptrdiff_t tid) {
+            MlasSgemmSmallBatchThreaded(ThreadCount, TransB, M, N, K, Data, BatchSize, tid);
+        });
+
+        return;
+    }
+
+#endif
+
     //
     // Segment the operation across multiple threads.
     //
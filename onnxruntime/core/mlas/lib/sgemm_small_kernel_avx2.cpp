@@ -0,0 +1,248 @@
+/*++
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+
+Licensed under the MIT License.
+
+Module Name:
+
+    sgemm_small_kernel_avx2.cpp
+
+Abstract:
+
+    This module implements the single precision matrix/matrix multiply kernel
+    for small matrices using AVX2 and FMA3 instructions.
+
+    The kernel reads matrix B in place, without packing, and keeps a block of
+    rows of the output matrix in registers for the whole K dimension. It is
+    specialized for the number of vectors spanning the N dimension, so that
+    batches of many small problems avoid the packing and the blocking of the
+    general kernel.
+
+--*/
+
+#include "mlasi.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+
+template <typename IterationFn, size_t... Indices>
+MLAS_FORCEINLINE void
+UnrolledLoopIterations(IterationFn&& f, std::index_sequence<Indices...> /* indices */)
+{
+    (f(Indices), ...);
+}
+
+template <size_t N, typename IterationFn>
+MLAS_FORCEINLINE void
+UnrolledLoop(IterationFn&& f)
+{
+    UnrolledLoopIterations(std::forward<IterationFn>(f), std::make_index_sequence<N>());
+}
+
+template <size_t VectorCount, size_t RowCount>
+MLAS_FORCEINLINE void
+SgemmSmallKernelRows(
+    const float* A,
+    const float* B,
+    float* C,
+    size_t CountK,
+    size_t lda,
+    size_t ldb,
+    size_t ldc,
+    __m256i LastMask,
+    float alpha,
+    float beta
+)
+{
+    __m256 Accumulators[RowCount][VectorCount];
+
+    UnrolledLoop<RowCount>([&](size_t r) {
+        UnrolledLoop<VectorCount>([&](size_t v) { Accumulators[r][v] = _mm256_setzero_ps(); });
+    });
+
+    for (size_t k = 0; k < CountK; k++) {
+        __m256 BElements[VectorCount];
+
+        UnrolledLoop<VectorCount>([&](size_t v) {
+            BElements[v] = (v + 1 < VectorCount) ? _mm256_loadu_ps(B + v * 8)
+                                                 : _mm256_maskload_ps(B + v * 8, LastMask);
+        });
+
+        UnrolledLoop<RowCount>([&](size_t r) {
+            const __m256 ABroadcast = _mm256_set1_ps(A[r * lda + k]);
+            UnrolledLoop<VectorCount>([&](size_t v) {
+                Accumulators[r][v] = _mm256_fmadd_ps(ABroadcast, BElements[v], Accumulators[r][v]);
+            });
+        });
+
+        B += ldb;
+    }
+
+    const __m256 AlphaBroadcast = _mm256_set1_ps(alpha);
+    const __m256 BetaBroadcast = _mm256_set1_ps(beta);
+
+    UnrolledLoop<RowCount>([&](size_t r) {
+        UnrolledLoop<VectorCount>([&](size_t v) {
+            float* c = C + r * ldc + v * 8;
+            __m256 Result = _mm256_mul_ps(Accumulators[r][v], AlphaBroadcast);
+            if (v + 1 < VectorCount) {
+                if (beta != 0.0f) {
+                    Result = _mm256_fmadd_ps(_mm256_loadu_ps(c), BetaBroadcast, Result);
+                }
+                _mm256_storeu_ps(c, Result);
+            } else {
+                if (beta != 0.0f) {
+                    Result = _mm256_fmadd_ps(_mm256_maskload_ps(c, LastMask), BetaBroadcast, Result);
+                }
+                _mm256_maskstore_ps(c, LastMask, Result);
+            }
+        });
+    });
+}
+
+template <size_t VectorCount>
+void
+SgemmSmallKernel(
+    const float* A,
+    const float* B,
+    float* C,
+    size_t CountM,
+    size_t CountN,
+    size_t CountK,
+    size_t lda,
+    size_t ldb,
+    size_t ldc,
+    float alpha,
+    float beta
+)
+{
+    //
+    // Use as many rows as fit the 16 registers along with the vectors of
+    // matrix B and the broadcast element of matrix A.
+    //
+
+    constexpr size_t RowCount = std::max<size_t>((15 - VectorCount) / VectorCount, 1);
+
+    const __m256i LastMask = _mm256_cmpgt_epi32(
+        _mm256_set1_epi32(int32_t(CountN - (VectorCount - 1) * 8)),
+        _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)
+    );
+
+    while (CountM >= RowCount) {
+        SgemmSmallKernelRows<VectorCount, RowCount>(A, B, C, CountK, lda, ldb, ldc, LastMask, alpha, beta);
+        A += lda * RowCount;
+        C += ldc * RowCount;
+        CountM -= RowCount;
+    }
+
+    while (CountM >= 4 && RowCount > 4) {
+        SgemmSmallKernelRows<VectorCount, 4>(A, B, C, CountK, lda, ldb, ldc, LastMask, alpha, beta);
+        A += lda * 4;
+        C += ldc * 4;
+        CountM -= 4;
+    }
+
+    if (CountM >= 2) {
+        SgemmSmallKernelRows<VectorCount, 2>(A, B, C, CountK, lda, ldb, ldc, LastMask, alpha, beta);
+        A += lda * 2;
+        C += ldc * 2;
+        CountM -= 2;
+    }
+
+    if (CountM >= 1) {
+        SgemmSmallKernelRows<VectorCount, 1>(A, B, C, CountK, lda, ldb, ldc, LastMask, alpha, beta);
+    }
+}
+
+}  // namespace
+
+void
+MLASCALL
+MlasSgemmSmallKernelAvx2(
+    const float* A,
+    const float* B,
+    float* C,
+    size_t CountM,
+    size_t CountN,
+    size_t CountK,
+    size_t lda,
+    size_t ldb,
+    size_t ldc,
+    float alpha,
+    float beta
+    )
+/*++
+
+Routine Description:
+
+    This routine computes C = alpha * A * B + beta * C for small matrices, with
+    A and B not transposed.
+
+Arguments:
+
+    A - Supplies the address of matrix A.
+
+    B - Supplies the address of matrix B.
+
+    C - Supplies the address of matrix C.
+
+    CountM - Supplies the number of rows of matrix A and matrix C.
+
+    CountN - Supplies the number of columns of matrix B and matrix C, which
+        must not exceed MLAS_SGEMM_SMALL_MAXIMUM_N.
+
+    CountK - Supplies the number of columns of matrix A and the number of rows
+        of matrix B.
+
+    lda - Supplies the first dimension of matrix A.
+
+    ldb - Supplies the first dimension of matrix B.
+
+    ldc - Supplies the first dimension of matrix C.
+
+    alpha - Supplies the scalar alpha multiplier.
+
+    beta - Supplies the scalar beta multiplier. The output matrix is not read
+        when beta is zero.
+
+Return Value:
+
+    None.
+
+--*/
+{
+    switch ((CountN + 7) / 8) {
+        case 1:
+            SgemmSmallKernel<1>(A, B, C, CountM, CountN, CountK, lda, ldb, ldc, alpha, beta);
+            break;
+        case 2:
+            SgemmSmallKernel<2>(A, B, C, CountM, CountN, CountK, lda, ldb, ldc, alpha, beta);
+            break;
+        case 3:
+            SgemmSmallKernel<3>(A, B, C, CountM, CountN, CountK, lda, ldb, ldc, alpha, beta);
+            break;
+        case 4:
+            SgemmSmallKernel<4>(A, B, C, CountM, CountN, CountK, lda, ldb, ldc, alpha, beta);
+            break;
+        case 5:
+            SgemmSmallKernel<5>(A, B, C, CountM, CountN, CountK, lda, ldb, ldc, alpha, beta);
+            break;
+        case 6:
+            SgemmSmallKernel<6>(A, B, C, CountM, CountN, CountK, lda, ldb, ldc, alpha, beta);
+            break;
+        case 7:
+            SgemmSmallKernel<7>(A, B, C, CountM, CountN, CountK, lda, ldb, ldc, alpha, beta);
+            break;
+        case 8:
+            SgemmSmallKernel<8>(A, B, C, CountM, CountN, CountK, lda, ldb, ldc, alpha, beta);
+            break;
+        default:
+            break;
+    }
+}
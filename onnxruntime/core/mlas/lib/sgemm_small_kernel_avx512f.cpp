@@ -0,0 +1,227 @@
+/*++
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+
+Licensed under the MIT License.
+
+Module Name:
+
+    sgemm_small_kernel_avx512f.cpp
+
+Abstract:
+
+    This module implements the single precision matrix/matrix multiply kernel
+    for small matrices using AVX512F instructions.
+
+    The kernel reads matrix B in place, without packing, and keeps a block of
+    rows of the output matrix in registers for the whole K dimension. It is
+    specialized for the number of vectors spanning the N dimension, so that
+    batches of many small problems avoid the packing and the blocking of the
+    general kernel.
+
+--*/
+
+#include "mlasi.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <utility>
+
+namespace
+{
+
+template <typename IterationFn, size_t... Indices>
+MLAS_FORCEINLINE void
+UnrolledLoopIterations(IterationFn&& f, std::index_sequence<Indices...> /* indices */)
+{
+    (f(Indices), ...);
+}
+
+template <size_t N, typename IterationFn>
+MLAS_FORCEINLINE void
+UnrolledLoop(IterationFn&& f)
+{
+    UnrolledLoopIterations(std::forward<IterationFn>(f), std::make_index_sequence<N>());
+}
+
+template <size_t VectorCount, size_t RowCount>
+MLAS_FORCEINLINE void
+SgemmSmallKernelRows(
+    const float* A,
+    const float* B,
+    float* C,
+    size_t CountK,
+    size_t lda,
+    size_t ldb,
+    size_t ldc,
+    __mmask16 LastMask,
+    float alpha,
+    float beta
+)
+{
+    __m512 Accumulators[RowCount][VectorCount];
+
+    UnrolledLoop<RowCount>([&](size_t r) {
+        UnrolledLoop<VectorCount>([&](size_t v) { Accumulators[r][v] = _mm512_setzero_ps(); });
+    });
+
+    for (size_t k = 0; k < CountK; k++) {
+        __m512 BElements[VectorCount];
+
+        UnrolledLoop<VectorCount>([&](size_t v) {
+            BElements[v] = (v + 1 < VectorCount) ? _mm512_loadu_ps(B + v * 16)
+                                                 : _mm512_maskz_loadu_ps(LastMask, B + v * 16);
+        });
+
+        UnrolledLoop<RowCount>([&](size_t r) {
+            const __m512 ABroadcast = _mm512_set1_ps(A[r * lda + k]);
+            UnrolledLoop<VectorCount>([&](size_t v) {
+                Accumulators[r][v] = _mm512_fmadd_ps(ABroadcast, BElements[v], Accumulators[r][v]);
+            });
+        });
+
+        B += ldb;
+    }
+
+    const __m512 AlphaBroadcast = _mm512_set1_ps(alpha);
+    const __m512 BetaBroadcast = _mm512_set1_ps(beta);
+
+    UnrolledLoop<RowCount>([&](size_t r) {
+        UnrolledLoop<VectorCount>([&](size_t v) {
+            const __mmask16 Mask = (v + 1 < VectorCount) ? __mmask16(0xFFFF) : LastMask;
+            float* c = C + r * ldc + v * 16;
+            __m512 Result = _mm512_mul_ps(Accumulators[r][v], AlphaBroadcast);
+            if (beta != 0.0f) {
+                Result = _mm512_fmadd_ps(_mm512_maskz_loadu_ps(Mask, c), BetaBroadcast, Result);
+            }
+            _mm512_mask_storeu_ps(c, Mask, Result);
+        });
+    });
+}
+
+template <size_t VectorCount>
+void
+SgemmSmallKernel(
+    const float* A,
+    const float* B,
+    float* C,
+    size_t CountM,
+    size_t CountN,
+    size_t CountK,
+    size_t lda,
+    size_t ldb,
+    size_t ldc,
+    float alpha,
+    float beta
+)
+{
+    //
+    // Use as many rows as fit the 32 registers along with the vectors of
+    // matrix B and the broadcast element of matrix A.
+    //
+
+    constexpr size_t RowCount = std::max<size_t>((31 - VectorCount) / VectorCount, 1);
+
+    const __mmask16 LastMask = __mmask16(0xFFFF >> (VectorCount * 16 - CountN));
+
+    while (CountM >= RowCount) {
+        SgemmSmallKernelRows<VectorCount, RowCount>(A, B, C, CountK, lda, ldb, ldc, LastMask, alpha, beta);
+        A += lda * RowCount;
+        C += ldc * RowCount;
+        CountM -= RowCount;
+    }
+
+    while (CountM >= 4 && RowCount > 4) {
+        SgemmSmallKernelRows<VectorCount, 4>(A, B, C, CountK, lda, ldb, ldc, LastMask, alpha, beta);
+        A += lda * 4;
+        C += ldc * 4;
+        CountM -= 4;
+    }
+
+    if (CountM >= 2) {
+        SgemmSmallKernelRows<VectorCount, 2>(A, B, C, CountK, lda, ldb, ldc, LastMask, alpha, beta);
+        A += lda * 2;
+        C += ldc * 2;
+        CountM -= 2;
+    }
+
+    if (CountM >= 1) {
+        SgemmSmallKernelRows<VectorCount, 1>(A, B, C, CountK, lda, ldb, ldc, LastMask, alpha, beta);
+    }
+}
+
+}  // namespace
+
+void
+MLASCALL
+MlasSgemmSmallKernelAvx512F(
+    const float* A,
+    const float* B,
+    float* C,
+    size_t CountM,
+    size_t CountN,
+    size_t CountK,
+    size_t lda,
+    size_t ldb,
+    size_t ldc,
+    float alpha,
+    float beta
+    )
+/*++
+
+Routine Description:
+
+    This routine computes C = alpha * A * B + beta * C for small matrices, with
+    A and B not transposed.
+
+Arguments:
+
+    A - Supplies the address of matrix A.
+
+    B - Supplies the address of matrix B.
+
+    C - Supplies the address of matrix C.
+
+    CountM - Supplies the number of rows of matrix A and matrix C.
+
+    CountN - Supplies the number of columns of matrix B and matrix C, which
+        must not exceed MLAS_SGEMM_SMALL_MAXIMUM_N.
+
+    CountK - Supplies the number of columns of matrix A and the number of rows
+        of matrix B.
+
+    lda - Supplies the first dimension of matrix A.
+
+    ldb - Supplies the first dimension of matrix B.
+
+    ldc - Supplies the first dimension of matrix C.
+
+    alpha - Supplies the scalar alpha multiplier.
+
+    beta - Supplies the scalar beta multiplier. The output matrix is not read
+        when beta is zero.
+
+Return Value:
+
+    None.
+
+--*/
+{
+    switch ((CountN + 15) / 16) {
+        case 1:
+            SgemmSmallKernel<1>(A, B, C, CountM, CountN, CountK, lda, ldb, ldc, alpha, beta);
+            break;
+        case 2:
+            SgemmSmallKernel<2>(A, B, C, CountM, CountN, CountK, lda, ldb, ldc, alpha, beta);
+            break;
+        case 3:
+            SgemmSmallKernel<3>(A, B, C, CountM, CountN, CountK, lda, ldb, ldc, alpha, beta);
+            break;
+        case 4:
+            SgemmSmallKernel<4>(A, B, C, CountM, CountN, CountK, lda, ldb, ldc, alpha, beta);
+            break;
+        default:
+            break;
+    }
+}
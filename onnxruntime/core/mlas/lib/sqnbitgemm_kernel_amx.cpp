@@ -0,0 +1,501 @@
+/*++
+
+Copyright (c) Microsoft Corporation. All rights reserved.
+
+Licensed under the MIT License.
+
+Module Name:
+
+    sqnbitgemm_kernel_amx.cpp
+
+Abstract:
+
+    This module implements the quantized 4-bit integer matrix multiplication
+    kernel for the SQNBIT_CompInt8 compute type with amx int8 tiles.
+
+    Matrix B is packed in groups of 16 columns. Each block of a group stores
+    the 4 values of k for a column in 2 bytes, the low and high nibbles of a
+    byte holding consecutive values of k, so that a row of 16 columns is
+    unpacked to the 64 bytes of a tile row. The scales of a group are stored
+    block by block in the same order.
+
+    The kernels of the other compute types and of 8-bit quantized B are the
+    avx512vnni ones, see MlasSQNBitGemmDispatchAmx.
+
+--*/
+
+#include <algorithm>
+#include <cassert>
+
+#include "qnbitgemm.h"
+#include "amx_common.h"
+
+#define TMM0 0
+#define TMM1 1
+#define TMM2 2
+#define TMM3 3
+#define TMM4 4
+#define TMM5 5
+#define TMM6 6
+#define TMM7 7
+
+namespace
+{
+
+constexpr size_t TileM = 16;
+constexpr size_t TileN = 16;
+constexpr size_t TileK = 64;
+
+//
+// Maximum rows of matrix A processed with the same unpacked blocks of B, and
+// maximum block length.
+//
+constexpr size_t StrideM = 128;
+constexpr size_t MaximumBlkLen = 256;
+
+MLAS_FORCEINLINE
+size_t
+GroupColumnCount(size_t N, size_t n)
+{
+    return std::min(N - n, TileN);
+}
+
+//
+// Offset of the scale of column n and block k_blk in the packed scales.
+//
+MLAS_FORCEINLINE
+size_t
+PackedScaleOffset(size_t N, size_t n, size_t BlockCountK, size_t k_blk)
+{
+    const size_t GroupStartN = n - n % TileN;
+    return GroupStartN * BlockCountK + k_blk * GroupColumnCount(N, GroupStartN) + n % TileN;
+}
+
+MLAS_FORCEINLINE
+__mmask16
+ColumnMask(size_t Count)
+{
+    return (Count >= 16) ? __mmask16(0xFFFF) : __mmask16((1u << Count) - 1);
+}
+
+/*
+    This routine unpacks 4 values of k for each column of a group to bytes:
+    the 2 bytes of a column hold k0 and k1, then k2 and k3, in their low and
+    high nibbles.
+*/
+MLAS_FORCEINLINE
+__m512i
+UnpackQuadRow(const std::byte* QuantBData, __mmask32 Mask)
+{
+    const __m512i Words = _mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(Mask, QuantBData));
+    const __m512i Shifted = _mm512_slli_epi16(Words, 4);
+
+    // (Words | Shifted) & 0x0F0F
+    return _mm512_ternarylogic_epi32(Words, Shifted, _mm512_set1_epi16(0x0F0F), 0xA8);
+}
+
+/*
+    This routine loads the tile of 16 rows of matrix A at a given offset. The
+    rows beyond CountM and the bytes beyond the end of the rows are copied to
+    a zero padded buffer instead.
+*/
+MLAS_FORCEINLINE
+void
+LoadTileA(
+    const std::byte* QuantA, size_t lda, size_t CountM, size_t Offset, int8_t* Buffer, int Tile
+)
+{
+    const std::byte* a = QuantA + Offset;
+
+    if (CountM >= TileM && Offset + TileK <= lda) {
+        if (Tile == 0) {
+            tile_loadd(TMM2, a, lda);
+        } else {
+            tile_loadd(TMM3, a, lda);
+        }
+        return;
+    }
+
+    const size_t Bytes = std::min(lda - Offset, TileK);
+    const __mmask64 Mask = (Bytes >= 64) ? ~__mmask64(0) : ((__mmask64(1) << Bytes) - 1);
+    for (size_t m = 0; m < TileM; m++) {
+        const __m512i Row = (m < CountM) ? _mm512_maskz_loadu_epi8(Mask, a + m * lda) : _mm512_setzero_si512();
+        _mm512_store_si512(Buffer + m * TileK, Row);
+    }
+
+    if (Tile == 0) {
+        tile_loadd(TMM2, Buffer, TileK);
+    } else {
+        tile_loadd(TMM3, Buffer, TileK);
+    }
+}
+
+/*
+    This routine scales a tile of the int32 dot products of a block and adds
+    it to the accumulators of the rows.
+*/
+MLAS_FORCEINLINE
+void
+AccumulateTile(
+    const int32_t* Tile,
+    float* Acc,
+    size_t ldacc,
+    size_t CountM,
+    const float* QuantAScale,
+    size_t BlockCountK,
+    __m512 QuantBScale
+)
+{
+    for (size_t m = 0; m < CountM; m++) {
+        const __m512 Scale = _mm512_mul_ps(_mm512_set1_ps(QuantAScale[m * BlockCountK]), QuantBScale);
+        const __m512 Dot = _mm512_cvtepi32_ps(_mm512_load_si512(Tile + m * TileN));
+        _mm512_store_ps(Acc + m * ldacc, _mm512_fmadd_ps(Dot, Scale, _mm512_load_ps(Acc + m * ldacc)));
+    }
+}
+
+/*
+    This routine computes up to 4 rows of matrix C with avx512vnni from the
+    same unpacked rows of matrix B, for the products of a few rows.
+*/
+template <size_t CountM>
+MLAS_FORCEINLINE
+void
+GemmRowsVnni(
+    size_t BlkLen,
+    const std::byte* QuantA,
+    size_t lda,
+    const float* QuantAScale,
+    const std::byte* QuantBData,
+    const float* QuantBScale,
+    float* C,
+    size_t CountN,
+    size_t BlockCountK,
+    const float* Bias,
+    size_t ldc
+)
+{
+    const size_t BlkDataSize = BlkLen / 2;
+
+    for (size_t n = 0; n < CountN; n += TileN) {
+        const size_t Cols = GroupColumnCount(CountN, n);
+        const __mmask16 Mask = ColumnMask(Cols);
+        const __mmask32 ByteMask = (Cols >= 16) ? __mmask32(0xFFFFFFFF) : __mmask32((1u << (2 * Cols)) - 1);
+        const std::byte* b = QuantBData + n * BlockCountK * BlkDataSize;
+        const float* b_scale = QuantBScale + n * BlockCountK;
+
+        __m512 Acc[CountM];
+        for (size_t m = 0; m < CountM; m++) {
+            Acc[m] = _mm512_setzero_ps();
+        }
+
+        for (size_t k_blk = 0; k_blk < BlockCountK; k_blk++) {
+            //
+            // Even and odd rows of B are accumulated separately to shorten
+            // the dependency chains of the products of a few rows.
+            //
+            __m512i Dot[2][CountM];
+            for (size_t m = 0; m < CountM; m++) {
+                Dot[0][m] = _mm512_setzero_si512();
+                Dot[1][m] = _mm512_setzero_si512();
+            }
+
+            const std::byte* b_blk = b + k_blk * Cols * BlkDataSize;
+            const std::byte* a_blk = QuantA + k_blk * BlkLen;
+            for (size_t q = 0; q < BlkLen / 4; q += 2) {
+                const __m512i Row0 = UnpackQuadRow(b_blk + q * Cols * 2, ByteMask);
+                const __m512i Row1 = UnpackQuadRow(b_blk + (q + 1) * Cols * 2, ByteMask);
+                for (size_t m = 0; m < CountM; m++) {
+                    const int32_t* a = reinterpret_cast<const int32_t*>(a_blk + m * lda + q * 4);
+                    Dot[0][m] = _mm512_dpbusd_epi32(Dot[0][m], Row0, _mm512_set1_epi32(a[0]));
+                    Dot[1][m] = _mm512_dpbusd_epi32(Dot[1][m], Row1, _mm512_set1_epi32(a[1]));
+                }
+            }
+
+            const __m512 ScaleB = _mm512_maskz_loadu_ps(Mask, b_scale + k_blk * Cols);
+            for (size_t m = 0; m < CountM; m++) {
+                const __m512 Scale = _mm512_mul_ps(_mm512_set1_ps(QuantAScale[m * BlockCountK + k_blk]), ScaleB);
+                const __m512i Sum = _mm512_add_epi32(Dot[0][m], Dot[1][m]);
+                Acc[m] = _mm512_fmadd_ps(_mm512_cvtepi32_ps(Sum), Scale, Acc[m]);
+            }
+        }
+
+        const __m512 BiasVector = (Bias == nullptr) ? _mm512_setzero_ps() : _mm512_maskz_loadu_ps(Mask, Bias + n);
+        for (size_t m = 0; m < CountM; m++) {
+            _mm512_mask_storeu_ps(C + m * ldc + n, Mask, _mm512_add_ps(Acc[m], BiasVector));
+        }
+    }
+}
+
+/*
+    This routine computes matrix C with amx tiles of 16 rows and 16 columns,
+    each block of 2 groups of columns of matrix B being unpacked once for all
+    the rows.
+*/
+void
+GemmAmx(
+    size_t BlkLen,
+    const std::byte* QuantA,
+    size_t lda,
+    const float* QuantAScale,
+    const std::byte* QuantBData,
+    const float* QuantBScale,
+    float* C,
+    size_t CountM,
+    size_t CountN,
+    size_t BlockCountK,
+    const float* Bias,
+    size_t ldc
+)
+{
+    constexpr size_t ldacc = 2 * TileN;
+    constexpr size_t MaximumStepsK = MaximumBlkLen / TileK;
+
+    const size_t BlkDataSize = BlkLen / 2;
+    const size_t StepsK = MlasDivRoundup(BlkLen, TileK);
+    const size_t QuadsPerStep = std::min(BlkLen, TileK) / 4;
+
+    MLAS_DECLSPEC_ALIGN(uint8_t PanelB[2][MaximumStepsK][TileK / 4 * 64], 64);
+    MLAS_DECLSPEC_ALIGN(int8_t PanelA[2][TileM * TileK], 64);
+    MLAS_DECLSPEC_ALIGN(int32_t Tile[TileM * TileN], 64);
+    MLAS_DECLSPEC_ALIGN(float Acc[StrideM * ldacc], 64);
+
+    //
+    // The rows of a tile beyond the values of k of a block shorter than a
+    // tile stay zero, so that the bytes of matrix A loaded beyond the block
+    // do not contribute.
+    //
+    if (QuadsPerStep < TileK / 4) {
+        std::fill_n(&PanelB[0][0][0], sizeof(PanelB), uint8_t(0));
+    }
+
+    MlasAmxLoadTileConfig();
+
+    for (size_t m0 = 0; m0 < CountM; m0 += StrideM) {
+        const size_t RowsM = std::min(CountM - m0, StrideM);
+        const std::byte* a = QuantA + m0 * lda;
+        const float* a_scale = QuantAScale + m0 * BlockCountK;
+
+        for (size_t n = 0; n < CountN; n += 2 * TileN) {
+            const size_t Cols0 = GroupColumnCount(CountN, n);
+            const size_t Cols1 = (n + TileN < CountN) ? GroupColumnCount(CountN, n + TileN) : 0;
+            const __mmask32 ByteMask0 = (Cols0 >= 16) ? __mmask32(0xFFFFFFFF) : __mmask32((1u << (2 * Cols0)) - 1);
+            const __mmask32 ByteMask1 = (Cols1 >= 16) ? __mmask32(0xFFFFFFFF) : __mmask32((1u << (2 * Cols1)) - 1);
+            const std::byte* b0 = QuantBData + n * BlockCountK * BlkDataSize;
+            const std::byte* b1 = b0 + TileN * BlockCountK * BlkDataSize;
+            const float* b0_scale = QuantBScale + n * BlockCountK;
+            const float* b1_scale = b0_scale + TileN * BlockCountK;
+
+            std::fill_n(Acc, RowsM * ldacc, 0.0f);
+
+            for (size_t k_blk = 0; k_blk < BlockCountK; k_blk++) {
+                const std::byte* b0_blk = b0 + k_blk * Cols0 * BlkDataSize;
+                const std::byte* b1_blk = b1 + k_blk * Cols1 * BlkDataSize;
+                for (size_t q = 0; q < BlkLen / 4; q++) {
+                    uint8_t* row0 = &PanelB[0][q / QuadsPerStep][(q % QuadsPerStep) * 64];
+                    _mm512_store_si512(row0, UnpackQuadRow(b0_blk + q * Cols0 * 2, ByteMask0));
+                    if (Cols1 > 0) {
+                        uint8_t* row1 = &PanelB[1][q / QuadsPerStep][(q % QuadsPerStep) * 64];
+                        _mm512_store_si512(row1, UnpackQuadRow(b1_blk + q * Cols1 * 2, ByteMask1));
+                    }
+                }
+
+                const __m512 ScaleB0 = _mm512_maskz_loadu_ps(ColumnMask(Cols0), b0_scale + k_blk * Cols0);
+                const __m512 ScaleB1 = _mm512_maskz_loadu_ps(ColumnMask(Cols1), b1_scale + k_blk * Cols1);
+
+                for (size_t m = 0; m < RowsM; m += 2 * TileM) {
+                    const size_t Rows0 = std::min(RowsM - m, TileM);
+                    const size_t Rows1 = (m + TileM < RowsM) ? std::min(RowsM - m - TileM, TileM) : 0;
+
+                    tile_zero(TMM4);
+                    tile_zero(TMM5);
+                    tile_zero(TMM6);
+                    tile_zero(TMM7);
+
+                    for (size_t s = 0; s < StepsK; s++) {
+                        const size_t Offset = k_blk * BlkLen + s * TileK;
+
+                        LoadTileA(a + m * lda, lda, Rows0, Offset, PanelA[0], 0);
+                        tile_loadd(TMM0, PanelB[0][s], 64);
+                        tile_dpbsud(TMM4, TMM2, TMM0);
+                        if (Cols1 > 0) {
+                            tile_loadd(TMM1, PanelB[1][s], 64);
+                            tile_dpbsud(TMM5, TMM2, TMM1);
+                        }
+                        if (Rows1 > 0) {
+                            LoadTileA(a + (m + TileM) * lda, lda, Rows1, Offset, PanelA[1], 1);
+                            tile_dpbsud(TMM6, TMM3, TMM0);
+                            if (Cols1 > 0) {
+                                tile_dpbsud(TMM7, TMM3, TMM1);
+                            }
+                        }
+                    }
+
+                    const float* scale0 = a_scale + m * BlockCountK + k_blk;
+                    const float* scale1 = scale0 + TileM * BlockCountK;
+                    float* acc = Acc + m * ldacc;
+
+                    tile_stored(TMM4, Tile, TileN * sizeof(int32_t));
+                    AccumulateTile(Tile, acc, ldacc, Rows0, scale0, BlockCountK, ScaleB0);
+                    if (Cols1 > 0) {
+                        tile_stored(TMM5, Tile, TileN * sizeof(int32_t));
+                        AccumulateTile(Tile, acc + TileN, ldacc, Rows0, scale0, BlockCountK, ScaleB1);
+                    }
+                    if (Rows1 > 0) {
+                        tile_stored(TMM6, Tile, TileN * sizeof(int32_t));
+                        AccumulateTile(Tile, acc + TileM * ldacc, ldacc, Rows1, scale1, BlockCountK, ScaleB0);
+                        if (Cols1 > 0) {
+                            tile_stored(TMM7, Tile, TileN * sizeof(int32_t));
+                            AccumulateTile(Tile, acc + TileM * ldacc + TileN, ldacc, Rows1, scale1, BlockCountK, ScaleB1);
+                        }
+                    }
+                }
+            }
+
+            const __mmask16 Mask0 = ColumnMask(Cols0);
+            const __mmask16 Mask1 = ColumnMask(Cols1);
+            const __m512 Bias0 = (Bias == nullptr) ? _mm512_setzero_ps() : _mm512_maskz_loadu_ps(Mask0, Bias + n);
+            const __m512 Bias1 = (Bias == nullptr) ? _mm512_setzero_ps() : _mm512_maskz_loadu_ps(Mask1, Bias + n + TileN);
+            for (size_t m = 0; m < RowsM; m++) {
+                float* c = C + (m0 + m) * ldc + n;
+                _mm512_mask_storeu_ps(c, Mask0, _mm512_add_ps(_mm512_load_ps(Acc + m * ldacc), Bias0));
+                if (Cols1 > 0) {
+                    _mm512_mask_storeu_ps(c + TileN, Mask1, _mm512_add_ps(_mm512_load_ps(Acc + m * ldacc + TileN), Bias1));
+                }
+            }
+        }
+    }
+}
+
+}  // namespace
+
+void
+SQ4BitGemmPackQuantBDataAndBlkSum_CompInt8_amx(
+    size_t N,
+    size_t BlockCountK,
+    size_t BlkLen,
+    const std::byte* QuantBDataBegin,
+    const float* QuantBScaleBegin,
+    bool HasZeroPoint,
+    const std::byte* QuantBZPBegin,
+    PackedQuantBDataStruct<float, 4>& PackedQuantB,
+    MLAS_THREADPOOL* ThreadPool
+)
+{
+    assert(BlkLen >= 16 && BlkLen % 16 == 0 && BlkLen <= MaximumBlkLen);
+
+    const size_t BlkDataSize = MlasQNBitBlkDataSizeInBytes(4, BlkLen);
+    const size_t GroupCount = MlasDivRoundup(N, TileN);
+
+    if (QuantBDataBegin) {
+        MlasTrySimpleParallel(ThreadPool, GroupCount * BlockCountK, [&](ptrdiff_t tid) {
+            const size_t n = (tid / BlockCountK) * TileN;
+            const size_t k_blk = tid % BlockCountK;
+            const size_t Cols = GroupColumnCount(N, n);
+
+            std::byte* dst = PackedQuantB.PackedQuantBData + n * BlockCountK * BlkDataSize + k_blk * Cols * BlkDataSize;
+            for (size_t c = 0; c < Cols; c++) {
+                const std::byte* src = QuantBDataBegin + (n + c) * BlockCountK * BlkDataSize + k_blk * BlkDataSize;
+                for (size_t q = 0; q < BlkLen / 4; q++) {
+                    dst[(q * Cols + c) * 2] = src[q * 2];
+                    dst[(q * Cols + c) * 2 + 1] = src[q * 2 + 1];
+                }
+            }
+        });
+    }
+
+    if (QuantBScaleBegin) {
+        MlasTrySimpleParallel(ThreadPool, N, [&](ptrdiff_t tid) {
+            const size_t n = static_cast<size_t>(tid);
+            for (size_t k_blk = 0; k_blk < BlockCountK; k_blk++) {
+                PackedQuantB.PackedQuantBScale[PackedScaleOffset(N, n, BlockCountK, k_blk)] =
+                    QuantBScaleBegin[n * BlockCountK + k_blk];
+            }
+        });
+    }
+
+    if ((QuantBScaleBegin && !HasZeroPoint) || QuantBZPBegin) {
+        MlasTrySimpleParallel(ThreadPool, N * BlockCountK, [&](ptrdiff_t tid) {
+            const size_t n = tid / BlockCountK;
+            const size_t k_blk = tid % BlockCountK;
+
+            const float QuantBScale = PackedQuantB.PackedQuantBScale[PackedScaleOffset(N, n, BlockCountK, k_blk)];
+            uint8_t zp = 8;
+            if (QuantBZPBegin) {
+                const size_t ZPCountK = MlasDivRoundup(BlockCountK, 2);
+                const std::byte QuantBZP = QuantBZPBegin[ZPCountK * n + k_blk / 2];
+                zp = (uint8_t)((k_blk % 2 == 0) ? (QuantBZP & std::byte{0x0F}) : (QuantBZP >> 4));
+            }
+
+            // BlockSum is a width 16 row major matrix
+            const size_t dst_offset = ((n / 16) * BlockCountK + k_blk) * 16 + n % 16;
+            PackedQuantB.QuantBBlkSum[dst_offset] = -QuantBScale * zp;
+        });
+    }
+}
+
+size_t
+SQ4BitGemmKernel_BlkSum_CompInt8_amx(
+    const size_t BlkLen,
+    const std::byte* QuantA,
+    const float* QuantAScale,
+    const std::byte* QuantBData,
+    const float* QuantBScale,
+    const std::byte* /*QuantBZeroPoint*/,
+    float* C,
+    size_t CountM,
+    size_t CountN,
+    size_t /*CountK*/,
+    size_t BlockCountK,
+    const float* Bias,
+    size_t ldc,
+    const float* ABlockSum,
+    const float* QuantBBlkSum
+)
+{
+    const size_t lda = BlockCountK * BlkLen;
+
+    //
+    // The tiles are used for a full tile of rows, fewer rows are computed
+    // from the same unpacked blocks of matrix B with avx512vnni.
+    //
+    if (CountM >= TileM) {
+        GemmAmx(BlkLen, QuantA, lda, QuantAScale, QuantBData, QuantBScale, C, CountM, CountN, BlockCountK, Bias, ldc);
+    } else {
+        for (size_t m = 0; m < CountM; m += 4) {
+            const std::byte* a = QuantA + m * lda;
+            const float* a_scale = QuantAScale + m * BlockCountK;
+            float* c = C + m * ldc;
+
+            switch (std::min(CountM - m, size_t(4))) {
+                case 1:
+                    GemmRowsVnni<1>(BlkLen, a, lda, a_scale, QuantBData, QuantBScale, c, CountN, BlockCountK, Bias, ldc);
+                    break;
+                case 2:
+                    GemmRowsVnni<2>(BlkLen, a, lda, a_scale, QuantBData, QuantBScale, c, CountN, BlockCountK, Bias, ldc);
+                    break;
+                case 3:
+                    GemmRowsVnni<3>(BlkLen, a, lda, a_scale, QuantBData, QuantBScale, c, CountN, BlockCountK, Bias, ldc);
+                    break;
+                default:
+                    GemmRowsVnni<4>(BlkLen, a, lda, a_scale, QuantBData, QuantBScale, c, CountN, BlockCountK, Bias, ldc);
+                    break;
+            }
+        }
+    }
+
+    float* c_blk = C;
+    const float* b_blk_sum = QuantBBlkSum;
+
+    size_t RowsRemaining = CountM;
+    const float* a_blksum_row = ABlockSum;
+    while (RowsRemaining > 0) {
+        auto RowsHandled = GetMlasPlatform().GemmFloatKernel(
+            a_blksum_row, b_blk_sum, c_blk, BlockCountK, RowsRemaining, CountN, BlockCountK, ldc, 1.f, false
+        );
+
+        c_blk += ldc * RowsHandled;
+        a_blksum_row += BlockCountK * RowsHandled;
+        RowsRemaining -= RowsHandled;
+    }
+    return CountM;
+}
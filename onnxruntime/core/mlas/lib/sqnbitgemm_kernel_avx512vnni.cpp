@@ -478,3 +478,83 @@ const MLAS_QNBIT_GEMM_DISPATCH MlasSQNBitGemmDispatchAvx512vnni = []() {
 
     return d;
 }();
+
+#if !defined(__APPLE__)
+
+void
+SQ4BitGemmPackQuantBDataAndBlkSum_CompInt8_amx(
+    size_t N,
+    size_t BlockCountK,
+    size_t BlkLen,
+    const std::byte* QuantBDataBegin,
+    const float* QuantBScaleBegin,
+    bool HasZeroPoint,
+    const std::byte* QuantBZPBegin,
+    PackedQuantBDataStruct<float, 4>& PackedQuantB,
+    MLAS_THREADPOOL* ThreadPool
+);
+
+size_t
+SQ4BitGemmKernel_BlkSum_CompInt8_amx(
+    const size_t BlkLen,
+    const std::byte* QuantA,
+    const float* QuantAScale,
+    const std::byte* QuantBData,
+    const float* QuantBScale,
+    const std::byte* QuantBZeroPoint,
+    float* C,
+    size_t CountM,
+    size_t CountN,
+    size_t CountK,
+    size_t BlockCountK,
+    const float* Bias,
+    size_t ldc,
+    const float* ABlockSum,
+    const float* QuantBBlkSum
+);
+
+static void
+SQ4BitGemmPackQuantBDataAndBlkSumAmx(
+    size_t N,
+    size_t K,
+    size_t BlkLen,
+    MLAS_QNBIT_GEMM_COMPUTE_TYPE ComputeType,
+    const std::byte* QuantBDataBegin,
+    const float* QuantBScaleBegin,
+    bool HasZeroPoint,
+    const std::byte* QuantBZPBegin,
+    PackedQuantBDataStruct<float, 4>& PackedQuantB,
+    MLAS_THREADPOOL* ThreadPool
+)
+{
+    if (ComputeType != SQNBIT_CompInt8) {
+        SQ4BitGemmPackQuantBDataAndBlkSum512vnni(
+            N, K, BlkLen, ComputeType, QuantBDataBegin, QuantBScaleBegin, HasZeroPoint, QuantBZPBegin, PackedQuantB, ThreadPool
+        );
+        return;
+    }
+
+    const size_t BlockCountK = MlasDivRoundup(K, BlkLen);
+
+    SQ4BitGemmPackQuantBDataAndBlkSum_CompInt8_amx(
+        N, BlockCountK, BlkLen, QuantBDataBegin, QuantBScaleBegin, HasZeroPoint, QuantBZPBegin, PackedQuantB, ThreadPool
+    );
+}
+
+//
+// Kernel dispatch structure definition for processors with amx int8 tiles.
+//
+// The 4-bit quantized B of the SQNBIT_CompInt8 compute type is packed for the
+// tile kernel, the other kernels are the avx512vnni ones. The structure is
+// defined in this module to be initialized after MlasSQNBitGemmDispatchAvx512vnni.
+//
+const MLAS_QNBIT_GEMM_DISPATCH MlasSQNBitGemmDispatchAmx = []() {
+    MLAS_QNBIT_GEMM_DISPATCH d = MlasSQNBitGemmDispatchAvx512vnni;
+
+    d.SQ4BitGemmPackQuantBDataAndBlkSum = SQ4BitGemmPackQuantBDataAndBlkSumAmx;
+    d.SQ4BitGemmKernel_BlkSum_CompInt8 = SQ4BitGemmKernel_BlkSum_CompInt8_amx;
+
+    return d;
+}();
+
+#endif  // !defined(__APPLE__)
@@ -4,10 +4,11 @@
 #include "core/optimizer/matmul_nbits_fusion.h"
 
 #include "core/common/common.h"
+#include "core/graph/graph_utils.h"
+#include "core/graph/node_attr_utils.h"
 #include "core/optimizer/selectors_actions/actions.h"
 
 #if !defined(ORT_MINIMAL_BUILD)
-#include "core/graph/graph_utils.h"
 #include "core/optimizer/utils.h"
 #include "core/framework/tensorprotoutils.h"
 #endif
@@ -20,13 +21,66 @@ namespace {
 
 namespace selectors {
 
+bool HasInput(const Node& node, size_t index) {
+  const auto input_defs = node.InputDefs();
+  return input_defs.size() > index && input_defs[index]->Exists();
+}
+
+// The epilogue of MatMulNBits is applied after the bias, in this order: activation, multiplier, residual.
+bool HasActivation(const Node& node) {
+  return graph_utils::GetNodeAttribute(node, "activation") != nullptr;
+}
+
+bool HasFloatElementType(const NodeArg& node_arg) {
+  const auto* type_proto = node_arg.TypeAsProto();
+  int32_t data_type;
+  return type_proto != nullptr && utils::TryGetElementDataType(*type_proto, data_type) &&
+         data_type == ONNX_NAMESPACE::TensorProto_DataType_FLOAT;
+}
+
+// check if two node args have the same known shape, with either the same values or the same names for each dimension
+bool HaveSameShape(const NodeArg& arg0, const NodeArg& arg1) {
+  const auto* shape0 = arg0.Shape();
+  const auto* shape1 = arg1.Shape();
+  if (shape0 == nullptr || shape1 == nullptr || shape0->dim_size() != shape1->dim_size()) {
+    return false;
+  }
+
+  for (int i = 0; i < shape0->dim_size(); ++i) {
+    const auto& dim0 = shape0->dim(i);
+    const auto& dim1 = shape1->dim(i);
+    const bool same_value = utils::HasDimValue(dim0) && utils::HasDimValue(dim1) &&
+                            dim0.dim_value() == dim1.dim_value();
+    const bool same_param = utils::HasDimParam(dim0) && utils::HasDimParam(dim1) &&
+                            dim0.dim_param() == dim1.dim_param();
+    if (!same_value && !same_param) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// the node consuming the only output of the MatMulNBits node, if it is assigned to the same EP
+const Node* GetLoneConsumerNode(const GraphViewer& graph_viewer, const Node& node) {
+  if (!optimizer_utils::CheckOutputEdges(graph_viewer.GetGraph(), node, 1)) {
+    return nullptr;
+  }
+
+  const Node& next_node = node.OutputEdgesBegin()->GetNode();
+  if (node.GetExecutionProviderType() != next_node.GetExecutionProviderType()) {
+    return nullptr;
+  }
+
+  return &next_node;
+}
+
 class BiasFusion : public NodeSelector {
  public:
   std::optional<NodesToOptimizeIndices> Select(const GraphViewer& graph_viewer,
                                                const Node& node) const override {
-    // check if MatMulNBits node already has a bias input
-    if (const auto input_defs = node.InputDefs();
-        input_defs.size() > 5 && input_defs[5]->Exists()) {
+    // check if MatMulNBits node already has a bias input, or an epilogue that must be applied after the bias
+    if (HasInput(node, 5) || HasActivation(node) || HasInput(node, 6) || HasInput(node, 7)) {
       return std::nullopt;
     }
 
@@ -71,6 +125,74 @@ class BiasFusion : public NodeSelector {
   }
 };
 
+class ActivationFusion : public NodeSelector {
+ public:
+  std::optional<NodesToOptimizeIndices> Select(const GraphViewer& graph_viewer,
+                                               const Node& node) const override {
+    // the epilogue is only supported for float by the CPU kernel
+    if (HasActivation(node) || HasInput(node, 6) || HasInput(node, 7) ||
+        !HasFloatElementType(*node.InputDefs()[0])) {
+      return std::nullopt;
+    }
+
+    const Node* next_node = GetLoneConsumerNode(graph_viewer, node);
+    if (next_node == nullptr) {
+      return std::nullopt;
+    }
+
+    if (!graph_utils::IsSupportedOptypeVersionAndDomain(*next_node, "Relu", {6, 13, 14}) &&
+        !graph_utils::IsSupportedOptypeVersionAndDomain(*next_node, "Sigmoid", {6, 13}) &&
+        !graph_utils::IsSupportedOptypeVersionAndDomain(*next_node, "Gelu", {20}) &&
+        !graph_utils::IsSupportedOptypeVersionAndDomain(*next_node, "Gelu", {1}, kMSDomain) &&
+        !graph_utils::IsSupportedOptypeVersionAndDomain(*next_node, "QuickGelu", {1}, kMSDomain) &&
+        !(graph_utils::IsSupportedOptypeVersionAndDomain(*next_node, "FastGelu", {1}, kMSDomain) &&
+          !HasInput(*next_node, 1))) {
+      return std::nullopt;
+    }
+
+    NodesToOptimizeIndicesBuilder builder{};
+    builder.target_node = node.Index();
+    builder.output_nodes = {next_node->Index()};
+    return builder.Build();
+  }
+};
+
+// Fuses a Mul or Add with a tensor of the shape of the MatMulNBits output into the multiplier or residual input.
+class ElementwiseFusion : public NodeSelector {
+ public:
+  ElementwiseFusion(std::string op_type, size_t input_index)
+      : op_type_{std::move(op_type)}, input_index_{input_index} {}
+
+  std::optional<NodesToOptimizeIndices> Select(const GraphViewer& graph_viewer,
+                                               const Node& node) const override {
+    // the residual is added last, so nothing can be fused after it
+    if (HasInput(node, input_index_) || HasInput(node, 7) || !HasFloatElementType(*node.InputDefs()[0])) {
+      return std::nullopt;
+    }
+
+    const Node* next_node = GetLoneConsumerNode(graph_viewer, node);
+    if (next_node == nullptr ||
+        !graph_utils::IsSupportedOptypeVersionAndDomain(*next_node, op_type_, {7, 13, 14})) {
+      return std::nullopt;
+    }
+
+    // the other input must not be broadcast
+    const auto other_index = node.OutputEdgesBegin()->GetDstArgIndex() == 0 ? 1 : 0;
+    if (!HaveSameShape(*next_node->InputDefs()[other_index], *node.OutputDefs()[0])) {
+      return std::nullopt;
+    }
+
+    NodesToOptimizeIndicesBuilder builder{};
+    builder.target_node = node.Index();
+    builder.output_nodes = {next_node->Index()};
+    return builder.Build();
+  }
+
+ private:
+  const std::string op_type_;
+  const size_t input_index_;
+};
+
 }  // namespace selectors
 
 #endif  // !defined(ORT_MINIMAL_BUILD)
@@ -98,6 +220,70 @@ struct BiasFusion : MergeIntoTarget {
   }
 };
 
+struct ActivationFusion : public ReplaceWithNew {
+ private:
+  std::string OpType(const RuntimeState&) const override { return "MatMulNBits"; }
+
+  std::string Domain(const RuntimeState&) const override { return kMSDomain; }
+
+  NodeAttributes ExtraAttributes(const RuntimeState& state) const override {
+    NodeAttributes extra_attributes;
+
+    const auto* activation = state.selected_nodes.Output(0);
+    ORT_ENFORCE(activation != nullptr, "Expected activation node.");
+
+    std::string activation_op_type = activation->OpType();
+    if (activation_op_type == "Gelu" && activation->Domain() == kOnnxDomain) {
+      const auto* approximate_attr = graph_utils::GetNodeAttribute(*activation, "approximate");
+      if (approximate_attr != nullptr && approximate_attr->s() == "tanh") {
+        activation_op_type = "FastGelu";
+      }
+    }
+    utils::SetNodeAttribute(utils::MakeAttribute("activation", activation_op_type), extra_attributes);
+
+    if (activation_op_type == "QuickGelu") {
+      const auto* alpha_attr = graph_utils::GetNodeAttribute(*activation, "alpha");
+      const float alpha = alpha_attr == nullptr ? 1.702f : alpha_attr->f();
+      utils::SetNodeAttribute(utils::MakeAttribute("activation_alpha", alpha), extra_attributes);
+    }
+
+    return extra_attributes;
+  }
+
+  std::vector<NodeAndMoveInfo> ValueMoves(const RuntimeState&) const override {
+    const NTO::NodeLocation matmul{NTO::NodeType::kTarget, 0};
+    const NTO::NodeLocation activation{NTO::NodeType::kOutput, 0};
+
+    return {
+        MoveAll(matmul, ArgType::kInput),       // move all inputs from MatMulNBits
+        MoveAll(activation, ArgType::kOutput),  // move all outputs from activation
+    };
+  }
+};
+
+struct ElementwiseFusion : MergeIntoTarget {
+  explicit ElementwiseFusion(int input_index) : input_index_{input_index} {}
+
+ private:
+  std::vector<NodeAndMoveInfo> ValueMoves(const RuntimeState& runtime_state) const override {
+    const Node& target = runtime_state.selected_nodes.Target();
+    ORT_ENFORCE(target.GetOutputEdgesCount() == 1);
+    const auto edge_to_next_node = target.OutputEdgesBegin();
+    const auto other_index = edge_to_next_node->GetDstArgIndex() == 0 ? 1 : 0;
+
+    NTO::NodeLocation next_location{NTO::NodeType::kOutput, 0};
+
+    std::vector<NodeAndMoveInfo> value_moves{
+        MoveToSlot(next_location, ArgType::kInput, other_index, ArgType::kInput, input_index_),
+        MoveToSlot(next_location, ArgType::kOutput, 0, ArgType::kOutput, 0),
+    };
+
+    return value_moves;
+  }
+
+  const int input_index_;
+};
+
 }  // namespace actions
 
 void BiasFusionRule(SelectorActionRegistry& registry) {
@@ -121,12 +307,57 @@ void BiasFusionRule(SelectorActionRegistry& registry) {
 #endif
 }
 
+void ActivationFusionRule(SelectorActionRegistry& registry) {
+  constexpr const char* name = "FuseActivation";
+
+  auto action = std::make_unique<actions::ActivationFusion>();
+
+#if !defined(ORT_MINIMAL_BUILD)
+
+  auto selector = std::make_unique<selectors::ActivationFusion>();
+
+  registry.RegisterSelectorAndAction(name,
+                                     {{SelectorActionRegistry::OpVersionsMapKey("MatMulNBits", kMSDomain), {}}},
+                                     std::move(selector),
+                                     std::move(action));
+
+#else
+
+  registry.RegisterAction(name, std::move(action));
+
+#endif
+}
+
+void ElementwiseFusionRule(SelectorActionRegistry& registry, const char* name, const char* op_type,
+                           int input_index) {
+  auto action = std::make_unique<actions::ElementwiseFusion>(input_index);
+
+#if !defined(ORT_MINIMAL_BUILD)
+
+  auto selector = std::make_unique<selectors::ElementwiseFusion>(op_type, static_cast<size_t>(input_index));
+
+  registry.RegisterSelectorAndAction(name,
+                                     {{SelectorActionRegistry::OpVersionsMapKey("MatMulNBits", kMSDomain), {}}},
+                                     std::move(selector),
+                                     std::move(action));
+
+#else
+
+  ORT_UNUSED_PARAMETER(op_type);
+  registry.RegisterAction(name, std::move(action));
+
+#endif
+}
+
 }  // namespace
 
 SelectorActionRegistry MatMulNBitsFusion::CreateSelectorActionRegistry() const {
   SelectorActionRegistry registry{};
 
   BiasFusionRule(registry);
+  ActivationFusionRule(registry);
+  ElementwiseFusionRule(registry, "FuseMultiplier", "Mul", 6);
+  ElementwiseFusionRule(registry, "FuseResidual", "Add", 7);
 
   return registry;
 }
@@ -10,6 +10,9 @@ namespace onnxruntime {
 // Performs node fusions with MatMulNBits.
 // Currently supports these fusions:
 // - MatMulNBits + Add -> MatMulNBits with bias input
+// - MatMulNBits + Relu/Sigmoid/Gelu/FastGelu/QuickGelu -> MatMulNBits with activation attribute
+// - MatMulNBits + Mul -> MatMulNBits with multiplier input, e.g. the gating of a SwiGLU
+// - MatMulNBits + Add -> MatMulNBits with residual input
 class MatMulNBitsFusion : public SelectorActionTransformer {
  public:
   MatMulNBitsFusion(const InlinedHashSet<std::string_view>& compatible_eps = {},
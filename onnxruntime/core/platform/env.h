@@ -83,6 +83,11 @@ struct ThreadOptions {
   // The process that owns the thread may consider setting its affinity.
   std::vector<LogicalProcessors> affinities;
 
+  // NUMA node of each thread, in the same order as affinities. If the node of a thread is not negative, the memory
+  // the thread allocates is bound to the node, and the thread pool prefers to exchange work between threads of the
+  // same node. Empty if the thread pool is not NUMA aware.
+  std::vector<int> numa_nodes;
+
   // Set or unset denormal as zero.
   bool set_denormal_as_zero = false;
 
@@ -90,6 +95,10 @@ struct ThreadOptions {
   void* custom_thread_creation_options = nullptr;
   OrtCustomJoinThreadFn custom_join_thread_fn = nullptr;
   int dynamic_block_base_ = 0;
+
+  // If it is greater than 0, the threads adapt the time they spin for work before blocking to the idle gaps they
+  // observe, up to this number of microseconds. Only applies if the thread pool allows spinning.
+  int adaptive_spin_budget_us = 0;
 };
 
 std::ostream& operator<<(std::ostream& os, const LogicalProcessors&);
@@ -148,6 +157,24 @@ class Env {
 
   virtual int GetL2CacheSize() const = 0;
 
+  /// <summary>
+  /// Returns the NUMA node of every logical processor, indexed by the logical processor id.
+  /// The node is -1 for a processor whose node is unknown.
+  /// </summary>
+  /// <returns>The NUMA nodes, or an empty vector if the NUMA topology is not available</returns>
+  virtual std::vector<int> GetNumaNodeOfLogicalProcessors() const { return {}; }
+
+  /// <summary>
+  /// Sets the NUMA memory policy of the calling thread, which decides where the pages it touches first are placed.
+  /// An empty list of nodes restores the default policy, a single node prefers that node and multiple nodes
+  /// interleave the pages across them.
+  /// </summary>
+  /// <returns>true if the policy was set, false if it is not supported</returns>
+  virtual bool SetCurrentThreadNumaMemoryPolicy(gsl::span<const int> numa_nodes) const {
+    ORT_UNUSED_PARAMETER(numa_nodes);
+    return false;
+  }
+
   /// \brief Returns the number of micro-seconds since the Unix epoch.
   virtual uint64_t NowMicros() const {
     return env_time_->NowMicros();
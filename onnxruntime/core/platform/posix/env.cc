@@ -49,6 +49,13 @@ limitations under the License.
 #include <sys/sysctl.h>
 #endif
 
+#if defined(__linux__) && !defined(__ANDROID__)
+#include <dirent.h>
+#include <linux/mempolicy.h>
+#include <fstream>
+#define ORT_USE_LINUX_NUMA
+#endif
+
 #include "core/common/common.h"
 #include <gsl/gsl>
 #include "core/common/logging/logging.h"
@@ -117,6 +124,42 @@ struct Freer {
 
 using MallocdStringPtr = std::unique_ptr<char, Freer<char> >;
 
+#if defined(ORT_USE_LINUX_NUMA)
+// Parses a list of logical processors in the format of the sysfs, e.g. "0-3,8-11".
+bool ParseCpuList(const std::string& cpu_list, std::vector<int>& cpus) {
+  size_t pos = 0;
+  while (pos < cpu_list.size()) {
+    size_t end = cpu_list.find(',', pos);
+    if (end == std::string::npos) {
+      end = cpu_list.size();
+    }
+
+    const std::string range = cpu_list.substr(pos, end - pos);
+    pos = end + 1;
+    if (range.empty()) {
+      continue;
+    }
+
+    char* parse_end = nullptr;
+    const long first = strtol(range.c_str(), &parse_end, 10);
+    long last = first;
+    if (*parse_end == '-') {
+      last = strtol(parse_end + 1, &parse_end, 10);
+    }
+
+    if (*parse_end != '\0' || first < 0 || last < first) {
+      return false;
+    }
+
+    for (long cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(static_cast<int>(cpu));
+    }
+  }
+
+  return true;
+}
+#endif
+
 class PosixThread : public EnvThread {
  private:
   struct Param {
@@ -125,6 +168,7 @@ class PosixThread : public EnvThread {
     unsigned (*start_address)(int id, Eigen::ThreadPoolInterface* param);
     Eigen::ThreadPoolInterface* param;
     std::optional<LogicalProcessors> affinity;
+    int numa_node = -1;
 
     Param(const ORTCHAR_T* name_prefix1,
           int index1,
@@ -149,6 +193,9 @@ class PosixThread : public EnvThread {
     if (narrow<size_t>(index) < thread_options.affinities.size()) {
       param_ptr->affinity = thread_options.affinities[index];
     }
+    if (narrow<size_t>(index) < thread_options.numa_nodes.size()) {
+      param_ptr->numa_node = thread_options.numa_nodes[index];
+    }
 
     if (custom_create_thread_fn) {
       custom_thread_handle = custom_create_thread_fn(custom_thread_creation_options, CustomThreadMain, param_ptr.get());
@@ -233,6 +280,12 @@ class PosixThread : public EnvThread {
         }
       }
 #endif
+      if (p->numa_node >= 0) {
+        // the worker is bound to the processors of the node, so the memory it touches first, e.g. its part of the
+        // output of a parallel loop, should be local to it as well
+        const int numa_nodes[] = {p->numa_node};
+        Env::Default().SetCurrentThreadNumaMemoryPolicy(numa_nodes);
+      }
       // Ignore the returned value for now
       p->start_address(p->index, p->param);
     }
@@ -317,6 +370,82 @@ class PosixEnv : public Env {
 #endif
   }
 
+  std::vector<int> GetNumaNodeOfLogicalProcessors() const override {
+    std::vector<int> ret;
+#if defined(ORT_USE_LINUX_NUMA)
+    constexpr const char* kNodeDir = "/sys/devices/system/node";
+    DIR* dir = opendir(kNodeDir);
+    if (dir == nullptr) {
+      return ret;
+    }
+
+    while (const struct dirent* entry = readdir(dir)) {
+      // the directories of the nodes are named node<id>
+      if (strncmp(entry->d_name, "node", 4) != 0) {
+        continue;
+      }
+
+      char* parse_end = nullptr;
+      const long node = strtol(entry->d_name + 4, &parse_end, 10);
+      if (parse_end == entry->d_name + 4 || *parse_end != '\0') {
+        continue;
+      }
+
+      std::ifstream cpu_list_file(std::string{kNodeDir} + "/" + entry->d_name + "/cpulist");
+      std::string cpu_list;
+      std::vector<int> cpus;
+      if (!std::getline(cpu_list_file, cpu_list) || !ParseCpuList(cpu_list, cpus)) {
+        ret.clear();
+        break;
+      }
+
+      for (int cpu : cpus) {
+        if (static_cast<size_t>(cpu) >= ret.size()) {
+          ret.resize(static_cast<size_t>(cpu) + 1, -1);
+        }
+        ret[cpu] = static_cast<int>(node);
+      }
+    }
+
+    closedir(dir);
+#endif
+    return ret;
+  }
+
+  bool SetCurrentThreadNumaMemoryPolicy(gsl::span<const int> numa_nodes) const override {
+#if defined(ORT_USE_LINUX_NUMA) && defined(SYS_set_mempolicy)
+    constexpr size_t kBitsPerWord = sizeof(unsigned long) * 8;
+    std::vector<unsigned long> node_mask;
+    for (int node : numa_nodes) {
+      if (node < 0) {
+        return false;
+      }
+      const size_t word = static_cast<size_t>(node) / kBitsPerWord;
+      if (word >= node_mask.size()) {
+        node_mask.resize(word + 1, 0);
+      }
+      node_mask[word] |= 1UL << (static_cast<size_t>(node) % kBitsPerWord);
+    }
+
+    // a preferred node falls back to the other nodes when it runs out of memory
+    const int mode = numa_nodes.empty() ? MPOL_DEFAULT : numa_nodes.size() == 1 ? MPOL_PREFERRED
+                                                                                  : MPOL_INTERLEAVE;
+    // the kernel ignores the last bit of the mask
+    const unsigned long max_node = node_mask.empty() ? 0 : node_mask.size() * kBitsPerWord + 1;
+    if (syscall(SYS_set_mempolicy, mode, node_mask.empty() ? nullptr : node_mask.data(), max_node) != 0) {
+      auto [err_no, err_msg] = GetErrnoInfo();
+      LOGS_DEFAULT(WARNING) << "set_mempolicy failed for thread: " << syscall(SYS_gettid)
+                            << ", error code: " << err_no << " error msg: " << err_msg;
+      return false;
+    }
+
+    return true;
+#else
+    ORT_UNUSED_PARAMETER(numa_nodes);
+    return false;
+#endif
+  }
+
   void SleepForMicroseconds(int64_t micros) const override {
     while (micros > 0) {
       timespec sleep_time;
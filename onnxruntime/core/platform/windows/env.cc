@@ -301,6 +301,26 @@ int WindowsEnv::GetL2CacheSize() const {
   return l2_cache_size_;
 }
 
+std::vector<int> WindowsEnv::GetNumaNodeOfLogicalProcessors() const {
+  std::vector<int> ret;
+  for (const auto& [global_processor_id, processor_info] : global_processor_info_map_) {
+    PROCESSOR_NUMBER processor_number{};
+    processor_number.Group = static_cast<WORD>(processor_info.group_id);
+    processor_number.Number = static_cast<BYTE>(processor_info.local_processor_id);
+    USHORT node_number = 0;
+    if (!GetNumaProcessorNodeEx(&processor_number, &node_number) || node_number == MAXUSHORT) {
+      return {};
+    }
+
+    if (static_cast<size_t>(global_processor_id) >= ret.size()) {
+      ret.resize(static_cast<size_t>(global_processor_id) + 1, -1);
+    }
+    ret[global_processor_id] = static_cast<int>(node_number);
+  }
+
+  return ret;
+}
+
 WindowsEnv& WindowsEnv::Instance() {
   static WindowsEnv default_env;
   return default_env;
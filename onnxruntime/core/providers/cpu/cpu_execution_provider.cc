@@ -3,11 +3,14 @@
 
 #include "core/providers/cpu/cpu_execution_provider.h"
 
+#include "core/common/parse_string.h"
 #include "core/framework/allocator_utils.h"
 #include "core/framework/op_kernel.h"
 #include "core/framework/kernel_registry.h"
 #include "core/framework/int4.h"
+#include "core/framework/session_options.h"
 #include "core/mlas/inc/mlas.h"
+#include "core/session/onnxruntime_session_options_config_keys.h"
 
 #ifndef DISABLE_CONTRIB_OPS
 #include "contrib_ops/cpu/cpu_contrib_kernels.h"
@@ -27,13 +30,22 @@ struct KernelRegistryAndStatus {
 }  // namespace
 
 namespace onnxruntime {
+CPUExecutionProviderInfo CPUExecutionProviderInfo::FromSessionOptions(const SessionOptions& session_options) {
+  CPUExecutionProviderInfo info{session_options.enable_cpu_mem_arena};
+  info.arena_extend_strategy = ParseStringWithClassicLocale<int>(
+      session_options.config_options.GetConfigOrDefault(kOrtSessionOptionsCpuArenaExtendStrategy, "-1"));
+  return info;
+}
+
 CPUExecutionProvider::CPUExecutionProvider(const CPUExecutionProviderInfo& info)
     : IExecutionProvider{onnxruntime::kCpuExecutionProvider}, info_{info} {}
 
 std::vector<AllocatorPtr> CPUExecutionProvider::CreatePreferredAllocators() {
   const bool create_arena = DoesCpuAllocatorSupportArenaUsage() ? info_.create_arena : false;
+  OrtArenaCfg arena_cfg;
+  arena_cfg.arena_extend_strategy = info_.arena_extend_strategy;
   AllocatorCreationInfo device_info_cpu{[](int) { return std::make_unique<CPUAllocator>(); },
-                                        DEFAULT_CPU_ALLOCATOR_DEVICE_ID, create_arena};
+                                        DEFAULT_CPU_ALLOCATOR_DEVICE_ID, create_arena, arena_cfg};
 
   return std::vector<AllocatorPtr>{CreateAllocator(device_info_cpu)};
 }
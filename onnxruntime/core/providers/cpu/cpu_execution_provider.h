@@ -8,14 +8,21 @@
 
 namespace onnxruntime {
 
+struct SessionOptions;
+
 // Information needed to construct CPU execution providers.
 struct CPUExecutionProviderInfo {
   bool create_arena{true};
+  // arena_extend_strategy of the OrtArenaCfg for the CPU arena. -1 for the default.
+  int arena_extend_strategy{-1};
 
   explicit CPUExecutionProviderInfo(bool use_arena)
       : create_arena(use_arena) {}
 
   CPUExecutionProviderInfo() = default;
+
+  // Create the info for the CPU execution provider of a session with `session_options`.
+  static CPUExecutionProviderInfo FromSessionOptions(const SessionOptions& session_options);
 };
 
 using FuseRuleFn = std::function<void(const onnxruntime::GraphViewer&,
@@ -31,8 +31,7 @@ std::unique_ptr<IExecutionProvider> CpuProviderFactory::CreateProvider() {
 
 std::unique_ptr<IExecutionProvider> CpuProviderFactory::CreateProvider(const OrtSessionOptions& session_options,
                                                                        const OrtLogger& session_logger) {
-  CPUExecutionProviderInfo info;
-  info.create_arena = session_options.value.enable_cpu_mem_arena;
+  auto info = CPUExecutionProviderInfo::FromSessionOptions(session_options.value);
 
   auto cpu_ep = std::make_unique<CPUExecutionProvider>(info);
   cpu_ep->SetLogger(reinterpret_cast<const logging::Logger*>(&session_logger));
@@ -3,8 +3,11 @@
 
 #pragma once
 
+#include <string_view>
+
 #include "core/common/common.h"
 #include "core/framework/op_kernel.h"
+#include "core/framework/string_tensor_view.h"
 #include "core/providers/cpu/ml/ml_common.h"
 
 namespace onnxruntime {
@@ -26,11 +29,25 @@ class CategoryMapper final : public OpKernel {
 
     ORT_ENFORCE(num_entries == int_categories.size());
 
+    // The categories are stored once, one after the other in a single buffer, and both tables refer to them
+    // through views instead of holding two copies of every string.
+    size_t total_length = 0;
+    for (const std::string& str : string_categories) {
+      total_length += str.size();
+    }
+    category_data_.reserve(total_length);
+    category_offsets_.reserve(num_entries);
+    for (const std::string& str : string_categories) {
+      category_offsets_.push_back(category_data_.size());
+      category_data_ += str;
+    }
+    ORT_THROW_IF_ERROR(StringTensorView::Create(category_data_, category_offsets_, categories_));
+
     string_to_int_map_.reserve(num_entries);
     int_to_string_map_.reserve(num_entries);
 
     for (size_t i = 0; i < num_entries; ++i) {
-      const std::string& str = string_categories[i];
+      const std::string_view str = categories_[i];
       int64_t index = int_categories[i];
 
       string_to_int_map_[str] = index;
@@ -41,8 +58,12 @@ class CategoryMapper final : public OpKernel {
   Status Compute(OpKernelContext* context) const override;
 
  private:
-  std::unordered_map<std::string, int64_t> string_to_int_map_;
-  std::unordered_map<int64_t, std::string> int_to_string_map_;
+  std::string category_data_;
+  std::vector<size_t> category_offsets_;
+  StringTensorView categories_;
+
+  InlinedHashMap<std::string_view, int64_t> string_to_int_map_;
+  InlinedHashMap<int64_t, std::string_view> int_to_string_map_;
 
   std::string default_string_;
   int64_t default_int_;
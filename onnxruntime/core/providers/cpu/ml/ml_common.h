@@ -528,5 +528,30 @@ void batched_update_scores_inplace(gsl::span<T> scores, int64_t num_batches_in,
     }
   }
 }
+
+// Writes the value associated to every element of input by the lookup table, or default_value if the element is not
+// in the table. The lookups are independent so large inputs are split over the thread pool.
+template <typename TKey, typename TValue, typename Map>
+void LookupValues(const Map& map, gsl::span<const TKey> input, gsl::span<TValue> output, const TValue& default_value,
+                  concurrency::ThreadPool* threadpool) {
+  ORT_ENFORCE(input.size() == output.size());
+
+  // A lookup hashes the key and compares it with the few candidates of its probe, strings have to be hashed
+  // byte by byte and copied to the output.
+  constexpr bool has_string = std::is_same_v<TKey, std::string> || std::is_same_v<TValue, std::string>;
+  const TensorOpCost cost{static_cast<double>(sizeof(TKey)), static_cast<double>(sizeof(TValue)),
+                          has_string ? 64.0 : 16.0};
+
+  concurrency::ThreadPool::TryParallelFor(
+      threadpool, static_cast<std::ptrdiff_t>(input.size()), cost,
+      [&map, &input, &output, &default_value](std::ptrdiff_t first, std::ptrdiff_t last) {
+        const auto map_end = map.end();
+        for (std::ptrdiff_t i = first; i < last; ++i) {
+          const auto found = map.find(input[i]);
+          output[i] = found == map_end ? default_value : found->second;
+        }
+      });
+}
+
 }  // namespace ml
 }  // namespace onnxruntime
@@ -63,6 +63,9 @@ SVMClassifier::SVMClassifier(const OpKernelInfo& info)
   if (vector_count_ > 0) {
     feature_count_ = support_vectors_.size() / vector_count_;  // length of each support vector
     mode_ = SVM_TYPE::SVM_SVC;
+    if (get_kernel_type() == KERNEL::RBF) {
+      rbf_support_vectors_ = PrecomputeRbfSupportVectors(support_vectors_, vector_count_, feature_count_);
+    }
   } else {
     feature_count_ = coefficients_.size() / class_count_;  // liblinear mode
     mode_ = SVM_TYPE::SVM_LINEAR;
@@ -245,7 +248,7 @@ Status SVMClassifier::ComputeImpl(OpKernelContext& ctx,
     // combine the input data with the support vectors and apply the kernel type
     // output is {num_batches, vector_count_}
     batched_kernel_dot<float>(x_data, support_vectors_, num_batches, vector_count_, feature_count_, 0.f, kernels_span,
-                              threadpool);
+                              threadpool, &rbf_support_vectors_);
 
     for (int64_t n = 0; n < num_batches; n++) {
       // reduce scores from kernels using coefficients, taking into account the varying number of support vectors
@@ -30,37 +30,98 @@ class SVMCommon {
   void set_kernel_type(KERNEL new_kernel_type) { kernel_type_ = new_kernel_type; }
   KERNEL get_kernel_type() const { return kernel_type_; }
 
+  // The support vectors of the RBF kernel centered on their mean, and their squared norms.
+  // They only depend on the model so they are computed once when the kernel is created.
+  struct RbfSupportVectors {
+    std::vector<float> mean;
+    std::vector<float> centered;
+    std::vector<float> norms;
+  };
+
+  static RbfSupportVectors PrecomputeRbfSupportVectors(gsl::span<const float> b, ptrdiff_t n, ptrdiff_t k) {
+    assert(b.size() == size_t(k * n));
+
+    RbfSupportVectors rbf;
+    rbf.mean.resize(onnxruntime::narrow<size_t>(k), 0.f);
+    rbf.centered.resize(b.size());
+    rbf.norms.resize(onnxruntime::narrow<size_t>(n));
+
+    auto map_mean = EigenVectorArrayMap<float>(rbf.mean.data(), rbf.mean.size());
+    for (int64_t support_vector = 0; support_vector < n; ++support_vector) {
+      map_mean += ConstEigenVectorArrayMap<float>(b.data() + support_vector * k, rbf.mean.size());
+    }
+    if (n > 0) {
+      map_mean /= static_cast<float>(n);
+    }
+
+    for (int64_t support_vector = 0; support_vector < n; ++support_vector) {
+      auto map_b = EigenVectorArrayMap<float>(rbf.centered.data() + support_vector * k, rbf.mean.size());
+      map_b = ConstEigenVectorArrayMap<float>(b.data() + support_vector * k, rbf.mean.size()) - map_mean;
+      rbf.norms[onnxruntime::narrow<size_t>(support_vector)] = map_b.square().sum();
+    }
+
+    return rbf;
+  }
+
+  // rbf_b is the precomputed form of b and is only used by the RBF kernel.
   template <typename T>
   void batched_kernel_dot(const gsl::span<const T> a, const gsl::span<const T> b,
                           ptrdiff_t m, ptrdiff_t n, ptrdiff_t k,
                           float scalar_C,
                           const gsl::span<T> out,
-                          concurrency::ThreadPool* threadpool) const {
+                          concurrency::ThreadPool* threadpool,
+                          const RbfSupportVectors* rbf_b = nullptr) const {
     assert(a.size() == size_t(m * k) && b.size() == size_t(k * n) && out.size() == size_t(m * n));
 
     if (kernel_type_ == KERNEL::RBF) {
+      // |a - b|^2 = |a|^2 + |b|^2 - 2 a.b, the dot products of all the rows with all the support vectors
+      // are computed with one GEMM. Both are centered on the mean of the support vectors first to keep the norms
+      // small compared to the distances.
+      ORT_ENFORCE(rbf_b != nullptr && rbf_b->norms.size() == size_t(n));
+      const auto map_mean = ConstEigenVectorArrayMap<T>(rbf_b->mean.data(), rbf_b->mean.size());
+
+      std::vector<T> centered_a(a.size());
+      for (int64_t batch = 0; batch < m; ++batch) {
+        EigenVectorArrayMap<T>(centered_a.data() + batch * k, map_mean.size()) =
+            ConstEigenVectorArrayMap<T>(a.data() + batch * k, map_mean.size()) - map_mean;
+      }
+
+      onnxruntime::Gemm<T>::ComputeGemm(CBLAS_TRANSPOSE::CblasNoTrans, CBLAS_TRANSPOSE::CblasTrans,
+                                        m, n, k,
+                                        -2.f, centered_a.data(), rbf_b->centered.data(), 0.f,
+                                        nullptr, nullptr,
+                                        out.data(),
+                                        threadpool);
+
       T* cur_out = out.data();
       const T* cur_batch = a.data();
-
-      // each batch has 'k' features
       for (int64_t batch = 0; batch < m; ++batch) {
+        const T a_norm = ConstEigenVectorArrayMap<T>(centered_a.data() + batch * k, map_mean.size()).square().sum();
         const T* cur_support_vector = b.data();
 
-        // broadcast the support vectors against the k features in each batch. output is one value per support vector
         for (int64_t support_vector = 0; support_vector < n; ++support_vector) {
-          T sum = 0.f;
-          const T* cur_input = cur_batch;
-
-          for (int64_t feature = 0; feature < k; ++feature) {
-            T val = *cur_input++ - *cur_support_vector++;
-            sum += val * val;
+          const T norms = a_norm + rbf_b->norms[onnxruntime::narrow<size_t>(support_vector)];
+          T sum = *cur_out + norms;
+
+          // The expansion loses the precision of the distance when the row is close to the support vector
+          // compared to their norms, the distance is computed directly in that case as before.
+          if (sum < norms * static_cast<T>(1e-2)) {
+            sum = 0.f;
+            const T* cur_input = cur_batch;
+            for (int64_t feature = 0; feature < k; ++feature) {
+              T val = cur_input[feature] - cur_support_vector[feature];
+              sum += val * val;
+            }
           }
 
-          *cur_out++ = std::exp(-gamma_ * sum);
+          *cur_out++ = -gamma_ * sum;
+          cur_support_vector += k;
         }
 
         cur_batch += k;  // move to start of next batch
       }
+
+      MlasComputeExp(out.data(), out.data(), out.size());
     } else {
       float alpha = 1.f;
       float beta = 1.f;
@@ -105,6 +166,8 @@ class SVMCommon {
 class SVMClassifier final : public OpKernel, private SVMCommon {
   using SVMCommon::batched_kernel_dot;
   using SVMCommon::get_kernel_type;
+  using SVMCommon::PrecomputeRbfSupportVectors;
+  using SVMCommon::RbfSupportVectors;
   using SVMCommon::set_kernel_type;
 
  public:
@@ -126,6 +189,7 @@ class SVMClassifier final : public OpKernel, private SVMCommon {
   std::vector<float> probb_;
   std::vector<float> coefficients_;
   std::vector<float> support_vectors_;
+  RbfSupportVectors rbf_support_vectors_;
   std::vector<int64_t> classlabels_ints_;
   std::vector<std::string> classlabels_strings_;
   POST_EVAL_TRANSFORM post_transform_;
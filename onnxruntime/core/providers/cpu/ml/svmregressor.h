@@ -16,6 +16,8 @@ template <typename T>
 class SVMRegressor final : public OpKernel, private SVMCommon {
   using SVMCommon::batched_kernel_dot;
   using SVMCommon::get_kernel_type;
+  using SVMCommon::PrecomputeRbfSupportVectors;
+  using SVMCommon::RbfSupportVectors;
   using SVMCommon::set_kernel_type;
 
  public:
@@ -29,6 +31,7 @@ class SVMRegressor final : public OpKernel, private SVMCommon {
   std::vector<float> rho_;
   std::vector<float> coefficients_;
   std::vector<float> support_vectors_;
+  RbfSupportVectors rbf_support_vectors_;
   POST_EVAL_TRANSFORM post_transform_;
   SVM_TYPE mode_;  // how are we computing SVM? 0=LibSVC, 1=LibLinear
 };
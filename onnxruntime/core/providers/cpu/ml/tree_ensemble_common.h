@@ -8,6 +8,8 @@
 #include "tree_ensemble_helper.h"
 #include "tree_ensemble_attribute.h"
 #include "tree_ensemble_aggregator.h"
+#include "tree_ensemble_compact.h"
+#include "tree_ensemble_quickscorer.h"
 
 namespace onnxruntime {
 namespace ml {
@@ -53,6 +55,10 @@ class TreeEnsembleCommon : public TreeEnsembleCommonAttributes {
   // `ThresholdType` is used as well for output type (double as well for lightgbm) and not `OutputType`.
   std::vector<SparseValue<ThresholdType>> weights_;
   std::vector<TreeNodeElement<ThresholdType>*> roots_;
+  // Evaluate the trees by batches of rows instead of ProcessTreeNodeLeave, nullptr if not applicable.
+  // quick_scorer_ is used for trees with at most 64 leaves, compact_trees_ for larger ones.
+  std::unique_ptr<TreeEnsembleQuickScorer<InputType, ThresholdType>> quick_scorer_;
+  std::unique_ptr<TreeEnsembleCompact<InputType, ThresholdType>> compact_trees_;
 
  public:
   TreeEnsembleCommon() {}
@@ -72,6 +78,18 @@ class TreeEnsembleCommon : public TreeEnsembleCommonAttributes {
   template <typename AGG>
   void ComputeAgg(concurrency::ThreadPool* ttp, const Tensor* X, Tensor* Y, Tensor* label, const AGG& agg) const;
 
+  bool HasBatchEngine() const { return quick_scorer_ != nullptr || compact_trees_ != nullptr; }
+
+  void ComputeLeaves(const InputType* x_data, int64_t stride, int64_t n_rows,
+                     const TreeNodeElement<ThresholdType>** leaves) const;
+
+  void ComputeLeaves(concurrency::ThreadPool* ttp, int32_t num_threads, const InputType* x_data,
+                     int64_t stride, int64_t begin, int64_t end,
+                     const TreeNodeElement<ThresholdType>** leaves) const;
+
+  template <typename FN>
+  void ProcessRowsLeaves(const InputType* x_data, int64_t stride, int64_t begin, int64_t end, FN&& fn) const;
+
  private:
   bool CheckIfSubtreesAreEqual(const size_t left_id, const size_t right_id, const int64_t tree_id, const InlinedVector<NODE_MODE_ONNX>& cmodes,
                                const InlinedVector<size_t>& truenode_ids, const InlinedVector<size_t>& falsenode_ids, gsl::span<const int64_t> nodes_featureids,
@@ -308,8 +326,15 @@ Status TreeEnsembleCommon<InputType, ThresholdType, OutputType>::Init(
     }
   }
 
+  quick_scorer_ = TreeEnsembleQuickScorer<InputType, ThresholdType>::Create(roots_);
+  if (quick_scorer_ == nullptr) {
+    compact_trees_ = TreeEnsembleCompact<InputType, ThresholdType>::Create(roots_);
+  }
+
 #if defined(_TREE_DEBUG)
   std::cout << "TreeEnsemble:same_mode_=" << (same_mode_ ? 1 : 0) << "\n";
+  std::cout << "TreeEnsemble:quick_scorer_=" << (quick_scorer_ != nullptr ? 1 : 0) << "\n";
+  std::cout << "TreeEnsemble:compact_trees_=" << (compact_trees_ != nullptr ? 1 : 0) << "\n";
   for (auto& node : nodes_) {
     std::cout << node.str() << "\n";
   }
@@ -529,6 +554,26 @@ void TreeEnsembleCommon<InputType, ThresholdType, OutputType>::ComputeAgg(concur
         }
       }
       agg.FinalizeScores1(z_data, score, label_data);
+    } else if (HasBatchEngine() &&
+               (N <= parallel_N_ || max_num_threads == 1 || n_trees_ <= max_num_threads)) {
+      /* sections C and E evaluated by batches of rows: 1 output, 2+ rows, parallelization by rows if enough rows */
+      auto num_threads = N <= parallel_N_ || max_num_threads == 1 ? 1 : std::min<int32_t>(max_num_threads, SafeInt<int32_t>(N));
+      concurrency::ThreadPool::TrySimpleParallelFor(
+          ttp,
+          num_threads,
+          [this, &agg, num_threads, x_data, z_data, label_data, N, stride](ptrdiff_t batch_num) {
+            auto work = concurrency::ThreadPool::PartitionWork(batch_num, num_threads, onnxruntime::narrow<ptrdiff_t>(N));
+            ProcessRowsLeaves(
+                x_data, stride, work.start, work.end,
+                [this, &agg, z_data, label_data](int64_t i, const TreeNodeElement<ThresholdType>* const* leaves) {
+                  ScoreValue<ThresholdType> score = {0, 0};
+                  for (size_t j = 0; j < static_cast<size_t>(n_trees_); ++j) {
+                    agg.ProcessTreeNodePrediction1(score, *leaves[j]);
+                  }
+                  agg.FinalizeScores1(z_data + i, score,
+                                      label_data == nullptr ? nullptr : (label_data + i));
+                });
+          });
     } else if (N <= parallel_N_ || max_num_threads == 1) { /* section C: 1 output, 2+ rows but not enough rows to parallelize */
       // Not enough data to parallelize but the computation is split into batches of 128 rows,
       // and then loop on trees to evaluate every tree on this batch.
@@ -562,13 +607,18 @@ void TreeEnsembleCommon<InputType, ThresholdType, OutputType>::ComputeAgg(concur
     } else if (n_trees_ > max_num_threads) { /* section D: 1 output, 2+ rows and enough trees to parallelize */
       auto num_threads = std::min<int32_t>(max_num_threads, SafeInt<int32_t>(n_trees_));
       std::vector<ScoreValue<ThresholdType>> scores(SafeInt<size_t>(num_threads) * N);
+      std::vector<const TreeNodeElement<ThresholdType>*> leaves(
+          HasBatchEngine() ? SafeInt<size_t>(parallel_tree_N_) * n_trees_ : 0);
       int64_t end_n, begin_n = 0;
       while (begin_n < N) {
         end_n = std::min(N, begin_n + parallel_tree_N_);
+        if (HasBatchEngine()) {
+          ComputeLeaves(ttp, num_threads, x_data, stride, begin_n, end_n, leaves.data());
+        }
         concurrency::ThreadPool::TrySimpleParallelFor(
             ttp,
             num_threads,
-            [this, &agg, &scores, num_threads, x_data, N, begin_n, end_n, stride](ptrdiff_t batch_num) {
+            [this, &agg, &scores, &leaves, num_threads, x_data, N, begin_n, end_n, stride](ptrdiff_t batch_num) {
               auto work = concurrency::ThreadPool::PartitionWork(batch_num, num_threads, onnxruntime::narrow<size_t>(this->n_trees_));
               for (int64_t i = begin_n; i < end_n; ++i) {
                 scores[batch_num * SafeInt<ptrdiff_t>(N) + i] = {0, 0};
@@ -576,7 +626,9 @@ void TreeEnsembleCommon<InputType, ThresholdType, OutputType>::ComputeAgg(concur
               for (auto j = work.start; j < work.end; ++j) {
                 for (int64_t i = begin_n; i < end_n; ++i) {
                   agg.ProcessTreeNodePrediction1(scores[batch_num * SafeInt<ptrdiff_t>(N) + i],
-                                                 *ProcessTreeNodeLeave(roots_[j], x_data + i * stride));
+                                                 HasBatchEngine()
+                                                     ? *leaves[(i - begin_n) * n_trees_ + j]
+                                                     : *ProcessTreeNodeLeave(roots_[j], x_data + i * stride));
                 }
               }
             });
@@ -636,6 +688,27 @@ void TreeEnsembleCommon<InputType, ThresholdType, OutputType>::ComputeAgg(concur
         }
         agg.FinalizeScores(scores[0], z_data, -1, label_data);
       }
+    } else if (HasBatchEngine() &&
+               (N <= parallel_N_ || max_num_threads == 1 || n_trees_ < max_num_threads)) {
+      /* sections C2 and E2 evaluated by batches of rows: 2+ outputs, 2+ rows, parallelization by rows if enough rows */
+      auto num_threads = N <= parallel_N_ || max_num_threads == 1 ? 1 : std::min<int32_t>(max_num_threads, SafeInt<int32_t>(N));
+      concurrency::ThreadPool::TrySimpleParallelFor(
+          ttp,
+          num_threads,
+          [this, &agg, num_threads, x_data, z_data, label_data, N, stride](ptrdiff_t batch_num) {
+            InlinedVector<ScoreValue<ThresholdType>> scores(onnxruntime::narrow<size_t>(n_targets_or_classes_));
+            auto work = concurrency::ThreadPool::PartitionWork(batch_num, num_threads, onnxruntime::narrow<ptrdiff_t>(N));
+            ProcessRowsLeaves(
+                x_data, stride, work.start, work.end,
+                [this, &agg, &scores, z_data, label_data](int64_t i, const TreeNodeElement<ThresholdType>* const* leaves) {
+                  std::fill(scores.begin(), scores.end(), ScoreValue<ThresholdType>({0, 0}));
+                  for (size_t j = 0; j < static_cast<size_t>(n_trees_); ++j) {
+                    agg.ProcessTreeNodePrediction(scores, *leaves[j], weights_);
+                  }
+                  agg.FinalizeScores(scores, z_data + i * n_targets_or_classes_, -1,
+                                     label_data == nullptr ? nullptr : (label_data + i));
+                });
+          });
     } else if (N <= parallel_N_ || max_num_threads == 1) { /* section C2: 2+ outputs, 2+ rows, not enough rows to parallelize */
       std::vector<InlinedVector<ScoreValue<ThresholdType>>> scores(parallel_tree_N_);
       size_t j, limit;
@@ -663,13 +736,18 @@ void TreeEnsembleCommon<InputType, ThresholdType, OutputType>::ComputeAgg(concur
     } else if (n_trees_ >= max_num_threads) { /* section: D2: 2+ outputs, 2+ rows, enough trees to parallelize*/
       auto num_threads = std::min<int32_t>(max_num_threads, SafeInt<int32_t>(n_trees_));
       std::vector<InlinedVector<ScoreValue<ThresholdType>>> scores(SafeInt<size_t>(num_threads) * N);
+      std::vector<const TreeNodeElement<ThresholdType>*> leaves(
+          HasBatchEngine() ? SafeInt<size_t>(parallel_tree_N_) * n_trees_ : 0);
       int64_t end_n, begin_n = 0;
       while (begin_n < N) {
         end_n = std::min(N, begin_n + parallel_tree_N_);
+        if (HasBatchEngine()) {
+          ComputeLeaves(ttp, num_threads, x_data, stride, begin_n, end_n, leaves.data());
+        }
         concurrency::ThreadPool::TrySimpleParallelFor(
             ttp,
             num_threads,
-            [this, &agg, &scores, num_threads, x_data, N, stride, begin_n, end_n](ptrdiff_t batch_num) {
+            [this, &agg, &scores, &leaves, num_threads, x_data, N, stride, begin_n, end_n](ptrdiff_t batch_num) {
               auto work = concurrency::ThreadPool::PartitionWork(batch_num, num_threads, onnxruntime::narrow<size_t>(this->n_trees_));
               for (int64_t i = begin_n; i < end_n; ++i) {
                 scores[batch_num * SafeInt<ptrdiff_t>(N) + i].resize(onnxruntime::narrow<size_t>(n_targets_or_classes_), {0, 0});
@@ -677,7 +755,10 @@ void TreeEnsembleCommon<InputType, ThresholdType, OutputType>::ComputeAgg(concur
               for (auto j = work.start; j < work.end; ++j) {
                 for (int64_t i = begin_n; i < end_n; ++i) {
                   agg.ProcessTreeNodePrediction(scores[batch_num * SafeInt<ptrdiff_t>(N) + i],
-                                                *ProcessTreeNodeLeave(roots_[j], x_data + i * stride), weights_);
+                                                HasBatchEngine()
+                                                    ? *leaves[(i - begin_n) * n_trees_ + j]
+                                                    : *ProcessTreeNodeLeave(roots_[j], x_data + i * stride),
+                                                weights_);
                 }
               }
             });
@@ -721,6 +802,48 @@ void TreeEnsembleCommon<InputType, ThresholdType, OutputType>::ComputeAgg(concur
   }
 }  // namespace detail
 
+template <typename InputType, typename ThresholdType, typename OutputType>
+void TreeEnsembleCommon<InputType, ThresholdType, OutputType>::ComputeLeaves(
+    const InputType* x_data, int64_t stride, int64_t n_rows, const TreeNodeElement<ThresholdType>** leaves) const {
+  if (quick_scorer_ != nullptr) {
+    quick_scorer_->ComputeLeaves(x_data, stride, n_rows, leaves);
+  } else {
+    compact_trees_->ComputeLeaves(x_data, stride, n_rows, leaves);
+  }
+}
+
+// Computes the leaves reached by the rows [begin, end) in every tree, the rows being split among num_threads threads.
+template <typename InputType, typename ThresholdType, typename OutputType>
+void TreeEnsembleCommon<InputType, ThresholdType, OutputType>::ComputeLeaves(
+    concurrency::ThreadPool* ttp, int32_t num_threads, const InputType* x_data, int64_t stride, int64_t begin,
+    int64_t end, const TreeNodeElement<ThresholdType>** leaves) const {
+  concurrency::ThreadPool::TrySimpleParallelFor(
+      ttp,
+      num_threads,
+      [this, num_threads, x_data, stride, begin, end, leaves](ptrdiff_t batch_num) {
+        auto work = concurrency::ThreadPool::PartitionWork(batch_num, num_threads, onnxruntime::narrow<ptrdiff_t>(end - begin));
+        ComputeLeaves(x_data + (begin + work.start) * stride, stride, work.end - work.start,
+                      leaves + work.start * n_trees_);
+      });
+}
+
+// Evaluates the rows [begin, end) by batches and calls fn(i, leaves) for every row i,
+// leaves[j] being the leaf reached in tree j.
+template <typename InputType, typename ThresholdType, typename OutputType>
+template <typename FN>
+void TreeEnsembleCommon<InputType, ThresholdType, OutputType>::ProcessRowsLeaves(
+    const InputType* x_data, int64_t stride, int64_t begin, int64_t end, FN&& fn) const {
+  const int64_t batch_size = parallel_tree_N_;
+  std::vector<const TreeNodeElement<ThresholdType>*> leaves(SafeInt<size_t>(batch_size) * n_trees_);
+  for (int64_t batch = begin; batch < end; batch += batch_size) {
+    int64_t batch_end = std::min(end, batch + batch_size);
+    ComputeLeaves(x_data + batch * stride, stride, batch_end - batch, leaves.data());
+    for (int64_t i = batch; i < batch_end; ++i) {
+      fn(i, leaves.data() + (i - batch) * n_trees_);
+    }
+  }
+}
+
 #define TREE_FIND_VALUE(CMP)                                                                           \
   if (has_missing_tracks_) {                                                                           \
     while (root->is_not_leaf()) {                                                                      \
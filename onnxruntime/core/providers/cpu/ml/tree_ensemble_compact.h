@@ -0,0 +1,307 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "tree_ensemble_aggregator.h"
+#include "tree_ensemble_attribute.h"
+
+namespace onnxruntime {
+namespace ml {
+namespace detail {
+
+/**
+ * Compact layout of the trees of an ensemble, evaluated on binned rows.
+ *
+ * The thresholds of every feature are sorted and deduplicated once, and a value x is replaced by its bin,
+ * 2 * (number of thresholds < x) + (1 if x is a threshold), so comparing x to the j-th threshold of the feature
+ * is the same as comparing its bin to 2 * j + 1. The rows of a batch are binned once and the trees are then
+ * evaluated on 16-bit integers.
+ *
+ * A node takes 8 bytes instead of the 24 bytes of TreeNodeElement: the index of the feature among the features
+ * used by the trees, the bin of the threshold and the index of its children, the false child followed by the true
+ * child, or of its leaf, along with the flags of the node. The nodes of a tree are laid out breadth first in
+ * blocks of kBlockDepth levels so that the first levels of a path share a few cache lines, and more trees stay
+ * cache resident on large ensembles.
+ *
+ * Every tree is evaluated on all the rows of the batch before the next one, several rows at a time to interleave
+ * their independent paths. It is used when every node has one of the modes BRANCH_LEQ, BRANCH_LT, BRANCH_GTE and
+ * BRANCH_GT, a feature has less than 32766 distinct thresholds and there are at least as many trees as features.
+ */
+template <typename InputType, typename ThresholdType>
+class TreeEnsembleCompact {
+ public:
+  static constexpr int kBlockDepth = 3;
+  static constexpr int64_t kRowBlock = 8;
+
+  // Returns nullptr if the trees cannot be evaluated on binned rows or if it is not worth it.
+  static std::unique_ptr<TreeEnsembleCompact> Create(gsl::span<TreeNodeElement<ThresholdType>* const> roots);
+
+  // Computes the leaves reached by the rows in every tree, leaves[i * n_trees + j] for row i and tree j.
+  void ComputeLeaves(const InputType* x_data, int64_t stride, int64_t n_rows,
+                     const TreeNodeElement<ThresholdType>** leaves) const;
+
+ private:
+  static constexpr uint16_t kMissingBin = 0xFFFF;
+  static constexpr size_t kMaxThresholdsPerFeature = (kMissingBin - 2) / 2;
+  static constexpr uint32_t kIndexMask = (uint32_t{1} << 28) - 1;
+  static constexpr uint32_t kLeaf = uint32_t{1} << 28;
+  static constexpr uint32_t kMissingTrackTrue = uint32_t{1} << 29;
+  static constexpr uint32_t kInverted = uint32_t{1} << 30;
+
+  // A node is true if (bin <= threshold) != inverted, or if the value is missing and the node tracks it as true.
+  struct Node {
+    uint16_t feature;
+    uint16_t threshold;
+    uint32_t index_and_flags;
+  };
+
+  bool AddTree(const TreeNodeElement<ThresholdType>* root,
+               const std::unordered_map<int64_t, uint16_t>& feature_indices);
+  bool SetNode(const TreeNodeElement<ThresholdType>* element, size_t pos,
+               const std::unordered_map<int64_t, uint16_t>& feature_indices);
+
+  size_t n_trees_{0};
+  std::vector<Node> nodes_;
+  std::vector<uint32_t> roots_;
+  std::vector<const TreeNodeElement<ThresholdType>*> leaves_;
+
+  // Original index of every feature used by the trees, and its sorted thresholds starting at threshold_offsets_[i].
+  std::vector<int64_t> features_;
+  std::vector<size_t> threshold_offsets_;
+  std::vector<ThresholdType> thresholds_;
+};
+
+template <typename InputType, typename ThresholdType>
+std::unique_ptr<TreeEnsembleCompact<InputType, ThresholdType>>
+TreeEnsembleCompact<InputType, ThresholdType>::Create(gsl::span<TreeNodeElement<ThresholdType>* const> roots) {
+  auto compact = std::make_unique<TreeEnsembleCompact>();
+  compact->n_trees_ = roots.size();
+
+  // Collects the thresholds of every feature.
+  std::vector<std::pair<int64_t, ThresholdType>> thresholds;
+  std::vector<const TreeNodeElement<ThresholdType>*> stack;
+  for (const TreeNodeElement<ThresholdType>* root : roots) {
+    stack.push_back(root);
+    while (!stack.empty()) {
+      const TreeNodeElement<ThresholdType>* node = stack.back();
+      stack.pop_back();
+      if (!node->is_not_leaf()) {
+        continue;
+      }
+      const NODE_MODE_ORT mode = node->mode();
+      if ((mode != NODE_MODE_ORT::BRANCH_LEQ && mode != NODE_MODE_ORT::BRANCH_LT &&
+           mode != NODE_MODE_ORT::BRANCH_GTE && mode != NODE_MODE_ORT::BRANCH_GT) ||
+          _isnan_(node->value_or_unique_weight)) {
+        return nullptr;
+      }
+      thresholds.emplace_back(node->feature_id, node->value_or_unique_weight);
+      stack.push_back(node->truenode_or_weight.ptr);
+      stack.push_back(node + 1);
+    }
+  }
+  if (thresholds.empty()) {
+    return nullptr;
+  }
+
+  std::sort(thresholds.begin(), thresholds.end());
+  thresholds.erase(std::unique(thresholds.begin(), thresholds.end(),
+                               [](const std::pair<int64_t, ThresholdType>& a,
+                                  const std::pair<int64_t, ThresholdType>& b) {
+                                 return a.first == b.first && a.second == b.second;
+                               }),
+                   thresholds.end());
+
+  std::unordered_map<int64_t, uint16_t> feature_indices;
+  for (const auto& [feature, threshold] : thresholds) {
+    if (compact->features_.empty() || compact->features_.back() != feature) {
+      if (compact->features_.size() >= kMissingBin) {
+        return nullptr;
+      }
+      feature_indices[feature] = static_cast<uint16_t>(compact->features_.size());
+      compact->features_.push_back(feature);
+      compact->threshold_offsets_.push_back(compact->thresholds_.size());
+    }
+    if (compact->thresholds_.size() - compact->threshold_offsets_.back() >= kMaxThresholdsPerFeature) {
+      return nullptr;
+    }
+    compact->thresholds_.push_back(threshold);
+  }
+  compact->threshold_offsets_.push_back(compact->thresholds_.size());
+
+  // Binning a row costs a binary search per feature, it is only worth it with enough trees.
+  if (roots.size() < compact->features_.size()) {
+    return nullptr;
+  }
+
+  compact->roots_.reserve(roots.size());
+  for (const TreeNodeElement<ThresholdType>* root : roots) {
+    if (!compact->AddTree(root, feature_indices)) {
+      return nullptr;
+    }
+  }
+  return compact;
+}
+
+// Lays out the nodes of the tree breadth first. A block starts with a pair of siblings, or the root, and holds
+// their descendants up to kBlockDepth levels, the children of its last level start new blocks.
+template <typename InputType, typename ThresholdType>
+bool TreeEnsembleCompact<InputType, ThresholdType>::AddTree(
+    const TreeNodeElement<ThresholdType>* root, const std::unordered_map<int64_t, uint16_t>& feature_indices) {
+  using Element = std::pair<const TreeNodeElement<ThresholdType>*, size_t>;
+
+  roots_.push_back(static_cast<uint32_t>(nodes_.size()));
+  nodes_.emplace_back();
+  std::vector<Element> blocks = {{root, nodes_.size() - 1}};
+  std::vector<Element> level, next_level;
+
+  for (size_t block = 0; block < blocks.size(); ++block) {
+    level.assign(1, blocks[block]);
+    // The block of a pair of siblings starts with both of them.
+    if (block > 0) {
+      level.push_back(blocks[++block]);
+    }
+    for (int depth = 0; depth < kBlockDepth && !level.empty(); ++depth) {
+      next_level.clear();
+      for (const auto& [element, pos] : level) {
+        if (!SetNode(element, pos, feature_indices)) {
+          return false;
+        }
+        if (!element->is_not_leaf()) {
+          continue;
+        }
+        if (nodes_.size() + 2 > kIndexMask) {
+          return false;
+        }
+        const size_t children = nodes_.size();
+        nodes_.resize(children + 2);
+        nodes_[pos].index_and_flags |= static_cast<uint32_t>(children);
+        if (depth + 1 < kBlockDepth) {
+          next_level.emplace_back(element + 1, children);
+          next_level.emplace_back(element->truenode_or_weight.ptr, children + 1);
+        } else {
+          blocks.emplace_back(element + 1, children);
+          blocks.emplace_back(element->truenode_or_weight.ptr, children + 1);
+        }
+      }
+      std::swap(level, next_level);
+    }
+  }
+  return true;
+}
+
+template <typename InputType, typename ThresholdType>
+bool TreeEnsembleCompact<InputType, ThresholdType>::SetNode(
+    const TreeNodeElement<ThresholdType>* element, size_t pos,
+    const std::unordered_map<int64_t, uint16_t>& feature_indices) {
+  Node& node = nodes_[pos];
+  if (!element->is_not_leaf()) {
+    if (leaves_.size() > kIndexMask) {
+      return false;
+    }
+    node = Node{0, 0, kLeaf | static_cast<uint32_t>(leaves_.size())};
+    leaves_.push_back(element);
+    return true;
+  }
+
+  node.feature = feature_indices.at(element->feature_id);
+  const ThresholdType* begin = thresholds_.data() + threshold_offsets_[node.feature];
+  const ThresholdType* end = thresholds_.data() + threshold_offsets_[node.feature + 1];
+  const uint16_t bin = static_cast<uint16_t>(2 * (std::lower_bound(begin, end, element->value_or_unique_weight) -
+                                                  begin) +
+                                             1);
+
+  // x < t <=> bin(x) <= bin(t) - 1, x >= t <=> !(bin(x) <= bin(t) - 1), x > t <=> !(bin(x) <= bin(t)).
+  uint32_t flags = element->is_missing_track_true() ? kMissingTrackTrue : 0;
+  switch (element->mode()) {
+    case NODE_MODE_ORT::BRANCH_LEQ:
+      node.threshold = bin;
+      break;
+    case NODE_MODE_ORT::BRANCH_LT:
+      node.threshold = bin - 1;
+      break;
+    case NODE_MODE_ORT::BRANCH_GTE:
+      node.threshold = bin - 1;
+      flags |= kInverted;
+      break;
+    default:
+      node.threshold = bin;
+      flags |= kInverted;
+      break;
+  }
+  node.index_and_flags = flags;
+  return true;
+}
+
+template <typename InputType, typename ThresholdType>
+void TreeEnsembleCompact<InputType, ThresholdType>::ComputeLeaves(
+    const InputType* x_data, int64_t stride, int64_t n_rows, const TreeNodeElement<ThresholdType>** leaves) const {
+  const size_t n_features = features_.size();
+  std::vector<uint16_t> bins(static_cast<size_t>(n_rows) * n_features);
+
+  // Bins the rows once for all the trees.
+  for (int64_t row = 0; row < n_rows; ++row) {
+    const InputType* x = x_data + row * stride;
+    uint16_t* row_bins = bins.data() + static_cast<size_t>(row) * n_features;
+    for (size_t feature = 0; feature < n_features; ++feature) {
+      const InputType val = x[features_[feature]];
+      if (_isnan_(val)) {
+        row_bins[feature] = kMissingBin;
+        continue;
+      }
+      // Branchless binary search of the number of thresholds lower than the value.
+      const ThresholdType* begin = thresholds_.data() + threshold_offsets_[feature];
+      const ThresholdType* end = thresholds_.data() + threshold_offsets_[feature + 1];
+      const ThresholdType* base = begin;
+      for (size_t n = static_cast<size_t>(end - begin); n > 1;) {
+        const size_t half = n / 2;
+        base = base[half] < val ? base + half : base;
+        n -= half;
+      }
+      const ThresholdType* it = *base < val ? base + 1 : base;
+      row_bins[feature] = static_cast<uint16_t>(2 * (it - begin) + (it != end && *it == val ? 1 : 0));
+    }
+  }
+
+  // Every tree is evaluated on all the rows before the next one so that it stays in cache, kRowBlock rows at a
+  // time to interleave the independent paths of the rows.
+  for (size_t tree = 0; tree < n_trees_; ++tree) {
+    for (int64_t row = 0; row < n_rows; row += kRowBlock) {
+      const int64_t rows = std::min(kRowBlock, n_rows - row);
+      uint32_t positions[kRowBlock];
+      for (int64_t r = 0; r < kRowBlock; ++r) {
+        positions[r] = roots_[tree];
+      }
+      for (bool done = false; !done;) {
+        done = true;
+        for (int64_t r = 0; r < kRowBlock; ++r) {
+          const Node node = nodes_[positions[r]];
+          if (node.index_and_flags & kLeaf) {
+            continue;
+          }
+          // The last row is repeated in a partial block.
+          const uint16_t bin = bins[static_cast<size_t>(row + std::min(r, rows - 1)) * n_features + node.feature];
+          const bool is_true = bin == kMissingBin
+                                   ? (node.index_and_flags & kMissingTrackTrue) != 0
+                                   : (bin <= node.threshold) != ((node.index_and_flags & kInverted) != 0);
+          positions[r] = (node.index_and_flags & kIndexMask) + (is_true ? 1 : 0);
+          done = false;
+        }
+      }
+      for (int64_t r = 0; r < rows; ++r) {
+        leaves[(row + r) * static_cast<int64_t>(n_trees_) + static_cast<int64_t>(tree)] =
+            leaves_[nodes_[positions[r]].index_and_flags & kIndexMask];
+      }
+    }
+  }
+}
+
+}  // namespace detail
+}  // namespace ml
+}  // namespace onnxruntime
@@ -0,0 +1,280 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "tree_ensemble_aggregator.h"
+#include "tree_ensemble_attribute.h"
+
+namespace onnxruntime {
+namespace ml {
+namespace detail {
+
+inline uint32_t CountTrailingZeros(uint64_t value) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+  unsigned long index;
+  _BitScanForward64(&index, value);
+  return static_cast<uint32_t>(index);
+#elif defined(_MSC_VER)
+  unsigned long index;
+  if (_BitScanForward(&index, static_cast<uint32_t>(value))) {
+    return static_cast<uint32_t>(index);
+  }
+  _BitScanForward(&index, static_cast<uint32_t>(value >> 32));
+  return static_cast<uint32_t>(index) + 32;
+#else
+  return static_cast<uint32_t>(__builtin_ctzll(value));
+#endif
+}
+
+/**
+ * QuickScorer evaluation of the trees of an ensemble (Lucchese et al., "QuickScorer: a Fast Algorithm to Rank
+ * Documents with Additive Ensembles of Regression Trees", SIGIR 2015).
+ *
+ * The leaves of every tree are numbered from left to right, the true branch of a node before its false branch,
+ * and a row keeps one bitvector of the candidate leaves per tree. A node whose condition is false for the row
+ * removes the leaves of its true branch from the candidates, and the exit leaf of the tree is the first remaining
+ * candidate. The nodes are grouped by feature and sorted by threshold so that the nodes whose condition is false
+ * for a value are a prefix of the nodes of the feature. That prefix is found with a branchless binary search and
+ * the bitvectors are updated without any comparison, which removes the unpredictable branches of the node walk.
+ *
+ * The engine only computes the exit leaf of each tree, the aggregation of the leaves is left to the caller so the
+ * outputs are the same as with the node by node evaluation. It is used when every tree has at most 64 leaves and
+ * every node has the same comparison mode among BRANCH_LEQ, BRANCH_LT, BRANCH_GTE and BRANCH_GT, the modes
+ * produced by LightGBM and XGBoost converters.
+ */
+template <typename InputType, typename ThresholdType>
+class TreeEnsembleQuickScorer {
+ public:
+  static constexpr size_t kMaxLeaves = 64;
+  // Below this average number of nodes per feature, the binary searches cost more than the node walk.
+  static constexpr size_t kMinNodesPerFeature = 64;
+
+  // Returns nullptr if the trees cannot be evaluated by the engine or if it is not worth it.
+  static std::unique_ptr<TreeEnsembleQuickScorer> Create(gsl::span<TreeNodeElement<ThresholdType>* const> roots);
+
+  // Computes the leaves reached by the rows in every tree, leaves[i * n_trees + j] for row i and tree j.
+  void ComputeLeaves(const InputType* x_data, int64_t stride, int64_t n_rows,
+                     const TreeNodeElement<ThresholdType>** leaves) const;
+
+ private:
+  struct Node {
+    int64_t feature_id;
+    ThresholdType threshold;
+    uint32_t tree;
+    uint64_t mask;
+    bool missing_track_true;
+  };
+
+  bool AddSubtree(const TreeNodeElement<ThresholdType>* node, size_t first_leaf, uint32_t tree,
+                  std::vector<Node>& nodes, std::unordered_set<const TreeNodeElement<ThresholdType>*>& visited);
+
+  template <typename IsTrue>
+  void ComputeLeaves(const InputType* x_data, int64_t stride, int64_t n_rows,
+                     const TreeNodeElement<ThresholdType>** leaves, IsTrue is_true) const;
+
+  NODE_MODE_ORT mode_{NODE_MODE_ORT::LEAF};
+  size_t n_trees_{0};
+
+  // Leaves of every tree from left to right, starting at leaf_offsets_[tree].
+  std::vector<const TreeNodeElement<ThresholdType>*> leaves_;
+  std::vector<size_t> leaf_offsets_;
+
+  // Nodes of the feature features_[i], starting at feature_offsets_[i] and sorted by threshold.
+  std::vector<int64_t> features_;
+  std::vector<size_t> feature_offsets_;
+  std::vector<ThresholdType> thresholds_;
+  std::vector<uint32_t> node_trees_;
+  std::vector<uint64_t> node_masks_;
+  std::vector<uint8_t> node_missing_tracks_true_;
+};
+
+template <typename InputType, typename ThresholdType>
+std::unique_ptr<TreeEnsembleQuickScorer<InputType, ThresholdType>>
+TreeEnsembleQuickScorer<InputType, ThresholdType>::Create(gsl::span<TreeNodeElement<ThresholdType>* const> roots) {
+  auto quick_scorer = std::make_unique<TreeEnsembleQuickScorer>();
+  quick_scorer->n_trees_ = roots.size();
+  quick_scorer->leaf_offsets_.reserve(roots.size());
+
+  std::vector<Node> nodes;
+  std::unordered_set<const TreeNodeElement<ThresholdType>*> visited;
+  for (size_t tree = 0; tree < roots.size(); ++tree) {
+    quick_scorer->leaf_offsets_.push_back(quick_scorer->leaves_.size());
+    visited.clear();
+    if (!quick_scorer->AddSubtree(roots[tree], quick_scorer->leaves_.size(), static_cast<uint32_t>(tree), nodes,
+                                  visited)) {
+      return nullptr;
+    }
+  }
+  if (quick_scorer->mode_ == NODE_MODE_ORT::LEAF) {
+    return nullptr;
+  }
+
+  // The nodes whose condition is false for a value come first.
+  const bool ascending = quick_scorer->mode_ == NODE_MODE_ORT::BRANCH_LEQ ||
+                         quick_scorer->mode_ == NODE_MODE_ORT::BRANCH_LT;
+  std::stable_sort(nodes.begin(), nodes.end(), [ascending](const Node& a, const Node& b) {
+    if (a.feature_id != b.feature_id) {
+      return a.feature_id < b.feature_id;
+    }
+    return ascending ? a.threshold < b.threshold : a.threshold > b.threshold;
+  });
+
+  quick_scorer->thresholds_.reserve(nodes.size());
+  quick_scorer->node_trees_.reserve(nodes.size());
+  quick_scorer->node_masks_.reserve(nodes.size());
+  quick_scorer->node_missing_tracks_true_.reserve(nodes.size());
+  for (const Node& node : nodes) {
+    if (quick_scorer->features_.empty() || quick_scorer->features_.back() != node.feature_id) {
+      quick_scorer->features_.push_back(node.feature_id);
+      quick_scorer->feature_offsets_.push_back(quick_scorer->thresholds_.size());
+    }
+    quick_scorer->thresholds_.push_back(node.threshold);
+    quick_scorer->node_trees_.push_back(node.tree);
+    quick_scorer->node_masks_.push_back(node.mask);
+    quick_scorer->node_missing_tracks_true_.push_back(node.missing_track_true ? 1 : 0);
+  }
+  quick_scorer->feature_offsets_.push_back(quick_scorer->thresholds_.size());
+
+  if (nodes.size() < kMinNodesPerFeature * quick_scorer->features_.size()) {
+    return nullptr;
+  }
+  return quick_scorer;
+}
+
+// Appends the leaves of the subtree to leaves_, the leaves of the true branch first, and the nodes of the subtree
+// to nodes. Returns false if the subtree cannot be evaluated by the engine.
+template <typename InputType, typename ThresholdType>
+bool TreeEnsembleQuickScorer<InputType, ThresholdType>::AddSubtree(
+    const TreeNodeElement<ThresholdType>* node, size_t first_leaf, uint32_t tree, std::vector<Node>& nodes,
+    std::unordered_set<const TreeNodeElement<ThresholdType>*>& visited) {
+  if (!node->is_not_leaf()) {
+    if (leaves_.size() - first_leaf >= kMaxLeaves) {
+      return false;
+    }
+    leaves_.push_back(node);
+    return true;
+  }
+
+  // Subtrees shared by several nodes are not supported.
+  if (!visited.insert(node).second) {
+    return false;
+  }
+
+  const NODE_MODE_ORT mode = node->mode();
+  if (mode_ == NODE_MODE_ORT::LEAF) {
+    if (mode != NODE_MODE_ORT::BRANCH_LEQ && mode != NODE_MODE_ORT::BRANCH_LT &&
+        mode != NODE_MODE_ORT::BRANCH_GTE && mode != NODE_MODE_ORT::BRANCH_GT) {
+      return false;
+    }
+    mode_ = mode;
+  } else if (mode != mode_) {
+    return false;
+  }
+  if (_isnan_(node->value_or_unique_weight)) {
+    return false;
+  }
+
+  const size_t true_begin = leaves_.size();
+  if (!AddSubtree(node->truenode_or_weight.ptr, first_leaf, tree, nodes, visited)) {
+    return false;
+  }
+  const size_t true_end = leaves_.size();
+  if (!AddSubtree(node + 1, first_leaf, tree, nodes, visited)) {
+    return false;
+  }
+
+  // The false branch holds at least one leaf so the true branch holds less than 64 leaves.
+  const uint64_t true_leaves = ((uint64_t{1} << (true_end - true_begin)) - 1) << (true_begin - first_leaf);
+  nodes.push_back(Node{node->feature_id, node->value_or_unique_weight, tree, ~true_leaves,
+                       node->is_missing_track_true()});
+  return true;
+}
+
+template <typename InputType, typename ThresholdType>
+void TreeEnsembleQuickScorer<InputType, ThresholdType>::ComputeLeaves(
+    const InputType* x_data, int64_t stride, int64_t n_rows, const TreeNodeElement<ThresholdType>** leaves) const {
+  switch (mode_) {
+    case NODE_MODE_ORT::BRANCH_LEQ:
+      ComputeLeaves(x_data, stride, n_rows, leaves, [](InputType val, ThresholdType threshold) {
+        return val <= threshold;
+      });
+      break;
+    case NODE_MODE_ORT::BRANCH_LT:
+      ComputeLeaves(x_data, stride, n_rows, leaves, [](InputType val, ThresholdType threshold) {
+        return val < threshold;
+      });
+      break;
+    case NODE_MODE_ORT::BRANCH_GTE:
+      ComputeLeaves(x_data, stride, n_rows, leaves, [](InputType val, ThresholdType threshold) {
+        return val >= threshold;
+      });
+      break;
+    case NODE_MODE_ORT::BRANCH_GT:
+      ComputeLeaves(x_data, stride, n_rows, leaves, [](InputType val, ThresholdType threshold) {
+        return val > threshold;
+      });
+      break;
+    default:
+      ORT_THROW("Unexpected node mode ", static_cast<int>(mode_), " in the QuickScorer evaluation.");
+  }
+}
+
+template <typename InputType, typename ThresholdType>
+template <typename IsTrue>
+void TreeEnsembleQuickScorer<InputType, ThresholdType>::ComputeLeaves(
+    const InputType* x_data, int64_t stride, int64_t n_rows, const TreeNodeElement<ThresholdType>** leaves,
+    IsTrue is_true) const {
+  std::vector<uint64_t> bitvectors(n_trees_);
+
+  for (int64_t row = 0; row < n_rows; ++row, x_data += stride) {
+    std::fill(bitvectors.begin(), bitvectors.end(), ~uint64_t{0});
+
+    for (size_t feature = 0; feature < features_.size(); ++feature) {
+      const size_t begin = feature_offsets_[feature];
+      const size_t end = feature_offsets_[feature + 1];
+      const InputType val = x_data[features_[feature]];
+
+      if (_isnan_(val)) {
+        // A missing value is false for every node but follows the true branch if the node says so.
+        for (size_t j = begin; j < end; ++j) {
+          if (!node_missing_tracks_true_[j]) {
+            bitvectors[node_trees_[j]] &= node_masks_[j];
+          }
+        }
+        continue;
+      }
+
+      // The condition of a node is monotonic in the sorted thresholds, the nodes whose condition is false
+      // are found with a branchless binary search and then remove their leaves without any comparison.
+      const ThresholdType* base = thresholds_.data() + begin;
+      for (size_t n = end - begin; n > 1;) {
+        const size_t half = n / 2;
+        base = is_true(val, base[half]) ? base : base + half;
+        n -= half;
+      }
+      const size_t false_end = static_cast<size_t>(base - thresholds_.data()) + (is_true(val, *base) ? 0 : 1);
+      for (size_t j = begin; j < false_end; ++j) {
+        bitvectors[node_trees_[j]] &= node_masks_[j];
+      }
+    }
+
+    for (size_t tree = 0; tree < n_trees_; ++tree) {
+      leaves[tree] = leaves_[leaf_offsets_[tree] + CountTrailingZeros(bitvectors[tree])];
+    }
+    leaves += n_trees_;
+  }
+}
+
+}  // namespace detail
+}  // namespace ml
+}  // namespace onnxruntime
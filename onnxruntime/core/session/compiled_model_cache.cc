@@ -0,0 +1,231 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#if !defined(ORT_MINIMAL_BUILD)
+
+#include "core/session/compiled_model_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "core/common/cpuid_info.h"
+#include "core/common/safeint.h"
+#include "core/framework/execution_providers.h"
+#include "core/framework/murmurhash3.h"
+#include "core/framework/session_options.h"
+#include "core/framework/tensorprotoutils.h"
+#include "core/graph/model.h"
+#include "core/platform/env.h"
+#include "core/session/onnxruntime_session_options_config_keys.h"
+#include "onnxruntime_config.h"  // for ORT_VERSION
+
+namespace onnxruntime {
+namespace compiled_model_cache {
+
+void CacheKeyBuilder::Add(const void* data, size_t length) {
+  // hash the value and chain it with the current state, so the key depends on the order of the values and on the
+  // boundaries between them
+  uint32_t block[5];
+  MurmurHash3::x86_128(data, length, static_cast<uint32_t>(length), block);
+  block[4] = static_cast<uint32_t>(length >> 16 >> 16);
+
+  uint32_t buffer[9];
+  std::copy(std::begin(state_), std::end(state_), buffer);
+  std::copy(std::begin(block), std::end(block), buffer + 4);
+  MurmurHash3::x86_128(buffer, sizeof(buffer), 0, state_);
+}
+
+Status CacheKeyBuilder::AddFileContent(const PathString& path) {
+  size_t length = 0;
+  ORT_RETURN_IF_ERROR(Env::Default().GetFileLength(path.c_str(), length));
+  if (length == 0) {
+    Add(nullptr, 0);
+    return Status::OK();
+  }
+
+  Env::MappedMemoryPtr mapped_memory;
+  ORT_RETURN_IF_ERROR(Env::Default().MapFileIntoMemory(path.c_str(), 0, length, mapped_memory));
+  Add(mapped_memory.get(), length);
+  return Status::OK();
+}
+
+std::string CacheKeyBuilder::Finish() const {
+  std::ostringstream ss;
+  ss << std::hex << std::setfill('0');
+  for (uint32_t word : state_) {
+    ss << std::setw(8) << word;
+  }
+
+  return ss.str();
+}
+
+static Status AddModelContent(CacheKeyBuilder& builder, const Model& model, const PathString& model_location) {
+  const Env& env = Env::Default();
+  size_t model_file_length = 0;
+  if (!model_location.empty() && env.GetFileLength(model_location.c_str(), model_file_length).IsOK()) {
+    ORT_RETURN_IF_ERROR(builder.AddFileContent(model_location));
+  } else {
+    builder.Add(model.ToProto().SerializeAsString());
+  }
+
+  // the data of initializers in external files is not part of the model file, so add it as well.
+  // every file is only added once, regardless of how many initializers refer to it.
+  const Graph& graph = model.MainGraph();
+  const std::filesystem::path model_dir = graph.ModelPath().parent_path();
+  std::vector<std::pair<std::string, PathString>> external_files;
+  for (const auto& [name, tensor_proto] : graph.GetAllInitializedTensors()) {
+    if (!utils::HasExternalData(*tensor_proto)) {
+      continue;
+    }
+
+    PathString external_file_path;
+    FileOffsetType file_offset = 0;
+    SafeInt<size_t> tensor_byte_size = 0;
+    ORT_RETURN_IF_ERROR(utils::GetExternalDataInfo(*tensor_proto, model_dir, external_file_path, file_offset,
+                                                   tensor_byte_size));
+
+    if (utils::HasExternalDataInMemory(*tensor_proto)) {
+      // the offset is the address of the data
+      builder.Add(name);
+      builder.Add(reinterpret_cast<const void*>(file_offset), static_cast<size_t>(tensor_byte_size));
+    } else {
+      external_files.emplace_back(ToUTF8String(external_file_path), std::move(external_file_path));
+    }
+  }
+
+  std::sort(external_files.begin(), external_files.end());
+  external_files.erase(std::unique(external_files.begin(), external_files.end()), external_files.end());
+  for (const auto& [name, path] : external_files) {
+    builder.Add(name);
+    ORT_RETURN_IF_ERROR(builder.AddFileContent(path));
+  }
+
+  return Status::OK();
+}
+
+static void AddSessionOptions(CacheKeyBuilder& builder, const SessionOptions& session_options,
+                              const InlinedHashSet<std::string>& optimizers_to_disable) {
+  builder.Add(static_cast<int64_t>(session_options.graph_optimization_level));
+
+  for (const auto& dim_override : session_options.free_dimension_overrides) {
+    builder.Add(dim_override.dim_identifier);
+    builder.Add(static_cast<int64_t>(dim_override.dim_identifier_type));
+    builder.Add(dim_override.dim_value);
+  }
+
+  // the config entries are stored in a hash map, so sort them to get a stable key.
+  // the cache directory itself does not affect the compiled model.
+  std::vector<std::pair<std::string, std::string>> config_entries;
+  for (const auto& entry : session_options.config_options.GetConfigOptionsMap()) {
+    if (entry.first != kOrtSessionOptionsCompiledModelCacheDir) {
+      config_entries.emplace_back(entry.first, entry.second);
+    }
+  }
+
+  std::sort(config_entries.begin(), config_entries.end());
+  for (const auto& [key, value] : config_entries) {
+    builder.Add(key);
+    builder.Add(value);
+  }
+
+  std::vector<std::string> disabled_optimizers(optimizers_to_disable.begin(), optimizers_to_disable.end());
+  std::sort(disabled_optimizers.begin(), disabled_optimizers.end());
+  for (const auto& optimizer : disabled_optimizers) {
+    builder.Add(optimizer);
+  }
+}
+
+static void AddPlatform(CacheKeyBuilder& builder) {
+  builder.Add(std::string_view{ORT_VERSION});
+
+  // optimizers such as the NchwcTransformer produce graphs that are specific to the instruction set of the CPU
+  const auto& cpuid_info = CPUIDInfo::GetCPUIDInfo();
+  builder.Add(cpuid_info.GetCPUVendor());
+  const bool features[] = {
+      cpuid_info.HasSSE3(),
+      cpuid_info.HasSSE4_1(),
+      cpuid_info.HasAVX(),
+      cpuid_info.HasAVX2(),
+      cpuid_info.HasF16C(),
+      cpuid_info.HasAVX512f(),
+      cpuid_info.HasAVX512Skylake(),
+      cpuid_info.HasAVX512_BF16(),
+      cpuid_info.HasAMX_BF16(),
+      cpuid_info.HasArmNeonDot(),
+      cpuid_info.HasArmNeon_I8MM(),
+      cpuid_info.HasArmSVE_I8MM(),
+      cpuid_info.HasArmNeon_BF16(),
+      cpuid_info.HasFp16VectorAcceleration(),
+  };
+
+  int64_t feature_bits = 0;
+  for (size_t i = 0; i < std::size(features); ++i) {
+    feature_bits |= static_cast<int64_t>(features[i]) << i;
+  }
+
+  builder.Add(feature_bits);
+}
+
+Status ComputeCacheKey(const Model& model, const PathString& model_location, const SessionOptions& session_options,
+                       const InlinedHashSet<std::string>& optimizers_to_disable,
+                       const ExecutionProviders& execution_providers, std::string& key) {
+  CacheKeyBuilder builder;
+  ORT_RETURN_IF_ERROR(AddModelContent(builder, model, model_location));
+  AddSessionOptions(builder, session_options, optimizers_to_disable);
+
+  // the execution providers are in priority order, which affects the partitioning
+  for (const auto& ep_id : execution_providers.GetIds()) {
+    builder.Add(ep_id);
+  }
+
+  AddPlatform(builder);
+
+  key = builder.Finish();
+  return Status::OK();
+}
+
+std::filesystem::path GetCacheEntryPath(const std::filesystem::path& cache_dir, const std::string& key) {
+  return cache_dir / (key + ".ort");
+}
+
+Status SaveCacheEntry(const std::filesystem::path& entry_path,
+                      const std::function<Status(const std::filesystem::path&)>& save) {
+  std::error_code ec;
+  std::filesystem::create_directories(entry_path.parent_path(), ec);
+  ORT_RETURN_IF(ec, "Failed to create the compiled model cache directory ",
+                entry_path.parent_path().string(), ": ", ec.message());
+
+  // make the name of the temporary file unique across the processes and sessions that may populate the same entry
+  static std::atomic<uint64_t> next_temp_file_id{0};
+  std::ostringstream suffix;
+  suffix << ".tmp." << Env::Default().GetSelfPid() << "." << next_temp_file_id++;
+  std::filesystem::path temp_path = entry_path;
+  temp_path += suffix.str();
+
+  Status status = save(temp_path);
+  if (status.IsOK()) {
+    // rename replaces an existing entry atomically
+    std::filesystem::rename(temp_path, entry_path, ec);
+    if (ec) {
+      status = ORT_MAKE_STATUS(ONNXRUNTIME, FAIL, "Failed to rename ", temp_path.string(), " to ",
+                               entry_path.string(), ": ", ec.message());
+    }
+  }
+
+  if (!status.IsOK()) {
+    std::filesystem::remove(temp_path, ec);
+  }
+
+  return status;
+}
+
+}  // namespace compiled_model_cache
+}  // namespace onnxruntime
+
+#endif  // !defined(ORT_MINIMAL_BUILD)
@@ -0,0 +1,72 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#if !defined(ORT_MINIMAL_BUILD)
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+
+#include "core/common/common.h"
+#include "core/common/inlined_containers.h"
+#include "core/common/path_string.h"
+
+namespace onnxruntime {
+class ExecutionProviders;
+class Model;
+struct SessionOptions;
+
+namespace compiled_model_cache {
+
+/// <summary>
+/// Incrementally computes the 128-bit content hash that identifies an entry of the compiled model cache.
+/// </summary>
+class CacheKeyBuilder {
+ public:
+  void Add(const void* data, size_t length);
+
+  void Add(std::string_view value) { Add(value.data(), value.size()); }
+
+  void Add(int64_t value) { Add(&value, sizeof(value)); }
+
+  // Adds the content of the file at `path`. The file is memory mapped rather than read.
+  Status AddFileContent(const PathString& path);
+
+  // Returns the hash as a hex string.
+  std::string Finish() const;
+
+ private:
+  uint32_t state_[4]{};
+};
+
+/// <summary>
+/// Computes the key of the cache entry for `model`.
+///
+/// The key covers everything that affects the optimized and partitioned graph: the content of the model file at
+/// `model_location` (or the serialized model if it was not loaded from a file) and of its external data files,
+/// the session options and config entries, the disabled optimizers, the types of the registered execution
+/// providers, the ORT version and the instruction set extensions of the CPU.
+/// </summary>
+Status ComputeCacheKey(const Model& model, const PathString& model_location, const SessionOptions& session_options,
+                       const InlinedHashSet<std::string>& optimizers_to_disable,
+                       const ExecutionProviders& execution_providers, std::string& key);
+
+// Path of the ORT format model of the cache entry with `key` in `cache_dir`.
+std::filesystem::path GetCacheEntryPath(const std::filesystem::path& cache_dir, const std::string& key);
+
+/// <summary>
+/// Writes a cache entry. `save` writes the model to the path it is given, which is a temporary file in the
+/// directory of `entry_path` that is then renamed to `entry_path`, so concurrent readers never observe a partially
+/// written entry.
+/// </summary>
+Status SaveCacheEntry(const std::filesystem::path& entry_path,
+                      const std::function<Status(const std::filesystem::path&)>& save);
+
+}  // namespace compiled_model_cache
+}  // namespace onnxruntime
+
+#endif  // !defined(ORT_MINIMAL_BUILD)
@@ -0,0 +1,377 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "core/session/dynamic_batcher.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "core/common/narrow.h"
+#include "core/framework/error_code_helper.h"
+#include "core/framework/ort_value.h"
+#include "core/framework/tensor.h"
+#include "core/platform/threadpool.h"
+#include "core/session/inference_session.h"
+
+namespace onnxruntime {
+
+namespace {
+
+// Number of bytes used by each slice along dim 0 of `tensor`, or 0 if the tensor cannot be split along dim 0.
+size_t GetBytesPerRow(const Tensor& tensor) {
+  const auto& shape = tensor.Shape();
+  if (shape.NumDimensions() == 0 || shape[0] <= 0 || tensor.Location().device.Type() != OrtDevice::CPU) {
+    return 0;
+  }
+
+  const size_t rows = narrow<size_t>(shape[0]);
+  const size_t total_bytes = tensor.SizeInBytes();
+  // sub-byte element types can only be split if every row starts on a byte boundary
+  if (total_bytes % rows != 0) {
+    return 0;
+  }
+
+  return total_bytes / rows;
+}
+
+// Copy `num_rows` rows starting at `src_row` of `src` into `dst` starting at `dst_row`.
+void CopyRows(const Tensor& src, size_t src_row, Tensor& dst, size_t dst_row, size_t num_rows) {
+  if (src.IsDataTypeString()) {
+    const size_t row_elements = narrow<size_t>(src.Shape().SizeFromDimension(1));
+    const std::string* src_data = src.Data<std::string>() + src_row * row_elements;
+    std::string* dst_data = dst.MutableData<std::string>() + dst_row * row_elements;
+    std::copy(src_data, src_data + num_rows * row_elements, dst_data);
+  } else {
+    const size_t bytes_per_row = GetBytesPerRow(src);
+    const auto* src_data = static_cast<const uint8_t*>(src.DataRaw()) + src_row * bytes_per_row;
+    auto* dst_data = static_cast<uint8_t*>(dst.MutableDataRaw()) + dst_row * bytes_per_row;
+    memcpy(dst_data, src_data, num_rows * bytes_per_row);
+  }
+}
+
+TensorShape ReplaceBatchDim(const TensorShape& shape, int64_t rows) {
+  TensorShapeVector dims = shape.AsShapeVector();
+  dims[0] = rows;
+  return TensorShape(dims);
+}
+
+bool SameNames(gsl::span<const char* const> a, gsl::span<const char* const> b) {
+  return a.size() == b.size() &&
+         std::equal(a.begin(), a.end(), b.begin(), [](const char* x, const char* y) { return strcmp(x, y) == 0; });
+}
+
+}  // namespace
+
+DynamicBatcher::DynamicBatcher(InferenceSession& session, concurrency::ThreadPool* thread_pool,
+                               AllocatorPtr cpu_allocator, const DynamicBatchingOptions& options,
+                               const logging::Logger& logger)
+    : session_(session),
+      thread_pool_(thread_pool),
+      cpu_allocator_(std::move(cpu_allocator)),
+      options_(options),
+      logger_(logger) {
+  ORT_ENFORCE(options_.max_batch_size > 1, "Dynamic batching requires a max batch size greater than 1.");
+  dispatcher_ = std::thread([this]() { DispatchLoop(); });
+}
+
+DynamicBatcher::~DynamicBatcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutdown_ = true;
+  }
+  queue_cv_.notify_all();
+  dispatcher_.join();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  in_flight_cv_.wait(lock, [this]() { return in_flight_batches_ == 0; });
+}
+
+Status DynamicBatcher::Enqueue(const RunOptions* run_options,
+                               gsl::span<const char* const> feed_names,
+                               gsl::span<const OrtValue* const> feeds,
+                               gsl::span<const char* const> fetch_names,
+                               gsl::span<OrtValue*> fetches,
+                               RunAsyncCallbackFn callback,
+                               void* user_data) {
+  ORT_RETURN_IF(feed_names.size() != feeds.size(), "Number of input names and input values must match.");
+  for (size_t i = 0; i < feeds.size(); ++i) {
+    ORT_RETURN_IF(feed_names[i] == nullptr || feed_names[i][0] == '\0', "input name cannot be empty");
+    ORT_RETURN_IF(feeds[i] == nullptr, "NULL input supplied for input ", feed_names[i]);
+  }
+  for (const char* name : fetch_names) {
+    ORT_RETURN_IF(name == nullptr || name[0] == '\0', "output name cannot be empty");
+  }
+
+  auto request = std::make_unique<Request>(Request{run_options, feed_names, feeds, fetch_names, fetches,
+                                                   callback, user_data, Clock::now(), 0});
+  request->batch_rows = GetBatchRows(*request);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ORT_RETURN_IF(shutdown_, "The session is being destroyed.");
+    queued_rows_ += request->batch_rows;
+    queue_.push_back(std::move(request));
+  }
+
+  queue_cv_.notify_one();
+  return Status::OK();
+}
+
+int64_t DynamicBatcher::GetBatchRows(const Request& request) const {
+  if (request.feeds.empty() ||
+      std::any_of(request.fetches.begin(), request.fetches.end(), [](const OrtValue* v) { return v != nullptr; }) ||
+      std::any_of(request.fetch_names.begin(), request.fetch_names.end(), [this](const char* name) {
+        return options_.batched_outputs.count(name) == 0;
+      })) {
+    return 0;
+  }
+
+  int64_t rows = -1;
+  for (const OrtValue* feed : request.feeds) {
+    if (!feed->IsTensor()) {
+      return 0;
+    }
+
+    const Tensor& tensor = feed->Get<Tensor>();
+    if (GetBytesPerRow(tensor) == 0) {
+      return 0;
+    }
+
+    const int64_t feed_rows = tensor.Shape()[0];
+    if (rows != -1 && feed_rows != rows) {
+      return 0;
+    }
+
+    rows = feed_rows;
+  }
+
+  return rows;
+}
+
+bool DynamicBatcher::CanJoin(const Request& head, const Request& candidate) {
+  if (head.batch_rows == 0 || candidate.batch_rows == 0 ||
+      head.run_options != candidate.run_options ||
+      !SameNames(head.feed_names, candidate.feed_names) ||
+      !SameNames(head.fetch_names, candidate.fetch_names)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < head.feeds.size(); ++i) {
+    const Tensor& a = head.feeds[i]->Get<Tensor>();
+    const Tensor& b = candidate.feeds[i]->Get<Tensor>();
+    if (a.DataType() != b.DataType() ||
+        a.Shape().NumDimensions() != b.Shape().NumDimensions() ||
+        a.Shape().Slice(1) != b.Shape().Slice(1)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void DynamicBatcher::DispatchLoop() {
+  const int64_t max_rows = narrow<int64_t>(options_.max_batch_size);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    queue_cv_.wait(lock, [this]() { return shutdown_ || !queue_.empty(); });
+    if (queue_.empty()) {
+      // shutting down and all queued requests have been dispatched
+      break;
+    }
+
+    // give other requests until the deadline of the oldest one to fill up the batch.
+    // requests that cannot be batched are dispatched immediately.
+    const auto deadline = queue_.front()->enqueue_time + options_.max_queue_delay;
+    queue_cv_.wait_until(lock, deadline, [this, max_rows]() {
+      return shutdown_ || queued_rows_ >= max_rows || queue_.front()->batch_rows == 0;
+    });
+
+    Batch batch = TakeBatchLocked();
+    ++in_flight_batches_;
+
+    lock.unlock();
+    ScheduleBatch(std::move(batch));
+    lock.lock();
+  }
+}
+
+DynamicBatcher::Batch DynamicBatcher::TakeBatchLocked() {
+  const int64_t max_rows = narrow<int64_t>(options_.max_batch_size);
+
+  Batch batch;
+  batch.push_back(std::move(queue_.front()));
+  queue_.pop_front();
+
+  const Request& head = *batch.front();
+  int64_t rows = head.batch_rows;
+
+  for (auto it = queue_.begin(); it != queue_.end() && rows < max_rows;) {
+    if (rows + (*it)->batch_rows <= max_rows && CanJoin(head, **it)) {
+      rows += (*it)->batch_rows;
+      batch.push_back(std::move(*it));
+      it = queue_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  queued_rows_ -= rows;
+  return batch;
+}
+
+void DynamicBatcher::ScheduleBatch(Batch&& batch) {
+  auto shared_batch = std::make_shared<Batch>(std::move(batch));
+  concurrency::ThreadPool::Schedule(thread_pool_, [this, shared_batch]() {
+    ExecuteBatch(*shared_batch);
+
+    // notify while holding the lock as the destructor may destroy the condition variable as soon as it observes 0
+    std::lock_guard<std::mutex> lock(mutex_);
+    --in_flight_batches_;
+    in_flight_cv_.notify_all();
+  });
+}
+
+void DynamicBatcher::RunSingle(Request& request) {
+  Status status;
+  ORT_TRY {
+    if (request.run_options) {
+      status = session_.Run(*request.run_options, request.feed_names, request.feeds, request.fetch_names,
+                            request.fetches);
+    } else {
+      RunOptions default_run_options;
+      status = session_.Run(default_run_options, request.feed_names, request.feeds, request.fetch_names,
+                            request.fetches);
+    }
+  }
+  ORT_CATCH(const std::exception& ex) {
+    ORT_HANDLE_EXCEPTION([&]() {
+      status = ORT_MAKE_STATUS(ONNXRUNTIME, RUNTIME_EXCEPTION, ex.what());
+    });
+  }
+  ORT_CATCH(...) {
+    status = ORT_MAKE_STATUS(ONNXRUNTIME, RUNTIME_EXCEPTION, "unknown exception");
+  }
+
+  request.callback(request.user_data, request.fetches.data(), status.IsOK() ? request.fetches.size() : 0,
+                   ToOrtStatus(status));
+}
+
+Status DynamicBatcher::RunBatched(Batch& batch, std::vector<std::vector<OrtValue>>& per_request_fetches) {
+  const Request& head = *batch.front();
+  const size_t num_feeds = head.feeds.size();
+  const size_t num_fetches = head.fetch_names.size();
+
+  int64_t total_rows = 0;
+  for (const auto& request : batch) {
+    total_rows += request->batch_rows;
+  }
+
+  // concatenate the inputs along dim 0
+  InlinedVector<std::string> feed_names;
+  InlinedVector<OrtValue> feeds;
+  feed_names.reserve(num_feeds);
+  feeds.reserve(num_feeds);
+  for (size_t i = 0; i < num_feeds; ++i) {
+    const Tensor& head_tensor = head.feeds[i]->Get<Tensor>();
+    OrtValue batched;
+    Tensor::InitOrtValue(head_tensor.DataType(), ReplaceBatchDim(head_tensor.Shape(), total_rows), cpu_allocator_,
+                         batched);
+    Tensor& batched_tensor = *batched.GetMutable<Tensor>();
+
+    size_t row = 0;
+    for (const auto& request : batch) {
+      const Tensor& src = request->feeds[i]->Get<Tensor>();
+      const size_t src_rows = narrow<size_t>(request->batch_rows);
+      CopyRows(src, 0, batched_tensor, row, src_rows);
+      row += src_rows;
+    }
+
+    feed_names.emplace_back(head.feed_names[i]);
+    feeds.push_back(std::move(batched));
+  }
+
+  InlinedVector<std::string> fetch_names;
+  fetch_names.reserve(num_fetches);
+  for (const char* name : head.fetch_names) {
+    fetch_names.emplace_back(name);
+  }
+
+  std::vector<OrtValue> fetches;
+  if (head.run_options) {
+    ORT_RETURN_IF_ERROR(session_.Run(*head.run_options, feed_names, feeds, fetch_names, &fetches));
+  } else {
+    RunOptions default_run_options;
+    ORT_RETURN_IF_ERROR(session_.Run(default_run_options, feed_names, feeds, fetch_names, &fetches));
+  }
+
+  // the fetched outputs are declared with the batch dimension, so a model that does not produce it is in error
+  for (size_t o = 0; o < fetches.size(); ++o) {
+    ORT_RETURN_IF_NOT(fetches[o].IsTensor(), "Output '", fetch_names[o], "' of a batched run is not a tensor.");
+
+    const Tensor& tensor = fetches[o].Get<Tensor>();
+    ORT_RETURN_IF(GetBytesPerRow(tensor) == 0 || tensor.Shape()[0] != total_rows,
+                  "Output '", fetch_names[o], "' of a batched run has the shape ", tensor.Shape(),
+                  ", which does not have the batch size ", total_rows, " in dim 0.");
+  }
+
+  per_request_fetches.resize(batch.size());
+  for (size_t o = 0; o < fetches.size(); ++o) {
+    const Tensor& batched_tensor = fetches[o].Get<Tensor>();
+    size_t row = 0;
+    for (size_t r = 0; r < batch.size(); ++r) {
+      const int64_t rows = batch[r]->batch_rows;
+      OrtValue slice;
+      Tensor::InitOrtValue(batched_tensor.DataType(), ReplaceBatchDim(batched_tensor.Shape(), rows), cpu_allocator_,
+                           slice);
+      CopyRows(batched_tensor, row, *slice.GetMutable<Tensor>(), 0, narrow<size_t>(rows));
+      row += narrow<size_t>(rows);
+      per_request_fetches[r].push_back(std::move(slice));
+    }
+  }
+
+  return Status::OK();
+}
+
+void DynamicBatcher::ExecuteBatch(Batch& batch) {
+  if (batch.size() == 1) {
+    RunSingle(*batch.front());
+    return;
+  }
+
+  LOGS(logger_, VERBOSE) << "Running " << batch.size() << " requests as one batch.";
+
+  std::vector<std::vector<OrtValue>> per_request_fetches;
+  Status status;
+  ORT_TRY {
+    status = RunBatched(batch, per_request_fetches);
+  }
+  ORT_CATCH(const std::exception& ex) {
+    ORT_HANDLE_EXCEPTION([&]() {
+      status = ORT_MAKE_STATUS(ONNXRUNTIME, RUNTIME_EXCEPTION, ex.what());
+    });
+  }
+  ORT_CATCH(...) {
+    status = ORT_MAKE_STATUS(ONNXRUNTIME, RUNTIME_EXCEPTION, "unknown exception");
+  }
+
+  if (status.IsOK()) {
+    num_batched_runs_.fetch_add(1, std::memory_order_relaxed);
+    num_batched_requests_.fetch_add(batch.size(), std::memory_order_relaxed);
+  }
+
+  for (size_t r = 0; r < batch.size(); ++r) {
+    Request& request = *batch[r];
+    if (status.IsOK()) {
+      auto& outputs = per_request_fetches[r];
+      for (size_t o = 0; o < outputs.size(); ++o) {
+        request.fetches[o] = std::make_unique<OrtValue>(std::move(outputs[o])).release();
+      }
+    }
+
+    request.callback(request.user_data, request.fetches.data(), status.IsOK() ? request.fetches.size() : 0,
+                     ToOrtStatus(status));
+  }
+}
+
+}  // namespace onnxruntime
@@ -0,0 +1,134 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/common/common.h"
+#include "core/common/inlined_containers.h"
+#include "core/common/logging/logging.h"
+#include "core/framework/allocator.h"
+#include "core/framework/run_options.h"
+#include "core/session/onnxruntime_c_api.h"
+
+struct OrtValue;
+
+namespace onnxruntime {
+class InferenceSession;
+namespace concurrency {
+class ThreadPool;
+}
+
+/// <summary>
+/// Policy for the dynamic batching front end of InferenceSession::RunAsync.
+/// </summary>
+struct DynamicBatchingOptions {
+  // Maximum number of rows along the batch dimension (dim 0) combined into a single Run.
+  // Values below 2 disable batching.
+  size_t max_batch_size = 0;
+
+  // Maximum time the oldest queued request waits for more requests to join its batch.
+  std::chrono::microseconds max_queue_delay{0};
+
+  // Names of the model outputs whose dim 0 is the batch dimension of the inputs.
+  // Only requests that fetch nothing but these outputs are batched.
+  InlinedHashSet<std::string> batched_outputs;
+};
+
+/// <summary>
+/// Collects concurrent RunAsync requests and executes compatible ones as a single batched Run.
+///
+/// Requests are compatible when they use the same RunOptions instance, the same input and output names,
+/// provide CPU tensor inputs whose shapes only differ in dim 0, and do not provide pre-allocated outputs.
+/// The inputs of compatible requests are concatenated along dim 0, the session is run once, and every output
+/// is split along dim 0 back into per-request tensors that are handed to each request's callback.
+/// Requests that cannot be batched, e.g. because they fetch an output that does not have the batch dimension
+/// in DynamicBatchingOptions::batched_outputs, are run one by one.
+/// </summary>
+class DynamicBatcher {
+ public:
+  DynamicBatcher(InferenceSession& session, concurrency::ThreadPool* thread_pool, AllocatorPtr cpu_allocator,
+                 const DynamicBatchingOptions& options, const logging::Logger& logger);
+
+  // Flushes all queued requests and waits for all in-flight batches to complete.
+  ~DynamicBatcher();
+
+  ORT_DISALLOW_COPY_ASSIGNMENT_AND_MOVE(DynamicBatcher);
+
+  /// <summary>
+  /// Queue a request. The arguments have the same semantics and lifetime requirements as
+  /// InferenceSession::RunAsync: they must stay valid until `callback` is invoked.
+  /// </summary>
+  Status Enqueue(const RunOptions* run_options,
+                 gsl::span<const char* const> feed_names,
+                 gsl::span<const OrtValue* const> feeds,
+                 gsl::span<const char* const> fetch_names,
+                 gsl::span<OrtValue*> fetches,
+                 RunAsyncCallbackFn callback,
+                 void* user_data);
+
+  // Number of runs that combined several requests, and the number of requests they completed.
+  uint64_t NumBatchedRuns() const { return num_batched_runs_.load(std::memory_order_relaxed); }
+  uint64_t NumBatchedRequests() const { return num_batched_requests_.load(std::memory_order_relaxed); }
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Request {
+    const RunOptions* run_options;
+    gsl::span<const char* const> feed_names;
+    gsl::span<const OrtValue* const> feeds;
+    gsl::span<const char* const> fetch_names;
+    gsl::span<OrtValue*> fetches;
+    RunAsyncCallbackFn callback;
+    void* user_data;
+    Clock::time_point enqueue_time;
+    // number of rows along dim 0. 0 if the request can only be run on its own.
+    int64_t batch_rows;
+  };
+
+  using Batch = std::vector<std::unique_ptr<Request>>;
+
+  void DispatchLoop();
+
+  // Remove the request at the front of the queue plus any compatible requests that fit in the batch.
+  Batch TakeBatchLocked();
+
+  void ScheduleBatch(Batch&& batch);
+  void ExecuteBatch(Batch& batch);
+  void RunSingle(Request& request);
+  Status RunBatched(Batch& batch, std::vector<std::vector<OrtValue>>& per_request_fetches);
+
+  static bool CanJoin(const Request& head, const Request& candidate);
+  int64_t GetBatchRows(const Request& request) const;
+
+  InferenceSession& session_;
+  concurrency::ThreadPool* thread_pool_;
+  AllocatorPtr cpu_allocator_;
+  const DynamicBatchingOptions options_;
+  const logging::Logger& logger_;
+
+  std::mutex mutex_;
+  std::condition_variable queue_cv_;
+  std::condition_variable in_flight_cv_;
+  std::deque<std::unique_ptr<Request>> queue_;  // GUARDED_BY(mutex_)
+  int64_t queued_rows_ = 0;                     // GUARDED_BY(mutex_)
+  size_t in_flight_batches_ = 0;                // GUARDED_BY(mutex_)
+  bool shutdown_ = false;                       // GUARDED_BY(mutex_)
+
+  std::atomic<uint64_t> num_batched_runs_{0};
+  std::atomic<uint64_t> num_batched_requests_{0};
+
+  std::thread dispatcher_;
+};
+
+}  // namespace onnxruntime
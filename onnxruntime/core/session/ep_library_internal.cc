@@ -53,7 +53,7 @@ std::unique_ptr<EpLibraryInternal> EpLibraryInternal::CreateCpuEp() {
                                    "CPU EP factory currently only supports one device at a time.");
     }
 
-    CPUExecutionProviderInfo epi{session_options->value.enable_cpu_mem_arena};
+    auto epi = CPUExecutionProviderInfo::FromSessionOptions(session_options->value);
     *ep = std::make_unique<CPUExecutionProvider>(epi);
     (*ep)->SetLogger(session_logger->ToInternal());
 
@@ -4,6 +4,7 @@
 #include "core/graph/onnx_protobuf.h"
 #include "core/session/inference_session.h"
 
+#include <algorithm>
 #include <memory>
 #include <sstream>
 #include <list>
@@ -14,6 +15,7 @@
 #include "core/common/denormal.h"
 #include "core/common/logging/isink.h"
 #include "core/common/logging/logging.h"
+#include "core/common/narrow.h"
 #include "core/common/parse_string.h"
 #include "core/common/path_string.h"
 #include "core/common/string_utils.h"
@@ -68,6 +70,7 @@
 #include "core/providers/dml/DmlExecutionProvider/src/ExecutionProvider.h"
 #include "core/optimizer/stft_decomposition.h"
 #endif
+#include "core/session/compiled_model_cache.h"
 #include "core/session/environment.h"
 #include "core/session/IOBinding.h"
 #include "core/session/inference_session_utils.h"
@@ -342,6 +345,18 @@ logging::Severity GetSeverity(const SessionOptions& session_options) {
   return severity;
 }
 
+// Parses the NUMA node the intra op thread pool is restricted to. -1 when it is not set.
+static Status ParseIntraOpNumaNode(const SessionOptions& session_options, int& numa_node) {
+  const std::string numa_node_str =
+      session_options.config_options.GetConfigOrDefault(kOrtSessionOptionsConfigIntraOpNumaNode, "-1");
+  if (!TryParseStringWithClassicLocale<int>(numa_node_str, numa_node)) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT, "Invalid value for ",
+                           kOrtSessionOptionsConfigIntraOpNumaNode, ": ", numa_node_str);
+  }
+
+  return Status::OK();
+}
+
 void InferenceSession::SetLoggingManager(const SessionOptions& session_options,
                                          const Environment& session_env) {
   logging_manager_ = session_env.GetLoggingManager();
@@ -444,6 +459,8 @@ void InferenceSession::ConstructorCommon(const SessionOptions& session_options,
         to.allow_spinning = allow_intra_op_spinning;
         to.dynamic_block_base_ = std::stoi(session_options_.config_options.GetConfigOrDefault(kOrtSessionOptionsConfigDynamicBlockBase, "0"));
         LOGS(*session_logger_, INFO) << "Dynamic block base set to " << to.dynamic_block_base_;
+        to.adaptive_spin_budget_us = std::stoi(session_options_.config_options.GetConfigOrDefault(
+            kOrtSessionOptionsConfigIntraOpAdaptiveSpinBudgetUs, "0"));
 
         // Set custom threading functions
         to.custom_create_thread_fn = session_options_.custom_create_thread_fn;
@@ -455,6 +472,10 @@ void InferenceSession::ConstructorCommon(const SessionOptions& session_options,
         to.auto_set_affinity = to.thread_pool_size == 0 &&
                                session_options_.execution_mode == ExecutionMode::ORT_SEQUENTIAL &&
                                to.affinity_str.empty();
+        ORT_THROW_IF_ERROR(ParseIntraOpNumaNode(session_options_, to.numa_node));
+        to.numa_aware = to.numa_node >= 0 ||
+                        session_options_.config_options.GetConfigOrDefault(kOrtSessionOptionsConfigIntraOpNumaAware,
+                                                                           "0") == "1";
 
         if (to.custom_create_thread_fn) {
           ORT_ENFORCE(to.custom_join_thread_fn, "custom join thread function not set for intra op thread pool");
@@ -730,6 +751,9 @@ InferenceSession::InferenceSession(const SessionOptions& session_options, const
 #endif  // !defined(ORT_MINIMAL_BUILD)
 
 InferenceSession::~InferenceSession() {
+  // complete any queued or in-flight batched requests while the session is still fully alive
+  dynamic_batcher_.reset();
+
   if (session_options_.enable_profiling) {
     ORT_TRY {
       EndProfiling();
@@ -962,6 +986,78 @@ common::Status InferenceSession::SaveToOrtFormat(const std::filesystem::path& fi
   return Status::OK();
 }
 
+Status InferenceSession::LoadFromCompiledModelCache(std::filesystem::path& cache_entry_path) {
+  const std::string cache_dir = session_options_.config_options.GetConfigOrDefault(
+      kOrtSessionOptionsCompiledModelCacheDir, "");
+  if (cache_dir.empty() || !ort_format_model_bytes_.empty()) {
+    // not enabled, or the model is an ORT format model already
+    return Status::OK();
+  }
+
+  // user provided initializers and saving the optimized model are handled by the regular initialization only.
+  // graph capture requires checks of the partitioning that are only done for ONNX models.
+  const bool is_supported =
+      session_options_.optimized_model_filepath.empty() &&
+      session_options_.external_initializers.empty() &&
+      session_options_.external_initializer_files_mmap.empty() &&
+      std::none_of(execution_providers_.begin(), execution_providers_.end(),
+                   [](const auto& ep) { return ep->IsGraphCaptureEnabled(); });
+  if (!is_supported) {
+    LOGS(*session_logger_, INFO) << "The compiled model cache is not supported with the session configuration.";
+    return Status::OK();
+  }
+
+  std::string key;
+  ORT_RETURN_IF_ERROR(compiled_model_cache::ComputeCacheKey(*model_, model_location_, session_options_,
+                                                            optimizers_to_disable_, execution_providers_, key));
+  cache_entry_path = compiled_model_cache::GetCacheEntryPath(ToPathString(cache_dir), key);
+
+  const Env& env = Env::Default();
+  size_t num_bytes = 0;
+  if (!env.GetFileLength(cache_entry_path.native().c_str(), num_bytes).IsOK() || num_bytes == 0) {
+    LOGS(*session_logger_, INFO) << "Compiled model cache miss: " << cache_entry_path.string();
+    return Status::OK();
+  }
+
+  // a cache entry that can not be loaded is replaced rather than failing the session creation
+  Status status = env.MapFileIntoMemory(cache_entry_path.native().c_str(), 0, num_bytes, mapped_ort_format_model_);
+  if (status.IsOK()) {
+    ort_format_model_bytes_ = gsl::span<const uint8_t>(reinterpret_cast<const uint8_t*>(
+                                                           mapped_ort_format_model_.get()),
+                                                       num_bytes);
+    status = LoadOrtModelFromBytes();
+  }
+
+  if (!status.IsOK()) {
+    LOGS(*session_logger_, WARNING) << "Failed to load the compiled model cache entry " << cache_entry_path.string()
+                                    << ". It will be recreated. Error: " << status.ErrorMessage();
+    ort_format_model_bytes_ = gsl::span<const uint8_t>();
+    mapped_ort_format_model_.reset();
+    using_ort_model_bytes_for_initializers_ = false;
+    return Status::OK();
+  }
+
+  LOGS(*session_logger_, INFO) << "Compiled model cache hit: " << cache_entry_path.string();
+  cache_entry_path.clear();
+  return Status::OK();
+}
+
+void InferenceSession::SaveToCompiledModelCache(const std::filesystem::path& cache_entry_path) const {
+  // the cache is an optimization, so failing to populate it does not fail the session creation
+  if (session_state_->GetFuncMgr().NumFuncs() > 0) {
+    LOGS(*session_logger_, WARNING)
+        << "The model is not saved to the compiled model cache as it contains compiled nodes.";
+    return;
+  }
+
+  Status status = compiled_model_cache::SaveCacheEntry(
+      cache_entry_path, [this](const std::filesystem::path& path) { return SaveToOrtFormat(path); });
+  if (!status.IsOK()) {
+    LOGS(*session_logger_, WARNING) << "Failed to save the model to the compiled model cache: "
+                                    << status.ErrorMessage();
+  }
+}
+
 common::Status InferenceSession::LoadWithLoader(std::function<common::Status(std::shared_ptr<Model>&)> loader,
                                                 const std::string& event_name) {
   Status status = Status::OK();
@@ -1547,6 +1643,20 @@ Status InferenceSession::LoadOrtModel(const PathString& model_uri) {
   return LoadOrtModelWithLoader(
       [&]() {
         model_location_ = model_uri;
+        const auto& config_options = GetSessionOptions().config_options;
+        if (config_options.GetConfigOrDefault(kOrtSessionOptionsConfigMapModelFiles, "0") == "1") {
+          // map the file rather than reading it. the initializers then refer to the mapped bytes, so the pages of the
+          // weights are only loaded when they are used and are shared with other sessions that map the same file.
+          size_t num_bytes = 0;
+          ORT_RETURN_IF_ERROR(Env::Default().GetFileLength(model_location_.c_str(), num_bytes));
+          ORT_RETURN_IF(num_bytes == 0, "Load model from ", ToUTF8String(model_location_), " failed. File is empty.");
+          ORT_RETURN_IF_ERROR(Env::Default().MapFileIntoMemory(model_location_.c_str(), 0, num_bytes,
+                                                               mapped_ort_format_model_));
+          ort_format_model_bytes_ = gsl::span<const uint8_t>(
+              reinterpret_cast<const uint8_t*>(mapped_ort_format_model_.get()), num_bytes);
+          return Status::OK();
+        }
+
         ORT_RETURN_IF_ERROR(
             LoadOrtModelBytes(model_location_, ort_format_model_bytes_, ort_format_model_bytes_data_holder_));
         return Status::OK();
@@ -1590,7 +1700,14 @@ Status InferenceSession::LoadOrtModelWithLoader(std::function<Status()> load_ort
   }
 
   ORT_RETURN_IF_ERROR(load_ort_format_model_bytes());
+  ORT_RETURN_IF_ERROR(LoadOrtModelFromBytes());
+
+  is_model_loaded_ = true;
+
+  return Status::OK();
+}
 
+Status InferenceSession::LoadOrtModelFromBytes() {
   // Verify the ort_format_model_bytes_ is a valid InferenceSessionBuffer before we access the data
   flatbuffers::Verifier verifier(ort_format_model_bytes_.data(), ort_format_model_bytes_.size());
   ORT_RETURN_IF_NOT(fbs::VerifyInferenceSessionBuffer(verifier), "ORT model verification failed.");
@@ -1654,11 +1771,13 @@ Status InferenceSession::LoadOrtModelWithLoader(std::function<Status()> load_ort
   // provided an existing buffer of bytes when creating the InferenceSession, ort_format_model_bytes_data_holder_
   // will be empty.
   // if that is the case we also allow creating initializers that directly use those bytes.
+  // a memory mapped model file is owned by the session, so its bytes are always used.
   const auto& config_options = session_options_.config_options;
   using_ort_model_bytes_for_initializers_ =
       load_options.can_use_flatbuffer_for_initializers =
           ort_format_model_bytes_data_holder_.empty() &&
-          config_options.GetConfigOrDefault(kOrtSessionOptionsConfigUseORTModelBytesForInitializers, "0") == "1";
+          (mapped_ort_format_model_ != nullptr ||
+           config_options.GetConfigOrDefault(kOrtSessionOptionsConfigUseORTModelBytesForInitializers, "0") == "1");
 
   // need to go from unique_ptr to shared_ptr when moving into model_
   std::unique_ptr<Model> tmp_model;
@@ -1670,9 +1789,6 @@ Status InferenceSession::LoadOrtModelWithLoader(std::function<Status()> load_ort
   ORT_RETURN_IF_ERROR(Model::LoadFromOrtFormat(*fbs_model, load_options, *session_logger_, tmp_model));
 #endif
 
-  ORT_RETURN_IF_ERROR(SaveModelMetadata(*tmp_model));
-  model_ = std::move(tmp_model);
-
   KernelTypeStrResolver kernel_type_str_resolver{};
   if (const auto* fbs_kernel_type_str_resolver = fbs_session->kernel_type_str_resolver();
       fbs_kernel_type_str_resolver != nullptr) {
@@ -1681,7 +1797,7 @@ Status InferenceSession::LoadOrtModelWithLoader(std::function<Status()> load_ort
 #if !defined(ORT_MINIMAL_BUILD)
     // insert the kernel type constraints if we're updating an old model that had kernel hashes.
     if (is_supported_with_update) {
-      ORT_RETURN_IF_ERROR(kernel_type_str_resolver.RegisterGraphNodeOpSchemas(model_->MainGraph()));
+      ORT_RETURN_IF_ERROR(kernel_type_str_resolver.RegisterGraphNodeOpSchemas(tmp_model->MainGraph()));
     }
 #endif
   }
@@ -1691,9 +1807,11 @@ Status InferenceSession::LoadOrtModelWithLoader(std::function<Status()> load_ort
       kernel_type_str_resolver_utils::AddLayoutTransformationRequiredOpsToKernelTypeStrResolver(
           kernel_type_str_resolver));
 #endif  // !defined(ORT_MINIMAL_BUILD) || defined(ORT_EXTENDED_MINIMAL_BUILD)
-  kernel_registry_manager_.SetKernelTypeStrResolver(std::move(kernel_type_str_resolver));
 
-  is_model_loaded_ = true;
+  // only replace the model once everything was loaded successfully
+  ORT_RETURN_IF_ERROR(SaveModelMetadata(*tmp_model));
+  model_ = std::move(tmp_model);
+  kernel_registry_manager_.SetKernelTypeStrResolver(std::move(kernel_type_str_resolver));
 
   return Status::OK();
 }
@@ -1970,6 +2088,50 @@ Status ApplyOrtFormatModelRuntimeOptimizations(
 #endif  // !defined(ORT_MINIMAL_BUILD) || defined(ORT_EXTENDED_MINIMAL_BUILD)
 }  // namespace
 
+// The NUMA nodes the intra op thread pool runs on, or an empty list if it is not NUMA aware.
+static Status GetIntraOpNumaNodes(const SessionOptions& session_options, std::vector<int>& numa_nodes) {
+  numa_nodes.clear();
+  int numa_node = -1;
+  ORT_RETURN_IF_ERROR(ParseIntraOpNumaNode(session_options, numa_node));
+  if (numa_node >= 0) {
+    numa_nodes.push_back(numa_node);
+    return Status::OK();
+  }
+
+  if (session_options.config_options.GetConfigOrDefault(kOrtSessionOptionsConfigIntraOpNumaAware, "0") == "1") {
+    for (int node : Env::Default().GetNumaNodeOfLogicalProcessors()) {
+      if (node >= 0 && std::find(numa_nodes.begin(), numa_nodes.end(), node) == numa_nodes.end()) {
+        numa_nodes.push_back(node);
+      }
+    }
+  }
+
+  // a single node is left to the default policy, which already places the memory on it
+  if (numa_nodes.size() < 2) {
+    numa_nodes.clear();
+  }
+
+  return Status::OK();
+}
+
+// Sets the NUMA memory policy of the calling thread while it is alive, and restores the default policy afterwards.
+class ScopedNumaMemoryPolicy {
+ public:
+  explicit ScopedNumaMemoryPolicy(gsl::span<const int> numa_nodes)
+      : is_set_(!numa_nodes.empty() && Env::Default().SetCurrentThreadNumaMemoryPolicy(numa_nodes)) {}
+
+  ~ScopedNumaMemoryPolicy() {
+    if (is_set_) {
+      Env::Default().SetCurrentThreadNumaMemoryPolicy({});
+    }
+  }
+
+  ORT_DISALLOW_COPY_ASSIGNMENT_AND_MOVE(ScopedNumaMemoryPolicy);
+
+ private:
+  const bool is_set_;
+};
+
 static void ResolveMemoryPatternFlags(SessionState& session_state) {
   session_state.ResolveMemoryPatternFlag();
 
@@ -2037,10 +2199,8 @@ common::Status InferenceSession::Initialize() {
     }
 
     // Verify that there are no external initializers in the graph if external data is disabled.
-    onnxruntime::Graph& graph = model_->MainGraph();
-
 #ifdef DISABLE_EXTERNAL_INITIALIZERS
-    const InitializedTensorSet& initializers = graph.GetAllInitializedTensors();
+    const InitializedTensorSet& initializers = model_->MainGraph().GetAllInitializedTensors();
     for (const auto& it : initializers) {
       if (utils::HasExternalData(*it.second) && !utils::HasExternalDataInMemory(*it.second)) {
         return common::Status(common::ONNXRUNTIME, common::FAIL,
@@ -2053,7 +2213,7 @@ common::Status InferenceSession::Initialize() {
     // RegisterExecutionProvider locks the session_mutex_ so we can't be holding it when we call that
     if (!have_cpu_ep) {
       LOGS(*session_logger_, INFO) << "Adding default CPU execution provider.";
-      CPUExecutionProviderInfo epi{session_options_.enable_cpu_mem_arena};
+      auto epi = CPUExecutionProviderInfo::FromSessionOptions(session_options_);
       auto p_cpu_exec_provider = std::make_unique<CPUExecutionProvider>(epi);
       ORT_RETURN_IF_ERROR_SESSIONID_(RegisterExecutionProvider(std::move(p_cpu_exec_provider)));
       execution_providers_.SetCpuProviderWasImplicitlyAdded(true);
@@ -2067,6 +2227,15 @@ common::Status InferenceSession::Initialize() {
     // re-acquire mutex
     std::lock_guard<std::mutex> l(session_mutex_);
 
+    // this may replace model_ with the cached ORT format model, so it must happen before accessing the graph.
+    // if the returned path is not empty the compiled model should be saved to it.
+    std::filesystem::path compiled_model_cache_entry_path;
+#if !defined(ORT_MINIMAL_BUILD)
+    ORT_RETURN_IF_ERROR_SESSIONID_(LoadFromCompiledModelCache(compiled_model_cache_entry_path));
+#endif
+
+    onnxruntime::Graph& graph = model_->MainGraph();
+
 #if !defined(DISABLE_EXTERNAL_INITIALIZERS) && !defined(ORT_MINIMAL_BUILD)
     if (!session_options_.external_initializers.empty()) {
       ORT_RETURN_IF_ERROR_SESSIONID_(graph.InjectExternalInitializedTensors(session_options_.external_initializers));
@@ -2115,6 +2284,13 @@ common::Status InferenceSession::Initialize() {
     }
 #endif
 
+    SharedPrepackedWeightsStore* shared_prepacked_weights_store = nullptr;
+    if (session_options_.config_options.GetConfigOrDefault(kOrtSessionOptionsConfigUseEnvPrepackedWeights, "0") ==
+        "1") {
+      LOGS(*session_logger_, INFO) << "This session will share its pre-packed weights with the environment.";
+      shared_prepacked_weights_store = &environment_.GetSharedPrepackedWeightsStore();
+    }
+
     // now that we have all the execution providers, create the session state
     session_state_ = std::make_unique<SessionState>(
         model_->MainGraph(),
@@ -2126,7 +2302,9 @@ common::Status InferenceSession::Initialize() {
         *session_logger_,
         session_profiler_,
         session_options_,
-        prepacked_weights_container_);
+        prepacked_weights_container_,
+        nullptr,  // parent_allocators
+        shared_prepacked_weights_store);
 
     bool use_env_allocators =
         session_options_.config_options.GetConfigOrDefault(kOrtSessionOptionsConfigUseEnvAllocators, "0") == "1";
@@ -2427,11 +2605,17 @@ common::Status InferenceSession::Initialize() {
 #endif  // !defined(ORT_MINIMAL_BUILD) || defined(ORT_EXTENDED_MINIMAL_BUILD)
     }
 
-    ORT_RETURN_IF_ERROR_SESSIONID_(
-        session_state_->FinalizeSessionState(model_location_, kernel_registry_manager_,
-                                             // need to keep the initializers if saving the optimized model
-                                             !saving_model,
-                                             saving_ort_format));
+    {
+      // place the initializers and prepacked weights, which are written here, on the nodes of the intra op threads
+      std::vector<int> numa_nodes;
+      ORT_RETURN_IF_ERROR_SESSIONID_(GetIntraOpNumaNodes(session_options_, numa_nodes));
+      ScopedNumaMemoryPolicy numa_memory_policy(numa_nodes);
+      ORT_RETURN_IF_ERROR_SESSIONID_(
+          session_state_->FinalizeSessionState(model_location_, kernel_registry_manager_,
+                                               // need to keep the initializers if saving the optimized model
+                                               !saving_model && compiled_model_cache_entry_path.empty(),
+                                               saving_ort_format || !compiled_model_cache_entry_path.empty()));
+    }
 
 #if !defined(ORT_MINIMAL_BUILD)
     if (saving_model) {
@@ -2473,6 +2657,10 @@ common::Status InferenceSession::Initialize() {
       }
     }
 
+    if (!compiled_model_cache_entry_path.empty()) {
+      SaveToCompiledModelCache(compiled_model_cache_entry_path);
+    }
+
     std::vector<TuningResults> tuning_results;
     bool found_tuning_results = false;
     ORT_RETURN_IF_ERROR_SESSIONID_(inference_session_utils::ParseTuningResultsFromModelMetadata(
@@ -2485,11 +2673,14 @@ common::Status InferenceSession::Initialize() {
     // Resolve memory pattern flags of the main graph and subgraph session states
     ResolveMemoryPatternFlags(*session_state_);
 
+    InitializeDynamicBatching();
+
     is_inited_ = true;
 
     if (!using_ort_model_bytes_for_initializers_) {
       ort_format_model_bytes_ = gsl::span<const uint8_t>();
       std::vector<uint8_t>().swap(ort_format_model_bytes_data_holder_);
+      mapped_ort_format_model_.reset();
     }
 
     // once the model is saved, we may remove unnecessary attributes for inference
@@ -3070,6 +3261,14 @@ Status InferenceSession::Run(const RunOptions& run_options,
     }
   }
 
+  if (retval.IsOK() && session_state_ != nullptr) {
+    if (auto* metrics = session_state_->GetMetrics(); metrics != nullptr) {
+      const auto run_duration = std::chrono::high_resolution_clock::now() - tp;
+      metrics->RecordRunLatency(static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(run_duration).count()));
+    }
+  }
+
   // keep track of telemetry
   int64_t batch_size = 1;
   for (const auto& feed : feeds) {
@@ -3229,6 +3428,9 @@ common::Status InferenceSession::RunAsync(const RunOptions* run_options,
   if (!tp || concurrency::ThreadPool::DegreeOfParallelism(tp) < 2) {
     return ORT_MAKE_STATUS(ONNXRUNTIME, INVALID_ARGUMENT, "intra op thread pool must have at least one thread for RunAsync");
   }
+  if (dynamic_batcher_) {
+    return dynamic_batcher_->Enqueue(run_options, feed_names, feeds, fetch_names, fetches, callback, user_data);
+  }
   std::function<void()> run_fn = [run_options, feed_names, feeds, fetch_names, fetches, num_fetches,
                                   callback, user_data, this]() {
     Status status = Status::OK();
@@ -3254,6 +3456,60 @@ common::Status InferenceSession::RunAsync(const RunOptions* run_options,
   return Status::OK();
 }
 
+void InferenceSession::InitializeDynamicBatching() {
+  const int64_t max_batch_size = ParseStringWithClassicLocale<int64_t>(
+      session_options_.config_options.GetConfigOrDefault(kOrtSessionOptionsDynamicBatchingMaxBatchSize, "0"));
+  if (max_batch_size < 2) {
+    return;
+  }
+
+  auto* tp = GetIntraOpThreadPoolToUse();
+  if (!tp || concurrency::ThreadPool::DegreeOfParallelism(tp) < 2) {
+    LOGS(*session_logger_, WARNING) << "Dynamic batching is disabled as it requires an intra op thread pool "
+                                    << "with at least one thread.";
+    return;
+  }
+
+  // every input must have the same symbolic first dimension so that requests can be concatenated along it
+  std::string batch_dim_param;
+  for (const NodeArg* input : model_->MainGraph().GetInputs()) {
+    const auto* shape = input->Shape();
+    if (shape == nullptr || shape->dim_size() == 0 || !utils::HasDimParam(shape->dim(0)) ||
+        (!batch_dim_param.empty() && shape->dim(0).dim_param() != batch_dim_param)) {
+      LOGS(*session_logger_, WARNING) << "Dynamic batching is disabled as the first dimension of input '"
+                                      << input->Name() << "' is not the symbolic batch dimension.";
+      return;
+    }
+    batch_dim_param = shape->dim(0).dim_param();
+  }
+
+  // only the tensor outputs with the same first dimension can be split back to the requests
+  DynamicBatchingOptions options;
+  for (const NodeArg* output : model_->MainGraph().GetOutputs()) {
+    const auto* type = output->TypeAsProto();
+    const auto* shape = output->Shape();
+    if (type != nullptr && utils::HasTensorType(*type) && shape != nullptr && shape->dim_size() > 0 &&
+        utils::HasDimParam(shape->dim(0)) && shape->dim(0).dim_param() == batch_dim_param) {
+      options.batched_outputs.insert(output->Name());
+    }
+  }
+
+  if (options.batched_outputs.empty()) {
+    LOGS(*session_logger_, WARNING) << "Dynamic batching is disabled as no output has the batch dimension '"
+                                    << batch_dim_param << "' as its first dimension.";
+    return;
+  }
+
+  options.max_batch_size = narrow<size_t>(max_batch_size);
+  options.max_queue_delay = std::chrono::microseconds(ParseStringWithClassicLocale<int64_t>(
+      session_options_.config_options.GetConfigOrDefault(kOrtSessionOptionsDynamicBatchingMaxQueueDelayUs, "1000")));
+
+  dynamic_batcher_ = std::make_unique<DynamicBatcher>(*this, tp, session_state_->GetAllocator(OrtDevice()),
+                                                      options, *session_logger_);
+  LOGS(*session_logger_, INFO) << "Dynamic batching enabled with max batch size " << options.max_batch_size
+                               << " and max queue delay " << options.max_queue_delay.count() << "us.";
+}
+
 common::Status InferenceSession::Run(const NameMLValMap& feeds, gsl::span<const std::string> output_names,
                                      std::vector<OrtValue>* p_fetches) {
   return Run(RunOptions(), feeds, output_names, p_fetches);
@@ -3385,6 +3641,102 @@ std::string InferenceSession::EndProfiling() {
   return std::string();
 }
 
+static void AddLatencyMetrics(const std::string& prefix, const LatencyHistogram& latency,
+                              std::vector<std::pair<std::string, std::string>>& snapshot) {
+  const auto latency_snapshot = latency.GetSnapshot();
+  snapshot.emplace_back(prefix + ".count", std::to_string(latency_snapshot.count));
+  snapshot.emplace_back(prefix + ".sum_ns", std::to_string(latency_snapshot.sum_ns));
+  snapshot.emplace_back(prefix + ".p50_ns", std::to_string(latency_snapshot.Percentile(0.5)));
+  snapshot.emplace_back(prefix + ".p90_ns", std::to_string(latency_snapshot.Percentile(0.9)));
+  snapshot.emplace_back(prefix + ".p99_ns", std::to_string(latency_snapshot.Percentile(0.99)));
+}
+
+static std::string GetNodeNameForMetrics(const Node& node) {
+  return node.Name().empty() ? MakeString(node.OpType(), "_", node.Index()) : node.Name();
+}
+
+// adds the node latencies of `session_state` and its subgraphs, and sums up their allocations
+static void AddSessionStateMetrics(const SessionState& session_state, const std::string& graph_prefix,
+                                   std::vector<std::pair<std::string, std::string>>& snapshot,
+                                   uint64_t& num_memory_pattern_allocations, uint64_t& num_dynamic_allocations,
+                                   uint64_t& dynamic_allocation_bytes) {
+  const SessionMetrics* metrics = session_state.GetMetrics();
+  if (metrics == nullptr) {
+    return;
+  }
+
+  const GraphViewer& graph_viewer = session_state.GetGraphViewer();
+  for (const auto& node : graph_viewer.Nodes()) {
+    const LatencyHistogram* latency = metrics->GetNodeLatency(node.Index());
+    if (latency != nullptr) {
+      const std::string prefix = "node." + graph_prefix + GetNodeNameForMetrics(node);
+      snapshot.emplace_back(prefix + ".op_type", node.OpType());
+      AddLatencyMetrics(prefix + ".latency", *latency, snapshot);
+    }
+  }
+
+  num_memory_pattern_allocations += metrics->GetNumMemoryPatternAllocations();
+  num_dynamic_allocations += metrics->GetNumDynamicAllocations();
+  dynamic_allocation_bytes += metrics->GetDynamicAllocationBytes();
+
+  for (const auto& [node_index, subgraph_session_states] : session_state.GetSubgraphSessionStateMap()) {
+    const Node* node = graph_viewer.GetNode(node_index);
+    const std::string node_prefix = graph_prefix + (node != nullptr ? GetNodeNameForMetrics(*node) : "") + "/";
+    for (const auto& [attribute_name, subgraph_session_state] : subgraph_session_states) {
+      AddSessionStateMetrics(*subgraph_session_state, node_prefix + attribute_name + "/", snapshot,
+                             num_memory_pattern_allocations, num_dynamic_allocations, dynamic_allocation_bytes);
+    }
+  }
+}
+
+common::Status InferenceSession::GetMetricsSnapshot(std::vector<std::pair<std::string, std::string>>& snapshot) const {
+  if (!is_inited_) {
+    LOGS(*session_logger_, ERROR) << "Session was not initialized";
+    return common::Status(common::ONNXRUNTIME, common::FAIL, "Session not initialized.");
+  }
+
+  const SessionMetrics* metrics = session_state_->GetMetrics();
+  if (metrics == nullptr) {
+    return ORT_MAKE_STATUS(ONNXRUNTIME, FAIL, "Metrics are not enabled for the session. Set the session config entry ",
+                           kOrtSessionOptionsEnableMetrics, " to 1 to enable them.");
+  }
+
+  snapshot.clear();
+  AddLatencyMetrics("run.latency", metrics->GetRunLatency(), snapshot);
+
+  uint64_t num_memory_pattern_allocations = 0;
+  uint64_t num_dynamic_allocations = 0;
+  uint64_t dynamic_allocation_bytes = 0;
+  AddSessionStateMetrics(*session_state_, "", snapshot,
+                         num_memory_pattern_allocations, num_dynamic_allocations, dynamic_allocation_bytes);
+  snapshot.emplace_back("frame.memory_pattern_allocations", std::to_string(num_memory_pattern_allocations));
+  snapshot.emplace_back("frame.dynamic_allocations", std::to_string(num_dynamic_allocations));
+  snapshot.emplace_back("frame.dynamic_allocation_bytes", std::to_string(dynamic_allocation_bytes));
+
+  snapshot.emplace_back("thread_pool.intra_op.queue_depth",
+                        std::to_string(concurrency::ThreadPool::QueueDepth(GetIntraOpThreadPoolToUse())));
+  snapshot.emplace_back("thread_pool.inter_op.queue_depth",
+                        std::to_string(concurrency::ThreadPool::QueueDepth(GetInterOpThreadPoolToUse())));
+
+  if (dynamic_batcher_) {
+    snapshot.emplace_back("dynamic_batching.batched_runs", std::to_string(dynamic_batcher_->NumBatchedRuns()));
+    snapshot.emplace_back("dynamic_batching.batched_requests",
+                          std::to_string(dynamic_batcher_->NumBatchedRequests()));
+  }
+
+  for (const auto& [device, allocator] : session_state_->GetAllocators()) {
+    AllocatorStats stats;
+    allocator->GetStats(&stats);
+    const std::string prefix = MakeString("allocator.", allocator->Info().name, ":", device.Id());
+    snapshot.emplace_back(prefix + ".num_allocs", std::to_string(stats.num_allocs));
+    snapshot.emplace_back(prefix + ".bytes_in_use", std::to_string(stats.bytes_in_use));
+    snapshot.emplace_back(prefix + ".max_bytes_in_use", std::to_string(stats.max_bytes_in_use));
+    snapshot.emplace_back(prefix + ".total_allocated_bytes", std::to_string(stats.total_allocated_bytes));
+  }
+
+  return Status::OK();
+}
+
 const profiling::Profiler& InferenceSession::GetProfiling() const {
   return session_profiler_;
 }
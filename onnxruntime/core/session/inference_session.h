@@ -30,6 +30,8 @@
 #include "core/optimizer/graph_transformer_level.h"
 #include "core/optimizer/graph_transformer_mgr.h"
 #include "core/optimizer/insert_cast_transformer.h"
+#include "core/platform/env.h"
+#include "core/session/dynamic_batcher.h"
 #include <mutex>
 #ifdef ENABLE_LANGUAGE_INTEROP_OPS
 #include "core/language_interop_ops/language_interop_ops.h"
@@ -528,6 +530,15 @@ class InferenceSession {
     */
   const profiling::Profiler& GetProfiling() const;
 
+  /**
+    * Get a snapshot of the metrics of the session. They must be enabled with "session.enable_metrics".
+    * The snapshot covers the latencies of the runs and of every node, including the nodes of subgraphs, the tensor
+    * allocations of the execution frames, the queue depth of the thread pools and the statistics of the allocators.
+    * @param snapshot The metrics as pairs of name and value.
+    * @return OK if success.
+    */
+  common::Status GetMetricsSnapshot(std::vector<std::pair<std::string, std::string>>& snapshot) const;
+
 #if !defined(ORT_MINIMAL_BUILD)
   /**
    * Get the TuningResults of TunableOp for every execution providers.
@@ -660,6 +671,9 @@ class InferenceSession {
 
   bool IsInitialized() const;
 
+  // Create dynamic_batcher_ if dynamic batching is enabled in the session options and the model supports it.
+  void InitializeDynamicBatching();
+
   // Use these 2 threadpool methods to get access to the threadpools since they rely on
   // specific flags in session options
   // These methods assume that session options have been finalized before the call.
@@ -735,6 +749,16 @@ class InferenceSession {
   }
 
   common::Status SaveToOrtFormat(const std::filesystem::path& filepath) const;
+
+  /**
+   * Replace the loaded ONNX model with the entry of the compiled model cache for it, if
+   * kOrtSessionOptionsCompiledModelCacheDir is set and the entry exists.
+   * @param cache_entry_path Set to the path of the entry if the compiled model should be saved to the cache once the
+   *                         session is initialized.
+   */
+  [[nodiscard]] common::Status LoadFromCompiledModelCache(std::filesystem::path& cache_entry_path);
+
+  void SaveToCompiledModelCache(const std::filesystem::path& cache_entry_path) const;
 #endif
 
   /**
@@ -756,6 +780,9 @@ class InferenceSession {
 
   [[nodiscard]] common::Status LoadOrtModelWithLoader(std::function<Status()> load_ort_format_model_bytes);
 
+  // Create model_ from ort_format_model_bytes_. model_ is left unchanged on failure.
+  [[nodiscard]] common::Status LoadOrtModelFromBytes();
+
   // Create a Logger for a single execution if possible. Otherwise use the default logger.
   // If a new logger is created, it will also be stored in new_run_logger,
   // which must remain valid for the duration of the execution.
@@ -974,6 +1001,11 @@ class InferenceSession {
 
   bool using_ort_model_bytes_for_initializers_{false};
 
+  // Memory mapped ORT format model, loaded from the compiled model cache or from a file with
+  // "session.map_model_files" set. ort_format_model_bytes_ refers to it and the initializers use its bytes directly,
+  // so it is kept for the lifetime of the session.
+  Env::MappedMemoryPtr mapped_ort_format_model_;
+
   // Container to store pre-packed weights to share between sessions.
   // The life-cycle of the cache itself is maintained by the user and the user will ensure
   // the cache is valid until any session reliant on it is still in scope.
@@ -1026,6 +1058,10 @@ class InferenceSession {
   // Enable nodestats collection
   std::optional<NodeStatsRecorder> node_stats_recorder_;
 #endif
+
+  // Batches concurrent RunAsync requests if "session.dynamic_batching.max_batch_size" is set.
+  // Declared last so it is destroyed, and its in-flight batches are completed, before anything it uses.
+  std::unique_ptr<DynamicBatcher> dynamic_batcher_;
 };
 
 struct SessionIOBinding {
@@ -22,6 +22,7 @@
 #include "core/framework/execution_provider.h"
 #include "core/framework/onnxruntime_typeinfo.h"
 #include "core/framework/ort_value.h"
+#include "core/framework/string_tensor_view.h"
 #include "core/framework/tensor.h"
 #include "core/framework/tensor_type_and_shape.h"
 #include "core/framework/tensorprotoutils.h"
@@ -1113,6 +1114,28 @@ ORT_API_STATUS_IMPL(OrtApis::FillStringTensor, _Inout_ OrtValue* value, _In_ con
   API_IMPL_END
 }
 
+ORT_API_STATUS_IMPL(OrtApis::FillStringTensorFromContent, _Inout_ OrtValue* value,
+                    _In_ const void* s, size_t s_len,
+                    _In_reads_(offsets_len) const size_t* offsets, size_t offsets_len) {
+  TENSOR_READWRITE_API_BEGIN
+  auto* dst = tensor->MutableData<std::string>();
+  const auto len = static_cast<size_t>(tensor->Shape().Size());
+  if (offsets_len != len) {
+    return OrtApis::CreateStatus(ORT_INVALID_ARGUMENT, "offsets array doesn't equal tensor size");
+  }
+
+  // every offset is checked before the first string is written so an invalid one leaves the tensor unchanged
+  StringTensorView content;
+  ORT_API_RETURN_IF_STATUS_NOT_OK(StringTensorView::Create(gsl::make_span(static_cast<const char*>(s), s_len),
+                                                           gsl::make_span(offsets, offsets_len), content));
+  for (size_t i = 0; i != len; ++i) {
+    // copies the bytes in place, strings short enough for the small string optimization do not allocate
+    dst[i] = content[i];
+  }
+  return nullptr;
+  API_IMPL_END
+}
+
 ORT_API_STATUS_IMPL(OrtApis::FillStringTensorElement, _Inout_ OrtValue* value, _In_ const char* s, size_t index) {
   TENSOR_READWRITE_API_BEGIN
   auto* dst = tensor->MutableData<std::string>();
@@ -2236,6 +2259,22 @@ ORT_API_STATUS_IMPL(OrtApis::SessionGetProfilingStartTimeNs, _In_ const OrtSessi
   API_IMPL_END
 }
 
+ORT_API_STATUS_IMPL(OrtApis::SessionGetMetrics, _In_ const OrtSession* sess, _Outptr_ OrtKeyValuePairs** out) {
+  API_IMPL_BEGIN
+  const auto* session = reinterpret_cast<const ::onnxruntime::InferenceSession*>(sess);
+  std::vector<std::pair<std::string, std::string>> snapshot;
+  ORT_API_RETURN_IF_STATUS_NOT_OK(session->GetMetricsSnapshot(snapshot));
+
+  auto kvps = std::make_unique<OrtKeyValuePairs>();
+  for (auto& [key, value] : snapshot) {
+    kvps->Add(std::move(key), std::move(value));
+  }
+
+  *out = reinterpret_cast<OrtKeyValuePairs*>(kvps.release());
+  return nullptr;
+  API_IMPL_END
+}
+
 // End support for non-tensor types
 
 ORT_API_STATUS_IMPL(OrtApis::CreateArenaCfg, _In_ size_t max_mem, int arena_extend_strategy, int initial_chunk_size_bytes,
@@ -3764,6 +3803,9 @@ static constexpr OrtApi ort_api_1_to_23 = {
     &OrtApis::GetTensorData,
 
     &OrtApis::GetSessionOptionsConfigEntries,
+
+    &OrtApis::SessionGetMetrics,
+    &OrtApis::FillStringTensorFromContent,
 };
 
 // OrtApiBase can never change as there is no way to know what version of OrtApiBase is returned by OrtGetApiBase.
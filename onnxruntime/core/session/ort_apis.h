@@ -700,4 +700,9 @@ ORT_API_STATUS_IMPL(ReleaseSharedAllocator, _In_ OrtEnv* env, _In_ const OrtEpDe
 ORT_API_STATUS_IMPL(GetTensorData, _In_ const OrtValue* value, _Outptr_ const void** out);
 
 ORT_API_STATUS_IMPL(GetSessionOptionsConfigEntries, _In_ const OrtSessionOptions* options, _Outptr_ OrtKeyValuePairs** out);
+
+ORT_API_STATUS_IMPL(SessionGetMetrics, _In_ const OrtSession* session, _Outptr_ OrtKeyValuePairs** out);
+
+ORT_API_STATUS_IMPL(FillStringTensorFromContent, _Inout_ OrtValue* value, _In_ const void* s,
+                    size_t s_len, _In_reads_(offsets_len) const size_t* offsets, size_t offsets_len);
 }  // namespace OrtApis
@@ -4,6 +4,7 @@
 #include "core/util/thread_utils.h"
 
 #include <algorithm>
+#include <map>
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -20,8 +21,11 @@ std::ostream& operator<<(std::ostream& os, const OrtThreadPoolParams& params) {
   os << " auto_set_affinity: " << params.auto_set_affinity;
   os << " allow_spinning: " << params.allow_spinning;
   os << " dynamic_block_base_: " << params.dynamic_block_base_;
+  os << " adaptive_spin_budget_us: " << params.adaptive_spin_budget_us;
   os << " stack_size: " << params.stack_size;
   os << " affinity_str: " << params.affinity_str;
+  os << " numa_aware: " << params.numa_aware;
+  os << " numa_node: " << params.numa_node;
   // os << " name: " << (params.name ? params.name : L"nullptr");
   os << " set_denormal_as_zero: " << params.set_denormal_as_zero;
   // os << " custom_create_thread_fn: " << (params.custom_create_thread_fn ? "set" : "nullptr");
@@ -89,10 +93,91 @@ static std::vector<LogicalProcessors> ReadThreadAffinityConfig(const std::string
 }
 #endif
 
+#if !defined(ORT_MINIMAL_BUILD) && !defined(ORT_EXTENDED_MINIMAL_BUILD)
+// Bind the threads to the physical cores grouped by NUMA node. The cores of every node are adjacent, so the
+// consecutive threads that the thread pool gives the consecutive parts of a parallel loop share a node.
+// If thread_pool_size is smaller than the number of cores, the threads are spread evenly over the nodes.
+// As with auto_set_affinity, the first core is left to the main thread.
+// Returns false if the NUMA topology is not available.
+static bool SetNumaThreadAffinities(OrtThreadPoolParams& options, ThreadOptions& to) {
+  const auto node_of_processor = Env::Default().GetNumaNodeOfLogicalProcessors();
+  if (node_of_processor.empty()) {
+    return false;
+  }
+
+  ORT_ENFORCE(options.numa_node < 0 || std::find(node_of_processor.begin(), node_of_processor.end(),
+                                                  options.numa_node) != node_of_processor.end(),
+              "NUMA node ", options.numa_node, " does not have any processors");
+
+  // the physical cores are not known without cpuinfo, use every logical processor as a core then
+  auto cores = Env::Default().GetDefaultThreadAffinities();
+  const auto is_unknown = [&node_of_processor](const LogicalProcessors& core) {
+    return core.empty() || core.front() < 0 || static_cast<size_t>(core.front()) >= node_of_processor.size() ||
+           node_of_processor[core.front()] < 0;
+  };
+  if (std::any_of(cores.begin(), cores.end(), is_unknown)) {
+    cores.clear();
+    for (size_t i = 0; i < node_of_processor.size(); ++i) {
+      if (node_of_processor[i] >= 0) {
+        cores.push_back(LogicalProcessors{static_cast<int>(i)});
+      }
+    }
+  }
+
+  std::map<int, std::vector<LogicalProcessors>> cores_of_node;
+  for (auto& core : cores) {
+    const int node = node_of_processor[core.front()];
+    if (options.numa_node < 0 || node == options.numa_node) {
+      cores_of_node[node].push_back(std::move(core));
+    }
+  }
+
+  // by default every core gets a thread, otherwise the threads are dealt to the nodes like cards
+  std::vector<size_t> threads_of_node;
+  size_t num_threads = 0;
+  for (const auto& entry : cores_of_node) {
+    threads_of_node.push_back(options.thread_pool_size > 0 ? 0 : entry.second.size());
+    num_threads += threads_of_node.back();
+  }
+
+  for (; static_cast<int>(num_threads) < options.thread_pool_size; ++num_threads) {
+    ++threads_of_node[num_threads % threads_of_node.size()];
+  }
+
+  // lay the threads out node by node
+  to.affinities.clear();
+  to.numa_nodes.clear();
+  size_t node_idx = 0;
+  for (const auto& [node, node_cores] : cores_of_node) {
+    for (size_t i = 0; i < threads_of_node[node_idx]; ++i) {
+      // more threads than cores share the cores of the node
+      to.affinities.push_back(node_cores[i % node_cores.size()]);
+      to.numa_nodes.push_back(node);
+    }
+    ++node_idx;
+  }
+
+  options.thread_pool_size = static_cast<int>(num_threads);
+  return true;
+}
+#endif
+
 static std::unique_ptr<ThreadPool>
 CreateThreadPoolHelper(Env* env, OrtThreadPoolParams options) {
   ThreadOptions to;
-  if (options.thread_pool_size <= 0) {  // default
+  bool numa_aware = false;
+  if (options.numa_aware && options.affinity_str.empty()) {
+#if defined(ORT_MINIMAL_BUILD) || defined(ORT_EXTENDED_MINIMAL_BUILD)
+    ORT_THROW("NUMA aware thread pools are not implemented in this build.");
+#else
+    numa_aware = SetNumaThreadAffinities(options, to);
+    if (!numa_aware) {
+      LOGS_DEFAULT(WARNING) << "The NUMA topology is not available, creating a thread pool that is not NUMA aware.";
+    }
+#endif
+  }
+
+  if (!numa_aware && options.thread_pool_size <= 0) {  // default
     if (options.auto_set_affinity) {
 #ifdef _WIN32
       // Only set thread affinity on Server with auto affinity.
@@ -151,6 +236,7 @@ CreateThreadPoolHelper(Env* env, OrtThreadPoolParams options) {
   to.custom_thread_creation_options = options.custom_thread_creation_options;
   to.custom_join_thread_fn = options.custom_join_thread_fn;
   to.dynamic_block_base_ = options.dynamic_block_base_;
+  to.adaptive_spin_budget_us = options.adaptive_spin_budget_us;
   if (to.custom_create_thread_fn) {
     ORT_ENFORCE(to.custom_join_thread_fn, "custom join thread function not set");
   }
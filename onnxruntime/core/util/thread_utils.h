@@ -31,6 +31,11 @@ struct OrtThreadPoolParams {
   // of remaining_of_total_iterations / (num_of_threads * dynamic_block_base_)
   int dynamic_block_base_ = 0;
 
+  // If it is greater than 0 and allow_spinning is true, the threads spin for a time that adapts to the
+  // idle gaps between their tasks, up to adaptive_spin_budget_us microseconds, instead of a fixed number
+  // of iterations.
+  int adaptive_spin_budget_us = 0;
+
   unsigned int stack_size = 0;
 
   // A utf-8 string of affinity settings, format be like:
@@ -43,6 +48,13 @@ struct OrtThreadPoolParams {
   // meaning ith thread will be attached to first 8 logical processors
   std::string affinity_str;
 
+  // If it is true and affinity_str is empty, bind the threads to the physical cores grouped by NUMA node,
+  // bind the memory of every thread to its node and prefer to exchange work between threads of the same node.
+  // If numa_node is not negative, only the cores of that node are used, e.g. to run one session per node.
+  // If thread_pool_size is 0, the pool has a thread for each of the cores that are used.
+  bool numa_aware = false;
+  int numa_node = -1;
+
   const ORTCHAR_T* name = nullptr;
 
   // Set or unset denormal as zero
@@ -2804,6 +2804,7 @@ including arg name, arg type (contains both type and shape).)pbdoc")
   py::enum_<onnxruntime::ArenaExtendStrategy>(m, "ArenaExtendStrategy", py::arithmetic())
       .value("kNextPowerOfTwo", onnxruntime::ArenaExtendStrategy::kNextPowerOfTwo)
       .value("kSameAsRequested", onnxruntime::ArenaExtendStrategy::kSameAsRequested)
+      .value("kSizeClassSlab", onnxruntime::ArenaExtendStrategy::kSizeClassSlab)
       .export_values();
 
   py::enum_<OrtCompileApiFlags>(m, "OrtCompileApiFlags", py::arithmetic())
@@ -0,0 +1,243 @@
+# -------------------------------------------------------------------------
+# Copyright (c) Microsoft Corporation.  All rights reserved.
+# Licensed under the MIT License.  See License.txt in the project root for
+# license information.
+# --------------------------------------------------------------------------
+# This script benchmarks speculative decoding of the GreedySearch or Sampling operator on CPU.
+# It takes two GPT-2 models exported with convert_generation.py: the main model and a smaller draft model
+# sharing its vocabulary. The decoder of the draft model is added to the main model as the draft_decoder
+# attribute, and generation with and without draft decoder is compared.
+#
+# Example:
+#   python convert_generation.py -m gpt2-medium --output gpt2_medium_greedy.onnx --num_beams 1 ...
+#   python convert_generation.py -m distilgpt2 --output distilgpt2_greedy.onnx --num_beams 1 ...
+#   python benchmark_speculative_decoding.py --model gpt2_medium_greedy.onnx --draft_model distilgpt2_greedy.onnx
+
+import argparse
+import logging
+import sys
+import time
+
+import numpy
+import onnx
+from benchmark_helper import setup_logger
+from onnx import helper
+from transformers import AutoTokenizer
+
+import onnxruntime
+
+logger = logging.getLogger("")
+
+GENERATION_OPS = ["GreedySearch", "Sampling"]
+
+
+def parse_arguments(argv=None):
+    parser = argparse.ArgumentParser()
+
+    parser.add_argument("--model", required=True, type=str, help="GreedySearch or Sampling model of the main decoder")
+
+    parser.add_argument(
+        "--draft_model",
+        required=True,
+        type=str,
+        help="GreedySearch or Sampling model whose decoder proposes the draft tokens",
+    )
+
+    parser.add_argument(
+        "--output",
+        required=False,
+        type=str,
+        default="speculative_decoding.onnx",
+        help="Path of the main model with the draft decoder",
+    )
+
+    parser.add_argument("--num_draft_tokens", required=False, type=int, default=4, help="Tokens proposed per step")
+
+    parser.add_argument("--tokenizer", required=False, type=str, default="gpt2", help="Tokenizer of the models")
+
+    parser.add_argument(
+        "--prompt",
+        required=False,
+        type=str,
+        default="The quick brown fox jumps over the lazy dog. Once upon a time",
+        help="Prompt of the generation",
+    )
+
+    parser.add_argument("-b", "--batch_size", required=False, type=int, default=1, help="Copies of the prompt")
+
+    parser.add_argument("--max_length", required=False, type=int, default=128, help="Maximum sequence length")
+
+    parser.add_argument("--test_times", required=False, type=int, default=5, help="Number of timed runs")
+
+    parser.add_argument("--thread_num", required=False, type=int, default=-1, help="Threads to use")
+
+    parser.add_argument("--verbose", required=False, action="store_true")
+    parser.set_defaults(verbose=False)
+
+    args = parser.parse_args(argv)
+    return args
+
+
+def get_generation_node(model: onnx.ModelProto) -> onnx.NodeProto:
+    for node in model.graph.node:
+        if node.op_type in GENERATION_OPS:
+            return node
+    raise ValueError(f"No {' or '.join(GENERATION_OPS)} node in the model")
+
+
+def add_draft_decoder(model: onnx.ModelProto, draft_model: onnx.ModelProto, num_draft_tokens: int) -> onnx.ModelProto:
+    """Add the decoder of the draft model to the generation node of the model.
+
+    Initializers of the outer graph used by the draft decoder are copied with a prefix to avoid name conflicts.
+    """
+    node = get_generation_node(model)
+    draft_node = get_generation_node(draft_model)
+    draft_decoder = next(attr.g for attr in draft_node.attribute if attr.name == "decoder")
+
+    prefix = "draft_"
+    outer_initializers = {initializer.name: initializer for initializer in draft_model.graph.initializer}
+    used = set()
+
+    def rename_inputs(graph: onnx.GraphProto):
+        for graph_node in graph.node:
+            for i, name in enumerate(graph_node.input):
+                if name in outer_initializers:
+                    used.add(name)
+                    graph_node.input[i] = prefix + name
+            for attr in graph_node.attribute:
+                if attr.type == onnx.AttributeProto.GRAPH:
+                    rename_inputs(attr.g)
+
+    rename_inputs(draft_decoder)
+    for name in sorted(used):
+        initializer = onnx.TensorProto()
+        initializer.CopyFrom(outer_initializers[name])
+        initializer.name = prefix + name
+        model.graph.initializer.append(initializer)
+
+    for attr in list(node.attribute):
+        if attr.name in ["draft_decoder", "num_draft_tokens"]:
+            node.attribute.remove(attr)
+    node.attribute.extend(
+        [
+            helper.make_attribute("draft_decoder", draft_decoder),
+            helper.make_attribute("num_draft_tokens", num_draft_tokens),
+        ]
+    )
+    return model
+
+
+def create_session(model_path: str, thread_num: int) -> onnxruntime.InferenceSession:
+    sess_options = onnxruntime.SessionOptions()
+    if thread_num > 0:
+        sess_options.intra_op_num_threads = thread_num
+    return onnxruntime.InferenceSession(model_path, sess_options, providers=["CPUExecutionProvider"])
+
+
+def create_inputs(session: onnxruntime.InferenceSession, input_ids: numpy.ndarray, max_length: int):
+    inputs = {"input_ids": input_ids, "max_length": numpy.array([max_length], dtype=numpy.int32)}
+    defaults = {
+        "min_length": numpy.array([0], dtype=numpy.int32),
+        "num_return_sequences": numpy.array([1], dtype=numpy.int32),
+        "repetition_penalty": numpy.array([1.0], dtype=numpy.float32),
+        "attention_mask": numpy.ones(input_ids.shape, dtype=numpy.int32),
+    }
+    for model_input in session.get_inputs():
+        if model_input.name in defaults:
+            inputs[model_input.name] = defaults[model_input.name]
+    return inputs
+
+
+def generate(session: onnxruntime.InferenceSession, input_ids: numpy.ndarray, max_length: int):
+    return session.run(["sequences"], create_inputs(session, input_ids, max_length))[0]
+
+
+def measure(session: onnxruntime.InferenceSession, input_ids: numpy.ndarray, max_length: int, test_times: int):
+    sequences = generate(session, input_ids, max_length)  # warm up
+    start = time.perf_counter()
+    for _ in range(test_times):
+        sequences = generate(session, input_ids, max_length)
+    latency = (time.perf_counter() - start) / test_times
+    return sequences.reshape(input_ids.shape[0], -1), latency
+
+
+def count_generated_tokens(sequences: numpy.ndarray, prompt_length: int, pad_token_id: int) -> int:
+    return int(numpy.count_nonzero(sequences[:, prompt_length:] != pad_token_id))
+
+
+def acceptance_rate(
+    draft_session: onnxruntime.InferenceSession, sequences: numpy.ndarray, prompt_length: int, pad_token_id: int
+) -> float:
+    """Fraction of the generated tokens that the draft model predicts from the same prefix (greedy search)."""
+    accepted = 0
+    total = 0
+    for length in range(prompt_length, sequences.shape[1]):
+        target = sequences[:, length]
+        rows = target != pad_token_id
+        if not rows.any():
+            break
+        prediction = generate(draft_session, numpy.ascontiguousarray(sequences[:, :length]), length + 1)
+        prediction = prediction.reshape(sequences.shape[0], -1)[:, length]
+        accepted += int(numpy.count_nonzero((prediction == target) & rows))
+        total += int(numpy.count_nonzero(rows))
+    return accepted / total if total > 0 else 0.0
+
+
+def main(argv=None):
+    args = parse_arguments(argv)
+    setup_logger(args.verbose)
+
+    model = onnx.load_model(args.model, load_external_data=True)
+    draft_model = onnx.load_model(args.draft_model, load_external_data=True)
+    node = get_generation_node(model)
+    pad_token_id = next(attr.i for attr in node.attribute if attr.name == "pad_token_id")
+    use_sampling = node.op_type == "Sampling"
+
+    onnx.save_model(
+        add_draft_decoder(model, draft_model, args.num_draft_tokens),
+        args.output,
+        save_as_external_data=True,
+        all_tensors_to_one_file=True,
+        location=args.output + ".data",
+    )
+    logger.info(f"Model with draft decoder saved to {args.output}")
+
+    tokenizer = AutoTokenizer.from_pretrained(args.tokenizer)
+    prompt_ids = tokenizer(args.prompt, return_tensors="np")["input_ids"].astype(numpy.int32)
+    input_ids = numpy.repeat(prompt_ids, args.batch_size, axis=0)
+    prompt_length = input_ids.shape[1]
+    if args.max_length <= prompt_length:
+        logger.error(f"max_length={args.max_length} shall be larger than the prompt length {prompt_length}")
+        return 1
+
+    baseline_session = create_session(args.model, args.thread_num)
+    speculative_session = create_session(args.output, args.thread_num)
+
+    baseline, baseline_latency = measure(baseline_session, input_ids, args.max_length, args.test_times)
+    speculative, speculative_latency = measure(speculative_session, input_ids, args.max_length, args.test_times)
+
+    baseline_tokens = count_generated_tokens(baseline, prompt_length, pad_token_id)
+    speculative_tokens = count_generated_tokens(speculative, prompt_length, pad_token_id)
+    logger.info(f"baseline: {baseline_latency * 1000:.2f} ms, {baseline_tokens / baseline_latency:.2f} tokens/s")
+    logger.info(
+        f"speculative: {speculative_latency * 1000:.2f} ms, {speculative_tokens / speculative_latency:.2f} tokens/s"
+    )
+    logger.info(f"speedup: {baseline_latency / speculative_latency:.2f}x")
+
+    if use_sampling:
+        logger.info("Sampling does not generate the same sequences with and without draft decoder.")
+    elif not numpy.array_equal(baseline, speculative):
+        logger.warning("The sequences generated with draft decoder are different.")
+
+    draft_session = create_session(args.draft_model, args.thread_num)
+    if get_generation_node(draft_model).op_type == "GreedySearch":
+        rate = acceptance_rate(draft_session, speculative, prompt_length, pad_token_id)
+        logger.info(f"acceptance rate: {rate:.2%} with num_draft_tokens={args.num_draft_tokens}")
+    else:
+        logger.info("The acceptance rate is measured with a GreedySearch draft model only.")
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
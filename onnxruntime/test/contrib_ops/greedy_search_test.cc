@@ -1,10 +1,13 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <functional>
 #include <memory>
+#include <string>
 #include <vector>
 #include "gtest/gtest.h"
 #include <gsl/gsl>
+#include "core/graph/model.h"
 #include "core/session/onnxruntime_cxx_api.h"
 #include "test/common/cuda_op_test_utils.h"
 
@@ -17,6 +20,73 @@ extern std::unique_ptr<Ort::Env> ort_env;
 namespace onnxruntime {
 namespace test {
 
+namespace {
+
+// Sequences of input_ids run by one call of GreedySearch.
+struct GreedySearchBatch {
+  std::vector<int64_t> shape;
+  std::vector<int32_t> input_ids;
+};
+
+// tiny_gpt2_greedysearch_with_init_decoder.onnx, with the GreedySearch node updated by update_node.
+std::string CreateGreedySearchModel(const std::function<void(ONNX_NAMESPACE::NodeProto&)>& update_node = {}) {
+  static const ONNX_NAMESPACE::ModelProto model_proto = [] {
+    ONNX_NAMESPACE::ModelProto proto;
+    ORT_THROW_IF_ERROR(Model::Load(ORT_TSTR("testdata/transformers/tiny_gpt2_greedysearch_with_init_decoder.onnx"),
+                                   proto));
+    return proto;
+  }();
+
+  ONNX_NAMESPACE::ModelProto updated_model_proto = model_proto;
+  if (update_node) {
+    update_node(*updated_model_proto.mutable_graph()->mutable_node(0));
+  }
+  return updated_model_proto.SerializeAsString();
+}
+
+void AddIntAttribute(ONNX_NAMESPACE::NodeProto& node, const std::string& name, int64_t value) {
+  auto* attribute = node.add_attribute();
+  attribute->set_name(name);
+  attribute->set_type(ONNX_NAMESPACE::AttributeProto_AttributeType_INT);
+  attribute->set_i(value);
+}
+
+// Run the batches in order in one session on CPU, and return the sequences generated for each of them.
+std::vector<std::vector<int32_t>> RunGreedySearch(const std::string& model_data,
+                                                  std::vector<GreedySearchBatch> batches,
+                                                  int32_t max_length) {
+  const char* input_names[] = {"input_ids", "max_length"};
+  const char* const output_names[] = {"sequences"};
+  std::vector<int64_t> parameter_shape{1};
+
+  Ort::MemoryInfo info("Cpu", OrtDeviceAllocator, 0, OrtMemTypeDefault);
+  Ort::SessionOptions session_options;
+  Ort::Session session(*ort_env, model_data.data(), model_data.size(), session_options);
+
+  std::vector<std::vector<int32_t>> outputs;
+  for (auto& batch : batches) {
+    std::vector<Ort::Value> ort_inputs;
+    ort_inputs.push_back(Ort::Value::CreateTensor(
+        info, batch.input_ids.data(), batch.input_ids.size(), batch.shape.data(), batch.shape.size()));
+    ort_inputs.push_back(Ort::Value::CreateTensor(
+        info, &max_length, 1, parameter_shape.data(), parameter_shape.size()));
+
+    auto ort_outputs = session.Run(Ort::RunOptions{}, input_names, ort_inputs.data(), ort_inputs.size(),
+                                   output_names, 1);
+    EXPECT_EQ(ort_outputs.size(), 1U);
+
+    auto result_ts = ort_outputs[0].GetTensorTypeAndShapeInfo();
+    EXPECT_EQ(ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32, result_ts.GetElementType());
+    EXPECT_EQ((std::vector<int64_t>{batch.shape[0], max_length}), result_ts.GetShape());
+
+    const auto* result_vals = ort_outputs[0].GetTensorData<int32_t>();
+    outputs.emplace_back(result_vals, result_vals + result_ts.GetElementCount());
+  }
+  return outputs;
+}
+
+}  // namespace
+
 TEST(GreedySearchTest, GptGreedySearchFp16_VocabPadded) {
   std::vector<int64_t> input_ids_shape{2, 4};
   std::vector<int32_t> input_ids{
@@ -177,5 +247,125 @@ TEST(GreedySearchTest, GptGreedySearchFp32) {
   }
 }
 
+TEST(GreedySearchTest, GptGreedySearchFp32_ContinuousBatching) {
+  // Sequences of different lengths, with token 98 as padding. Two of them are decoded together, and the
+  // third one takes the place of the first one to finish.
+  std::vector<GreedySearchBatch> batches{
+      {{3, 4},
+       {0, 0, 0, 52,
+        98, 98, 195, 731,
+        98, 12, 33, 61}}};
+
+  auto model_data = CreateGreedySearchModel([](ONNX_NAMESPACE::NodeProto& node) {
+    AddIntAttribute(node, "continuous_batch_size", 2);
+  });
+
+  auto expected_output = RunGreedySearch(CreateGreedySearchModel(), batches, 10);
+  ASSERT_EQ(expected_output, RunGreedySearch(model_data, batches, 10));
+}
+
+TEST(GreedySearchTest, GptGreedySearchFp32_SpeculativeDecoding) {
+  std::vector<GreedySearchBatch> batches{
+      {{2, 4},
+       {0, 0, 0, 52,
+        98, 98, 195, 731}}};
+
+  // The draft decoder proposes 3 tokens. It is the decoder with the weight of its last MLP projection negated,
+  // so that some of its tokens are rejected.
+  auto model_data = CreateGreedySearchModel([](ONNX_NAMESPACE::NodeProto& node) {
+    ONNX_NAMESPACE::GraphProto draft_graph;
+    for (const auto& attribute : node.attribute()) {
+      if (attribute.name() == "decoder") {
+        draft_graph = attribute.g();
+      }
+    }
+
+    for (auto& initializer : *draft_graph.mutable_initializer()) {
+      if (initializer.name() == "d_transformer.h.4.mlp.c_proj.weight") {
+        // raw data is little endian, so the sign bit of a float is in its last byte
+        std::string& raw_data = *initializer.mutable_raw_data();
+        for (size_t i = 3; i < raw_data.size(); i += 4) {
+          raw_data[i] = static_cast<char>(raw_data[i] ^ 0x80);
+        }
+      }
+    }
+
+    auto* draft_decoder = node.add_attribute();
+    draft_decoder->set_name("draft_decoder");
+    draft_decoder->set_type(ONNX_NAMESPACE::AttributeProto_AttributeType_GRAPH);
+    *draft_decoder->mutable_g() = std::move(draft_graph);
+    AddIntAttribute(node, "num_draft_tokens", 3);
+  });
+
+  auto expected_output = RunGreedySearch(CreateGreedySearchModel(), batches, 16);
+  ASSERT_EQ(expected_output, RunGreedySearch(model_data, batches, 16));
+}
+
+TEST(GreedySearchTest, GptGreedySearchFp32_PrefixCache) {
+  // The second prompt starts with the first one, and the third prompt is the first one again.
+  std::vector<GreedySearchBatch> batches{
+      {{1, 5}, {12, 33, 61, 195, 731}},
+      {{1, 7}, {12, 33, 61, 195, 731, 52, 7}},
+      {{1, 5}, {12, 33, 61, 195, 731}}};
+
+  // The prompts are run in order in one session, so that the later prompts are decoded from the cached past state.
+  auto model_data = CreateGreedySearchModel([](ONNX_NAMESPACE::NodeProto& node) {
+    AddIntAttribute(node, "prefix_cache_bytes", 1 << 20);
+  });
+
+  auto expected_outputs = RunGreedySearch(CreateGreedySearchModel(), batches, 16);
+  ASSERT_EQ(expected_outputs, RunGreedySearch(model_data, batches, 16));
+}
+
+TEST(GreedySearchTest, GptGreedySearchFp32_PrefixCacheEviction) {
+  // The past state of a prompt of 5 tokens takes 6400 bytes: 5 layers of 2 x 4 heads x 5 tokens x 8 floats.
+  // The cache only has room for one, so each prompt evicts the other one.
+  std::vector<GreedySearchBatch> batches{
+      {{1, 5}, {12, 33, 61, 195, 731}},
+      {{1, 5}, {52, 7, 41, 554, 74}},
+      {{1, 5}, {12, 33, 61, 195, 731}},
+      {{1, 6}, {52, 7, 41, 554, 74, 622}}};
+
+  auto model_data = CreateGreedySearchModel([](ONNX_NAMESPACE::NodeProto& node) {
+    AddIntAttribute(node, "prefix_cache_bytes", 8192);
+  });
+
+  auto expected_outputs = RunGreedySearch(CreateGreedySearchModel(), batches, 16);
+  ASSERT_EQ(expected_outputs, RunGreedySearch(model_data, batches, 16));
+}
+
+TEST(GreedySearchTest, GptGreedySearchFp32_PrefixCachePadding) {
+  // The prompt with padding is decoded without the cache, even though it ends with the cached prompt, and it is
+  // not cached.
+  std::vector<GreedySearchBatch> batches{
+      {{1, 5}, {12, 33, 61, 195, 731}},
+      {{1, 7}, {98, 98, 12, 33, 61, 195, 731}},
+      {{1, 7}, {12, 33, 61, 195, 731, 52, 7}}};
+
+  auto model_data = CreateGreedySearchModel([](ONNX_NAMESPACE::NodeProto& node) {
+    AddIntAttribute(node, "prefix_cache_bytes", 1 << 20);
+  });
+
+  auto expected_outputs = RunGreedySearch(CreateGreedySearchModel(), batches, 16);
+  ASSERT_EQ(expected_outputs, RunGreedySearch(model_data, batches, 16));
+}
+
+TEST(GreedySearchTest, GptGreedySearchFp32_PrefixCacheContinuousBatching) {
+  // Sequences are decoded one at a time. The prompt of the second sequence, without its last token, is a prefix of
+  // the prompt of the first one, so its past state is the cached one truncated to its length.
+  std::vector<GreedySearchBatch> batches{
+      {{2, 7},
+       {12, 33, 61, 195, 731, 52, 7,
+        98, 98, 98, 12, 33, 61, 195}}};
+
+  auto model_data = CreateGreedySearchModel([](ONNX_NAMESPACE::NodeProto& node) {
+    AddIntAttribute(node, "continuous_batch_size", 1);
+    AddIntAttribute(node, "prefix_cache_bytes", 1 << 20);
+  });
+
+  auto expected_output = RunGreedySearch(CreateGreedySearchModel(), batches, 16);
+  ASSERT_EQ(expected_output, RunGreedySearch(model_data, batches, 16));
+}
+
 }  // namespace test
 }  // namespace onnxruntime
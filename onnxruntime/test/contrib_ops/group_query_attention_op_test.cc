@@ -0,0 +1,141 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <vector>
+#include "gtest/gtest.h"
+#include "contrib_ops/cpu/bert/attention_common.h"
+#include "test/common/random_generator.h"
+#include "test/providers/provider_test_utils.h"
+#include "test/util/include/scoped_env_vars.h"
+
+namespace onnxruntime {
+namespace test {
+
+namespace {
+
+struct GroupQueryAttentionConfig {
+  int batch_size = 2;
+  int sequence_length = 1;
+  int num_heads = 4;
+  int kv_num_heads = 4;
+  int head_size = 16;
+  int local_window_size = -1;
+  float softcap = 0.0f;
+  bool smooth_softmax = false;
+  bool head_sink = false;
+};
+
+// Runs the first prompt through GroupQueryAttention on CPU, and returns its output, present_key and present_value.
+std::vector<std::vector<float>> RunGroupQueryAttentionPrompt(const GroupQueryAttentionConfig& config,
+                                                             bool disable_flash) {
+  ScopedEnvironmentVariables scoped_env_vars{
+      EnvVarMap{{onnxruntime::contrib::attention::kDisableFlashAttention, disable_flash ? "1" : "0"}}};
+
+  const int64_t batch_size = config.batch_size;
+  const int64_t sequence_length = config.sequence_length;
+  const int64_t hidden_size = static_cast<int64_t>(config.num_heads) * config.head_size;
+  const int64_t kv_hidden_size = static_cast<int64_t>(config.kv_num_heads) * config.head_size;
+  std::vector<int64_t> query_dims{batch_size, sequence_length, hidden_size};
+  std::vector<int64_t> kv_dims{batch_size, sequence_length, kv_hidden_size};
+  std::vector<int64_t> present_dims{batch_size, config.kv_num_heads, sequence_length, config.head_size};
+
+  // Large enough scores for the softcap and the sinks to matter.
+  RandomValueGenerator random{1234};
+  std::vector<float> query = random.Uniform<float>(query_dims, -2.0f, 2.0f);
+  std::vector<float> key = random.Uniform<float>(kv_dims, -2.0f, 2.0f);
+  std::vector<float> value = random.Uniform<float>(kv_dims, -1.0f, 1.0f);
+  std::vector<float> head_sink = random.Uniform<float>(std::vector<int64_t>{config.num_heads}, -2.0f, 2.0f);
+
+  OpTester tester("GroupQueryAttention", 1, onnxruntime::kMSDomain);
+  tester.AddAttribute<int64_t>("num_heads", config.num_heads);
+  tester.AddAttribute<int64_t>("kv_num_heads", config.kv_num_heads);
+  tester.AddAttribute<int64_t>("local_window_size", config.local_window_size);
+  tester.AddAttribute<float>("softcap", config.softcap);
+  tester.AddAttribute<int64_t>("smooth_softmax", config.smooth_softmax ? 1 : 0);
+
+  tester.AddInput<float>("query", query_dims, query);
+  tester.AddInput<float>("key", kv_dims, key);
+  tester.AddInput<float>("value", kv_dims, value);
+  tester.AddOptionalInputEdge<float>();  // past_key
+  tester.AddOptionalInputEdge<float>();  // past_value
+  tester.AddInput<int32_t>("seqlens_k", {batch_size},
+                           std::vector<int32_t>(static_cast<size_t>(batch_size), config.sequence_length - 1));
+  tester.AddInput<int32_t>("total_sequence_length", {1}, {config.sequence_length});
+  if (config.head_sink) {
+    tester.AddOptionalInputEdge<float>();  // cos_cache
+    tester.AddOptionalInputEdge<float>();  // sin_cache
+    tester.AddOptionalInputEdge<int64_t>();  // position_ids
+    tester.AddOptionalInputEdge<float>();  // attention_bias
+    tester.AddInput<float>("head_sink", {config.num_heads}, head_sink);
+  }
+
+  // The outputs are returned by the verifier, the values here are not checked.
+  tester.AddOutput<float>("output", query_dims, std::vector<float>(query.size()));
+  tester.AddOutput<float>("present_key", present_dims, std::vector<float>(key.size()));
+  tester.AddOutput<float>("present_value", present_dims, std::vector<float>(value.size()));
+
+  std::vector<std::vector<float>> outputs;
+  tester.SetCustomOutputVerifier([&](const std::vector<OrtValue>& fetches, const std::string& /*provider_type*/) {
+    for (const OrtValue& fetch : fetches) {
+      auto data = fetch.Get<Tensor>().DataAsSpan<float>();
+      outputs.emplace_back(data.begin(), data.end());
+    }
+  });
+
+  std::vector<std::unique_ptr<IExecutionProvider>> execution_providers;
+  execution_providers.push_back(DefaultCpuExecutionProvider());
+  tester.Run(OpTester::ExpectResult::kExpectSuccess, "", {}, nullptr, &execution_providers);
+  return outputs;
+}
+
+void TestFlashAttentionMatchesAttentionProbs(const GroupQueryAttentionConfig& config) {
+  auto expected_outputs = RunGroupQueryAttentionPrompt(config, true);
+  auto outputs = RunGroupQueryAttentionPrompt(config, false);
+  ASSERT_EQ(expected_outputs.size(), 3U);
+  ASSERT_EQ(outputs.size(), 3U);
+
+  for (size_t i = 0; i < expected_outputs[0].size(); i++) {
+    ASSERT_NEAR(outputs[0][i], expected_outputs[0][i], 1e-5f + std::fabs(expected_outputs[0][i]) * 1e-4f)
+        << "output @" << i << ", sequence_length=" << config.sequence_length
+        << ", kv_num_heads=" << config.kv_num_heads << ", local_window_size=" << config.local_window_size
+        << ", softcap=" << config.softcap << ", smooth_softmax=" << config.smooth_softmax
+        << ", head_sink=" << config.head_sink;
+  }
+
+  // Both paths copy the keys and values of the prompt to the present state as they are.
+  EXPECT_EQ(outputs[1], expected_outputs[1]);
+  EXPECT_EQ(outputs[2], expected_outputs[2]);
+}
+
+}  // namespace
+
+// The first prompt is computed by MlasFlashAttention when the L2 cache size is known, and otherwise from the
+// attention probs, like the prompts after a past. Both shall give the same outputs.
+TEST(GroupQueryAttentionTest, FlashAttentionMatchesAttentionProbs) {
+  // Prompt lengths that are not multiples of the block sizes of the flash kernel.
+  for (int sequence_length : {1, 7, 33, 130}) {
+    for (int kv_num_heads : {4, 2, 1}) {
+      GroupQueryAttentionConfig config;
+      config.sequence_length = sequence_length;
+      config.kv_num_heads = kv_num_heads;
+      TestFlashAttentionMatchesAttentionProbs(config);
+
+      config.local_window_size = 5;
+      TestFlashAttentionMatchesAttentionProbs(config);
+
+      config.softcap = 2.0f;
+      TestFlashAttentionMatchesAttentionProbs(config);
+
+      config.local_window_size = -1;
+      config.smooth_softmax = true;
+      TestFlashAttentionMatchesAttentionProbs(config);
+
+      config.softcap = 0.0f;
+      config.head_sink = true;
+      TestFlashAttentionMatchesAttentionProbs(config);
+    }
+  }
+}
+
+}  // namespace test
+}  // namespace onnxruntime
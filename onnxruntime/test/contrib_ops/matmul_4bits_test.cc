@@ -3,7 +3,9 @@
 
 #ifndef ORT_MINIMAL_BUILD
 
+#include <cmath>
 #include <optional>
+#include <string>
 
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
@@ -83,6 +85,12 @@ struct TestOptions {
   bool has_g_idx{false};
   bool has_bias{false};
 
+  // epilogue, only supported for float on CPU
+  std::string activation{};
+  float activation_alpha{1.702f};
+  bool has_multiplier{false};
+  bool has_residual{false};
+
   bool legacy_shape{false};  // for backward compatibility
 
   std::optional<float> output_abs_error{};
@@ -96,7 +104,25 @@ struct TestOptions {
             << ", has_zero_point:" << opts.has_zero_point
             << ", zp_is_4bit:" << opts.zp_is_4bit
             << ", has_g_idx:" << opts.has_g_idx
-            << ", has_bias:" << opts.has_bias;
+            << ", has_bias:" << opts.has_bias
+            << ", activation:" << opts.activation
+            << ", has_multiplier:" << opts.has_multiplier
+            << ", has_residual:" << opts.has_residual;
+}
+
+float ApplyActivation(const std::string& activation, float alpha, float x) {
+  if (activation == "Relu") {
+    return std::max(x, 0.0f);
+  } else if (activation == "Sigmoid") {
+    return 1.0f / (1.0f + std::exp(-x));
+  } else if (activation == "Gelu") {
+    return 0.5f * x * (1.0f + std::erf(x * static_cast<float>(M_SQRT1_2)));
+  } else if (activation == "FastGelu") {
+    return 0.5f * x * (1.0f + std::tanh(0.7978845608f * (x + 0.044715f * x * x * x)));
+  } else if (activation == "QuickGelu") {
+    return x / (1.0f + std::exp(-alpha * x));
+  }
+  return x;
 }
 
 template <typename T1>
@@ -150,6 +176,11 @@ void RunTest(const TestOptions& opts,
     return std::nullopt;
   }();
 
+  const std::vector<float> multiplier = opts.has_multiplier ? random.Uniform(AsSpan({M, N}), -2.0f, 2.0f)
+                                                            : std::vector<float>{};
+  const std::vector<float> residual = opts.has_residual ? random.Uniform(AsSpan({M, N}), -2.0f, 2.0f)
+                                                        : std::vector<float>{};
+
   std::vector<float> expected_vals(M * N);
   for (int64_t m = 0; m < M; m++) {
     for (int64_t n = 0; n < N; n++) {
@@ -157,7 +188,15 @@ void RunTest(const TestOptions& opts,
       for (int64_t k = 0; k < K; k++) {
         sum += input0_vals[m * K + k] * input1_f_vals[n * K + k];
       }
-      expected_vals[m * N + n] = sum + (bias.has_value() ? (*bias)[n] : 0.0f);
+      float y = ApplyActivation(opts.activation, opts.activation_alpha,
+                                sum + (bias.has_value() ? (*bias)[n] : 0.0f));
+      if (opts.has_multiplier) {
+        y *= multiplier[m * N + n];
+      }
+      if (opts.has_residual) {
+        y += residual[m * N + n];
+      }
+      expected_vals[m * N + n] = y;
     }
   }
 
@@ -167,6 +206,10 @@ void RunTest(const TestOptions& opts,
   test.AddAttribute<int64_t>("block_size", opts.block_size);
   test.AddAttribute<int64_t>("bits", QBits);
   test.AddAttribute<int64_t>("accuracy_level", opts.accuracy_level);
+  if (!opts.activation.empty()) {
+    test.AddAttribute<std::string>("activation", opts.activation);
+    test.AddAttribute<float>("activation_alpha", opts.activation_alpha);
+  }
 
   if constexpr (std::is_same_v<T1, float>) {
     test.AddInput<T1>("A", {M, K}, input0_vals, false);
@@ -247,6 +290,19 @@ void RunTest(const TestOptions& opts,
     test.AddOptionalInputEdge<T1>();
   }
 
+  if constexpr (std::is_same<T1, float>::value) {
+    if (opts.has_multiplier || opts.has_residual) {
+      if (opts.has_multiplier) {
+        test.AddInput<T1>("multiplier", {M, N}, multiplier);
+      } else {
+        test.AddOptionalInputEdge<T1>();
+      }
+      if (opts.has_residual) {
+        test.AddInput<T1>("residual", {M, N}, residual);
+      }
+    }
+  }
+
   if constexpr (std::is_same<T1, float>::value) {
     test.AddOutput<T1>("Y", {M, N}, expected_vals);
   } else if constexpr (std::is_same<T1, MLFloat16>::value) {
@@ -411,6 +467,33 @@ TEST(MatMulNBits, Float32_Accuracy4) {
   TestMatMulNBitsTyped<float, 100, 288, 1234, 16, 4>();
 }
 
+TEST(MatMulNBits, Float32_Epilogue) {
+  for (int64_t accuracy_level : {0, 4}) {
+    for (const char* activation : {"", "Relu", "Sigmoid", "Gelu", "FastGelu", "QuickGelu"}) {
+      for (bool has_multiplier : {false, true}) {
+        TestOptions opts{};
+        opts.M = 35, opts.N = 288, opts.K = 93;
+        opts.block_size = 32;
+        opts.accuracy_level = accuracy_level;
+        opts.has_bias = true;
+        opts.activation = activation;
+        opts.activation_alpha = 1.0f;
+        opts.has_multiplier = has_multiplier;
+        opts.has_residual = true;
+        if (accuracy_level == 4) {
+          opts.output_abs_error = 0.1f;
+          opts.output_rel_error = 0.02f;
+        }
+
+        // the epilogue is only supported by the CPU EP
+        std::vector<std::unique_ptr<IExecutionProvider>> explicit_eps;
+        explicit_eps.emplace_back(DefaultCpuExecutionProvider());
+        RunTest<float>(opts, std::move(explicit_eps));
+      }
+    }
+  }
+}
+
 #if defined(MLAS_TARGET_AMD64_IX86) || defined(MLAS_TARGET_ARM64)
 #if !defined(USE_DML)
 // Actual and expected difference is over 0.01 with DmlExecutionProvider.
@@ -1,10 +1,15 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <algorithm>
+#include <cmath>
+
 #include "gtest/gtest.h"
+#include "test/common/random_generator.h"
 #include "test/common/tensor_op_test_utils.h"
 #include "test/common/cuda_op_test_utils.h"
 #include "test/providers/provider_test_utils.h"
+#include "test/util/include/default_providers.h"
 
 namespace onnxruntime {
 namespace test {
@@ -1270,6 +1275,149 @@ TEST(MoETest, QMoETest_Mixtral_Int4) {
               1, /*normalize_routing_weights*/
               2 /*top_k*/);
 }
+
+// Dequantizes the signed expert weights of shape (num_experts, rows, cols), packed along cols for 4 bits.
+static std::vector<float> DequantizeExpertWeights(const std::vector<uint8_t>& weights, const std::vector<float>& scales,
+                                                  int num_experts, int rows, int cols, int bits) {
+  std::vector<float> dequantized(static_cast<size_t>(num_experts) * rows * cols);
+  const int row_bytes = bits == 4 ? cols / 2 : cols;
+  for (int e = 0; e < num_experts; e++) {
+    for (int r = 0; r < rows; r++) {
+      for (int c = 0; c < cols; c++) {
+        const uint8_t byte = weights[(static_cast<size_t>(e) * rows + r) * row_bytes + (bits == 4 ? c / 2 : c)];
+        const int value = bits == 4 ? static_cast<int8_t>(byte << (4 - (c & 1) * 4)) >> 4 : static_cast<int8_t>(byte);
+        dequantized[(static_cast<size_t>(e) * rows + r) * cols + c] = value * scales[e * cols + c];
+      }
+    }
+  }
+  return dequantized;
+}
+
+// Runs the CPU QMoE kernel on random inputs and compares it with a reference computed from the dequantized weights.
+static void RunQMoECpuTest(int num_rows, int num_experts, int hidden_size, int inter_size, int top_k,
+                           const std::string& activation_type, int bits, bool normalize_routing_weights,
+                           bool use_fc3, bool weights_are_initializers) {
+  RandomValueGenerator random{1234};
+  const int pack_size = 8 / bits;
+  const std::vector<int64_t> input_dims = {num_rows, hidden_size};
+  const std::vector<int64_t> router_probs_dims = {num_rows, num_experts};
+  const std::vector<int64_t> fc1_experts_weights_dims = {num_experts, hidden_size, inter_size / pack_size};
+  const std::vector<int64_t> fc2_experts_weights_dims = {num_experts, inter_size, hidden_size / pack_size};
+  const std::vector<int64_t> fc1_dims = {num_experts, inter_size};
+  const std::vector<int64_t> fc2_dims = {num_experts, hidden_size};
+
+  const std::vector<float> input = random.Uniform<float>(input_dims, -1.0f, 1.0f);
+  const std::vector<float> router_probs = random.Uniform<float>(router_probs_dims, -2.0f, 2.0f);
+  const std::vector<uint8_t> fc1_experts_weights = random.Uniform<uint8_t>(fc1_experts_weights_dims, 0, 255);
+  const std::vector<uint8_t> fc2_experts_weights = random.Uniform<uint8_t>(fc2_experts_weights_dims, 0, 255);
+  const std::vector<uint8_t> fc3_experts_weights = random.Uniform<uint8_t>(fc1_experts_weights_dims, 0, 255);
+  const float scale = bits == 4 ? 0.05f : 0.004f;
+  const std::vector<float> fc1_scales = random.Uniform<float>(fc1_dims, scale / 2, scale);
+  const std::vector<float> fc2_scales = random.Uniform<float>(fc2_dims, scale / 2, scale);
+  const std::vector<float> fc3_scales = random.Uniform<float>(fc1_dims, scale / 2, scale);
+  const std::vector<float> fc1_experts_bias = random.Uniform<float>(fc1_dims, -0.1f, 0.1f);
+  const std::vector<float> fc2_experts_bias = random.Uniform<float>(fc2_dims, -0.1f, 0.1f);
+
+  const std::vector<float> fc1 = DequantizeExpertWeights(fc1_experts_weights, fc1_scales, num_experts, hidden_size,
+                                                         inter_size, bits);
+  const std::vector<float> fc2 = DequantizeExpertWeights(fc2_experts_weights, fc2_scales, num_experts, inter_size,
+                                                         hidden_size, bits);
+  const std::vector<float> fc3 = DequantizeExpertWeights(fc3_experts_weights, fc3_scales, num_experts, hidden_size,
+                                                         inter_size, bits);
+
+  std::vector<float> output(static_cast<size_t>(num_rows) * hidden_size, 0.0f);
+  for (int row = 0; row < num_rows; row++) {
+    const float* logits = router_probs.data() + row * num_experts;
+    std::vector<float> probs(num_experts);
+    const float max_logit = *std::max_element(logits, logits + num_experts);
+    float sum = 0.0f;
+    for (int e = 0; e < num_experts; e++) {
+      probs[e] = std::exp(logits[e] - max_logit);
+      sum += probs[e];
+    }
+    std::vector<int> experts(num_experts);
+    for (int e = 0; e < num_experts; e++) {
+      experts[e] = e;
+    }
+    std::stable_sort(experts.begin(), experts.end(), [&](int a, int b) { return probs[a] > probs[b]; });
+    float selected_sum = 0.0f;
+    for (int j = 0; j < top_k; j++) {
+      selected_sum += probs[experts[j]] / sum;
+    }
+
+    const float* x = input.data() + row * hidden_size;
+    for (int j = 0; j < top_k; j++) {
+      const int e = experts[j];
+      const float weight = probs[e] / sum / (normalize_routing_weights ? selected_sum : 1.0f);
+      std::vector<float> hidden(inter_size);
+      for (int i = 0; i < inter_size; i++) {
+        float h = fc1_experts_bias[e * inter_size + i];
+        float gate = 0.0f;
+        for (int k = 0; k < hidden_size; k++) {
+          h += x[k] * fc1[(static_cast<size_t>(e) * hidden_size + k) * inter_size + i];
+          gate += x[k] * fc3[(static_cast<size_t>(e) * hidden_size + k) * inter_size + i];
+        }
+        if (activation_type == "relu") {
+          h = std::max(h, 0.0f);
+        } else if (activation_type == "gelu") {
+          h = 0.5f * h * (1.0f + std::tanh(0.7978845608f * (h + 0.044715f * h * h * h)));
+        } else if (activation_type == "silu") {
+          h = h / (1.0f + std::exp(-h));
+        }
+        hidden[i] = use_fc3 ? h * gate : h;
+      }
+      for (int o = 0; o < hidden_size; o++) {
+        float y = fc2_experts_bias[e * hidden_size + o];
+        for (int i = 0; i < inter_size; i++) {
+          y += hidden[i] * fc2[(static_cast<size_t>(e) * inter_size + i) * hidden_size + o];
+        }
+        output[static_cast<size_t>(row) * hidden_size + o] += weight * y;
+      }
+    }
+  }
+
+  OpTester tester("QMoE", 1, onnxruntime::kMSDomain);
+  tester.AddAttribute<int64_t>("k", static_cast<int64_t>(top_k));
+  tester.AddAttribute<std::string>("activation_type", activation_type);
+  tester.AddAttribute<int64_t>("normalize_routing_weights", normalize_routing_weights ? 1 : 0);
+  tester.AddAttribute<int64_t>("expert_weight_bits", static_cast<int64_t>(bits));
+
+  tester.AddInput<float>("input", input_dims, input);
+  tester.AddInput<float>("router_probs", router_probs_dims, router_probs);
+  tester.AddInput<uint8_t>("fc1_experts_weights", fc1_experts_weights_dims, fc1_experts_weights,
+                           weights_are_initializers);
+  tester.AddInput<float>("fc1_scales", fc1_dims, fc1_scales, weights_are_initializers);
+  tester.AddInput<float>("fc1_experts_bias", fc1_dims, fc1_experts_bias);
+  tester.AddInput<uint8_t>("fc2_experts_weights", fc2_experts_weights_dims, fc2_experts_weights,
+                           weights_are_initializers);
+  tester.AddInput<float>("fc2_scales", fc2_dims, fc2_scales, weights_are_initializers);
+  tester.AddInput<float>("fc2_experts_bias", fc2_dims, fc2_experts_bias);
+  if (use_fc3) {
+    tester.AddInput<uint8_t>("fc3_experts_weights", fc1_experts_weights_dims, fc3_experts_weights,
+                             weights_are_initializers);
+    tester.AddInput<float>("fc3_scales", fc1_dims, fc3_scales, weights_are_initializers);
+  }
+  tester.AddOutput<float>("output", input_dims, output);
+  tester.SetOutputTolerance(0.001f);
+
+  std::vector<std::unique_ptr<IExecutionProvider>> execution_providers;
+  execution_providers.push_back(DefaultCpuExecutionProvider());
+  tester.Run(OpTester::ExpectResult::kExpectSuccess, "", {}, nullptr, &execution_providers);
+}
+
+TEST(MoETest, QMoETest_Cpu_Int4) {
+  RunQMoECpuTest(9, 4, 64, 32, 1, "relu", 4, false, false, true);
+  RunQMoECpuTest(9, 4, 64, 32, 1, "relu", 4, false, false, false);
+  RunQMoECpuTest(33, 8, 48, 96, 2, "gelu", 4, true, false, true);
+  RunQMoECpuTest(33, 8, 48, 96, 2, "silu", 4, true, true, true);
+  RunQMoECpuTest(17, 8, 32, 64, 2, "silu", 4, false, true, false);
+}
+
+TEST(MoETest, QMoETest_Cpu_Int8) {
+  RunQMoECpuTest(9, 4, 32, 16, 1, "identity", 8, false, false, true);
+  RunQMoECpuTest(33, 8, 48, 96, 2, "silu", 8, true, true, true);
+  RunQMoECpuTest(17, 8, 32, 64, 2, "gelu", 8, false, true, false);
+}
 #endif
 
 }  // namespace test
@@ -0,0 +1,123 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <memory>
+#include <vector>
+#include "gtest/gtest.h"
+#include "core/framework/allocator.h"
+#include "core/framework/tensor.h"
+#include "contrib_ops/cpu/transformers/prefix_cache.h"
+
+using onnxruntime::contrib::transformers::PrefixCache;
+
+namespace onnxruntime {
+namespace test {
+
+namespace {
+
+// Present state of one layer, of num_elements floats.
+std::vector<OrtValue> CreatePresent(int64_t num_elements) {
+  OrtValue state;
+  Tensor::InitOrtValue(DataTypeImpl::GetType<float>(), TensorShape({num_elements}),
+                       std::make_shared<CPUAllocator>(), state);
+  return {state};
+}
+
+const void* PresentData(const std::vector<OrtValue>& present) {
+  return present.empty() ? nullptr : present[0].Get<Tensor>().DataRaw();
+}
+
+}  // namespace
+
+TEST(PrefixCacheTest, LookupLongestPrefix) {
+  PrefixCache cache(1024);
+  auto present = CreatePresent(4);
+  cache.Insert(std::vector<int32_t>{1, 2, 3, 4}, present);
+  EXPECT_EQ(cache.SizeInBytes(), 16U);
+
+  std::vector<OrtValue> found;
+  EXPECT_EQ(cache.Lookup(std::vector<int32_t>{1, 2, 3, 9}, 4, found), 3);
+  EXPECT_EQ(PresentData(found), PresentData(present));
+
+  // The prefix is at most max_prefix_length tokens.
+  EXPECT_EQ(cache.Lookup(std::vector<int32_t>{1, 2, 3, 4}, 2, found), 2);
+  EXPECT_EQ(cache.Lookup(std::vector<int32_t>{1, 2, 3, 4, 5}, 5, found), 4);
+
+  std::vector<OrtValue> not_found;
+  EXPECT_EQ(cache.Lookup(std::vector<int32_t>{2, 3}, 2, not_found), 0);
+  EXPECT_TRUE(not_found.empty());
+}
+
+TEST(PrefixCacheTest, InsertPrefixOfCachedSequence) {
+  PrefixCache cache(1024);
+  auto present = CreatePresent(4);
+  cache.Insert(std::vector<int32_t>{1, 2, 3, 4}, present);
+
+  // A sequence that starts a cached sequence is already cached.
+  cache.Insert(std::vector<int32_t>{1, 2}, CreatePresent(2));
+  EXPECT_EQ(cache.SizeInBytes(), 16U);
+
+  std::vector<OrtValue> found;
+  EXPECT_EQ(cache.Lookup(std::vector<int32_t>{1, 2}, 2, found), 2);
+  EXPECT_EQ(PresentData(found), PresentData(present));
+}
+
+TEST(PrefixCacheTest, InsertReplacesCachedPrefix) {
+  PrefixCache cache(1024);
+  cache.Insert(std::vector<int32_t>{1, 2}, CreatePresent(2));
+  auto present = CreatePresent(3);
+  cache.Insert(std::vector<int32_t>{1, 2, 3}, present);
+  EXPECT_EQ(cache.SizeInBytes(), 12U);
+
+  std::vector<OrtValue> found;
+  EXPECT_EQ(cache.Lookup(std::vector<int32_t>{1, 2}, 2, found), 2);
+  EXPECT_EQ(PresentData(found), PresentData(present));
+}
+
+TEST(PrefixCacheTest, EvictLeastRecentlyUsed) {
+  // Room for two sequences of 4 floats.
+  PrefixCache cache(32);
+  auto present_1 = CreatePresent(4);
+  auto present_2 = CreatePresent(4);
+  cache.Insert(std::vector<int32_t>{1}, present_1);
+  cache.Insert(std::vector<int32_t>{2}, present_2);
+
+  // The lookup makes {1} more recent than {2}, so {2} is evicted.
+  std::vector<OrtValue> found;
+  EXPECT_EQ(cache.Lookup(std::vector<int32_t>{1}, 1, found), 1);
+  auto present_3 = CreatePresent(4);
+  cache.Insert(std::vector<int32_t>{3}, present_3);
+  EXPECT_EQ(cache.SizeInBytes(), 32U);
+
+  EXPECT_EQ(cache.Lookup(std::vector<int32_t>{2}, 1, found), 0);
+  EXPECT_EQ(cache.Lookup(std::vector<int32_t>{1}, 1, found), 1);
+  EXPECT_EQ(PresentData(found), PresentData(present_1));
+  EXPECT_EQ(cache.Lookup(std::vector<int32_t>{3}, 1, found), 1);
+  EXPECT_EQ(PresentData(found), PresentData(present_3));
+
+  // A sequence larger than the capacity is not cached.
+  cache.Insert(std::vector<int32_t>{4}, CreatePresent(9));
+  EXPECT_EQ(cache.SizeInBytes(), 32U);
+  EXPECT_EQ(cache.Lookup(std::vector<int32_t>{4}, 1, found), 0);
+}
+
+TEST(PrefixCacheTest, EraseKeepsSharedPrefixes) {
+  // Room for two sequences of 4 floats.
+  PrefixCache cache(32);
+  auto present_1 = CreatePresent(4);
+  cache.Insert(std::vector<int32_t>{1, 2, 3}, present_1);
+  cache.Insert(std::vector<int32_t>{1, 2, 4}, CreatePresent(4));
+
+  // {1, 2, 4} maps the prefixes {1} and {1, 2} shared with {1, 2, 3}. When it is evicted, they shall map to
+  // {1, 2, 3} again.
+  std::vector<OrtValue> found;
+  EXPECT_EQ(cache.Lookup(std::vector<int32_t>{1, 2, 3}, 3, found), 3);
+  cache.Insert(std::vector<int32_t>{5}, CreatePresent(4));
+  EXPECT_EQ(cache.Lookup(std::vector<int32_t>{1, 2, 4}, 3, found), 2);
+  EXPECT_EQ(PresentData(found), PresentData(present_1));
+  EXPECT_EQ(cache.Lookup(std::vector<int32_t>{1, 9}, 2, found), 1);
+  EXPECT_EQ(PresentData(found), PresentData(present_1));
+}
+
+}  // namespace test
+}  // namespace onnxruntime
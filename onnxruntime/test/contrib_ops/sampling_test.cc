@@ -2,11 +2,14 @@
 // Licensed under the MIT License.
 
 #include <memory>
+#include <string>
 #include <vector>
 #include "gtest/gtest.h"
 #include <gsl/gsl>
+#include "core/graph/model.h"
 #include "core/session/onnxruntime_cxx_api.h"
 #include "test/common/cuda_op_test_utils.h"
+#include "test/util/include/asserts.h"
 
 #ifdef USE_CUDA
 #include "core/providers/cuda/cuda_provider_options.h"
@@ -162,6 +165,109 @@ TEST(SamplingTest, Gpt2Sampling_CPU) {
 
   ASSERT_TRUE(std::equal(expected_output.cbegin(), expected_output.cend(), result_span.begin(), result_span.end()));
 }
+
+TEST(SamplingTest, Gpt2Sampling_CPU_SpeculativeDecoding) {
+  std::vector<int32_t> input_ids{
+      0, 0, 0, 0, 0, 52, 195, 731, 321, 301, 734, 620,
+      41, 554, 74, 622, 206, 222, 75, 223, 221, 198, 224, 572,
+      0, 0, 0, 52, 328, 219, 328, 206, 288, 227, 896, 328};
+
+  std::vector<int32_t> max_length{15};
+  std::vector<int32_t> min_length{1};
+  std::vector<float> repetition_penalty{1.0f};
+
+  std::vector<int64_t> input_ids_shape{3, 12};
+  std::vector<int64_t> parameter_shape{1};
+
+  const char* input_names[] = {"input_ids", "max_length", "min_length", "repetition_penalty"};
+  const char* const output_names[] = {"sequences"};
+
+  ONNX_NAMESPACE::ModelProto sampling_model_proto;
+  ASSERT_STATUS_OK(Model::Load(ORT_TSTR("testdata/transformers/tiny_gpt2_sampling.onnx"), sampling_model_proto));
+
+  // A draft decoder shall not change the distribution of the sampled sequences. The sequences themselves only match
+  // the ones sampled without draft decoder when sampling is deterministic, since accepting a proposed token takes
+  // a random number. So top_p is small enough to keep only the most likely token: a proposed token is accepted when
+  // it is that token (p / q >= 1), and otherwise rejected (p = 0) and replaced by the token sampled from
+  // max(p - q, 0), which is that token again.
+  enum class Draft { kNone, kDecoder, kPerturbedDecoder };
+  auto create_model = [&](Draft draft) {
+    ONNX_NAMESPACE::ModelProto model_proto = sampling_model_proto;
+    auto* node = model_proto.mutable_graph()->mutable_node(0);
+    ONNX_NAMESPACE::GraphProto draft_graph;
+    for (auto& attribute : *node->mutable_attribute()) {
+      if (attribute.name() == "top_p") {
+        attribute.set_f(1e-6f);
+      } else if (attribute.name() == "decoder") {
+        draft_graph = attribute.g();
+      }
+    }
+
+    if (draft == Draft::kNone) {
+      return model_proto.SerializeAsString();
+    }
+
+    // The perturbed draft decoder is the decoder with the weight of its last MLP projection negated.
+    if (draft == Draft::kPerturbedDecoder) {
+      for (auto& initializer : *draft_graph.mutable_initializer()) {
+        if (initializer.name() == "transformer.h.4.mlp.c_proj.weight") {
+          // raw data is little endian, so the sign bit of a float is in its last byte
+          std::string& raw_data = *initializer.mutable_raw_data();
+          for (size_t i = 3; i < raw_data.size(); i += 4) {
+            raw_data[i] = static_cast<char>(raw_data[i] ^ 0x80);
+          }
+        }
+      }
+    }
+
+    auto* draft_decoder = node->add_attribute();
+    draft_decoder->set_name("draft_decoder");
+    draft_decoder->set_type(ONNX_NAMESPACE::AttributeProto_AttributeType_GRAPH);
+    *draft_decoder->mutable_g() = std::move(draft_graph);
+
+    auto* num_draft_tokens = node->add_attribute();
+    num_draft_tokens->set_name("num_draft_tokens");
+    num_draft_tokens->set_type(ONNX_NAMESPACE::AttributeProto_AttributeType_INT);
+    num_draft_tokens->set_i(3);
+
+    return model_proto.SerializeAsString();
+  };
+
+  auto run = [&](const std::string& model_data) {
+    Ort::MemoryInfo info("Cpu", OrtDeviceAllocator, 0, OrtMemTypeDefault);
+    std::vector<Ort::Value> ort_inputs;
+    ort_inputs.push_back(Ort::Value::CreateTensor(
+        info, input_ids.data(), input_ids.size(), input_ids_shape.data(), input_ids_shape.size()));
+    ort_inputs.push_back(Ort::Value::CreateTensor(
+        info, max_length.data(), max_length.size(), parameter_shape.data(), parameter_shape.size()));
+    ort_inputs.push_back(Ort::Value::CreateTensor(
+        info, min_length.data(), min_length.size(), parameter_shape.data(), parameter_shape.size()));
+    ort_inputs.push_back(Ort::Value::CreateTensor(
+        info, repetition_penalty.data(), repetition_penalty.size(), parameter_shape.data(), parameter_shape.size()));
+
+    Ort::SessionOptions session_options;
+    Ort::Session session(*ort_env, model_data.data(), model_data.size(), session_options);
+    auto ort_outputs = session.Run(Ort::RunOptions{}, input_names, ort_inputs.data(), ort_inputs.size(),
+                                   output_names, 1);
+    EXPECT_EQ(ort_outputs.size(), 1U);
+
+    auto result_ts = ort_outputs[0].GetTensorTypeAndShapeInfo();
+    EXPECT_EQ(ONNX_TENSOR_ELEMENT_DATA_TYPE_INT32, result_ts.GetElementType());
+    EXPECT_EQ((std::vector<int64_t>{input_ids_shape[0], max_length[0]}), result_ts.GetShape());
+
+    const auto* result_vals = ort_outputs[0].GetTensorData<int32_t>();
+    return std::vector<int32_t>(result_vals, result_vals + result_ts.GetElementCount());
+  };
+
+  auto expected_output = run(create_model(Draft::kNone));
+
+  // The decoder itself as draft decoder proposes tokens sampled from the same logits.
+  EXPECT_EQ(expected_output, run(create_model(Draft::kDecoder)));
+
+  // The perturbed draft decoder proposes other tokens, so that more of them are rejected and resampled from
+  // the residual.
+  EXPECT_EQ(expected_output, run(create_model(Draft::kPerturbedDecoder)));
+}
 #endif
 }  // namespace test
 }  // namespace onnxruntime
@@ -8,6 +8,7 @@
 #include "core/graph/model.h"
 #include "core/providers/cpu/cpu_execution_provider.h"
 #include "core/session/inference_session.h"
+#include "core/session/onnxruntime_session_options_config_keys.h"
 #include "test_utils.h"
 #include "test/test_environment.h"
 #include "test/framework/TestAllocatorManager.h"
@@ -458,6 +459,100 @@ TEST_F(ExecutionFrameTest, MemPatternWithExternalOutputsTest) {
 }
 #endif
 
+// Create a model with a dynamic sequence length and two intermediate values.
+// Y = 2 * X * X - 2 * X
+static void CreateDynamicSequenceModel(std::string& model_data) {
+  onnxruntime::Model model("dynamic_sequence", false, ModelMetaData(), PathString(),
+                           IOnnxRuntimeOpSchemaRegistryList(), {{kOnnxDomain, 13}}, {},
+                           DefaultLoggingManager().DefaultLogger());
+  auto& graph = model.MainGraph();
+
+  TypeProto float_tensor;
+  float_tensor.mutable_tensor_type()->set_elem_type(TensorProto_DataType_FLOAT);
+  float_tensor.mutable_tensor_type()->mutable_shape()->add_dim()->set_dim_value(1);
+  float_tensor.mutable_tensor_type()->mutable_shape()->add_dim()->set_dim_param("sequence");
+
+  auto& x = graph.GetOrCreateNodeArg("X", &float_tensor);
+  auto& add_out = graph.GetOrCreateNodeArg("add_out", &float_tensor);
+  auto& mul_out = graph.GetOrCreateNodeArg("mul_out", &float_tensor);
+  auto& y = graph.GetOrCreateNodeArg("Y", &float_tensor);
+  graph.AddNode("add", "Add", "", {&x, &x}, {&add_out});
+  graph.AddNode("mul", "Mul", "", {&add_out, &x}, {&mul_out});
+  graph.AddNode("sub", "Sub", "", {&mul_out, &add_out}, {&y});
+
+  ASSERT_STATUS_OK(graph.Resolve());
+  ASSERT_TRUE(model.ToProto().SerializeToString(&model_data));
+}
+
+// Run the model once for each sequence length and return the hits and misses of the memory pattern cache.
+static void RunDynamicSequenceModel(const SessionOptions& so, const std::vector<int64_t>& sequence_lengths,
+                                    size_t& num_hits, size_t& num_misses) {
+  std::string model_data;
+  CreateDynamicSequenceModel(model_data);
+
+  InferenceSessionWrapper session{so, GetEnvironment()};
+  ASSERT_STATUS_OK(session.Load(model_data.data(), static_cast<int>(model_data.size())));
+  ASSERT_STATUS_OK(session.Initialize());
+  ASSERT_TRUE(session.GetSessionState().GetEnableMemoryPattern());
+
+  for (int64_t sequence_length : sequence_lengths) {
+    std::vector<float> x_values(static_cast<size_t>(sequence_length));
+    std::vector<float> expected(x_values.size());
+    for (size_t i = 0; i < x_values.size(); ++i) {
+      x_values[i] = static_cast<float>(i % 7) - 3.0f;
+      expected[i] = 2.0f * x_values[i] * x_values[i] - 2.0f * x_values[i];
+    }
+
+    OrtValue x;
+    const std::vector<int64_t> x_dims{1, sequence_length};
+    CreateMLValue<float>(TestCPUExecutionProvider()->CreatePreferredAllocators()[0], x_dims, x_values, &x);
+    std::vector<OrtValue> fetches;
+    ASSERT_STATUS_OK(session.Run(RunOptions{}, AsSpan({std::string("X")}), AsSpan({x}),
+                                 AsSpan({std::string("Y")}), &fetches, nullptr));
+    ASSERT_EQ(fetches.size(), 1u);
+    EXPECT_THAT(fetches[0].Get<Tensor>().DataAsSpan<float>(), ::testing::ContainerEq(gsl::make_span(expected)));
+  }
+
+  session.GetSessionState().GetMemoryPatternCacheStats(num_hits, num_misses);
+}
+
+TEST(ExecutionFrameTestMemPatternCache, ExactShapes) {
+  SessionOptions so;
+  so.graph_optimization_level = TransformerLevel::Default;
+
+  size_t num_hits = 0, num_misses = 0;
+  RunDynamicSequenceModel(so, {100, 120, 100, 110}, num_hits, num_misses);
+  EXPECT_EQ(num_hits, 1u);
+  EXPECT_EQ(num_misses, 3u);
+}
+
+TEST(ExecutionFrameTestMemPatternCache, ShapeBuckets) {
+  SessionOptions so;
+  so.graph_optimization_level = TransformerLevel::Default;
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsMemoryPatternShapeBuckets, "1"));
+
+  // all the sequence lengths are in the bucket of 128.
+  // the first run traces the pattern, the intermediate values of the second one do not fit into it. the third run
+  // traces a pattern that fits both, which all the later runs of the bucket use.
+  size_t num_hits = 0, num_misses = 0;
+  RunDynamicSequenceModel(so, {100, 120, 110, 90, 128, 65}, num_hits, num_misses);
+  EXPECT_EQ(num_hits, 4u);
+  EXPECT_EQ(num_misses, 2u);
+}
+
+TEST(ExecutionFrameTestMemPatternCache, Capacity) {
+  SessionOptions so;
+  so.graph_optimization_level = TransformerLevel::Default;
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsMemoryPatternShapeBuckets, "1"));
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsMemoryPatternCacheCapacity, "1"));
+
+  // the pattern of the bucket of 128 is evicted by the one of the bucket of 512
+  size_t num_hits = 0, num_misses = 0;
+  RunDynamicSequenceModel(so, {100, 300, 300, 100}, num_hits, num_misses);
+  EXPECT_EQ(num_hits, 1u);
+  EXPECT_EQ(num_misses, 3u);
+}
+
 TEST(ExecutionFrameTestWithoutSessionState, BadModelInvalidDimParamUsage) {
   // Model that has 2 inputs with shape {'Symbolic', 'Symbolic'} that is carefully constructed to re-use a
   // buffer the size of one input for output the size of the other input.
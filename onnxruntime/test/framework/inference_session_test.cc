@@ -28,6 +28,7 @@
 #include "core/framework/bfc_arena.h"
 #include "core/graph/graph_viewer.h"
 #include "core/graph/model.h"
+#include "core/graph/model_saving_options.h"
 #include "core/graph/op.h"
 #include "core/optimizer/rule_based_graph_transformer.h"
 #include "core/platform/env.h"
@@ -58,6 +59,7 @@
 #include "test/optimizer/dummy_graph_transformer.h"
 #include "test/util/include/default_providers.h"
 #include "test/util/include/inference_session_wrapper.h"
+#include "test/util/include/temp_dir.h"
 
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
@@ -564,6 +566,75 @@ TEST(InferenceSessionTests, TestModelSerialization) {
   ASSERT_TRUE(session_object_emptyValidation.Initialize().IsOK());
 }
 
+TEST(InferenceSessionTests, CompiledModelCache) {
+  const test::TemporaryDirectory cache_dir{ORT_TSTR("compiled_model_cache_test")};
+  const std::string test_model = "testdata/transform/abs-id-max.onnx";
+
+  auto get_cache_entries = [&cache_dir]() {
+    std::vector<std::filesystem::path> entries;
+    for (const auto& entry : std::filesystem::directory_iterator(cache_dir.Path())) {
+      entries.push_back(entry.path());
+    }
+    return entries;
+  };
+
+  // create the session with a sink that captures the log messages to see whether the cache was hit
+  auto create_session = [&](TransformerLevel level, bool& cache_hit) {
+    SessionOptions so;
+    so.session_logid = "InferenceSessionTests.CompiledModelCache";
+    so.graph_optimization_level = level;
+    EXPECT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsCompiledModelCacheDir,
+                                                      ToUTF8String(cache_dir.Path()).c_str()));
+
+    auto capturing_sink = new CapturingSink();
+    auto logging_manager = std::make_unique<logging::LoggingManager>(
+        std::unique_ptr<ISink>(capturing_sink), logging::Severity::kINFO, false,
+        LoggingManager::InstanceType::Temporal);
+    std::unique_ptr<Environment> env;
+    EXPECT_STATUS_OK(Environment::Create(std::move(logging_manager), env));
+
+    InferenceSessionWrapper session_object{so, *env};
+    EXPECT_STATUS_OK(session_object.Load(test_model));
+    EXPECT_STATUS_OK(session_object.Initialize());
+
+    const auto& msgs = capturing_sink->Messages();
+    cache_hit = std::any_of(msgs.begin(), msgs.end(), [](const std::string& msg) {
+      return msg.find("Compiled model cache hit") != std::string::npos;
+    });
+
+    return CountOpsInGraph(session_object.GetGraph())["Identity"];
+  };
+
+  bool cache_hit = false;
+  ASSERT_EQ(create_session(TransformerLevel::Level1, cache_hit), 0);
+  ASSERT_FALSE(cache_hit);
+  auto entries = get_cache_entries();
+  ASSERT_EQ(entries.size(), 1u);
+  EXPECT_EQ(entries[0].extension(), ".ort");
+
+  // the second session loads the optimized model from the cache
+  ASSERT_EQ(create_session(TransformerLevel::Level1, cache_hit), 0);
+  ASSERT_TRUE(cache_hit);
+  ASSERT_EQ(get_cache_entries().size(), 1u);
+
+  // different session options result in a different entry
+  ASSERT_GT(create_session(TransformerLevel::Default, cache_hit), 0);
+  ASSERT_FALSE(cache_hit);
+  ASSERT_EQ(get_cache_entries().size(), 2u);
+
+  // an invalid entry is replaced
+  {
+    std::ofstream entry_file(entries[0], std::ios::binary | std::ios::trunc);
+    entry_file << "not an ORT format model";
+  }
+
+  ASSERT_EQ(create_session(TransformerLevel::Level1, cache_hit), 0);
+  ASSERT_FALSE(cache_hit);
+  ASSERT_EQ(create_session(TransformerLevel::Level1, cache_hit), 0);
+  ASSERT_TRUE(cache_hit);
+  ASSERT_EQ(get_cache_entries().size(), 2u);
+}
+
 TEST(InferenceSessionTests, RequestLoadCancellation) {
   {
     // Explicit cancel during load, small model is fine
@@ -838,6 +909,53 @@ TEST(InferenceSessionTests, CheckRunProfilerWithSessionOptions2) {
 #endif
 }
 
+TEST(InferenceSessionTests, CheckMetrics) {
+  SessionOptions so;
+  so.session_logid = "CheckMetrics";
+
+  {
+    // metrics are disabled by default
+    InferenceSession session_object(so, GetEnvironment());
+    ASSERT_STATUS_OK(session_object.Load(MODEL_URI));
+    ASSERT_STATUS_OK(session_object.Initialize());
+    std::vector<std::pair<std::string, std::string>> snapshot;
+    ASSERT_FALSE(session_object.GetMetricsSnapshot(snapshot).IsOK());
+  }
+
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsEnableMetrics, "1"));
+  InferenceSession session_object(so, GetEnvironment());
+  ASSERT_STATUS_OK(session_object.Load(MODEL_URI));
+  ASSERT_STATUS_OK(session_object.Initialize());
+
+  RunOptions run_options;
+  RunModel(session_object, run_options);
+  RunModel(session_object, run_options);
+
+  std::vector<std::pair<std::string, std::string>> snapshot;
+  ASSERT_STATUS_OK(session_object.GetMetricsSnapshot(snapshot));
+  std::unordered_map<std::string, std::string> metrics(snapshot.begin(), snapshot.end());
+
+  ASSERT_EQ(metrics["run.latency.count"], "2");
+  ASSERT_GT(std::stoull(metrics["run.latency.p50_ns"]), 0u);
+  ASSERT_LE(std::stoull(metrics["run.latency.p50_ns"]), std::stoull(metrics["run.latency.p99_ns"]));
+
+  // the model has a single Mul node
+  std::string node_prefix;
+  for (const auto& [key, value] : snapshot) {
+    if (value == "Mul" && key.size() > 8 && key.compare(key.size() - 8, 8, ".op_type") == 0) {
+      node_prefix = key.substr(0, key.size() - 8);
+    }
+  }
+
+  ASSERT_FALSE(node_prefix.empty());
+  ASSERT_EQ(metrics[node_prefix + ".latency.count"], "2");
+  ASSERT_LE(std::stoull(metrics[node_prefix + ".latency.sum_ns"]), std::stoull(metrics["run.latency.sum_ns"]));
+
+  // the output of the model is allocated by every run
+  ASSERT_GE(std::stoull(metrics["frame.dynamic_allocations"]), 2u);
+  ASSERT_EQ(metrics.count("thread_pool.intra_op.queue_depth"), 1u);
+}
+
 TEST(InferenceSessionTests, CheckRunProfilerWithStartProfile) {
   SessionOptions so;
 
@@ -3021,6 +3139,56 @@ TEST(InferenceSessionTests, InitializerSharing_EnsureSessionsUseUserAddedInitial
   }
 }
 
+#if !defined(__wasm__)
+// The sessions that map the model files share a single mapping of the external data file.
+TEST(InferenceSessionTests, MapModelFilesSharesExternalData) {
+  const test::TemporaryDirectory model_dir{ORT_TSTR("map_model_files_test")};
+  const std::filesystem::path model_path = std::filesystem::path(model_dir.Path()) / "mul_1_external_data.onnx";
+  {
+    std::shared_ptr<Model> model;
+    ASSERT_STATUS_OK(Model::Load(MODEL_URI, model, nullptr, DefaultLoggingManager().DefaultLogger()));
+    // every initializer is saved to the external data file
+    ASSERT_STATUS_OK(Model::SaveWithExternalInitializers(*model, model_path, "mul_1_external_data.bin",
+                                                         ModelSavingOptions{0}));
+  }
+
+  const auto get_initializer_data = [](InferenceSessionWrapper& session) -> const float* {
+    int idx;
+    ORT_THROW_IF_ERROR(session.GetSessionState().GetOrtValueNameIdxMap().GetIdx("W", idx));
+    return session.GetSessionState().GetInitializedTensors().at(idx).Get<Tensor>().Data<float>();
+  };
+
+  SessionOptions so;
+  so.graph_optimization_level = TransformerLevel::Default;
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsConfigMapModelFiles, "1"));
+
+  InferenceSessionWrapper session_1{so, GetEnvironment()};
+  ASSERT_STATUS_OK(session_1.Load(model_path.native()));
+  ASSERT_STATUS_OK(session_1.Initialize());
+
+  InferenceSessionWrapper session_2{so, GetEnvironment()};
+  ASSERT_STATUS_OK(session_2.Load(model_path.native()));
+  ASSERT_STATUS_OK(session_2.Initialize());
+
+  // the initializers of both sessions are views into the same mapping of the file
+  ASSERT_EQ(get_initializer_data(session_1), get_initializer_data(session_2));
+
+  RunOptions run_options;
+  RunModel(session_1, run_options);
+  RunModel(session_2, run_options);
+
+  // without the option every session maps the data of its own initializers
+  SessionOptions so_not_mapped;
+  so_not_mapped.graph_optimization_level = TransformerLevel::Default;
+  InferenceSessionWrapper session_3{so_not_mapped, GetEnvironment()};
+  ASSERT_STATUS_OK(session_3.Load(model_path.native()));
+  ASSERT_STATUS_OK(session_3.Initialize());
+
+  ASSERT_NE(get_initializer_data(session_3), get_initializer_data(session_1));
+  RunModel(session_3, run_options);
+}
+#endif
+
 void RunModelWithDenormalAsZero(InferenceSession& session_object,
                                 const RunOptions& run_options,
                                 bool set_denormal_as_zero) {
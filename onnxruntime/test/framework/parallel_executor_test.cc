@@ -3,11 +3,16 @@
 
 #include "core/framework/data_types.h"
 #include "core/framework/op_kernel.h"
+#include "core/graph/model.h"
+#include "core/session/onnxruntime_session_options_config_keys.h"
 #include "test/providers/provider_test_utils.h"
+#include "test/test_environment.h"
+#include "test/util/include/inference_session_wrapper.h"
 #include "test_utils.h"
 #include "core/session/inference_session.h"
 
 #include "gtest/gtest.h"
+#include "gmock/gmock.h"
 
 using namespace ONNX_NAMESPACE;
 using namespace onnxruntime::common;
@@ -145,5 +150,136 @@ TEST_P(ParallelExecutorThreadPoolTest, TestNullInterOpThreadPool) {
 
 INSTANTIATE_TEST_SUITE_P(ParallelExecutorThreadPoolTests, ParallelExecutorThreadPoolTest,
                          testing::Values(1, 0));
+
+// test that the status from TestOp is correctly returned when the nodes are run by the dataflow executor
+TEST(DataflowExecutor, TestStatusPropagation) {
+  auto registry = std::make_shared<CustomRegistry>();
+  std::vector<OpSchema> schemas{TestOp::OpSchema()};
+  Status status;
+  ASSERT_TRUE((status = registry->RegisterOpSet(schemas, TestOp::OpDomain, 10, 11)).IsOK()) << status;
+  KernelCreateFn kernel_create_fn = [](FuncManager&, const OpKernelInfo& info, std::unique_ptr<OpKernel>& out) { out = std::make_unique<typename TestOp::OpKernelImpl>(info); return Status::OK(); };
+  auto kernel_def = TestOp::KernelDef();
+  ASSERT_TRUE((status = registry->RegisterCustomKernel(kernel_def, kernel_create_fn)).IsOK()) << status;
+
+  onnxruntime::SessionOptions so;
+  so.session_logid = "DataflowExecutor";
+  so.intra_op_param.thread_pool_size = 4;
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsEnableDataflowExecution, "1"));
+
+  {  // test success
+    OpTester tester{"TestOp", 10, TestOp::OpDomain};
+    tester.AddCustomOpRegistry(registry);
+
+    tester.AddInput<int64_t>("action", {1}, {/*success*/ 0});
+    tester.AddOutput<int64_t>("action_out", {1}, {0});
+    tester.Run(so, OpTester::ExpectResult::kExpectSuccess, {}, {kTensorrtExecutionProvider});
+  }
+
+  {  // test failure
+    OpTester tester{"TestOp", 10, TestOp::OpDomain};
+    tester.AddCustomOpRegistry(registry);
+
+    tester.AddInput<int64_t>("action", {1}, {/*failure*/ 1});
+    tester.AddOutput<int64_t>("action_out", {1}, {0});
+    tester.Run(so, OpTester::ExpectResult::kExpectFailure, "Action was 1", {kTensorrtExecutionProvider});
+  }
+
+  {  // test exception
+    OpTester tester{"TestOp", 10, TestOp::OpDomain};
+    tester.AddCustomOpRegistry(registry);
+
+    tester.AddInput<int64_t>("action", {1}, {/*exception*/ 2});
+    tester.AddOutput<int64_t>("action_out", {1}, {0});
+    tester.Run(so, OpTester::ExpectResult::kExpectFailure, "Throwing as action was 2", {kTensorrtExecutionProvider});
+  }
+}
+
+// Create a model with `num_branches` independent branches of Add -> Mul -> Sub that are summed up at the end.
+// Y = num_branches * (2 * X * X - 2 * X)
+static void CreateWideModel(int num_branches, std::string& model_data) {
+  onnxruntime::Model model("wide_graph", false, ModelMetaData(), PathString(), IOnnxRuntimeOpSchemaRegistryList(),
+                           {{kOnnxDomain, 13}}, {}, DefaultLoggingManager().DefaultLogger());
+  auto& graph = model.MainGraph();
+
+  TypeProto float_tensor;
+  float_tensor.mutable_tensor_type()->set_elem_type(TensorProto_DataType_FLOAT);
+  float_tensor.mutable_tensor_type()->mutable_shape()->add_dim()->set_dim_value(2);
+  float_tensor.mutable_tensor_type()->mutable_shape()->add_dim()->set_dim_value(3);
+
+  auto& x = graph.GetOrCreateNodeArg("X", &float_tensor);
+  std::vector<NodeArg*> branch_outputs;
+  for (int i = 0; i < num_branches; ++i) {
+    const std::string suffix = std::to_string(i);
+    auto& add_out = graph.GetOrCreateNodeArg("add_" + suffix, &float_tensor);
+    auto& mul_out = graph.GetOrCreateNodeArg("mul_" + suffix, &float_tensor);
+    auto& sub_out = graph.GetOrCreateNodeArg("sub_" + suffix, &float_tensor);
+    graph.AddNode("add_node_" + suffix, "Add", "", {&x, &x}, {&add_out});
+    graph.AddNode("mul_node_" + suffix, "Mul", "", {&add_out, &x}, {&mul_out});
+    graph.AddNode("sub_node_" + suffix, "Sub", "", {&mul_out, &add_out}, {&sub_out});
+    branch_outputs.push_back(&sub_out);
+  }
+
+  auto& y = graph.GetOrCreateNodeArg("Y", &float_tensor);
+  graph.AddNode("sum_node", "Sum", "", branch_outputs, {&y});
+
+  ASSERT_STATUS_OK(graph.Resolve());
+  ASSERT_TRUE(model.ToProto().SerializeToString(&model_data));
+}
+
+TEST(DataflowExecutor, RunIndependentBranches) {
+  constexpr int kNumBranches = 16;
+  std::string model_data;
+  CreateWideModel(kNumBranches, model_data);
+
+  SessionOptions so;
+  so.session_logid = "DataflowExecutor";
+  so.intra_op_param.thread_pool_size = 4;
+  // keep the identical branches apart
+  so.graph_optimization_level = TransformerLevel::Default;
+  ASSERT_STATUS_OK(so.config_options.AddConfigEntry(kOrtSessionOptionsEnableDataflowExecution, "1"));
+
+  InferenceSessionWrapper session{so, GetEnvironment()};
+  ASSERT_STATUS_OK(session.Load(model_data.data(), static_cast<int>(model_data.size())));
+  ASSERT_STATUS_OK(session.Initialize());
+
+  // all the nodes have been put in the dataflow plan, the branches only depend on the graph input
+  const auto& plan = *session.GetSessionState().GetExecutionPlan();
+  ASSERT_EQ(plan.dataflow_nodes.size(), static_cast<size_t>(kNumBranches * 3 + 1));
+  EXPECT_EQ(plan.dataflow_roots.size(), static_cast<size_t>(kNumBranches));
+  EXPECT_FALSE(session.GetSessionState().GetEnableMemoryPattern());
+
+  const std::vector<float> x_values = {-1.f, 0.f, 1.f, 2.f, 3.f, 4.f};
+  std::vector<float> expected_values;
+  for (float x : x_values) {
+    expected_values.push_back(kNumBranches * (2.f * x * x - 2.f * x));
+  }
+
+  OrtValue x;
+  CreateMLValue<float>(TestCPUExecutionProvider()->CreatePreferredAllocators()[0], std::vector<int64_t>{2, 3},
+                       x_values, &x);
+  NameMLValMap feeds{{"X", x}};
+
+  RunOptions run_options;
+  for (int i = 0; i < 10; ++i) {
+    std::vector<OrtValue> fetches;
+    ASSERT_STATUS_OK(session.Run(run_options, feeds, {"Y"}, &fetches));
+    ASSERT_EQ(fetches.size(), 1u);
+    const auto& y = fetches[0].Get<Tensor>();
+    ASSERT_EQ(y.Shape(), TensorShape({2, 3}));
+    EXPECT_THAT(y.DataAsSpan<float>(), ::testing::ElementsAreArray(expected_values));
+  }
+}
+
+TEST(DataflowExecutor, DisabledByDefault) {
+  std::string model_data;
+  CreateWideModel(2, model_data);
+
+  SessionOptions so;
+  so.graph_optimization_level = TransformerLevel::Default;
+  InferenceSessionWrapper session{so, GetEnvironment()};
+  ASSERT_STATUS_OK(session.Load(model_data.data(), static_cast<int>(model_data.size())));
+  ASSERT_STATUS_OK(session.Initialize());
+  EXPECT_TRUE(session.GetSessionState().GetExecutionPlan()->dataflow_nodes.empty());
+}
 }  // namespace test
 }  // namespace onnxruntime
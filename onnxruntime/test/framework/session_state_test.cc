@@ -1230,6 +1230,74 @@ TEST_F(SessionStateTestSharedInitalizersWithPrePacking, test4) {
   ASSERT_EQ(if_node_branches_shared_prepack_counter_2, static_cast<size_t>(2));
 }
 
+// Pre-packing enabled + shared pre-packed weights store of the env =
+// pre-packed weights of initializers that are not shared explicitly are shared by content
+TEST_F(SessionStateTestSharedInitalizersWithPrePacking, SharedPrepackedWeightsStore) {
+  SessionOptions sess_options;
+  sess_options.enable_mem_pattern = true;
+  sess_options.execution_mode = ExecutionMode::ORT_SEQUENTIAL;
+  sess_options.use_deterministic_compute = false;
+  sess_options.enable_mem_reuse = true;
+  // Enable pre-packing
+  sess_options.config_options.configurations[kOrtSessionOptionsConfigDisablePrepacking] = "0";
+
+  SharedPrepackedWeightsStore shared_prepacked_weights_store;
+
+  auto create_session_state = [&](Model& model) {
+    CreateSimpleGraph(model.MainGraph());
+    PlaceAllNodesToCPUEP(model.MainGraph());
+    auto session_state = std::make_unique<SessionState>(model.MainGraph(),
+                                                        execution_providers,
+                                                        tp.get(),
+                                                        nullptr, /*inter_op_thread_pool*/
+                                                        dtm,
+                                                        edlm,
+                                                        DefaultLoggingManager().DefaultLogger(),
+                                                        profiler,
+                                                        sess_options,
+                                                        nullptr, /*prepacked_weights_container*/
+                                                        nullptr, /*parent_allocators*/
+                                                        &shared_prepacked_weights_store);
+
+    EXPECT_STATUS_OK(session_state->FinalizeSessionState(std::basic_string<PATH_CHAR_TYPE>(),
+                                                         kernel_registry_manager));
+    return session_state;
+  };
+
+  // First session/model
+  Model model_1("graph_main", false, ModelMetaData(), PathString(), IOnnxRuntimeOpSchemaRegistryList(),
+                domain_to_version, std::vector<ONNX_NAMESPACE::FunctionProto>(),
+                DefaultLoggingManager().DefaultLogger());
+  auto session_state_1 = create_session_state(model_1);
+
+  const auto* kernel_1 = reinterpret_cast<const PrePackingTestOpKernel*>(session_state_1->GetKernel(0));
+  ASSERT_EQ(session_state_1->GetNumberOfPrepacksCounter(), static_cast<size_t>(1));
+  ASSERT_EQ(kernel_1->prepack_calls_count, 1);
+  ASSERT_EQ(kernel_1->store_pre_packed_weight_calls_count, 1);
+  ASSERT_EQ(session_state_1->GetUsedSharedPrePackedWeightCounter(), static_cast<size_t>(0));
+  ASSERT_EQ(shared_prepacked_weights_store.GetNumberOfElements(), static_cast<size_t>(1));
+
+  // Second session/model uses the pre-packed weight of the first one
+  Model model_2("graph_main", false, ModelMetaData(), PathString(), IOnnxRuntimeOpSchemaRegistryList(),
+                domain_to_version, std::vector<ONNX_NAMESPACE::FunctionProto>(),
+                DefaultLoggingManager().DefaultLogger());
+  auto session_state_2 = create_session_state(model_2);
+
+  const auto* kernel_2 = reinterpret_cast<const PrePackingTestOpKernel*>(session_state_2->GetKernel(0));
+  ASSERT_EQ(session_state_2->GetNumberOfPrepacksCounter(), static_cast<size_t>(1));
+  ASSERT_EQ(kernel_2->prepack_calls_count, 1);
+  ASSERT_EQ(kernel_2->store_pre_packed_weight_calls_count, 1);
+  ASSERT_EQ(session_state_2->GetUsedSharedPrePackedWeightCounter(), static_cast<size_t>(1));
+  ASSERT_EQ(kernel_1->weight_packed_.get(), kernel_2->weight_packed_.get());
+  ASSERT_EQ(shared_prepacked_weights_store.GetNumberOfElements(), static_cast<size_t>(1));
+
+  // the weight is freed with the last session that uses it
+  session_state_1.reset();
+  ASSERT_EQ(shared_prepacked_weights_store.GetNumberOfElements(), static_cast<size_t>(1));
+  session_state_2.reset();
+  ASSERT_EQ(shared_prepacked_weights_store.GetNumberOfElements(), static_cast<size_t>(0));
+}
+
 #ifndef __wasm__
 // sharing is on
 TEST_F(SessionStateTestSharedInitalizersWithPrePacking, TestPrepackedSerialization) {
@@ -0,0 +1,202 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "core/framework/allocator_utils.h"
+#include "core/framework/arena_extend_strategy.h"
+#include "core/framework/slab_arena.h"
+#include "gtest/gtest.h"
+
+namespace onnxruntime {
+namespace test {
+
+static AllocatorStats GetStats(SlabArena& a) {
+  AllocatorStats stats;
+  a.GetStats(&stats);
+  return stats;
+}
+
+TEST(SlabArenaTest, SizeClasses) {
+  EXPECT_EQ(SlabArena::SizeClassIndex(1), 0u);
+  EXPECT_EQ(SlabArena::SizeClassIndex(64), 0u);
+  EXPECT_EQ(SlabArena::SizeClassIndex(65), 1u);
+  EXPECT_EQ(SlabArena::SizeClassIndex(256), 3u);
+  EXPECT_EQ(SlabArena::SizeClassBlockSize(SlabArena::SizeClassIndex(257)), 320u);
+  EXPECT_EQ(SlabArena::SizeClassBlockSize(SlabArena::SizeClassIndex(512)), 512u);
+  EXPECT_EQ(SlabArena::SizeClassBlockSize(SlabArena::SizeClassIndex(513)), 640u);
+  EXPECT_EQ(SlabArena::SizeClassIndex(SlabArena::kMaxBlockSize), SlabArena::kNumSizeClasses - 1);
+  EXPECT_EQ(SlabArena::SizeClassIndex(SlabArena::kMaxBlockSize + 1), SlabArena::kNumSizeClasses);
+
+  // every size maps to the smallest class that can hold it and all classes keep blocks aligned
+  size_t prev_block_size = 0;
+  for (size_t i = 0; i < SlabArena::kNumSizeClasses; ++i) {
+    const size_t block_size = SlabArena::SizeClassBlockSize(i);
+    EXPECT_GT(block_size, prev_block_size);
+    EXPECT_EQ(block_size % SlabArena::kHeaderSize, 0u);
+    EXPECT_EQ(SlabArena::SizeClassIndex(block_size), i);
+    EXPECT_EQ(SlabArena::SizeClassIndex(prev_block_size + 1), i);
+    prev_block_size = block_size;
+  }
+}
+
+TEST(SlabArenaTest, NoDupsAndStats) {
+  SlabArena a(std::make_unique<CPUAllocator>(), 1 << 30);
+
+  std::vector<void*> ptrs;
+  int64_t expected_bytes_in_use = 0;
+  for (size_t s = 1; s < 1024; s++) {
+    void* raw = a.Alloc(s);
+    ASSERT_NE(raw, nullptr);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(raw) % 64, 0u);
+    memset(raw, 0xff, s);
+    ptrs.push_back(raw);
+    expected_bytes_in_use += static_cast<int64_t>(SlabArena::SizeClassBlockSize(SlabArena::SizeClassIndex(s)));
+  }
+
+  auto stats = GetStats(a);
+  EXPECT_EQ(stats.num_allocs, 1023);
+  EXPECT_EQ(stats.bytes_in_use, expected_bytes_in_use);
+  EXPECT_GE(stats.max_bytes_in_use, expected_bytes_in_use);
+  EXPECT_EQ(stats.max_alloc_size, 1023);
+  EXPECT_GE(stats.total_allocated_bytes, expected_bytes_in_use);
+  EXPECT_EQ(stats.bytes_limit, 1 << 30);
+
+  std::vector<void*> sorted = ptrs;
+  std::sort(sorted.begin(), sorted.end());
+  EXPECT_EQ(std::adjacent_find(sorted.begin(), sorted.end()), sorted.end());
+
+  for (void* p : ptrs) {
+    a.Free(p);
+  }
+
+  stats = GetStats(a);
+  EXPECT_EQ(stats.bytes_in_use, 0);
+  EXPECT_GE(stats.max_bytes_in_use, expected_bytes_in_use);
+}
+
+TEST(SlabArenaTest, ReusesFreedBlocks) {
+  SlabArena a(std::make_unique<CPUAllocator>());
+
+  void* p1 = a.Alloc(1000);
+  a.Free(p1);
+  void* p2 = a.Alloc(1000);
+  EXPECT_EQ(p1, p2);
+  a.Free(p2);
+
+  const auto extensions = GetStats(a).num_arena_extensions;
+  for (int i = 0; i < 100; ++i) {
+    a.Free(a.Alloc(1000));
+  }
+  EXPECT_EQ(GetStats(a).num_arena_extensions, extensions);
+}
+
+TEST(SlabArenaTest, LargeAllocationsAndReserve) {
+  SlabArena a(std::make_unique<CPUAllocator>());
+
+  const size_t large_size = SlabArena::kMaxBlockSize + 1;
+  void* large = a.Alloc(large_size);
+  ASSERT_NE(large, nullptr);
+  memset(large, 0, large_size);
+
+  void* reserved = a.Reserve(1024);
+  ASSERT_NE(reserved, nullptr);
+
+  auto stats = GetStats(a);
+  EXPECT_EQ(stats.num_allocs, 2);
+  EXPECT_EQ(stats.num_reserves, 1);
+  EXPECT_EQ(stats.bytes_in_use, static_cast<int64_t>(large_size + 1024));
+  EXPECT_EQ(stats.max_alloc_size, static_cast<int64_t>(large_size));
+
+  a.Free(large);
+  a.Free(reserved);
+
+  stats = GetStats(a);
+  EXPECT_EQ(stats.bytes_in_use, 0);
+  EXPECT_EQ(stats.total_allocated_bytes, 0);
+}
+
+TEST(SlabArenaTest, ZeroSizeAndNull) {
+  SlabArena a(std::make_unique<CPUAllocator>());
+  EXPECT_EQ(a.Alloc(0), nullptr);
+  EXPECT_EQ(a.Reserve(0), nullptr);
+  a.Free(nullptr);
+  EXPECT_EQ(GetStats(a).num_allocs, 0);
+}
+
+TEST(SlabArenaTest, MemoryLimit) {
+  SlabArena a(std::make_unique<CPUAllocator>(), 1024 * 1024);
+  EXPECT_THROW(a.Alloc(SlabArena::kMaxBlockSize + 1), OnnxRuntimeException);
+  EXPECT_EQ(GetStats(a).total_allocated_bytes, 0);
+}
+
+TEST(SlabArenaTest, ConcurrentAllocAndCrossThreadFree) {
+  SlabArena a(std::make_unique<CPUAllocator>());
+
+  constexpr int kNumThreads = 4;
+  constexpr int kNumAllocs = 2000;
+  std::vector<std::vector<void*>> allocations(kNumThreads);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&a, &allocations, t]() {
+      for (int i = 0; i < kNumAllocs; ++i) {
+        const size_t size = 16 + static_cast<size_t>((i * 37 + t * 101) % 8192);
+        void* p = a.Alloc(size);
+        memset(p, t, size);
+        allocations[t].push_back(p);
+        if (i % 3 == 0) {
+          a.Free(allocations[t].back());
+          allocations[t].pop_back();
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(GetStats(a).num_allocs, kNumThreads * kNumAllocs);
+
+  // free everything from threads other than the allocating ones
+  threads.clear();
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&a, &allocations, t]() {
+      for (void* p : allocations[(t + 1) % kNumThreads]) {
+        a.Free(p);
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  // the exited threads returned their caches to the shared pools but their counters are kept
+  EXPECT_EQ(GetStats(a).bytes_in_use, 0);
+  EXPECT_EQ(GetStats(a).num_allocs, kNumThreads * kNumAllocs);
+}
+
+TEST(SlabArenaTest, CreateAllocator) {
+  OrtArenaCfg arena_cfg;
+  arena_cfg.arena_extend_strategy = static_cast<int>(ArenaExtendStrategy::kSizeClassSlab);
+  AllocatorCreationInfo info{[](OrtDevice::DeviceId) { return std::make_unique<CPUAllocator>(); },
+                             0, true, arena_cfg};
+
+  auto allocator = CreateAllocator(info);
+  ASSERT_NE(allocator, nullptr);
+  EXPECT_EQ(allocator->Info().alloc_type, OrtDeviceAllocator);
+
+  void* p = allocator->Alloc(100);
+  ASSERT_NE(p, nullptr);
+  AllocatorStats stats;
+  allocator->GetStats(&stats);
+  EXPECT_EQ(stats.num_allocs, 1);
+  allocator->Free(p);
+}
+
+}  // namespace test
+}  // namespace onnxruntime
@@ -0,0 +1,48 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "core/framework/string_tensor_view.h"
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "test/util/include/asserts.h"
+
+namespace onnxruntime {
+namespace test {
+
+TEST(StringTensorViewTest, Strings) {
+  // the strings are not null terminated, may be empty or contain null characters
+  const std::string content("abc\0de" "kmp", 9);
+  const std::vector<size_t> offsets{0, 6, 6};
+
+  StringTensorView view;
+  ASSERT_STATUS_OK(StringTensorView::Create(content, offsets, view));
+  ASSERT_EQ(view.size(), 3U);
+  EXPECT_EQ(view[0], std::string_view("abc\0de", 6));
+  EXPECT_EQ(view[1], "");
+  EXPECT_EQ(view[2], "kmp");
+  // the view reads the buffer in place
+  EXPECT_EQ(view[2].data(), content.data() + 6);
+}
+
+TEST(StringTensorViewTest, InvalidOffsets) {
+  const std::string content("abcdef");
+  StringTensorView view;
+
+  // out of order
+  ASSERT_STATUS_NOT_OK(StringTensorView::Create(content, std::vector<size_t>{0, 4, 2}, view));
+  // the last string goes to the end of the buffer so its start must be within it
+  ASSERT_STATUS_NOT_OK(StringTensorView::Create(content, std::vector<size_t>{0, 7}, view));
+  // nothing was set by the failed calls
+  EXPECT_EQ(view.size(), 0U);
+
+  const std::vector<size_t> offsets{0, 6};
+  ASSERT_STATUS_OK(StringTensorView::Create(content, offsets, view));
+  EXPECT_EQ(view[0], "abcdef");
+  EXPECT_EQ(view[1], "");
+}
+
+}  // namespace test
+}  // namespace onnxruntime
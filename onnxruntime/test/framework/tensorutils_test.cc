@@ -7,11 +7,15 @@
 #include "core/framework/prepacked_weights_container.h"
 #include "core/framework/tensorprotoutils.h"
 #include "core/graph/onnx_protobuf.h"
+#include "core/platform/env.h"
 #include "test/util/include/asserts.h"
 #include "file_util.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <filesystem>
 #include <limits>
+#include <numeric>
 
 #include "gtest/gtest.h"
 #include "gmock/gmock.h"
@@ -502,5 +506,90 @@ TEST(TensorProtoUtilsTest, ConstantTensorProtoWithExternalData) {
   TestConstantNodeConversionWithExternalData<float>(TensorProto_DataType_FLOAT);
   TestConstantNodeConversionWithExternalData<double>(TensorProto_DataType_DOUBLE);
 }
+
+#if !defined(__wasm__)
+// Writes `data` to a new test file and returns its name.
+static std::basic_string<ORTCHAR_T> CreateTestFileWithData(const std::vector<float>& data) {
+  std::basic_string<ORTCHAR_T> filename(ORT_TSTR("tensor_XXXXXX"));
+  FILE* fp;
+  CreateTestFile(fp, filename);
+  WriteDataToFile(fp, data);
+  EXPECT_EQ(0, fclose(fp));
+  return filename;
+}
+
+// Creates a float tensor proto that refers to `count` elements at `offset` of the external data file `filename`.
+static TensorProto CreateFloatTensorProtoWithExternalData(const std::basic_string<ORTCHAR_T>& filename,
+                                                          int64_t offset, size_t count) {
+  TensorProto tensor_proto;
+  tensor_proto.set_name("external_tensor");
+  tensor_proto.set_data_type(TensorProto_DataType_FLOAT);
+  tensor_proto.add_dims(static_cast<int64_t>(count));
+  ExternalDataInfo::SetExternalLocationToProto(filename, offset, count * sizeof(float), tensor_proto);
+  return tensor_proto;
+}
+
+TEST(TensorProtoUtilsTest, GetExtDataFromTensorProtoWithSharedFileMapping) {
+  if constexpr (endian::native != endian::little) {
+    GTEST_SKIP() << "The shared file mapping is only used on little endian hosts.";
+  }
+
+  std::vector<float> data(1024);
+  std::iota(data.begin(), data.end(), 0.f);
+  const auto filename = CreateTestFileWithData(data);
+  ScopedFileDeleter file_deleter(filename);
+
+  const auto load = [](const TensorProto& tensor_proto, bool use_shared_file_mapping, OrtValue& ort_value) {
+    ASSERT_STATUS_OK(utils::GetExtDataFromTensorProto(Env::Default(), {}, tensor_proto, ort_value, nullptr,
+                                                      use_shared_file_mapping));
+  };
+  const auto data_of = [](const OrtValue& ort_value) { return ort_value.Get<Tensor>().Data<float>(); };
+  const auto expect_data = [](const OrtValue& ort_value, const float* expected, size_t count) {
+    const auto values = ort_value.Get<Tensor>().DataAsSpan<float>();
+    ASSERT_EQ(values.size(), count);
+    EXPECT_TRUE(std::equal(values.begin(), values.end(), expected));
+  };
+
+  // the offsets are not aligned to the allocation granularity of the file mapping
+  const auto tensor_proto_1 = CreateFloatTensorProtoWithExternalData(filename, 3 * sizeof(float), 100);
+  const auto tensor_proto_2 = CreateFloatTensorProtoWithExternalData(filename, 517 * sizeof(float), 200);
+
+  OrtValue shared_1, shared_1_again, shared_2, not_shared_1;
+  load(tensor_proto_1, true, shared_1);
+  load(tensor_proto_1, true, shared_1_again);
+  load(tensor_proto_2, true, shared_2);
+  load(tensor_proto_1, false, not_shared_1);
+
+  // the shared tensors are views into a single mapping of the whole file
+  EXPECT_EQ(data_of(shared_1_again), data_of(shared_1));
+  EXPECT_EQ(data_of(shared_2) - data_of(shared_1), 514);
+  // otherwise only the data of the tensor is mapped
+  EXPECT_NE(data_of(not_shared_1), data_of(shared_1));
+
+  expect_data(shared_1, data.data() + 3, 100);
+  expect_data(shared_1_again, data.data() + 3, 100);
+  expect_data(shared_2, data.data() + 517, 200);
+  expect_data(not_shared_1, data.data() + 3, 100);
+
+#if !defined(_WIN32)
+  // replace the file (a mapped file can't be replaced on Windows).
+  // the existing mapping is out of date, so the new file is mapped instead of sharing it.
+  std::vector<float> new_data(2048);
+  std::iota(new_data.begin(), new_data.end(), 5000.f);
+  const auto new_filename = CreateTestFileWithData(new_data);
+  ScopedFileDeleter new_file_deleter(new_filename);
+  std::filesystem::rename(new_filename, filename);
+
+  OrtValue shared_after_change;
+  load(tensor_proto_1, true, shared_after_change);
+  EXPECT_NE(data_of(shared_after_change), data_of(shared_1));
+  expect_data(shared_after_change, new_data.data() + 3, 100);
+
+  // the tensors that were loaded before keep the data of the old file
+  expect_data(shared_1, data.data() + 3, 100);
+  expect_data(shared_2, data.data() + 517, 200);
+#endif
+}
+#endif
 }  // namespace test
 }  // namespace onnxruntime
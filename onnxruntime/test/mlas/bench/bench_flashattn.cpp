@@ -0,0 +1,97 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "mlas.h"
+#include "bench_util.h"
+#include "core/platform/env.h"
+#include "core/util/thread_utils.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+using onnxruntime::narrow;
+
+// Causal self attention of a prompt with grouped query heads, as in GroupQueryAttention on CPU.
+void FLASHATTENTION(benchmark::State& state) {
+  const auto sequence_length = narrow<int>(state.range(0));
+  const auto num_heads = narrow<int>(state.range(1));
+  const auto kv_num_heads = narrow<int>(state.range(2));
+  const auto head_size = narrow<int>(state.range(3));
+  const auto threads = narrow<int>(state.range(4));
+
+  if (sequence_length <= 0 || num_heads <= 0 || kv_num_heads <= 0 || head_size <= 0 || threads <= 0) {
+    throw std::invalid_argument("SequenceLength, NumHeads, KvNumHeads, HeadSize and Threads must be greater than 0!");
+  }
+  if (num_heads % kv_num_heads != 0) {
+    throw std::invalid_argument("NumHeads must be a multiple of KvNumHeads!");
+  }
+
+  OrtThreadPoolParams tpo;
+  tpo.thread_pool_size = threads;
+  tpo.auto_set_affinity = true;
+
+  std::unique_ptr<onnxruntime::concurrency::ThreadPool> tp(
+      onnxruntime::concurrency::CreateThreadPool(
+          &onnxruntime::Env::Default(), tpo, onnxruntime::concurrency::ThreadPoolType::INTRA_OP));
+
+  const size_t q_elements = static_cast<size_t>(num_heads) * sequence_length * head_size;
+  const size_t kv_elements = static_cast<size_t>(kv_num_heads) * sequence_length * head_size;
+  auto query = RandomVectorUniform<float>(q_elements, -1.0f, 1.0f);
+  auto key = RandomVectorUniform<float>(kv_elements, -1.0f, 1.0f);
+  auto value = RandomVectorUniform<float>(kv_elements, -1.0f, 1.0f);
+  std::vector<float> output(q_elements);
+
+  MlasFlashAttentionThreadedArgs args;
+  args.batch_size = 1;
+  args.num_heads = num_heads;
+  args.q_sequence_length = sequence_length;
+  args.kv_sequence_length = sequence_length;
+  args.qk_head_size = head_size;
+  args.v_head_size = head_size;
+  args.scale = 1.0f / sqrt(static_cast<float>(head_size));
+
+  int l2_cache_size = onnxruntime::Env::Default().GetL2CacheSize();
+  if (l2_cache_size <= 0) {
+    l2_cache_size = 1024 * 1024;
+  }
+  args.kv_block_size = l2_cache_size / (static_cast<int>(sizeof(float)) * 4 * (head_size + head_size));
+  args.kv_block_size = std::max(args.kv_block_size, 1);
+  args.q_block_size = std::min(args.kv_block_size, head_size + head_size);
+  args.kv_block_size = std::min(args.kv_block_size, sequence_length);
+  args.q_block_size = std::min(args.q_block_size, sequence_length);
+
+  args.thread_count = onnxruntime::concurrency::ThreadPool::DegreeOfParallelism(tp.get());
+  args.buffer_size_per_thread = (static_cast<size_t>(args.q_block_size) * 2 +
+                                 static_cast<size_t>(args.q_block_size) * static_cast<size_t>(args.kv_block_size) +
+                                 static_cast<size_t>(args.q_block_size) * static_cast<size_t>(args.v_head_size)) *
+                                sizeof(float);
+  std::vector<float> buffer(args.buffer_size_per_thread / sizeof(float) * args.thread_count);
+  args.buffer = buffer.data();
+
+  args.query = query.data();
+  args.key = key.data();
+  args.value = value.data();
+  args.output = output.data();
+  args.kv_num_heads = kv_num_heads;
+  args.kv_buffer_sequence_length = sequence_length;
+  args.is_causal = true;
+
+  // warming up run
+  MlasFlashAttention(&args, tp.get());
+
+  for (auto _ : state) {
+    MlasFlashAttention(&args, tp.get());
+  }
+}
+
+static void FlashAttentionArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"SequenceLength", "NumHeads", "KvNumHeads", "HeadSize", "Threads"});
+  for (int threads : {1, 8}) {
+    for (int sequence_length : {512, 1024, 2048, 4096, 8192}) {
+      b->Args({sequence_length, 32, 8, 128, threads});  // Llama 3 8B
+      b->Args({sequence_length, 32, 32, 96, threads});  // Phi-3 mini
+    }
+  }
+}
+
+BENCHMARK(FLASHATTENTION)->Apply(FlashAttentionArgs)->UseRealTime()->Unit(benchmark::TimeUnit::kMillisecond);
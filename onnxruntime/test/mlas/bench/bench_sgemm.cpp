@@ -5,6 +5,7 @@
 #include "bench_util.h"
 #include "core/util/thread_utils.h"
 
+#include <algorithm>
 #include <stdexcept>
 #include <numeric>
 
@@ -132,3 +133,139 @@ static void GemmLLMSizeProducts(benchmark::internal::Benchmark* b) {
 }
 
 BENCHMARK_CAPTURE(SGEMM, LLM, false, false, true)->Apply(GemmLLMSizeProducts)->UseRealTime();
+
+static const std::vector<std::string> sgemm_batch_bench_arg_names = {"BatchSize", "M", "N", "K"};
+
+// A batch of small SGEMMs, like the experts of a mixture of experts layer or the heads of an attention layer. The
+// batch is either dispatched by a single MlasGemmBatch call or by a MlasGemm call per problem.
+void SGEMM_BATCH(benchmark::State& state, bool per_problem, bool trans_b) {
+  if (state.range(0) <= 0) throw std::invalid_argument("BatchSize must greater than 0!");
+  if (state.range(1) <= 0) throw std::invalid_argument("M must greater than 0!");
+  if (state.range(2) <= 0) throw std::invalid_argument("N must greater than 0!");
+  if (state.range(3) <= 0) throw std::invalid_argument("K must greater than 0!");
+  const size_t batch_size = static_cast<size_t>(state.range(0));
+  const size_t M = static_cast<size_t>(state.range(1));
+  const size_t N = static_cast<size_t>(state.range(2));
+  const size_t K = static_cast<size_t>(state.range(3));
+
+  auto A = RandomVectorUniform(static_cast<size_t>(batch_size * M * K), -1.0f, 1.0f);
+  auto B = RandomVectorUniform(static_cast<size_t>(batch_size * N * K), -1.0f, 1.0f);
+  std::vector<float> C(static_cast<size_t>(batch_size * M * N));
+
+  OrtThreadPoolParams tpo;
+  tpo.thread_pool_size = 8;
+  tpo.auto_set_affinity = true;
+  std::unique_ptr<onnxruntime::concurrency::ThreadPool> tp(
+      onnxruntime::concurrency::CreateThreadPool(&onnxruntime::Env::Default(),
+                                                 tpo, onnxruntime::concurrency::ThreadPoolType::INTRA_OP));
+
+  const CBLAS_TRANSPOSE TransB = trans_b ? CblasTrans : CblasNoTrans;
+
+  std::vector<MLAS_SGEMM_DATA_PARAMS> data(batch_size);
+  for (size_t i = 0; i < batch_size; i++) {
+    data[i].A = A.data() + i * M * K;
+    data[i].lda = K;
+    data[i].B = B.data() + i * N * K;
+    data[i].ldb = trans_b ? K : N;
+    data[i].C = C.data() + i * M * N;
+    data[i].ldc = N;
+  }
+
+  auto run = [&]() {
+    if (per_problem) {
+      for (size_t i = 0; i < batch_size; i++) {
+        MlasGemmBatch(CblasNoTrans, TransB, M, N, K, &data[i], 1, tp.get());
+      }
+    } else {
+      MlasGemmBatch(CblasNoTrans, TransB, M, N, K, data.data(), batch_size, tp.get());
+    }
+  };
+
+  run();
+
+  for (auto _ : state) {
+    run();
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(2 * batch_size * M * N * K));
+}
+
+static void GemmBatchSizeProducts(benchmark::internal::Benchmark* b) {
+  b->ArgNames(sgemm_batch_bench_arg_names);
+  b->ArgsProduct({{64, 1024}, {4, 8, 16, 32}, {4, 8, 16, 32, 64}, {4, 8, 16, 32, 64}});
+  b->ArgsProduct({{64, 1024}, {1}, {16, 64}, {16, 64}});
+}
+
+BENCHMARK_CAPTURE(SGEMM_BATCH, BATCH_NoTrans, false, false)->Apply(GemmBatchSizeProducts)->UseRealTime();
+BENCHMARK_CAPTURE(SGEMM_BATCH, PER_PROBLEM_NoTrans, true, false)->Apply(GemmBatchSizeProducts)->UseRealTime();
+BENCHMARK_CAPTURE(SGEMM_BATCH, BATCH_TransB, false, true)->Apply(GemmBatchSizeProducts)->UseRealTime();
+BENCHMARK_CAPTURE(SGEMM_BATCH, PER_PROBLEM_TransB, true, true)->Apply(GemmBatchSizeProducts)->UseRealTime();
+
+static const std::vector<std::string> sgemm_numa_bench_arg_names = {"NumaNode", "M", "N", "K"};
+
+// Packed SGEMM on a NUMA aware thread pool. A non-negative NumaNode restricts the pool to the cores of that node and
+// first touches the packed B on it, like a session per socket does. NumaNode -1 runs a single pool over all the
+// nodes with B interleaved across them. The benchmark thread takes part in the GEMM as well, so it should be bound
+// to the node being measured, e.g. with numactl.
+void SGEMM_NUMA(benchmark::State& state) {
+  const int numa_node = static_cast<int>(state.range(0));
+  if (state.range(1) <= 0) throw std::invalid_argument("M must greater than 0!");
+  if (state.range(2) <= 0) throw std::invalid_argument("N must greater than 0!");
+  if (state.range(3) <= 0) throw std::invalid_argument("K must greater than 0!");
+  const size_t M = static_cast<size_t>(state.range(1));
+  const size_t N = static_cast<size_t>(state.range(2));
+  const size_t K = static_cast<size_t>(state.range(3));
+
+  OrtThreadPoolParams tpo;
+  tpo.numa_aware = true;
+  tpo.numa_node = numa_node;
+  std::unique_ptr<onnxruntime::concurrency::ThreadPool> tp(
+      onnxruntime::concurrency::CreateThreadPool(&onnxruntime::Env::Default(),
+                                                 tpo, onnxruntime::concurrency::ThreadPoolType::INTRA_OP));
+
+  std::vector<int> numa_nodes;
+  if (numa_node >= 0) {
+    numa_nodes.push_back(numa_node);
+  } else {
+    for (int node : onnxruntime::Env::Default().GetNumaNodeOfLogicalProcessors()) {
+      if (node >= 0 && std::find(numa_nodes.begin(), numa_nodes.end(), node) == numa_nodes.end()) {
+        numa_nodes.push_back(node);
+      }
+    }
+  }
+
+  auto A = RandomVectorUniform(static_cast<size_t>(M * K), -1.0f, 1.0f);
+  auto B = RandomVectorUniform(static_cast<size_t>(N * K), -1.0f, 1.0f);
+  std::vector<float> C(static_cast<size_t>(M * N));
+
+  // the packed B is allocated and written under the memory policy of the pool, like the prepacked weights of a
+  // session are
+  onnxruntime::Env::Default().SetCurrentThreadNumaMemoryPolicy(numa_nodes);
+  std::vector<float> B_packed(MlasGemmPackBSize(N, K));
+  MlasGemmPackB(CblasNoTrans, N, K, B.data(), N, B_packed.data());
+  onnxruntime::Env::Default().SetCurrentThreadNumaMemoryPolicy({});
+
+  MlasGemm(CblasNoTrans, M, N, K, 1.0f, A.data(), K, B_packed.data(), 0.0f, C.data(), N, tp.get());
+
+  for (auto _ : state) {
+    MlasGemm(CblasNoTrans, M, N, K, 1.0f, A.data(), K, B_packed.data(), 0.0f, C.data(), N, tp.get());
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * static_cast<int64_t>(2 * M * N * K));
+  state.counters["Threads"] = onnxruntime::concurrency::ThreadPool::DegreeOfParallelism(tp.get());
+}
+
+static void GemmNumaNodeProducts(benchmark::internal::Benchmark* b) {
+  b->ArgNames(sgemm_numa_bench_arg_names);
+
+  std::vector<int64_t> numa_nodes{-1};
+  for (int node : onnxruntime::Env::Default().GetNumaNodeOfLogicalProcessors()) {
+    if (node >= 0 && std::find(numa_nodes.begin(), numa_nodes.end(), node) == numa_nodes.end()) {
+      numa_nodes.push_back(node);
+    }
+  }
+
+  b->ArgsProduct({numa_nodes, {1, 128, 1024}, {4096, 11008}, {4096}});
+}
+
+BENCHMARK(SGEMM_NUMA)->Apply(GemmNumaNodeProducts)->UseRealTime();
@@ -70,6 +70,15 @@ class FgemmShortExecuteTest : public MlasTestFixture<MlasFgemmTest<T, Packed, Th
     test_registered += RegisterTestTransposeABProduct(128, 3072, 768, 1, 1.0f, 0.0f);
     test_registered += RegisterTestTransposeABProduct(128, 768, 3072, 1, 1.0f, 0.0f);
     test_registered += RegisterTestTransposeABProduct(25, 81, 79, 7, 1.0f, 0.0f);
+
+    // Batches of small matrices, which are computed without packing matrix B.
+    static const size_t small_ns[] = {1, 7, 16, 17, 33, 48, 63, 64};
+    for (size_t n : small_ns) {
+      test_registered += RegisterTestTransposeABProduct(13, n, 9, 33, 1.0f, 0.0f);
+      test_registered += RegisterTestTransposeABProduct(31, n, 4, 17, 0.5f, -1.0f);
+    }
+    test_registered += RegisterTestTransposeABProduct(2, 16, 16, 65, 1.0f, 1.0f);
+    test_registered += RegisterTestTransposeABProduct(4, 64, 250, 5, 1.0f, 0.0f);
     return test_registered;
   }
 
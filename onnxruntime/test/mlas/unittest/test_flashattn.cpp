@@ -0,0 +1,190 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "test_util.h"
+
+class MlasFlashAttentionTest : public MlasTestBase {
+ private:
+  MatrixGuardBuffer<float> BufferQuery;
+  MatrixGuardBuffer<float> BufferKey;
+  MatrixGuardBuffer<float> BufferValue;
+  MatrixGuardBuffer<float> BufferSink;
+  MatrixGuardBuffer<float> BufferWorkspace;
+  MatrixGuardBuffer<float> BufferOutput;
+  MatrixGuardBuffer<float> BufferOutputReference;
+  MatrixGuardBuffer<float> BufferScores;
+
+  // Softmax of the scores over the attended keys, with the sink as an extra score without a value, times V.
+  static void ReferenceFlashAttention(const MlasFlashAttentionThreadedArgs& args, float* Scores, float* Output) {
+    const int kv_num_heads = args.kv_num_heads > 0 ? args.kv_num_heads : args.num_heads;
+    const int kv_buffer_sequence_length =
+        args.kv_buffer_sequence_length > 0 ? args.kv_buffer_sequence_length : args.kv_sequence_length;
+    const size_t query_batch_stride = args.query_batch_stride > 0
+                                          ? args.query_batch_stride
+                                          : static_cast<size_t>(args.num_heads) * args.q_sequence_length * args.qk_head_size;
+    const bool has_sink = args.smooth_softmax || args.head_sink != nullptr;
+
+    for (int b = 0; b < args.batch_size; b++) {
+      for (int h = 0; h < args.num_heads; h++) {
+        const int kv_h = h / (args.num_heads / kv_num_heads);
+        const float* key = args.key + (static_cast<size_t>(b) * kv_num_heads + kv_h) * kv_buffer_sequence_length * args.qk_head_size;
+        const float* value = args.value + (static_cast<size_t>(b) * kv_num_heads + kv_h) * kv_buffer_sequence_length * args.v_head_size;
+
+        for (int i = 0; i < args.q_sequence_length; i++) {
+          const float* query = args.query + b * query_batch_stride + (static_cast<size_t>(h) * args.q_sequence_length + i) * args.qk_head_size;
+          float* output = Output + ((static_cast<size_t>(b) * args.q_sequence_length + i) * args.num_heads + h) * args.v_head_size;
+
+          int start = 0;
+          int end = args.kv_sequence_length;
+          if (args.is_causal) {
+            const int position = i + args.kv_sequence_length - args.q_sequence_length;
+            end = position + 1;
+            if (args.local_window_size >= 0) {
+              start = std::max(0, position - args.local_window_size);
+            }
+          }
+
+          float max_score = has_sink ? (args.head_sink != nullptr ? args.head_sink[h] : 0.0f)
+                                     : std::numeric_limits<float>::lowest();
+          for (int j = start; j < end; j++) {
+            float score = 0.0f;
+            for (int k = 0; k < args.qk_head_size; k++) {
+              score += query[k] * key[static_cast<size_t>(j) * args.qk_head_size + k];
+            }
+            score *= args.scale;
+            if (args.softcap > 0.0f) {
+              score = args.softcap * std::tanh(score / args.softcap);
+            }
+            Scores[j] = score;
+            max_score = std::max(max_score, score);
+          }
+
+          float sum = has_sink ? std::exp((args.head_sink != nullptr ? args.head_sink[h] : 0.0f) - max_score) : 0.0f;
+          for (int j = start; j < end; j++) {
+            Scores[j] = std::exp(Scores[j] - max_score);
+            sum += Scores[j];
+          }
+
+          for (int k = 0; k < args.v_head_size; k++) {
+            float weighted = 0.0f;
+            for (int j = start; j < end; j++) {
+              weighted += Scores[j] * value[static_cast<size_t>(j) * args.v_head_size + k];
+            }
+            output[k] = start < end ? weighted / sum : 0.0f;
+          }
+        }
+      }
+    }
+  }
+
+  void Test(int BatchSize, int NumHeads, int KvNumHeads, int QSequenceLength, int KvSequenceLength,
+            int QkHeadSize, int VHeadSize, int QBlockSize, int KvBlockSize, bool IsCausal, int LocalWindowSize,
+            float Softcap, bool SmoothSoftmax, bool HeadSink, int ThreadCount) {
+    // The K and V buffers and the batches of Q are larger than the sequences, as in the present state of GQA.
+    const int kv_buffer_sequence_length = KvSequenceLength + 3;
+    const size_t query_batch_stride = (static_cast<size_t>(NumHeads) * QSequenceLength + 2) * QkHeadSize;
+
+    float* Query = BufferQuery.GetBuffer(BatchSize * query_batch_stride);
+    float* Key = BufferKey.GetBuffer(static_cast<size_t>(BatchSize) * KvNumHeads * kv_buffer_sequence_length * QkHeadSize);
+    float* Value = BufferValue.GetBuffer(static_cast<size_t>(BatchSize) * KvNumHeads * kv_buffer_sequence_length * VHeadSize);
+    float* Sink = BufferSink.GetBuffer(NumHeads);
+    const size_t output_size = static_cast<size_t>(BatchSize) * QSequenceLength * NumHeads * VHeadSize;
+    float* Output = BufferOutput.GetBuffer(output_size);
+    float* OutputReference = BufferOutputReference.GetBuffer(output_size);
+    float* Scores = BufferScores.GetBuffer(KvSequenceLength);
+
+    std::default_random_engine generator(static_cast<unsigned>(QSequenceLength * 131 + KvSequenceLength));
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    for (size_t i = 0; i < BatchSize * query_batch_stride; i++) {
+      Query[i] = distribution(generator);
+    }
+    for (size_t i = 0; i < static_cast<size_t>(BatchSize) * KvNumHeads * kv_buffer_sequence_length * QkHeadSize; i++) {
+      Key[i] = distribution(generator);
+    }
+    for (size_t i = 0; i < static_cast<size_t>(BatchSize) * KvNumHeads * kv_buffer_sequence_length * VHeadSize; i++) {
+      Value[i] = distribution(generator);
+    }
+    for (int i = 0; i < NumHeads; i++) {
+      Sink[i] = 2.0f * distribution(generator);
+    }
+
+    MlasFlashAttentionThreadedArgs args;
+    args.batch_size = BatchSize;
+    args.num_heads = NumHeads;
+    args.q_sequence_length = QSequenceLength;
+    args.kv_sequence_length = KvSequenceLength;
+    args.qk_head_size = QkHeadSize;
+    args.v_head_size = VHeadSize;
+    args.q_block_size = QBlockSize;
+    args.kv_block_size = KvBlockSize;
+    // large enough for the softcap to matter
+    args.scale = 4.0f / std::sqrt(static_cast<float>(QkHeadSize));
+    args.thread_count = ThreadCount;
+    args.buffer_size_per_thread = (static_cast<size_t>(QBlockSize) * 2 +
+                                   static_cast<size_t>(QBlockSize) * KvBlockSize +
+                                   static_cast<size_t>(QBlockSize) * VHeadSize) *
+                                  sizeof(float);
+    args.buffer = BufferWorkspace.GetBuffer(args.buffer_size_per_thread * ThreadCount / sizeof(float));
+    args.query = Query;
+    args.key = Key;
+    args.value = Value;
+    args.output = Output;
+    args.kv_num_heads = KvNumHeads;
+    args.kv_buffer_sequence_length = kv_buffer_sequence_length;
+    args.query_batch_stride = query_batch_stride;
+    args.is_causal = IsCausal;
+    args.local_window_size = LocalWindowSize;
+    args.softcap = Softcap;
+    args.smooth_softmax = SmoothSoftmax;
+    args.head_sink = HeadSink ? Sink : nullptr;
+
+    MlasFlashAttention(&args, GetMlasThreadPool());
+    ReferenceFlashAttention(args, Scores, OutputReference);
+
+    for (size_t i = 0; i < output_size; i++) {
+      ASSERT_NEAR(Output[i], OutputReference[i], 1e-5f + std::fabs(OutputReference[i]) * 1e-4f)
+          << "@" << i << " of " << output_size << ", NumHeads=" << NumHeads << ", KvNumHeads=" << KvNumHeads
+          << ", QSequenceLength=" << QSequenceLength << ", KvSequenceLength=" << KvSequenceLength
+          << ", QBlockSize=" << QBlockSize << ", KvBlockSize=" << KvBlockSize << ", IsCausal=" << IsCausal
+          << ", LocalWindowSize=" << LocalWindowSize << ", Softcap=" << Softcap
+          << ", SmoothSoftmax=" << SmoothSoftmax << ", HeadSink=" << HeadSink << ", ThreadCount=" << ThreadCount;
+    }
+  }
+
+ public:
+  static const char* GetTestSuiteName() {
+    static const std::string suite_name("FlashAttention");
+    return suite_name.c_str();
+  }
+
+  void ExecuteShort(void) override {
+    // Plain multi-head attention.
+    Test(2, 4, 4, 13, 29, 16, 8, 4, 8, false, -1, 0.0f, false, false, 1);
+
+    // Sequence lengths that are and are not a multiple of the block sizes, with fewer K/V heads than query heads,
+    // the first prompt (QSequenceLength == KvSequenceLength) and a prompt after a past.
+    for (int kv_num_heads : {4, 2, 1}) {
+      for (auto [q_sequence_length, kv_sequence_length] : {std::pair{1, 1}, std::pair{8, 8}, std::pair{13, 13},
+                                                           std::pair{37, 37}, std::pair{5, 21}}) {
+        for (int local_window_size : {-1, 0, 3, 16}) {
+          for (float softcap : {0.0f, 2.0f}) {
+            Test(2, 4, kv_num_heads, q_sequence_length, kv_sequence_length, 16, 16, 4, 8, true,
+                 local_window_size, softcap, false, false, 3);
+          }
+          Test(2, 4, kv_num_heads, q_sequence_length, kv_sequence_length, 16, 16, 8, 8, true,
+               local_window_size, 0.0f, true, false, 2);
+          Test(2, 4, kv_num_heads, q_sequence_length, kv_sequence_length, 16, 16, 5, 3, true,
+               local_window_size, 2.0f, false, true, 2);
+        }
+      }
+    }
+  }
+};
+
+static UNUSED_VARIABLE bool added_to_main = AddTestRegister([](bool is_short_execute) {
+  size_t count = 0;
+  if (is_short_execute) {
+    count += MlasDirectShortExecuteTests<MlasFlashAttentionTest>::RegisterShortExecute();
+  }
+  return count;
+});
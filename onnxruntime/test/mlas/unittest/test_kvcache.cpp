@@ -0,0 +1,122 @@
+// Copyright (c) Microsoft Corporation. All rights reserved.
+// Licensed under the MIT License.
+
+#include "test_util.h"
+
+class MlasKvCacheTest : public MlasTestBase {
+ private:
+  MatrixGuardBuffer<float> BufferInput;
+  MatrixGuardBuffer<float> BufferScale;
+  MatrixGuardBuffer<float> BufferVector;
+  MatrixGuardBuffer<uint8_t> BufferQuantized;
+  MatrixGuardBuffer<float> BufferOutput;
+
+  static float Dequantize(size_t BitWidth, const uint8_t* Row, size_t k) {
+    if (BitWidth == 8) {
+      return static_cast<float>(reinterpret_cast<const int8_t*>(Row)[k]);
+    }
+    const uint8_t packed = Row[k / 2];
+    return static_cast<float>(((k & 1) ? (packed >> 4) : (packed & 0x0F)) - 8);
+  }
+
+  void Test(size_t BitWidth, size_t Rows, size_t Count) {
+    const size_t row_bytes = Count * BitWidth / 8;
+    float* Input = BufferInput.GetBuffer(Rows * Count);
+    float* Scale = BufferScale.GetBuffer(Rows);
+    float* Vector = BufferVector.GetBuffer(std::max(Rows, Count));
+    uint8_t* Quantized = BufferQuantized.GetBuffer(Rows * row_bytes);
+    float* Output = BufferOutput.GetBuffer(std::max(Rows, Count));
+
+    std::default_random_engine generator(static_cast<unsigned>(Rows * 131 + Count));
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    const float max_level = BitWidth == 8 ? 127.0f : 7.0f;
+
+    for (size_t j = 0; j < Rows; j++) {
+      // rows of very different magnitudes, and a row of zeros
+      const float magnitude = (j % 5 == 4) ? 0.0f : std::ldexp(1.0f, static_cast<int>(j % 7) * 4 - 12);
+      for (size_t k = 0; k < Count; k++) {
+        Input[j * Count + k] = distribution(generator) * magnitude;
+      }
+    }
+    for (size_t i = 0; i < std::max(Rows, Count); i++) {
+      Vector[i] = distribution(generator);
+    }
+
+    MlasQuantizeKvCache(BitWidth, Input, Quantized, Scale, Rows, Count);
+
+    for (size_t j = 0; j < Rows; j++) {
+      float max_magnitude = 0.0f;
+      float max_quantized = 0.0f;
+      for (size_t k = 0; k < Count; k++) {
+        max_magnitude = std::max(max_magnitude, std::fabs(Input[j * Count + k]));
+        max_quantized = std::max(max_quantized, std::fabs(Dequantize(BitWidth, Quantized + j * row_bytes, k)));
+      }
+      // the scale maps the largest magnitude of the row to the largest level, nothing saturates
+      ASSERT_NEAR(Scale[j], max_magnitude / max_level, max_magnitude * 1e-6f)
+          << "BitWidth=" << BitWidth << ", Rows=" << Rows << ", Count=" << Count << " @ " << j;
+      ASSERT_EQ(max_quantized, max_magnitude > 0.0f ? max_level : 0.0f)
+          << "BitWidth=" << BitWidth << ", Rows=" << Rows << ", Count=" << Count << " @ " << j;
+
+      for (size_t k = 0; k < Count; k++) {
+        const float dequantized = Dequantize(BitWidth, Quantized + j * row_bytes, k) * Scale[j];
+        ASSERT_LE(std::fabs(dequantized - Input[j * Count + k]), Scale[j] * 0.5f * (1.0f + 1e-5f))
+            << "BitWidth=" << BitWidth << ", Rows=" << Rows << ", Count=" << Count << " @ [" << j << ", " << k << "]";
+      }
+    }
+
+    MlasKvCacheDot(BitWidth, Vector, Quantized, Output, Rows, Count);
+
+    for (size_t j = 0; j < Rows; j++) {
+      float sum = 0.0f;
+      float magnitude = 0.0f;
+      for (size_t k = 0; k < Count; k++) {
+        const float product = Vector[k] * Dequantize(BitWidth, Quantized + j * row_bytes, k);
+        sum += product;
+        magnitude += std::fabs(product);
+      }
+      // the kernels may sum in any order
+      ASSERT_LE(std::fabs(Output[j] - sum), magnitude * 1e-5f + 1e-6f)
+          << "Dot, BitWidth=" << BitWidth << ", Rows=" << Rows << ", Count=" << Count << " @ " << j
+          << ", got: " << Output[j] << ", expecting: " << sum;
+    }
+
+    MlasKvCacheAccumulate(BitWidth, Vector, Quantized, Output, Rows, Count);
+
+    for (size_t k = 0; k < Count; k++) {
+      float sum = 0.0f;
+      float magnitude = 0.0f;
+      for (size_t j = 0; j < Rows; j++) {
+        const float product = Vector[j] * Dequantize(BitWidth, Quantized + j * row_bytes, k);
+        sum += product;
+        magnitude += std::fabs(product);
+      }
+      ASSERT_LE(std::fabs(Output[k] - sum), magnitude * 1e-5f + 1e-6f)
+          << "Accumulate, BitWidth=" << BitWidth << ", Rows=" << Rows << ", Count=" << Count << " @ " << k
+          << ", got: " << Output[k] << ", expecting: " << sum;
+    }
+  }
+
+ public:
+  static const char* GetTestSuiteName() {
+    static const std::string suite_name("KvCache");
+    return suite_name.c_str();
+  }
+
+  void ExecuteShort(void) override {
+    for (size_t BitWidth : {4, 8}) {
+      for (size_t Count : {2, 8, 14, 16, 30, 48, 64, 80, 96, 128, 256}) {
+        for (size_t Rows : {1, 3, 16, 67}) {
+          Test(BitWidth, Rows, Count);
+        }
+      }
+    }
+  }
+};
+
+static UNUSED_VARIABLE bool added_to_main = AddTestRegister([](bool is_short_execute) {
+  size_t count = 0;
+  if (is_short_execute) {
+    count += MlasDirectShortExecuteTests<MlasKvCacheTest>::RegisterShortExecute();
+  }
+  return count;
+});
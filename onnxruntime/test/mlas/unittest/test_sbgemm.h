@@ -15,10 +15,12 @@ Abstract:
 
 --*/
 
-#if defined(__aarch64__) && defined(__linux__)
+#if defined(__linux__) && (defined(__aarch64__) || defined(__x86_64__))
 
 #pragma once
 
+#include <cstring>
+
 #include "test_util.h"
 
 template <typename T>
@@ -278,4 +280,4 @@ class MlasSBGemmTest : public MlasTestBase {
   }
 };
 
-#endif  // defined(__aarch64__) && defined(__linux__)
+#endif  // defined(__linux__) && (defined(__aarch64__) || defined(__x86_64__))
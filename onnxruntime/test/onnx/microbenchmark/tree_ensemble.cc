@@ -0,0 +1,144 @@
+#include "core/framework/tensor.h"
+#include "core/providers/cpu/ml/tree_ensemble_common.h"
+#include <benchmark/benchmark.h>
+#include <random>
+
+using namespace onnxruntime;
+using namespace onnxruntime::ml;
+using namespace onnxruntime::ml::detail;
+
+// Gives access to the evaluation engines of TreeEnsembleCommon, the node walk and the batch engine,
+// QuickScorer or the compact layout depending on the trees.
+class TreeEnsembleBenchmark : public TreeEnsembleCommon<float, float, float> {
+ public:
+  TreeEnsembleBenchmark(const TreeEnsembleAttributesV3<float>& attributes, bool batch_engine) {
+    ORT_THROW_IF_ERROR(Init(80, 128, 50, attributes));
+    if (!batch_engine) {
+      quick_scorer_.reset();
+      compact_trees_.reset();
+    }
+  }
+
+  bool HasBatchEngine() const { return TreeEnsembleCommon<float, float, float>::HasBatchEngine(); }
+
+  void Compute(const Tensor& X, Tensor& Y) const {
+    ComputeAgg(nullptr, &X, &Y, nullptr,
+               TreeAggregatorSum<float, float, float>(roots_.size(), n_targets_or_classes_, post_transform_,
+                                                      base_values_));
+  }
+};
+
+// Adds a random subtree with n_leaves leaves and returns the id of its root. Balanced trees look like the ones
+// converted from XGBoost (depth-wise growth), unbalanced ones like the ones converted from LightGBM (leaf-wise
+// growth with a fixed number of leaves).
+static int64_t AddRandomSubtree(TreeEnsembleAttributesV3<float>& attributes, int64_t tree_id, int64_t& n_nodes,
+                                int64_t n_leaves, NODE_MODE_ONNX mode, bool balanced, bool missing_tracks,
+                                int64_t n_features, std::mt19937& gen) {
+  std::uniform_real_distribution<float> values(0.f, 1.f);
+  const int64_t node_id = n_nodes++;
+  attributes.nodes_treeids.push_back(tree_id);
+  attributes.nodes_nodeids.push_back(node_id);
+  size_t k = attributes.nodes_nodeids.size() - 1;
+  attributes.nodes_truenodeids.push_back(0);
+  attributes.nodes_falsenodeids.push_back(0);
+  attributes.nodes_featureids.push_back(0);
+  attributes.nodes_values.push_back(0.f);
+  attributes.nodes_missing_value_tracks_true.push_back(0);
+
+  if (n_leaves == 1) {
+    attributes.nodes_modes.push_back(NODE_MODE_ONNX::LEAF);
+    attributes.target_class_treeids.push_back(tree_id);
+    attributes.target_class_nodeids.push_back(node_id);
+    attributes.target_class_ids.push_back(0);
+    attributes.target_class_weights.push_back(values(gen));
+    return node_id;
+  }
+
+  attributes.nodes_modes.push_back(mode);
+  attributes.nodes_featureids[k] = std::uniform_int_distribution<int64_t>(0, n_features - 1)(gen);
+  attributes.nodes_values[k] = values(gen);
+  attributes.nodes_missing_value_tracks_true[k] = missing_tracks && values(gen) < 0.5f ? 1 : 0;
+  int64_t true_leaves = balanced ? n_leaves / 2 : std::uniform_int_distribution<int64_t>(1, n_leaves - 1)(gen);
+  int64_t true_id = AddRandomSubtree(attributes, tree_id, n_nodes, true_leaves, mode, balanced, missing_tracks,
+                                     n_features, gen);
+  int64_t false_id = AddRandomSubtree(attributes, tree_id, n_nodes, n_leaves - true_leaves, mode, balanced,
+                                      missing_tracks, n_features, gen);
+  attributes.nodes_truenodeids[k] = true_id;
+  attributes.nodes_falsenodeids[k] = false_id;
+  return node_id;
+}
+
+static TreeEnsembleAttributesV3<float> CreateRandomTrees(int64_t n_trees, int64_t n_leaves, int64_t n_features,
+                                                        NODE_MODE_ONNX mode, bool balanced, bool missing_tracks) {
+  std::mt19937 gen(0);
+  TreeEnsembleAttributesV3<float> attributes;
+  attributes.aggregate_function = "SUM";
+  attributes.post_transform = "NONE";
+  attributes.n_targets_or_classes = 1;
+  for (int64_t tree_id = 0; tree_id < n_trees; ++tree_id) {
+    int64_t n_nodes = 0;
+    AddRandomSubtree(attributes, tree_id, n_nodes, n_leaves, mode, balanced, missing_tracks, n_features, gen);
+  }
+  return attributes;
+}
+
+// args: batch size, number of trees, 0 for the node walk or 1 for the batch engine.
+static void RunTreeEnsemble(benchmark::State& state, const TreeEnsembleAttributesV3<float>& attributes,
+                            int64_t n_features) {
+  const int64_t batch_size = state.range(0);
+  const bool batch_engine = state.range(2) != 0;
+  TreeEnsembleBenchmark tree_ensemble(attributes, batch_engine);
+  if (batch_engine && !tree_ensemble.HasBatchEngine()) {
+    state.SkipWithError("The trees cannot be evaluated by batches.");
+    return;
+  }
+
+  AllocatorPtr alloc = CPUAllocator::DefaultInstance();
+  Tensor X(DataTypeImpl::GetType<float>(), {batch_size, n_features}, alloc);
+  Tensor Y(DataTypeImpl::GetType<float>(), {batch_size, 1}, alloc);
+  std::mt19937 gen(1);
+  std::uniform_real_distribution<float> values(0.f, 1.f);
+  auto x = X.MutableDataAsSpan<float>();
+  std::generate(x.begin(), x.end(), [&]() { return values(gen); });
+
+  for (auto _ : state) {
+    tree_ensemble.Compute(X, Y);
+  }
+  state.SetItemsProcessed(state.iterations() * batch_size);
+}
+
+static void BM_TreeEnsembleLightGbm(benchmark::State& state) {
+  // 31 leaves per tree, BRANCH_LEQ with missing values tracked.
+  constexpr int64_t n_features = 28;
+  auto attributes = CreateRandomTrees(state.range(1), 31, n_features, NODE_MODE_ONNX::BRANCH_LEQ, false, true);
+  RunTreeEnsemble(state, attributes, n_features);
+}
+
+static void BM_TreeEnsembleLightGbmLarge(benchmark::State& state) {
+  // 255 leaves per tree, evaluated with the compact layout.
+  constexpr int64_t n_features = 28;
+  auto attributes = CreateRandomTrees(state.range(1), 255, n_features, NODE_MODE_ONNX::BRANCH_LEQ, false, true);
+  RunTreeEnsemble(state, attributes, n_features);
+}
+
+static void BM_TreeEnsembleXgboost(benchmark::State& state) {
+  // Depth 6, BRANCH_LT.
+  constexpr int64_t n_features = 28;
+  auto attributes = CreateRandomTrees(state.range(1), 64, n_features, NODE_MODE_ONNX::BRANCH_LT, true, false);
+  RunTreeEnsemble(state, attributes, n_features);
+}
+
+BENCHMARK(BM_TreeEnsembleLightGbm)
+    ->UseRealTime()
+    ->Unit(benchmark::TimeUnit::kMicrosecond)
+    ->ArgsProduct({{16, 1000}, {100, 1000}, {0, 1}});
+
+BENCHMARK(BM_TreeEnsembleLightGbmLarge)
+    ->UseRealTime()
+    ->Unit(benchmark::TimeUnit::kMicrosecond)
+    ->ArgsProduct({{16, 1000, 100000}, {100, 1000}, {0, 1}});
+
+BENCHMARK(BM_TreeEnsembleXgboost)
+    ->UseRealTime()
+    ->Unit(benchmark::TimeUnit::kMicrosecond)
+    ->ArgsProduct({{16, 1000}, {100, 1000}, {0, 1}});
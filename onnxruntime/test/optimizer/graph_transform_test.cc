@@ -8235,6 +8235,117 @@ TEST_F(GraphTransformationTests, MatMulNBitsBiasFusion) {
   }
 }
 
+TEST_F(GraphTransformationTests, MatMulNBitsEpilogueFusion) {
+  struct TestOptions {
+    std::string activation;
+    bool broadcast_multiplier{false};
+  };
+
+  auto run_test = [&logger = *logger_](const TestOptions& opts) {
+    SCOPED_TRACE(MakeString("activation:", opts.activation, ", broadcast_multiplier:", opts.broadcast_multiplier));
+
+    auto build_test_case = [&](ModelTestBuilder& builder) {
+      constexpr size_t qbits = 4;
+      constexpr size_t block_size = 32;
+
+      constexpr int64_t M = 2, K = 4, N = 8;
+
+      int q_rows, q_cols;
+      MlasBlockwiseQuantizedShape<float, qbits>(block_size, /* columnwise */ true,
+                                                K, N,
+                                                q_rows, q_cols);
+
+      size_t q_data_size_in_bytes, q_scale_size, q_zp_size_in_bytes;
+      MlasBlockwiseQuantizedBufferSizes<qbits>(block_size, /* columnwise */ true,
+                                               K, N,
+                                               q_data_size_in_bytes, q_scale_size, &q_zp_size_in_bytes);
+
+      auto* A = builder.MakeInput<float>(std::vector{M, K}, "A");
+
+      auto* B_data = builder.MakeInitializer<uint8_t>({int64_t{q_rows}, int64_t{q_cols}},
+                                                      uint8_t{0}, uint8_t{255});
+      auto* B_scales = builder.MakeInitializer<float>({static_cast<int64_t>(q_scale_size)},
+                                                      1.0f, 2.0f);
+
+      auto* matmul_output = builder.MakeIntermediate();
+
+      auto& matmul = builder.AddNode("MatMulNBits",
+                                     {A, B_data, B_scales},
+                                     {matmul_output},
+                                     kMSDomain);
+      matmul.AddAttribute("N", N);
+      matmul.AddAttribute("K", K);
+      matmul.AddAttribute("block_size", static_cast<int64_t>(block_size));
+      matmul.AddAttribute("bits", static_cast<int64_t>(qbits));
+
+      auto* activation_output = builder.MakeIntermediate();
+      if (opts.activation == "Relu") {
+        builder.AddNode("Relu", {matmul_output}, {activation_output});
+      } else {
+        auto& activation = builder.AddNode(opts.activation, {matmul_output}, {activation_output}, kMSDomain);
+        if (opts.activation == "QuickGelu") {
+          activation.AddAttribute("alpha", 1.0f);
+        }
+      }
+
+      auto* Multiplier = opts.broadcast_multiplier ? builder.MakeInput<float>(std::vector{N}, "Multiplier")
+                                                   : builder.MakeInput<float>(std::vector{M, N}, "Multiplier");
+      auto* mul_output = builder.MakeIntermediate();
+      builder.AddNode("Mul", {Multiplier, activation_output}, {mul_output});
+
+      auto* Residual = builder.MakeInput<float>(std::vector{M, N}, "Residual");
+      builder.AddNode("Add", {mul_output, Residual}, {builder.MakeOutput()});
+    };
+
+    auto pre_graph_checker = [&](Graph& graph) {
+      auto op_count = CountOpsInGraph(graph);
+      EXPECT_EQ(op_count[opts.activation == "Relu" ? "Relu" : "com.microsoft." + opts.activation], 1);
+      EXPECT_EQ(op_count["Mul"], 1);
+      EXPECT_EQ(op_count["Add"], 1);
+      return Status::OK();
+    };
+
+    auto post_graph_checker = [&](Graph& graph) {
+      auto op_count = CountOpsInGraph(graph);
+      EXPECT_EQ(op_count["com.microsoft.MatMulNBits"], 1);
+      EXPECT_EQ(op_count[opts.activation == "Relu" ? "Relu" : "com.microsoft." + opts.activation], 0);
+      // a multiplier that is broadcast is not fused, and then neither is the residual added after it
+      EXPECT_EQ(op_count["Mul"], opts.broadcast_multiplier ? 1 : 0);
+      EXPECT_EQ(op_count["Add"], opts.broadcast_multiplier ? 1 : 0);
+
+      for (const Node& node : graph.Nodes()) {
+        if (node.OpType() == "MatMulNBits") {
+          const auto* activation_attr = graph_utils::GetNodeAttribute(node, "activation");
+          EXPECT_NE(activation_attr, nullptr);
+          if (activation_attr != nullptr) {
+            EXPECT_EQ(activation_attr->s(), opts.activation);
+          }
+          if (opts.activation == "QuickGelu") {
+            EXPECT_EQ(graph_utils::GetNodeAttribute(node, "activation_alpha")->f(), 1.0f);
+          }
+
+          const auto input_defs = node.InputDefs();
+          EXPECT_EQ(input_defs.size() > 7 && input_defs[6]->Exists() && input_defs[7]->Exists(),
+                    !opts.broadcast_multiplier);
+        }
+      }
+      return Status::OK();
+    };
+
+    ASSERT_STATUS_OK(TestGraphTransformer(build_test_case, 21, logger, std::make_unique<MatMulNBitsFusion>(),
+                                          TransformerLevel::Level2, 3, pre_graph_checker, post_graph_checker));
+  };
+
+  for (const char* activation : {"Relu", "Gelu", "QuickGelu"}) {
+    for (bool broadcast_multiplier : {false, true}) {
+      TestOptions opts{};
+      opts.activation = activation;
+      opts.broadcast_multiplier = broadcast_multiplier;
+      run_test(opts);
+    }
+  }
+}
+
 #endif  // !defined(DISABLE_CONTRIB_OPS)
 
 }  // namespace test
@@ -14,6 +14,7 @@
 #include <algorithm>
 #include <memory>
 #include <functional>
+#include <thread>
 
 #ifdef _WIN32
 #include <Windows.h>
@@ -510,6 +511,140 @@ TEST(ThreadPoolTest, TestStagedMultiLoopSections_4Thread_100Loop) {
   TestStagedMultiLoopSections("TestStagedMultiLoopSections_4Thread_100Loop", 4, 100);
 }
 
+TEST(ThreadPoolTest, TestNumaNodes) {
+  // two NUMA nodes with two workers each, the first entry belongs to the main thread.
+  // the nodes need not exist, binding the memory of the workers to them is best effort.
+  ThreadOptions to;
+  to.numa_nodes = {0, 0, 0, 1, 1};
+  auto tp = std::make_unique<ThreadPool>(&onnxruntime::Env::Default(), to, nullptr, 5, true);
+
+  constexpr int num_tasks = 1024;
+  constexpr int num_concurrent = 3;
+  auto test_data = CreateTestData(num_tasks);
+  std::vector<std::thread> threads;
+  for (int c = 0; c < num_concurrent; c++) {
+    threads.emplace_back([&]() {
+      for (int l = 0; l < 10; l++) {
+        ThreadPool::TryParallelFor(tp.get(), num_tasks, 0.0, [&](std::ptrdiff_t s, std::ptrdiff_t e) {
+          for (auto i = s; i < e; i++) {
+            IncrementElement(*test_data, i);
+          }
+        });
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ValidateTestData(*test_data, num_concurrent * 10);
+
+  // tasks scheduled from the workers stay on their node, but must all run
+  std::atomic<int> ctr{0};
+  Barrier b(num_tasks * 2, /*spin=*/true);
+  for (int i = 0; i < num_tasks; i++) {
+    ThreadPool::Schedule(tp.get(), [&]() {
+      ThreadPool::Schedule(tp.get(), [&]() {
+        ctr++;
+        b.Notify();
+      });
+      ctr++;
+      b.Notify();
+    });
+  }
+  b.Wait();
+  ASSERT_EQ(ctr, num_tasks * 2);
+}
+
+TEST(ThreadPoolTest, TestAdaptiveSpinPolicy) {
+  using namespace std::chrono_literals;
+  AdaptiveSpinPolicy policy(1000us);
+  // no gaps observed yet, spin for the whole budget
+  ASSERT_EQ(policy.SpinLimit(), 1000us);
+
+  // short gaps, spin for a little longer than them
+  for (int i = 0; i < 100; i++) {
+    policy.RecordGap(10us);
+  }
+  ASSERT_GE(policy.SpinLimit(), 20us);
+  ASSERT_LT(policy.SpinLimit(), 100us);
+
+  // gaps longer than the budget, only spin briefly
+  for (int i = 0; i < 100; i++) {
+    policy.RecordGap(1s);
+  }
+  ASSERT_LT(policy.SpinLimit(), 100us);
+  ASSERT_LE(policy.AverageGap(), 4000us);
+
+  // a burst of short gaps brings the spinning back quickly
+  for (int i = 0; i < 16; i++) {
+    policy.RecordGap(10us);
+  }
+  ASSERT_GE(policy.SpinLimit(), 100us);
+  ASSERT_LE(policy.SpinLimit(), 1000us);
+}
+
+TEST(ThreadPoolTest, TestAdaptiveSpinning) {
+  ThreadOptions to;
+  to.adaptive_spin_budget_us = 100;
+  auto tp = std::make_unique<ThreadPool>(&onnxruntime::Env::Default(), to, nullptr, 4, true);
+  ThreadPool::StartProfiling(tp.get());
+
+  constexpr int num_tasks = 256;
+  auto test_data = CreateTestData(num_tasks);
+  for (int l = 0; l < 20; l++) {
+    ThreadPool::TrySimpleParallelFor(tp.get(), num_tasks, [&](std::ptrdiff_t i) {
+      IncrementElement(*test_data, i);
+    });
+    // alternate gaps the workers can spin through with gaps they should block in
+    std::this_thread::sleep_for(std::chrono::microseconds(l % 2 == 0 ? 10 : 1000));
+  }
+  ValidateTestData(*test_data, 20);
+
+  const std::string stats = ThreadPool::StopProfiling(tp.get());
+  ASSERT_NE(stats.find("\"num_spin_hit\""), std::string::npos);
+  ASSERT_NE(stats.find("\"num_block\""), std::string::npos);
+  ASSERT_NE(stats.find("\"spin_limit_us\""), std::string::npos);
+}
+
+TEST(ThreadPoolTest, TestQueueDepth) {
+  ASSERT_EQ(ThreadPool::QueueDepth(nullptr), 0u);
+
+  // 2 worker threads
+  auto tp = std::make_unique<ThreadPool>(&onnxruntime::Env::Default(), ThreadOptions{}, nullptr, 3, true);
+  ASSERT_EQ(ThreadPool::QueueDepth(tp.get()), 0u);
+
+  // keep both workers busy so the tasks scheduled next stay in the queues
+  std::atomic<int> num_busy{0};
+  std::atomic<bool> release{false};
+  std::atomic<int> num_done{0};
+  for (int i = 0; i < 2; i++) {
+    ThreadPool::Schedule(tp.get(), [&]() {
+      ++num_busy;
+      while (!release) {
+        std::this_thread::yield();
+      }
+      ++num_done;
+    });
+  }
+
+  while (num_busy < 2) {
+    std::this_thread::yield();
+  }
+
+  for (int i = 0; i < 3; i++) {
+    ThreadPool::Schedule(tp.get(), [&]() { ++num_done; });
+  }
+
+  ASSERT_EQ(ThreadPool::QueueDepth(tp.get()), 3u);
+
+  release = true;
+  while (num_done < 5) {
+    std::this_thread::yield();
+  }
+
+  ASSERT_EQ(ThreadPool::QueueDepth(tp.get()), 0u);
+}
+
 #ifdef _WIN32
 #if WINAPI_FAMILY_PARTITION(WINAPI_PARTITION_DESKTOP)
 #pragma warning(push)
@@ -613,6 +748,31 @@ TEST(ThreadPoolTest, TestAffinityStringWellShaped) {
   }
 }
 
+TEST(ThreadPoolTest, TestNumaAware) {
+  OrtThreadPoolParams tp_params;
+  tp_params.numa_aware = true;
+  tp_params.thread_pool_size = 4;
+  // falls back to a pool that is not NUMA aware if the topology is not available
+  auto tp = concurrency::CreateThreadPool(&onnxruntime::Env::Default(), tp_params,
+                                          concurrency::ThreadPoolType::INTRA_OP);
+  ASSERT_EQ(concurrency::ThreadPool::DegreeOfParallelism(tp.get()) % 4, 0);
+
+  std::atomic<std::ptrdiff_t> ctr{0};
+  ThreadPool::TryParallelFor(tp.get(), 1024, 0.0, [&](std::ptrdiff_t s, std::ptrdiff_t e) {
+    ctr += e - s;
+  });
+  ASSERT_EQ(ctr, 1024);
+
+#ifndef ORT_NO_EXCEPTIONS
+  if (!onnxruntime::Env::Default().GetNumaNodeOfLogicalProcessors().empty()) {
+    tp_params.numa_node = 1 << 16;
+    ASSERT_THROW(concurrency::CreateThreadPool(&onnxruntime::Env::Default(), tp_params,
+                                               concurrency::ThreadPoolType::INTRA_OP),
+                 std::exception);
+  }
+#endif
+}
+
 #ifdef _WIN32
 TEST(ThreadPoolTest, TestDefaultAffinity) {
   test::CpuGroup cpu_group = {{0, 1},
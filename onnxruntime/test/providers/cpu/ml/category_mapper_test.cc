@@ -43,5 +43,75 @@ TEST(CategoryMapper, IntToString) {
 
   RunTest(dims, input, output);
 }
+
+// The categories are stored in one buffer, check the boundaries between them with empty categories, categories
+// that are prefixes of each other and a null character.
+TEST(CategoryMapper, AdjacentCategories) {
+  const std::vector<std::string> categories{"", "a", "ab", std::string("a\0b", 3), "abc", ""};
+  const std::vector<int64_t> indexes{0, 1, 2, 3, 4, 5};
+
+  const std::vector<std::string> strings{"abc", "", "ab", std::string("a\0b", 3), "a", "b", "abcd"};
+  // the last duplicate category wins in the string to int direction
+  const std::vector<int64_t> ints{4, 5, 2, 3, 1, -1, -1};
+
+  for (bool string_input : {true, false}) {
+    OpTester test("CategoryMapper", 1, onnxruntime::kMLDomain);
+    test.AddAttribute("cats_strings", categories);
+    test.AddAttribute("cats_int64s", indexes);
+    test.AddAttribute("default_string", "default");
+    test.AddAttribute<int64_t>("default_int64", -1);
+    if (string_input) {
+      test.AddInput<std::string>("X", {7}, strings);
+      test.AddOutput<int64_t>("Y", {7}, ints);
+    } else {
+      test.AddInput<int64_t>("X", {7}, {0, 1, 2, 3, 4, 5, 6});
+      test.AddOutput<std::string>("Y", {7}, {"", "a", "ab", std::string("a\0b", 3), "abc", "", "default"});
+    }
+    test.Run();
+  }
+}
+
+// Large vocabulary and input so the lookups are split over the thread pool.
+TEST(CategoryMapper, LargeVocabulary) {
+  constexpr int64_t n_categories = 10000;
+  constexpr int64_t n_rows = 100000;
+
+  std::vector<std::string> categories;
+  std::vector<int64_t> indexes;
+  for (int64_t i = 0; i < n_categories; ++i) {
+    categories.push_back("category_" + std::to_string(i));
+    indexes.push_back(i * 3);
+  }
+
+  std::vector<std::string> string_values;
+  std::vector<int64_t> int_values;
+  std::vector<std::string> strings_from_ints;
+  std::vector<int64_t> ints_from_strings;
+  for (int64_t i = 0; i < n_rows; ++i) {
+    // one row out of 7 is not in the vocabulary
+    const int64_t category = (i * 7919) % (n_categories + n_categories / 6);
+    const bool known = category < n_categories;
+    string_values.push_back(known ? categories[category] : "unknown_" + std::to_string(category));
+    ints_from_strings.push_back(known ? indexes[category] : -1);
+    int_values.push_back(known ? indexes[category] : indexes[category - n_categories] + 1);
+    strings_from_ints.push_back(known ? categories[category] : "default");
+  }
+
+  for (bool string_input : {true, false}) {
+    OpTester test("CategoryMapper", 1, onnxruntime::kMLDomain);
+    test.AddAttribute("cats_strings", categories);
+    test.AddAttribute("cats_int64s", indexes);
+    test.AddAttribute("default_string", "default");
+    test.AddAttribute<int64_t>("default_int64", -1);
+    if (string_input) {
+      test.AddInput<std::string>("X", {n_rows}, string_values);
+      test.AddOutput<int64_t>("Y", {n_rows}, ints_from_strings);
+    } else {
+      test.AddInput<int64_t>("X", {n_rows}, int_values);
+      test.AddOutput<std::string>("Y", {n_rows}, strings_from_ints);
+    }
+    test.Run();
+  }
+}
 }  // namespace test
 }  // namespace onnxruntime
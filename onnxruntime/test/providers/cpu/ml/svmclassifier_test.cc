@@ -1,6 +1,7 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <cmath>
 #include "gtest/gtest.h"
 #include "test/providers/provider_test_utils.h"
 
@@ -179,6 +180,57 @@ TEST(MLOpTest, SVMClassifierSVC) {
   test.Run();
 }
 
+TEST(MLOpTest, SVMClassifierSVCNearLargeSupportVector) {
+  OpTester test("SVMClassifier", 1, onnxruntime::kMLDomain);
+
+  // The support vectors have norms of about 3e6, and the rows are within 0.03 of one of them. |x|^2 + |sv|^2 -
+  // 2 x.sv loses the distance in the rounding of the norms here, so the kernel falls back to the direct distance.
+  const float gamma = 100.f;
+  std::vector<float> support_vectors = {1000.f, 1000.f, 1000.f,
+                                        -1000.f, -1000.f, -1000.f};
+  std::vector<float> coefficients = {1.f, -1.f};
+  std::vector<float> rho = {0.f};
+  std::vector<float> kernel_params = {gamma, 0.f, 3.f};  // gamma, coef0, degree
+  std::vector<int64_t> classes = {0, 1};
+  std::vector<int64_t> vectors_per_class = {1, 1};
+
+  std::vector<float> X = {1000.01f, 999.99f, 1000.02f,
+                          -1000.02f, -999.99f, -1000.01f,
+                          1000.f, 1000.f, 1000.f};
+
+  // exp(-gamma |x - sv|^2) of the closest support vector, the other one is too far to count.
+  auto rbf = [&](const float* x, const float* sv) {
+    float distance = 0.f;
+    for (size_t i = 0; i < 3; ++i) {
+      distance += (x[i] - sv[i]) * (x[i] - sv[i]);
+    }
+    return std::exp(-gamma * distance);
+  };
+  std::vector<float> scores_predictions;
+  std::vector<int64_t> class_predictions;
+  for (size_t row = 0; row < 3; ++row) {
+    const float score = coefficients[0] * rbf(&X[row * 3], &support_vectors[0]) +
+                        coefficients[1] * rbf(&X[row * 3], &support_vectors[3]) + rho[0];
+    scores_predictions.push_back(-score);
+    scores_predictions.push_back(score);
+    class_predictions.push_back(score > 0 ? 0 : 1);
+  }
+
+  test.AddAttribute("kernel_type", std::string("RBF"));
+  test.AddAttribute("coefficients", coefficients);
+  test.AddAttribute("support_vectors", support_vectors);
+  test.AddAttribute("vectors_per_class", vectors_per_class);
+  test.AddAttribute("rho", rho);
+  test.AddAttribute("kernel_params", kernel_params);
+  test.AddAttribute("classlabels_ints", classes);
+
+  test.AddInput<float>("X", {3, 3}, X);
+  test.AddOutput<int64_t>("Y", {3}, class_predictions);
+  test.AddOutput<float>("Z", {3, 2}, scores_predictions);
+
+  test.Run();
+}
+
 TEST(MLOpTest, SVMClassifierSVCDouble) {
   OpTester test("SVMClassifier", 1, onnxruntime::kMLDomain);
 
@@ -1,6 +1,7 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <cmath>
 #include "gtest/gtest.h"
 #include "test/providers/provider_test_utils.h"
 
@@ -57,6 +58,49 @@ TEST(MLOpTest, SVMRegressorNuSVC) {
   test.Run();
 }
 
+TEST(MLOpTest, SVMRegressorNearLargeSupportVector) {
+  OpTester test("SVMRegressor", 1, onnxruntime::kMLDomain);
+
+  // The support vectors have norms of about 3e6, and the rows are within 0.03 of one of them. |x|^2 + |sv|^2 -
+  // 2 x.sv loses the distance in the rounding of the norms here, so the kernel falls back to the direct distance.
+  const float gamma = 100.f;
+  std::vector<float> support_vectors = {1000.f, 1000.f, 1000.f,
+                                        -1000.f, -1000.f, -1000.f};
+  std::vector<float> coefficients = {2.f, 3.f};
+  std::vector<float> rho = {0.5f};
+  std::vector<float> kernel_params = {gamma, 0.f, 3.f};  // gamma, coef0, degree
+
+  std::vector<float> X = {1000.01f, 999.99f, 1000.02f,
+                          -1000.02f, -999.99f, -1000.01f,
+                          1000.f, 1000.f, 1000.f,
+                          0.f, 0.f, 0.f};
+
+  auto rbf = [&](const float* x, const float* sv) {
+    float distance = 0.f;
+    for (size_t i = 0; i < 3; ++i) {
+      distance += (x[i] - sv[i]) * (x[i] - sv[i]);
+    }
+    return std::exp(-gamma * distance);
+  };
+  std::vector<float> predictions;
+  for (size_t row = 0; row < 4; ++row) {
+    predictions.push_back(coefficients[0] * rbf(&X[row * 3], &support_vectors[0]) +
+                          coefficients[1] * rbf(&X[row * 3], &support_vectors[3]) + rho[0]);
+  }
+
+  test.AddAttribute("kernel_type", std::string("RBF"));
+  test.AddAttribute("coefficients", coefficients);
+  test.AddAttribute("support_vectors", support_vectors);
+  test.AddAttribute("rho", rho);
+  test.AddAttribute("kernel_params", kernel_params);
+  test.AddAttribute("n_supports", static_cast<int64_t>(2));
+
+  test.AddInput<float>("X", {4, 3}, X);
+  test.AddOutput<float>("Y", {4, 1}, predictions);
+
+  test.Run();
+}
+
 TEST(MLOpTest, SVMRegressorNuSVCPolyKernel) {
   OpTester test("SVMRegressor", 1, onnxruntime::kMLDomain);
 
@@ -1,6 +1,10 @@
 // Copyright (c) Microsoft Corporation. All rights reserved.
 // Licensed under the MIT License.
 
+#include <cmath>
+#include <limits>
+#include <random>
+
 #include "gtest/gtest.h"
 #include "test/providers/provider_test_utils.h"
 
@@ -885,5 +889,138 @@ TEST(MLOpTest, TreeRegressorBranchEq) {
   test.Run();
 }
 
+// Generates random trees sharing the same mode, evaluated with QuickScorer if max_depth <= 6 or with the compact
+// layout otherwise, and compares the outputs with a node by node evaluation of the trees.
+void GenRandomTreesAndRunTest(const std::string& mode, int64_t n_targets, int64_t n_rows, int n_trees,
+                              int max_depth = 6) {
+  OpTester test("TreeEnsembleRegressor", 3, onnxruntime::kMLDomain);
+
+  constexpr int64_t n_features = 3;
+  const size_t n_outputs = static_cast<size_t>(n_targets);
+  std::mt19937 gen(static_cast<unsigned int>(n_targets * 1000 + n_rows + n_trees));
+  std::uniform_int_distribution<int> values(0, 15);
+
+  std::vector<int64_t> nodes_treeids, nodes_nodeids, nodes_featureids, nodes_truenodeids, nodes_falsenodeids;
+  std::vector<int64_t> nodes_missing_value_tracks_true;
+  std::vector<float> nodes_values;
+  std::vector<std::string> nodes_modes;
+  std::vector<int64_t> target_treeids, target_nodeids, target_ids;
+  std::vector<float> target_weights;
+  std::vector<float> leaf_weights;
+
+  // Nodes are added depth first, a node is a leaf with probability 1/4 or at the maximum depth.
+  for (int64_t tree = 0; tree < n_trees; ++tree) {
+    int64_t first_node = static_cast<int64_t>(nodes_nodeids.size());
+    std::vector<std::pair<int64_t, int>> stack = {{0, 0}};
+    int64_t n_nodes = 1;
+    while (!stack.empty()) {
+      auto [id, depth] = stack.back();
+      stack.pop_back();
+      size_t k = static_cast<size_t>(first_node + id);
+      if (nodes_nodeids.size() <= k) {
+        nodes_nodeids.resize(k + 1);
+        nodes_treeids.resize(k + 1);
+        nodes_featureids.resize(k + 1);
+        nodes_truenodeids.resize(k + 1);
+        nodes_falsenodeids.resize(k + 1);
+        nodes_missing_value_tracks_true.resize(k + 1);
+        nodes_values.resize(k + 1);
+        nodes_modes.resize(k + 1);
+        leaf_weights.resize((k + 1) * n_outputs);
+      }
+      nodes_nodeids[k] = id;
+      nodes_treeids[k] = tree;
+      if (depth == max_depth || (depth > 0 && values(gen) < 4)) {
+        nodes_modes[k] = "LEAF";
+        for (int64_t t = 0; t < n_targets; ++t) {
+          target_treeids.push_back(tree);
+          target_nodeids.push_back(id);
+          target_ids.push_back(t);
+          target_weights.push_back(static_cast<float>(values(gen)) * 0.5f);
+          leaf_weights[k * n_outputs + static_cast<size_t>(t)] = target_weights.back();
+        }
+        continue;
+      }
+      nodes_modes[k] = mode;
+      nodes_featureids[k] = values(gen) % n_features;
+      nodes_values[k] = static_cast<float>(values(gen)) * 0.25f;
+      nodes_missing_value_tracks_true[k] = values(gen) % 2;
+      nodes_truenodeids[k] = n_nodes++;
+      nodes_falsenodeids[k] = n_nodes++;
+      stack.push_back({nodes_truenodeids[k], depth + 1});
+      stack.push_back({nodes_falsenodeids[k], depth + 1});
+    }
+  }
+
+  // Rows take values on the same grid as the thresholds and some are missing.
+  std::vector<float> X(static_cast<size_t>(n_rows * n_features));
+  for (auto& x : X) {
+    int v = values(gen);
+    x = v == 15 ? std::numeric_limits<float>::quiet_NaN() : static_cast<float>(v) * 0.25f;
+  }
+
+  std::vector<size_t> roots;
+  for (size_t k = 0; k < nodes_nodeids.size(); ++k) {
+    if (nodes_nodeids[k] == 0) {
+      roots.push_back(k);
+    }
+  }
+
+  std::vector<float> Y(static_cast<size_t>(n_rows * n_targets), 0.f);
+  for (int64_t i = 0; i < n_rows; ++i) {
+    for (size_t first_node : roots) {
+      size_t k = first_node;
+      while (nodes_modes[k] != "LEAF") {
+        float x = X[static_cast<size_t>(i * n_features + nodes_featureids[k])];
+        float th = nodes_values[k];
+        bool is_true = mode == "BRANCH_LEQ"   ? x <= th
+                       : mode == "BRANCH_LT"  ? x < th
+                       : mode == "BRANCH_GTE" ? x >= th
+                                              : x > th;
+        is_true = is_true || (std::isnan(x) && nodes_missing_value_tracks_true[k] == 1);
+        k = first_node + static_cast<size_t>(is_true ? nodes_truenodeids[k] : nodes_falsenodeids[k]);
+      }
+      for (size_t t = 0; t < n_outputs; ++t) {
+        Y[static_cast<size_t>(i) * n_outputs + t] += leaf_weights[k * n_outputs + t];
+      }
+    }
+  }
+
+  test.AddAttribute("nodes_truenodeids", nodes_truenodeids);
+  test.AddAttribute("nodes_falsenodeids", nodes_falsenodeids);
+  test.AddAttribute("nodes_treeids", nodes_treeids);
+  test.AddAttribute("nodes_nodeids", nodes_nodeids);
+  test.AddAttribute("nodes_featureids", nodes_featureids);
+  test.AddAttribute("nodes_values", nodes_values);
+  test.AddAttribute("nodes_modes", nodes_modes);
+  test.AddAttribute("nodes_missing_value_tracks_true", nodes_missing_value_tracks_true);
+  test.AddAttribute("target_treeids", target_treeids);
+  test.AddAttribute("target_nodeids", target_nodeids);
+  test.AddAttribute("target_ids", target_ids);
+  test.AddAttribute("target_weights", target_weights);
+  test.AddAttribute("n_targets", n_targets);
+
+  test.AddInput<float>("X", {n_rows, n_features}, X);
+  test.AddOutput<float>("Y", {n_rows, n_targets}, Y);
+  test.Run();
+}
+
+TEST(MLOpTest, TreeRegressorQuickScorer) {
+  for (const char* mode : {"BRANCH_LEQ", "BRANCH_LT", "BRANCH_GTE", "BRANCH_GT"}) {
+    GenRandomTreesAndRunTest(mode, 1, 3, 100);    // section C
+    GenRandomTreesAndRunTest(mode, 1, 201, 100);  // section D or E
+    GenRandomTreesAndRunTest(mode, 2, 3, 100);    // section C2
+    GenRandomTreesAndRunTest(mode, 2, 201, 100);  // section D2 or E2
+  }
+}
+
+TEST(MLOpTest, TreeRegressorCompactTrees) {
+  for (const char* mode : {"BRANCH_LEQ", "BRANCH_LT", "BRANCH_GTE", "BRANCH_GT"}) {
+    GenRandomTreesAndRunTest(mode, 1, 3, 100, 10);    // section C
+    GenRandomTreesAndRunTest(mode, 1, 201, 100, 10);  // section D or E
+    GenRandomTreesAndRunTest(mode, 2, 201, 100, 10);  // section D2 or E2
+  }
+}
+
 }  // namespace test
 }  // namespace onnxruntime
@@ -80,6 +80,20 @@ class PromptConfig:
     qk_output: QKOutputType = QKOutputType.NO_OUTPUT
 
 
+@dataclass
+class QuantizedKvCacheConfig:
+    batch_size: int = 0
+    sequence_length: int = 0
+    # sequence length of the present key and value
+    kv_sequence_length: int = 0
+    num_heads: int = 0
+    kv_num_heads: int = 0
+    head_size: int = 0
+    kv_cache_bit_width: int = 8
+    has_head_sink: bool = False
+    is_prompt: bool = False
+
+
 # LLaMA Microsoft model
 class LlamaMSRotaryEmbedding(torch.nn.Module):
     def __init__(self):
@@ -2449,6 +2463,359 @@ def parity_check_gqa_past_no_buff(
     return all_close
 
 
+def create_group_query_attention_graph_quantized_kv(
+    config,
+    ort_type,
+    past_kv_seqlen,
+    share_buffer=True,
+    local_window_size=-1,
+    packed=False,
+):
+    has_past = past_kv_seqlen > 0
+    cache_type = TensorProto.INT8 if config.kv_cache_bit_width == 8 else TensorProto.UINT8
+    cache_head_size = config.head_size * config.kv_cache_bit_width // 8
+    present_kv_seqlen = past_kv_seqlen if share_buffer and has_past else config.kv_sequence_length
+
+    nodes = [
+        helper.make_node(
+            "GroupQueryAttention",
+            [
+                "query",
+                "key" if not packed else "",
+                "value" if not packed else "",
+                "past_key" if has_past else "",
+                "past_value" if has_past else "",
+                "seqlens_k",
+                "total_sequence_length",
+                "",
+                "",
+                "",
+                "",
+                "head_sink" if config.has_head_sink else "",
+                "past_key_scale" if has_past else "",
+                "past_value_scale" if has_past else "",
+            ],
+            ["output", "present_key", "present_value", "", "present_key_scale", "present_value_scale"],
+            "GroupQueryAttention_0",
+            num_heads=config.num_heads,
+            kv_num_heads=config.kv_num_heads,
+            local_window_size=local_window_size,
+            kv_cache_bit_width=config.kv_cache_bit_width,
+            domain="com.microsoft",
+        ),
+    ]
+
+    q_hidden_size = config.num_heads * config.head_size
+    kv_hidden_size = config.kv_num_heads * config.head_size
+    graph_input = [
+        helper.make_tensor_value_info(
+            "query",
+            ort_type,
+            [
+                config.batch_size,
+                config.sequence_length,
+                q_hidden_size if not packed else q_hidden_size + 2 * kv_hidden_size,
+            ],
+        ),
+        helper.make_tensor_value_info("seqlens_k", TensorProto.INT32, [config.batch_size]),
+        helper.make_tensor_value_info("total_sequence_length", TensorProto.INT32, [1]),
+    ]
+
+    if not packed:
+        graph_input += [
+            helper.make_tensor_value_info("key", ort_type, [config.batch_size, config.sequence_length, kv_hidden_size]),
+            helper.make_tensor_value_info(
+                "value", ort_type, [config.batch_size, config.sequence_length, kv_hidden_size]
+            ),
+        ]
+
+    if has_past:
+        graph_input += [
+            helper.make_tensor_value_info(
+                name, cache_type, [config.batch_size, config.kv_num_heads, past_kv_seqlen, cache_head_size]
+            )
+            for name in ["past_key", "past_value"]
+        ]
+        graph_input += [
+            helper.make_tensor_value_info(
+                name, TensorProto.FLOAT, [config.batch_size, config.kv_num_heads, past_kv_seqlen]
+            )
+            for name in ["past_key_scale", "past_value_scale"]
+        ]
+
+    if config.has_head_sink:
+        graph_input += [
+            helper.make_tensor_value_info("head_sink", ort_type, [config.num_heads]),
+        ]
+
+    graph_output = [
+        helper.make_tensor_value_info(
+            "output",
+            ort_type,
+            [config.batch_size, config.sequence_length, q_hidden_size],
+        ),
+    ]
+    graph_output += [
+        helper.make_tensor_value_info(
+            name, cache_type, [config.batch_size, config.kv_num_heads, present_kv_seqlen, cache_head_size]
+        )
+        for name in ["present_key", "present_value"]
+    ]
+    graph_output += [
+        helper.make_tensor_value_info(
+            name, TensorProto.FLOAT, [config.batch_size, config.kv_num_heads, present_kv_seqlen]
+        )
+        for name in ["present_key_scale", "present_value_scale"]
+    ]
+
+    graph = helper.make_graph(
+        nodes,
+        "GroupQueryAttention_Graph",
+        graph_input,
+        graph_output,
+    )
+
+    model = helper.make_model(graph)
+    return model.SerializeToString()
+
+
+def gqa_quantized_kv_func(
+    config,
+    ort_inputs,
+    past_kv_seqlen,
+    share_buffer=True,
+    local_window_size=-1,
+    packed=False,
+    ort_type=TensorProto.FLOAT16,
+):
+    onnx_model_str = create_group_query_attention_graph_quantized_kv(
+        config, ort_type, past_kv_seqlen, share_buffer, local_window_size, packed
+    )
+    sess_options = SessionOptions()
+    ort_session = InferenceSession(onnx_model_str, sess_options, providers=["CPUExecutionProvider"])
+    if not (share_buffer and past_kv_seqlen > 0):
+        return ort_session.run(None, ort_inputs)
+
+    # the present key and value and their scales are written in place into the past ones
+    io_binding = ort_session.io_binding()
+    shared_names = ("past_key", "past_value", "past_key_scale", "past_value_scale")
+    shared = {name: OrtValue.ortvalue_from_numpy(ort_inputs[name], "cpu", 0) for name in shared_names}
+    for name, value in ort_inputs.items():
+        if name in shared:
+            io_binding.bind_ortvalue_input(name, shared[name])
+        else:
+            io_binding.bind_cpu_input(name, value)
+    io_binding.bind_output("output")
+    for name in shared_names:
+        io_binding.bind_ortvalue_output(name.replace("past", "present"), shared[name])
+    ort_session.run_with_iobinding(io_binding)
+
+    output = io_binding.copy_outputs_to_cpu()[0]
+    return (output, *(shared[name].numpy() for name in shared_names))
+
+
+def quantize_kv_cache_ref(x, bit_width):
+    """
+    Arguments:
+        x: (batch_size, kv_num_heads, seqlen, head_size) in float32
+    Output:
+        cache: (batch_size, kv_num_heads, seqlen, head_size * bit_width / 8), int8, or uint8 with two values per
+            byte, the even channel in the low nibble, biased by 8
+        scale: (batch_size, kv_num_heads, seqlen), the largest magnitude of each head of each token over the largest
+            level, so that no value is clamped
+    """
+    max_level = numpy.float32(127 if bit_width == 8 else 7)
+    max_magnitude = numpy.abs(x).max(axis=-1, keepdims=True)
+    inverse_scale = numpy.divide(
+        max_level, max_magnitude, out=numpy.zeros_like(max_magnitude), where=max_magnitude > 0
+    )
+    scale = (max_magnitude / max_level)[..., 0]
+    q = numpy.clip(numpy.rint(x * inverse_scale), -max_level, max_level)
+    if bit_width == 8:
+        return q.astype(numpy.int8), scale
+    q = (q + 8).astype(numpy.uint8)
+    return q[..., 0::2] | (q[..., 1::2] << 4), scale
+
+
+def dequantize_kv_cache_ref(cache, scale, bit_width):
+    """
+    Arguments:
+        cache: (batch_size, kv_num_heads, seqlen, head_size * bit_width / 8)
+        scale: (batch_size, kv_num_heads, seqlen)
+    Output:
+        x: (batch_size, kv_num_heads, seqlen, head_size) in float32
+    """
+    if bit_width == 8:
+        q = cache.astype(numpy.float32)
+    else:
+        q = numpy.empty((*cache.shape[:-1], cache.shape[-1] * 2), dtype=numpy.float32)
+        q[..., 0::2] = (cache & 0x0F).astype(numpy.float32) - 8
+        q[..., 1::2] = (cache >> 4).astype(numpy.float32) - 8
+    return q * scale[..., None]
+
+
+def parity_check_gqa_quantized_kv(
+    config,
+    torch_type,
+    numpy_type,
+    ort_type,
+    share_buffer=True,
+    local=False,
+    packed=False,
+    rtol=RTOL,
+    atol=ATOL,
+):
+    b, s, n, n_kv, h = (
+        config.batch_size,
+        config.sequence_length,
+        config.num_heads,
+        config.kv_num_heads,
+        config.head_size,
+    )
+    bit_width = config.kv_cache_bit_width
+    present_kv_seqlen = config.kv_sequence_length
+
+    q = torch.randn(b, s, n, h, device="cpu", dtype=torch_type, requires_grad=False)
+    # the magnitude of the new key and value varies by orders of magnitude between tokens and heads, a range that
+    # no fixed scale could cover without clamping
+    magnitude = torch.exp2(torch.randint(-4, 5, (2, b, s, n_kv, 1)).float())
+    new_k = (torch.randn(b, s, n_kv, h) * magnitude[0]).to(torch_type)
+    new_v = (torch.randn(b, s, n_kv, h) * magnitude[1]).to(torch_type)
+    head_sink = get_custom_head_sink(n, torch_type=torch_type) if config.has_head_sink else None
+
+    if config.is_prompt:
+        assert share_buffer or present_kv_seqlen == s
+        past_seqlens = numpy.zeros(b, dtype=numpy.int32)
+        past_kv_seqlen = present_kv_seqlen if share_buffer else 0
+        total_sequence_length = s
+    else:
+        assert s == 1 or b == 1
+        past_seqlens = numpy.random.randint(0, present_kv_seqlen - s + 1, size=b).astype(numpy.int32)
+        past_kv_seqlen = present_kv_seqlen if share_buffer else present_kv_seqlen - s
+        total_sequence_length = present_kv_seqlen
+
+    # the past key and value are quantized random data, including the unused positions of a shared buffer
+    past_k, past_k_scale = quantize_kv_cache_ref(
+        numpy.random.randn(b, n_kv, past_kv_seqlen, h).astype(numpy.float32), bit_width
+    )
+    past_v, past_v_scale = quantize_kv_cache_ref(
+        numpy.random.randn(b, n_kv, past_kv_seqlen, h).astype(numpy.float32), bit_width
+    )
+
+    # the new key and value are quantized and appended after the past ones, with their scales
+    new_k_cache, new_k_scale = quantize_kv_cache_ref(new_k.float().numpy().transpose(0, 2, 1, 3), bit_width)
+    new_v_cache, new_v_scale = quantize_kv_cache_ref(new_v.float().numpy().transpose(0, 2, 1, 3), bit_width)
+    present_k_ref = numpy.zeros((b, n_kv, present_kv_seqlen, new_k_cache.shape[-1]), dtype=new_k_cache.dtype)
+    present_v_ref = numpy.zeros_like(present_k_ref)
+    present_k_scale_ref = numpy.zeros((b, n_kv, present_kv_seqlen), dtype=numpy.float32)
+    present_v_scale_ref = numpy.zeros_like(present_k_scale_ref)
+    for i in range(b):
+        past_seqlen = past_seqlens[i]
+        present_k_ref[i, :, :past_seqlen] = past_k[i, :, :past_seqlen]
+        present_v_ref[i, :, :past_seqlen] = past_v[i, :, :past_seqlen]
+        present_k_ref[i, :, past_seqlen : past_seqlen + s] = new_k_cache[i]
+        present_v_ref[i, :, past_seqlen : past_seqlen + s] = new_v_cache[i]
+        present_k_scale_ref[i, :, :past_seqlen] = past_k_scale[i, :, :past_seqlen]
+        present_v_scale_ref[i, :, :past_seqlen] = past_v_scale[i, :, :past_seqlen]
+        present_k_scale_ref[i, :, past_seqlen : past_seqlen + s] = new_k_scale[i]
+        present_v_scale_ref[i, :, past_seqlen : past_seqlen + s] = new_v_scale[i]
+
+    # Pytorch to compare, on the dequantized present key and value
+    window_size = (-1, 0)
+    left_window_size = -1
+    if local:
+        left_window_size = random.randint(1, present_kv_seqlen)
+        window_size = (left_window_size, 0)
+    k_ref = torch.from_numpy(
+        dequantize_kv_cache_ref(present_k_ref, present_k_scale_ref, bit_width).transpose(0, 2, 1, 3)
+    )
+    v_ref = torch.from_numpy(
+        dequantize_kv_cache_ref(present_v_ref, present_v_scale_ref, bit_width).transpose(0, 2, 1, 3)
+    )
+    arange = rearrange(torch.arange(present_kv_seqlen, device="cpu"), "s -> 1 s")
+    key_padding_mask = arange < rearrange(torch.from_numpy(past_seqlens + s), "b -> b 1")
+    out_ref, _, _ = attention_ref(
+        q.float(),
+        k_ref,
+        v_ref,
+        None,
+        key_padding_mask,
+        0.0,
+        None,
+        causal=True,
+        window_size=window_size,
+        head_sink=head_sink.float() if head_sink is not None else None,
+    )
+    out_ref = out_ref.detach().cpu().numpy()
+
+    # ORT function
+    ort_inputs = {
+        "seqlens_k": past_seqlens + s - 1,
+        "total_sequence_length": numpy.array([total_sequence_length], dtype=numpy.int32),
+    }
+    if packed:
+        ort_inputs["query"] = torch.concatenate([q, new_k, new_v], dim=2).reshape(b, s, -1).numpy()
+    else:
+        ort_inputs["query"] = q.reshape(b, s, -1).numpy()
+        ort_inputs["key"] = new_k.reshape(b, s, -1).numpy()
+        ort_inputs["value"] = new_v.reshape(b, s, -1).numpy()
+    if past_kv_seqlen > 0:
+        ort_inputs["past_key"] = past_k
+        ort_inputs["past_value"] = past_v
+        ort_inputs["past_key_scale"] = past_k_scale
+        ort_inputs["past_value_scale"] = past_v_scale
+    if config.has_head_sink:
+        ort_inputs["head_sink"] = head_sink.numpy()
+
+    out, present_k, present_v, present_k_scale, present_v_scale = gqa_quantized_kv_func(
+        config, ort_inputs, past_kv_seqlen, share_buffer, left_window_size, packed, ort_type
+    )
+    out = numpy.reshape(out, (b, s, n, h)).astype(numpy.float32)
+
+    # Make sure the new key and value and their scales are quantized and appended correctly
+    for i in range(b):
+        total_seqlen = past_seqlens[i] + s
+        assert numpy.array_equal(present_k[i, :, :total_seqlen], present_k_ref[i, :, :total_seqlen])
+        assert numpy.array_equal(present_v[i, :, :total_seqlen], present_v_ref[i, :, :total_seqlen])
+        assert numpy.array_equal(present_k_scale[i, :, :total_seqlen], present_k_scale_ref[i, :, :total_seqlen])
+        assert numpy.array_equal(present_v_scale[i, :, :total_seqlen], present_v_scale_ref[i, :, :total_seqlen])
+
+    # Compare results
+    all_close = numpy.allclose(out, out_ref, rtol=rtol, atol=atol, equal_nan=True)
+    correct = GREEN + "True" + RESET if all_close else RED + "False" + RESET
+    print(
+        "Quantized KV-cache",
+        " bits:",
+        bit_width,
+        " prompt:",
+        config.is_prompt,
+        " share_buffer:",
+        share_buffer,
+        " packed:",
+        packed,
+        " local:",
+        local,
+        " head_sink:",
+        config.has_head_sink,
+        " B:",
+        b,
+        " S:",
+        s,
+        " kv S:",
+        present_kv_seqlen,
+        " N:",
+        n,
+        " kv N:",
+        n_kv,
+        " h:",
+        h,
+        " Mean Error:",
+        numpy.mean(numpy.abs(out - out_ref)),
+        correct,
+    )
+    return all_close
+
+
 class TestGQA(unittest.TestCase):
     def setUp(self):
         # Define precision configurations
@@ -2676,5 +3043,81 @@ class TestGQA(unittest.TestCase):
         )
 
 
+class TestGQAQuantizedKvCache(unittest.TestCase):
+    def setUp(self):
+        # The cache is quantized in float32 for both input types, so only the output is rounded to float16.
+        self.precision_configs = [
+            {
+                "ort_type": TensorProto.FLOAT16,
+                "torch_type": torch.float16,
+                "numpy_type": numpy.float16,
+                "rtol": 1e-2,
+                "atol": 1e-2,
+            },
+            {
+                "ort_type": TensorProto.FLOAT,
+                "torch_type": torch.float32,
+                "numpy_type": numpy.float32,
+                "rtol": 1e-4,
+                "atol": 1e-4,
+            },
+        ]
+
+    def run_test_config(self, is_prompt, batches, seqs, num_h, h_sizes):
+        random.seed(69)
+        numpy.random.seed(69)
+        torch.manual_seed(69)
+
+        for precision in self.precision_configs:
+            for bit_width in [8, 4]:
+                for b in batches:
+                    for s, s2 in seqs:
+                        for n, n2 in num_h:
+                            for h in h_sizes:
+                                for share_buffer in [True, False]:
+                                    for local in [False, True]:
+                                        for packed in [False, True]:
+                                            for head_sink in [False, True]:
+                                                config = QuantizedKvCacheConfig(
+                                                    b,
+                                                    s,
+                                                    s if is_prompt and not share_buffer else s2,
+                                                    n,
+                                                    n2,
+                                                    h,
+                                                    bit_width,
+                                                    head_sink,
+                                                    is_prompt,
+                                                )
+                                                all_close = parity_check_gqa_quantized_kv(
+                                                    config,
+                                                    precision["torch_type"],
+                                                    precision["numpy_type"],
+                                                    precision["ort_type"],
+                                                    share_buffer=share_buffer,
+                                                    local=local,
+                                                    packed=packed,
+                                                    rtol=precision["rtol"],
+                                                    atol=precision["atol"],
+                                                )
+                                                self.assertTrue(all_close)
+
+    def test_gqa_quantized_kv_cache_no_past(self):
+        print("-------- TEST GQA QUANTIZED KV CACHE NO PAST (PROMPT CASE) ---------")
+        batches = [2] if pipeline_mode else [1, 3]
+        seqs = [(35, 64)] if pipeline_mode else [(35, 64), (127, 160)]
+        num_h = [(6, 3)] if pipeline_mode else [(6, 6), (6, 3), (9, 3)]
+        h_sizes = [40] if pipeline_mode else [32, 40, 64, 128]
+        self.run_test_config(True, batches, seqs, num_h, h_sizes)
+
+    def test_gqa_quantized_kv_cache_past(self):
+        print("-------- TEST GQA QUANTIZED KV CACHE PAST (TOKEN GEN) ---------")
+        batches = [3] if pipeline_mode else [1, 3, 5]
+        seqs = [(1, 128)] if pipeline_mode else [(1, 128), (1, 339), (1, 1024)]
+        num_h = [(6, 3)] if pipeline_mode else [(6, 6), (6, 3), (9, 3)]
+        h_sizes = [40] if pipeline_mode else [32, 40, 64, 128]
+        self.run_test_config(False, batches, seqs, num_h, h_sizes)
+
+
 if __name__ == "__main__":
     unittest.main()
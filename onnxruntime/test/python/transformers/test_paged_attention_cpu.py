@@ -0,0 +1,343 @@
+# -------------------------------------------------------------------------
+# Copyright (c) Microsoft Corporation.  All rights reserved.
+# Licensed under the MIT License.  See License.txt in the project root for
+# license information.
+# -------------------------------------------------------------------------
+import math
+import random
+import unittest
+
+import numpy
+import torch
+from einops import rearrange, repeat
+from onnx import TensorProto, helper
+from parameterized import parameterized
+from test_gqa_cpu import LlamaMSRotaryEmbedding
+from test_paged_attention_cuda import attention_ref
+
+from onnxruntime import InferenceSession, OrtValue, SessionOptions
+
+torch.manual_seed(0)
+random.seed(0)
+
+pipeline_mode = True  # Reduces number of tests so pipeline doesn't time out
+
+
+class Config:
+    def __init__(
+        self,
+        batch_size,
+        sequence_length,
+        total_sequence_length,
+        num_heads,
+        kv_num_heads,
+        head_size,
+        paged_kv_block_size,
+        local,
+        rotary,
+        rotary_interleaved,
+        packed,
+        softcap,
+        torch_type,
+    ):
+        self.batch_size = batch_size
+        self.sequence_length = sequence_length
+        self.total_sequence_length = total_sequence_length
+        self.num_heads = num_heads
+        self.kv_num_heads = kv_num_heads
+        self.head_size = head_size
+        self.paged_kv_block_size = paged_kv_block_size
+        self.local = local
+        self.rotary = rotary
+        self.rotary_interleaved = rotary_interleaved
+        self.packed = packed
+        self.softcap = softcap
+        self.torch_type = torch_type
+
+    def __repr__(self):
+        return (
+            f"Config(batch_size={self.batch_size}, sequence_length={self.sequence_length}, "
+            f"total_sequence_length={self.total_sequence_length}, num_heads={self.num_heads}, "
+            f"kv_num_heads={self.kv_num_heads}, head_size={self.head_size}, "
+            f"paged_kv_block_size={self.paged_kv_block_size}, local={self.local}, rotary={self.rotary}, "
+            f"rotary_interleaved={self.rotary_interleaved}, packed={self.packed}, softcap={self.softcap}, "
+            f"type={self.torch_type})"
+        )
+
+
+def create_paged_attention_graph(config, num_tokens, num_blocks, max_blocks_per_sequence, local_window_size=-1):
+    ort_type = TensorProto.FLOAT16 if config.torch_type == torch.float16 else TensorProto.FLOAT
+    nodes = [
+        helper.make_node(
+            "PagedAttention",
+            [
+                "query",
+                "key" if not config.packed else "",
+                "value" if not config.packed else "",
+                "key_cache",
+                "value_cache",
+                "cumulative_sequence_length",
+                "past_seqlens",
+                "block_table",
+                "cos_cache" if config.rotary else "",
+                "sin_cache" if config.rotary else "",
+            ],
+            ["output", "key_cache_out", "value_cache_out"],
+            "PagedAttention_0",
+            num_heads=config.num_heads,
+            kv_num_heads=config.kv_num_heads,
+            local_window_size=local_window_size,
+            do_rotary=config.rotary,
+            rotary_interleaved=config.rotary_interleaved,
+            softcap=config.softcap,
+            domain="com.microsoft",
+        ),
+    ]
+
+    query_hidden_size = config.num_heads * config.head_size
+    kv_hidden_size = config.kv_num_heads * config.head_size
+    cache_shape = [num_blocks, config.paged_kv_block_size, config.kv_num_heads, config.head_size]
+    graph_input = [
+        helper.make_tensor_value_info(
+            "query",
+            ort_type,
+            [num_tokens, query_hidden_size if not config.packed else query_hidden_size + 2 * kv_hidden_size],
+        ),
+        helper.make_tensor_value_info("key_cache", ort_type, cache_shape),
+        helper.make_tensor_value_info("value_cache", ort_type, cache_shape),
+        helper.make_tensor_value_info("cumulative_sequence_length", TensorProto.INT32, [config.batch_size + 1]),
+        helper.make_tensor_value_info("past_seqlens", TensorProto.INT32, [config.batch_size]),
+        helper.make_tensor_value_info("block_table", TensorProto.INT32, [config.batch_size, max_blocks_per_sequence]),
+    ]
+    if not config.packed:
+        graph_input += [
+            helper.make_tensor_value_info("key", ort_type, [num_tokens, kv_hidden_size]),
+            helper.make_tensor_value_info("value", ort_type, [num_tokens, kv_hidden_size]),
+        ]
+    if config.rotary:
+        graph_input += [
+            helper.make_tensor_value_info("cos_cache", ort_type, [config.total_sequence_length, config.head_size // 2]),
+            helper.make_tensor_value_info("sin_cache", ort_type, [config.total_sequence_length, config.head_size // 2]),
+        ]
+
+    graph_output = [
+        helper.make_tensor_value_info("output", ort_type, [num_tokens, query_hidden_size]),
+        helper.make_tensor_value_info("key_cache_out", ort_type, cache_shape),
+        helper.make_tensor_value_info("value_cache_out", ort_type, cache_shape),
+    ]
+
+    graph = helper.make_graph(nodes, "PagedAttention_Graph", graph_input, graph_output)
+    model = helper.make_model(graph)
+    return model.SerializeToString()
+
+
+def paged_attention_func(
+    config,
+    query,
+    key,
+    value,
+    key_cache,
+    value_cache,
+    cumulative_sequence_length,
+    past_seqlens,
+    block_table,
+    cos=None,
+    sin=None,
+    window_size=-1,
+):
+    onnx_model_str = create_paged_attention_graph(
+        config,
+        cumulative_sequence_length[-1].item(),
+        key_cache.shape[0],
+        block_table.shape[1],
+        local_window_size=window_size,
+    )
+    ort_session = InferenceSession(onnx_model_str, SessionOptions(), providers=["CPUExecutionProvider"])
+
+    # Bind the caches to the outputs, so they are updated in place like in a generation loop.
+    key_cache_value = OrtValue.ortvalue_from_numpy(key_cache.numpy())
+    value_cache_value = OrtValue.ortvalue_from_numpy(value_cache.numpy())
+    io_binding = ort_session.io_binding()
+    io_binding.bind_cpu_input("query", query.numpy())
+    if key is not None and value is not None:
+        io_binding.bind_cpu_input("key", key.numpy())
+        io_binding.bind_cpu_input("value", value.numpy())
+    if cos is not None and sin is not None:
+        io_binding.bind_cpu_input("cos_cache", cos.numpy())
+        io_binding.bind_cpu_input("sin_cache", sin.numpy())
+    io_binding.bind_ortvalue_input("key_cache", key_cache_value)
+    io_binding.bind_ortvalue_input("value_cache", value_cache_value)
+    io_binding.bind_cpu_input("cumulative_sequence_length", cumulative_sequence_length.numpy())
+    io_binding.bind_cpu_input("past_seqlens", past_seqlens.numpy())
+    io_binding.bind_cpu_input("block_table", block_table.numpy())
+    io_binding.bind_output("output")
+    io_binding.bind_ortvalue_output("key_cache_out", key_cache_value)
+    io_binding.bind_ortvalue_output("value_cache_out", value_cache_value)
+    ort_session.run_with_iobinding(io_binding)
+    output, key_cache_out, value_cache_out = io_binding.copy_outputs_to_cpu()
+    return torch.tensor(output), torch.tensor(key_cache_out), torch.tensor(value_cache_out)
+
+
+def gather_blocks(config, cache_paged, block_table):
+    return rearrange(
+        cache_paged[block_table.to(dtype=torch.long).flatten()],
+        "(b nblocks) block_size ... -> b (nblocks block_size) ...",
+        b=config.batch_size,
+    )[:, : config.total_sequence_length]
+
+
+def parity_check_paged_attention(config, rtol=1e-3, atol=1e-3):
+    torch_type = config.torch_type
+    q_shape = (config.batch_size, config.sequence_length, config.num_heads, config.head_size)
+    kv_shape = (config.batch_size, config.sequence_length, config.kv_num_heads, config.head_size)
+    q = torch.randn(q_shape, dtype=torch_type)
+    k_new = torch.randn(kv_shape, dtype=torch_type)
+    v_new = torch.randn(kv_shape, dtype=torch_type)
+
+    past_seqlens = torch.randint(
+        0, config.total_sequence_length - config.sequence_length + 1, (config.batch_size,), dtype=torch.int32
+    )
+    new_seqlens = torch.randint(1, config.sequence_length + 1, (config.batch_size,), dtype=torch.int32)
+    cum_seqlens = torch.cat((torch.tensor([0], dtype=torch.int32), torch.cumsum(new_seqlens, dim=0))).type(torch.int32)
+    total_seqlens = past_seqlens + new_seqlens
+
+    # Blocks are assigned to the sequences in a random order, with spare blocks left in the cache.
+    max_blocks_per_sequence = math.ceil(config.total_sequence_length / config.paged_kv_block_size)
+    num_blocks = max_blocks_per_sequence * config.batch_size * 2
+    cache_shape = (num_blocks, config.paged_kv_block_size, config.kv_num_heads, config.head_size)
+    k_cache_paged = torch.randn(cache_shape, dtype=torch_type)
+    v_cache_paged = torch.randn(cache_shape, dtype=torch_type)
+    block_table = rearrange(
+        torch.randperm(num_blocks, dtype=torch.int32)[: max_blocks_per_sequence * config.batch_size],
+        "(b nblocks) -> b nblocks",
+        b=config.batch_size,
+    )
+    k_cache = gather_blocks(config, k_cache_paged, block_table)
+    v_cache = gather_blocks(config, v_cache_paged, block_table)
+
+    left_window_size = random.randint(0, config.total_sequence_length - 1) if config.local else -1
+    window_size = (left_window_size, 0)
+
+    if config.rotary:
+        angle = torch.rand(config.total_sequence_length, config.head_size // 2) * 2 * math.pi
+        cos = torch.cos(angle).to(dtype=torch_type)
+        sin = torch.sin(angle).to(dtype=torch_type)
+        rotary = LlamaMSRotaryEmbedding()
+        cos_ref = cos.unsqueeze(0).unsqueeze(2)
+        sin_ref = sin.unsqueeze(0).unsqueeze(2)
+        q_ro = rotary(q.clone(), cos_ref, sin_ref, past_seqlens, config.rotary_interleaved).to(dtype=torch_type)
+        k_ro = rotary(k_new.clone(), cos_ref, sin_ref, past_seqlens, config.rotary_interleaved).to(dtype=torch_type)
+    else:
+        cos, sin = None, None
+        q_ro, k_ro = q, k_new
+
+    # Reference: contiguous caches with the new tokens of each sequence appended after its past tokens
+    k_cache_ref = k_cache.clone()
+    v_cache_ref = v_cache.clone()
+    for i in range(config.batch_size):
+        past, new = past_seqlens[i].item(), new_seqlens[i].item()
+        k_cache_ref[i, past : past + new] = k_ro[i, :new]
+        v_cache_ref[i, past : past + new] = v_new[i, :new]
+    k_cache_rep = repeat(k_cache_ref, "b s h d -> b s (h g) d", g=config.num_heads // config.kv_num_heads)
+    v_cache_rep = repeat(v_cache_ref, "b s h d -> b s (h g) d", g=config.num_heads // config.kv_num_heads)
+
+    total_range = rearrange(torch.arange(config.total_sequence_length), "s -> 1 s")
+    key_padding_mask = total_range < rearrange(total_seqlens, "b -> b 1")
+    query_range = rearrange(torch.arange(config.sequence_length), "s -> 1 s")
+    query_padding_mask = query_range < rearrange(new_seqlens, "b -> b 1")
+
+    out_ref, _ = attention_ref(
+        q_ro,
+        k_cache_rep,
+        v_cache_rep,
+        query_padding_mask,
+        key_padding_mask,
+        causal=True,
+        window_size=window_size,
+        softcap=config.softcap,
+    )
+    out_ref = out_ref.float().numpy()
+
+    q_unpad = torch.cat([rearrange(q[i, : new_seqlens[i]], "s n h -> s (n h)") for i in range(config.batch_size)])
+    k_unpad = torch.cat([rearrange(k_new[i, : new_seqlens[i]], "s n h -> s (n h)") for i in range(config.batch_size)])
+    v_unpad = torch.cat([rearrange(v_new[i, : new_seqlens[i]], "s n h -> s (n h)") for i in range(config.batch_size)])
+    if config.packed:
+        q_unpad = torch.cat([q_unpad, k_unpad, v_unpad], dim=1)
+        k_unpad = None
+        v_unpad = None
+
+    out, k_cache_out, v_cache_out = paged_attention_func(
+        config,
+        q_unpad,
+        k_unpad,
+        v_unpad,
+        k_cache_paged,
+        v_cache_paged,
+        cum_seqlens,
+        past_seqlens,
+        block_table,
+        cos,
+        sin,
+        left_window_size,
+    )
+    out = out.float().numpy()
+    present_k = gather_blocks(config, k_cache_out, block_table).float().numpy()
+    present_v = gather_blocks(config, v_cache_out, block_table).float().numpy()
+
+    err_msg = f" with {config}"
+    for i in range(config.batch_size):
+        total = total_seqlens[i].item()
+        numpy.testing.assert_allclose(
+            present_k[i, :total], k_cache_ref[i, :total].float().numpy(), rtol=rtol, atol=atol, err_msg=err_msg
+        )
+        numpy.testing.assert_allclose(
+            present_v[i, :total], v_cache_ref[i, :total].float().numpy(), rtol=rtol, atol=atol, err_msg=err_msg
+        )
+        out_i = out[cum_seqlens[i] : cum_seqlens[i + 1]].reshape(-1, config.num_heads, config.head_size)
+        numpy.testing.assert_allclose(out_i, out_ref[i, : new_seqlens[i]], rtol=rtol, atol=atol, err_msg=err_msg)
+
+
+def paged_attention_test_cases():
+    batches = [3] if pipeline_mode else [1, 3, 5]
+    seqs = [(1, 128), (40, 200)] if pipeline_mode else [(1, 128), (3, 1024), (40, 200), (257, 257), (64, 2048)]
+    num_h = [(8, 2)] if pipeline_mode else [(6, 6), (6, 3), (9, 3)]
+    h_sizes = [64] if pipeline_mode else [32, 64, 128, 256]
+    block_sizes = [16] if pipeline_mode else [1, 16, 256]
+
+    for torch_type in [torch.float32, torch.float16]:
+        for b in batches:
+            for s, s2 in seqs:
+                for n, n2 in num_h:
+                    for h in h_sizes:
+                        for block_size in block_sizes:
+                            for local in [False, True]:
+                                for rotary, rotary_interleaved in [(False, False), (True, False), (True, True)]:
+                                    for packed in [False, True]:
+                                        for softcap in [0.0, 50.0]:
+                                            config = Config(
+                                                b,
+                                                s,
+                                                s2,
+                                                n,
+                                                n2,
+                                                h,
+                                                block_size,
+                                                local,
+                                                rotary,
+                                                rotary_interleaved,
+                                                packed,
+                                                softcap,
+                                                torch_type,
+                                            )
+                                            yield (str(config), config)
+
+
+class TestPagedAttentionCPU(unittest.TestCase):
+    @parameterized.expand(paged_attention_test_cases())
+    def test_paged_attention(self, _, config):
+        tolerance = 1e-3 if config.torch_type == torch.float32 else 2e-2
+        parity_check_paged_attention(config, rtol=tolerance, atol=tolerance)
+
+
+if __name__ == "__main__":
+    unittest.main(verbosity=2)
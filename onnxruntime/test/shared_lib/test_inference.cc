@@ -2,7 +2,9 @@
 // Licensed under the MIT License.
 
 #include <algorithm>
+#include <array>
 #include <atomic>
+#include <cmath>
 #include <fstream>
 #include <future>
 #include <iostream>
@@ -2897,6 +2899,53 @@ TEST(CApiTest, fill_string_tensor_directly) {
   }
 }
 
+TEST(CApiTest, fill_string_tensor_from_content) {
+  // the strings are not null terminated, may be empty or contain null characters
+  const std::string content("abc\0de" "kmp", 9);
+  const size_t offsets[] = {0, 6, 6};
+  const std::string expected[] = {std::string("abc\0de", 6), "", "kmp"};
+  constexpr int64_t expected_len = 3;
+
+  MockedOrtAllocator default_allocator;
+  Ort::Value tensor = Ort::Value::CreateTensor(&default_allocator, &expected_len, 1U,
+                                               ONNX_TENSOR_ELEMENT_DATA_TYPE_STRING);
+  tensor.FillStringTensorFromContent(content.data(), content.size(), offsets, std::size(offsets));
+
+  for (size_t i = 0; i < expected_len; i++) {
+    ASSERT_EQ(expected[i], tensor.GetStringTensorElement(i));
+  }
+
+  // GetStringTensorContent returns the same buffer and offsets
+  ASSERT_EQ(content.size(), tensor.GetStringTensorDataLength());
+  std::string result(content.size(), '\0');
+  std::vector<size_t> result_offsets(expected_len);
+  tensor.GetStringTensorContent(result.data(), result.size(), result_offsets.data(), result_offsets.size());
+  ASSERT_EQ(content, result);
+  ASSERT_EQ(std::vector<size_t>(std::begin(offsets), std::end(offsets)), result_offsets);
+
+  // offsets out of order or beyond the buffer are rejected
+  const size_t invalid_offsets[] = {0, 7, 6};
+  Ort::Status status(Ort::GetApi().FillStringTensorFromContent(tensor, content.data(), content.size(),
+                                                               invalid_offsets, std::size(invalid_offsets)));
+  ASSERT_FALSE(status.IsOK());
+  const size_t out_of_buffer_offsets[] = {0, 6, 10};
+  status = Ort::Status(Ort::GetApi().FillStringTensorFromContent(tensor, content.data(), content.size(),
+                                                                 out_of_buffer_offsets,
+                                                                 std::size(out_of_buffer_offsets)));
+  ASSERT_FALSE(status.IsOK());
+
+  // only the last offset is invalid, the strings before it must not be written either
+  const std::string other_content("xyz");
+  const size_t last_offset_invalid[] = {0, 1, 4};
+  status = Ort::Status(Ort::GetApi().FillStringTensorFromContent(tensor, other_content.data(), other_content.size(),
+                                                                 last_offset_invalid,
+                                                                 std::size(last_offset_invalid)));
+  ASSERT_FALSE(status.IsOK());
+  for (size_t i = 0; i < expected_len; i++) {
+    ASSERT_EQ(expected[i], tensor.GetStringTensorElement(i));
+  }
+}
+
 TEST(CApiTest, get_string_tensor_element) {
   const char* s[] = {"abc", "kmp"};
   constexpr int64_t expected_len = 2;
@@ -4624,6 +4673,87 @@ TEST(CApiTest, RunAsyncFail) {
   EXPECT_THROW(session.RunAsync(run_options, input_names, input_tensors, 1, output_names, output_values, 1, CallbackFail, nullptr), std::exception);
 }
 
+struct DynamicBatchingRequest {
+  std::array<float, 10> x_value{};
+  Ort::Value input{nullptr};
+  Ort::Value output{nullptr};
+  std::atomic_bool done{false};
+  bool succeeded = false;
+};
+
+void CallbackDynamicBatching(void* user_data, OrtValue** outputs, size_t num_outputs, OrtStatusPtr status_ptr) {
+  auto* request = reinterpret_cast<DynamicBatchingRequest*>(user_data);
+  Ort::Status status(status_ptr);
+  if (status.IsOK() && num_outputs == 1) {
+    Ort::Value output_value(outputs[0]);
+    auto shape = output_value.GetTensorTypeAndShapeInfo().GetShape();
+    const float* y = output_value.GetTensorData<float>();
+    request->succeeded = shape == std::vector<int64_t>{1, 2, 5} &&
+                         std::equal(request->x_value.begin(), request->x_value.end(), y,
+                                    [](float x, float y_i) { return std::abs(x) == y_i; });
+    output_value.release();
+  }
+  request->done.store(true);
+}
+
+TEST(CApiTest, RunAsyncWithDynamicBatching) {
+  Ort::SessionOptions session_options;
+  session_options.SetIntraOpNumThreads(2);
+  session_options.AddConfigEntry(kOrtSessionOptionsDynamicBatchingMaxBatchSize, "4");
+  // long enough for all requests to be queued before the first batch is dispatched
+  session_options.AddConfigEntry(kOrtSessionOptionsDynamicBatchingMaxQueueDelayUs, "100000");
+  session_options.AddConfigEntry(kOrtSessionOptionsEnableMetrics, "1");
+  Ort::Session session(*ort_env, TSTR("testdata/abs_free_dimensions.onnx"), session_options);
+
+  const char* input_names[] = {"x"};
+  const char* output_names[] = {"y"};
+  int64_t x_dim[] = {1, 2, 5};
+  auto memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+  Ort::RunOptions run_options;
+
+  constexpr size_t num_requests = 6;
+  std::vector<std::unique_ptr<DynamicBatchingRequest>> requests;
+  for (size_t r = 0; r < num_requests; ++r) {
+    auto request = std::make_unique<DynamicBatchingRequest>();
+    for (size_t i = 0; i < request->x_value.size(); ++i) {
+      request->x_value[i] = (i % 2 == 0 ? -1.f : 1.f) * static_cast<float>(r * 10 + i);
+    }
+    request->input = Ort::Value::CreateTensor<float>(memory_info, request->x_value.data(), request->x_value.size(),
+                                                     x_dim, 3);
+    requests.push_back(std::move(request));
+  }
+
+  for (auto& request : requests) {
+    EXPECT_NO_THROW(session.RunAsync(run_options, input_names, &request->input, 1, output_names, &request->output, 1,
+                                     CallbackDynamicBatching, request.get()));
+  }
+
+  std::chrono::duration<double, std::milli> dur{100};
+  // timeout in about 10 secs
+  auto all_done = [&requests]() {
+    return std::all_of(requests.begin(), requests.end(), [](const auto& r) { return r->done.load(); });
+  };
+  for (int i = 0; i < 100 && !all_done(); ++i) {
+    std::this_thread::sleep_for(dur);
+  }
+
+  for (const auto& request : requests) {
+    EXPECT_TRUE(request->done.load());
+    EXPECT_TRUE(request->succeeded);
+  }
+
+  // the outputs would be the same if every request ran on its own, so check that requests were combined
+  OrtKeyValuePairs* metrics_kvps = nullptr;
+  Ort::ThrowOnError(Ort::GetApi().SessionGetMetrics(session, &metrics_kvps));
+  Ort::KeyValuePairs metrics(metrics_kvps);
+  const char* batched_runs = metrics.GetValue("dynamic_batching.batched_runs");
+  const char* batched_requests = metrics.GetValue("dynamic_batching.batched_requests");
+  ASSERT_NE(batched_runs, nullptr);
+  ASSERT_NE(batched_requests, nullptr);
+  EXPECT_GE(std::stoull(batched_runs), 1u);
+  EXPECT_GE(std::stoull(batched_requests), 2u);
+}
+
 static void TestRunWithLoraAdapter(const Ort::LoraAdapter& adapter) {
   constexpr const ORTCHAR_T* model_path = TSTR("testdata/lora/two_params_lora_model.onnx");
 